@@ -3,11 +3,16 @@
 
 #include <ros/serialization.h>
 #include <ros/node_handle.h>
-#include <fstream>
+#include <godel_param_helpers/message_file.h>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
 
 namespace godel_param_helpers
 {
-// Write a message to disk
+// Serialize a message into a checksummed, versioned buffer (see message_file.h for the layout)
 template <class T> inline bool toFile(const std::string& path, const T& msg)
 {
   namespace ser = ros::serialization;
@@ -17,41 +22,155 @@ template <class T> inline bool toFile(const std::string& path, const T& msg)
   ser::OStream stream(buffer.get(), serialize_size);
   ser::serialize(stream, msg);
 
-  std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
-  if (!file)
+  const detail::FileHeader header =
+      detail::makeHeader(ros::message_traits::md5sum(msg), buffer.get(), serialize_size);
+  return detail::atomicWrite(path, header, buffer.get(), serialize_size);
+}
+
+/**
+ * @brief Saves messages to disk on one background thread that it owns. Saves run in the order
+ * they are queued, so the last snapshot of a file queued is the one left on disk; the destructor
+ * finishes every queued save before joining the thread.
+ */
+class MessageFileWriter
+{
+public:
+  MessageFileWriter() : stopping_(false), worker_(&MessageFileWriter::run, this) {}
+
+  ~MessageFileWriter()
   {
-    return false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    ready_.notify_one();
+    worker_.join();
+  }
+
+  MessageFileWriter(const MessageFileWriter&) = delete;
+  MessageFileWriter& operator=(const MessageFileWriter&) = delete;
+
+  /**
+   * @brief Queues a save of a copy of 'msg' to 'path', so the caller may keep modifying it.
+   * Failures are logged as well as reported through the returned future.
+   */
+  template <class T> std::future<bool> save(const std::string& path, const T& msg)
+  {
+    std::packaged_task<bool()> task([path, msg]() {
+      const bool ok = toFile(path, msg);
+      if (!ok)
+        ROS_ERROR_STREAM("Unable to save message to: " << path);
+      return ok;
+    });
+    std::future<bool> result = task.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(std::move(task));
+    }
+    ready_.notify_one();
+    return result;
+  }
+
+private:
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+      ready_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+      if (queue_.empty())
+        return; // stopping, with nothing left to save
+
+      std::packaged_task<bool()> task = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<std::packaged_task<bool()> > queue_;
+  bool stopping_;
+  std::thread worker_; // last, so that it starts once the queue exists
+};
+
+namespace detail
+{
+// Deserializes a whole buffer into 'msg', which is left untouched on failure. Legacy files have
+// no checksum, so the message must account for every byte of the buffer.
+template <class T> inline bool deserializePayload(const uint8_t* payload, std::size_t payload_size,
+                                                  bool exact_size, const std::string& path, T& msg)
+{
+  namespace ser = ros::serialization;
+  try
+  {
+    // IStream only reads from the buffer, but its interface is non-const
+    T tmp;
+    ser::IStream istream(const_cast<uint8_t*>(payload), payload_size);
+    ser::deserialize(istream, tmp);
+    if (exact_size && ser::serializationLength(tmp) != payload_size)
+    {
+      ROS_WARN_STREAM("File '" << path << "' does not hold a message of this type");
+      return false;
+    }
+    msg = std::move(tmp);
   }
-  else
+  catch (const ros::Exception& e)
   {
-    file.write((char*)buffer.get(), serialize_size);
-    return file.good();
+    ROS_WARN_STREAM("Unable to deserialize '" << path << "': " << e.what());
+    return false;
   }
+  return true;
 }
+} // end namespace detail
 
-// Restore a message from disk
+// Restore a message from disk. The file is memory mapped and deserialized in place. Files
+// written before the container was introduced, which hold only the serialized message, are
+// still read; the next save rewrites them in the current format.
 template <class T> inline bool fromFile(const std::string& path, T& msg)
 {
-  namespace ser = ros::serialization;
+  detail::MappedFile file(path);
+  if (!file.valid())
+  {
+    return false;
+  }
 
-  std::ifstream ifs(path.c_str(), std::ios::in | std::ios::binary);
-  if (!ifs)
+  if (file.size() < sizeof(detail::FILE_MAGIC) ||
+      std::memcmp(file.data(), detail::FILE_MAGIC, sizeof(detail::FILE_MAGIC)) != 0)
   {
+    if (!detail::deserializePayload(file.data(), file.size(), true, path, msg))
+    {
+      return false;
+    }
+    ROS_INFO_STREAM("Read '" << path << "' in the format used before message files were checksummed");
+    return true;
+  }
+
+  if (file.size() < sizeof(detail::FileHeader))
+  {
+    ROS_WARN_STREAM("File '" << path << "' is truncated");
     return false;
   }
 
-  ifs.seekg(0, std::ios::end);
-  std::streampos end = ifs.tellg();
-  ifs.seekg(0, std::ios::beg);
-  std::streampos begin = ifs.tellg();
+  detail::FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
 
-  uint32_t file_size = end - begin;
+  const uint8_t* payload = file.data() + sizeof(header);
+  const std::size_t payload_size = file.size() - sizeof(header);
+  if (!detail::validateHeader(header, ros::message_traits::md5sum(msg), payload_size, path))
+  {
+    return false;
+  }
 
-  boost::shared_array<uint8_t> ibuffer(new uint8_t[file_size]);
-  ifs.read((char*)ibuffer.get(), file_size);
-  ser::IStream istream(ibuffer.get(), file_size);
-  ser::deserialize(istream, msg);
-  return true;
+  if (detail::checksum(payload, payload_size) != header.payload_crc)
+  {
+    ROS_WARN_STREAM("File '" << path << "' failed its checksum; ignoring it");
+    return false;
+  }
+
+  return detail::deserializePayload(payload, payload_size, false, path, msg);
 }
 
 // for loading parameters from server
@@ -0,0 +1,169 @@
+#ifndef GODEL_PARAM_HELPERS_MESSAGE_FILE_H
+#define GODEL_PARAM_HELPERS_MESSAGE_FILE_H
+
+#include <boost/crc.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <ros/console.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+namespace godel_param_helpers
+{
+namespace detail
+{
+/**
+ * On-disk layout of a cached message:
+ *
+ *   | magic (4) | version (4) | md5sum (32) | payload size (4) | payload crc32 (4) | payload |
+ *
+ * The payload is the ROS serialization of the message. The md5sum is the message definition
+ * hash so that a cache written by an older message definition is rejected instead of being
+ * deserialized into garbage.
+ */
+const static char FILE_MAGIC[4] = {'G', 'D', 'L', 'M'};
+const static uint32_t FILE_VERSION = 1;
+const static std::size_t MD5_LENGTH = 32;
+
+struct FileHeader
+{
+  char magic[4];
+  uint32_t version;
+  char md5sum[MD5_LENGTH];
+  uint32_t payload_size;
+  uint32_t payload_crc;
+};
+
+inline uint32_t checksum(const uint8_t* data, std::size_t size)
+{
+  boost::crc_32_type crc;
+  crc.process_bytes(data, size);
+  return crc.checksum();
+}
+
+inline FileHeader makeHeader(const std::string& md5sum, const uint8_t* payload, uint32_t size)
+{
+  FileHeader header;
+  std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header.version = FILE_VERSION;
+  std::memset(header.md5sum, 0, MD5_LENGTH);
+  std::memcpy(header.md5sum, md5sum.data(), std::min(md5sum.size(), MD5_LENGTH));
+  header.payload_size = size;
+  header.payload_crc = checksum(payload, size);
+  return header;
+}
+
+/**
+ * @brief Checks that 'header' describes a payload of 'available' bytes written by this
+ * container version for the message type with the given md5sum. Logs the reason on failure.
+ */
+inline bool validateHeader(const FileHeader& header, const std::string& md5sum, std::size_t available,
+                           const std::string& path)
+{
+  if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+  {
+    ROS_WARN_STREAM("File '" << path << "' is not a godel message file");
+    return false;
+  }
+
+  if (header.version != FILE_VERSION)
+  {
+    ROS_WARN_STREAM("File '" << path << "' has unsupported version " << header.version);
+    return false;
+  }
+
+  if (md5sum.compare(0, MD5_LENGTH, header.md5sum, strnlen(header.md5sum, MD5_LENGTH)) != 0)
+  {
+    ROS_WARN_STREAM("File '" << path << "' was written for a different message definition");
+    return false;
+  }
+
+  if (header.payload_size != available)
+  {
+    ROS_WARN_STREAM("File '" << path << "' is truncated: expected " << header.payload_size << " bytes, found "
+                             << available);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Writes 'header' followed by 'payload' to a temporary file next to 'path', flushes it
+ * to disk, and renames it over 'path'. Readers therefore see either the old or the new file,
+ * never a partial one.
+ */
+inline bool atomicWrite(const std::string& path, const FileHeader& header, const uint8_t* payload,
+                        uint32_t size)
+{
+  static std::atomic<unsigned> counter(0);
+  const std::string tmp_path =
+      path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+
+  int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  auto write_all = [fd](const uint8_t* data, std::size_t n) {
+    while (n > 0)
+    {
+      ssize_t written = ::write(fd, data, n);
+      if (written <= 0)
+        return false;
+      data += written;
+      n -= written;
+    }
+    return true;
+  };
+
+  bool ok = write_all(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) &&
+            write_all(payload, size) && ::fsync(fd) == 0;
+  ok = (::close(fd) == 0) && ok;
+
+  if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0)
+  {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Read-only memory map of a message file. The mapping lives as long as this object.
+ */
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string& path)
+  {
+    namespace bip = boost::interprocess;
+    try
+    {
+      bip::file_mapping mapping(path.c_str(), bip::read_only);
+      region_ = bip::mapped_region(mapping, bip::read_only);
+    }
+    catch (const bip::interprocess_exception&)
+    {
+      // Missing or empty files leave the region unmapped; valid() reports this
+    }
+  }
+
+  bool valid() const { return region_.get_address() != nullptr; }
+  const uint8_t* data() const { return static_cast<const uint8_t*>(region_.get_address()); }
+  std::size_t size() const { return region_.get_size(); }
+
+private:
+  boost::interprocess::mapped_region region_;
+};
+
+} // end namespace detail
+} // end namespace godel_param_helpers
+
+#endif
@@ -0,0 +1,77 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <benchmark/benchmark.h>
+#include <godel_param_helpers/godel_param_helpers.h>
+#include <std_msgs/Float64MultiArray.h>
+
+#include <boost/filesystem.hpp>
+
+static std_msgs::Float64MultiArray makeMsg(std::size_t bytes)
+{
+  std_msgs::Float64MultiArray msg;
+  msg.data.assign(bytes / sizeof(double), 1.0);
+  return msg;
+}
+
+static std::string benchPath()
+{
+  return (boost::filesystem::temp_directory_path() / "godel_param_helpers_bench.msg").string();
+}
+
+static void BM_ToFile(benchmark::State& state)
+{
+  const std_msgs::Float64MultiArray msg = makeMsg(state.range(0));
+  const std::string path = benchPath();
+  for (auto _ : state)
+    benchmark::DoNotOptimize(godel_param_helpers::toFile(path, msg));
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  boost::filesystem::remove(path);
+}
+BENCHMARK(BM_ToFile)->RangeMultiplier(8)->Range(1 << 10, 1 << 26)->Unit(benchmark::kMillisecond);
+
+static void BM_FromFile(benchmark::State& state)
+{
+  const std::string path = benchPath();
+  godel_param_helpers::toFile(path, makeMsg(state.range(0)));
+  std_msgs::Float64MultiArray msg;
+  for (auto _ : state)
+    benchmark::DoNotOptimize(godel_param_helpers::fromFile(path, msg));
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  boost::filesystem::remove(path);
+}
+BENCHMARK(BM_FromFile)->RangeMultiplier(8)->Range(1 << 10, 1 << 26)->Unit(benchmark::kMillisecond);
+
+// Time the caller spends on the service thread when saving asynchronously
+static void BM_WriterCallerLatency(benchmark::State& state)
+{
+  const std_msgs::Float64MultiArray msg = makeMsg(state.range(0));
+  const std::string path = benchPath();
+  godel_param_helpers::MessageFileWriter writer;
+  for (auto _ : state)
+  {
+    std::future<bool> done = writer.save(path, msg);
+    state.PauseTiming();
+    done.wait();
+    state.ResumeTiming();
+  }
+  boost::filesystem::remove(path);
+}
+BENCHMARK(BM_WriterCallerLatency)->RangeMultiplier(8)->Range(1 << 10, 1 << 26)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,212 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <godel_param_helpers/godel_param_helpers.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <std_msgs/String.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+std::string tempPath(const std::string& name)
+{
+  return (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path(name + "-%%%%%%")).string();
+}
+
+std_msgs::Float64MultiArray makeMsg(std::size_t n)
+{
+  std_msgs::Float64MultiArray msg;
+  msg.data.resize(n);
+  for (std::size_t i = 0; i < n; ++i)
+    msg.data[i] = 0.5 * i;
+  return msg;
+}
+
+// Flips one bit of the byte at 'offset' from the end of the file
+void corrupt(const std::string& path, std::streamoff offset)
+{
+  std::fstream f(path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+  f.seekg(-offset, std::ios::end);
+  char c;
+  f.read(&c, 1);
+  c ^= 0x10;
+  f.seekp(-offset, std::ios::end);
+  f.write(&c, 1);
+}
+
+} // end anon namespace
+
+TEST(ParamHelpers, roundTrip)
+{
+  const std::string path = tempPath("roundtrip");
+  const std_msgs::Float64MultiArray out = makeMsg(1000);
+  ASSERT_TRUE(godel_param_helpers::toFile(path, out));
+
+  std_msgs::Float64MultiArray in;
+  ASSERT_TRUE(godel_param_helpers::fromFile(path, in));
+  EXPECT_EQ(out.data, in.data);
+  boost::filesystem::remove(path);
+}
+
+TEST(ParamHelpers, missingFile)
+{
+  std_msgs::Float64MultiArray in;
+  EXPECT_FALSE(godel_param_helpers::fromFile(tempPath("missing"), in));
+}
+
+TEST(ParamHelpers, corruptPayloadIsRejected)
+{
+  const std::string path = tempPath("corrupt");
+  ASSERT_TRUE(godel_param_helpers::toFile(path, makeMsg(1000)));
+  corrupt(path, 17);
+
+  std_msgs::Float64MultiArray in = makeMsg(3);
+  EXPECT_FALSE(godel_param_helpers::fromFile(path, in));
+  EXPECT_EQ(3u, in.data.size()); // untouched on failure
+  boost::filesystem::remove(path);
+}
+
+TEST(ParamHelpers, truncatedFileIsRejected)
+{
+  const std::string path = tempPath("truncated");
+  ASSERT_TRUE(godel_param_helpers::toFile(path, makeMsg(1000)));
+  boost::filesystem::resize_file(path, boost::filesystem::file_size(path) - 8);
+
+  std_msgs::Float64MultiArray in;
+  EXPECT_FALSE(godel_param_helpers::fromFile(path, in));
+
+  boost::filesystem::resize_file(path, 10); // shorter than the header
+  EXPECT_FALSE(godel_param_helpers::fromFile(path, in));
+  boost::filesystem::remove(path);
+}
+
+TEST(ParamHelpers, wrongMessageTypeIsRejected)
+{
+  const std::string path = tempPath("wrongtype");
+  std_msgs::String s;
+  s.data = "not an array";
+  ASSERT_TRUE(godel_param_helpers::toFile(path, s));
+
+  std_msgs::Float64MultiArray in;
+  EXPECT_FALSE(godel_param_helpers::fromFile(path, in));
+  boost::filesystem::remove(path);
+}
+
+// Files written before the container was introduced hold only the serialized payload
+template <class T> void writeLegacy(const std::string& path, const T& msg)
+{
+  std::vector<uint8_t> buffer(ros::serialization::serializationLength(msg));
+  ros::serialization::OStream stream(buffer.data(), buffer.size());
+  ros::serialization::serialize(stream, msg);
+  std::ofstream(path.c_str(), std::ios::binary).write((char*)buffer.data(), buffer.size());
+}
+
+TEST(ParamHelpers, legacyRawFileIsRead)
+{
+  const std::string path = tempPath("legacy");
+  const std_msgs::Float64MultiArray out = makeMsg(100);
+  writeLegacy(path, out);
+
+  std_msgs::Float64MultiArray in;
+  ASSERT_TRUE(godel_param_helpers::fromFile(path, in));
+  EXPECT_EQ(out.data, in.data);
+
+  // Saving it again moves it to the current format
+  ASSERT_TRUE(godel_param_helpers::toFile(path, in));
+  ASSERT_TRUE(godel_param_helpers::fromFile(path, in));
+  EXPECT_EQ(out.data, in.data);
+  boost::filesystem::remove(path);
+}
+
+TEST(ParamHelpers, legacyFileOfOtherTypeIsRejected)
+{
+  const std::string path = tempPath("legacywrongtype");
+  std_msgs::String s;
+  s.data = "not an array";
+  writeLegacy(path, s);
+
+  std_msgs::Float64MultiArray in = makeMsg(3);
+  EXPECT_FALSE(godel_param_helpers::fromFile(path, in));
+  EXPECT_EQ(3u, in.data.size());
+
+  // A legacy file that a message of the right type doesn't use up is not that message either
+  writeLegacy(path, makeMsg(5));
+  std::ofstream(path.c_str(), std::ios::binary | std::ios::app).write("xx", 2);
+  EXPECT_FALSE(godel_param_helpers::fromFile(path, in));
+  boost::filesystem::remove(path);
+}
+
+TEST(ParamHelpers, writerSavesAtomically)
+{
+  const std::string path = tempPath("async");
+  ASSERT_TRUE(godel_param_helpers::toFile(path, makeMsg(10)));
+
+  godel_param_helpers::MessageFileWriter writer;
+  std::future<bool> done = writer.save(path, makeMsg(100000));
+  // Whenever we look, the file is either the old or the new message, never a partial one
+  std_msgs::Float64MultiArray in;
+  EXPECT_TRUE(godel_param_helpers::fromFile(path, in));
+  EXPECT_TRUE(in.data.size() == 10 || in.data.size() == 100000);
+
+  ASSERT_TRUE(done.get());
+  ASSERT_TRUE(godel_param_helpers::fromFile(path, in));
+  EXPECT_EQ(100000u, in.data.size());
+
+  // No temporary files are left behind
+  const boost::filesystem::path dir = boost::filesystem::path(path).parent_path();
+  const std::string prefix = boost::filesystem::path(path).filename().string() + ".tmp";
+  for (boost::filesystem::directory_iterator it(dir), end; it != end; ++it)
+    EXPECT_NE(0u, it->path().filename().string().find(prefix));
+  boost::filesystem::remove(path);
+}
+
+TEST(ParamHelpers, writerKeepsLastSave)
+{
+  const std::string path = tempPath("ordered");
+  {
+    // Large snapshots followed by small ones: were they written concurrently, a small one
+    // would finish first and be replaced by an older, larger one
+    godel_param_helpers::MessageFileWriter writer;
+    for (std::size_t n = 20; n > 0; --n)
+      writer.save(path, makeMsg(n * 10000));
+    writer.save(path, makeMsg(7));
+  } // queued saves finish before the writer is destroyed
+
+  std_msgs::Float64MultiArray in;
+  ASSERT_TRUE(godel_param_helpers::fromFile(path, in));
+  EXPECT_EQ(7u, in.data.size());
+  boost::filesystem::remove(path);
+}
+
+TEST(ParamHelpers, writerReportsFailures)
+{
+  godel_param_helpers::MessageFileWriter writer;
+  std::future<bool> done = writer.save(tempPath("missing-dir") + "/params.msg", makeMsg(10));
+  EXPECT_FALSE(done.get());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
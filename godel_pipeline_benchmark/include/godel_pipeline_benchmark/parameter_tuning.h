@@ -0,0 +1,174 @@
+#ifndef GODEL_PIPELINE_BENCHMARK_PARAMETER_TUNING_H
+#define GODEL_PIPELINE_BENCHMARK_PARAMETER_TUNING_H
+
+#include <godel_msgs/BlendingPlanParameters.h>
+#include <godel_msgs/PathPlanningParameters.h>
+#include <godel_msgs/ScanPlanParameters.h>
+#include <godel_msgs/SurfaceDetectionParameters.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <xmlrpcpp/XmlRpcValue.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace godel_pipeline_benchmark
+{
+
+/**
+ * @brief Everything a tuning run can change. Exported as the parameter files that
+ * surface_blending_service caches between runs.
+ */
+struct ParameterSet
+{
+  godel_msgs::SurfaceDetectionParameters detection;
+  godel_msgs::PathPlanningParameters path_planning;
+  godel_msgs::BlendingPlanParameters blend;
+  godel_msgs::ScanPlanParameters scan;
+};
+
+/**
+ * @brief The range searched for one field, named "<message>.<field>" as in tunableParameters()
+ */
+struct ParameterRange
+{
+  std::string name;
+  double min;
+  double max;
+  bool integer;   // values are rounded to the nearest integer
+  bool log_scale; // sampled uniformly in log space; min must be positive
+};
+
+/**
+ * @brief Names of the fields that can be tuned: those read by detection, in-process tool path
+ * generation or the stand-in planner, e.g. "detection.rg_smoothness_threshold"
+ */
+std::vector<std::string> tunableParameters();
+
+/** @brief Sets a field by name, rounding integer fields; false if the name isn't tunable */
+bool setParameter(ParameterSet& set, const std::string& name, double value);
+
+/** @brief Reads a field by name; false if the name isn't tunable */
+bool getParameter(const ParameterSet& set, const std::string& name, double& value);
+
+/**
+ * @brief Reads a list of {name, min, max, integer, log} entries
+ * @return false (and logs why) on unknown names or empty ranges
+ */
+bool loadParameterRanges(XmlRpc::XmlRpcValue& list, std::vector<ParameterRange>& ranges);
+
+typedef pcl::PointXYZRGBL LabelledPoint;
+typedef pcl::PointCloud<LabelledPoint> LabelledCloud;
+
+/**
+ * @brief A scan with its ground truth: the label of each point names the surface it belongs to,
+ * 0 for none. Labels come from a synthetic part or from an operator-approved segmentation.
+ */
+struct TuningPart
+{
+  std::string name;
+  LabelledCloud::Ptr cloud;
+};
+
+/**
+ * @brief Reads the 'parts' list of a tuning dataset: '{name, pcd}' entries load a labelled PCD
+ * and '{name, part}' entries generate a synthetic part (see godel_surface_detection's
+ * synthetic_scan.launch for the format)
+ * @param data_directory Relative PCD paths are resolved against this directory
+ */
+bool loadTuningParts(XmlRpc::XmlRpcValue& parts, const std::string& data_directory,
+                     std::vector<TuningPart>& dataset);
+
+/**
+ * @brief How well one parameter set did on one or more parts; every objective is minimized
+ */
+struct Score
+{
+  double runtime_s = 0.0;          // detection and tool path generation wall time
+  double segmentation_error = 0.0; // 1 - segmentationScore()
+  double coverage_error = 0.0;     // share of surface points no scan stripe passes over
+  double cycle_time_s = 0.0;       // stand-in plan duration of the scan and edge paths
+};
+
+/** @brief Names of the objectives, in the order of objectiveValues() */
+const static std::vector<std::string> OBJECTIVES = {"runtime_s", "segmentation_error", "coverage_error",
+                                                    "cycle_time_s"};
+
+std::vector<double> objectiveValues(const Score& score);
+
+/** @brief Mean of each objective; all zero if there are no scores */
+Score meanScore(const std::vector<Score>& scores);
+
+/**
+ * @brief Share of the labelled points of a part that were segmented into the right surface.
+ *
+ * Every point of the detection's process cloud takes the label of the nearest ground truth point
+ * within 'match_radius' (0 if there is none). Ground truth surfaces and detected segments are
+ * then paired one to one, best intersection over union first, and the score is the mean IoU of
+ * the ground truth surfaces weighted by their share of the labelled process points. A missed or
+ * merged surface scores 0 for its points; 1 is a perfect segmentation.
+ */
+double segmentationScore(const LabelledCloud& truth, const pcl::PointCloud<pcl::PointXYZRGB>& process_cloud,
+                         const std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>& segments,
+                         double match_radius);
+
+/**
+ * @brief Runs detection and tool path generation in-process with a parameter set, and scores the
+ * result against the part's labels.
+ *
+ * Detection is SurfaceDetection::segment_surfaces(). Per surface, edge paths come from
+ * generateEdgePaths() and the scan path from the profilometer raster of the scan planner plugin,
+ * laid over the surface's convex hull in its principal axes. Paths are timed with the stand-in
+ * planner. Blend raster paths are not generated: they need the polygon offset service.
+ * @param threads Normal estimation threads, 0 for every core
+ */
+Score evaluateParameterSet(const ParameterSet& set, const TuningPart& part, int threads = 1);
+
+/** @brief Scores one parameter set on one part; called concurrently from several threads */
+typedef std::function<Score(const ParameterSet&, const TuningPart&)> Evaluator;
+
+struct TuningOptions
+{
+  std::size_t candidates = 27; // parameter sets sampled for the first rung
+  double eta = 3.0;            // each rung keeps 1/eta of the candidates, on eta times as many parts
+  std::size_t min_parts = 1;   // parts every candidate is evaluated on
+  unsigned seed = 0;
+  unsigned threads = 0; // parallel evaluations, 0 for one per core
+};
+
+struct Candidate
+{
+  ParameterSet params;
+  std::vector<double> values;      // one per searched range
+  std::vector<Score> part_scores;  // one per part evaluated so far, in dataset order
+  Score score;                     // mean over part_scores
+};
+
+/**
+ * @brief Successive halving: 'candidates' parameter sets, the first being 'base' and the rest a
+ * Latin hypercube over the ranges, are evaluated on the first 'min_parts' parts. The best 1/eta
+ * (by non-dominated rank, then by the sum of their normalized objectives) go on to eta times as
+ * many parts, until the survivors have seen the whole dataset.
+ * @return Every candidate; only those with a score for every part reached the last rung
+ */
+std::vector<Candidate> successiveHalving(const ParameterSet& base, const std::vector<ParameterRange>& ranges,
+                                         const std::vector<TuningPart>& dataset, const TuningOptions& options,
+                                         const Evaluator& evaluate);
+
+/**
+ * @brief Non-dominated sorting: rank 0 is the Pareto front, rank 1 the front once rank 0 is
+ * removed, and so on. Points are minimized in every coordinate.
+ */
+std::vector<std::size_t> paretoRanks(const std::vector<std::vector<double>>& points);
+
+/**
+ * @brief Writes a parameter set as the files surface_blending_service loads at startup
+ * (godel_surface_detection_parameters.msg, godel_path_planning_parameters.msg,
+ * godel_blending_parameters.msg and godel_scan_parameters.msg) into a directory, creating it
+ */
+bool exportParameterSet(const ParameterSet& set, const std::string& directory);
+
+} // namespace godel_pipeline_benchmark
+
+#endif // GODEL_PIPELINE_BENCHMARK_PARAMETER_TUNING_H
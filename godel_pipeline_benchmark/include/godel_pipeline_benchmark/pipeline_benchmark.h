@@ -0,0 +1,22 @@
+#ifndef GODEL_PIPELINE_BENCHMARK_PIPELINE_BENCHMARK_H
+#define GODEL_PIPELINE_BENCHMARK_PIPELINE_BENCHMARK_H
+
+#include <ros/node_handle.h>
+
+#include <string>
+
+namespace godel_pipeline_benchmark
+{
+
+/**
+ * @brief Runs the dataset configured under 'pnh' through the pipeline and writes the report,
+ * as the pipeline_benchmark node and its nodelet do. See the package README.
+ * @param deployment How the geometry services run, as recorded in the report: "processes" when
+ * they are nodes of their own, "nodelets" when they share the benchmark's manager
+ * @return 0 on success, like the node's exit code
+ */
+int runPipelineBenchmark(ros::NodeHandle& pnh, const std::string& deployment);
+
+} // namespace godel_pipeline_benchmark
+
+#endif // GODEL_PIPELINE_BENCHMARK_PIPELINE_BENCHMARK_H
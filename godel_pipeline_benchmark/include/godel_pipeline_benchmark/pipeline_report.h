@@ -0,0 +1,156 @@
+#ifndef GODEL_PIPELINE_BENCHMARK_PIPELINE_REPORT_H
+#define GODEL_PIPELINE_BENCHMARK_PIPELINE_REPORT_H
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace godel_pipeline_benchmark
+{
+
+/**
+ * Version of the JSON written by PipelineReport::writeJson(). Bump it whenever a field is
+ * renamed, removed or changes meaning; adding fields does not require a bump.
+ */
+const static int REPORT_SCHEMA_VERSION = 1;
+
+/**
+ * Pipeline stages, in the order they run. Every report lists all of them, even those without
+ * samples, so that reports from different runs line up.
+ */
+const static std::vector<std::string> PIPELINE_STAGES = {
+    "ingest",          // load or generate a cloud and add it to SurfaceDetection
+    "detection",       // SurfaceDetection::find_surfaces(), once per part
+    "path_generation", // blend, scan and edge tool paths, once per surface
+    "planning",        // process planning (stand-in), once per tool path
+    "rapid_emission",  // RAPID module generation and upload (stand-in), once per plan
+    "end_to_end"       // all of the above, once per part
+};
+
+struct LatencySummary
+{
+  std::size_t samples;
+  double mean_ms;
+  double p50_ms;
+  double p90_ms;
+  double p99_ms;
+  double max_ms;
+};
+
+/**
+ * @brief Nearest-rank percentiles of a set of latencies; all zero if there are no samples
+ */
+LatencySummary summarize(std::vector<double> samples_ms);
+
+struct PlanMetrics
+{
+  std::string name;
+  std::string type;       // "blend", "scan" or "edge"
+  std::size_t points;     // trajectory points over approach, process and depart
+  double path_length_m;   // see processPathLength()
+  double cycle_time_s;    // see planDuration()
+  std::size_t rapid_bytes;
+};
+
+/**
+ * CPU time of a whole benchmark run. In the nodelet deployment the geometry services run in the
+ * benchmark's own process, so their time is part of benchmark_s.
+ */
+struct CpuUsage
+{
+  double wall_s;            // wall time of the run
+  double benchmark_s;       // user + system time of the benchmark process
+  double other_processes_s; // user + system time of the other pipeline processes, see cpu_nodes
+};
+
+struct PartMetrics
+{
+  std::string name;
+  std::size_t points;
+  std::size_t segments; // found by region growing, before coplanar ones are merged
+  std::size_t surfaces;
+  std::vector<PlanMetrics> plans;
+};
+
+/**
+ * @brief Collects stage latencies and plan quality for a benchmark run and writes them as JSON
+ */
+class PipelineReport
+{
+public:
+  explicit PipelineReport(const std::string& dataset, int repetitions)
+    : dataset_(dataset), deployment_("processes"), repetitions_(repetitions), peak_rss_kb_(0), cpu_()
+  {
+  }
+
+  void addSample(const std::string& stage, double ms) { samples_[stage].push_back(ms); }
+
+  void addPart(const PartMetrics& part) { parts_.push_back(part); }
+
+  void setPeakRssKb(long kb) { peak_rss_kb_ = kb; }
+
+  /** @brief How the geometry services were run: "processes" or "nodelets" */
+  void setDeployment(const std::string& deployment) { deployment_ = deployment; }
+
+  void setCpuUsage(const CpuUsage& cpu) { cpu_ = cpu; }
+
+  const std::vector<double>& samples(const std::string& stage) const;
+
+  const std::vector<PartMetrics>& parts() const { return parts_; }
+
+  void writeJson(std::ostream& os) const;
+
+private:
+  std::string dataset_;
+  std::string deployment_;
+  int repetitions_;
+  long peak_rss_kb_;
+  CpuUsage cpu_;
+  std::map<std::string, std::vector<double>> samples_;
+  std::vector<PartMetrics> parts_;
+};
+
+/**
+ * @brief Adds the time between its construction and destruction to a report stage
+ */
+class ScopedStageTimer
+{
+public:
+  ScopedStageTimer(PipelineReport& report, const std::string& stage)
+    : report_(report), stage_(stage), start_(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedStageTimer()
+  {
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_;
+    report_.addSample(stage_, elapsed.count());
+  }
+
+private:
+  PipelineReport& report_;
+  std::string stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief High-water mark of this process' resident memory, in kilobytes
+ */
+long peakRssKb();
+
+/**
+ * @brief User plus system CPU time of this process so far, in seconds
+ */
+double processCpuSeconds();
+
+/**
+ * @brief User plus system CPU time of process 'pid' so far, in seconds, from /proc
+ * @return A negative value if the process doesn't exist or can't be read
+ */
+double processCpuSeconds(int pid);
+
+} // namespace godel_pipeline_benchmark
+
+#endif // GODEL_PIPELINE_BENCHMARK_PIPELINE_REPORT_H
@@ -0,0 +1,53 @@
+#ifndef GODEL_PIPELINE_BENCHMARK_REFERENCE_DATASET_H
+#define GODEL_PIPELINE_BENCHMARK_REFERENCE_DATASET_H
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <xmlrpcpp/XmlRpcValue.h>
+
+#include <string>
+#include <vector>
+
+namespace godel_pipeline_benchmark
+{
+
+/**
+ * @brief An axis aligned box; (x, y, z) is its minimum corner
+ */
+struct Box
+{
+  double x, y, z;
+  double size_x, size_y, size_z;
+};
+
+/**
+ * @brief One part of a benchmark dataset: either a recorded cloud or a synthetic part made of
+ * boxes. See data/reference_dataset.yaml for the format.
+ */
+struct DatasetPart
+{
+  std::string name;
+  std::string pcd;        // recorded cloud; if set, the fields below are ignored
+  std::vector<Box> boxes; // synthetic part
+  double spacing;         // (m) distance between synthetic samples
+  double noise;           // (m) standard deviation of the synthetic sensor noise
+  unsigned seed;
+};
+
+/**
+ * @brief Reads the 'parts' list of a dataset description
+ * @param data_directory Relative PCD paths are resolved against this directory
+ * @return false (and logs why) if the description is malformed
+ */
+bool loadDataset(XmlRpc::XmlRpcValue& parts, const std::string& data_directory, std::vector<DatasetPart>& dataset);
+
+/**
+ * @brief Loads or generates the cloud of a part. Synthetic parts are deterministic for a given
+ * seed: the tops and sides of the boxes are sampled on a grid, surfaces hidden inside another box
+ * are dropped and Gaussian noise is added.
+ */
+bool loadPartCloud(const DatasetPart& part, pcl::PointCloud<pcl::PointXYZRGB>& cloud);
+
+} // namespace godel_pipeline_benchmark
+
+#endif // GODEL_PIPELINE_BENCHMARK_REFERENCE_DATASET_H
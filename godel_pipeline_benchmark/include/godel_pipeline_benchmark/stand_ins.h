@@ -0,0 +1,98 @@
+#ifndef GODEL_PIPELINE_BENCHMARK_STAND_INS_H
+#define GODEL_PIPELINE_BENCHMARK_STAND_INS_H
+
+#include <godel_msgs/BlendingPlanParameters.h>
+#include <godel_msgs/ProcessPath.h>
+#include <godel_msgs/ProcessPlan.h>
+#include <godel_msgs/ScanPlanParameters.h>
+#include <rapid_generator/rapid_data_structures.h>
+
+#include <string>
+
+namespace godel_pipeline_benchmark
+{
+
+/**
+ * @brief Replaces the Descartes/MoveIt process planners (blend_process_planning and
+ * keyence_process_planning) with a Cartesian time parameterization of the same path.
+ *
+ * Each trajectory point carries the tool pose as six "joints": x, y, z (m) and roll, pitch,
+ * yaw (rad). The plans have the same structure as the real ones (approach, process, depart and
+ * retract/traverse moves between segments), so downstream stages see the same number of points,
+ * but they are not kinematically valid and the timing ignores joint limits.
+ */
+class StandInProcessPlanner
+{
+public:
+  /**
+   * @brief Plans a blend or edge path: down to the surface at the approach speed, along each
+   * segment at the blending speed, up to the traverse height at the retract speed and across to
+   * the next segment at the traverse speed.
+   * @return false if the path has no poses
+   */
+  bool planBlend(const godel_msgs::ProcessPath& path, const godel_msgs::BlendingPlanParameters& params,
+                 godel_msgs::ProcessPlan& plan) const;
+
+  /**
+   * @brief Plans a scan path: the same structure as a blend path, but every move is made at the
+   * traverse speed from the scan approach distance.
+   * @return false if the path has no poses
+   */
+  bool planScan(const godel_msgs::ProcessPath& path, const godel_msgs::ScanPlanParameters& params,
+                godel_msgs::ProcessPlan& plan) const;
+};
+
+/**
+ * @brief Replaces the FTP upload to the robot controller: modules are written to a local
+ * directory, or only counted when no directory is given.
+ */
+class StandInFtp
+{
+public:
+  explicit StandInFtp(const std::string& directory = std::string())
+    : directory_(directory), bytes_uploaded_(0), files_uploaded_(0)
+  {
+  }
+
+  bool upload(const std::string& filename, const std::string& contents);
+
+  std::size_t bytesUploaded() const { return bytes_uploaded_; }
+  std::size_t filesUploaded() const { return files_uploaded_; }
+
+private:
+  std::string directory_;
+  std::size_t bytes_uploaded_;
+  std::size_t files_uploaded_;
+};
+
+/**
+ * @brief Replaces the ABB blend process execution service: the plan is turned into a RAPID
+ * module exactly as for a real robot and handed to the FTP stand-in. Nothing waits for motion;
+ * the plan's duration is reported as its cycle time instead.
+ */
+class StandInExecutor
+{
+public:
+  explicit StandInExecutor(StandInFtp& ftp) : ftp_(ftp) {}
+
+  /**
+   * @brief Emits and "uploads" the RAPID module for a plan
+   * @param name Used for the module's file name
+   * @param bytes Set to the size of the module
+   * @return false if the module couldn't be generated
+   */
+  bool execute(const std::string& name, const godel_msgs::ProcessPlan& plan, std::size_t& bytes);
+
+private:
+  StandInFtp& ftp_;
+};
+
+/** @brief Total duration of the approach, process and depart trajectories, in seconds */
+double planDuration(const godel_msgs::ProcessPlan& plan);
+
+/** @brief Distance the tool travels in the process trajectory, including moves between segments, in meters */
+double processPathLength(const godel_msgs::ProcessPlan& plan);
+
+} // namespace godel_pipeline_benchmark
+
+#endif // GODEL_PIPELINE_BENCHMARK_STAND_INS_H
@@ -0,0 +1,178 @@
+/*
+ * Offline auto-tuning of the detection and planning parameters on labelled scans. Parameter sets
+ * are searched with successive halving, evaluated in parallel with in-process detection and tool
+ * path generation, and the Pareto front of runtime, segmentation error, scan coverage and cycle
+ * time is exported as parameter files that surface_blending_service can load. See the package
+ * README for the dataset format.
+ */
+
+#include <godel_pipeline_benchmark/parameter_tuning.h>
+
+#include <detection/surface_detection.h>
+#include <ros/package.h>
+#include <ros/ros.h>
+
+#include <fstream>
+#include <iomanip>
+
+using namespace godel_pipeline_benchmark;
+
+// The process parameters are read from the same places as in surface_blending_service
+const static std::string PATH_PARAM_BASE = "/path_planning_params/";
+const static std::string PARAM_BASE = "/process_planning_params/";
+const static std::string SCAN_PARAM_BASE = PARAM_BASE + "scan_params/";
+const static std::string BLEND_PARAM_BASE = PARAM_BASE + "blend_params/";
+
+const static std::string FRONT_SUMMARY_FILE = "pareto_front.yaml";
+
+static void loadProcessParameters(ParameterSet& set)
+{
+  ros::NodeHandle nh;
+
+  nh.getParam(PATH_PARAM_BASE + "discretization", set.path_planning.discretization);
+  nh.getParam(PATH_PARAM_BASE + "margin", set.path_planning.margin);
+  nh.getParam(PATH_PARAM_BASE + "overlap", set.path_planning.overlap);
+  nh.getParam(PATH_PARAM_BASE + "safe_traverse_height", set.path_planning.traverse_height);
+  nh.getParam(PATH_PARAM_BASE + "scan_width", set.path_planning.scan_width);
+  nh.getParam(PATH_PARAM_BASE + "tool_radius", set.path_planning.tool_radius);
+
+  nh.getParam(PATH_PARAM_BASE + "margin", set.blend.margin);
+  nh.getParam(PATH_PARAM_BASE + "overlap", set.blend.overlap);
+  nh.getParam(PATH_PARAM_BASE + "tool_radius", set.blend.tool_radius);
+  nh.getParam(PATH_PARAM_BASE + "discretization", set.blend.discretization);
+  nh.getParam(PATH_PARAM_BASE + "safe_traverse_height", set.blend.safe_traverse_height);
+  nh.getParam(BLEND_PARAM_BASE + "spindle_speed", set.blend.spindle_speed);
+  nh.getParam(BLEND_PARAM_BASE + "approach_speed", set.blend.approach_spd);
+  nh.getParam(BLEND_PARAM_BASE + "blending_speed", set.blend.blending_spd);
+  nh.getParam(BLEND_PARAM_BASE + "retract_speed", set.blend.retract_spd);
+  nh.getParam(BLEND_PARAM_BASE + "traverse_speed", set.blend.traverse_spd);
+  nh.getParam(BLEND_PARAM_BASE + "z_adjust", set.blend.z_adjust);
+
+  nh.getParam(PATH_PARAM_BASE + "scan_width", set.scan.scan_width);
+  nh.getParam(PATH_PARAM_BASE + "margin", set.scan.margin);
+  nh.getParam(PATH_PARAM_BASE + "overlap", set.scan.overlap);
+  nh.getParam(SCAN_PARAM_BASE + "approach_distance", set.scan.approach_distance);
+  nh.getParam(SCAN_PARAM_BASE + "traverse_speed", set.scan.traverse_spd);
+  nh.getParam(SCAN_PARAM_BASE + "quality_metric", set.scan.quality_metric);
+  nh.getParam(SCAN_PARAM_BASE + "window_width", set.scan.window_width);
+  nh.getParam(SCAN_PARAM_BASE + "min_qa_value", set.scan.min_qa_value);
+  nh.getParam(SCAN_PARAM_BASE + "max_qa_value", set.scan.max_qa_value);
+}
+
+static void writeFrontSummary(std::ostream& os, const std::vector<ParameterRange>& ranges,
+                              const std::vector<const Candidate*>& front)
+{
+  os << std::setprecision(6);
+  os << "front:\n";
+  for (std::size_t i = 0; i < front.size(); ++i)
+  {
+    const std::vector<double> objectives = objectiveValues(front[i]->score);
+    os << "  - directory: front_" << i << "\n";
+    for (std::size_t k = 0; k < OBJECTIVES.size(); ++k)
+      os << "    " << OBJECTIVES[k] << ": " << objectives[k] << "\n";
+    os << "    parameters:\n";
+    for (std::size_t k = 0; k < ranges.size(); ++k)
+      os << "      " << ranges[k].name << ": " << front[i]->values[k] << "\n";
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "auto_tune");
+  ros::NodeHandle pnh("~");
+
+  std::string output_directory;
+  int candidates, min_parts, seed, threads;
+  double eta;
+  pnh.param<std::string>("output_directory", output_directory, "godel_tuning");
+  pnh.param("candidates", candidates, 27);
+  pnh.param("eta", eta, 3.0);
+  pnh.param("min_parts", min_parts, 1);
+  pnh.param("seed", seed, 0);
+  pnh.param("threads", threads, 0);
+  if (candidates < 1 || eta <= 1.0 || min_parts < 1 || threads < 0)
+  {
+    ROS_ERROR("'candidates' and 'min_parts' must be positive, 'eta' greater than 1 and 'threads' not negative");
+    return 1;
+  }
+
+  XmlRpc::XmlRpcValue parts, parameters;
+  std::vector<TuningPart> dataset;
+  std::vector<ParameterRange> ranges;
+  if (!pnh.getParam("parts", parts) ||
+      !loadTuningParts(parts, ros::package::getPath("godel_pipeline_benchmark") + "/data", dataset) ||
+      dataset.empty())
+  {
+    ROS_ERROR("No tuning dataset was loaded into '%s/parts'", pnh.getNamespace().c_str());
+    return 1;
+  }
+  if (!pnh.getParam("parameters", parameters) || !loadParameterRanges(parameters, ranges) || ranges.empty())
+  {
+    ROS_ERROR("No tuned parameters were loaded from '%s/parameters'", pnh.getNamespace().c_str());
+    return 1;
+  }
+
+  // The search starts from the robot configuration's parameters
+  ParameterSet base;
+  godel_surface_detection::detection::SurfaceDetection detection;
+  if (!detection.load_parameters(""))
+  {
+    ROS_ERROR("Unable to load the surface detection parameters from '%s/surface_detection'",
+              pnh.getNamespace().c_str());
+    return 1;
+  }
+  base.detection = detection.params_;
+  loadProcessParameters(base);
+
+  TuningOptions options;
+  options.candidates = candidates;
+  options.eta = eta;
+  options.min_parts = min_parts;
+  options.seed = seed;
+  options.threads = threads;
+
+  // Evaluations run side by side, so each one estimates normals on a single thread
+  const std::vector<Candidate> results = successiveHalving(
+      base, ranges, dataset, options,
+      [](const ParameterSet& set, const TuningPart& part) { return evaluateParameterSet(set, part, 1); });
+
+  std::vector<const Candidate*> finalists;
+  std::vector<std::vector<double>> objectives;
+  for (const auto& c : results)
+  {
+    if (c.part_scores.size() == dataset.size())
+    {
+      finalists.push_back(&c);
+      objectives.push_back(objectiveValues(c.score));
+    }
+  }
+  const std::vector<std::size_t> ranks = paretoRanks(objectives);
+
+  std::vector<const Candidate*> front;
+  for (std::size_t i = 0; i < finalists.size(); ++i)
+  {
+    if (ranks[i] == 0)
+    {
+      if (!exportParameterSet(finalists[i]->params, output_directory + "/front_" + std::to_string(front.size())))
+        return 1;
+      front.push_back(finalists[i]);
+    }
+  }
+
+  std::ofstream fp(output_directory + "/" + FRONT_SUMMARY_FILE);
+  if (!fp)
+  {
+    ROS_ERROR_STREAM("Unable to write " << output_directory << "/" << FRONT_SUMMARY_FILE);
+    return 1;
+  }
+  writeFrontSummary(fp, ranges, front);
+
+  for (std::size_t i = 0; i < front.size(); ++i)
+  {
+    const Score& s = front[i]->score;
+    ROS_INFO("front_%-3zu runtime %8.3f s  segmentation error %6.3f  coverage error %6.3f  cycle time %8.1f s", i,
+             s.runtime_s, s.segmentation_error, s.coverage_error, s.cycle_time_s);
+  }
+  ROS_INFO_STREAM(front.size() << " Pareto optimal parameter sets written to " << output_directory);
+  return 0;
+}
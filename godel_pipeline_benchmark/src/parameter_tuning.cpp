@@ -0,0 +1,706 @@
+#include <godel_pipeline_benchmark/parameter_tuning.h>
+#include <godel_pipeline_benchmark/stand_ins.h>
+
+#include <detection/surface_detection.h>
+#include <godel_param_helpers/godel_param_helpers.h>
+#include <profilometer/profilometer_scan.h>
+#include <segmentation/edge_paths.h>
+#include <synthetic/synthetic_workload.h>
+
+#include <Eigen/Eigenvalues>
+#include <boost/filesystem.hpp>
+#include <pcl/common/io.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/kdtree/kdtree_flann.h>
+#include <ros/console.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+#include <thread>
+#include <tuple>
+
+// Process points farther than this from every ground truth point are unlabelled
+const static double LABEL_MATCH_RADIUS = 0.005; // m
+// Scan coverage is estimated on at most this many points per surface
+const static std::size_t MAX_COVERAGE_POINTS = 2000;
+
+namespace
+{
+
+using godel_pipeline_benchmark::ParameterSet;
+typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+
+struct Field
+{
+  std::function<double(const ParameterSet&)> get;
+  std::function<void(ParameterSet&, double)> set;
+  bool integer;
+};
+
+template <typename T> void assign(T& field, double value) { field = value; }
+
+void assign(int32_t& field, double value) { field = static_cast<int32_t>(std::lround(value)); }
+
+template <class Msg, class T> Field makeField(Msg ParameterSet::*msg, T Msg::*field)
+{
+  Field f;
+  f.get = [msg, field](const ParameterSet& s) { return static_cast<double>(s.*msg.*field); };
+  f.set = [msg, field](ParameterSet& s, double value) { assign(s.*msg.*field, value); };
+  f.integer = std::is_integral<T>::value;
+  return f;
+}
+
+// Only fields that detection, in-process path generation or the stand-in planner read
+const std::map<std::string, Field>& fields()
+{
+  typedef godel_msgs::SurfaceDetectionParameters Detection;
+  typedef godel_msgs::PathPlanningParameters PathPlanning;
+  typedef godel_msgs::BlendingPlanParameters Blend;
+  typedef godel_msgs::ScanPlanParameters Scan;
+  static const std::map<std::string, Field> table = {
+      {"detection.voxel_leafsize", makeField(&ParameterSet::detection, &Detection::voxel_leafsize)},
+      {"detection.normal_radius", makeField(&ParameterSet::detection, &Detection::normal_radius)},
+      {"detection.rg_min_cluster_size", makeField(&ParameterSet::detection, &Detection::rg_min_cluster_size)},
+      {"detection.rg_max_cluster_size", makeField(&ParameterSet::detection, &Detection::rg_max_cluster_size)},
+      {"detection.rg_neightbors", makeField(&ParameterSet::detection, &Detection::rg_neightbors)},
+      {"detection.rg_smoothness_threshold", makeField(&ParameterSet::detection, &Detection::rg_smoothness_threshold)},
+      {"detection.rg_curvature_threshold", makeField(&ParameterSet::detection, &Detection::rg_curvature_threshold)},
+      {"detection.rg_coarse_leaf", makeField(&ParameterSet::detection, &Detection::rg_coarse_leaf)},
+      {"path_planning.scan_width", makeField(&ParameterSet::path_planning, &PathPlanning::scan_width)},
+      {"path_planning.overlap", makeField(&ParameterSet::path_planning, &PathPlanning::overlap)},
+      {"blend.approach_spd", makeField(&ParameterSet::blend, &Blend::approach_spd)},
+      {"blend.blending_spd", makeField(&ParameterSet::blend, &Blend::blending_spd)},
+      {"blend.retract_spd", makeField(&ParameterSet::blend, &Blend::retract_spd)},
+      {"blend.traverse_spd", makeField(&ParameterSet::blend, &Blend::traverse_spd)},
+      {"blend.safe_traverse_height", makeField(&ParameterSet::blend, &Blend::safe_traverse_height)},
+      {"scan.approach_distance", makeField(&ParameterSet::scan, &Scan::approach_distance)},
+      {"scan.traverse_spd", makeField(&ParameterSet::scan, &Scan::traverse_spd)},
+  };
+  return table;
+}
+
+double toDouble(XmlRpc::XmlRpcValue& value)
+{
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+    return static_cast<int>(value);
+  return static_cast<double>(value);
+}
+
+bool isNumber(XmlRpc::XmlRpcValue& value)
+{
+  return value.getType() == XmlRpc::XmlRpcValue::TypeInt || value.getType() == XmlRpc::XmlRpcValue::TypeDouble;
+}
+
+bool optionalBool(XmlRpc::XmlRpcValue& entry, const std::string& name, bool& value)
+{
+  if (!entry.hasMember(name))
+    return true;
+  if (entry[name].getType() != XmlRpc::XmlRpcValue::TypeBoolean)
+    return false;
+  value = static_cast<bool>(entry[name]);
+  return true;
+}
+
+// Principal axes of a surface: x along its length, z along its normal and pointing up
+Eigen::Affine3d surfaceFrame(const CloudRGB& surface)
+{
+  Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+  for (const auto& p : surface.points)
+    mean += Eigen::Vector3d(p.x, p.y, p.z);
+  mean /= static_cast<double>(surface.size());
+
+  Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+  for (const auto& p : surface.points)
+  {
+    const Eigen::Vector3d d = Eigen::Vector3d(p.x, p.y, p.z) - mean;
+    covariance += d * d.transpose();
+  }
+
+  // Eigenvalues are sorted in increasing order
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+  Eigen::Vector3d z = solver.eigenvectors().col(0);
+  if (z.z() < 0.0)
+    z = -z;
+  const Eigen::Vector3d x = (solver.eigenvectors().col(2) - solver.eigenvectors().col(2).dot(z) * z).normalized();
+
+  Eigen::Affine3d frame = Eigen::Affine3d::Identity();
+  frame.linear().col(0) = x;
+  frame.linear().col(1) = z.cross(x);
+  frame.linear().col(2) = z;
+  frame.translation() = mean;
+  return frame;
+}
+
+double cross(const Eigen::Vector2d& o, const Eigen::Vector2d& a, const Eigen::Vector2d& b)
+{
+  return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+// Counter-clockwise convex hull (Andrew's monotone chain)
+godel_process_path::PolygonBoundary convexHull(std::vector<Eigen::Vector2d> points)
+{
+  godel_process_path::PolygonBoundary boundary;
+  if (points.size() < 3)
+  {
+    for (const auto& p : points)
+      boundary.push_back(godel_process_path::PolygonPt(p.x(), p.y()));
+    return boundary;
+  }
+
+  std::sort(points.begin(), points.end(), [](const Eigen::Vector2d& a, const Eigen::Vector2d& b) {
+    return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+  });
+
+  std::vector<Eigen::Vector2d> hull(2 * points.size());
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0)
+      --k;
+    hull[k++] = points[i];
+  }
+  for (std::size_t i = points.size() - 1, lower = k + 1; i-- > 0;)
+  {
+    while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0)
+      --k;
+    hull[k++] = points[i];
+  }
+
+  for (std::size_t i = 0; i + 1 < k; ++i)
+    boundary.push_back(godel_process_path::PolygonPt(hull[i].x(), hull[i].y()));
+  return boundary;
+}
+
+double segmentDistance(const Eigen::Vector2d& p, const Eigen::Vector2d& a, const Eigen::Vector2d& b)
+{
+  const Eigen::Vector2d ab = b - a;
+  const double length2 = ab.squaredNorm();
+  const double t = length2 > 0.0 ? std::max(0.0, std::min(1.0, (p - a).dot(ab) / length2)) : 0.0;
+  return (p - (a + t * ab)).norm();
+}
+
+struct ScanResult
+{
+  geometry_msgs::PoseArray path;
+  std::size_t sampled; // surface points checked for coverage
+  std::size_t covered; // of which a scan stripe passes over
+};
+
+/**
+ * The scan planner plugin rasters the bounding box of the surface's outer boundary in the mesh's
+ * frame. The convex hull in the surface's principal axes has the same bounding box, without a mesh.
+ */
+ScanResult planScanPath(const CloudRGB& surface, const godel_msgs::PathPlanningParameters& params)
+{
+  ScanResult result;
+  result.sampled = result.covered = 0;
+
+  const Eigen::Affine3d frame = surfaceFrame(surface);
+  const Eigen::Affine3d to_local = frame.inverse();
+  std::vector<Eigen::Vector2d> local;
+  local.reserve(surface.size());
+  for (const auto& p : surface.points)
+    local.push_back((to_local * Eigen::Vector3d(p.x, p.y, p.z)).head<2>());
+
+  const std::vector<godel_process_path::PolygonPt> raster =
+      path_planning_plugins::scan::generateProfilometerScanPath(convexHull(local), params);
+
+  const Eigen::Quaterniond q(frame.rotation());
+  std::vector<Eigen::Vector2d> line;
+  for (const auto& pt : raster)
+  {
+    const Eigen::Vector3d position = frame * Eigen::Vector3d(pt.x, pt.y, 0.0);
+    geometry_msgs::Pose pose;
+    pose.position.x = position.x();
+    pose.position.y = position.y();
+    pose.position.z = position.z();
+    pose.orientation.x = q.x();
+    pose.orientation.y = q.y();
+    pose.orientation.z = q.z();
+    pose.orientation.w = q.w();
+    result.path.poses.push_back(pose);
+    line.push_back(Eigen::Vector2d(pt.x, pt.y));
+  }
+
+  const double half_width = params.scan_width / 2.0;
+  const std::size_t stride = std::max<std::size_t>(1, local.size() / MAX_COVERAGE_POINTS);
+  for (std::size_t i = 0; i < local.size(); i += stride)
+  {
+    ++result.sampled;
+    for (std::size_t j = 0; j + 1 < line.size(); ++j)
+    {
+      if (segmentDistance(local[i], line[j], line[j + 1]) <= half_width)
+      {
+        ++result.covered;
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+double normalized(double value, double min, double max)
+{
+  return max > min ? (value - min) / (max - min) : 0.0;
+}
+
+} // end anon namespace
+
+std::vector<std::string> godel_pipeline_benchmark::tunableParameters()
+{
+  std::vector<std::string> names;
+  for (const auto& field : fields())
+    names.push_back(field.first);
+  return names;
+}
+
+bool godel_pipeline_benchmark::setParameter(ParameterSet& set, const std::string& name, double value)
+{
+  const auto it = fields().find(name);
+  if (it == fields().end())
+    return false;
+  it->second.set(set, value);
+  return true;
+}
+
+bool godel_pipeline_benchmark::getParameter(const ParameterSet& set, const std::string& name, double& value)
+{
+  const auto it = fields().find(name);
+  if (it == fields().end())
+    return false;
+  value = it->second.get(set);
+  return true;
+}
+
+bool godel_pipeline_benchmark::loadParameterRanges(XmlRpc::XmlRpcValue& list, std::vector<ParameterRange>& ranges)
+{
+  if (list.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    ROS_ERROR("The tuned 'parameters' must be a list");
+    return false;
+  }
+
+  for (int i = 0; i < list.size(); ++i)
+  {
+    XmlRpc::XmlRpcValue& entry = list[i];
+    if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("name") ||
+        !entry.hasMember("min") || !entry.hasMember("max") || !isNumber(entry["min"]) || !isNumber(entry["max"]))
+    {
+      ROS_ERROR_STREAM("Tuned parameter " << i << " needs a name, a min and a max");
+      return false;
+    }
+
+    ParameterRange range;
+    range.name = static_cast<std::string>(entry["name"]);
+    range.min = toDouble(entry["min"]);
+    range.max = toDouble(entry["max"]);
+    range.integer = false;
+    range.log_scale = false;
+
+    const auto field = fields().find(range.name);
+    if (field == fields().end())
+    {
+      ROS_ERROR_STREAM("'" << range.name << "' can't be tuned");
+      return false;
+    }
+    if (!optionalBool(entry, "integer", range.integer) || !optionalBool(entry, "log", range.log_scale))
+    {
+      ROS_ERROR_STREAM("'integer' and 'log' of '" << range.name << "' must be true or false");
+      return false;
+    }
+    range.integer = range.integer || field->second.integer;
+
+    if (!(range.min < range.max) || (range.log_scale && range.min <= 0.0))
+    {
+      ROS_ERROR_STREAM("'" << range.name << "' has an empty range, or a log range that isn't positive");
+      return false;
+    }
+    ranges.push_back(range);
+  }
+  return true;
+}
+
+bool godel_pipeline_benchmark::loadTuningParts(XmlRpc::XmlRpcValue& parts, const std::string& data_directory,
+                                               std::vector<TuningPart>& dataset)
+{
+  if (parts.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    ROS_ERROR("The tuning dataset's 'parts' must be a list");
+    return false;
+  }
+
+  for (int i = 0; i < parts.size(); ++i)
+  {
+    XmlRpc::XmlRpcValue& entry = parts[i];
+    if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("name"))
+    {
+      ROS_ERROR_STREAM("Tuning part " << i << " has no name");
+      return false;
+    }
+
+    TuningPart part;
+    part.name = static_cast<std::string>(entry["name"]);
+    part.cloud.reset(new LabelledCloud());
+
+    if (entry.hasMember("pcd"))
+    {
+      std::string pcd = static_cast<std::string>(entry["pcd"]);
+      if (!pcd.empty() && pcd[0] != '/')
+        pcd = data_directory + "/" + pcd;
+      if (pcl::io::loadPCDFile(pcd, *part.cloud) != 0)
+      {
+        ROS_ERROR_STREAM("Unable to load the labelled cloud of '" << part.name << "' from " << pcd);
+        return false;
+      }
+    }
+    else if (entry.hasMember("part"))
+    {
+      godel_surface_detection::synthetic::PartDescription description;
+      if (!godel_surface_detection::synthetic::loadPart(entry["part"], description) ||
+          !godel_surface_detection::synthetic::generatePart(description, *part.cloud))
+      {
+        ROS_ERROR_STREAM("Unable to generate the synthetic part '" << part.name << "'");
+        return false;
+      }
+    }
+    else
+    {
+      ROS_ERROR_STREAM("Tuning part '" << part.name << "' needs a 'pcd' or a 'part'");
+      return false;
+    }
+    dataset.push_back(part);
+  }
+  return true;
+}
+
+std::vector<double> godel_pipeline_benchmark::objectiveValues(const Score& score)
+{
+  return {score.runtime_s, score.segmentation_error, score.coverage_error, score.cycle_time_s};
+}
+
+godel_pipeline_benchmark::Score godel_pipeline_benchmark::meanScore(const std::vector<Score>& scores)
+{
+  Score mean;
+  if (scores.empty())
+    return mean;
+  for (const auto& s : scores)
+  {
+    mean.runtime_s += s.runtime_s;
+    mean.segmentation_error += s.segmentation_error;
+    mean.coverage_error += s.coverage_error;
+    mean.cycle_time_s += s.cycle_time_s;
+  }
+  mean.runtime_s /= scores.size();
+  mean.segmentation_error /= scores.size();
+  mean.coverage_error /= scores.size();
+  mean.cycle_time_s /= scores.size();
+  return mean;
+}
+
+double godel_pipeline_benchmark::segmentationScore(const LabelledCloud& truth, const CloudRGB& process_cloud,
+                                                   const std::vector<CloudRGB::Ptr>& segments,
+                                                   double match_radius)
+{
+  if (truth.empty())
+    return 0.0;
+
+  pcl::KdTreeFLANN<LabelledPoint> tree;
+  tree.setInputCloud(truth.makeShared());
+  std::vector<int> index(1);
+  std::vector<float> sqr_distance(1);
+  const float max_sqr_distance = match_radius * match_radius;
+  auto labelOf = [&](const pcl::PointXYZRGB& p) -> uint32_t {
+    LabelledPoint query;
+    query.x = p.x;
+    query.y = p.y;
+    query.z = p.z;
+    if (!pcl::isFinite(p) || tree.nearestKSearch(query, 1, index, sqr_distance) < 1 ||
+        sqr_distance[0] > max_sqr_distance)
+      return 0;
+    return truth[index[0]].label;
+  };
+
+  // Ground truth surface sizes, in process points
+  std::map<uint32_t, std::size_t> truth_sizes;
+  std::size_t labelled = 0;
+  for (const auto& p : process_cloud.points)
+  {
+    const uint32_t label = labelOf(p);
+    if (label != 0)
+    {
+      ++truth_sizes[label];
+      ++labelled;
+    }
+  }
+  if (labelled == 0)
+    return 0.0;
+
+  // Candidate pairs, best overlap first
+  std::vector<std::tuple<double, uint32_t, std::size_t>> pairs;
+  for (std::size_t s = 0; s < segments.size(); ++s)
+  {
+    std::map<uint32_t, std::size_t> intersections;
+    for (const auto& p : segments[s]->points)
+    {
+      const uint32_t label = labelOf(p);
+      if (label != 0)
+        ++intersections[label];
+    }
+    for (const auto& i : intersections)
+    {
+      const double iou = static_cast<double>(i.second) / (truth_sizes[i.first] + segments[s]->size() - i.second);
+      pairs.push_back(std::make_tuple(iou, i.first, s));
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(), [](const std::tuple<double, uint32_t, std::size_t>& a,
+                                           const std::tuple<double, uint32_t, std::size_t>& b) {
+    return std::get<0>(a) > std::get<0>(b);
+  });
+
+  std::map<uint32_t, bool> truth_used;
+  std::vector<bool> segment_used(segments.size(), false);
+  double score = 0.0;
+  for (const auto& pair : pairs)
+  {
+    const uint32_t label = std::get<1>(pair);
+    const std::size_t segment = std::get<2>(pair);
+    if (truth_used[label] || segment_used[segment])
+      continue;
+    truth_used[label] = segment_used[segment] = true;
+    score += std::get<0>(pair) * truth_sizes[label] / labelled;
+  }
+  return score;
+}
+
+godel_pipeline_benchmark::Score godel_pipeline_benchmark::evaluateParameterSet(const ParameterSet& set,
+                                                                               const TuningPart& part, int threads)
+{
+  godel_surface_detection::detection::SurfaceDetection detection;
+  detection.params_ = set.detection;
+  detection.normal_estimation_threads_ = threads;
+  detection.init();
+
+  CloudRGB cloud;
+  pcl::copyPointCloud(*part.cloud, cloud);
+  detection.add_cloud(cloud);
+
+  // Only detection and tool path generation count towards the runtime
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<CloudRGB::Ptr> surfaces;
+  if (detection.segment_surfaces())
+    detection.get_surface_clouds(surfaces);
+
+  std::vector<geometry_msgs::PoseArray> edges;
+  std::vector<ScanResult> scans;
+  for (const auto& surface : surfaces)
+  {
+    godel_surface_detection::generateEdgePaths(surface, edges);
+    scans.push_back(planScanPath(*surface, set.path_planning));
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  Score score;
+  score.runtime_s = elapsed.count();
+
+  CloudRGB process_cloud;
+  detection.get_process_cloud(process_cloud);
+  score.segmentation_error = 1.0 - segmentationScore(*part.cloud, process_cloud, surfaces, LABEL_MATCH_RADIUS);
+
+  StandInProcessPlanner planner;
+  godel_msgs::ProcessPath path;
+  godel_msgs::ProcessPlan plan;
+  std::size_t sampled = 0, covered = 0;
+  for (const auto& scan : scans)
+  {
+    sampled += scan.sampled;
+    covered += scan.covered;
+    path.segments = {scan.path};
+    if (planner.planScan(path, set.scan, plan))
+      score.cycle_time_s += planDuration(plan);
+  }
+  for (const auto& edge : edges)
+  {
+    path.segments = {edge};
+    if (planner.planBlend(path, set.blend, plan))
+      score.cycle_time_s += planDuration(plan);
+  }
+
+  // Finding no surface leaves nothing scanned
+  score.coverage_error = sampled > 0 ? 1.0 - static_cast<double>(covered) / sampled : 1.0;
+  return score;
+}
+
+std::vector<std::size_t> godel_pipeline_benchmark::paretoRanks(const std::vector<std::vector<double>>& points)
+{
+  auto dominates = [](const std::vector<double>& a, const std::vector<double>& b) {
+    bool better = false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+      if (a[i] > b[i])
+        return false;
+      better = better || a[i] < b[i];
+    }
+    return better;
+  };
+
+  const std::size_t unranked = std::numeric_limits<std::size_t>::max();
+  std::vector<std::size_t> ranks(points.size(), unranked);
+  std::size_t remaining = points.size();
+  for (std::size_t rank = 0; remaining > 0; ++rank)
+  {
+    std::vector<std::size_t> front;
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+      if (ranks[i] != unranked)
+        continue;
+      bool dominated = false;
+      for (std::size_t j = 0; j < points.size() && !dominated; ++j)
+        dominated = j != i && ranks[j] == unranked && dominates(points[j], points[i]);
+      if (!dominated)
+        front.push_back(i);
+    }
+    for (std::size_t i : front)
+      ranks[i] = rank;
+    remaining -= front.size();
+  }
+  return ranks;
+}
+
+std::vector<godel_pipeline_benchmark::Candidate>
+godel_pipeline_benchmark::successiveHalving(const ParameterSet& base, const std::vector<ParameterRange>& ranges,
+                                            const std::vector<TuningPart>& dataset, const TuningOptions& options,
+                                            const Evaluator& evaluate)
+{
+  std::vector<Candidate> candidates(std::max<std::size_t>(1, options.candidates));
+  if (dataset.empty())
+    return candidates;
+
+  // The current parameters, then a Latin hypercube: every range is cut into as many strata as
+  // there are samples and each stratum is sampled once
+  std::mt19937 rng(options.seed);
+  std::uniform_real_distribution<double> jitter(0.0, 1.0);
+  const std::size_t samples = candidates.size() - 1;
+  for (auto& c : candidates)
+    c.params = base;
+  for (const auto& range : ranges)
+  {
+    double current;
+    getParameter(base, range.name, current);
+    candidates[0].values.push_back(current);
+
+    std::vector<std::size_t> strata(samples);
+    for (std::size_t i = 0; i < samples; ++i)
+      strata[i] = i;
+    std::shuffle(strata.begin(), strata.end(), rng);
+
+    for (std::size_t i = 0; i < samples; ++i)
+    {
+      const double u = (strata[i] + jitter(rng)) / samples;
+      double value = range.log_scale ? std::exp(std::log(range.min) + u * (std::log(range.max) - std::log(range.min)))
+                                     : range.min + u * (range.max - range.min);
+      if (range.integer)
+        value = std::round(value);
+      candidates[i + 1].values.push_back(value);
+      setParameter(candidates[i + 1].params, range.name, value);
+    }
+  }
+
+  const double eta = std::max(options.eta, 1.0);
+  const unsigned threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::size_t> alive(candidates.size());
+  for (std::size_t i = 0; i < alive.size(); ++i)
+    alive[i] = i;
+  std::size_t budget = std::min(dataset.size(), std::max<std::size_t>(1, options.min_parts));
+
+  while (true)
+  {
+    // Survivors have already been scored on the parts of the previous rungs
+    std::vector<std::pair<std::size_t, std::size_t>> tasks;
+    for (std::size_t c : alive)
+    {
+      for (std::size_t p = candidates[c].part_scores.size(); p < budget; ++p)
+        tasks.push_back(std::make_pair(c, p));
+      candidates[c].part_scores.resize(budget);
+    }
+
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+      for (std::size_t t = next++; t < tasks.size(); t = next++)
+      {
+        Candidate& c = candidates[tasks[t].first];
+        c.part_scores[tasks[t].second] = evaluate(c.params, dataset[tasks[t].second]);
+      }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < std::min<std::size_t>(threads, tasks.size()); ++i)
+      pool.push_back(std::thread(worker));
+    worker();
+    for (auto& t : pool)
+      t.join();
+
+    for (std::size_t c : alive)
+      candidates[c].score = meanScore(candidates[c].part_scores);
+
+    ROS_INFO_STREAM("Evaluated " << alive.size() << " parameter sets on " << budget << " of " << dataset.size()
+                                 << " parts");
+    if (budget == dataset.size())
+      break;
+
+    // Keep the best 1/eta: lowest non-dominated rank, then lowest sum of normalized objectives
+    std::vector<std::vector<double>> objectives;
+    for (std::size_t c : alive)
+      objectives.push_back(objectiveValues(candidates[c].score));
+    const std::vector<std::size_t> ranks = paretoRanks(objectives);
+
+    std::vector<double> lo = objectives.front(), hi = objectives.front();
+    for (const auto& o : objectives)
+    {
+      for (std::size_t k = 0; k < o.size(); ++k)
+      {
+        lo[k] = std::min(lo[k], o[k]);
+        hi[k] = std::max(hi[k], o[k]);
+      }
+    }
+    std::vector<double> sums(objectives.size(), 0.0);
+    for (std::size_t i = 0; i < objectives.size(); ++i)
+      for (std::size_t k = 0; k < lo.size(); ++k)
+        sums[i] += normalized(objectives[i][k], lo[k], hi[k]);
+
+    std::vector<std::size_t> order(alive.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return std::make_tuple(ranks[a], sums[a], a) < std::make_tuple(ranks[b], sums[b], b);
+    });
+
+    const std::size_t keep = std::max<std::size_t>(1, std::ceil(alive.size() / eta));
+    std::vector<std::size_t> survivors;
+    for (std::size_t i = 0; i < keep; ++i)
+      survivors.push_back(alive[order[i]]);
+    alive = survivors;
+    budget = std::min<std::size_t>(dataset.size(), std::max<double>(budget + 1, std::ceil(budget * eta)));
+  }
+  return candidates;
+}
+
+bool godel_pipeline_benchmark::exportParameterSet(const ParameterSet& set, const std::string& directory)
+{
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(directory, ec);
+  if (ec)
+  {
+    ROS_ERROR_STREAM("Unable to create " << directory << ": " << ec.message());
+    return false;
+  }
+
+  // The file names surface_blending_service loads from its 'param_cache_prefix'
+  return godel_param_helpers::toFile(directory + "/godel_surface_detection_parameters.msg", set.detection) &&
+         godel_param_helpers::toFile(directory + "/godel_path_planning_parameters.msg", set.path_planning) &&
+         godel_param_helpers::toFile(directory + "/godel_blending_parameters.msg", set.blend) &&
+         godel_param_helpers::toFile(directory + "/godel_scan_parameters.msg", set.scan);
+}
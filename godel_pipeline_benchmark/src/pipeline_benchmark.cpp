@@ -0,0 +1,371 @@
+/*
+ * Offline end-to-end benchmark of the blending pipeline:
+ *
+ *   cloud ingest -> surface detection -> tool path generation -> process planning -> RAPID emission
+ *
+ * Detection and tool path generation run the same code as surface_blending_service (including
+ * the path planning plugins and the process path generator node they call). Stand-ins replace
+ * the MoveIt/Descartes process planners, the robot execution service and the FTP upload, so no
+ * robot, simulator or camera is needed. See the package README for the report format.
+ *
+ * The geometry services run either as nodes of their own or as nodelets in the benchmark's
+ * manager; the report's CPU time covers the benchmark and the processes of the nodes in cpu_nodes.
+ */
+
+#include <godel_pipeline_benchmark/pipeline_benchmark.h>
+#include <godel_pipeline_benchmark/pipeline_report.h>
+#include <godel_pipeline_benchmark/reference_dataset.h>
+#include <godel_pipeline_benchmark/stand_ins.h>
+
+#include <detection/surface_detection.h>
+#include <segmentation/edge_paths.h>
+#include <path_planning_plugins_base/path_planning_base.h>
+#include <pluginlib/class_loader.h>
+#include <ros/network.h>
+#include <ros/package.h>
+#include <ros/ros.h>
+#include <xmlrpcpp/XmlRpcClient.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <set>
+#include <unistd.h>
+
+using namespace godel_pipeline_benchmark;
+
+const static std::string PATH_GENERATION_SERVICE = "process_path_generator";
+const static double SERVICE_WAIT_TIME = 30.0; // seconds
+
+// Nodes whose processes' CPU time is reported with the benchmark's own
+const static std::string CPU_NODES_PARAM = "cpu_nodes";
+const static std::vector<std::string> DEFAULT_CPU_NODES = {"process_path_generator_node", "polygon_offset_node"};
+
+const static std::string BLEND_TOOL_PLUGIN_PARAM = "blend_tool_planning_plugin_name";
+const static std::string SCAN_TOOL_PLUGIN_PARAM = "scan_tool_planning_plugin_name";
+const static std::string MERGE_SURFACES_PARAM = "merge_surfaces";
+
+// The process parameters are read from the same places as in surface_blending_service
+const static std::string PATH_PARAM_BASE = "/path_planning_params/";
+const static std::string PARAM_BASE = "/process_planning_params/";
+const static std::string SCAN_PARAM_BASE = PARAM_BASE + "scan_params/";
+const static std::string BLEND_PARAM_BASE = PARAM_BASE + "blend_params/";
+
+typedef std::pair<std::string, std::vector<geometry_msgs::PoseArray>> NamedPath;
+typedef pluginlib::ClassLoader<path_planning_plugins_base::PathPlanningBase> PathPlannerLoader;
+
+static void loadProcessParameters(godel_msgs::BlendingPlanParameters& blend_params,
+                                  godel_msgs::ScanPlanParameters& scan_params)
+{
+  ros::NodeHandle nh;
+
+  nh.getParam(PATH_PARAM_BASE + "margin", blend_params.margin);
+  nh.getParam(PATH_PARAM_BASE + "overlap", blend_params.overlap);
+  nh.getParam(PATH_PARAM_BASE + "tool_radius", blend_params.tool_radius);
+  nh.getParam(PATH_PARAM_BASE + "discretization", blend_params.discretization);
+  nh.getParam(PATH_PARAM_BASE + "safe_traverse_height", blend_params.safe_traverse_height);
+  nh.getParam(BLEND_PARAM_BASE + "spindle_speed", blend_params.spindle_speed);
+  nh.getParam(BLEND_PARAM_BASE + "approach_speed", blend_params.approach_spd);
+  nh.getParam(BLEND_PARAM_BASE + "blending_speed", blend_params.blending_spd);
+  nh.getParam(BLEND_PARAM_BASE + "retract_speed", blend_params.retract_spd);
+  nh.getParam(BLEND_PARAM_BASE + "traverse_speed", blend_params.traverse_spd);
+  nh.getParam(BLEND_PARAM_BASE + "z_adjust", blend_params.z_adjust);
+
+  nh.getParam(PATH_PARAM_BASE + "scan_width", scan_params.scan_width);
+  nh.getParam(PATH_PARAM_BASE + "margin", scan_params.margin);
+  nh.getParam(PATH_PARAM_BASE + "overlap", scan_params.overlap);
+  nh.getParam(SCAN_PARAM_BASE + "approach_distance", scan_params.approach_distance);
+  nh.getParam(SCAN_PARAM_BASE + "traverse_speed", scan_params.traverse_spd);
+}
+
+static bool generateToolPaths(PathPlannerLoader& loader, const std::string& plugin_name,
+                              const pcl::PolygonMesh& mesh, std::vector<geometry_msgs::PoseArray>& result)
+{
+  try
+  {
+    auto planner = loader.createInstance(plugin_name);
+    planner->init(mesh);
+    return planner->generatePath(result);
+  }
+  catch (const pluginlib::PluginlibException& ex)
+  {
+    ROS_ERROR("Tool planning plugin '%s' failed to load: %s", plugin_name.c_str(), ex.what());
+    return false;
+  }
+}
+
+/**
+ * @brief Process ids of the named nodes, asked from the nodes themselves through their XML-RPC
+ * API; nodes that aren't running are left out
+ */
+static std::map<std::string, int> nodePids(const std::vector<std::string>& nodes)
+{
+  std::map<std::string, int> pids;
+  for (const auto& node : nodes)
+  {
+    const std::string name = ros::names::resolve(node);
+    XmlRpc::XmlRpcValue args, result, payload;
+    args[0] = ros::this_node::getName();
+    args[1] = name;
+    std::string host;
+    uint32_t port;
+    if (!ros::master::execute("lookupNode", args, result, payload, false) ||
+        !ros::network::splitURI(static_cast<std::string>(payload), host, port))
+    {
+      ROS_WARN_STREAM("Node '" << name << "' is not running; its CPU time is not reported");
+      continue;
+    }
+
+    XmlRpc::XmlRpcValue pid_args, pid_result;
+    pid_args[0] = ros::this_node::getName();
+    XmlRpc::XmlRpcClient client(host.c_str(), port, "/");
+    if (client.execute("getPid", pid_args, pid_result) && pid_result.getType() == XmlRpc::XmlRpcValue::TypeArray &&
+        pid_result.size() == 3 && static_cast<int>(pid_result[0]) == 1)
+      pids[name] = static_cast<int>(pid_result[2]);
+    else
+      ROS_WARN_STREAM("Unable to get the process id of node '" << name << "'");
+    client.close();
+  }
+  return pids;
+}
+
+/**
+ * @brief Summed CPU time of the given processes other than this one, each counted once
+ */
+static double otherProcessesCpuSeconds(const std::map<std::string, int>& pids)
+{
+  std::set<int> counted = {static_cast<int>(getpid())};
+  double seconds = 0.0;
+  for (const auto& node : pids)
+  {
+    if (counted.insert(node.second).second)
+      seconds += std::max(processCpuSeconds(node.second), 0.0);
+  }
+  return seconds;
+}
+
+static std::string pathType(const std::string& name)
+{
+  if (name.find("_edge_") != std::string::npos)
+    return "edge";
+  if (name.find("_scan") != std::string::npos)
+    return "scan";
+  return "blend";
+}
+
+class PipelineBenchmark
+{
+public:
+  PipelineBenchmark(ros::NodeHandle& pnh, PipelineReport& report, StandInExecutor& executor)
+    : report_(report), executor_(executor),
+      loader_("path_planning_plugins_base", "path_planning_plugins_base::PathPlanningBase")
+  {
+    pnh.getParam(BLEND_TOOL_PLUGIN_PARAM, blend_plugin_);
+    pnh.getParam(SCAN_TOOL_PLUGIN_PARAM, scan_plugin_);
+    pnh.param(MERGE_SURFACES_PARAM, merge_surfaces_, true);
+    loadProcessParameters(blend_params_, scan_params_);
+  }
+
+  /**
+   * @brief Runs one part through the whole pipeline
+   * @param metrics If not null, filled with the part's plan quality
+   */
+  void run(const DatasetPart& part, PartMetrics* metrics)
+  {
+    ScopedStageTimer end_to_end(report_, "end_to_end");
+    if (metrics)
+      metrics->name = part.name;
+
+    pcl::PointCloud<pcl::PointXYZRGB> cloud;
+    godel_surface_detection::detection::SurfaceDetection detection;
+    detection.params_.merge_enabled = merge_surfaces_;
+    {
+      ScopedStageTimer timer(report_, "ingest");
+      if (!loadPartCloud(part, cloud))
+        return;
+      detection.init();
+      detection.add_cloud(cloud);
+    }
+
+    {
+      ScopedStageTimer timer(report_, "detection");
+      if (!detection.find_surfaces())
+      {
+        ROS_WARN_STREAM("No surfaces were found in part '" << part.name << "'");
+        return;
+      }
+    }
+
+    std::vector<pcl::PolygonMesh> meshes;
+    std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> surfaces;
+    detection.get_meshes(meshes);
+    detection.get_surface_clouds(surfaces);
+    // Meshing can fail for some surfaces; the marker ids map meshes back to their surface clouds
+    const visualization_msgs::MarkerArray markers = detection.get_surface_markers();
+
+    if (metrics)
+    {
+      metrics->points = cloud.size();
+      metrics->segments = detection.get_merge_stats().segments;
+      metrics->surfaces = meshes.size();
+    }
+
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+      const std::string surface_name = part.name + "_surface_" + std::to_string(i);
+      std::vector<NamedPath> paths;
+      {
+        ScopedStageTimer timer(report_, "path_generation");
+        generatePaths(surface_name, meshes[i], surfaces[markers.markers[i].id], paths);
+      }
+
+      for (const auto& path : paths)
+        planAndEmit(path, metrics);
+    }
+  }
+
+private:
+  void generatePaths(const std::string& name, const pcl::PolygonMesh& mesh,
+                     const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& surface, std::vector<NamedPath>& paths)
+  {
+    std::vector<geometry_msgs::PoseArray> blend, scan, edges;
+    if (generateToolPaths(loader_, blend_plugin_, mesh, blend))
+      paths.push_back(NamedPath(name + "_blend", blend));
+    if (generateToolPaths(loader_, scan_plugin_, mesh, scan))
+      paths.push_back(NamedPath(name + "_scan", scan));
+    if (godel_surface_detection::generateEdgePaths(surface, edges))
+    {
+      for (std::size_t k = 0; k < edges.size(); ++k)
+        paths.push_back(NamedPath(name + "_edge_" + std::to_string(k), {edges[k]}));
+    }
+  }
+
+  void planAndEmit(const NamedPath& path, PartMetrics* metrics)
+  {
+    const std::string type = pathType(path.first);
+    godel_msgs::ProcessPath process_path;
+    process_path.segments = path.second;
+
+    godel_msgs::ProcessPlan plan;
+    bool planned;
+    {
+      ScopedStageTimer timer(report_, "planning");
+      planned = type == "scan" ? planner_.planScan(process_path, scan_params_, plan)
+                               : planner_.planBlend(process_path, blend_params_, plan);
+    }
+    if (!planned)
+    {
+      ROS_WARN_STREAM("Failed to plan " << path.first);
+      return;
+    }
+
+    std::size_t bytes = 0;
+    bool emitted;
+    {
+      ScopedStageTimer timer(report_, "rapid_emission");
+      emitted = executor_.execute(path.first, plan, bytes);
+    }
+
+    if (metrics && emitted)
+    {
+      PlanMetrics m;
+      m.name = path.first;
+      m.type = type;
+      m.points = plan.trajectory_approach.points.size() + plan.trajectory_process.points.size() +
+                 plan.trajectory_depart.points.size();
+      m.path_length_m = processPathLength(plan);
+      m.cycle_time_s = planDuration(plan);
+      m.rapid_bytes = bytes;
+      metrics->plans.push_back(m);
+    }
+  }
+
+  PipelineReport& report_;
+  StandInExecutor& executor_;
+  StandInProcessPlanner planner_;
+  PathPlannerLoader loader_;
+  std::string blend_plugin_;
+  std::string scan_plugin_;
+  bool merge_surfaces_;
+  godel_msgs::BlendingPlanParameters blend_params_;
+  godel_msgs::ScanPlanParameters scan_params_;
+};
+
+int godel_pipeline_benchmark::runPipelineBenchmark(ros::NodeHandle& pnh, const std::string& deployment)
+{
+  std::string dataset_name, output, rapid_directory;
+  int repetitions;
+  std::vector<std::string> cpu_nodes;
+  pnh.param<std::string>("dataset_name", dataset_name, "unnamed");
+  pnh.param<std::string>("output", output, "pipeline_benchmark.json");
+  pnh.param<std::string>("rapid_output_directory", rapid_directory, "");
+  pnh.param("repetitions", repetitions, 3);
+  pnh.param(CPU_NODES_PARAM, cpu_nodes, DEFAULT_CPU_NODES);
+
+  XmlRpc::XmlRpcValue parts;
+  std::vector<DatasetPart> dataset;
+  if (!pnh.getParam("parts", parts) ||
+      !loadDataset(parts, ros::package::getPath("godel_pipeline_benchmark") + "/data", dataset) || dataset.empty())
+  {
+    ROS_ERROR("No benchmark dataset was loaded into '%s/parts'", pnh.getNamespace().c_str());
+    return 1;
+  }
+
+  // The blend and scan path planning plugins call the process path generator node
+  if (!ros::service::waitForService(PATH_GENERATION_SERVICE, ros::Duration(SERVICE_WAIT_TIME)))
+  {
+    ROS_ERROR_STREAM("The '" << PATH_GENERATION_SERVICE << "' service is not available");
+    return 1;
+  }
+
+  PipelineReport report(dataset_name, repetitions);
+  report.setDeployment(deployment);
+  StandInFtp ftp(rapid_directory);
+  StandInExecutor executor(ftp);
+  PipelineBenchmark benchmark(pnh, report, executor);
+
+  const std::map<std::string, int> pids = nodePids(cpu_nodes);
+  const auto wall_start = std::chrono::steady_clock::now();
+  const double cpu_start = processCpuSeconds();
+  const double other_cpu_start = otherProcessesCpuSeconds(pids);
+
+  // Plan quality doesn't change between repetitions, so it is only recorded once
+  for (int rep = 0; rep < repetitions && ros::ok(); ++rep)
+  {
+    for (const auto& part : dataset)
+    {
+      ROS_INFO_STREAM("Repetition " << rep + 1 << "/" << repetitions << ": " << part.name);
+      PartMetrics metrics = PartMetrics();
+      benchmark.run(part, rep == 0 ? &metrics : NULL);
+      if (rep == 0)
+        report.addPart(metrics);
+    }
+  }
+
+  CpuUsage cpu;
+  cpu.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  cpu.benchmark_s = processCpuSeconds() - cpu_start;
+  cpu.other_processes_s = otherProcessesCpuSeconds(pids) - other_cpu_start;
+  report.setCpuUsage(cpu);
+  report.setPeakRssKb(peakRssKb());
+
+  std::ofstream fp(output);
+  if (!fp)
+  {
+    ROS_ERROR_STREAM("Unable to write benchmark report to " << output);
+    return 1;
+  }
+  report.writeJson(fp);
+
+  for (const auto& stage : PIPELINE_STAGES)
+  {
+    const LatencySummary s = summarize(report.samples(stage));
+    ROS_INFO("%-16s n=%-4zu p50 %9.2f ms  p90 %9.2f ms  p99 %9.2f ms", stage.c_str(), s.samples, s.p50_ms,
+             s.p90_ms, s.p99_ms);
+  }
+  ROS_INFO("Deployment '%s': %.2f s wall, %.2f s CPU in the benchmark and %.2f s in %zu other processes",
+           deployment.c_str(), cpu.wall_s, cpu.benchmark_s, cpu.other_processes_s, pids.size());
+  ROS_INFO_STREAM("Peak memory " << peakRssKb() / 1024 << " MB; report written to " << output);
+  return 0;
+}
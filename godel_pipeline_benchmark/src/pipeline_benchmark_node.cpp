@@ -0,0 +1,14 @@
+/*
+ * Offline end-to-end benchmark of the blending pipeline, with the geometry services as nodes of
+ * their own. See pipeline_benchmark.cpp and the package README.
+ */
+
+#include <godel_pipeline_benchmark/pipeline_benchmark.h>
+#include <ros/ros.h>
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "pipeline_benchmark");
+  ros::NodeHandle pnh("~");
+  return godel_pipeline_benchmark::runPipelineBenchmark(pnh, "processes");
+}
@@ -0,0 +1,45 @@
+/*
+ * The pipeline benchmark as a nodelet, for the deployment in which the geometry services are
+ * nodelets in the same manager. The path planning plugins it loads then call the process path
+ * generator, and that the polygon offset service, without serializing the surfaces' boundaries
+ * and poses. Like the node, it reads its parameters from the private namespace, which is the
+ * manager's (see launch/pipeline_benchmark.launch). The manager is shut down when the report is
+ * written.
+ */
+
+#include <godel_pipeline_benchmark/pipeline_benchmark.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <ros/ros.h>
+
+#include <thread>
+
+namespace godel_pipeline_benchmark
+{
+
+class PipelineBenchmarkNodelet : public nodelet::Nodelet
+{
+public:
+  ~PipelineBenchmarkNodelet()
+  {
+    if (worker_.joinable())
+      worker_.join();
+  }
+
+private:
+  virtual void onInit()
+  {
+    // The benchmark waits for the other nodelets' services, so it can't run on the loading thread
+    worker_ = std::thread([this]() {
+      ros::NodeHandle pnh("~");
+      runPipelineBenchmark(pnh, "nodelets");
+      ros::requestShutdown();
+    });
+  }
+
+  std::thread worker_;
+};
+
+} // namespace godel_pipeline_benchmark
+
+PLUGINLIB_EXPORT_CLASS(godel_pipeline_benchmark::PipelineBenchmarkNodelet, nodelet::Nodelet)
@@ -0,0 +1,162 @@
+#include <godel_pipeline_benchmark/pipeline_report.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace
+{
+
+double nearestRank(const std::vector<double>& sorted, double percentile)
+{
+  const std::size_t rank = static_cast<std::size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+  return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
+std::string quoted(const std::string& s)
+{
+  std::string out = "\"";
+  for (char c : s)
+  {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    if (static_cast<unsigned char>(c) < 0x20)
+      out += ' ';
+    else
+      out += c;
+  }
+  return out + "\"";
+}
+
+double sumOf(const std::vector<godel_pipeline_benchmark::PlanMetrics>& plans,
+             double godel_pipeline_benchmark::PlanMetrics::*field)
+{
+  double sum = 0.0;
+  for (const auto& plan : plans)
+    sum += plan.*field;
+  return sum;
+}
+
+} // end anon namespace
+
+godel_pipeline_benchmark::LatencySummary godel_pipeline_benchmark::summarize(std::vector<double> samples_ms)
+{
+  LatencySummary summary = {samples_ms.size(), 0.0, 0.0, 0.0, 0.0, 0.0};
+  if (samples_ms.empty())
+    return summary;
+
+  std::sort(samples_ms.begin(), samples_ms.end());
+  summary.mean_ms = std::accumulate(samples_ms.begin(), samples_ms.end(), 0.0) / samples_ms.size();
+  summary.p50_ms = nearestRank(samples_ms, 50.0);
+  summary.p90_ms = nearestRank(samples_ms, 90.0);
+  summary.p99_ms = nearestRank(samples_ms, 99.0);
+  summary.max_ms = samples_ms.back();
+  return summary;
+}
+
+const std::vector<double>& godel_pipeline_benchmark::PipelineReport::samples(const std::string& stage) const
+{
+  const static std::vector<double> empty;
+  auto it = samples_.find(stage);
+  return it == samples_.end() ? empty : it->second;
+}
+
+void godel_pipeline_benchmark::PipelineReport::writeJson(std::ostream& os) const
+{
+  os << std::setprecision(6) << std::fixed;
+  os << "{\n";
+  os << "  \"schema\": \"godel_pipeline_benchmark\",\n";
+  os << "  \"schema_version\": " << REPORT_SCHEMA_VERSION << ",\n";
+  os << "  \"dataset\": " << quoted(dataset_) << ",\n";
+  os << "  \"deployment\": " << quoted(deployment_) << ",\n";
+  os << "  \"repetitions\": " << repetitions_ << ",\n";
+
+  os << "  \"stages\": {\n";
+  for (std::size_t i = 0; i < PIPELINE_STAGES.size(); ++i)
+  {
+    const LatencySummary s = summarize(samples(PIPELINE_STAGES[i]));
+    os << "    " << quoted(PIPELINE_STAGES[i]) << ": {\"samples\": " << s.samples << ", \"mean_ms\": " << s.mean_ms
+       << ", \"p50_ms\": " << s.p50_ms << ", \"p90_ms\": " << s.p90_ms << ", \"p99_ms\": " << s.p99_ms
+       << ", \"max_ms\": " << s.max_ms << "}" << (i + 1 < PIPELINE_STAGES.size() ? "," : "") << "\n";
+  }
+  os << "  },\n";
+
+  os << "  \"memory\": {\"peak_rss_kb\": " << peak_rss_kb_ << "},\n";
+
+  const double cpu_total = cpu_.benchmark_s + cpu_.other_processes_s;
+  os << "  \"cpu\": {\"wall_s\": " << cpu_.wall_s << ", \"benchmark_process_s\": " << cpu_.benchmark_s
+     << ", \"other_processes_s\": " << cpu_.other_processes_s << ", \"total_s\": " << cpu_total
+     << ", \"utilization\": " << (cpu_.wall_s > 0.0 ? cpu_total / cpu_.wall_s : 0.0) << "},\n";
+
+  std::size_t total_plans = 0;
+  double total_length = 0.0, total_time = 0.0;
+  os << "  \"parts\": [\n";
+  for (std::size_t i = 0; i < parts_.size(); ++i)
+  {
+    const PartMetrics& part = parts_[i];
+    const double length = sumOf(part.plans, &PlanMetrics::path_length_m);
+    const double time = sumOf(part.plans, &PlanMetrics::cycle_time_s);
+    total_plans += part.plans.size();
+    total_length += length;
+    total_time += time;
+
+    os << "    {\"name\": " << quoted(part.name) << ", \"points\": " << part.points
+       << ", \"segments\": " << part.segments << ", \"surfaces\": " << part.surfaces << ", \"path_length_m\": " << length
+       << ", \"cycle_time_s\": " << time << ", \"plans\": [";
+    for (std::size_t j = 0; j < part.plans.size(); ++j)
+    {
+      const PlanMetrics& plan = part.plans[j];
+      os << (j == 0 ? "\n" : ",\n") << "      {\"name\": " << quoted(plan.name) << ", \"type\": " << quoted(plan.type)
+         << ", \"points\": " << plan.points << ", \"path_length_m\": " << plan.path_length_m
+         << ", \"cycle_time_s\": " << plan.cycle_time_s << ", \"rapid_bytes\": " << plan.rapid_bytes << "}";
+    }
+    os << (part.plans.empty() ? "" : "\n    ") << "]}" << (i + 1 < parts_.size() ? "," : "") << "\n";
+  }
+  os << "  ],\n";
+
+  os << "  \"totals\": {\"parts\": " << parts_.size() << ", \"plans\": " << total_plans
+     << ", \"path_length_m\": " << total_length << ", \"cycle_time_s\": " << total_time << "}\n";
+  os << "}\n";
+}
+
+long godel_pipeline_benchmark::peakRssKb()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  return usage.ru_maxrss; // kilobytes on Linux
+}
+
+double godel_pipeline_benchmark::processCpuSeconds()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0.0;
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+double godel_pipeline_benchmark::processCpuSeconds(int pid)
+{
+  std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+  const std::string line((std::istreambuf_iterator<char>(stat)), std::istreambuf_iterator<char>());
+  // The command name in parentheses may hold spaces; utime and stime are the 12th and 13th fields after it
+  const std::size_t end_of_name = line.rfind(')');
+  if (end_of_name == std::string::npos)
+    return -1.0;
+
+  std::istringstream fields(line.substr(end_of_name + 1));
+  std::string skipped;
+  for (int i = 0; i < 11; ++i)
+    fields >> skipped;
+  unsigned long utime, stime;
+  if (!(fields >> utime >> stime))
+    return -1.0;
+  return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+}
@@ -0,0 +1,182 @@
+#include <godel_pipeline_benchmark/reference_dataset.h>
+
+#include <pcl/io/pcd_io.h>
+#include <ros/console.h>
+
+#include <random>
+
+const static double DEFAULT_SPACING = 0.0015;
+const static double DEFAULT_NOISE = 0.0003;
+
+namespace
+{
+
+double toDouble(XmlRpc::XmlRpcValue& value)
+{
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+    return static_cast<int>(value);
+  return static_cast<double>(value);
+}
+
+bool isNumber(XmlRpc::XmlRpcValue& value)
+{
+  return value.getType() == XmlRpc::XmlRpcValue::TypeInt || value.getType() == XmlRpc::XmlRpcValue::TypeDouble;
+}
+
+bool insideOtherBox(const std::vector<godel_pipeline_benchmark::Box>& boxes, std::size_t self, double x, double y,
+                    double z)
+{
+  const double eps = 1e-6;
+  for (std::size_t i = 0; i < boxes.size(); ++i)
+  {
+    const auto& b = boxes[i];
+    if (i != self && x > b.x - eps && x < b.x + b.size_x + eps && y > b.y - eps && y < b.y + b.size_y + eps &&
+        z > b.z - eps && z < b.z + b.size_z + eps)
+      return true;
+  }
+  return false;
+}
+
+class BoxSampler
+{
+public:
+  BoxSampler(const godel_pipeline_benchmark::DatasetPart& part, pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+    : part_(part), cloud_(cloud), rng_(part.seed), noise_(0.0, part.noise)
+  {
+  }
+
+  void sample()
+  {
+    for (std::size_t i = 0; i < part_.boxes.size(); ++i)
+    {
+      const auto& b = part_.boxes[i];
+      const double h = part_.spacing;
+      const double top = b.z + b.size_z;
+
+      for (double x = b.x; x <= b.x + b.size_x; x += h)
+        for (double y = b.y; y <= b.y + b.size_y; y += h)
+          add(i, x, y, top);
+
+      for (double z = b.z; z < top; z += h)
+      {
+        for (double x = b.x; x <= b.x + b.size_x; x += h)
+        {
+          add(i, x, b.y, z);
+          add(i, x, b.y + b.size_y, z);
+        }
+        for (double y = b.y + h; y < b.y + b.size_y; y += h)
+        {
+          add(i, b.x, y, z);
+          add(i, b.x + b.size_x, y, z);
+        }
+      }
+    }
+  }
+
+private:
+  void add(std::size_t box, double x, double y, double z)
+  {
+    if (insideOtherBox(part_.boxes, box, x, y, z))
+      return;
+
+    pcl::PointXYZRGB p;
+    p.x = x + noise_(rng_);
+    p.y = y + noise_(rng_);
+    p.z = z + noise_(rng_);
+    p.r = p.g = p.b = 255;
+    cloud_.push_back(p);
+  }
+
+  const godel_pipeline_benchmark::DatasetPart& part_;
+  pcl::PointCloud<pcl::PointXYZRGB>& cloud_;
+  std::mt19937 rng_;
+  std::normal_distribution<double> noise_;
+};
+
+} // end anon namespace
+
+bool godel_pipeline_benchmark::loadDataset(XmlRpc::XmlRpcValue& parts, const std::string& data_directory,
+                                           std::vector<DatasetPart>& dataset)
+{
+  if (parts.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    ROS_ERROR("The dataset's 'parts' must be a list");
+    return false;
+  }
+
+  for (int i = 0; i < parts.size(); ++i)
+  {
+    XmlRpc::XmlRpcValue& entry = parts[i];
+    DatasetPart part;
+    part.spacing = DEFAULT_SPACING;
+    part.noise = DEFAULT_NOISE;
+    part.seed = i;
+
+    if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("name"))
+    {
+      ROS_ERROR_STREAM("Dataset part " << i << " has no name");
+      return false;
+    }
+    part.name = static_cast<std::string>(entry["name"]);
+
+    if (entry.hasMember("pcd"))
+    {
+      part.pcd = static_cast<std::string>(entry["pcd"]);
+      if (!part.pcd.empty() && part.pcd[0] != '/')
+        part.pcd = data_directory + "/" + part.pcd;
+      dataset.push_back(part);
+      continue;
+    }
+
+    if (entry.hasMember("spacing"))
+      part.spacing = toDouble(entry["spacing"]);
+    if (entry.hasMember("noise"))
+      part.noise = toDouble(entry["noise"]);
+    if (entry.hasMember("seed"))
+      part.seed = static_cast<int>(entry["seed"]);
+
+    if (!entry.hasMember("boxes") || entry["boxes"].getType() != XmlRpc::XmlRpcValue::TypeArray ||
+        part.spacing <= 0.0)
+    {
+      ROS_ERROR_STREAM("Dataset part '" << part.name << "' needs either a 'pcd' file or a list of 'boxes'");
+      return false;
+    }
+
+    XmlRpc::XmlRpcValue& boxes = entry["boxes"];
+    for (int j = 0; j < boxes.size(); ++j)
+    {
+      XmlRpc::XmlRpcValue& b = boxes[j];
+      if (b.getType() != XmlRpc::XmlRpcValue::TypeArray || b.size() != 6 || !isNumber(b[0]) || !isNumber(b[1]) ||
+          !isNumber(b[2]) || !isNumber(b[3]) || !isNumber(b[4]) || !isNumber(b[5]))
+      {
+        ROS_ERROR_STREAM("Box " << j << " of dataset part '" << part.name
+                                << "' must be [x, y, z, size_x, size_y, size_z]");
+        return false;
+      }
+      part.boxes.push_back(Box{toDouble(b[0]), toDouble(b[1]), toDouble(b[2]),
+                               toDouble(b[3]), toDouble(b[4]), toDouble(b[5])});
+    }
+    dataset.push_back(part);
+  }
+  return true;
+}
+
+bool godel_pipeline_benchmark::loadPartCloud(const DatasetPart& part, pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+{
+  cloud.clear();
+  if (!part.pcd.empty())
+  {
+    if (pcl::io::loadPCDFile(part.pcd, cloud) < 0)
+    {
+      ROS_ERROR_STREAM("Unable to load dataset cloud " << part.pcd);
+      return false;
+    }
+    return true;
+  }
+
+  BoxSampler(part, cloud).sample();
+  cloud.width = cloud.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
+  return true;
+}
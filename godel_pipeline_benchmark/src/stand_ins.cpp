@@ -0,0 +1,229 @@
+#include <godel_pipeline_benchmark/stand_ins.h>
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <ros/console.h>
+#include <rapid_generator/rapid_emitter.h>
+#include <sstream>
+
+// Guards the timing against unset (zero) speed parameters
+const static double MIN_SPEED = 0.001; // m/s
+
+// Mirrors the ABB blend process service
+const static double RAPID_SPINDLE_SPEED = 1.0;
+const static double RAPID_TCP_SPEED = 200;
+const static std::string RAPID_OUTPUT_NAME = "do_PIO_8";
+
+namespace
+{
+
+std::vector<double> toPositions(const geometry_msgs::Pose& pose, double lift)
+{
+  const Eigen::Quaterniond q(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+  const Eigen::Vector3d ypr = q.toRotationMatrix().eulerAngles(2, 1, 0);
+  return {pose.position.x, pose.position.y, pose.position.z + lift, ypr(2), ypr(1), ypr(0)};
+}
+
+double distance(const std::vector<double>& a, const std::vector<double>& b)
+{
+  return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+/**
+ * Appends points to a trajectory, timing each move by its Cartesian length and speed
+ */
+class TrajectoryBuilder
+{
+public:
+  explicit TrajectoryBuilder(trajectory_msgs::JointTrajectory& traj) : traj_(traj), t_(0.0)
+  {
+    traj_.points.clear();
+    traj_.joint_names = {"x", "y", "z", "roll", "pitch", "yaw"};
+  }
+
+  void moveTo(const std::vector<double>& positions, double speed)
+  {
+    if (!traj_.points.empty())
+      t_ += distance(traj_.points.back().positions, positions) / std::max(speed, MIN_SPEED);
+
+    trajectory_msgs::JointTrajectoryPoint pt;
+    pt.positions = positions;
+    pt.time_from_start = ros::Duration(t_);
+    traj_.points.push_back(pt);
+  }
+
+private:
+  trajectory_msgs::JointTrajectory& traj_;
+  double t_;
+};
+
+struct MoveSpeeds
+{
+  double approach;
+  double process;
+  double retract;
+  double traverse;
+  double clearance; // height above the surface for approach and traverse moves
+};
+
+bool planPath(const godel_msgs::ProcessPath& path, const MoveSpeeds& speeds, godel_msgs::ProcessPlan& plan)
+{
+  const geometry_msgs::PoseArray* first = NULL;
+  const geometry_msgs::PoseArray* last = NULL;
+  for (const auto& segment : path.segments)
+  {
+    if (segment.poses.empty())
+      continue;
+    if (!first)
+      first = &segment;
+    last = &segment;
+  }
+  if (!first)
+    return false;
+
+  TrajectoryBuilder approach(plan.trajectory_approach);
+  approach.moveTo(toPositions(first->poses.front(), speeds.clearance), speeds.traverse);
+  approach.moveTo(toPositions(first->poses.front(), 0.0), speeds.approach);
+
+  TrajectoryBuilder process(plan.trajectory_process);
+  const geometry_msgs::Pose* previous = NULL;
+  for (const auto& segment : path.segments)
+  {
+    if (segment.poses.empty())
+      continue;
+
+    if (previous)
+    {
+      process.moveTo(toPositions(*previous, speeds.clearance), speeds.retract);
+      process.moveTo(toPositions(segment.poses.front(), speeds.clearance), speeds.traverse);
+    }
+    // Down onto the surface, then along it
+    for (std::size_t i = 0; i < segment.poses.size(); ++i)
+      process.moveTo(toPositions(segment.poses[i], 0.0), i == 0 ? speeds.approach : speeds.process);
+    previous = &segment.poses.back();
+  }
+
+  TrajectoryBuilder depart(plan.trajectory_depart);
+  depart.moveTo(toPositions(last->poses.back(), 0.0), speeds.retract);
+  depart.moveTo(toPositions(last->poses.back(), speeds.clearance), speeds.retract);
+  return true;
+}
+
+std::vector<rapid_emitter::TrajectoryPt> toRapidTrajectory(const godel_msgs::ProcessPlan& plan)
+{
+  std::vector<rapid_emitter::TrajectoryPt> pts;
+  const trajectory_msgs::JointTrajectory* parts[] = {&plan.trajectory_approach, &plan.trajectory_process,
+                                                      &plan.trajectory_depart};
+  for (const auto* traj : parts)
+  {
+    for (std::size_t i = 0; i < traj->points.size(); ++i)
+    {
+      std::vector<double> values = traj->points[i].positions;
+      for (std::size_t j = 3; j < values.size(); ++j)
+        values[j] *= 180.0 / M_PI;
+
+      const double duration =
+          i > 0 ? (traj->points[i].time_from_start - traj->points[i - 1].time_from_start).toSec() : 0.0;
+      // The stand-in 'joints' are the tool pose, so the zones are sized from the first three
+      const std::vector<double> tcp_position = {values[0] * 1000.0, values[1] * 1000.0, values[2] * 1000.0};
+      pts.push_back(rapid_emitter::TrajectoryPt(values, duration, tcp_position));
+    }
+  }
+  return pts;
+}
+
+double trajectoryDuration(const trajectory_msgs::JointTrajectory& traj)
+{
+  return traj.points.empty() ? 0.0 : traj.points.back().time_from_start.toSec();
+}
+
+} // end anon namespace
+
+bool godel_pipeline_benchmark::StandInProcessPlanner::planBlend(const godel_msgs::ProcessPath& path,
+                                                               const godel_msgs::BlendingPlanParameters& params,
+                                                               godel_msgs::ProcessPlan& plan) const
+{
+  MoveSpeeds speeds;
+  speeds.approach = params.approach_spd;
+  speeds.process = params.blending_spd;
+  speeds.retract = params.retract_spd;
+  speeds.traverse = params.traverse_spd;
+  speeds.clearance = params.safe_traverse_height;
+
+  plan.type = godel_msgs::ProcessPlan::BLEND_TYPE;
+  return planPath(path, speeds, plan);
+}
+
+bool godel_pipeline_benchmark::StandInProcessPlanner::planScan(const godel_msgs::ProcessPath& path,
+                                                              const godel_msgs::ScanPlanParameters& params,
+                                                              godel_msgs::ProcessPlan& plan) const
+{
+  MoveSpeeds speeds;
+  speeds.approach = speeds.process = speeds.retract = speeds.traverse = params.traverse_spd;
+  speeds.clearance = params.approach_distance;
+
+  plan.type = godel_msgs::ProcessPlan::SCAN_TYPE;
+  return planPath(path, speeds, plan);
+}
+
+bool godel_pipeline_benchmark::StandInFtp::upload(const std::string& filename, const std::string& contents)
+{
+  if (!directory_.empty())
+  {
+    std::ofstream fp(directory_ + "/" + filename);
+    if (!fp || !(fp << contents))
+    {
+      ROS_ERROR_STREAM("Unable to write '" << filename << "' to " << directory_);
+      return false;
+    }
+  }
+
+  bytes_uploaded_ += contents.size();
+  files_uploaded_++;
+  return true;
+}
+
+bool godel_pipeline_benchmark::StandInExecutor::execute(const std::string& name,
+                                                        const godel_msgs::ProcessPlan& plan, std::size_t& bytes)
+{
+  const std::vector<rapid_emitter::TrajectoryPt> pts = toRapidTrajectory(plan);
+
+  rapid_emitter::ProcessParams params;
+  params.spindle_speed = RAPID_SPINDLE_SPEED;
+  params.tcp_speed = RAPID_TCP_SPEED;
+  params.force = 0.0;
+  params.wolf_mode = false;
+  params.slide_force = 0.0;
+  params.output_name = RAPID_OUTPUT_NAME;
+
+  const std::size_t start_index = plan.trajectory_approach.points.size();
+  const std::size_t stop_index = start_index + plan.trajectory_process.points.size();
+
+  std::ostringstream module;
+  if (!rapid_emitter::emitRapidFile(module, pts, start_index, stop_index, params))
+  {
+    ROS_ERROR_STREAM("Unable to write RAPID module for " << name);
+    return false;
+  }
+
+  const std::string contents = module.str();
+  bytes = contents.size();
+  return ftp_.upload(name + ".mod", contents);
+}
+
+double godel_pipeline_benchmark::planDuration(const godel_msgs::ProcessPlan& plan)
+{
+  return trajectoryDuration(plan.trajectory_approach) + trajectoryDuration(plan.trajectory_process) +
+         trajectoryDuration(plan.trajectory_depart);
+}
+
+double godel_pipeline_benchmark::processPathLength(const godel_msgs::ProcessPlan& plan)
+{
+  double length = 0.0;
+  const auto& points = plan.trajectory_process.points;
+  for (std::size_t i = 1; i < points.size(); ++i)
+    length += distance(points[i - 1].positions, points[i].positions);
+  return length;
+}
@@ -0,0 +1,240 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <godel_pipeline_benchmark/parameter_tuning.h>
+#include <godel_param_helpers/godel_param_helpers.h>
+#include <synthetic/synthetic_workload.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <unistd.h>
+
+using namespace godel_pipeline_benchmark;
+namespace synthetic = godel_surface_detection::synthetic;
+
+namespace
+{
+
+// A 30cm x 20cm plate with a block on top, raised clear of the table filter of detection
+TuningPart makeSteppedPlate()
+{
+  synthetic::PartDescription description;
+  description.primitives.push_back(synthetic::box(0.0, 0.0, 0.075, 0.3, 0.2, 0.05));
+  description.primitives.push_back(synthetic::box(0.05, 0.0, 0.125, 0.1, 0.1, 0.05));
+  description.target_points = 200000;
+  description.noise = 0.0002;
+
+  TuningPart part;
+  part.name = "stepped_plate";
+  part.cloud.reset(new LabelledCloud());
+  synthetic::generatePart(description, *part.cloud);
+  return part;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr toRGB(const LabelledCloud& cloud)
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr rgb(new pcl::PointCloud<pcl::PointXYZRGB>());
+  for (const auto& p : cloud.points)
+  {
+    pcl::PointXYZRGB q;
+    q.x = p.x;
+    q.y = p.y;
+    q.z = p.z;
+    rgb->points.push_back(q);
+  }
+  return rgb;
+}
+
+ParameterSet defaultParameters()
+{
+  ParameterSet set;
+  set.detection.voxel_leafsize = 0.0015;
+  set.detection.normal_radius = 0.025;
+  set.detection.rg_min_cluster_size = 2500;
+  set.detection.rg_max_cluster_size = 50000;
+  set.detection.rg_neightbors = 30;
+  set.detection.rg_smoothness_threshold = 0.035;
+  set.detection.rg_curvature_threshold = 1.0;
+  set.path_planning.scan_width = 0.01;
+  set.path_planning.overlap = 0.0;
+  set.blend.approach_spd = 0.005;
+  set.blend.blending_spd = 0.3;
+  set.blend.retract_spd = 0.02;
+  set.blend.traverse_spd = 0.05;
+  set.blend.safe_traverse_height = 0.05;
+  set.scan.approach_distance = 0.15;
+  set.scan.traverse_spd = 0.05;
+  return set;
+}
+
+} // end anon namespace
+
+TEST(ParameterTuning, parametersAreSetByName)
+{
+  ParameterSet set;
+  EXPECT_TRUE(setParameter(set, "detection.rg_smoothness_threshold", 0.05));
+  EXPECT_TRUE(setParameter(set, "detection.rg_min_cluster_size", 99.6));
+  EXPECT_FALSE(setParameter(set, "detection.no_such_field", 1.0));
+
+  EXPECT_DOUBLE_EQ(0.05, set.detection.rg_smoothness_threshold);
+  EXPECT_EQ(100, set.detection.rg_min_cluster_size);
+
+  double value;
+  ASSERT_TRUE(getParameter(set, "detection.rg_min_cluster_size", value));
+  EXPECT_EQ(100.0, value);
+  for (const auto& name : tunableParameters())
+    EXPECT_TRUE(getParameter(set, name, value)) << name;
+}
+
+TEST(ParameterTuning, paretoRanksPeelFronts)
+{
+  // (1, 3), (2, 2) and (3, 1) trade off; (3, 3) is dominated by (2, 2) and (4, 4) by everything
+  const std::vector<std::vector<double>> points = {{3, 3}, {1, 3}, {2, 2}, {4, 4}, {3, 1}, {2, 2}};
+  const std::vector<std::size_t> ranks = paretoRanks(points);
+  EXPECT_EQ(std::vector<std::size_t>({1, 0, 0, 2, 0, 0}), ranks);
+}
+
+TEST(ParameterTuning, segmentationScoreMatchesSurfacesOneToOne)
+{
+  const TuningPart part = makeSteppedPlate();
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr process = toRGB(*part.cloud);
+
+  // One segment per ground truth surface is a perfect segmentation
+  std::map<uint32_t, pcl::PointCloud<pcl::PointXYZRGB>::Ptr> by_label;
+  for (std::size_t i = 0; i < part.cloud->size(); ++i)
+  {
+    auto& segment = by_label[(*part.cloud)[i].label];
+    if (!segment)
+      segment.reset(new pcl::PointCloud<pcl::PointXYZRGB>());
+    segment->points.push_back(process->points[i]);
+  }
+  std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> perfect;
+  std::size_t largest = 0;
+  for (const auto& s : by_label)
+  {
+    perfect.push_back(s.second);
+    largest = std::max(largest, s.second->size());
+  }
+  EXPECT_NEAR(1.0, segmentationScore(*part.cloud, *process, perfect, 0.005), 1e-9);
+
+  // Everything merged into one segment: only the largest surface is matched, with an IoU of its
+  // share of the part
+  const double share = static_cast<double>(largest) / process->size();
+  EXPECT_NEAR(share * share, segmentationScore(*part.cloud, *process, {process}, 0.005), 1e-9);
+
+  // Nothing found
+  EXPECT_EQ(0.0, segmentationScore(*part.cloud, *process, {}, 0.005));
+}
+
+TEST(ParameterTuning, successiveHalvingPrunesAndKeepsTheOptimum)
+{
+  // Segmentation error is lowest at a smoothness of 0.05 and nothing else changes, so the best
+  // sampled smoothness must survive every rung
+  std::vector<TuningPart> dataset(9);
+  std::vector<ParameterRange> ranges = {{"detection.rg_smoothness_threshold", 0.01, 0.1, false, false},
+                                        {"detection.rg_neightbors", 10, 100, true, true}};
+  std::atomic<int> evaluations(0);
+  Evaluator evaluator = [&](const ParameterSet& set, const TuningPart&) {
+    ++evaluations;
+    Score s;
+    s.segmentation_error = std::abs(set.detection.rg_smoothness_threshold - 0.05);
+    s.runtime_s = 0.001;
+    return s;
+  };
+
+  ParameterSet base = defaultParameters();
+  TuningOptions options;
+  options.candidates = 27;
+  options.eta = 3.0;
+  options.threads = 4;
+  const std::vector<Candidate> candidates = successiveHalving(base, ranges, dataset, options, evaluator);
+
+  // 27 sets on 1 part, the best 9 on 2 more, the best 3 on the last 6
+  ASSERT_EQ(27u, candidates.size());
+  EXPECT_EQ(27 + 9 * 2 + 3 * 6, evaluations.load());
+  EXPECT_EQ(std::vector<double>({0.035, 30.0}), candidates[0].values);
+
+  double best_error = 1.0;
+  std::size_t finalists = 0;
+  for (const auto& c : candidates)
+  {
+    ASSERT_EQ(2u, c.values.size());
+    EXPECT_GE(c.values[0], 0.01);
+    EXPECT_LE(c.values[0], 0.1);
+    EXPECT_EQ(std::round(c.values[1]), c.values[1]);
+    if (c.part_scores.size() == dataset.size())
+    {
+      ++finalists;
+      best_error = std::min(best_error, c.score.segmentation_error);
+    }
+  }
+  EXPECT_EQ(3u, finalists);
+  // A Latin hypercube of 26 samples puts one within 0.09 / 26 of any smoothness
+  EXPECT_LT(best_error, 0.0035);
+}
+
+TEST(ParameterTuning, detectionOfASyntheticPartIsScored)
+{
+  const TuningPart part = makeSteppedPlate();
+  const ParameterSet good = defaultParameters();
+  const Score score = evaluateParameterSet(good, part);
+
+  EXPECT_GT(score.runtime_s, 0.0);
+  EXPECT_LT(score.segmentation_error, 0.25);
+  EXPECT_LT(score.coverage_error, 0.05);
+  EXPECT_GT(score.cycle_time_s, 0.0);
+
+  // Clusters bigger than any surface: nothing is found and nothing is scanned
+  ParameterSet bad = good;
+  bad.detection.rg_min_cluster_size = 1000000;
+  const Score missed = evaluateParameterSet(bad, part);
+  EXPECT_EQ(1.0, missed.segmentation_error);
+  EXPECT_EQ(1.0, missed.coverage_error);
+
+  // Scan stripes that overlap by half take about twice as long over the same surfaces
+  ParameterSet overlapped = good;
+  overlapped.path_planning.overlap = good.path_planning.scan_width / 2.0;
+  const Score slower = evaluateParameterSet(overlapped, part);
+  EXPECT_GT(slower.cycle_time_s, score.cycle_time_s);
+  EXPECT_LE(slower.coverage_error, score.coverage_error);
+}
+
+TEST(ParameterTuning, exportedParametersLoadBack)
+{
+  ParameterSet set = defaultParameters();
+  set.detection.rg_smoothness_threshold = 0.06;
+  set.path_planning.overlap = 0.002;
+  const std::string directory = "/tmp/test_parameter_tuning_" + std::to_string(::getpid());
+  ASSERT_TRUE(exportParameterSet(set, directory + "/front_0"));
+
+  godel_msgs::SurfaceDetectionParameters detection;
+  godel_msgs::PathPlanningParameters path_planning;
+  ASSERT_TRUE(godel_param_helpers::fromFile(directory + "/front_0/godel_surface_detection_parameters.msg", detection));
+  ASSERT_TRUE(godel_param_helpers::fromFile(directory + "/front_0/godel_path_planning_parameters.msg", path_planning));
+  EXPECT_EQ(0.06, detection.rg_smoothness_threshold);
+  EXPECT_EQ(0.002, path_planning.overlap);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,237 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <godel_pipeline_benchmark/pipeline_report.h>
+#include <godel_pipeline_benchmark/reference_dataset.h>
+#include <godel_pipeline_benchmark/stand_ins.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <sstream>
+#include <unistd.h>
+
+using namespace godel_pipeline_benchmark;
+
+namespace
+{
+
+geometry_msgs::PoseArray makeLine(double x0, double x1, double y, int n)
+{
+  geometry_msgs::PoseArray line;
+  for (int i = 0; i < n; ++i)
+  {
+    geometry_msgs::Pose p;
+    p.position.x = x0 + (x1 - x0) * i / (n - 1);
+    p.position.y = y;
+    p.orientation.w = 1.0;
+    line.poses.push_back(p);
+  }
+  return line;
+}
+
+godel_msgs::BlendingPlanParameters blendParams()
+{
+  godel_msgs::BlendingPlanParameters params;
+  params.approach_spd = 0.01;
+  params.blending_spd = 0.1;
+  params.retract_spd = 0.02;
+  params.traverse_spd = 0.2;
+  params.safe_traverse_height = 0.05;
+  return params;
+}
+
+} // end anon namespace
+
+TEST(StandInPlanner, timesEachMoveByItsSpeed)
+{
+  godel_msgs::ProcessPath path;
+  path.segments.push_back(makeLine(0.0, 0.3, 0.0, 31));
+
+  godel_msgs::ProcessPlan plan;
+  ASSERT_TRUE(StandInProcessPlanner().planBlend(path, blendParams(), plan));
+  EXPECT_EQ(godel_msgs::ProcessPlan::BLEND_TYPE, plan.type);
+
+  // 5cm down at 1cm/s, 30cm along the surface at 10cm/s, 5cm up at 2cm/s
+  EXPECT_NEAR(5.0, plan.trajectory_approach.points.back().time_from_start.toSec(), 1e-6);
+  EXPECT_NEAR(3.0, plan.trajectory_process.points.back().time_from_start.toSec(), 1e-6);
+  EXPECT_NEAR(2.5, plan.trajectory_depart.points.back().time_from_start.toSec(), 1e-6);
+  EXPECT_NEAR(10.5, planDuration(plan), 1e-6);
+  EXPECT_NEAR(0.3, processPathLength(plan), 1e-9);
+  EXPECT_EQ(31u, plan.trajectory_process.points.size());
+}
+
+TEST(StandInPlanner, retractsAndTraversesBetweenSegments)
+{
+  godel_msgs::ProcessPath path;
+  path.segments.push_back(makeLine(0.0, 0.1, 0.0, 11));
+  path.segments.push_back(geometry_msgs::PoseArray()); // empty segments are skipped
+  path.segments.push_back(makeLine(0.1, 0.0, 0.02, 11));
+
+  godel_msgs::ProcessPlan plan;
+  ASSERT_TRUE(StandInProcessPlanner().planBlend(path, blendParams(), plan));
+
+  // 2 segments of 10cm, plus up 5cm, across 2cm and down 5cm in between
+  EXPECT_NEAR(0.32, processPathLength(plan), 1e-9);
+  EXPECT_EQ(24u, plan.trajectory_process.points.size());
+  // 1s + 2.5s retract + 0.1s traverse + 5s approach + 1s
+  EXPECT_NEAR(9.6, plan.trajectory_process.points.back().time_from_start.toSec(), 1e-6);
+}
+
+TEST(StandInPlanner, rejectsEmptyPaths)
+{
+  godel_msgs::ProcessPath path;
+  path.segments.push_back(geometry_msgs::PoseArray());
+  godel_msgs::ProcessPlan plan;
+  EXPECT_FALSE(StandInProcessPlanner().planBlend(path, blendParams(), plan));
+  EXPECT_FALSE(StandInProcessPlanner().planScan(path, godel_msgs::ScanPlanParameters(), plan));
+}
+
+TEST(StandInExecutor, emitsARapidModulePerPlan)
+{
+  godel_msgs::ProcessPath path;
+  path.segments.push_back(makeLine(0.0, 0.3, 0.0, 31));
+  godel_msgs::ProcessPlan plan;
+  ASSERT_TRUE(StandInProcessPlanner().planBlend(path, blendParams(), plan));
+
+  StandInFtp ftp;
+  StandInExecutor executor(ftp);
+  std::size_t bytes = 0;
+  ASSERT_TRUE(executor.execute("test_blend", plan, bytes));
+  EXPECT_GT(bytes, 0u);
+  EXPECT_EQ(bytes, ftp.bytesUploaded());
+  EXPECT_EQ(1u, ftp.filesUploaded());
+}
+
+TEST(PipelineReport, nearestRankPercentiles)
+{
+  std::vector<double> samples;
+  for (int i = 100; i >= 1; --i)
+    samples.push_back(i);
+
+  const LatencySummary s = summarize(samples);
+  EXPECT_EQ(100u, s.samples);
+  EXPECT_DOUBLE_EQ(50.5, s.mean_ms);
+  EXPECT_DOUBLE_EQ(50.0, s.p50_ms);
+  EXPECT_DOUBLE_EQ(90.0, s.p90_ms);
+  EXPECT_DOUBLE_EQ(99.0, s.p99_ms);
+  EXPECT_DOUBLE_EQ(100.0, s.max_ms);
+
+  const LatencySummary single = summarize({7.0});
+  EXPECT_DOUBLE_EQ(7.0, single.p50_ms);
+  EXPECT_DOUBLE_EQ(7.0, single.p99_ms);
+  EXPECT_EQ(0u, summarize({}).samples);
+}
+
+TEST(PipelineReport, listsEveryStage)
+{
+  PipelineReport report("test", 1);
+  report.addSample("detection", 3.0);
+  std::ostringstream json;
+  report.writeJson(json);
+
+  EXPECT_NE(std::string::npos, json.str().find("\"schema_version\": " + std::to_string(REPORT_SCHEMA_VERSION)));
+  for (const auto& stage : PIPELINE_STAGES)
+    EXPECT_NE(std::string::npos, json.str().find("\"" + stage + "\": {\"samples\""));
+}
+
+TEST(PipelineReport, reportsCpuTimeOfTheDeployment)
+{
+  PipelineReport report("test", 1);
+  report.setDeployment("nodelets");
+  report.setCpuUsage({2.0, 1.5, 0.5});
+  std::ostringstream json;
+  report.writeJson(json);
+
+  EXPECT_NE(std::string::npos, json.str().find("\"deployment\": \"nodelets\""));
+  EXPECT_NE(std::string::npos, json.str().find("\"total_s\": 2.000000, \"utilization\": 1.000000"));
+}
+
+TEST(PipelineReport, readsCpuTimeOfOtherProcesses)
+{
+  // Burn some CPU so that both clocks have ticked
+  volatile double x = 0.0;
+  while (processCpuSeconds() < 0.05)
+    x = x + std::sqrt(x + 1.0);
+
+  const double own = processCpuSeconds();
+  const double from_proc = processCpuSeconds(getpid());
+  EXPECT_GT(from_proc, 0.0);
+  EXPECT_NEAR(own, from_proc, 0.05);
+  EXPECT_LT(processCpuSeconds(-1), 0.0);
+}
+
+TEST(ReferenceDataset, syntheticPartsAreDeterministic)
+{
+  DatasetPart part;
+  part.name = "step";
+  part.spacing = 0.005;
+  part.noise = 0.0005;
+  part.seed = 4;
+  part.boxes.push_back(Box{0.0, 0.0, 0.02, 0.2, 0.1, 0.04});
+  part.boxes.push_back(Box{0.05, 0.02, 0.06, 0.05, 0.05, 0.02});
+
+  pcl::PointCloud<pcl::PointXYZRGB> a, b;
+  ASSERT_TRUE(loadPartCloud(part, a));
+  ASSERT_TRUE(loadPartCloud(part, b));
+  ASSERT_EQ(a.size(), b.size());
+  for (std::size_t i = 0; i < a.size(); ++i)
+  {
+    EXPECT_EQ(a[i].x, b[i].x);
+    EXPECT_EQ(a[i].z, b[i].z);
+  }
+
+  // The base's top under the step is hidden and must not be sampled
+  for (const auto& p : a)
+  {
+    const bool under_step = p.x > 0.055 && p.x < 0.095 && p.y > 0.025 && p.y < 0.065;
+    EXPECT_FALSE(under_step && std::abs(p.z - 0.06) < 0.003);
+  }
+}
+
+TEST(ReferenceDataset, parsesPartDescriptions)
+{
+  XmlRpc::XmlRpcValue parts;
+  parts[0]["name"] = "scan";
+  parts[0]["pcd"] = "scans/part.pcd";
+  parts[1]["name"] = "box";
+  parts[1]["seed"] = 7;
+  parts[1]["boxes"][0][0] = 0.0;
+  parts[1]["boxes"][0][1] = 0.0;
+  parts[1]["boxes"][0][2] = 0.02;
+  parts[1]["boxes"][0][3] = 0.1;
+  parts[1]["boxes"][0][4] = 0.1;
+  parts[1]["boxes"][0][5] = 1; // integers are accepted too
+
+  std::vector<DatasetPart> dataset;
+  ASSERT_TRUE(loadDataset(parts, "/data", dataset));
+  ASSERT_EQ(2u, dataset.size());
+  EXPECT_EQ("/data/scans/part.pcd", dataset[0].pcd);
+  EXPECT_EQ(7u, dataset[1].seed);
+  ASSERT_EQ(1u, dataset[1].boxes.size());
+  EXPECT_DOUBLE_EQ(1.0, dataset[1].boxes[0].size_z);
+
+  XmlRpc::XmlRpcValue bad;
+  bad[0]["name"] = "no_geometry";
+  EXPECT_FALSE(loadDataset(bad, "/data", dataset));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
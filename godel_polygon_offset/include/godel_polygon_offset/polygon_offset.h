@@ -32,8 +32,10 @@
 #include <boost/shared_ptr.hpp>
 #include <openvoronoi/voronoidiagram.hpp>
 #include <openvoronoi/offset_sorter.hpp>
+#include "godel_process_path_generation/path_primitives.h"
 #include "godel_process_path_generation/polygon_pts.hpp"
 
+using godel_process_path::PathLoopCollection;
 using godel_process_path::PolygonBoundaryCollection;
 
 namespace godel_polygon_offset
@@ -42,7 +44,8 @@ namespace godel_polygon_offset
 /**@brief PolygonOffset class creates offset paths for closed polygon boundaries.
  * Can handle multiple boundaries of both inside and outside types.
  * offset_/initial_offset_ are used as offset distances.
- * Both line segments and arcs are discretized to line segments.
+ * Offsets are available as the lines and arcs of the voronoi diagram, or with both line segments
+ * and arcs discretized to line segments.
  * Resulting polygons are sorted for easy machining: Start at innermost and work outwards, then hop
  * to next innermost.
  */
@@ -70,14 +73,23 @@ public:
    */
   bool generateOrderedOffsets(PolygonBoundaryCollection& pbc, std::vector<double>& offsets);
 
+  /**@brief As above, with the lines and arcs of the offsets kept as they are.
+   * Nothing is discretized; the discretization distance is not used.
+   * @param loops Resultant loops, in the same order as the polygons.
+   * @param offsets List of offset distances corresponding to loops.
+   * @return True if successfully performed offsets.
+   */
+  bool generateOrderedOffsets(PathLoopCollection& loops, std::vector<double>& offsets);
+
+  /**@brief Discretize lines and arcs of loops to polygons, as generateOrderedOffsets() does.
+   * @param loops Loops from generateOrderedOffsets().
+   * @param pbc Resultant polygons, with points no further apart than the discretization distance.
+   */
+  void discretize(const PathLoopCollection& loops, PolygonBoundaryCollection& pbc) const;
+
   bool verbose_; /**<Flag to display additional debug messages */
 
 private:
-  /**@brief Convert ovd::OffsetLoops (lines/arcs) to PolygonBoundaries (lines)
-   * All lines and arcs are discretized (TODO should only arcs be discretized here?)
-   * @param polygons Collection of polygons resulting from conversion.
-   * @param offset_loops Ordered OffsetLoops by machining order.
-   */
 
   double offset_, initial_offset_; /**<Typical offset and initial offset distance. */
   double discretization_;          /**<Max linear or arc-length distance between adjacent points in
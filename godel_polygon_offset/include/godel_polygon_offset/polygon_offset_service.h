@@ -0,0 +1,41 @@
+/*
+ * Software License Agreement (GPLv3 License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * This file is part of godel. https://github.com/ros-industrial-consortium/godel
+ *
+ *  godel_polygon_offset is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  godel_polygon_offset is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with godel_polygon_offset.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GODEL_POLYGON_OFFSET_SERVICE_H
+#define GODEL_POLYGON_OFFSET_SERVICE_H
+
+#include <godel_msgs/OffsetBoundary.h>
+
+namespace godel_polygon_offset
+{
+
+const static std::string OFFSET_POLYGON_SERVICE = "offset_polygon";
+
+/**
+ * @brief Handler of the offset_polygon service, shared by polygon_offset_node and its nodelet.
+ * The service is served as godel_msgs/OffsetBoundary, which is identical to OffsetPolygon on the
+ * wire, so that process_path_generator can call it in-process.
+ */
+bool offsetPolygons(godel_msgs::OffsetBoundary::Request& req, godel_msgs::OffsetBoundary::Response& res);
+
+} // namespace godel_polygon_offset
+
+#endif // GODEL_POLYGON_OFFSET_SERVICE_H
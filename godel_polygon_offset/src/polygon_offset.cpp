@@ -34,6 +34,9 @@
 #include <godel_process_path_generation/utils.h>
 #include "godel_polygon_offset/polygon_offset.h"
 
+using godel_process_path::PathLoop;
+using godel_process_path::PathLoopCollection;
+using godel_process_path::PathPrimitive;
 using godel_process_path::PolygonBoundaryCollection;
 using godel_process_path::PolygonBoundary;
 using godel_process_path::PolygonPt;
@@ -111,6 +114,43 @@ bool PolygonOffset::init(const PolygonBoundaryCollection& pbc, double _offset,
 
 bool PolygonOffset::generateOrderedOffsets(PolygonBoundaryCollection& polygons,
                                            std::vector<double>& offsets)
+{
+  PathLoopCollection loops;
+  if (!generateOrderedOffsets(loops, offsets))
+  {
+    return false;
+  }
+  discretize(loops, polygons);
+  return true;
+}
+
+void PolygonOffset::discretize(const PathLoopCollection& loops, PolygonBoundaryCollection& polygons) const
+{
+  polygons.clear();
+  BOOST_FOREACH (const PathLoop& loop, loops)
+  {
+    PolygonBoundary polygon;
+    BOOST_FOREACH (const PathPrimitive& primitive, loop)
+    {
+      std::vector<PolygonPt> pts;
+      if (primitive.type == PathPrimitive::LINE)
+      {
+        pts = godel_process_path::utils::geometry::discretizeLinear(primitive.start, primitive.end,
+                                                                    discretization_);
+      }
+      else
+      {
+        pts = godel_process_path::utils::geometry::discretizeArc2D(primitive.start, primitive.end,
+                                                                   primitive.center, primitive.ccw,
+                                                                   discretization_);
+      }
+      polygon.insert(polygon.end(), pts.begin(), pts.end());
+    }
+    polygons.push_back(polygon);
+  }
+}
+
+bool PolygonOffset::generateOrderedOffsets(PathLoopCollection& loops, std::vector<double>& offsets)
 {
   if (!init_ok_)
   {
@@ -205,37 +245,32 @@ bool PolygonOffset::generateOrderedOffsets(PolygonBoundaryCollection& polygons,
     }
   }
 
-  // Convert ovg::OffsetLoops to polygons and discretize
-  // Populate polygons and offsets
-  polygons.clear();
+  // Convert ovg::OffsetLoops to lines and arcs
+  // Populate loops and offsets
+  loops.clear();
   offsets.clear();
   BOOST_FOREACH (ovd::MGVertex loop_descriptor, ordered_loops)
   {
-    PolygonBoundary polygon;
+    PathLoop path_loop;
     const ovd::OffsetLoop& loop = mg[loop_descriptor];
     ovd::OffsetVertex prior_vtx = loop.vertices.front();
     std::list<ovd::OffsetVertex>::const_iterator vtx = boost::next(loop.vertices.begin());
     while (vtx != loop.vertices.end())
     {
       PolygonPt prior(prior_vtx.p.x, prior_vtx.p.y), current(vtx->p.x, vtx->p.y);
-      std::vector<PolygonPt> pts;
       if (vtx->r == -1)
       {
-        pts =
-            godel_process_path::utils::geometry::discretizeLinear(prior, current, discretization_);
+        path_loop.push_back(PathPrimitive::line(prior, current));
       }
       else
       {
         PolygonPt arc_center(vtx->c.x, vtx->c.y);
-        pts = godel_process_path::utils::geometry::discretizeArc2D(prior, current, arc_center,
-                                                                   !vtx->cw, discretization_);
+        path_loop.push_back(PathPrimitive::arc(prior, current, arc_center, !vtx->cw));
       }
-      polygon.insert(polygon.end(), pts.begin(), pts.end());
-      pts.clear();
       prior_vtx = *vtx;
       ++vtx;
     }
-    polygons.push_back(polygon);
+    loops.push_back(path_loop);
     offsets.push_back(loop.offset_distance);
   }
 
@@ -26,49 +26,17 @@
  */
 
 #include <ros/ros.h>
-#include <boost/foreach.hpp>
-#include "godel_polygon_offset/OffsetPolygon.h"
-#include "godel_polygon_offset/polygon_offset.h"
-#include "godel_process_path_generation/polygon_pts.hpp"
-#include "godel_process_path_generation/utils.h"
-
-using godel_polygon_offset::OffsetPolygonRequest;
-using godel_polygon_offset::OffsetPolygonResponse;
-using namespace godel_process_path;
-
-bool offset_polygons_cb(OffsetPolygonRequest& req, OffsetPolygonResponse& res)
-{
-  godel_polygon_offset::PolygonOffset po;
-  po.verbose_ = true;
-
-  godel_process_path::PolygonBoundaryCollection pbc;
-  utils::translations::geometryMsgsToGodel(pbc, req.polygons);
-  ROS_INFO_STREAM("Received request with " << pbc.size() << " boundary polygons.");
-
-  if (req.initial_offset <= 0.)
-  {
-    req.initial_offset = req.offset_distance; // Default initial offset if unspecified.
-  }
-  if (!po.init(pbc, req.offset_distance, req.initial_offset, req.discretization))
-  {
-    ROS_ERROR("Could not initialize PolygonOffset.");
-    return false;
-  }
-  if (!po.generateOrderedOffsets(pbc, res.offsets)) /* Generates polygons and offset list*/
-  {
-    ROS_ERROR("Could not offset boundaries.");
-    return false;
-  }
-  utils::translations::godelToGeometryMsgs(res.offset_polygons, pbc);
-  ROS_INFO_STREAM("Returning " << pbc.size() << " offset polygons.");
-  return true;
-}
+#include "godel_polygon_offset/polygon_offset_service.h"
+#include <godel_utils/intra_process.h>
+#include <godel_utils/tracing.h>
 
 int main(int argc, char** argv)
 {
   ros::init(argc, argv, "polygon_offset_node");
   ros::NodeHandle nh;
-  ros::ServiceServer service = nh.advertiseService("offset_polygon", offset_polygons_cb);
+  godel_utils::tracing::initialize(ros::this_node::getName());
+  godel_utils::intra_process::ServiceServer<godel_msgs::OffsetBoundary> service(
+      nh, godel_polygon_offset::OFFSET_POLYGON_SERVICE, &godel_polygon_offset::offsetPolygons);
   ROS_INFO("%s ready to service requests.", service.getService().c_str());
   ros::spin();
   return 0;
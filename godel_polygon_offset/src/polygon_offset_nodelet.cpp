@@ -0,0 +1,53 @@
+/*
+ * Software License Agreement (GPLv3 License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * This file is part of godel. https://github.com/ros-industrial-consortium/godel
+ *
+ *  godel_polygon_offset is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  godel_polygon_offset is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with godel_polygon_offset.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "godel_polygon_offset/polygon_offset_service.h"
+#include <godel_utils/intra_process.h>
+#include <godel_utils/tracing.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+namespace godel_polygon_offset
+{
+
+/**
+ * @brief polygon_offset_node as a nodelet; process_path_generator loaded into the same manager
+ * calls it without serializing the boundaries
+ */
+class PolygonOffsetNodelet : public nodelet::Nodelet
+{
+private:
+  virtual void onInit()
+  {
+    if (!godel_utils::tracing::enabled())
+      godel_utils::tracing::initialize(ros::this_node::getName());
+
+    service_ = godel_utils::intra_process::ServiceServer<godel_msgs::OffsetBoundary>(
+        getNodeHandle(), OFFSET_POLYGON_SERVICE, &offsetPolygons);
+    NODELET_INFO("%s ready to service requests.", service_.getService().c_str());
+  }
+
+  godel_utils::intra_process::ServiceServer<godel_msgs::OffsetBoundary> service_;
+};
+
+} // namespace godel_polygon_offset
+
+PLUGINLIB_EXPORT_CLASS(godel_polygon_offset::PolygonOffsetNodelet, nodelet::Nodelet)
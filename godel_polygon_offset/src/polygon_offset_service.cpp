@@ -0,0 +1,68 @@
+/*
+ * Software License Agreement (GPLv3 License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * This file is part of godel. https://github.com/ros-industrial-consortium/godel
+ *
+ *  godel_polygon_offset is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  godel_polygon_offset is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with godel_polygon_offset.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "godel_polygon_offset/polygon_offset_service.h"
+#include "godel_polygon_offset/polygon_offset.h"
+#include "godel_process_path_generation/polygon_pts.hpp"
+#include "godel_process_path_generation/utils.h"
+#include <godel_utils/tracing.h>
+#include <ros/console.h>
+
+using namespace godel_process_path;
+
+namespace godel_polygon_offset
+{
+
+bool offsetPolygons(godel_msgs::OffsetBoundary::Request& req, godel_msgs::OffsetBoundary::Response& res)
+{
+  godel_utils::tracing::Span span("offset_polygon", req.trace);
+  PolygonOffset po;
+  po.verbose_ = true;
+
+  godel_process_path::PolygonBoundaryCollection pbc;
+  utils::translations::geometryMsgsToGodel(pbc, req.polygons);
+  ROS_INFO_STREAM("Received request with " << pbc.size() << " boundary polygons.");
+
+  if (req.initial_offset <= 0.)
+  {
+    req.initial_offset = req.offset_distance; // Default initial offset if unspecified.
+  }
+  if (!po.init(pbc, req.offset_distance, req.initial_offset, req.discretization))
+  {
+    ROS_ERROR("Could not initialize PolygonOffset.");
+    return false;
+  }
+  godel_process_path::PathLoopCollection loops;
+  if (!po.generateOrderedOffsets(loops, res.offsets)) /* Generates loops and offset list*/
+  {
+    ROS_ERROR("Could not offset boundaries.");
+    return false;
+  }
+  utils::translations::godelToGodelMsgs(res.offset_loops, loops);
+
+  // The same loops, discretized for callers that want polygons
+  po.discretize(loops, pbc);
+  utils::translations::godelToGeometryMsgs(res.offset_polygons, pbc);
+  ROS_INFO_STREAM("Returning " << pbc.size() << " offset polygons.");
+  return true;
+}
+
+} // namespace godel_polygon_offset
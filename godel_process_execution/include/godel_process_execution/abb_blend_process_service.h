@@ -4,6 +4,7 @@
 #include <ros/ros.h>
 #include <godel_msgs/ProcessExecutionAction.h>
 #include <actionlib/server/simple_action_server.h>
+#include <moveit/robot_model/robot_model.h>
 
 namespace godel_process_execution
 {
@@ -28,6 +29,9 @@ private:
   ros::ServiceClient sim_client_;
   actionlib::SimpleActionServer<godel_msgs::ProcessExecutionAction> process_exe_action_server_;
   bool j23_coupled_;
+  moveit::core::RobotModelConstPtr robot_model_;
+  std::string tcp_frame_;  // the tool whose path the zones are sized for
+  double path_tolerance_;  // mm the tool may cut corners of the process path by
 };
 }
 
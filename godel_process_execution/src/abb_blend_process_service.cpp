@@ -1,11 +1,14 @@
 #include <godel_process_execution/abb_blend_process_service.h>
+#include <godel_utils/tracing.h>
 
 #include <industrial_robot_simulator_service/SimulateTrajectory.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit_msgs/ExecuteKnownTrajectory.h>
 
 #include <fstream>
 
 #include "process_utils.h"
+#include "rapid_utils.h"
 #include "rapid_generator/rapid_emitter.h"
 #include "abb_file_suite/ExecuteProgram.h"
 #include <godel_utils/ensenso_guard.h>
@@ -17,6 +20,8 @@
 const static double DEFAULT_JOINT_TOPIC_WAIT_TIME = 5.0; // seconds
 const static double DEFAULT_TRAJECTORY_BUFFER_TIME = 5.0; // seconds
 const static std::string JOINT_TOPIC_NAME = "/joint_states";
+const static std::string DEFAULT_TCP_FRAME = "tcp_frame";
+const static double DEFAULT_PATH_TOLERANCE = 1.0; // mm
 
 const static std::string THIS_SERVICE_NAME = "blend_process_execution";
 const static std::string EXECUTION_SERVICE_NAME = "execute_program";
@@ -70,53 +75,6 @@ static bool waitForExecution(const std::vector<double>& end_goal, const ros::Dur
   return false;
 }
 
-static double toDegrees(double rads) { return rads * 180.0 / M_PI; }
-
-static std::vector<double> toDegrees(const std::vector<double>& rads)
-{
-  std::vector<double> degrees;
-  degrees.reserve(rads.size());
-
-  for (std::size_t i = 0; i < rads.size(); ++i)
-  {
-    degrees.push_back(toDegrees(rads[i]));
-  }
-  return degrees;
-}
-
-static std::vector<rapid_emitter::TrajectoryPt>
-toRapidTrajectory(const trajectory_msgs::JointTrajectory& traj, bool j23_coupled)
-{
-  std::vector<rapid_emitter::TrajectoryPt> rapid_pts;
-  rapid_pts.reserve(traj.points.size());
-
-  for (std::size_t i = 0; i < traj.points.size(); ++i)
-  {
-
-    // Retrieve and convert joint values to degrees
-    std::vector<double> angles = toDegrees(traj.points[i].positions);
-
-    // Account for coupling if necessary
-    if (j23_coupled)
-    {
-      ROS_ASSERT(traj.points[i].positions.size() > 2);
-      angles[2] += angles[1];
-    }
-
-    // Calculate between point timing
-    double duration = 0.0;
-    if (i > 0)
-    {
-      duration = (traj.points[i].time_from_start - traj.points[i - 1].time_from_start).toSec();
-    }
-
-    // Now we have all the info we need
-    rapid_emitter::TrajectoryPt rapid_point(angles, duration);
-    rapid_pts.push_back(rapid_point);
-  }
-  return rapid_pts;
-}
-
 static bool writeRapidFile(const std::string& path,
                            const std::vector<rapid_emitter::TrajectoryPt>& traj,
                            unsigned process_start, unsigned process_stop,
@@ -147,6 +105,18 @@ godel_process_execution::AbbBlendProcessService::AbbBlendProcessService(ros::Nod
 {
   // Load Robot Specific Parameters
   nh_.param<bool>("J23_coupled", j23_coupled_, false);
+  nh_.param<std::string>("tcp_frame", tcp_frame_, DEFAULT_TCP_FRAME);
+  nh_.param<double>("path_tolerance", path_tolerance_, DEFAULT_PATH_TOLERANCE);
+
+  // The robot model gives the tool positions that the zones of the RAPID program are sized with
+  robot_model_loader::RobotModelLoader::Options options("robot_description");
+  options.load_kinematics_solvers_ = false;
+  robot_model_loader::RobotModelLoader loader(options);
+  robot_model_ = loader.getModel();
+  if (!robot_model_)
+  {
+    ROS_WARN("No robot model; RAPID programs use fixed zones");
+  }
 
   // Create client services
   sim_client_ = nh_.serviceClient<industrial_robot_simulator_service::SimulateTrajectory>(SIMULATION_SERVICE_NAME);
@@ -157,6 +127,7 @@ godel_process_execution::AbbBlendProcessService::AbbBlendProcessService(ros::Nod
 void godel_process_execution::AbbBlendProcessService::executionCallback(
     const godel_msgs::ProcessExecutionGoalConstPtr &goal)
 {
+  godel_utils::tracing::Span span("blend_process_execution", goal->trace);
   godel_msgs::ProcessExecutionResult res;
   if (goal->simulate)
   {
@@ -178,7 +149,8 @@ bool godel_process_execution::AbbBlendProcessService::executeProcess(
   appendTrajectory(aggregate_traj, goal->trajectory_depart);
 
   // ABB Rapid Emmiter
-  std::vector<rapid_emitter::TrajectoryPt> pts = toRapidTrajectory(aggregate_traj, j23_coupled_);
+  std::vector<rapid_emitter::TrajectoryPt> pts =
+      toRapidTrajectory(aggregate_traj, j23_coupled_, robot_model_, tcp_frame_);
 
   // RAPID process parameters
   rapid_emitter::ProcessParams params;
@@ -187,12 +159,18 @@ bool godel_process_execution::AbbBlendProcessService::executeProcess(
   params.wolf_mode = false;
   params.slide_force = 0.0;
   params.output_name = "do_PIO_8";
+  params.path_tolerance = path_tolerance_;
 
   // Calculate process start and end indexes
   unsigned start_index = goal->trajectory_approach.points.size();
   unsigned stop_index = start_index + goal->trajectory_process.points.size();
 
-  if (!writeRapidFile("/tmp/blend.mod", pts, start_index, stop_index, params))
+  bool written;
+  {
+    GODEL_TRACE_SPAN("emit_rapid");
+    written = writeRapidFile("/tmp/blend.mod", pts, start_index, stop_index, params);
+  }
+  if (!written)
   {
     ROS_ERROR("Unable to generate RAPID motion file; Cannot execute process.");
     return false;
@@ -203,7 +181,12 @@ bool godel_process_execution::AbbBlendProcessService::executeProcess(
   abb_file_suite::ExecuteProgram srv;
   srv.request.file_path = "/tmp/blend.mod";
 
-  if (!real_client_.call(srv))
+  bool uploaded;
+  {
+    GODEL_TRACE_SPAN("upload_rapid");
+    uploaded = real_client_.call(srv);
+  }
+  if (!uploaded)
   {
     ROS_ERROR("Unable to upload blending process RAPID module to controller via FTP.");
     return false;
@@ -1,4 +1,5 @@
 #include <godel_process_execution/blend_process_service.h>
+#include <godel_utils/tracing.h>
 
 #include <industrial_robot_simulator_service/SimulateTrajectory.h>
 #include <godel_msgs/TrajectoryExecution.h>
@@ -32,6 +33,7 @@ godel_process_execution::BlendProcessService::BlendProcessService(ros::NodeHandl
 void godel_process_execution::BlendProcessService::executionCallback(
     const godel_msgs::ProcessExecutionGoalConstPtr &goal)
 {
+  godel_utils::tracing::Span span("blend_process_execution", goal->trace);
   godel_msgs::ProcessExecutionResult res;
   if (goal->simulate)
   {
@@ -1,10 +1,12 @@
 #include <godel_process_execution/blend_process_service.h>
 
+#include <godel_utils/tracing.h>
 #include <ros/ros.h>
 
 int main(int argc, char** argv)
 {
   ros::init(argc, argv, "blend_process_service_node");
+  godel_utils::tracing::initialize(ros::this_node::getName());
 
   ros::NodeHandle nh;
 
@@ -1,4 +1,5 @@
 #include <godel_process_execution/keyence_process_service.h>
+#include <godel_utils/tracing.h>
 
 #include <industrial_robot_simulator_service/SimulateTrajectory.h>
 #include <moveit_msgs/ExecuteKnownTrajectory.h>
@@ -49,6 +50,7 @@ godel_process_execution::KeyenceProcessService::KeyenceProcessService(ros::NodeH
 void godel_process_execution::KeyenceProcessService::executionCallback(
     const godel_msgs::ProcessExecutionGoalConstPtr &goal)
 {
+  godel_utils::tracing::Span span("scan_process_execution", goal->trace);
   godel_msgs::ProcessExecutionResult res;
   if (goal->simulate)
   {
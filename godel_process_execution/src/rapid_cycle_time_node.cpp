@@ -0,0 +1,198 @@
+/*
+ * Compares the estimated cycle times of the RAPID programs of recorded blending plans with the
+ * zones the emitter used to write (z40/z20) and with the planned ones. The plans come from a
+ * trajectory library saved by the blending service; the robot description must be loaded, as
+ * the zones are sized from the tool positions.
+ *
+ * Each process path is also retimed, with planned zones, at one speed slow enough for its
+ * tightest corner ('constant') and with the feed scheduled along it ('scheduled'), both within
+ * ~tcp_speed, ~max_acceleration, ~max_lateral_acceleration and ~max_rotation_speed and the joint
+ * velocity limits of the robot description.
+ *
+ *   rosrun godel_process_execution rapid_cycle_time plans.bag _tcp_frame:=tcp_frame
+ *
+ * With ~output_directory set, the planned programs are written there as <plan>.mod.
+ */
+
+#include <godel_msgs/ProcessPlan.h>
+#include <godel_process_planning/feed_scheduling.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_state/robot_state.h>
+#include <rapid_generator/rapid_emitter.h>
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "process_utils.h"
+#include "rapid_utils.h"
+
+const static std::string DEFAULT_TCP_FRAME = "tcp_frame";
+const static double DEFAULT_PATH_TOLERANCE = 1.0; // mm
+const static double DEFAULT_TCP_SPEED = 200.0;    // mm/s, as abb_blend_process_service
+
+// Tool positions (m) and orientations of the points of a trajectory
+static godel_process_planning::PoseVector toolPoses(const trajectory_msgs::JointTrajectory& traj,
+                                                    const moveit::core::RobotModelConstPtr& model,
+                                                    const std::string& tcp_frame)
+{
+  godel_process_planning::PoseVector poses;
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  for (const auto& pt : traj.points)
+  {
+    state.setVariablePositions(traj.joint_names, pt.positions);
+    poses.push_back(state.getGlobalLinkTransform(tcp_frame));
+  }
+  return poses;
+}
+
+// The trajectory with the given time (s) of the move into each point
+static trajectory_msgs::JointTrajectory retime(const trajectory_msgs::JointTrajectory& traj,
+                                               const std::vector<double>& durations)
+{
+  trajectory_msgs::JointTrajectory retimed = traj;
+  for (std::size_t i = 1; i < retimed.points.size(); ++i)
+  {
+    retimed.points[i].time_from_start = retimed.points[i - 1].time_from_start + ros::Duration(durations[i]);
+  }
+  return retimed;
+}
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "rapid_cycle_time");
+  ros::NodeHandle pnh("~");
+  if (argc < 2)
+  {
+    ROS_ERROR("Usage: rapid_cycle_time <trajectory library bag>");
+    return 1;
+  }
+
+  bool j23_coupled;
+  std::string tcp_frame, output_directory;
+  rapid_emitter::ProcessParams params;
+  pnh.param<bool>("J23_coupled", j23_coupled, false);
+  pnh.param<std::string>("tcp_frame", tcp_frame, DEFAULT_TCP_FRAME);
+  pnh.param<std::string>("output_directory", output_directory, "");
+  pnh.param<double>("path_tolerance", params.path_tolerance, DEFAULT_PATH_TOLERANCE);
+  pnh.param<double>("tcp_speed", params.tcp_speed, DEFAULT_TCP_SPEED);
+  params.output_name = "do_PIO_8";
+
+  godel_process_planning::FeedLimits feed;
+  pnh.param<double>("max_acceleration", feed.max_acceleration, feed.max_acceleration);
+  pnh.param<double>("max_lateral_acceleration", feed.max_lateral_acceleration, feed.max_lateral_acceleration);
+  pnh.param<double>("max_rotation_speed", feed.max_rotation_speed, feed.max_rotation_speed);
+  feed.max_speed = params.tcp_speed / 1000.0;
+
+  robot_model_loader::RobotModelLoader::Options options("robot_description");
+  options.load_kinematics_solvers_ = false;
+  robot_model_loader::RobotModelLoader loader(options);
+  if (!loader.getModel() || !loader.getModel()->hasLinkModel(tcp_frame))
+  {
+    ROS_ERROR_STREAM("Unable to load a robot model with link '" << tcp_frame << "'");
+    return 1;
+  }
+
+  // Where a plan names joints the model limits, their limits bound its feed
+  const auto joint_velocity_limits = [&loader](const std::vector<std::string>& joint_names) -> std::vector<double>
+  {
+    std::vector<double> limits;
+    for (const auto& name : joint_names)
+    {
+      const moveit::core::JointModel* joint = loader.getModel()->getJointModel(name);
+      const bool bounded = joint && !joint->getVariableBounds().empty() &&
+                           joint->getVariableBounds()[0].velocity_bounded_;
+      limits.push_back(bounded ? joint->getVariableBounds()[0].max_velocity_ : 0.0);
+    }
+    return limits;
+  };
+
+  rosbag::Bag bag;
+  try
+  {
+    bag.open(argv[1], rosbag::bagmode::Read);
+  }
+  catch (const rosbag::BagException& e)
+  {
+    ROS_ERROR_STREAM("Unable to open " << argv[1] << ": " << e.what());
+    return 1;
+  }
+
+  std::printf("%-32s %8s %10s %11s %8s %12s %13s %8s\n", "plan", "points", "fixed [s]", "planned [s]", "change",
+              "constant [s]", "scheduled [s]", "change");
+  double total_fixed = 0.0, total_planned = 0.0, total_constant = 0.0, total_scheduled = 0.0;
+  rosbag::View view(bag);
+  for (rosbag::View::iterator it = view.begin(); it != view.end(); ++it)
+  {
+    godel_msgs::ProcessPlanConstPtr plan = it->instantiate<godel_msgs::ProcessPlan>();
+    if (!plan || plan->type != godel_msgs::ProcessPlan::BLEND_TYPE)
+      continue;
+
+    const auto to_rapid =
+        [&](const trajectory_msgs::JointTrajectory& process) -> std::vector<rapid_emitter::TrajectoryPt>
+    {
+      trajectory_msgs::JointTrajectory aggregate_traj = plan->trajectory_approach;
+      godel_process_execution::appendTrajectory(aggregate_traj, process);
+      godel_process_execution::appendTrajectory(aggregate_traj, plan->trajectory_depart);
+      return godel_process_execution::toRapidTrajectory(aggregate_traj, j23_coupled, loader.getModel(),
+                                                        tcp_frame);
+    };
+    const std::vector<rapid_emitter::TrajectoryPt> pts = to_rapid(plan->trajectory_process);
+
+    const std::size_t start = plan->trajectory_approach.points.size();
+    const std::size_t stop = start + plan->trajectory_process.points.size();
+    const double fixed = rapid_emitter::estimateCycleTime(
+        pts, rapid_emitter::fixedMoves(pts, start, stop, params), start, stop, params);
+    const double planned = rapid_emitter::estimateCycleTime(
+        pts, rapid_emitter::planMoves(pts, start, stop, params), start, stop, params);
+    total_fixed += fixed;
+    total_planned += planned;
+
+    // The process path at one speed safe everywhere on it, and with its feed scheduled
+    const trajectory_msgs::JointTrajectory& process = plan->trajectory_process;
+    const godel_process_planning::PoseVector poses = toolPoses(process, loader.getModel(), tcp_frame);
+    std::vector<std::vector<double>> joints;
+    for (const auto& pt : process.points)
+      joints.push_back(pt.positions);
+
+    godel_process_planning::FeedLimits plan_feed = feed;
+    plan_feed.max_joint_velocity = joint_velocity_limits(process.joint_names);
+    godel_process_planning::FeedLimits constant_feed = plan_feed;
+    const std::vector<double> limits = godel_process_planning::speedLimits(poses, joints, plan_feed);
+    if (limits.size() > 2)
+      constant_feed.max_speed = *std::min_element(limits.begin() + 1, limits.end() - 1);
+    constant_feed.max_lateral_acceleration = 0.0;
+
+    const std::vector<rapid_emitter::TrajectoryPt> constant_pts =
+        to_rapid(retime(process, godel_process_planning::scheduleFeed(poses, joints, constant_feed)));
+    const std::vector<rapid_emitter::TrajectoryPt> scheduled_pts =
+        to_rapid(retime(process, godel_process_planning::scheduleFeed(poses, joints, plan_feed)));
+    const double constant = rapid_emitter::estimateCycleTime(
+        constant_pts, rapid_emitter::planMoves(constant_pts, start, stop, params), start, stop, params);
+    const double scheduled = rapid_emitter::estimateCycleTime(
+        scheduled_pts, rapid_emitter::planMoves(scheduled_pts, start, stop, params), start, stop, params);
+    total_constant += constant;
+    total_scheduled += scheduled;
+
+    std::printf("%-32s %8zu %10.2f %11.2f %7.1f%% %12.2f %13.2f %7.1f%%\n", it->getTopic().c_str(), pts.size(),
+                fixed, planned, fixed > 0.0 ? 100.0 * (planned - fixed) / fixed : 0.0, constant, scheduled,
+                constant > 0.0 ? 100.0 * (scheduled - constant) / constant : 0.0);
+
+    if (!output_directory.empty())
+    {
+      std::ofstream fp((output_directory + "/" + it->getTopic() + ".mod").c_str());
+      if (!fp || !rapid_emitter::emitRapidFile(fp, pts, start, stop, params))
+        ROS_WARN_STREAM("Unable to write the program of " << it->getTopic() << " to " << output_directory);
+    }
+  }
+
+  std::printf("%-32s %8s %10.2f %11.2f %7.1f%% %12.2f %13.2f %7.1f%%\n", "total", "", total_fixed, total_planned,
+              total_fixed > 0.0 ? 100.0 * (total_planned - total_fixed) / total_fixed : 0.0, total_constant,
+              total_scheduled,
+              total_constant > 0.0 ? 100.0 * (total_scheduled - total_constant) / total_constant : 0.0);
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include "rapid_utils.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <moveit/robot_state/robot_state.h>
+#include <ros/assert.h>
+#include <ros/console.h>
+
+#include <cmath>
+
+static double toDegrees(double rads) { return rads * 180.0 / M_PI; }
+
+static std::vector<double> toDegrees(const std::vector<double>& rads)
+{
+  std::vector<double> degrees;
+  degrees.reserve(rads.size());
+
+  for (std::size_t i = 0; i < rads.size(); ++i)
+  {
+    degrees.push_back(toDegrees(rads[i]));
+  }
+  return degrees;
+}
+
+std::vector<rapid_emitter::TrajectoryPt>
+godel_process_execution::toRapidTrajectory(const trajectory_msgs::JointTrajectory& traj, bool j23_coupled,
+                                           const moveit::core::RobotModelConstPtr& model,
+                                           const std::string& tcp_frame)
+{
+  std::vector<rapid_emitter::TrajectoryPt> rapid_pts;
+  rapid_pts.reserve(traj.points.size());
+
+  boost::scoped_ptr<moveit::core::RobotState> state;
+  if (model && model->hasLinkModel(tcp_frame))
+  {
+    state.reset(new moveit::core::RobotState(model));
+    state->setToDefaultValues();
+  }
+  else if (model)
+  {
+    ROS_WARN_STREAM("Robot model has no link '" << tcp_frame << "'; RAPID zones can't be sized");
+  }
+
+  for (std::size_t i = 0; i < traj.points.size(); ++i)
+  {
+
+    // Retrieve and convert joint values to degrees
+    std::vector<double> angles = toDegrees(traj.points[i].positions);
+
+    // Account for coupling if necessary
+    if (j23_coupled)
+    {
+      ROS_ASSERT(traj.points[i].positions.size() > 2);
+      angles[2] += angles[1];
+    }
+
+    // Calculate between point timing
+    double duration = 0.0;
+    if (i > 0)
+    {
+      duration = (traj.points[i].time_from_start - traj.points[i - 1].time_from_start).toSec();
+    }
+
+    // The tool position, in mm like all lengths of a RAPID program
+    std::vector<double> tcp_position;
+    if (state && traj.joint_names.size() == traj.points[i].positions.size())
+    {
+      state->setVariablePositions(traj.joint_names, traj.points[i].positions);
+      const Eigen::Vector3d tcp = state->getGlobalLinkTransform(tcp_frame).translation() * 1000.0;
+      tcp_position.assign(tcp.data(), tcp.data() + 3);
+    }
+
+    // Now we have all the info we need
+    rapid_emitter::TrajectoryPt rapid_point(angles, duration, tcp_position);
+    rapid_pts.push_back(rapid_point);
+  }
+  return rapid_pts;
+}
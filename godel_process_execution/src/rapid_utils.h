@@ -0,0 +1,23 @@
+#ifndef PATH_GODEL_RAPID_UTILS_H
+#define PATH_GODEL_RAPID_UTILS_H
+
+#include <moveit/robot_model/robot_model.h>
+#include <rapid_generator/rapid_data_structures.h>
+#include <trajectory_msgs/JointTrajectory.h>
+
+namespace godel_process_execution
+{
+
+/**
+ * @brief Converts a joint trajectory to the points of a RAPID program. If 'model' is given, the
+ *        points carry the position of 'tcp_frame' in its model frame, which the emitter sizes
+ *        the zones of the program with.
+ * @param j23_coupled Whether joint 3 of the controller is measured from joint 2 (IRB 2400)
+ */
+std::vector<rapid_emitter::TrajectoryPt>
+toRapidTrajectory(const trajectory_msgs::JointTrajectory& traj, bool j23_coupled,
+                  const moveit::core::RobotModelConstPtr& model = moveit::core::RobotModelConstPtr(),
+                  const std::string& tcp_frame = std::string());
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * path_primitives.h
+ *
+ * Tool paths as the lines and circular arcs that polygon offsetting produces. Loops are carried
+ * in this form from the offsetter through process path generation, and are turned into points
+ * once, by discretizeLoop(), under one spacing and one chord tolerance.
+ */
+
+#ifndef PATH_PRIMITIVES_H_
+#define PATH_PRIMITIVES_H_
+
+#include <vector>
+#include "godel_process_path_generation/polygon_pts.hpp"
+
+namespace godel_process_path
+{
+
+/**@brief A straight line, or a circular arc about 'center', from 'start' to 'end' */
+struct PathPrimitive
+{
+  enum Type
+  {
+    LINE,
+    ARC
+  };
+
+  PathPrimitive() : type(LINE), ccw(true){};
+
+  static PathPrimitive line(const PolygonPt& start, const PolygonPt& end);
+  static PathPrimitive arc(const PolygonPt& start, const PolygonPt& end, const PolygonPt& center, bool ccw);
+
+  double radius() const { return center.dist(start); }
+
+  /**@brief Signed angle (rad) the arc turns through, positive counter-clockwise; 0 for lines */
+  double sweep() const;
+
+  double length() const;
+
+  /**@brief Point at distance s (m) along the primitive from its start */
+  PolygonPt pointAt(double s) const;
+
+  /**@brief Distance (m) along the primitive to the point on it closest to pt */
+  double project(const PolygonPt& pt) const;
+
+  Type type;
+  PolygonPt start;
+  PolygonPt end;
+  PolygonPt center; /**<Arcs only */
+  bool ccw;         /**<Arcs only */
+};
+
+/**@brief A closed path: each primitive starts where the one before it ends, and the last one ends
+ * where the first one starts. */
+typedef std::vector<PathPrimitive> PathLoop;
+typedef std::vector<PathLoop> PathLoopCollection;
+
+/**@brief The edges of a polygon as a loop of lines */
+PathLoop toPathLoop(const PolygonBoundary& polygon);
+
+/**@brief True if the loop is not empty and each primitive starts within 'tolerance' (m) of where
+ * the one before it ends */
+bool isClosed(const PathLoop& loop, double tolerance = 1e-6);
+
+double loopLength(const PathLoop& loop);
+
+/**@brief Distance (m) from pt to the closest point on the loop */
+double distanceToLoop(const PolygonPt& pt, const PathLoop& loop);
+
+/**@brief Point at distance s (m) along the loop from its start */
+PolygonPt loopPointAt(const PathLoop& loop, double s);
+
+/**@brief Distance (m) along the loop from its start to its point closest to pt */
+double loopProject(const PathLoop& loop, const PolygonPt& pt);
+
+/**@brief Makes the loop start at its point closest to pt, splitting the primitive there */
+void rotateLoop(PathLoop& loop, const PolygonPt& pt);
+
+/**@brief Points along the loop from its start, with the closing point left out as in a
+ * PolygonBoundary. Lines and arcs are split into pieces no longer than max_spacing (m), if it is
+ * positive; arcs are also split finely enough that no chord is further than chord_tolerance (m)
+ * from the arc, if it is positive, and no chord spans more than a quarter turn. Where primitives
+ * meet, their points are kept as they are.
+ */
+PolygonBoundary discretizeLoop(const PathLoop& loop, double max_spacing, double chord_tolerance);
+
+/**@brief Distances (m) along the loop of the points discretizeLoop() places */
+std::vector<double> loopStations(const PathLoop& loop, double max_spacing, double chord_tolerance);
+
+/**@brief Points of a spiral that morphs one loop into the next in a single turn, from the start
+ * of 'from' up to, but leaving out, the start of 'to'.
+ * Each point of either loop, as discretizeLoop() places them, is paired with the closest point of
+ * the other loop, with pairs kept in order around both loops; the spiral blends each pair
+ * linearly, from all 'from' at its start to all 'to' at its end. Both loops must run the same way
+ * round, as the offsets of one boundary do, and 'to' should start at its point closest to the start
+ * of 'from' (see rotateLoop()).
+ */
+PolygonBoundary spiralBetween(const PathLoop& from, const PathLoop& to, double max_spacing,
+                              double chord_tolerance);
+
+} /* namespace godel_process_path */
+#endif /* PATH_PRIMITIVES_H_ */
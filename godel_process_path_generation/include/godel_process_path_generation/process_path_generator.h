@@ -25,6 +25,7 @@
 #ifndef PROCESS_PATH_GENERATOR_H_
 #define PROCESS_PATH_GENERATOR_H_
 
+#include "godel_process_path_generation/path_primitives.h"
 #include "godel_process_path_generation/polygon_pts.hpp"
 #include "godel_process_path_generation/process_path.h"
 #include "godel_process_path_generation/polygon_utils.h"
@@ -43,18 +44,26 @@ struct ProcessVelocity
   double approach, blending, retract, traverse;
 };
 
+/**@brief Estimate (s) of the time taken to follow the path.
+ * Each move takes its length at the velocity for its kind: blending on the surface (z = 0), approach
+ * down to it, retract up from it and traverse above it. Where the path turns through an angle a, the
+ * tool slows to cos(a) of the velocity, or stops for a >= 90deg, at the given acceleration (m/s^2).
+ */
+double estimateCycleTime(const descartes::ProcessPath& path, const ProcessVelocity& vel, double acceleration);
+
 class ProcessPathGenerator
 {
 public:
   ProcessPathGenerator()
-      : tool_radius_(0.), margin_(0.), overlap_(0.), safe_traverse_height_(-1.), verbose_(false){};
+      : verbose_(false), tool_radius_(0.), margin_(0.), overlap_(0.), safe_traverse_height_(-1.),
+        max_discretization_distance_(0.), chord_tolerance_(0.), spiral_(false){};
   virtual ~ProcessPathGenerator(){};
 
   bool createProcessPath();
   const descartes::ProcessPath& getProcessPath() const { return process_path_; }
 
   /**@brief Set data used by path generator.
-   * Note: Polygons data may become rotated during processing, but order will remain consistent.
+   * The polygons are joined as loops of lines; see setPathLoops().
    * @param polygons Pointer to collection of polygons that will be joined into ProcessPath
    * @param offset_depths Offset distance of each polygon
    */
@@ -66,17 +75,50 @@ public:
       return false;
     }
 
-    path_polygons_ = polygons;
+    path_loops_.clear();
+    for (const PolygonBoundary& polygon : *polygons)
+    {
+      path_loops_.push_back(toPathLoop(polygon));
+    }
+    path_offsets_ = *offset_depths;
+    return true;
+  }
+
+  /**@brief Set data used by path generator, as the lines and arcs the offsets are made of.
+   * Loops are only discretized while the ProcessPath is created, under the discretization distance
+   * and chord tolerance.
+   * @param loops Collection of closed loops that will be joined into ProcessPath
+   * @param offset_depths Offset distance of each loop
+   */
+  bool setPathLoops(const PathLoopCollection& loops, const std::vector<double>& offset_depths)
+  {
+    for (const PathLoop& loop : loops)
+    {
+      if (!isClosed(loop))
+      {
+        ROS_WARN("Malformed path loops detected.");
+        return false;
+      }
+    }
+
+    path_loops_ = loops;
     path_offsets_ = offset_depths;
     return true;
   }
 
+  /**@brief (m) Max distance between adjacent points; 0 places points at the ends of lines only */
   void setDiscretizationDistance(double d) { max_discretization_distance_ = std::abs(d); }
+  /**@brief (m) Max distance of the chords arcs are discretized to from the arcs; 0 for none */
+  void setChordTolerance(double tolerance) { chord_tolerance_ = std::abs(tolerance); }
   void setMargin(double margin) { margin_ = margin; }
   void setOverlap(double overlap) { overlap_ = overlap; }
   void setToolRadius(double radius) { tool_radius_ = std::abs(radius); }
   void setTraverseHeight(double height) { safe_traverse_height_ = height; }
   void setVelocity(const ProcessVelocity& vel) { velocity_ = vel; }
+  /**@brief Blend each loop into the one it steps out to along a spiral (see spiralBetween()), so
+   * that a region is one continuous pass with no step outs or seams. Otherwise each loop is closed
+   * and joined to the next by a straight step out. */
+  void setSpiral(bool spiral) { spiral_ = spiral; }
 
   /**@brief Check if values of offset variables are acceptable */
   bool variables_ok() const
@@ -94,8 +136,8 @@ private:
   // TODO comment Does not add start/end
   void addInterpolatedProcessPts(const ProcessPt& start, const ProcessPt& end);
 
-  // TODO comment
-  void addPolygonToProcessPath(const PolygonBoundary& bnd);
+  /**@brief Discretize a loop and add it to the ProcessPath, ending where it starts if 'close' */
+  void addLoopToProcessPath(const PathLoop& loop, bool close = true);
 
   // TODO comment
   void addTraverseToProcessPath(const PolygonPt& from, const PolygonPt& to);
@@ -120,9 +162,11 @@ private:
   double
       max_discretization_distance_; /**<(m) When discretizing segments, use this or less distance
                                        between points */
+  double chord_tolerance_; /**<(m) When discretizing arcs, stay this close to them or closer */
+  bool spiral_;            /**<Spiral from each loop to the next instead of stepping out */
 
-  PolygonBoundaryCollection* path_polygons_;
-  const std::vector<double>* path_offsets_;
+  PathLoopCollection path_loops_;
+  std::vector<double> path_offsets_;
 
   descartes::ProcessPath process_path_;
   ProcessVelocity velocity_; /**<Velocities for different types of path movements */
@@ -0,0 +1,63 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2014, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef PROCESS_PATH_GENERATOR_SERVICE_H_
+#define PROCESS_PATH_GENERATOR_SERVICE_H_
+
+#include <godel_msgs/OffsetBoundary.h>
+#include <godel_msgs/PathPlanning.h>
+#include <godel_utils/intra_process.h>
+#include <ros/node_handle.h>
+
+namespace godel_process_path
+{
+
+const static std::string PATH_GENERATION_SERVICE = "process_path_generator";
+const static std::string OFFSET_POLYGON_SERVICE = "offset_polygon";
+
+/**
+ * @brief The process_path_generator service: turns the boundaries of a surface into a blending
+ * path, offsetting them with the offset_polygon service. Served by process_path_generator_node
+ * and by its nodelet; callers and the polygon offsetter in the same process are called directly.
+ */
+class ProcessPathGeneratorService
+{
+public:
+  /**
+   * @brief Reads the path parameters from 'pnh' and advertises the service on 'nh'. With
+   * 'blending_plan/spiral_paths' set, each region is blended in one continuous pass that spirals
+   * from loop to loop instead of stepping out between closed loops; it is off by default.
+   */
+  ProcessPathGeneratorService(ros::NodeHandle& nh, ros::NodeHandle& pnh);
+
+  ProcessPathGeneratorService(const ProcessPathGeneratorService&) = delete;
+  ProcessPathGeneratorService& operator=(const ProcessPathGeneratorService&) = delete;
+
+  bool pathGen(godel_msgs::PathPlanningRequest& req, godel_msgs::PathPlanningResponse& res);
+
+  std::string getService() const { return server_.getService(); }
+
+private:
+  godel_utils::intra_process::ServiceClient<godel_msgs::OffsetBoundary> offset_client_;
+  godel_utils::intra_process::ServiceServer<godel_msgs::PathPlanning> server_;
+  bool spiral_paths_;
+};
+
+} // namespace godel_process_path
+
+#endif // PROCESS_PATH_GENERATOR_SERVICE_H_
@@ -32,7 +32,9 @@
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/foreach.hpp>
 #include <geometry_msgs/Polygon.h>
+#include <godel_msgs/PathLoop.h>
 #include <visualization_msgs/MarkerArray.h>
+#include "godel_process_path_generation/path_primitives.h"
 #include "godel_process_path_generation/polygon_pts.hpp"
 
 using std::cos;
@@ -157,6 +159,65 @@ inline void geometryMsgsToGodel(godel_process_path::PolygonBoundaryCollection& p
   }
 }
 
+/**@brief Convert a godel type to a godel_msgs type. This function operates on
+ * PathLoopCollection and vector<PathLoop>.
+ * @param loops_msg vector of PathLoops populated from PathLoopCollection. Z-values are zero.
+ * @param loops Collection of PathLoops.
+ */
+inline void godelToGodelMsgs(std::vector<godel_msgs::PathLoop>& loops_msg,
+                             const godel_process_path::PathLoopCollection& loops)
+{
+  loops_msg.clear();
+  BOOST_FOREACH (const ::godel_process_path::PathLoop& loop, loops)
+  {
+    godel_msgs::PathLoop loop_msg;
+    BOOST_FOREACH (const godel_process_path::PathPrimitive& p, loop)
+    {
+      godel_msgs::PathPrimitive p_msg;
+      p_msg.type = p.type == godel_process_path::PathPrimitive::ARC ? godel_msgs::PathPrimitive::ARC
+                                                                     : godel_msgs::PathPrimitive::LINE;
+      p_msg.start.x = p.start.x;
+      p_msg.start.y = p.start.y;
+      p_msg.end.x = p.end.x;
+      p_msg.end.y = p.end.y;
+      p_msg.center.x = p.center.x;
+      p_msg.center.y = p.center.y;
+      p_msg.ccw = p.ccw;
+      loop_msg.primitives.push_back(p_msg);
+    }
+    loops_msg.push_back(loop_msg);
+  }
+}
+
+/**@brief Convert a godel_msgs type to a godel type. This function operates on vector<PathLoop>
+ * and PathLoopCollection.
+ * @param loops Collection of PathLoops.
+ * @param loops_msg vector of PathLoops. Z-values are ignored.
+ */
+inline void godelMsgsToGodel(godel_process_path::PathLoopCollection& loops,
+                             const std::vector<godel_msgs::PathLoop>& loops_msg)
+{
+  loops.clear();
+  BOOST_FOREACH (const godel_msgs::PathLoop& loop_msg, loops_msg)
+  {
+    godel_process_path::PathLoop loop;
+    BOOST_FOREACH (const godel_msgs::PathPrimitive& p_msg, loop_msg.primitives)
+    {
+      const godel_process_path::PolygonPt start(p_msg.start.x, p_msg.start.y), end(p_msg.end.x, p_msg.end.y);
+      if (p_msg.type == godel_msgs::PathPrimitive::ARC)
+      {
+        const godel_process_path::PolygonPt center(p_msg.center.x, p_msg.center.y);
+        loop.push_back(godel_process_path::PathPrimitive::arc(start, end, center, p_msg.ccw));
+      }
+      else
+      {
+        loop.push_back(godel_process_path::PathPrimitive::line(start, end));
+      }
+    }
+    loops.push_back(loop);
+  }
+}
+
 /**@brief Convert a godel type to a visualization_msg type. This function operates on
  * PolygonBoundary and Marker.
  * Creates a line list with default color and 1mm thickness.
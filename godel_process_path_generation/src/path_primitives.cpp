@@ -0,0 +1,387 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2016, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * path_primitives.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include "godel_process_path_generation/path_primitives.h"
+
+namespace godel_process_path
+{
+
+const static double MIN_LENGTH = 1e-12;          // (m) shorter primitives are dropped
+const static double PIECE_SLACK = 1e-6;          // keeps a piece of exactly max_spacing whole
+const static double MAX_CHORD_ANGLE = M_PI / 2.; // (rad) largest turn of an arc a chord may span
+
+// Number of pieces discretizeLoop() splits a primitive into
+static size_t countPieces(const PathPrimitive& p, double max_spacing, double chord_tolerance)
+{
+  const double len = p.length();
+  double pieces = 1.;
+  if (max_spacing > 0.)
+  {
+    pieces = std::max(pieces, std::ceil(len / max_spacing - PIECE_SLACK));
+  }
+  if (p.type == PathPrimitive::ARC)
+  {
+    const double turn = std::abs(p.sweep());
+    pieces = std::max(pieces, std::ceil(turn / MAX_CHORD_ANGLE - PIECE_SLACK));
+    // A chord spanning an angle a lies r * (1 - cos(a / 2)) from the arc at most
+    const double r = p.radius();
+    if (chord_tolerance > 0. && chord_tolerance < r)
+    {
+      const double max_angle = 2. * std::acos(1. - chord_tolerance / r);
+      pieces = std::max(pieces, std::ceil(turn / max_angle - PIECE_SLACK));
+    }
+  }
+  return static_cast<size_t>(pieces);
+}
+
+PathPrimitive PathPrimitive::line(const PolygonPt& start, const PolygonPt& end)
+{
+  PathPrimitive p;
+  p.type = LINE;
+  p.start = start;
+  p.end = end;
+  p.center = start;
+  return p;
+}
+
+PathPrimitive PathPrimitive::arc(const PolygonPt& start, const PolygonPt& end, const PolygonPt& center,
+                                 bool ccw)
+{
+  PathPrimitive p;
+  p.type = ARC;
+  p.start = start;
+  p.end = end;
+  p.center = center;
+  p.ccw = ccw;
+  return p;
+}
+
+double PathPrimitive::sweep() const
+{
+  if (type == LINE)
+  {
+    return 0.;
+  }
+
+  // As discretizeArc2D() measures it
+  const PolygonPt u = start - center, v = end - center;
+  double theta = std::atan2(u.cross(v), u.dot(v));
+  if (theta < 0. && ccw)
+  {
+    theta += 2. * M_PI;
+  }
+  else if (theta > 0. && !ccw)
+  {
+    theta -= 2. * M_PI;
+  }
+  return theta;
+}
+
+double PathPrimitive::length() const
+{
+  return type == LINE ? start.dist(end) : std::abs(sweep()) * radius();
+}
+
+PolygonPt PathPrimitive::pointAt(double s) const
+{
+  const double len = length();
+  if (len < MIN_LENGTH)
+  {
+    return start;
+  }
+  const double t = std::min(std::max(s / len, 0.), 1.);
+  if (type == LINE)
+  {
+    return start + (end - start) * t;
+  }
+
+  const double angle = t * sweep();
+  const PolygonPt u = start - center;
+  return center + PolygonPt(std::cos(angle) * u.x - std::sin(angle) * u.y,
+                            std::sin(angle) * u.x + std::cos(angle) * u.y);
+}
+
+double PathPrimitive::project(const PolygonPt& pt) const
+{
+  const double len = length();
+  if (len < MIN_LENGTH)
+  {
+    return 0.;
+  }
+  if (type == LINE)
+  {
+    const PolygonPt d = end - start;
+    return std::min(std::max((pt - start).dot(d) / d.norm2(), 0.), 1.) * len;
+  }
+
+  // Angle from the start to pt, in the direction the arc turns
+  const PolygonPt u = start - center, w = pt - center;
+  double angle = std::atan2(u.cross(w), u.dot(w));
+  if (!ccw)
+  {
+    angle = -angle;
+  }
+  if (angle < 0.)
+  {
+    angle += 2. * M_PI;
+  }
+  if (angle * radius() <= len)
+  {
+    return angle * radius();
+  }
+  return pt.dist2(start) <= pt.dist2(end) ? 0. : len;
+}
+
+PathLoop toPathLoop(const PolygonBoundary& polygon)
+{
+  PathLoop loop;
+  for (size_t ii = 0; ii < polygon.size(); ++ii)
+  {
+    loop.push_back(PathPrimitive::line(polygon[ii], polygon[(ii + 1) % polygon.size()]));
+  }
+  return loop;
+}
+
+bool isClosed(const PathLoop& loop, double tolerance)
+{
+  if (loop.empty())
+  {
+    return false;
+  }
+  for (size_t ii = 0; ii < loop.size(); ++ii)
+  {
+    if (loop[ii].end.dist(loop[(ii + 1) % loop.size()].start) > tolerance)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+double loopLength(const PathLoop& loop)
+{
+  double len = 0.;
+  for (const PathPrimitive& p : loop)
+  {
+    len += p.length();
+  }
+  return len;
+}
+
+double distanceToLoop(const PolygonPt& pt, const PathLoop& loop)
+{
+  double dist = std::numeric_limits<double>::max();
+  for (const PathPrimitive& p : loop)
+  {
+    dist = std::min(dist, pt.dist(p.pointAt(p.project(pt))));
+  }
+  return dist;
+}
+
+PolygonPt loopPointAt(const PathLoop& loop, double s)
+{
+  for (const PathPrimitive& p : loop)
+  {
+    const double len = p.length();
+    if (s <= len)
+    {
+      return p.pointAt(s);
+    }
+    s -= len;
+  }
+  return loop.empty() ? PolygonPt(0., 0.) : loop.front().start;
+}
+
+double loopProject(const PathLoop& loop, const PolygonPt& pt)
+{
+  double s = 0., closest_s = 0., closest_dist2 = std::numeric_limits<double>::max();
+  for (const PathPrimitive& p : loop)
+  {
+    const double along = p.project(pt);
+    const double dist2 = pt.dist2(p.pointAt(along));
+    if (dist2 < closest_dist2)
+    {
+      closest_s = s + along;
+      closest_dist2 = dist2;
+    }
+    s += p.length();
+  }
+  return closest_s;
+}
+
+void rotateLoop(PathLoop& loop, const PolygonPt& pt)
+{
+  if (loop.empty())
+  {
+    return;
+  }
+
+  size_t closest = 0;
+  double closest_s = 0., closest_dist2 = std::numeric_limits<double>::max();
+  for (size_t ii = 0; ii < loop.size(); ++ii)
+  {
+    const double s = loop[ii].project(pt);
+    const double dist2 = pt.dist2(loop[ii].pointAt(s));
+    if (dist2 < closest_dist2)
+    {
+      closest = ii;
+      closest_s = s;
+      closest_dist2 = dist2;
+    }
+  }
+
+  // Split the closest primitive into the part before the point, which ends the loop, and the
+  // part after it, which starts it
+  const PathPrimitive split = loop[closest];
+  const PolygonPt p = split.pointAt(closest_s);
+  PathPrimitive before = split, after = split;
+  before.end = p;
+  after.start = p;
+
+  PathLoop rotated;
+  rotated.reserve(loop.size() + 1);
+  if (after.length() > MIN_LENGTH)
+  {
+    rotated.push_back(after);
+  }
+  rotated.insert(rotated.end(), loop.begin() + closest + 1, loop.end());
+  rotated.insert(rotated.end(), loop.begin(), loop.begin() + closest);
+  if (before.length() > MIN_LENGTH)
+  {
+    rotated.push_back(before);
+  }
+  loop.swap(rotated);
+}
+
+PolygonBoundary discretizeLoop(const PathLoop& loop, double max_spacing, double chord_tolerance)
+{
+  PolygonBoundary pts;
+  for (const PathPrimitive& p : loop)
+  {
+    const double len = p.length();
+    if (len < MIN_LENGTH)
+    {
+      continue;
+    }
+
+    const size_t pieces = countPieces(p, max_spacing, chord_tolerance);
+    pts.push_back(p.start);
+    for (size_t ii = 1; ii < pieces; ++ii)
+    {
+      pts.push_back(p.pointAt(len * static_cast<double>(ii) / static_cast<double>(pieces)));
+    }
+  }
+  return pts;
+}
+
+std::vector<double> loopStations(const PathLoop& loop, double max_spacing, double chord_tolerance)
+{
+  std::vector<double> stations;
+  double s = 0.;
+  for (const PathPrimitive& p : loop)
+  {
+    const double len = p.length();
+    if (len >= MIN_LENGTH)
+    {
+      const size_t pieces = countPieces(p, max_spacing, chord_tolerance);
+      for (size_t ii = 0; ii < pieces; ++ii)
+      {
+        stations.push_back(s + len * static_cast<double>(ii) / static_cast<double>(pieces));
+      }
+    }
+    s += len;
+  }
+  return stations;
+}
+
+PolygonBoundary spiralBetween(const PathLoop& from, const PathLoop& to, double max_spacing,
+                              double chord_tolerance)
+{
+  const double from_len = loopLength(from), to_len = loopLength(to);
+  if (from_len < MIN_LENGTH || to_len < MIN_LENGTH)
+  {
+    return PolygonBoundary();
+  }
+
+  // Distance along 'to' paired with each station of 'from': that of its closest point, unwrapped
+  // across the start of 'to' and never running backwards
+  typedef std::pair<double, double> Pairing; // (m) along 'from', along 'to'
+  std::vector<Pairing> pairs;
+  const std::vector<double> from_stations = loopStations(from, max_spacing, chord_tolerance);
+  for (double s : from_stations)
+  {
+    double t = 0.;
+    if (!pairs.empty())
+    {
+      const double last = pairs.back().second;
+      t = loopProject(to, loopPointAt(from, s));
+      if (t > last + 0.5 * to_len)
+      {
+        t -= to_len;
+      }
+      else if (t < last - 0.5 * to_len)
+      {
+        t += to_len;
+      }
+      t = std::min(std::max(t, last), to_len);
+    }
+    pairs.push_back(Pairing(s, t));
+  }
+  pairs.push_back(Pairing(from_len, to_len));
+
+  // Stations of 'to' are paired by interpolating along 'from' between the pairs either side
+  std::vector<Pairing> blended = pairs;
+  size_t kk = 0;
+  for (double t : loopStations(to, max_spacing, chord_tolerance))
+  {
+    while (kk + 1 < pairs.size() && pairs[kk + 1].second < t)
+    {
+      ++kk;
+    }
+    if (kk + 1 == pairs.size() || t <= pairs[kk].second)
+    {
+      continue;
+    }
+    const Pairing& a = pairs[kk];
+    const Pairing& b = pairs[kk + 1];
+    blended.push_back(Pairing(a.first + (b.first - a.first) * (t - a.second) / (b.second - a.second), t));
+  }
+  std::sort(blended.begin(), blended.end());
+
+  PolygonBoundary pts;
+  for (size_t ii = 0; ii + 1 < blended.size(); ++ii)
+  {
+    const double s = blended[ii].first, t = blended[ii].second;
+    if (ii > 0 && s - blended[ii - 1].first < MIN_LENGTH && t - blended[ii - 1].second < MIN_LENGTH)
+    {
+      continue;
+    }
+    const double u = 0.5 * (s / from_len + t / to_len);
+    pts.push_back(loopPointAt(from, s) * (1. - u) + loopPointAt(to, t) * u);
+  }
+  return pts;
+}
+
+} /* namespace godel_process_path */
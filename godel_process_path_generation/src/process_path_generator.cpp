@@ -44,7 +44,7 @@ void ProcessPathGenerator::addInterpolatedProcessPts(const ProcessPt& start, con
   const Eigen::Affine3d& p1 = start.pose();
   const Eigen::Affine3d& p2 = end.pose();
   double sep = (p2.translation() - p1.translation()).norm();
-  if (sep > max_discretization_distance_)
+  if (max_discretization_distance_ > 0. && sep > max_discretization_distance_)
   {
     size_t new_ptcnt = static_cast<size_t>(std::ceil(sep / max_discretization_distance_) - 1.);
     for (size_t ii = 1; ii <= new_ptcnt; ++ii)
@@ -61,10 +61,13 @@ void ProcessPathGenerator::addInterpolatedProcessPts(const ProcessPt& start, con
   }
 }
 
-void ProcessPathGenerator::addPolygonToProcessPath(const PolygonBoundary& bnd_ref)
+void ProcessPathGenerator::addLoopToProcessPath(const PathLoop& loop, bool close)
 {
-  PolygonBoundary bnd = bnd_ref;
-  bnd.push_back(bnd.front());
+  PolygonBoundary bnd = discretizeLoop(loop, max_discretization_distance_, chord_tolerance_);
+  if (close)
+  {
+    bnd.push_back(bnd.front());
+  }
   ProcessPt process_pt;
   BOOST_FOREACH (const PolygonPt& pg_pt, bnd)
   {
@@ -109,13 +112,13 @@ bool ProcessPathGenerator::createProcessPath()
   /* Create a series of polygons to represent the paths for blending
    * Polygons are ordered so as to begin at most inner, spiral out to most outer,
    *  jump to next incomplete inner, spiral out to largest incomplete outer, etc. */
-  if (!path_polygons_ || !path_offsets_)
+  if (path_loops_.empty() || path_offsets_.empty())
   {
     ROS_WARN("Must set path polygons and path offsets before creating process path.");
     return false;
   }
 
-  if (path_polygons_->size() != path_offsets_->size())
+  if (path_loops_.size() != path_offsets_.size())
   {
     ROS_WARN("Must have identical count of Polygons and Offsets.");
     return false;
@@ -128,7 +131,7 @@ bool ProcessPathGenerator::createProcessPath()
   // Add approach vector
   process_path_.clear();
   ProcessPt approach, start;
-  const PolygonPt& first = *(path_polygons_->begin()->begin());
+  const PolygonPt first = path_loops_.front().front().start;
 
   approach.setPosePosition(first.x, first.y, safe_traverse_height_);
   start << first;
@@ -139,41 +142,66 @@ bool ProcessPathGenerator::createProcessPath()
   // Do all loops until last
   double current_offset = std::numeric_limits<double>::max();
   size_t pgIdx(0);
-  while (pgIdx < path_polygons_->size() - 1)
+  bool spiralled_in = false; /*the path is already at the start of the current loop, and in it*/
+  while (pgIdx < path_loops_.size() - 1)
   {
-    current_offset = path_offsets_->at(pgIdx);
-    const PolygonBoundary& polygon = path_polygons_->at(pgIdx);
-    addPolygonToProcessPath(polygon);
+    current_offset = path_offsets_.at(pgIdx);
+    const PathLoop& loop = path_loops_.at(pgIdx);
+    const PolygonPt last_pgpt = loop.front().start; // Each loop ends where it starts
+    PathLoop& next_loop = path_loops_.at(pgIdx + 1);
+    const bool step_out = path_offsets_.at(pgIdx + 1) < current_offset;
+    if (step_out)
+    {
+      rotateLoop(next_loop, last_pgpt);
+    }
+
+    if (spiral_ && step_out)
+    { /*Go round the loop once, unless spiralling out of the one before it, then spiral out*/
+      if (!spiralled_in)
+      {
+        addLoopToProcessPath(loop, false);
+        ROS_INFO_COND(verbose_, "Added polygon %li to process path.", pgIdx);
+      }
+      ProcessPt process_pt;
+      BOOST_FOREACH (const PolygonPt& pg_pt,
+                     spiralBetween(loop, next_loop, max_discretization_distance_, chord_tolerance_))
+      {
+        process_pt << pg_pt;
+        process_path_.addPoint(process_pt);
+      }
+      spiralled_in = true;
+      ROS_INFO_COND(verbose_, "Added spiral to polygon %li.", pgIdx + 1);
+      ++pgIdx;
+      continue;
+    }
+
+    addLoopToProcessPath(loop);
+    spiralled_in = false;
     ROS_INFO_COND(verbose_, "Added polygon %li to process path.", pgIdx);
 
-    const PolygonPt last_pgpt = polygon.front(); // Each polygon ends where it starts
     ProcessPt last_pt;
     last_pt << last_pgpt;
 
     ++pgIdx;
-    PolygonBoundary& next_polygon = path_polygons_->at(pgIdx);
-
-    if (path_offsets_->at(pgIdx) < current_offset)
-    { /*Take one step out*/
-      size_t rotate_index = polygon_utils::closestPoint(last_pgpt, next_polygon).first;
-      std::rotate(next_polygon.begin(), next_polygon.begin() + rotate_index, next_polygon.end());
+    if (step_out)
+    { /*Take one step out, to the closest point of the next loop*/
       ProcessPt next_pt;
-      next_pt << next_polygon.front();
+      next_pt << next_loop.front().start;
       addInterpolatedProcessPts(last_pt, next_pt);
       ROS_INFO_COND(verbose_, "Added connection to polygon %li.", pgIdx);
     }
     else
     {
-      addTraverseToProcessPath(last_pgpt, next_polygon.front());
+      addTraverseToProcessPath(last_pgpt, next_loop.front().start);
       ROS_INFO_COND(verbose_, "Added traverse to polygon %li.", pgIdx);
     }
   }
 
   // Add last loop and retract
-  const PolygonBoundary& polygon = path_polygons_->at(pgIdx);
-  addPolygonToProcessPath(polygon);
+  const PathLoop& loop = path_loops_.at(pgIdx);
+  addLoopToProcessPath(loop);
   ROS_INFO_COND(verbose_, "Added polygon %li to process path.", pgIdx);
-  const PolygonPt last_pgpt = polygon.front();
+  const PolygonPt last_pgpt = loop.front().start;
   ProcessPt last, retract;
   last << last_pgpt;
   retract.setPosePosition(last_pgpt.x, last_pgpt.y, safe_traverse_height_);
@@ -185,4 +213,54 @@ bool ProcessPathGenerator::createProcessPath()
   return true;
 }
 
+double estimateCycleTime(const descartes::ProcessPath& path, const ProcessVelocity& vel, double acceleration)
+{
+  const std::vector<ProcessPt> pts = path.data().first;
+  const double ON_SURFACE = 1e-9; // (m)
+  double time = 0., last_vel = 0.;
+  Eigen::Vector3d last_dir = Eigen::Vector3d::Zero();
+  for (size_t ii = 1; ii < pts.size(); ++ii)
+  {
+    const Eigen::Vector3d& a = pts[ii - 1].pose().translation();
+    const Eigen::Vector3d& b = pts[ii].pose().translation();
+    const Eigen::Vector3d move = b - a;
+    const double len = move.norm();
+    if (len < ON_SURFACE)
+    {
+      continue;
+    }
+
+    double v = vel.traverse;
+    if (std::abs(a.z()) < ON_SURFACE && std::abs(b.z()) < ON_SURFACE)
+    {
+      v = vel.blending;
+    }
+    else if (b.z() < a.z() - ON_SURFACE)
+    {
+      v = vel.approach;
+    }
+    else if (b.z() > a.z() + ON_SURFACE)
+    {
+      v = vel.retract;
+    }
+    if (v <= 0.)
+    {
+      return std::numeric_limits<double>::max();
+    }
+    time += len / v;
+
+    // Slowing down into the turn and speeding up out of it, at most as fast as either move goes
+    const Eigen::Vector3d dir = move / len;
+    const double cruise = std::min(v, last_vel);
+    if (acceleration > 0. && cruise > 0.)
+    {
+      const double slowed = cruise * std::max(0., last_dir.dot(dir));
+      time += (cruise - slowed) * (cruise - slowed) / (acceleration * cruise);
+    }
+    last_dir = dir;
+    last_vel = v;
+  }
+  return time;
+}
+
 } /* namespace godel_process_path */
@@ -0,0 +1,50 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2014, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <godel_process_path_generation/process_path_generator_service.h>
+#include <godel_utils/tracing.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <memory>
+
+namespace godel_process_path
+{
+
+/**
+ * @brief process_path_generator_node as a nodelet. Unlike the node, it doesn't wait for
+ * offset_polygon: the polygon offset nodelet may be loaded after it.
+ */
+class ProcessPathGeneratorNodelet : public nodelet::Nodelet
+{
+private:
+  virtual void onInit()
+  {
+    if (!godel_utils::tracing::enabled())
+      godel_utils::tracing::initialize(ros::this_node::getName());
+
+    service_.reset(new ProcessPathGeneratorService(getNodeHandle(), getPrivateNodeHandle()));
+    NODELET_INFO("%s ready to service requests.", service_->getService().c_str());
+  }
+
+  std::unique_ptr<ProcessPathGeneratorService> service_;
+};
+
+} // namespace godel_process_path
+
+PLUGINLIB_EXPORT_CLASS(godel_process_path::ProcessPathGeneratorNodelet, nodelet::Nodelet)
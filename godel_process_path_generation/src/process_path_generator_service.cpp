@@ -0,0 +1,147 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2014, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+/*
+ * process_path_generator_service.cpp
+ *
+ *  Created on: May 26, 2014
+ *      Author: Dan Solomon
+ */
+
+#include <ros/ros.h>
+#include <boost/bind.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <godel_process_path_generation/process_path_generator_service.h>
+#include <godel_process_path_generation/utils.h>
+#include <godel_utils/tracing.h>
+#include <godel_process_path_generation/polygon_pts.hpp>
+#include <godel_process_path_generation/process_path_generator.h>
+#include <godel_process_path_generation/process_path.h>
+#include <godel_process_path_generation/polygon_utils.h>
+
+namespace godel_process_path
+{
+
+const static double DISCRETIZATION_DISTANCE = 0.01; // m
+const static double CHORD_TOLERANCE = 0.0005;        // m
+
+typedef godel_utils::intra_process::ServiceClient<godel_msgs::OffsetBoundary> OffsetClient;
+
+namespace
+{
+
+bool generateProcessPlan(descartes::ProcessPath& process_path,
+                         const godel_msgs::PathPlanningRequest& req,
+                         OffsetClient& offset_service_client, bool spiral)
+{
+  // Create ProcessPathGenerator and initialize.
+  godel_process_path::ProcessPathGenerator ppg;
+  ppg.verbose_ = true;
+  ppg.setDiscretizationDistance(DISCRETIZATION_DISTANCE);
+  ppg.setChordTolerance(CHORD_TOLERANCE);
+  ppg.setSpiral(spiral);
+  ppg.setMargin(req.params.margin);
+  ppg.setOverlap(req.params.overlap);
+  ppg.setToolRadius(req.params.tool_radius);
+  ppg.setTraverseHeight(0.0); // Note: We added traverse height to the newer
+                              // 'process_planning' component of our system
+                              // so I set the param to zero here.
+  if (!ppg.variables_ok())
+  {
+    ROS_ERROR("Cannot continue path generation with current variables.");
+    return false;
+  }
+
+  // Call polygon_offset service.
+  godel_msgs::OffsetBoundaryRequest ob_req;
+  godel_msgs::OffsetBoundaryResponse ob_res;
+
+  ob_req.discretization = DISCRETIZATION_DISTANCE;
+  ob_req.initial_offset = req.params.tool_radius + req.params.margin;
+  ob_req.offset_distance = req.params.tool_radius - req.params.overlap;
+  ob_req.polygons = req.surface.boundaries;
+  ob_req.trace = godel_utils::tracing::inject();
+
+  if (!offset_service_client.call(ob_req, ob_res))
+  {
+    ROS_ERROR("Bad response from %s", offset_service_client.getService().c_str());
+    return false;
+  }
+
+  GODEL_TRACE_SPAN("create_process_path");
+
+  // Generate process paths from the lines and arcs of the offsets, which are discretized only
+  // once, here; an offsetter without them only returns polygons.
+  bool paths_set;
+  if (!ob_res.offset_loops.empty())
+  {
+    godel_process_path::PathLoopCollection loops;
+    godel_process_path::utils::translations::godelMsgsToGodel(loops, ob_res.offset_loops);
+    paths_set = ppg.setPathLoops(loops, ob_res.offsets);
+  }
+  else
+  {
+    godel_process_path::PolygonBoundaryCollection paths;
+    godel_process_path::utils::translations::geometryMsgsToGodel(paths, ob_res.offset_polygons);
+    paths_set = ppg.setPathPolygons(&paths, &ob_res.offsets);
+  }
+  if (!paths_set)
+  {
+    ROS_ERROR("Could not set polygon data in path planner.");
+    return false;
+  }
+  if (!ppg.createProcessPath())
+  {
+    ROS_ERROR("Could not create process paths.");
+    return false;
+  }
+  process_path = ppg.getProcessPath();
+
+  return true;
+}
+
+} // namespace
+
+ProcessPathGeneratorService::ProcessPathGeneratorService(ros::NodeHandle& nh, ros::NodeHandle& pnh)
+  : offset_client_(nh, OFFSET_POLYGON_SERVICE)
+{
+  pnh.param("blending_plan/spiral_paths", spiral_paths_, false);
+
+  server_ = godel_utils::intra_process::ServiceServer<godel_msgs::PathPlanning>(
+      nh, PATH_GENERATION_SERVICE, boost::bind(&ProcessPathGeneratorService::pathGen, this, _1, _2));
+}
+
+bool ProcessPathGeneratorService::pathGen(godel_msgs::PathPlanningRequest& req,
+                                          godel_msgs::PathPlanningResponse& res)
+{
+  godel_utils::tracing::Span span("process_path_generator", req.trace);
+
+  // Call function to generate process path.
+  descartes::ProcessPath process_path;
+  generateProcessPlan(process_path, req, offset_client_, spiral_paths_);
+
+  // Populate service response
+  std::vector<descartes::ProcessPt> pts;
+  std::vector<descartes::ProcessTransition> transitions;
+  boost::tie(pts, transitions) = process_path.data();
+
+  res.poses = process_path.asPoseArray();
+
+  return true;
+}
+
+} // namespace godel_process_path
@@ -0,0 +1,173 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Process path generation from offsets around a 5cm square hole, 2cm apart: rectangles with
+ * corners rounded to the offset distance. Polygons is the old path, with lines and arcs
+ * discretized by the offsetter every 1cm and joined at their closest vertices. Primitives carries
+ * the lines and arcs to the generator, which discretizes them once, every 1cm and within 0.5mm of
+ * the arcs. EndpointsOnly leaves straight edges whole. The argument is the number of loops.
+ * Descartes makes one rung of its planning graph per point, so 'points' is what planning time
+ * scales with; 'chord_error_um' is the furthest any edge of the path strays from the offsets.
+ */
+
+#include <benchmark/benchmark.h>
+#include "godel_process_path_generation/path_primitives.h"
+#include "godel_process_path_generation/process_path_generator.h"
+#include "godel_process_path_generation/utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace godel_process_path;
+
+namespace
+{
+
+const static double HOLE_SIZE = 0.05;       // m
+const static double OFFSET_DISTANCE = 0.02; // m
+const static double DISCRETIZATION = 0.01;  // m, as the path generation service uses
+const static double CHORD_TOLERANCE = 0.0005;
+
+PathLoopCollection makeLoops(int count, std::vector<double>& offsets)
+{
+  PathLoopCollection loops;
+  offsets.clear();
+  for (int ii = 0; ii < count; ++ii)
+  {
+    const double r = 0.5 * OFFSET_DISTANCE + ii * OFFSET_DISTANCE;
+    const double h = 0.5 * HOLE_SIZE, e = h + r;
+    PathLoop loop;
+    loop.push_back(PathPrimitive::line(PolygonPt(-h, -e), PolygonPt(h, -e)));
+    loop.push_back(PathPrimitive::arc(PolygonPt(h, -e), PolygonPt(e, -h), PolygonPt(h, -h), true));
+    loop.push_back(PathPrimitive::line(PolygonPt(e, -h), PolygonPt(e, h)));
+    loop.push_back(PathPrimitive::arc(PolygonPt(e, h), PolygonPt(h, e), PolygonPt(h, h), true));
+    loop.push_back(PathPrimitive::line(PolygonPt(h, e), PolygonPt(-h, e)));
+    loop.push_back(PathPrimitive::arc(PolygonPt(-h, e), PolygonPt(-e, h), PolygonPt(-h, h), true));
+    loop.push_back(PathPrimitive::line(PolygonPt(-e, h), PolygonPt(-e, -h)));
+    loop.push_back(PathPrimitive::arc(PolygonPt(-e, -h), PolygonPt(-h, -e), PolygonPt(-h, -h), true));
+    loops.push_back(loop);
+    // Innermost first, stepping out to each next one
+    offsets.push_back(count - ii);
+  }
+  return loops;
+}
+
+ProcessPathGenerator makeGenerator(double spacing)
+{
+  ProcessPathGenerator ppg;
+  ppg.setTraverseHeight(0.);
+  ppg.setToolRadius(0.025);
+  ppg.setOverlap(0.005);
+  ppg.setDiscretizationDistance(spacing);
+  ppg.setChordTolerance(CHORD_TOLERANCE);
+  return ppg;
+}
+
+// Furthest the edges of the path between points on loops stray from them, at their midpoints
+double chordError(const descartes::ProcessPath& path, const PathLoopCollection& loops)
+{
+  const std::vector<descartes::ProcessPt> pts = path.data().first;
+  double error = 0.;
+  for (std::size_t ii = 1; ii < pts.size(); ++ii)
+  {
+    const Eigen::Vector3d a = pts[ii - 1].pose().translation(), b = pts[ii].pose().translation();
+    double on_a = 1., on_b = 1., on_mid = 1.;
+    const Eigen::Vector3d m = 0.5 * (a + b);
+    for (const PathLoop& loop : loops)
+    {
+      on_a = std::min(on_a, distanceToLoop(PolygonPt(a.x(), a.y()), loop));
+      on_b = std::min(on_b, distanceToLoop(PolygonPt(b.x(), b.y()), loop));
+      on_mid = std::min(on_mid, distanceToLoop(PolygonPt(m.x(), m.y()), loop));
+    }
+    // Edges that step out from one loop to the next are not part of either
+    if (on_a < 1e-9 && on_b < 1e-9 && on_mid < OFFSET_DISTANCE / 4.)
+    {
+      error = std::max(error, on_mid);
+    }
+  }
+  return error;
+}
+
+void report(benchmark::State& state, const descartes::ProcessPath& path, const PathLoopCollection& loops)
+{
+  state.counters["points"] = path.data().first.size();
+  state.counters["chord_error_um"] = 1e6 * chordError(path, loops);
+}
+
+void BM_Polygons(benchmark::State& state)
+{
+  std::vector<double> offsets;
+  const PathLoopCollection loops = makeLoops(state.range(0), offsets);
+  PolygonBoundaryCollection polygons;
+  for (const PathLoop& loop : loops)
+  {
+    PolygonBoundary polygon;
+    for (const PathPrimitive& p : loop)
+    {
+      const std::vector<PolygonPt> pts =
+          p.type == PathPrimitive::LINE
+              ? utils::geometry::discretizeLinear(p.start, p.end, DISCRETIZATION)
+              : utils::geometry::discretizeArc2D(p.start, p.end, p.center, p.ccw, DISCRETIZATION);
+      polygon.insert(polygon.end(), pts.begin(), pts.end());
+    }
+    polygons.push_back(polygon);
+  }
+
+  ProcessPathGenerator ppg = makeGenerator(DISCRETIZATION);
+  for (auto _ : state)
+  {
+    PolygonBoundaryCollection copy = polygons;
+    ppg.setPathPolygons(&copy, &offsets);
+    ppg.createProcessPath();
+    benchmark::DoNotOptimize(ppg.getProcessPath());
+  }
+  report(state, ppg.getProcessPath(), loops);
+}
+
+void BM_Primitives(benchmark::State& state, double spacing)
+{
+  std::vector<double> offsets;
+  const PathLoopCollection loops = makeLoops(state.range(0), offsets);
+  ProcessPathGenerator ppg = makeGenerator(spacing);
+  for (auto _ : state)
+  {
+    ppg.setPathLoops(loops, offsets);
+    ppg.createProcessPath();
+    benchmark::DoNotOptimize(ppg.getProcessPath());
+  }
+  report(state, ppg.getProcessPath(), loops);
+}
+
+void BM_PathPrimitives(benchmark::State& state)
+{
+  BM_Primitives(state, DISCRETIZATION);
+}
+
+void BM_PathPrimitivesEndpointsOnly(benchmark::State& state)
+{
+  BM_Primitives(state, 0.);
+}
+
+} // end anon namespace
+
+BENCHMARK(BM_Polygons)->Arg(5)->Arg(20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PathPrimitives)->Arg(5)->Arg(20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PathPrimitivesEndpointsOnly)->Arg(5)->Arg(20)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
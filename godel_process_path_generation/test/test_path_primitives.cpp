@@ -0,0 +1,229 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+/*
+ * test_path_primitives.cpp
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include "godel_process_path_generation/path_primitives.h"
+#include "godel_process_path_generation/process_path_generator.h"
+#include "godel_process_path_generation/utils.h"
+
+using namespace godel_process_path;
+
+namespace
+{
+
+/**@brief A w x h rectangle centred on the origin with corners rounded to radius r, counter-clockwise
+ * from the start of its bottom edge: the shape of an offset around a rectangular hole */
+PathLoop roundedRectangle(double w, double h, double r)
+{
+  const double x0 = -0.5 * w, x1 = 0.5 * w, y0 = -0.5 * h, y1 = 0.5 * h;
+  PathLoop loop;
+  loop.push_back(PathPrimitive::line(PolygonPt(x0 + r, y0), PolygonPt(x1 - r, y0)));
+  loop.push_back(PathPrimitive::arc(PolygonPt(x1 - r, y0), PolygonPt(x1, y0 + r), PolygonPt(x1 - r, y0 + r), true));
+  loop.push_back(PathPrimitive::line(PolygonPt(x1, y0 + r), PolygonPt(x1, y1 - r)));
+  loop.push_back(PathPrimitive::arc(PolygonPt(x1, y1 - r), PolygonPt(x1 - r, y1), PolygonPt(x1 - r, y1 - r), true));
+  loop.push_back(PathPrimitive::line(PolygonPt(x1 - r, y1), PolygonPt(x0 + r, y1)));
+  loop.push_back(PathPrimitive::arc(PolygonPt(x0 + r, y1), PolygonPt(x0, y1 - r), PolygonPt(x0 + r, y1 - r), true));
+  loop.push_back(PathPrimitive::line(PolygonPt(x0, y1 - r), PolygonPt(x0, y0 + r)));
+  loop.push_back(PathPrimitive::arc(PolygonPt(x0, y0 + r), PolygonPt(x0 + r, y0), PolygonPt(x0 + r, y0 + r), true));
+  return loop;
+}
+
+// Largest distance of the closed polygon's edges from the loop, checked at their midpoints
+double maxChordError(const PolygonBoundary& pts, const PathLoop& loop)
+{
+  double error = 0.;
+  for (size_t ii = 0; ii < pts.size(); ++ii)
+  {
+    const PolygonPt mid = (pts[ii] + pts[(ii + 1) % pts.size()]) * 0.5;
+    error = std::max(error, distanceToLoop(mid, loop));
+  }
+  return error;
+}
+
+double maxSpacing(const PolygonBoundary& pts)
+{
+  double spacing = 0.;
+  for (size_t ii = 0; ii < pts.size(); ++ii)
+  {
+    spacing = std::max(spacing, pts[ii].dist(pts[(ii + 1) % pts.size()]));
+  }
+  return spacing;
+}
+
+} // end anon namespace
+
+TEST(PathPrimitives, measuresArcs)
+{
+  const PolygonPt center(1., 1.), start(2., 1.), end(1., 2.);
+  const PathPrimitive quarter = PathPrimitive::arc(start, end, center, true);
+  EXPECT_NEAR(0.5 * M_PI, quarter.sweep(), 1e-12);
+  EXPECT_NEAR(0.5 * M_PI, quarter.length(), 1e-12);
+  const PolygonPt mid = quarter.pointAt(0.25 * M_PI);
+  EXPECT_NEAR(1. + std::sqrt(0.5), mid.x, 1e-12);
+  EXPECT_NEAR(1. + std::sqrt(0.5), mid.y, 1e-12);
+  EXPECT_NEAR(0.25 * M_PI, quarter.project(PolygonPt(3., 3.)), 1e-12);
+  // Beyond the ends of the arc, the closer end
+  EXPECT_NEAR(0., quarter.project(PolygonPt(2., 0.)), 1e-12);
+  EXPECT_NEAR(0.5 * M_PI, quarter.project(PolygonPt(0., 2.5)), 1e-12);
+
+  // The same ends the other way round
+  const PathPrimitive three_quarters = PathPrimitive::arc(start, end, center, false);
+  EXPECT_NEAR(-1.5 * M_PI, three_quarters.sweep(), 1e-12);
+  EXPECT_NEAR(1.5 * M_PI, three_quarters.length(), 1e-12);
+  EXPECT_NEAR(0., three_quarters.pointAt(0.5 * M_PI).x - 1., 1e-12);
+  EXPECT_NEAR(-1., three_quarters.pointAt(0.5 * M_PI).y - 1., 1e-12);
+}
+
+TEST(PathPrimitives, discretizesWithinTolerance)
+{
+  const PathLoop loop = roundedRectangle(0.3, 0.2, 0.04);
+  ASSERT_TRUE(isClosed(loop));
+  EXPECT_NEAR(2. * (0.22 + 0.12) + 2. * M_PI * 0.04, loopLength(loop), 1e-12);
+
+  const double tolerances[] = {1e-3, 1e-4, 1e-5};
+  const double spacings[] = {0.01, 0.};
+  for (double tolerance : tolerances)
+  {
+    for (double spacing : spacings)
+    {
+      const PolygonBoundary pts = discretizeLoop(loop, spacing, tolerance);
+      double on_loop = 0.;
+      for (const PolygonPt& pt : pts)
+      {
+        on_loop = std::max(on_loop, distanceToLoop(pt, loop));
+      }
+      EXPECT_LT(on_loop, 1e-12);
+      EXPECT_LE(maxChordError(pts, loop), tolerance + 1e-12) << "tolerance " << tolerance << ", spacing " << spacing;
+      if (spacing > 0.)
+      {
+        EXPECT_LE(maxSpacing(pts), spacing + 1e-12);
+      }
+      // Corners are where the primitives meet
+      for (const PathPrimitive& p : loop)
+      {
+        EXPECT_TRUE(std::find(pts.begin(), pts.end(), p.start) != pts.end());
+      }
+    }
+  }
+
+  // Without a spacing, straight edges are a single chord
+  const double corner_chords = std::ceil(0.5 * M_PI / (2. * std::acos(1. - 1e-3 / 0.04)));
+  EXPECT_EQ(4u + 4u * static_cast<size_t>(corner_chords), discretizeLoop(loop, 0., 1e-3).size());
+}
+
+TEST(PathPrimitives, keepsTightArcsThatSpacingAloneCuts)
+{
+  // Corners of 4mm radius are shorter than 1cm, so discretizing by spacing leaves one chord each
+  const PathLoop loop = roundedRectangle(0.1, 0.1, 0.004);
+  const double spacing = 0.01, tolerance = 0.0005;
+
+  PolygonBoundary by_spacing;
+  for (const PathPrimitive& p : loop)
+  {
+    const std::vector<PolygonPt> pts =
+        p.type == PathPrimitive::LINE ? utils::geometry::discretizeLinear(p.start, p.end, spacing)
+                                      : utils::geometry::discretizeArc2D(p.start, p.end, p.center, p.ccw, spacing);
+    by_spacing.insert(by_spacing.end(), pts.begin(), pts.end());
+  }
+  EXPECT_GT(maxChordError(by_spacing, loop), 2. * tolerance);
+
+  const PolygonBoundary by_tolerance = discretizeLoop(loop, spacing, tolerance);
+  EXPECT_LE(maxChordError(by_tolerance, loop), tolerance);
+  EXPECT_LE(by_tolerance.size(), by_spacing.size() + 4u);
+}
+
+TEST(PathPrimitives, rotatesToTheClosestPoint)
+{
+  const PathLoop loop = roundedRectangle(0.3, 0.2, 0.04);
+
+  // Beside the middle of the right edge
+  PathLoop rotated = loop;
+  rotateLoop(rotated, PolygonPt(0.2, 0.01));
+  ASSERT_TRUE(isClosed(rotated));
+  EXPECT_EQ(loop.size() + 1, rotated.size());
+  EXPECT_NEAR(0.15, rotated.front().start.x, 1e-12);
+  EXPECT_NEAR(0.01, rotated.front().start.y, 1e-12);
+  EXPECT_NEAR(loopLength(loop), loopLength(rotated), 1e-12);
+
+  // On a corner's arc, and on the loop's own start, which is not split
+  rotated = loop;
+  rotateLoop(rotated, PolygonPt(0.2, 0.2));
+  ASSERT_TRUE(isClosed(rotated));
+  EXPECT_EQ(PathPrimitive::ARC, rotated.front().type);
+  EXPECT_NEAR(0.04, rotated.front().start.dist(rotated.front().center), 1e-12);
+  EXPECT_NEAR(loopLength(loop), loopLength(rotated), 1e-12);
+
+  rotated = loop;
+  rotateLoop(rotated, loop.front().start);
+  EXPECT_EQ(loop.size(), rotated.size());
+  EXPECT_EQ(loop.front().start, rotated.front().start);
+}
+
+TEST(PathPrimitives, generatorStepsOutToTheClosestPoint)
+{
+  // Two offsets 2cm apart around a rectangular hole, inner one first
+  PathLoopCollection loops;
+  loops.push_back(roundedRectangle(0.14, 0.1, 0.01));
+  loops.push_back(roundedRectangle(0.18, 0.14, 0.03));
+  std::vector<double> offsets;
+  offsets.push_back(0.03);
+  offsets.push_back(0.01);
+
+  ProcessPathGenerator ppg;
+  ppg.setTraverseHeight(0.);
+  ppg.setToolRadius(.025);
+  ppg.setOverlap(.005);
+  ppg.setDiscretizationDistance(0.01);
+  ppg.setChordTolerance(1e-4);
+  ASSERT_TRUE(ppg.setPathLoops(loops, offsets));
+  ASSERT_TRUE(ppg.createProcessPath());
+
+  // The step out, from the start of the inner loop straight down to the outer one
+  const PathLoop step(1, PathPrimitive::line(PolygonPt(-0.06, -0.05), PolygonPt(-0.06, -0.07)));
+
+  std::vector<descartes::ProcessPt> pts = ppg.getProcessPath().data().first;
+  double length = 0.;
+  for (size_t ii = 0; ii < pts.size(); ++ii)
+  {
+    const Eigen::Vector3d p = pts[ii].pose().translation();
+    EXPECT_NEAR(0., p.z(), 1e-12);
+    const PolygonPt pt(p.x(), p.y());
+    const double on_path =
+        std::min(std::min(distanceToLoop(pt, loops[0]), distanceToLoop(pt, loops[1])), distanceToLoop(pt, step));
+    EXPECT_LT(on_path, 1e-12) << "at point " << ii;
+    if (ii > 0)
+    {
+      length += (p - pts[ii - 1].pose().translation()).norm();
+    }
+  }
+
+  // Both loops, less what their chords cut off, and the 2cm straight out between them
+  EXPECT_NEAR(loopLength(loops[0]) + loopLength(loops[1]) + 0.02, length, 1e-3);
+  EXPECT_LT(length, loopLength(loops[0]) + loopLength(loops[1]) + 0.02);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
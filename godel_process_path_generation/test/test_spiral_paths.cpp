@@ -0,0 +1,350 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+/*
+ * test_spiral_paths.cpp
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "godel_process_path_generation/path_primitives.h"
+#include "godel_process_path_generation/process_path_generator.h"
+
+using namespace godel_process_path;
+
+namespace
+{
+
+const static double STEP = 0.01;           // (m) between offsets
+const static double DISCRETIZATION = 0.01; // m, as the path generation service uses
+const static double CHORD_TOLERANCE = 0.0005;
+const static double TRAVERSE_HEIGHT = 0.05;
+const static double ACCELERATION = 1.; // m/s^2
+const static double GRID = 0.001;      // (m) spacing of the points coverage is checked at
+
+enum Mode
+{
+  TRAVERSE, /**<every loop on its own, lifting off between them */
+  STEP_OUT, /**<loops joined by a step out, in contact */
+  SPIRAL
+};
+
+/**@brief Inward offset by d of a w x h rectangle with its lower left corner at the origin:
+ * counter-clockwise from the lower left corner, as the offsets of a convex boundary are */
+PathLoop rectangleOffset(double w, double h, double d)
+{
+  PathLoop loop;
+  loop.push_back(PathPrimitive::line(PolygonPt(d, d), PolygonPt(w - d, d)));
+  loop.push_back(PathPrimitive::line(PolygonPt(w - d, d), PolygonPt(w - d, h - d)));
+  loop.push_back(PathPrimitive::line(PolygonPt(w - d, h - d), PolygonPt(d, h - d)));
+  loop.push_back(PathPrimitive::line(PolygonPt(d, h - d), PolygonPt(d, d)));
+  return loop;
+}
+
+/**@brief Inward offset by d of an L made of two 0.2 x 0.1 arms from a corner at the origin. Offsets
+ * keep the convex corners and go round the reflex one at (0.1, 0.1) on an arc of radius d. */
+PathLoop lOffset(double d)
+{
+  PathLoop loop;
+  loop.push_back(PathPrimitive::line(PolygonPt(d, d), PolygonPt(0.2 - d, d)));
+  loop.push_back(PathPrimitive::line(PolygonPt(0.2 - d, d), PolygonPt(0.2 - d, 0.1 - d)));
+  loop.push_back(PathPrimitive::line(PolygonPt(0.2 - d, 0.1 - d), PolygonPt(0.1, 0.1 - d)));
+  loop.push_back(PathPrimitive::arc(PolygonPt(0.1, 0.1 - d), PolygonPt(0.1 - d, 0.1), PolygonPt(0.1, 0.1), false));
+  loop.push_back(PathPrimitive::line(PolygonPt(0.1 - d, 0.1), PolygonPt(0.1 - d, 0.2 - d)));
+  loop.push_back(PathPrimitive::line(PolygonPt(0.1 - d, 0.2 - d), PolygonPt(d, 0.2 - d)));
+  loop.push_back(PathPrimitive::line(PolygonPt(d, 0.2 - d), PolygonPt(d, d)));
+  return loop;
+}
+
+PathLoop shift(PathLoop loop, double dx)
+{
+  for (PathPrimitive& p : loop)
+  {
+    p.start.x += dx;
+    p.end.x += dx;
+    p.center.x += dx;
+  }
+  return loop;
+}
+
+/**@brief The offsets of a region, deepest first as the offsetter orders them */
+struct Region
+{
+  PathLoopCollection loops;
+  std::vector<double> offsets;
+};
+
+Region rectangleRegion()
+{
+  Region region;
+  for (int ii = 6; ii > 0; --ii)
+  {
+    region.loops.push_back(rectangleOffset(0.24, 0.16, ii * STEP));
+    region.offsets.push_back(ii * STEP);
+  }
+  return region;
+}
+
+Region lRegion()
+{
+  Region region;
+  for (int ii = 4; ii > 0; --ii)
+  {
+    region.loops.push_back(lOffset(ii * STEP));
+    region.offsets.push_back(ii * STEP);
+  }
+  return region;
+}
+
+descartes::ProcessPath generate(const Region& region, Mode mode)
+{
+  ProcessPathGenerator ppg;
+  ppg.setTraverseHeight(TRAVERSE_HEIGHT);
+  ppg.setToolRadius(.01);
+  ppg.setOverlap(.01 - STEP);
+  ppg.setDiscretizationDistance(DISCRETIZATION);
+  ppg.setChordTolerance(CHORD_TOLERANCE);
+  ppg.setSpiral(mode == SPIRAL);
+  // Offsets that never get smaller make every loop its own pass
+  const std::vector<double> offsets =
+      mode == TRAVERSE ? std::vector<double>(region.offsets.size(), 0.) : region.offsets;
+  EXPECT_TRUE(ppg.setPathLoops(region.loops, offsets));
+  EXPECT_TRUE(ppg.createProcessPath());
+  return ppg.getProcessPath();
+}
+
+std::vector<Eigen::Vector3d> positions(const descartes::ProcessPath& path)
+{
+  std::vector<Eigen::Vector3d> pts;
+  for (const descartes::ProcessPt& pt : path.data().first)
+  {
+    pts.push_back(pt.pose().translation());
+  }
+  return pts;
+}
+
+// Number of times the path leaves the surface
+size_t countLiftOffs(const std::vector<Eigen::Vector3d>& pts)
+{
+  size_t count = 0;
+  for (size_t ii = 1; ii < pts.size(); ++ii)
+  {
+    count += pts[ii - 1].z() == 0. && pts[ii].z() > 0. ? 1 : 0;
+  }
+  return count;
+}
+
+bool inside(const PolygonPt& pt, const PolygonBoundary& polygon)
+{
+  bool in = false;
+  for (size_t ii = 0, jj = polygon.size() - 1; ii < polygon.size(); jj = ii++)
+  {
+    const PolygonPt &a = polygon[ii], &b = polygon[jj];
+    if ((a.y > pt.y) != (b.y > pt.y) && pt.x < a.x + (b.x - a.x) * (pt.y - a.y) / (b.y - a.y))
+    {
+      in = !in;
+    }
+  }
+  return in;
+}
+
+/**@brief Furthest any point between the innermost and outermost loops of the region is from the
+ * path where it is on the surface: half the largest stepover */
+double maxGap(const std::vector<Eigen::Vector3d>& pts, const Region& region)
+{
+  const PolygonBoundary inner = discretizeLoop(region.loops.front(), 0., CHORD_TOLERANCE);
+  const PolygonBoundary outer = discretizeLoop(region.loops.back(), 0., CHORD_TOLERANCE);
+  double x0 = outer.front().x, x1 = x0, y0 = outer.front().y, y1 = y0;
+  for (const PolygonPt& pt : outer)
+  {
+    x0 = std::min(x0, pt.x);
+    x1 = std::max(x1, pt.x);
+    y0 = std::min(y0, pt.y);
+    y1 = std::max(y1, pt.y);
+  }
+
+  double gap = 0.;
+  for (double x = x0; x <= x1; x += GRID)
+  {
+    for (double y = y0; y <= y1; y += GRID)
+    {
+      const PolygonPt pt(x, y);
+      if (!inside(pt, outer) || inside(pt, inner))
+      {
+        continue;
+      }
+      double dist2 = std::numeric_limits<double>::max();
+      for (size_t ii = 1; ii < pts.size(); ++ii)
+      {
+        if (pts[ii - 1].z() != 0. || pts[ii].z() != 0.)
+        {
+          continue;
+        }
+        const PolygonPt a(pts[ii - 1].x(), pts[ii - 1].y()), b(pts[ii].x(), pts[ii].y());
+        const PolygonPt ab = b - a;
+        const double len2 = ab.norm2();
+        const double t = len2 > 0. ? std::min(std::max((pt - a).dot(ab) / len2, 0.), 1.) : 0.;
+        dist2 = std::min(dist2, pt.dist2(a + ab * t));
+      }
+      gap = std::max(gap, std::sqrt(dist2));
+    }
+  }
+  return gap;
+}
+
+double maxContactSpacing(const std::vector<Eigen::Vector3d>& pts)
+{
+  double spacing = 0.;
+  for (size_t ii = 1; ii < pts.size(); ++ii)
+  {
+    if (pts[ii - 1].z() == 0. && pts[ii].z() == 0.)
+    {
+      spacing = std::max(spacing, (pts[ii] - pts[ii - 1]).norm());
+    }
+  }
+  return spacing;
+}
+
+double cycleTime(const descartes::ProcessPath& path)
+{
+  return estimateCycleTime(path, ProcessVelocity(0.05, 0.1, 0.05, 0.25), ACCELERATION);
+}
+
+void checkSpiral(const Region& region)
+{
+  const descartes::ProcessPath spiral = generate(region, SPIRAL);
+  const descartes::ProcessPath step_out = generate(region, STEP_OUT);
+  const descartes::ProcessPath traverse = generate(region, TRAVERSE);
+  const std::vector<Eigen::Vector3d> pts = positions(spiral);
+
+  // One pass in contact: down at the start, up at the end
+  EXPECT_EQ(1u, countLiftOffs(pts));
+  EXPECT_EQ(region.loops.size(), countLiftOffs(positions(traverse)));
+  EXPECT_EQ(TRAVERSE_HEIGHT, pts.front().z());
+  EXPECT_EQ(TRAVERSE_HEIGHT, pts.back().z());
+  EXPECT_LE(maxContactSpacing(pts), DISCRETIZATION * 1.1);
+
+  // Starts round the innermost loop and ends round the outermost one
+  const PathLoop& inner = region.loops.front();
+  const PathLoop& outer = region.loops.back();
+  size_t ii = 1;
+  for (; ii < pts.size() && distanceToLoop(PolygonPt(pts[ii].x(), pts[ii].y()), inner) < 1e-9; ++ii)
+  {
+  }
+  EXPECT_GE(ii, discretizeLoop(inner, DISCRETIZATION, CHORD_TOLERANCE).size());
+  size_t jj = pts.size() - 2;
+  for (; jj > 0 && distanceToLoop(PolygonPt(pts[jj].x(), pts[jj].y()), outer) < 1e-9; --jj)
+  {
+  }
+  EXPECT_GE(pts.size() - 2 - jj, discretizeLoop(outer, DISCRETIZATION, CHORD_TOLERANCE).size());
+
+  // Stepping over about as far as going round each loop does, which is furthest across the convex
+  // corners: on their diagonal, as far from one loop's corner as from the other loop's edges
+  const double spiral_gap = maxGap(pts, region), loop_gap = maxGap(positions(step_out), region);
+  EXPECT_NEAR((2. - std::sqrt(2.)) * STEP, loop_gap, GRID);
+  EXPECT_LE(spiral_gap, 1.15 * loop_gap);
+
+  // Going round the innermost and outermost loops in full costs the spiral half a turn more than
+  // the loops take, which is less than what lifting off between them costs
+  const double spiral_time = cycleTime(spiral), step_out_time = cycleTime(step_out),
+               traverse_time = cycleTime(traverse);
+  EXPECT_LT(spiral_time, traverse_time);
+  EXPECT_LT(step_out_time, traverse_time);
+  std::cout << "Max stepover (mm): spiral " << 2e3 * spiral_gap << ", loops " << 2e3 * loop_gap << std::endl
+            << "Cycle time (s): spiral " << spiral_time << ", loops with step outs " << step_out_time
+            << ", loops with traverses " << traverse_time << std::endl;
+}
+
+} // end anon namespace
+
+TEST(SpiralPaths, spiralsBetweenLoops)
+{
+  const PathLoop from = rectangleOffset(0.24, 0.16, 0.03);
+  PathLoop to = rectangleOffset(0.24, 0.16, 0.02);
+  rotateLoop(to, from.front().start);
+  const PolygonBoundary spiral = spiralBetween(from, to, DISCRETIZATION, CHORD_TOLERANCE);
+  ASSERT_FALSE(spiral.empty());
+  EXPECT_EQ(from.front().start, spiral.front());
+
+  // Between the loops, moving out from one to the other over the turn
+  for (size_t ii = 0; ii < spiral.size(); ++ii)
+  {
+    const PolygonPt& pt = spiral[ii];
+    EXPECT_LE(distanceToLoop(pt, to), STEP + 1e-12);
+    if (pt.x > 0.03 && pt.x < 0.21 && pt.y > 0.03 && pt.y < 0.13)
+    {
+      ADD_FAILURE() << "Point " << ii << " is inside the first loop";
+    }
+    if (pt.x < 0.02 || pt.x > 0.22 || pt.y < 0.02 || pt.y > 0.14)
+    {
+      ADD_FAILURE() << "Point " << ii << " is outside the second loop";
+    }
+    if (ii > 0)
+    {
+      EXPECT_LE(pt.dist(spiral[ii - 1]), DISCRETIZATION * 1.1);
+    }
+  }
+  const size_t quarter = spiral.size() / 4;
+  EXPECT_LT(distanceToLoop(spiral[quarter], from), distanceToLoop(spiral[quarter], to));
+  EXPECT_GT(distanceToLoop(spiral[3 * quarter], from), distanceToLoop(spiral[3 * quarter], to));
+  EXPECT_LE(spiral.back().dist(to.front().start), DISCRETIZATION);
+}
+
+TEST(SpiralPaths, convexRegion)
+{
+  checkSpiral(rectangleRegion());
+}
+
+TEST(SpiralPaths, concaveRegion)
+{
+  checkSpiral(lRegion());
+}
+
+TEST(SpiralPaths, traversesOnlyBetweenRegions)
+{
+  Region both = rectangleRegion();
+  const Region l = lRegion();
+  for (size_t ii = 0; ii < l.loops.size(); ++ii)
+  {
+    both.loops.push_back(shift(l.loops[ii], 0.5));
+    both.offsets.push_back(l.offsets[ii]);
+  }
+
+  const std::vector<Eigen::Vector3d> pts = positions(generate(both, SPIRAL));
+  EXPECT_EQ(2u, countLiftOffs(pts));
+  // The traverse goes from the last rectangle to the innermost offset of the L
+  for (size_t ii = 1; ii < pts.size(); ++ii)
+  {
+    if (pts[ii - 1].z() == 0. && pts[ii].z() > 0. && pts[ii].x() < 0.3)
+    {
+      EXPECT_LT(distanceToLoop(PolygonPt(pts[ii].x(), pts[ii].y()), both.loops[5]), 1e-9);
+    }
+    if (pts[ii - 1].z() > 0. && pts[ii].z() == 0. && pts[ii].x() > 0.3)
+    {
+      EXPECT_LT(distanceToLoop(PolygonPt(pts[ii].x(), pts[ii].y()), both.loops[6]), 1e-9);
+    }
+  }
+  EXPECT_LT(cycleTime(generate(both, SPIRAL)), cycleTime(generate(both, TRAVERSE)));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
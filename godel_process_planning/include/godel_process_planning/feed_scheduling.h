@@ -0,0 +1,75 @@
+#ifndef GODEL_PROCESS_PLANNING_FEED_SCHEDULING_H
+#define GODEL_PROCESS_PLANNING_FEED_SCHEDULING_H
+
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+
+#include <vector>
+
+/*
+ * Feed scheduling: the speed of the tool along a path, point by point.
+ *
+ * Process paths used to be timed with one speed, which had to be slow enough for the tightest
+ * corner of every path. The scheduler instead limits the speed at each point by the curvature of
+ * the path there, by how fast the tool turns and by how fast the joints of the planned solution
+ * move; then it bounds how quickly the speed may change from point to point with a forward and a
+ * backward pass, so that the tool brakes ahead of a corner and speeds up after it. Paths start
+ * and end at rest.
+ */
+
+namespace godel_process_planning
+{
+typedef std::vector<Eigen::Affine3d, Eigen::aligned_allocator<Eigen::Affine3d> > PoseVector;
+
+/**
+ * @brief Limits of the tool and the robot that the feed is scheduled within
+ */
+struct FeedLimits
+{
+  FeedLimits()
+      : max_speed(0.0), max_acceleration(0.5), max_lateral_acceleration(0.25), max_rotation_speed(1.0)
+  {
+  }
+
+  double max_speed;                       // m/s the tool moves at on straight runs
+  double max_acceleration;                // m/s^2 along the path; 0 for none
+  double max_lateral_acceleration;        // m/s^2 across the path, which limits the speed in curves; 0 for none
+  double max_rotation_speed;              // rad/s the tool may turn at; 0 for none
+  std::vector<double> max_joint_velocity; // rad/s of each joint; empty for none
+};
+
+/**
+ * @brief The speed (m/s) each point may be passed at: the maximum speed, lowered where the path
+ *        curves, where the tool turns and where the joints move quickly, before accelerations
+ *        are accounted for
+ * @param poses The tool poses of the path
+ * @param joints The joint positions of each pose, as planned; empty if there is no plan yet
+ */
+std::vector<double> speedLimits(const PoseVector& poses, const std::vector<std::vector<double> >& joints,
+                                const FeedLimits& limits);
+
+/**
+ * @brief Lowers the speeds so that the tool can brake and accelerate between them at
+ *        'acceleration' (m/s^2), starting and ending at rest
+ */
+void limitAcceleration(const PoseVector& poses, double acceleration, std::vector<double>& speeds);
+
+/**
+ * @brief The time (s) of the move into each point at the given speeds: the speed changes evenly
+ *        along each move, and moves that turn the tool or the joints take at least as long as
+ *        the limits allow. The first point takes 0.
+ */
+std::vector<double> moveDurations(const PoseVector& poses, const std::vector<std::vector<double> >& joints,
+                                  const std::vector<double>& speeds, const FeedLimits& limits);
+
+/**
+ * @brief Schedules the feed along the path
+ * @param poses The tool poses of the path
+ * @param joints The joint positions of each pose, as planned; empty if there is no plan yet
+ * @return The time (s) of the move into each point; 0 for the first
+ */
+std::vector<double> scheduleFeed(const PoseVector& poses, const std::vector<std::vector<double> >& joints,
+                                 const FeedLimits& limits);
+}
+
+#endif // GODEL_PROCESS_PLANNING_FEED_SCHEDULING_H
@@ -7,6 +7,8 @@
 #include <descartes_core/robot_model.h>
 #include <pluginlib/class_loader.h>
 
+#include <future>
+
 /*
  * This class wraps Descartes planning methods and provides functionality for configuration
  * and for planning for blending/scanning paths.
@@ -20,6 +22,9 @@
  * 3. Make a rough plan that moves through these points and solve
  * 4. Replan for the approach and departure using this plan as a 'seed'. Only at this point
  *    are collisions considered.
+ *
+ * The robot models are initialized in the background, so that the services can be advertised
+ * right away; requests that arrive earlier wait for them.
  */
 namespace godel_process_planning
 {
@@ -27,9 +32,21 @@ namespace godel_process_planning
 class ProcessPlanningManager
 {
 public:
+  /**
+   * @brief Creates the robot models and starts initializing them from the 'robot_description'
+   * parameter in the background
+   * @throw std::runtime_error if 'robot_model_plugin' can't be loaded
+   */
   ProcessPlanningManager(const std::string& world_frame, const std::string& blend_group,
                          const std::string& blend_tcp, const std::string& keyence_group,
-                         const std::string& keyence_tcp, const std::string& robot_model_plugin);
+                         const std::string& keyence_tcp, const std::string& robot_model_plugin,
+                         const std::string& robot_description = "robot_description");
+
+  /**
+   * @brief Blocks until the robot models are initialized
+   * @return false if any of them failed to initialize
+   */
+  bool waitForModels();
 
   bool handleBlendPlanning(godel_msgs::BlendProcessPlanning::Request& req,
                            godel_msgs::BlendProcessPlanning::Response& res);
@@ -38,6 +55,9 @@ public:
                              godel_msgs::KeyenceProcessPlanning::Response& res);
 
 private:
+  bool initializeModels(const std::string& robot_description, const std::string& world_frame,
+                        const std::string& blend_tcp, const std::string& keyence_tcp);
+
   descartes_core::RobotModelPtr blend_model_;
   descartes_core::RobotModelPtr keyence_model_;
   moveit::core::RobotModelConstPtr moveit_model_;
@@ -45,6 +65,7 @@ private:
       plugin_loader_; // kept around so code doesn't get unloaded
   std::string blend_group_name_;
   std::string keyence_group_name_;
+  std::shared_future<bool> models_ready_;
 };
 }
 
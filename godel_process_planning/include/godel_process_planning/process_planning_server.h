@@ -0,0 +1,40 @@
+#ifndef GODEL_PROCESS_PLANNING_SERVER_H
+#define GODEL_PROCESS_PLANNING_SERVER_H
+
+#include <godel_process_planning/godel_process_planning.h>
+#include <godel_utils/intra_process.h>
+#include <ros/node_handle.h>
+
+#include <memory>
+
+namespace godel_process_planning
+{
+
+const static std::string DEFAULT_BLEND_PLANNING_SERVICE = "blend_process_planning";
+const static std::string DEFAULT_KEYENCE_PLANNING_SERVICE = "keyence_process_planning";
+
+/**
+ * The blend and keyence process planning services, as run by godel_process_planning_node and by
+ * its nodelet. Callers in the same process, e.g. surface_blending_service loaded into the same
+ * nodelet manager, hand their requests over without serializing them.
+ */
+class ProcessPlanningServer
+{
+public:
+  /**
+   * @brief Reads the planning parameters from 'pnh' and advertises the services on 'nh'. The
+   * robot models keep loading in the background; see ProcessPlanningManager.
+   * @throw std::runtime_error if the parameters are incomplete or the robot model plugin
+   * can't be loaded
+   */
+  ProcessPlanningServer(ros::NodeHandle& nh, ros::NodeHandle& pnh);
+
+private:
+  std::unique_ptr<ProcessPlanningManager> manager_;
+  godel_utils::intra_process::ServiceServer<godel_msgs::BlendProcessPlanning> blend_server_;
+  godel_utils::intra_process::ServiceServer<godel_msgs::KeyenceProcessPlanning> keyence_server_;
+};
+
+} // namespace godel_process_planning
+
+#endif // GODEL_PROCESS_PLANNING_SERVER_H
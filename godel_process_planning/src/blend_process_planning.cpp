@@ -1,4 +1,5 @@
 #include <godel_process_planning/godel_process_planning.h>
+#include <godel_utils/tracing.h>
 
 #include <ros/console.h>
 
@@ -50,6 +51,14 @@ descartes_core::TrajectoryPtPtr toDescartesBlendPt(const Eigen::Affine3d& pose,
 bool ProcessPlanningManager::handleBlendPlanning(godel_msgs::BlendProcessPlanning::Request& req,
                                                  godel_msgs::BlendProcessPlanning::Response& res)
 {
+  godel_utils::tracing::Span span("blend_process_planning", req.trace);
+
+  if (!waitForModels())
+  {
+    ROS_ERROR("%s: Robot models failed to initialize", __FUNCTION__);
+    return false;
+  }
+
   // Enable Collision Checks
   blend_model_->setCheckCollisions(true);
 
@@ -84,11 +93,16 @@ bool ProcessPlanningManager::handleBlendPlanning(godel_msgs::BlendProcessPlannin
   transition_params.traverse_height = req.params.safe_traverse_height;
   transition_params.z_adjust = req.params.z_adjust;
 
-  DescartesTraj process_points = toDescartesTraj(req.path.segments, req.params.traverse_spd, transition_params,
+  // The tool runs at the traverse speed on straight runs and slows down where the path, the tool or
+  // the joints turn quickly
+  FeedLimits feed;
+  feed.max_speed = req.params.traverse_spd;
+
+  DescartesTraj process_points = toDescartesTraj(req.path.segments, feed, transition_params,
                                                  toDescartesBlendPt);
 
   if (generateMotionPlan(blend_model_, process_points, moveit_model_, blend_group_name_,
-                         current_joints, res.plan))
+                         current_joints, feed, res.plan))
   {
     res.plan.type = res.plan.BLEND_TYPE;
     return true;
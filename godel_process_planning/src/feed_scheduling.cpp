@@ -0,0 +1,143 @@
+#include "godel_process_planning/feed_scheduling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+// Moves shorter than this (m) have no direction and don't move the tool along the path
+const static double MIN_MOVE_LENGTH = 1e-9;
+
+double moveLength(const Eigen::Affine3d& a, const Eigen::Affine3d& b)
+{
+  return (b.translation() - a.translation()).norm();
+}
+
+double rotationAngle(const Eigen::Affine3d& a, const Eigen::Affine3d& b)
+{
+  return Eigen::AngleAxisd(a.rotation().transpose() * b.rotation()).angle();
+}
+
+// The shortest time (s) the move from joint positions 'a' to 'b' may take
+double jointTime(const std::vector<double>& a, const std::vector<double>& b, const std::vector<double>& max_velocity)
+{
+  double time = 0.0;
+  for (std::size_t j = 0; j < std::min(max_velocity.size(), std::min(a.size(), b.size())); ++j)
+  {
+    if (max_velocity[j] > 0.0)
+      time = std::max(time, std::abs(b[j] - a[j]) / max_velocity[j]);
+  }
+  return time;
+}
+
+// The shortest time (s) of the move into point i by how fast the tool turns and the joints move
+double minimumMoveTime(const godel_process_planning::PoseVector& poses,
+                       const std::vector<std::vector<double> >& joints, std::size_t i,
+                       const godel_process_planning::FeedLimits& limits)
+{
+  double time = 0.0;
+  if (limits.max_rotation_speed > 0.0)
+    time = rotationAngle(poses[i - 1], poses[i]) / limits.max_rotation_speed;
+  if (joints.size() == poses.size())
+    time = std::max(time, jointTime(joints[i - 1], joints[i], limits.max_joint_velocity));
+  return time;
+}
+
+// The curvature (1/m) of the circle through three points; 0 if they are in a line
+double curvature(const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c)
+{
+  const double ab = (b - a).norm(), bc = (c - b).norm(), ac = (c - a).norm();
+  if (ab < MIN_MOVE_LENGTH || bc < MIN_MOVE_LENGTH || ac < MIN_MOVE_LENGTH)
+    return 0.0;
+  return 2.0 * (b - a).cross(c - b).norm() / (ab * bc * ac);
+}
+
+} // end anon namespace
+
+std::vector<double> godel_process_planning::speedLimits(const PoseVector& poses,
+                                                        const std::vector<std::vector<double> >& joints,
+                                                        const FeedLimits& limits)
+{
+  const std::size_t n = poses.size();
+  std::vector<double> speeds(n, limits.max_speed);
+
+  for (std::size_t i = 1; i < n; ++i)
+  {
+    // A move can't go faster than it may turn the tool and the joints; both of its ends are
+    // passed at that speed at most
+    const double length = moveLength(poses[i - 1], poses[i]);
+    const double time = minimumMoveTime(poses, joints, i, limits);
+    const double speed = length < MIN_MOVE_LENGTH ? 0.0 : time > 0.0 ? length / time : limits.max_speed;
+    speeds[i - 1] = std::min(speeds[i - 1], speed);
+    speeds[i] = std::min(speeds[i], speed);
+  }
+
+  // In a curve of radius r the tool is pulled sideways at v^2 / r
+  if (limits.max_lateral_acceleration > 0.0)
+  {
+    for (std::size_t i = 1; i + 1 < n; ++i)
+    {
+      const double k =
+          curvature(poses[i - 1].translation(), poses[i].translation(), poses[i + 1].translation());
+      if (k > 0.0)
+        speeds[i] = std::min(speeds[i], std::sqrt(limits.max_lateral_acceleration / k));
+    }
+  }
+  return speeds;
+}
+
+void godel_process_planning::limitAcceleration(const PoseVector& poses, double acceleration,
+                                               std::vector<double>& speeds)
+{
+  if (acceleration <= 0.0 || speeds.empty())
+    return;
+
+  speeds.front() = 0.0;
+  speeds.back() = 0.0;
+
+  // Speeding up from each point to the next, then braking from each point to the one before it
+  for (std::size_t i = 1; i < speeds.size(); ++i)
+  {
+    const double length = moveLength(poses[i - 1], poses[i]);
+    speeds[i] = std::min(speeds[i], std::sqrt(speeds[i - 1] * speeds[i - 1] + 2.0 * acceleration * length));
+  }
+  for (std::size_t i = speeds.size() - 1; i > 0; --i)
+  {
+    const double length = moveLength(poses[i - 1], poses[i]);
+    speeds[i - 1] = std::min(speeds[i - 1], std::sqrt(speeds[i] * speeds[i] + 2.0 * acceleration * length));
+  }
+}
+
+std::vector<double> godel_process_planning::moveDurations(const PoseVector& poses,
+                                                          const std::vector<std::vector<double> >& joints,
+                                                          const std::vector<double>& speeds,
+                                                          const FeedLimits& limits)
+{
+  std::vector<double> durations(poses.size(), 0.0);
+  for (std::size_t i = 1; i < poses.size(); ++i)
+  {
+    const double length = moveLength(poses[i - 1], poses[i]);
+    double time = 0.0;
+    if (length >= MIN_MOVE_LENGTH)
+    {
+      const double mean_speed = 0.5 * (speeds[i - 1] + speeds[i]);
+      if (mean_speed > 0.0)
+        time = length / mean_speed;
+      else if (limits.max_acceleration > 0.0)
+        time = 2.0 * std::sqrt(length / limits.max_acceleration); // from rest to rest
+    }
+    durations[i] = std::max(time, minimumMoveTime(poses, joints, i, limits));
+  }
+  return durations;
+}
+
+std::vector<double> godel_process_planning::scheduleFeed(const PoseVector& poses,
+                                                         const std::vector<std::vector<double> >& joints,
+                                                         const FeedLimits& limits)
+{
+  std::vector<double> speeds = speedLimits(poses, joints, limits);
+  limitAcceleration(poses, limits.max_acceleration, speeds);
+  return moveDurations(poses, joints, speeds, limits);
+}
@@ -6,6 +6,7 @@
 
 #include <descartes_planner/ladder_graph_dag_search.h>
 #include <descartes_planner/dense_planner.h>
+#include <godel_utils/tracing.h>
 
 const static bool validateTrajectory(const trajectory_msgs::JointTrajectory& pts,
                                      const descartes_core::RobotModel& model,
@@ -37,17 +38,65 @@ const static bool validateTrajectory(const trajectory_msgs::JointTrajectory& pts
   return true;
 }
 
+// The velocity limit (rad/s or m/s) of each active joint of the group; 0 where it has none
+static std::vector<double> jointVelocityLimits(moveit::core::RobotModelConstPtr moveit_model,
+                                               const std::string& move_group_name)
+{
+  std::vector<double> limits;
+  for (const auto* joint : moveit_model->getJointModelGroup(move_group_name)->getActiveJointModels())
+  {
+    const moveit::core::VariableBounds& bounds = joint->getVariableBounds()[0];
+    limits.push_back(bounds.velocity_bounded_ ? bounds.max_velocity_ : 0.0);
+  }
+  return limits;
+}
+
+/**
+ * @brief Retimes the solution with the feed scheduled along its tool path, now that the joint
+ * motion of each move is known
+ */
+static godel_process_planning::DescartesTraj
+scheduleSolution(const godel_process_planning::DescartesTraj& solution, const descartes_core::RobotModel& model,
+                 const godel_process_planning::FeedLimits& feed)
+{
+  godel_process_planning::PoseVector poses (solution.size());
+  std::vector<std::vector<double>> joints (solution.size());
+  for (std::size_t i = 0; i < solution.size(); ++i)
+  {
+    joints[i] = godel_process_planning::extractJoints(model, *solution[i]);
+    model.getFK(joints[i], poses[i]);
+  }
+
+  const auto durations = godel_process_planning::scheduleFeed(poses, joints, feed);
+
+  godel_process_planning::DescartesTraj scheduled;
+  scheduled.reserve(solution.size());
+  for (std::size_t i = 0; i < solution.size(); ++i)
+  {
+    const descartes_core::TimingConstraint tm = i == 0 ? solution[i]->getTiming()
+                                                       : descartes_core::TimingConstraint(durations[i]);
+    scheduled.push_back(descartes_core::TrajectoryPtPtr(new descartes_trajectory::JointTrajectoryPt(joints[i], tm)));
+  }
+  return scheduled;
+}
+
 bool godel_process_planning::generateMotionPlan(const descartes_core::RobotModelPtr model,
                                                 const std::vector<descartes_core::TrajectoryPtPtr> &traj,
                                                 moveit::core::RobotModelConstPtr moveit_model,
                                                 const std::string &move_group_name,
                                                 const std::vector<double> &start_state,
+                                                const FeedLimits& feed,
                                                 godel_msgs::ProcessPlan &plan)
 {
 
   // Generate a graph of the process path joint solutions
   descartes_planner::PlanningGraph planning_graph (model);
-  if (!planning_graph.insertGraph(traj)) // builds the graph out
+  bool graph_built;
+  {
+    GODEL_TRACE_SPAN("build_planning_graph");
+    graph_built = planning_graph.insertGraph(traj); // builds the graph out
+  }
+  if (!graph_built)
   {
     ROS_ERROR("%s: Failed to build graph. One or more points may have no valid IK solutions", __FUNCTION__);
     return false;
@@ -76,7 +125,11 @@ bool godel_process_planning::generateMotionPlan(const descartes_core::RobotModel
 
   // Now we perform the search using the starting costs from our estimation above
   descartes_planner::DAGSearch search (graph);
-  double cost = search.run(process_start_costs);
+  double cost;
+  {
+    GODEL_TRACE_SPAN("search_planning_graph");
+    cost = search.run(process_start_costs);
+  }
   if (cost == std::numeric_limits<double>::max())
   {
     ROS_ERROR("%s: Failed to search graph. All points have IK, but process constraints (e.g velocity) "
@@ -97,9 +150,21 @@ bool godel_process_planning::generateMotionPlan(const descartes_core::RobotModel
     solution.push_back(pt);
   }
 
+  // Time the process path by the speeds its tool path and joint motion allow
+  FeedLimits joint_feed = feed;
+  if (joint_feed.max_joint_velocity.empty())
+  {
+    joint_feed.max_joint_velocity = jointVelocityLimits(moveit_model, move_group_name);
+  }
+  {
+    GODEL_TRACE_SPAN("schedule_feed");
+    solution = scheduleSolution(solution, *model, joint_feed);
+  }
+
   // Now we plan our approach and depart to/from the path. We try to joint interpolate, and then we run from there
   try
   {
+    GODEL_TRACE_SPAN("plan_approach_depart");
     trajectory_msgs::JointTrajectory approach =
         planFreeMove(*model, move_group_name, moveit_model,
                      start_state,
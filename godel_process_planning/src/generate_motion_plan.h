@@ -4,6 +4,7 @@
 #include <descartes_core/robot_model.h>
 #include <descartes_core/trajectory_pt.h>
 #include <godel_msgs/ProcessPlan.h>
+#include <godel_process_planning/feed_scheduling.h>
 
 namespace godel_process_planning
 {
@@ -17,6 +18,8 @@ namespace godel_process_planning
  * @param moveit_model A moveit robot model corresponding to the robot used
  * @param move_group_name The name of the move group being manipulated
  * @param start_state The initial position of the robot
+ * @param feed The limits the process path is timed within once its joint solution is chosen. If
+ * it has no joint velocity limits, those of \e move_group_name are used.
  * @param plan Output parameter - the approach, process, and departure joint paths.
  * NOTE THAT ProcessPlan::type is NOT set.
  * @return True on planning success, false otherwise
@@ -26,6 +29,7 @@ bool generateMotionPlan(const descartes_core::RobotModelPtr model,
                         moveit::core::RobotModelConstPtr moveit_model,
                         const std::string& move_group_name,
                         const std::vector<double>& start_state,
+                        const FeedLimits& feed,
                         godel_msgs::ProcessPlan& plan);
 
 
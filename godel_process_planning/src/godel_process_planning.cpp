@@ -1,43 +1,76 @@
 #include "godel_process_planning/godel_process_planning.h"
 #include <moveit/robot_model_loader/robot_model_loader.h>
+#include <ros/ros.h>
 
 godel_process_planning::ProcessPlanningManager::ProcessPlanningManager(
     const std::string& world_frame, const std::string& blend_group, const std::string& blend_tcp,
     const std::string& keyence_group, const std::string& keyence_tcp,
-    const std::string& robot_model_plugin)
+    const std::string& robot_model_plugin, const std::string& robot_description)
     : plugin_loader_("descartes_core", "descartes_core::RobotModel"),
       blend_group_name_(blend_group), keyence_group_name_(keyence_group)
 {
-  // Attempt to load and initialize the blending robot model
+  // Attempt to load the blending and scanning/keyence robot models
   blend_model_ = plugin_loader_.createInstance(robot_model_plugin);
-  if (!blend_model_)
+  keyence_model_ = plugin_loader_.createInstance(robot_model_plugin);
+  if (!blend_model_ || !keyence_model_)
   {
     throw std::runtime_error(std::string("Could not load: ") + robot_model_plugin);
   }
 
-  if (!blend_model_->initialize("robot_description", blend_group, world_frame, blend_tcp))
+  // Parsing the description, building the collision models and initializing IK take most of the
+  // startup time, so they happen in the background
+  models_ready_ = std::async(std::launch::async, &ProcessPlanningManager::initializeModels, this,
+                             robot_description, world_frame, blend_tcp, keyence_tcp)
+                      .share();
+}
+
+bool godel_process_planning::ProcessPlanningManager::waitForModels()
+{
+  return models_ready_.get();
+}
+
+bool godel_process_planning::ProcessPlanningManager::initializeModels(
+    const std::string& robot_description, const std::string& world_frame,
+    const std::string& blend_tcp, const std::string& keyence_tcp)
+{
+  const ros::WallTime start = ros::WallTime::now();
+
+  // The moveit model is only used for its joint groups, so it loads without kinematics solvers,
+  // alongside the Descartes models
+  std::future<moveit::core::RobotModelConstPtr> moveit_model =
+      std::async(std::launch::async, [robot_description]() {
+        robot_model_loader::RobotModelLoader::Options options(robot_description);
+        options.load_kinematics_solvers_ = false;
+        robot_model_loader::RobotModelLoader robot_model_loader(options);
+        return moveit::core::RobotModelConstPtr(robot_model_loader.getModel());
+      });
+
+  // The Descartes models initialize one after the other: their IK plugins aren't known to be
+  // thread safe while loading
+  bool ok = true;
+  if (!blend_model_->initialize(robot_description, blend_group_name_, world_frame, blend_tcp))
   {
-    throw std::runtime_error("Unable to initialize blending robot model");
+    ROS_ERROR_STREAM("Unable to initialize blending robot model");
+    ok = false;
   }
-
-  // Attempt to load and initialize the scanning/keyence robot model
-  keyence_model_ = plugin_loader_.createInstance(robot_model_plugin);
-  if (!keyence_model_)
+  else if (!keyence_model_->initialize(robot_description, keyence_group_name_, world_frame,
+                                       keyence_tcp))
   {
-    throw std::runtime_error(std::string("Could not load: ") + robot_model_plugin);
+    ROS_ERROR_STREAM("Unable to initialize scanning robot model");
+    ok = false;
   }
 
-  if (!keyence_model_->initialize("robot_description", keyence_group, world_frame, keyence_tcp))
+  moveit_model_ = moveit_model.get();
+  if (moveit_model_.get() == NULL)
   {
-    throw std::runtime_error("Unable to initialize scanning robot model");
+    ROS_ERROR_STREAM("Could not load moveit robot model");
+    ok = false;
   }
 
-  // Load the moveit model
-  robot_model_loader::RobotModelLoader robot_model_loader("robot_description");
-  moveit_model_ = robot_model_loader.getModel();
-
-  if (moveit_model_.get() == NULL)
+  if (ok)
   {
-    throw std::runtime_error("Could not load moveit robot model");
+    ROS_INFO_STREAM("Process planning robot models ready after "
+                    << (ros::WallTime::now() - start).toSec() << " s");
   }
+  return ok;
 }
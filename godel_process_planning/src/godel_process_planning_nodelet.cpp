@@ -0,0 +1,36 @@
+#include <godel_process_planning/process_planning_server.h>
+#include <godel_utils/tracing.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+namespace godel_process_planning
+{
+
+/**
+ * @brief godel_process_planning_node as a nodelet; takes the same private parameters
+ */
+class ProcessPlanningNodelet : public nodelet::Nodelet
+{
+private:
+  virtual void onInit()
+  {
+    if (!godel_utils::tracing::enabled())
+      godel_utils::tracing::initialize(ros::this_node::getName());
+
+    try
+    {
+      server_.reset(new ProcessPlanningServer(getNodeHandle(), getPrivateNodeHandle()));
+      NODELET_INFO("Godel Process Planning Server Online");
+    }
+    catch (const std::runtime_error& e)
+    {
+      NODELET_ERROR("%s", e.what());
+    }
+  }
+
+  std::unique_ptr<ProcessPlanningServer> server_;
+};
+
+} // namespace godel_process_planning
+
+PLUGINLIB_EXPORT_CLASS(godel_process_planning::ProcessPlanningNodelet, nodelet::Nodelet)
@@ -1,4 +1,5 @@
 #include <godel_process_planning/godel_process_planning.h>
+#include <godel_utils/tracing.h>
 
 #include <ros/console.h>
 
@@ -54,6 +55,14 @@ descartes_core::TrajectoryPtPtr toDescartesScanPt(const Eigen::Affine3d& pose, d
 bool ProcessPlanningManager::handleKeyencePlanning(godel_msgs::KeyenceProcessPlanning::Request& req,
                                                    godel_msgs::KeyenceProcessPlanning::Response& res)
 {
+  godel_utils::tracing::Span span("keyence_process_planning", req.trace);
+
+  if (!waitForModels())
+  {
+    ROS_ERROR("%s: Robot models failed to initialize", __FUNCTION__);
+    return false;
+  }
+
   keyence_model_->setCheckCollisions(true);
   // Precondition: Input trajectory must be non-zero
   if (req.path.segments.empty())
@@ -80,13 +89,16 @@ bool ProcessPlanningManager::handleKeyencePlanning(godel_msgs::KeyenceProcessPla
   transition_params.traverse_height = req.params.approach_distance;
   transition_params.z_adjust = req.params.z_adjust;
 
-  DescartesTraj process_points = toDescartesTraj(req.path.segments, req.params.traverse_spd, transition_params,
+  FeedLimits feed;
+  feed.max_speed = req.params.traverse_spd;
+
+  DescartesTraj process_points = toDescartesTraj(req.path.segments, feed, transition_params,
                                                  toDescartesScanPt);
   // Capture the current state of the robot
   std::vector<double> current_joints = getCurrentJointState(JOINT_TOPIC_NAME);
 
   if (generateMotionPlan(keyence_model_, process_points, moveit_model_, keyence_group_name_,
-                         current_joints, res.plan))
+                         current_joints, feed, res.plan))
   {
     res.plan.type = res.plan.SCAN_TYPE;
     return true;
@@ -141,50 +141,39 @@ using DescartesConversionFunc =
 
 godel_process_planning::DescartesTraj
 godel_process_planning::toDescartesTraj(const std::vector<geometry_msgs::PoseArray> &segments,
-                                        const double process_speed, const TransitionParameters& transition_params,
+                                        const FeedLimits& feed, const TransitionParameters& transition_params,
                                         DescartesConversionFunc conversion_fn)
 {
   auto transitions = generateTransitions(segments, transition_params);
 
-  DescartesTraj traj;
+  PoseVector path;
   Eigen::Affine3d last_pose = createNominalTransform(segments.front().poses.front());
 
   // Convert pose arrays to Eigen types
   auto eigen_segments = toEigenArrays(segments);
 
   // Inline function for adding a sequence of motions
-  auto add_segment = [&traj, &last_pose, process_speed, conversion_fn, transition_params]
-                     (const EigenSTL::vector_Affine3d& poses, bool free_last)
+  auto add_segment = [&path, &last_pose, &feed, transition_params](const EigenSTL::vector_Affine3d& poses)
   {
-    // Create Descartes trajectory for the segment path
     for (std::size_t j = 0; j < poses.size(); ++j)
     {
       Eigen::Affine3d this_pose = createNominalTransform(poses[j], transition_params.z_adjust);
-      // O(1) jerky - may need to revisit this time parameterization later. This at least allows
-      // Descartes to perform some optimizations in its graph serach.
-      double dt = (this_pose.translation() - last_pose.translation()).norm() / process_speed;
-
-      if (dt < 1e-4)
+      if ((this_pose.translation() - last_pose.translation()).norm() / feed.max_speed < 1e-4)
       {
         continue;
       }
-
-      if (j == poses.size() - 1 && free_last)
-      {
-        dt = 0.0;
-      }
-      traj.push_back( conversion_fn(this_pose, dt) );
+      path.push_back(this_pose);
       last_pose = this_pose;
     }
   };
 
   for (std::size_t i = 0; i < segments.size(); ++i)
   {
-    add_segment(transitions[i].approach, false);
+    add_segment(transitions[i].approach);
 
-    add_segment(eigen_segments[i], false);
+    add_segment(eigen_segments[i]);
 
-    add_segment(transitions[i].depart, false);
+    add_segment(transitions[i].depart);
 
     if (i != segments.size() - 1)
     {
@@ -194,9 +183,20 @@ godel_process_planning::toDescartesTraj(const std::vector<geometry_msgs::PoseArr
       auto connection = interpolateCartesian(transitions[i].depart.back(),
                                              closestRotationalPose(transitions[i].depart.back(), transitions[i+1].approach.front()),
                                              transition_params.linear_disc, transition_params.angular_disc);
-      add_segment(connection, false);
+      add_segment(connection);
     }
   } // end segments
 
+  // The joints aren't known yet, so this schedule only accounts for the path itself. It gives
+  // Descartes upper limits on the time of each move that it searches for joint solutions within;
+  // generateMotionPlan() reschedules the feed once they are chosen.
+  const std::vector<double> durations = scheduleFeed(path, std::vector<std::vector<double> >(), feed);
+
+  DescartesTraj traj;
+  traj.reserve(path.size());
+  for (std::size_t i = 0; i < path.size(); ++i)
+  {
+    traj.push_back(conversion_fn(path[i], durations[i]));
+  }
   return traj;
 }
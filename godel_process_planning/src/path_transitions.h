@@ -3,6 +3,7 @@
 
 #include "common_utils.h"
 #include <godel_msgs/BlendingPlanParameters.h>
+#include <godel_process_planning/feed_scheduling.h>
 #include "eigen_conversions/eigen_msg.h"
 
 
@@ -34,7 +35,8 @@ std::vector<ConnectingPath> generateTransitions(const std::vector<geometry_msgs:
  * @param segments Sequence of poses (relative to the world space of blending robot model)
  * @param traverse_height The height in meters from the surface of the part to move to before
  *        moving to the next segment start
- * @param process_speed The point to point difference in speed
+ * @param feed The limits the feed along the path, transitions included, is scheduled within; each
+ *        point's timing is the time of the move into it
  * @param linear_discretization The distance (meters) between points in the connecting paths
  * @param conversion_fn A function that creates a Descartes process point of whatever type your
  *        process (e.g. blending or scanning) requires
@@ -42,7 +44,7 @@ std::vector<ConnectingPath> generateTransitions(const std::vector<geometry_msgs:
  */
 godel_process_planning::DescartesTraj
 toDescartesTraj(const std::vector<geometry_msgs::PoseArray>& segments,
-                const double process_speed, const TransitionParameters& transition_params,
+                const FeedLimits& feed, const TransitionParameters& transition_params,
                 boost::function<descartes_core::TrajectoryPtPtr(const Eigen::Affine3d&, const double)> conversion_fn);
 
 
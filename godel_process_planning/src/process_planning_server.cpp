@@ -0,0 +1,43 @@
+#include <godel_process_planning/process_planning_server.h>
+#include <godel_utils/model_cache.h>
+#include <boost/bind.hpp>
+
+namespace godel_process_planning
+{
+
+ProcessPlanningServer::ProcessPlanningServer(ros::NodeHandle& nh, ros::NodeHandle& pnh)
+{
+  // Load local parameters
+  std::string world_frame, blend_group, keyence_group, blend_tcp, keyence_tcp, robot_model_plugin;
+  pnh.param<std::string>("world_frame", world_frame, "world_frame");
+  pnh.param<std::string>("blend_group", blend_group, "manipulator_tcp");
+  pnh.param<std::string>("keyence_group", keyence_group, "manipulator_keyence");
+  pnh.param<std::string>("blend_tcp", blend_tcp, "tcp_frame");
+  pnh.param<std::string>("keyence_tcp", keyence_tcp, "keyence_tcp_frame");
+  pnh.param<std::string>("robot_model_plugin", robot_model_plugin, "");
+
+  // IK Plugin parameter must be specified
+  if (robot_model_plugin.empty())
+  {
+    throw std::runtime_error("MUST SPECIFY PARAMETER 'robot_model_plugin' for godel_process_planning");
+  }
+
+  // Load the robot models from the description with preprocessed collision meshes
+  const std::string robot_description = godel_utils::model_cache::cachedRobotDescription();
+
+  // Creates a planning manager that will create the appropriate planning classes and perform
+  // all required initialization. It exposes member functions to handle each kind of processing
+  // event.
+  manager_.reset(new ProcessPlanningManager(world_frame, blend_group, blend_tcp, keyence_group,
+                                            keyence_tcp, robot_model_plugin, robot_description));
+
+  // Plumb in the appropriate ros services
+  blend_server_ = godel_utils::intra_process::ServiceServer<godel_msgs::BlendProcessPlanning>(
+      nh, DEFAULT_BLEND_PLANNING_SERVICE,
+      boost::bind(&ProcessPlanningManager::handleBlendPlanning, manager_.get(), _1, _2));
+  keyence_server_ = godel_utils::intra_process::ServiceServer<godel_msgs::KeyenceProcessPlanning>(
+      nh, DEFAULT_KEYENCE_PLANNING_SERVICE,
+      boost::bind(&ProcessPlanningManager::handleKeyencePlanning, manager_.get(), _1, _2));
+}
+
+} // namespace godel_process_planning
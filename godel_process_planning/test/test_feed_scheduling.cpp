@@ -0,0 +1,278 @@
+#include <godel_process_planning/feed_scheduling.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+using namespace godel_process_planning;
+
+namespace
+{
+
+const double SPACING = 0.001; // (m) between the points of the synthetic paths
+
+const std::vector<std::vector<double> > NO_JOINTS;
+
+Eigen::Affine3d pose(double x, double y, double angle = 0.0)
+{
+  return Eigen::Translation3d(x, y, 0.0) * Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitZ());
+}
+
+// Points every SPACING along the straight line from a to b, leaving out b
+void addLine(const Eigen::Vector2d& a, const Eigen::Vector2d& b, PoseVector& path)
+{
+  const int n = static_cast<int>(std::round((b - a).norm() / SPACING));
+  for (int i = 0; i < n; ++i)
+  {
+    const Eigen::Vector2d p = a + (b - a) * static_cast<double>(i) / n;
+    path.push_back(pose(p.x(), p.y()));
+  }
+}
+
+// Points every SPACING around a quarter of the circle of radius r about c, from the angle
+// 'start', leaving out its end
+void addQuarterArc(const Eigen::Vector2d& c, double r, double start, PoseVector& path)
+{
+  const int n = static_cast<int>(std::round(0.5 * M_PI * r / SPACING));
+  for (int i = 0; i < n; ++i)
+  {
+    const double angle = start + 0.5 * M_PI * i / n;
+    path.push_back(pose(c.x() + r * std::cos(angle), c.y() + r * std::sin(angle)));
+  }
+}
+
+PoseVector line(double length)
+{
+  PoseVector path;
+  addLine(Eigen::Vector2d(0.0, 0.0), Eigen::Vector2d(length, 0.0), path);
+  path.push_back(pose(length, 0.0));
+  return path;
+}
+
+// Square of the given side, with sharp corners, around from and back to the origin
+PoseVector square(double side)
+{
+  const Eigen::Vector2d corners[] = {Eigen::Vector2d(0.0, 0.0), Eigen::Vector2d(side, 0.0),
+                                     Eigen::Vector2d(side, side), Eigen::Vector2d(0.0, side)};
+  PoseVector path;
+  for (int i = 0; i < 4; ++i)
+  {
+    addLine(corners[i], corners[(i + 1) % 4], path);
+  }
+  path.push_back(path.front());
+  return path;
+}
+
+// Blend path of 'loops' square loops, each one 'step' inside the last, with corners rounded to
+// 'radius' as offsetting rounds them, joined by a short straight step in
+PoseVector blendPath(double side, double radius, double step, int loops)
+{
+  PoseVector path;
+  for (int k = 0; k < loops; ++k)
+  {
+    const double lo = k * step, hi = side - k * step, r = std::max(radius - k * step, 2.0 * SPACING);
+    addLine(Eigen::Vector2d(lo + r, lo), Eigen::Vector2d(hi - r, lo), path);
+    addQuarterArc(Eigen::Vector2d(hi - r, lo + r), r, -0.5 * M_PI, path);
+    addLine(Eigen::Vector2d(hi, lo + r), Eigen::Vector2d(hi, hi - r), path);
+    addQuarterArc(Eigen::Vector2d(hi - r, hi - r), r, 0.0, path);
+    addLine(Eigen::Vector2d(hi - r, hi), Eigen::Vector2d(lo + r, hi), path);
+    addQuarterArc(Eigen::Vector2d(lo + r, hi - r), r, 0.5 * M_PI, path);
+    addLine(Eigen::Vector2d(lo, hi - r), Eigen::Vector2d(lo, lo + r), path);
+    addQuarterArc(Eigen::Vector2d(lo + r, lo + r), r, M_PI, path);
+  }
+  return path;
+}
+
+double pathLength(const PoseVector& path)
+{
+  double length = 0.0;
+  for (std::size_t i = 1; i < path.size(); ++i)
+  {
+    length += (path[i].translation() - path[i - 1].translation()).norm();
+  }
+  return length;
+}
+
+double total(const std::vector<double>& durations)
+{
+  return std::accumulate(durations.begin(), durations.end(), 0.0);
+}
+
+FeedLimits limits()
+{
+  FeedLimits limits;
+  limits.max_speed = 0.2;
+  limits.max_acceleration = 0.5;
+  limits.max_lateral_acceleration = 0.25;
+  limits.max_rotation_speed = 1.0;
+  return limits;
+}
+
+std::vector<double> scheduledSpeeds(const PoseVector& path, const std::vector<std::vector<double> >& joints,
+                                    const FeedLimits& feed)
+{
+  std::vector<double> speeds = speedLimits(path, joints, feed);
+  limitAcceleration(path, feed.max_acceleration, speeds);
+  return speeds;
+}
+
+} // end anon namespace
+
+TEST(FeedScheduling, straightLineRunsAtMaxSpeed)
+{
+  const FeedLimits feed = limits();
+  const PoseVector path = line(1.0);
+
+  const std::vector<double> speeds = scheduledSpeeds(path, NO_JOINTS, feed);
+  EXPECT_EQ(0.0, speeds.front());
+  EXPECT_EQ(0.0, speeds.back());
+  EXPECT_DOUBLE_EQ(feed.max_speed, speeds[path.size() / 2]);
+
+  // Accelerating to the maximum speed and braking from it each take v / a, and cover half as much
+  // path as running at it would
+  const std::vector<double> durations = scheduleFeed(path, NO_JOINTS, feed);
+  EXPECT_EQ(0.0, durations.front());
+  const double expected = 1.0 / feed.max_speed + feed.max_speed / feed.max_acceleration;
+  EXPECT_NEAR(expected, total(durations), 0.01 * expected);
+}
+
+TEST(FeedScheduling, slowsDownForCorners)
+{
+  const FeedLimits feed = limits();
+  const double side = 0.2;
+  const PoseVector path = square(side);
+  const std::size_t edge = path.size() / 4;
+
+  const std::vector<double> speeds = scheduledSpeeds(path, NO_JOINTS, feed);
+  for (std::size_t corner = edge; corner < path.size() - 1; corner += edge)
+  {
+    // The circle through a right-angled corner and its neighbours has a diameter of the
+    // diagonal between the neighbours
+    const double curvature = 2.0 / (std::sqrt(2.0) * SPACING);
+    EXPECT_LE(speeds[corner], std::sqrt(feed.max_lateral_acceleration / curvature) + 1e-9);
+    EXPECT_DOUBLE_EQ(feed.max_speed, speeds[corner + edge / 2]);
+  }
+}
+
+TEST(FeedScheduling, followsArcsAtLateralAccelerationLimit)
+{
+  const FeedLimits feed = limits();
+  const double radius = 0.05;
+  PoseVector path;
+  addQuarterArc(Eigen::Vector2d(0.0, 0.0), radius, 0.0, path);
+  addQuarterArc(Eigen::Vector2d(0.0, 0.0), radius, 0.5 * M_PI, path);
+
+  const std::vector<double> speeds = speedLimits(path, NO_JOINTS, feed);
+  const double expected = std::sqrt(feed.max_lateral_acceleration * radius);
+  ASSERT_LT(expected, feed.max_speed);
+  for (std::size_t i = 1; i + 1 < path.size(); ++i)
+  {
+    EXPECT_NEAR(expected, speeds[i], 1e-3 * expected);
+  }
+}
+
+TEST(FeedScheduling, limitsToolRotation)
+{
+  FeedLimits feed = limits();
+  const double turn = 0.01; // (rad) per point
+  PoseVector path;
+  for (int i = 0; i <= 100; ++i)
+  {
+    path.push_back(pose(i * SPACING, 0.0, i * turn));
+  }
+
+  const std::vector<double> speeds = speedLimits(path, NO_JOINTS, feed);
+  const double expected = feed.max_rotation_speed * SPACING / turn;
+  ASSERT_LT(expected, feed.max_speed);
+  for (double speed : speeds)
+  {
+    EXPECT_NEAR(expected, speed, 1e-6);
+  }
+
+  const std::vector<double> durations = scheduleFeed(path, NO_JOINTS, feed);
+  for (std::size_t i = 1; i < durations.size(); ++i)
+  {
+    EXPECT_GE(durations[i], turn / feed.max_rotation_speed - 1e-9);
+  }
+}
+
+TEST(FeedScheduling, limitsJointVelocities)
+{
+  FeedLimits feed = limits();
+  feed.max_joint_velocity = {1.0, 0.5};
+  const PoseVector path = line(0.1);
+
+  // The second joint moves the most for its limit
+  std::vector<std::vector<double> > joints;
+  for (std::size_t i = 0; i < path.size(); ++i)
+  {
+    joints.push_back({0.01 * i, 0.008 * i});
+  }
+
+  const std::vector<double> speeds = speedLimits(path, joints, feed);
+  const double expected = SPACING * 0.5 / 0.008;
+  ASSERT_LT(expected, feed.max_speed);
+  EXPECT_NEAR(expected, speeds[path.size() / 2], 1e-6);
+
+  const std::vector<double> durations = scheduleFeed(path, joints, feed);
+  for (std::size_t i = 1; i < durations.size(); ++i)
+  {
+    EXPECT_GE(durations[i], 0.008 / 0.5 - 1e-9);
+  }
+
+  // Limits of joints that aren't planned, or that are zero, are left out
+  feed.max_joint_velocity = {0.0, 0.5, 1.0};
+  EXPECT_NEAR(expected, speedLimits(path, joints, feed)[path.size() / 2], 1e-6);
+  EXPECT_DOUBLE_EQ(feed.max_speed, speedLimits(path, NO_JOINTS, feed)[path.size() / 2]);
+}
+
+TEST(FeedScheduling, boundsAcceleration)
+{
+  const FeedLimits feed = limits();
+  const PoseVector path = blendPath(0.2, 0.02, 0.01, 3);
+
+  const std::vector<double> speeds = scheduledSpeeds(path, NO_JOINTS, feed);
+  for (std::size_t i = 1; i < path.size(); ++i)
+  {
+    const double ds = (path[i].translation() - path[i - 1].translation()).norm();
+    EXPECT_LE(std::abs(speeds[i] * speeds[i] - speeds[i - 1] * speeds[i - 1]),
+              2.0 * feed.max_acceleration * ds + 1e-12);
+  }
+
+  // The durations are those of changing speed evenly along each move
+  const std::vector<double> durations = moveDurations(path, NO_JOINTS, speeds, feed);
+  for (std::size_t i = 1; i < path.size(); ++i)
+  {
+    const double ds = (path[i].translation() - path[i - 1].translation()).norm();
+    EXPECT_NEAR(2.0 * ds / (speeds[i - 1] + speeds[i]), durations[i], 1e-9);
+  }
+}
+
+TEST(FeedScheduling, beatsConstantSpeedOnBlendPath)
+{
+  const FeedLimits feed = limits();
+  const PoseVector path = blendPath(0.3, 0.02, 0.01, 5);
+
+  // One speed for the whole path must be slow enough for its tightest corner
+  const std::vector<double> limits = speedLimits(path, NO_JOINTS, feed);
+  const double constant_speed = *std::min_element(limits.begin() + 1, limits.end() - 1);
+  FeedLimits constant = feed;
+  constant.max_speed = constant_speed;
+  constant.max_lateral_acceleration = 0.0;
+  const double constant_time = total(scheduleFeed(path, NO_JOINTS, constant));
+
+  const double scheduled_time = total(scheduleFeed(path, NO_JOINTS, feed));
+  std::cout << "Blend path of " << pathLength(path) << " m: " << constant_time << " s at a constant "
+            << constant_speed << " m/s, " << scheduled_time << " s scheduled\n";
+
+  EXPECT_LT(scheduled_time, 0.5 * constant_time);
+  EXPECT_GT(scheduled_time, pathLength(path) / feed.max_speed);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -20,8 +20,14 @@ struct TrajectoryPt
   {
   }
 
-  value_type positions_; // degrees
-  double duration_;      // seconds
+  TrajectoryPt(const std::vector<double>& positions, double duration, const std::vector<double>& tcp_position)
+      : positions_(positions), duration_(duration), tcp_position_(tcp_position)
+  {
+  }
+
+  value_type positions_;     // degrees
+  double duration_;          // seconds
+  value_type tcp_position_;  // x, y, z of the tool point in mm; empty if unknown. Used to size the zones.
 };
 
 /**
@@ -32,12 +38,21 @@ struct TrajectoryPt
  */
 struct ProcessParams
 {
+  ProcessParams()
+      : spindle_speed(0.0), tcp_speed(0.0), force(0.0), wolf_mode(false), slide_force(0.0),
+        path_tolerance(1.0), motion_tolerance(10.0), max_zone(100.0)
+  {
+  }
+
   double spindle_speed;    // Tool rotation speed
   double tcp_speed;        // Tool linear traversal speed
   double force;            // For non-wolfware software, a general identification of force
   std::string output_name; // The I/O that toggles the tool power; We assume 0 is off and 1 is on.
   bool wolf_mode;          // In the case of Wolfware software, we emit special instructions.
   double slide_force;      // For WolfWare, a meaure of the cross-slide force (?)
+  double path_tolerance;   // How far (mm) the tool may cut a corner of the process path
+  double motion_tolerance; // How far (mm) the tool may cut a corner of the free motions
+  double max_zone;         // Upper bound (mm) of the zones on straight runs
 };
 }
 
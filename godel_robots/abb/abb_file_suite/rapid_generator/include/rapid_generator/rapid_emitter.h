@@ -2,6 +2,7 @@
 #define RAPID_EMITTER_H
 
 #include "rapid_generator/rapid_data_structures.h"
+#include "rapid_generator/zone_planning.h"
 
 #include <iosfwd>
 #include <string>
@@ -10,7 +11,8 @@ namespace rapid_emitter
 {
 /**
  * @brief Writes a RAPID program to 'os' that moves through a sequence of joint positions
- *        and toggles an I/O on and off at specific sequence points.
+ *        and toggles an I/O on and off at specific sequence points. Zones and process speeds
+ *        come from planMoves().
  * @param os  The output stream; will usually be a std::ofstream
  * @param points  Sequence of joint-positions and durations
  * @param startProcessMotion  The first joint-position inside the 'process' segment of the points
@@ -41,13 +43,21 @@ bool emitJointPosition(std::ostream& os, const TrajectoryPt& pt, size_t n);
 // Wolf systems
 bool emitGrindMotion(std::ostream& os, const ProcessParams& params, size_t n, bool start = false,
                      bool end = false);
+// As above, with the zone and speed of 'move'
+bool emitGrindMotion(std::ostream& os, const ProcessParams& params, size_t n, const MoveData& move,
+                     bool start = false, bool end = false);
 // Writes a free joint move to target 'n'
 bool emitFreeMotion(std::ostream& os, const ProcessParams& params, size_t n, double duration,
                     bool stop_at);
+// As above, with the zone of 'move'
+bool emitFreeMotion(std::ostream& os, const ProcessParams& params, size_t n, double duration,
+                    const MoveData& move);
 // Writes an I/O using the name from 'params'
 bool emitSetOutput(std::ostream& os, const ProcessParams& params, size_t value);
 // Writes the necessary info for process parameter blocks
 bool emitProcessDeclarations(std::ostream& os, const ProcessParams& params, size_t value);
+// Declares each zone and speed of 'moves' that the controller does not predefine, once
+bool emitMoveDeclarations(std::ostream& os, const std::vector<MoveData>& moves);
 }
 
 #endif
@@ -0,0 +1,97 @@
+#ifndef RAPID_ZONE_PLANNING_H
+#define RAPID_ZONE_PLANNING_H
+
+#include "rapid_generator/rapid_data_structures.h"
+
+#include <string>
+
+/*
+ * Zone and speed data for the moves of an emitted program.
+ *
+ * A zone is the distance from a target at which the controller starts blending into the next
+ * move; the tool then cuts the corner instead of stopping at it. Large zones keep the robot at
+ * speed, but how far the tool leaves the path depends on the radius and on how sharply the path
+ * turns. The planner gives every target the largest zone that keeps the tool within the
+ * tolerance of the process (or of the free motions) and within half of the neighbouring moves,
+ * and stops ('fine') only where the program switches the tool or the process. Radii are rounded
+ * down to a short ladder of values so that a program declares a handful of zonedata.
+ */
+
+namespace rapid_emitter
+{
+
+const double FINE_ZONE = -1.0;
+
+/**
+ * @brief How the robot passes through one target of the program
+ */
+struct MoveData
+{
+  MoveData(double zone = FINE_ZONE, double speed = 0.0) : zone(zone), speed(speed) {}
+
+  double zone;  // mm; FINE_ZONE stops at the target
+  double speed; // TCP speed (mm/s) of the move into the target; 0 uses the default speed
+};
+
+/**
+ * @brief The largest zone (mm) at 'pt' that keeps the tool within 'tolerance' of the path
+ *        'prev' -> 'pt' -> 'next' and within half of either move. All positions are in mm.
+ */
+double zoneRadius(const std::vector<double>& prev, const std::vector<double>& pt,
+                  const std::vector<double>& next, double tolerance, double max_zone);
+
+/**
+ * @brief Rounds a zone (mm) down to the ladder of radii that the programs declare
+ */
+double quantizeZone(double zone);
+
+/**
+ * @brief Zones and speeds of the program emitted by emitRapidFile(). Points without TCP
+ *        positions keep the fixed zones and the default process speed.
+ * @return One MoveData per point
+ */
+std::vector<MoveData> planMoves(const std::vector<TrajectoryPt>& points, size_t startProcessMotion,
+                                size_t endProcessMotion, const ProcessParams& params);
+
+/**
+ * @brief The zones of emitRapidFile() before zones were planned: z40 on the process path, z20 on
+ *        free motions and 'fine' at both ends of each. Used to compare cycle times.
+ */
+std::vector<MoveData> fixedMoves(const std::vector<TrajectoryPt>& points, size_t startProcessMotion,
+                                 size_t endProcessMotion, const ProcessParams& params);
+
+/** @brief True for 'fine' and the zones the controller predefines, which are not declared */
+bool isPredefinedZone(double zone);
+
+/** @brief The RAPID name of a zone: 'fine', a predefined zone or a declared one */
+std::string zoneName(double zone);
+
+/** @brief The RAPID name of a declared process speed (mm/s) */
+std::string speedName(double speed);
+
+/**
+ * @brief Assumptions of estimateCycleTime() about the controller
+ */
+struct CycleTimeModel
+{
+  CycleTimeModel() : acceleration(2000.0), settle_time(0.05), motion_speed(200.0) {}
+
+  double acceleration; // mm/s^2 the TCP brakes and accelerates with
+  double settle_time;  // s spent at every 'fine' target to come into position
+  double motion_speed; // mm/s of free motions without a duration (vMotionSpeed)
+};
+
+/**
+ * @brief Estimates how long a program runs without a controller: every move takes its duration
+ *        or its length at its speed, and the robot loses time at every target it cannot pass
+ *        at speed, down to a standstill at 'fine' targets. Meant to compare the moves of one set
+ *        of points, not to predict the cycle time of a real controller.
+ * @param moves One MoveData per point, as from planMoves() or fixedMoves()
+ * @return The estimated time in seconds
+ */
+double estimateCycleTime(const std::vector<TrajectoryPt>& points, const std::vector<MoveData>& moves,
+                         size_t startProcessMotion, size_t endProcessMotion, const ProcessParams& params,
+                         const CycleTimeModel& model = CycleTimeModel());
+}
+
+#endif // RAPID_ZONE_PLANNING_H
@@ -1,5 +1,6 @@
 #include "rapid_generator/rapid_emitter.h"
 
+#include <algorithm>
 #include <iostream>
 
 bool rapid_emitter::emitRapidFile(std::ostream& os, const std::vector<TrajectoryPt>& points,
@@ -15,18 +16,15 @@ bool rapid_emitter::emitRapidFile(std::ostream& os, const std::vector<Trajectory
   }
   // Emit Process Declarations
   emitProcessDeclarations(os, params, 1);
+  const std::vector<MoveData> moves = planMoves(points, startProcessMotion, endProcessMotion, params);
+  emitMoveDeclarations(os, moves);
 
   // Write beginning of procedure
   os << "\nPROC Godel_Blend()\n";
   // For 0 to lengthFreeMotion, emit free moves
   for (std::size_t i = 0; i < startProcessMotion; ++i)
   {
-    if (i == 0)
-      emitFreeMotion(os, params, i, 0.0, true);
-    else if (i == (startProcessMotion - 1))
-      emitFreeMotion(os, params, i, points[i].duration_, true);
-    else
-      emitFreeMotion(os, params, i, points[i].duration_, false);
+    emitFreeMotion(os, params, i, i == 0 ? 0.0 : points[i].duration_, moves[i]);
   }
 
   // Turn on the tool
@@ -37,15 +35,15 @@ bool rapid_emitter::emitRapidFile(std::ostream& os, const std::vector<Trajectory
   {
     if (i == startProcessMotion)
     {
-      emitGrindMotion(os, params, i, true, false);
+      emitGrindMotion(os, params, i, moves[i], true, false);
     }
     else if (i == endProcessMotion - 1)
     {
-      emitGrindMotion(os, params, i, false, true);
+      emitGrindMotion(os, params, i, moves[i], false, true);
     }
     else
     {
-      emitGrindMotion(os, params, i);
+      emitGrindMotion(os, params, i, moves[i]);
     }
   }
 
@@ -55,12 +53,7 @@ bool rapid_emitter::emitRapidFile(std::ostream& os, const std::vector<Trajectory
   // for lengthFreeMotion to end of points, emit grind moves
   for (std::size_t i = endProcessMotion; i < points.size(); ++i)
   {
-    if (i == endProcessMotion)
-      emitFreeMotion(os, params, i, 0.0, true);
-    else if (i == (points.size() - 1))
-      emitFreeMotion(os, params, i, points[i].duration_, true);
-    else
-      emitFreeMotion(os, params, i, points[i].duration_, false);
+    emitFreeMotion(os, params, i, i == endProcessMotion ? 0.0 : points[i].duration_, moves[i]);
   }
 
   os << "EndProc\n";
@@ -74,28 +67,38 @@ bool rapid_emitter::emitGrindMotion(std::ostream& os, const ProcessParams& param
                                     bool start, bool end)
 {
   // The 'fine' zoning means the robot will stop at this point
+  const MoveData move(params.wolf_mode && (start || end) ? FINE_ZONE : 40.0);
+  return emitGrindMotion(os, params, n, move, start, end);
+}
+
+bool rapid_emitter::emitGrindMotion(std::ostream& os, const ProcessParams& params, size_t n,
+                                    const MoveData& move, bool start, bool end)
+{
+  const std::string zone = zoneName(move.zone);
 
   // Note that 'wolf_mode' indicates the presence of WolfWare software for the ABB which has
   // a sepcial instruction called the 'GrindL'. This encapsulates both a robot motion and the
   // state of a tool as it moves through the path. The 'Start' and 'End' varieties handle I/O.
   if (params.wolf_mode)
   {
+    const std::string speed = move.speed > 0.0 ? speedName(move.speed) : "v100";
     if (start)
     {
-      os << "GrindLStart CalcRobT(jTarget_" << n << ",tool1), v100, gr1, fine, tool1;\n";
+      os << "GrindLStart CalcRobT(jTarget_" << n << ",tool1), " << speed << ", gr1, " << zone << ", tool1;\n";
     }
     else if (end)
     {
-      os << "GrindLEnd CalcRobT(jTarget_" << n << ",tool1), v100, fine, tool1;\n";
+      os << "GrindLEnd CalcRobT(jTarget_" << n << ",tool1), " << speed << ", " << zone << ", tool1;\n";
     }
     else
     {
-      os << "GrindL CalcRobT(jTarget_" << n << ",tool1), v100, z40, tool1;\n";
+      os << "GrindL CalcRobT(jTarget_" << n << ",tool1), " << speed << ", " << zone << ", tool1;\n";
     }
   }
   else
   {
-    os << "MoveL CalcRobT(jTarget_" << n << ",tool1), vProcessSpeed, z40, tool1;\n";
+    const std::string speed = move.speed > 0.0 ? speedName(move.speed) : "vProcessSpeed";
+    os << "MoveL CalcRobT(jTarget_" << n << ",tool1), " << speed << ", " << zone << ", tool1;\n";
   }
   return os.good();
 }
@@ -105,7 +108,13 @@ bool rapid_emitter::emitFreeMotion(std::ostream& os, const ProcessParams& params
 {
   // We want the robot to move smoothly and stop at the last point; these tolerances ensure that
   // this happens
-  const char* zone = stop_at ? "fine" : "z20";
+  return emitFreeMotion(os, params, n, duration, MoveData(stop_at ? FINE_ZONE : 20.0));
+}
+
+bool rapid_emitter::emitFreeMotion(std::ostream& os, const ProcessParams& params, size_t n,
+                                   double duration, const MoveData& move)
+{
+  const std::string zone = zoneName(move.zone);
 
   if (duration <= 0.0)
   {
@@ -118,6 +127,7 @@ bool rapid_emitter::emitFreeMotion(std::ostream& os, const ProcessParams& params
   }
   return os.good();
 }
+
 bool rapid_emitter::emitJointPosition(std::ostream& os, const TrajectoryPt& pt, size_t n)
 {
   os << "TASK PERS jointtarget jTarget_" << n << ":=[[";
@@ -169,6 +179,34 @@ bool rapid_emitter::emitProcessDeclarations(std::ostream& os, const ProcessParam
   return os.good();
 }
 
+bool rapid_emitter::emitMoveDeclarations(std::ostream& os, const std::vector<MoveData>& moves)
+{
+  std::vector<double> zones, speeds;
+  for (const MoveData& move : moves)
+  {
+    if (!isPredefinedZone(move.zone))
+      zones.push_back(move.zone);
+    if (move.speed > 0.0)
+      speeds.push_back(move.speed);
+  }
+  std::sort(zones.begin(), zones.end());
+  zones.erase(std::unique(zones.begin(), zones.end()), zones.end());
+  std::sort(speeds.begin(), speeds.end());
+  speeds.erase(std::unique(speeds.begin(), speeds.end()), speeds.end());
+
+  // Same proportions as the predefined zones
+  for (double zone : zones)
+  {
+    os << "CONST zonedata " << zoneName(zone) << ":=[FALSE," << zone << "," << 1.5 * zone << "," << 1.5 * zone
+       << "," << 0.15 * zone << "," << 1.5 * zone << "," << 0.15 * zone << "];\n";
+  }
+  for (double speed : speeds)
+  {
+    os << "CONST speeddata " << speedName(speed) << ":=[" << speed << "," << speed << ",50,50];\n";
+  }
+  return os.good();
+}
+
 bool rapid_emitter::emitJointTrajectoryFile(std::ostream& os,
                                             const std::vector<TrajectoryPt>& points,
                                             const ProcessParams& params)
@@ -182,26 +220,26 @@ bool rapid_emitter::emitJointTrajectoryFile(std::ostream& os,
   }
   // Emit Process Declarations
   emitProcessDeclarations(os, params, 1);
-  // Write beginning of procedure
-  os << "\nPROC Godel_Blend()\n";
   // For 0 to lengthFreeMotion, emit free moves
   if (points.empty())
   {
+    os << "\nPROC Godel_Blend()\n";
     return false;
   }
+  // There is no process; the robot stops at the first and the last point
+  const std::vector<MoveData> moves = planMoves(points, 0, 0, params);
+  emitMoveDeclarations(os, moves);
+  // Write beginning of procedure
+  os << "\nPROC Godel_Blend()\n";
 
   // Write first point as normal move abs j so that the robot gets to where it needs to be
-  emitFreeMotion(os, params, 0, 0.0, true);
+  emitFreeMotion(os, params, 0, 0.0, moves[0]);
 
-  // The second motion
-  for (std::size_t i = 1; i < points.size() - 1; ++i)
+  for (std::size_t i = 1; i < points.size(); ++i)
   {
-    emitFreeMotion(os, params, i, points[i].duration_, false);
+    emitFreeMotion(os, params, i, points[i].duration_, moves[i]);
   }
 
-  // Stop at the last point
-  emitFreeMotion(os, params, points.size() - 1, points.back().duration_, true);
-
   os << "EndProc\n";
   // write any footers including main procedure calling the above
   os << "ENDMODULE\n";
@@ -0,0 +1,244 @@
+#include "rapid_generator/zone_planning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+
+// Radii (mm) the planned zones are rounded down to; most are predefined zones of the controller
+const static double ZONE_LADDER[] = {1, 2, 3, 5, 7, 10, 15, 20, 25, 30, 40, 50, 60, 80, 100, 150, 200};
+const static double PREDEFINED_ZONES[] = {0, 1, 5, 10, 15, 20, 30, 40, 50, 60, 80, 100, 150, 200};
+
+// The zones of the program before they were planned
+const static double FIXED_PROCESS_ZONE = 40.0;
+const static double FIXED_MOTION_ZONE = 20.0;
+
+// Default speeds (mm/s) of process moves that have no speed of their own
+const static double WOLF_PROCESS_SPEED = 100.0;
+
+// Planned process speeds are rounded down to this (mm/s), so that the program never outruns a
+// feed scheduled for the corners of the path; speeds within SPEED_SLACK steps of the next one up
+// are taken as that one
+const static double SPEED_STEP = 5.0;
+const static double SPEED_SLACK = 0.01;
+
+// The WaitTime\InPos before each switch of the tool (s)
+const static double IO_WAIT_TIME = 0.01;
+
+// Turns below this angle (rad) count as straight
+const static double STRAIGHT_ANGLE = 1e-6;
+
+// The radius (mm) of the predefined zone z0
+const static double Z0_RADIUS = 0.3;
+
+bool hasPosition(const rapid_emitter::TrajectoryPt& pt) { return pt.tcp_position_.size() >= 3; }
+
+double distance(const std::vector<double>& a, const std::vector<double>& b)
+{
+  return std::sqrt((b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1]) + (b[2] - a[2]) * (b[2] - a[2]));
+}
+
+// The angle (rad) the path turns by at 'pt'; 0 if either move has no length
+double turnAngle(const std::vector<double>& prev, const std::vector<double>& pt, const std::vector<double>& next)
+{
+  const double d1 = distance(prev, pt), d2 = distance(pt, next);
+  if (d1 <= 0.0 || d2 <= 0.0)
+    return 0.0;
+
+  double cosine = 0.0;
+  for (int i = 0; i < 3; ++i)
+    cosine += (pt[i] - prev[i]) * (next[i] - pt[i]);
+  cosine /= d1 * d2;
+  return std::acos(std::max(-1.0, std::min(1.0, cosine)));
+}
+
+bool isProcess(size_t i, size_t start, size_t end) { return i >= start && i < end; }
+
+double defaultProcessSpeed(const rapid_emitter::ProcessParams& params)
+{
+  return params.wolf_mode ? WOLF_PROCESS_SPEED : params.tcp_speed;
+}
+
+// Targets the robot has to stop at because the program switches the tool or the process there
+bool isEvent(size_t i, size_t size, size_t start, size_t end, const rapid_emitter::ProcessParams& params)
+{
+  // The first target is reached from wherever the robot is, the last ends the program
+  if (i == 0 || i + 1 == size)
+    return true;
+  // The tool is switched on after the approach and off after the process path
+  if (i + 1 == start || (end > start && i + 1 == end))
+    return true;
+  // GrindLStart switches the tool itself
+  return params.wolf_mode && i == start && end > start;
+}
+
+} // end anon namespace
+
+double rapid_emitter::zoneRadius(const std::vector<double>& prev, const std::vector<double>& pt,
+                                 const std::vector<double>& next, double tolerance, double max_zone)
+{
+  // The controller shrinks zones to half of the neighbouring moves anyway
+  double radius = std::min(max_zone, 0.5 * std::min(distance(prev, pt), distance(pt, next)));
+
+  // Blending between the two points at 'radius' from the corner passes the corner at no more than
+  // radius * sin(angle / 2)
+  const double angle = turnAngle(prev, pt, next);
+  if (angle > STRAIGHT_ANGLE)
+    radius = std::min(radius, tolerance / std::sin(0.5 * angle));
+  return std::max(0.0, radius);
+}
+
+double rapid_emitter::quantizeZone(double zone)
+{
+  double quantized = 0.0;
+  for (double step : ZONE_LADDER)
+  {
+    if (step <= zone)
+      quantized = step;
+  }
+  return quantized;
+}
+
+std::vector<rapid_emitter::MoveData> rapid_emitter::planMoves(const std::vector<TrajectoryPt>& points,
+                                                              size_t startProcessMotion, size_t endProcessMotion,
+                                                              const ProcessParams& params)
+{
+  std::vector<MoveData> moves(points.size());
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    const bool process = isProcess(i, startProcessMotion, endProcessMotion);
+
+    // Process moves go at the speed the plan moves between the points
+    if (process && i > 0 && points[i].duration_ > 0.0 && hasPosition(points[i - 1]) && hasPosition(points[i]))
+    {
+      const double speed = distance(points[i - 1].tcp_position_, points[i].tcp_position_) / points[i].duration_;
+      moves[i].speed = std::max(SPEED_STEP, SPEED_STEP * std::floor(speed / SPEED_STEP + SPEED_SLACK));
+    }
+
+    if (isEvent(i, points.size(), startProcessMotion, endProcessMotion, params))
+      moves[i].zone = FINE_ZONE;
+    else if (hasPosition(points[i - 1]) && hasPosition(points[i]) && hasPosition(points[i + 1]))
+      moves[i].zone = quantizeZone(zoneRadius(points[i - 1].tcp_position_, points[i].tcp_position_,
+                                              points[i + 1].tcp_position_,
+                                              process ? params.path_tolerance : params.motion_tolerance,
+                                              params.max_zone));
+    else
+      moves[i].zone = process ? FIXED_PROCESS_ZONE : FIXED_MOTION_ZONE;
+  }
+  return moves;
+}
+
+std::vector<rapid_emitter::MoveData> rapid_emitter::fixedMoves(const std::vector<TrajectoryPt>& points,
+                                                               size_t startProcessMotion, size_t endProcessMotion,
+                                                               const ProcessParams& params)
+{
+  std::vector<MoveData> moves(points.size());
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    if (isProcess(i, startProcessMotion, endProcessMotion))
+    {
+      // Without Wolfware the z40 of the last process move made no difference: WaitTime\InPos stops
+      // the robot there before the tool is switched off
+      const bool stop = params.wolf_mode ? i == startProcessMotion || i + 1 == endProcessMotion
+                                         : i + 1 == endProcessMotion;
+      moves[i].zone = stop ? FINE_ZONE : FIXED_PROCESS_ZONE;
+    }
+    else
+    {
+      const bool stop = i == 0 || i + 1 == startProcessMotion || i == endProcessMotion || i + 1 == points.size();
+      moves[i].zone = stop ? FINE_ZONE : FIXED_MOTION_ZONE;
+    }
+  }
+  return moves;
+}
+
+bool rapid_emitter::isPredefinedZone(double zone)
+{
+  const double* end = PREDEFINED_ZONES + sizeof(PREDEFINED_ZONES) / sizeof(PREDEFINED_ZONES[0]);
+  return zone < 0.0 || std::find(PREDEFINED_ZONES, end, zone) != end;
+}
+
+std::string rapid_emitter::zoneName(double zone)
+{
+  if (zone < 0.0)
+    return "fine";
+
+  std::ostringstream ss;
+  ss << (isPredefinedZone(zone) ? "z" : "zPath_") << zone;
+  return ss.str();
+}
+
+std::string rapid_emitter::speedName(double speed)
+{
+  std::ostringstream ss;
+  ss << "vPath_" << speed;
+  return ss.str();
+}
+
+double rapid_emitter::estimateCycleTime(const std::vector<TrajectoryPt>& points, const std::vector<MoveData>& moves,
+                                        size_t startProcessMotion, size_t endProcessMotion,
+                                        const ProcessParams& params, const CycleTimeModel& model)
+{
+  // Length (mm, 0 if unknown), time and speed of the move into each point
+  std::vector<double> lengths(points.size(), 0.0), speeds(points.size(), 0.0);
+  double time = 0.0;
+  for (std::size_t i = 1; i < points.size(); ++i)
+  {
+    if (hasPosition(points[i - 1]) && hasPosition(points[i]))
+      lengths[i] = distance(points[i - 1].tcp_position_, points[i].tcp_position_);
+
+    double move_time = points[i].duration_;
+    if (isProcess(i, startProcessMotion, endProcessMotion))
+    {
+      const double speed = moves[i].speed > 0.0 ? moves[i].speed : defaultProcessSpeed(params);
+      if (lengths[i] > 0.0 && speed > 0.0)
+        move_time = lengths[i] / speed;
+    }
+    else if (move_time <= 0.0 && model.motion_speed > 0.0)
+    {
+      move_time = lengths[i] / model.motion_speed;
+    }
+
+    if (move_time > 0.0)
+      speeds[i] = lengths[i] / move_time;
+    time += move_time;
+  }
+
+  // Time lost braking for, and accelerating out of, each target
+  const double a = model.acceleration;
+  for (std::size_t i = 1; i < points.size(); ++i)
+  {
+    const double v_in = speeds[i];
+    const double v_out = i + 1 < points.size() ? speeds[i + 1] : 0.0;
+
+    double v_pass = std::numeric_limits<double>::infinity();
+    if (moves[i].zone < 0.0)
+    {
+      v_pass = 0.0;
+      time += model.settle_time;
+    }
+    else if (i + 1 < points.size() && hasPosition(points[i - 1]) && hasPosition(points[i]) &&
+             hasPosition(points[i + 1]))
+    {
+      const double angle = turnAngle(points[i - 1].tcp_position_, points[i].tcp_position_,
+                                     points[i + 1].tcp_position_);
+      const double zone = std::min(std::max(moves[i].zone, Z0_RADIUS), 0.5 * std::min(lengths[i], lengths[i + 1]));
+      // The blend turns on a radius of about zone / tan(angle / 2) and is taken at the speed
+      // the acceleration allows on it
+      if (angle > STRAIGHT_ANGLE)
+        v_pass = std::sqrt(a * zone / std::tan(0.5 * angle));
+    }
+
+    if (a > 0.0 && v_in > v_pass)
+      time += (v_in - v_pass) * (v_in - v_pass) / (2.0 * a * v_in);
+    if (a > 0.0 && v_out > v_pass)
+      time += (v_out - v_pass) * (v_out - v_pass) / (2.0 * a * v_out);
+  }
+
+  if (!params.wolf_mode && endProcessMotion > startProcessMotion)
+    time += 2 * IO_WAIT_TIME;
+  return time;
+}
@@ -0,0 +1,90 @@
+MODULE mGodel_Blend
+
+TASK PERS jointtarget jTarget_0:=[[0,0,10,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_1:=[[0,0,5,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_2:=[[0,0,1,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_3:=[[0,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_4:=[[1,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_5:=[[2,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_6:=[[3,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_7:=[[4,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_8:=[[5,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_9:=[[6,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_10:=[[7,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_11:=[[8,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_12:=[[9,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_13:=[[10,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_14:=[[10,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_15:=[[9,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_16:=[[8,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_17:=[[7,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_18:=[[6,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_19:=[[5,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_20:=[[4,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_21:=[[3,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_22:=[[2,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_23:=[[1,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_24:=[[0,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_25:=[[0,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_26:=[[1,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_27:=[[2,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_28:=[[3,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_29:=[[4,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_30:=[[5,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_31:=[[6,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_32:=[[7,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_33:=[[8,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_34:=[[9,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_35:=[[10,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_36:=[[10,4,1,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_37:=[[10,4,10,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+CONST speeddata vProcessSpeed:=[50,50,50,50];
+CONST speeddata vMotionSpeed:=[200,30,500,500];
+CONST zonedata zPath_2:=[FALSE,2,3,3,0.3,3,0.3];
+CONST speeddata vPath_50:=[50,50,50,50];
+
+PROC Godel_Blend()
+MoveAbsJ jTarget_0, vMotionSpeed,fine, tool1;
+MoveAbsJ jTarget_1, vMotionSpeed, \T:=1, z20, tool1;
+MoveAbsJ jTarget_2, vMotionSpeed, \T:=0.5, fine, tool1;
+WaitTime\InPos, 0.01;
+SETDO do_PIO_8, 1;
+MoveL CalcRobT(jTarget_3,tool1), vPath_50, zPath_2, tool1;
+MoveL CalcRobT(jTarget_4,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_5,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_6,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_7,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_8,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_9,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_10,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_11,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_12,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_13,tool1), vPath_50, zPath_2, tool1;
+MoveL CalcRobT(jTarget_14,tool1), vPath_50, zPath_2, tool1;
+MoveL CalcRobT(jTarget_15,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_16,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_17,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_18,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_19,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_20,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_21,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_22,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_23,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_24,tool1), vPath_50, zPath_2, tool1;
+MoveL CalcRobT(jTarget_25,tool1), vPath_50, zPath_2, tool1;
+MoveL CalcRobT(jTarget_26,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_27,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_28,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_29,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_30,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_31,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_32,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_33,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_34,tool1), vPath_50, z5, tool1;
+MoveL CalcRobT(jTarget_35,tool1), vPath_50, fine, tool1;
+WaitTime\InPos, 0.01;
+SETDO do_PIO_8, 0;
+MoveAbsJ jTarget_36, vMotionSpeed,z5, tool1;
+MoveAbsJ jTarget_37, vMotionSpeed, \T:=1, fine, tool1;
+EndProc
+ENDMODULE
@@ -0,0 +1,84 @@
+MODULE mGodel_Blend
+
+TASK PERS jointtarget jTarget_0:=[[0,0,10,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_1:=[[0,0,5,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_2:=[[0,0,1,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_3:=[[0,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_4:=[[1,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_5:=[[2,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_6:=[[3,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_7:=[[4,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_8:=[[5,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_9:=[[6,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_10:=[[7,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_11:=[[8,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_12:=[[9,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_13:=[[10,0,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_14:=[[10,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_15:=[[9,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_16:=[[8,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_17:=[[7,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_18:=[[6,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_19:=[[5,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_20:=[[4,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_21:=[[3,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_22:=[[2,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_23:=[[1,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_24:=[[0,2,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_25:=[[0,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_26:=[[1,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_27:=[[2,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_28:=[[3,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_29:=[[4,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_30:=[[5,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_31:=[[6,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_32:=[[7,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_33:=[[8,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_34:=[[9,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_35:=[[10,4,0,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_36:=[[10,4,1,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+TASK PERS jointtarget jTarget_37:=[[10,4,10,0,90,0],[9E9,9E9,9E9,9E9,9E9,9E9]];
+CONST speeddata vProcessSpeed:=[50,50,50,50];
+CONST speeddata vMotionSpeed:=[200,30,500,500];
+
+PROC Godel_Blend()
+MoveAbsJ jTarget_0, vMotionSpeed,fine, tool1;
+MoveAbsJ jTarget_1, vMotionSpeed, \T:=1, z20, tool1;
+MoveAbsJ jTarget_2, vMotionSpeed, \T:=0.5, z5, tool1;
+MoveAbsJ jTarget_3, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_4, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_5, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_6, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_7, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_8, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_9, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_10, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_11, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_12, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_13, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_14, vMotionSpeed, \T:=0.4, z5, tool1;
+MoveAbsJ jTarget_15, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_16, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_17, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_18, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_19, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_20, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_21, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_22, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_23, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_24, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_25, vMotionSpeed, \T:=0.4, z5, tool1;
+MoveAbsJ jTarget_26, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_27, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_28, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_29, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_30, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_31, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_32, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_33, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_34, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_35, vMotionSpeed, \T:=0.2, z5, tool1;
+MoveAbsJ jTarget_36, vMotionSpeed, \T:=0.5, z5, tool1;
+MoveAbsJ jTarget_37, vMotionSpeed, \T:=1, fine, tool1;
+EndProc
+ENDMODULE
@@ -0,0 +1,204 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <rapid_generator/rapid_emitter.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace rapid_emitter;
+
+namespace
+{
+
+// Set to rewrite the golden files from the current output
+const static char* UPDATE_VARIABLE = "GODEL_UPDATE_GOLDEN";
+
+/*
+ * A blending plan like the process planner makes them: an approach from above, a raster of three
+ * 100 mm passes 20 mm apart, 10 mm per point at 50 mm/s, and a retract. The tool may leave the
+ * path by 2 mm.
+ */
+struct Plan
+{
+  Plan(bool positions)
+  {
+    add(positions, 0, 0, 100, 0.0);
+    add(positions, 0, 0, 50, 1.0);
+    add(positions, 0, 0, 10, 0.5);
+    start = points.size();
+    for (int pass = 0; pass < 3; ++pass)
+    {
+      for (int step = 0; step <= 10; ++step)
+      {
+        const double x = pass % 2 == 0 ? 10.0 * step : 100.0 - 10.0 * step;
+        add(positions, x, 20.0 * pass, 0, step == 0 && pass > 0 ? 0.4 : 0.2);
+      }
+    }
+    end = points.size();
+    add(positions, 100, 40, 10, 0.5);
+    add(positions, 100, 40, 100, 1.0);
+
+    params.tcp_speed = 50;
+    params.path_tolerance = 2.0;
+    params.spindle_speed = 1.0;
+    params.output_name = "do_PIO_8";
+  }
+
+  void add(bool positions, double x, double y, double z, double duration)
+  {
+    // Stand-ins for the joint positions (degrees) of the TCP position
+    std::vector<double> joints = {x / 10.0, y / 10.0, z / 10.0, 0.0, 90.0, 0.0};
+    if (positions)
+      points.push_back(TrajectoryPt(joints, duration, {x + 500.0, y, z + 300.0}));
+    else
+      points.push_back(TrajectoryPt(joints, duration));
+  }
+
+  std::vector<TrajectoryPt> points;
+  size_t start, end;
+  ProcessParams params;
+};
+
+void expectGolden(const std::string& name, const std::string& program)
+{
+  const std::string path = std::string(GOLDEN_DIRECTORY) + "/" + name;
+  if (std::getenv(UPDATE_VARIABLE))
+  {
+    std::ofstream out(path.c_str());
+    out << program;
+  }
+
+  std::ifstream in(path.c_str());
+  ASSERT_TRUE(in.good()) << "Missing golden file " << path << "; run with " << UPDATE_VARIABLE << "=1";
+  std::stringstream golden;
+  golden << in.rdbuf();
+  EXPECT_EQ(golden.str(), program) << "Output differs from " << path;
+}
+
+std::string emit(const Plan& plan)
+{
+  std::ostringstream os;
+  EXPECT_TRUE(emitRapidFile(os, plan.points, plan.start, plan.end, plan.params));
+  return os.str();
+}
+
+} // end anon namespace
+
+TEST(ZonePlanning, zonesFollowTheCorners)
+{
+  const std::vector<double> a = {0, 0, 0}, b = {100, 0, 0}, c = {200, 0, 0}, d = {100, 100, 0}, e = {100, 10, 0};
+
+  // Straight runs are limited by the moves, corners by the tolerance
+  EXPECT_DOUBLE_EQ(50.0, zoneRadius(a, b, c, 1.0, 100.0));
+  EXPECT_DOUBLE_EQ(30.0, zoneRadius(a, b, c, 1.0, 30.0));
+  EXPECT_DOUBLE_EQ(1.0 / std::sin(M_PI / 4), zoneRadius(a, b, d, 1.0, 100.0));
+  EXPECT_DOUBLE_EQ(5.0, zoneRadius(a, b, e, 10.0, 100.0));
+  EXPECT_DOUBLE_EQ(1.0, zoneRadius(a, b, a, 1.0, 100.0));
+  EXPECT_DOUBLE_EQ(0.0, zoneRadius(a, b, b, 1.0, 100.0));
+
+  EXPECT_EQ(0.0, quantizeZone(0.9));
+  EXPECT_EQ(1.0, quantizeZone(1.41));
+  EXPECT_EQ(25.0, quantizeZone(29.9));
+  EXPECT_EQ(200.0, quantizeZone(500.0));
+
+  EXPECT_EQ("fine", zoneName(FINE_ZONE));
+  EXPECT_EQ("z0", zoneName(0.0));
+  EXPECT_EQ("z40", zoneName(40.0));
+  EXPECT_EQ("zPath_7", zoneName(7.0));
+}
+
+TEST(ZonePlanning, stopsOnlyAtEvents)
+{
+  const Plan plan(true);
+  const std::vector<MoveData> moves = planMoves(plan.points, plan.start, plan.end, plan.params);
+  ASSERT_EQ(plan.points.size(), moves.size());
+
+  for (std::size_t i = 0; i < moves.size(); ++i)
+  {
+    const bool event = i == 0 || i + 1 == plan.start || i + 1 == plan.end || i + 1 == moves.size();
+    EXPECT_EQ(event, moves[i].zone == FINE_ZONE) << "at point " << i;
+  }
+
+  // The passes run at the plan's 50 mm/s, with large zones between the corners
+  EXPECT_EQ(50.0, moves[plan.start + 5].speed);
+  EXPECT_EQ(5.0, moves[plan.start + 5].zone);
+  EXPECT_EQ(0.0, moves[1].speed);
+}
+
+TEST(ZonePlanning, plannedZonesShortenTheCycle)
+{
+  const Plan plan(true);
+  const double fixed =
+      estimateCycleTime(plan.points, fixedMoves(plan.points, plan.start, plan.end, plan.params), plan.start,
+                        plan.end, plan.params);
+  const double planned =
+      estimateCycleTime(plan.points, planMoves(plan.points, plan.start, plan.end, plan.params), plan.start,
+                        plan.end, plan.params);
+
+  // The moves alone take 3 s on the approach and retract and 7 s on the passes
+  EXPECT_GT(planned, 10.0);
+  EXPECT_LT(planned, fixed);
+}
+
+TEST(RapidEmitter, plannedProgram)
+{
+  const std::string program = emit(Plan(true));
+  expectGolden("blend_planned.mod", program);
+
+  // Each declaration appears once
+  std::istringstream lines(program);
+  std::string line;
+  int zones = 0, speeds = 0;
+  while (std::getline(lines, line))
+  {
+    zones += line.find("CONST zonedata") == 0;
+    speeds += line.find("CONST speeddata vPath_") == 0;
+  }
+  EXPECT_EQ(1, zones);
+  EXPECT_EQ(1, speeds);
+}
+
+TEST(RapidEmitter, programWithoutPositionsKeepsFixedZones)
+{
+  expectGolden("blend_fixed.mod", emit(Plan(false)));
+}
+
+TEST(RapidEmitter, wolfwareProgram)
+{
+  Plan plan(true);
+  plan.params.wolf_mode = true;
+  expectGolden("blend_wolf.mod", emit(plan));
+}
+
+TEST(RapidEmitter, jointTrajectoryProgram)
+{
+  const Plan plan(true);
+  std::ostringstream os;
+  ASSERT_TRUE(emitJointTrajectoryFile(os, plan.points, plan.params));
+  expectGolden("joint_trajectory.mod", os.str());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,35 @@
+#ifndef ABB_IRB1200_IKFAST_SOLVER_H
+#define ABB_IRB1200_IKFAST_SOLVER_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * The generated IKFast solver of the IRB1200 5/0.9, without the MoveIt kinematics plugin that
+ * wraps it. Poses are of tool0 relative to base_link; joints are in the order of the manipulator
+ * group, joint_1 to joint_6.
+ */
+
+namespace abb_irb1200_ikfast
+{
+
+const static int NUM_JOINTS = 6;
+
+/**
+ * @brief All closed-form solutions for a pose, with every joint within [-pi, pi]
+ * @param translation Position of tool0 (m)
+ * @param rotation Orientation of tool0 as a row-major 3x3 matrix
+ * @param solutions NUM_JOINTS values per solution are appended to it. Keep the vector between
+ * calls and clear it to reuse its storage.
+ * @return The number of solutions appended
+ */
+std::size_t computeIk(const double translation[3], const double rotation[9], std::vector<double>& solutions);
+
+/**
+ * @brief Pose of tool0 for a joint position
+ */
+void computeFk(const double joints[NUM_JOINTS], double translation[3], double rotation[9]);
+
+} // namespace abb_irb1200_ikfast
+
+#endif // ABB_IRB1200_IKFAST_SOLVER_H
@@ -0,0 +1,39 @@
+/*
+ * The generated solver as a library of its own, for callers that want its solutions without
+ * going through the MoveIt kinematics plugin (abb_irb1200_descartes). The generated code is
+ * enclosed in a namespace so that it can share a process with the plugin.
+ */
+
+#include <abb_irb1200_5_90_ikfast_manipulator_plugin/abb_irb1200_ikfast_solver.h>
+
+#define IKFAST_NO_MAIN
+#define IKFAST_NAMESPACE abb_irb1200_ikfast_generated
+#include "abb_irb1200_5_90_manipulator_ikfast_solver.cpp"
+
+namespace abb_irb1200_ikfast
+{
+
+std::size_t computeIk(const double translation[3], const double rotation[9], std::vector<double>& solutions)
+{
+  using namespace abb_irb1200_ikfast_generated;
+
+  // The solution list allocates as it fills; one per thread keeps its storage between calls
+  thread_local ikfast::IkSolutionList<IkReal> list;
+  list.Clear();
+  if (!ComputeIk(translation, rotation, NULL, list))
+    return 0;
+
+  const std::size_t count = list.GetNumSolutions();
+  const std::size_t offset = solutions.size();
+  solutions.resize(offset + count * NUM_JOINTS);
+  for (std::size_t i = 0; i < count; ++i)
+    list.GetSolution(i).GetSolution(&solutions[offset + i * NUM_JOINTS], NULL);
+  return count;
+}
+
+void computeFk(const double joints[NUM_JOINTS], double translation[3], double rotation[9])
+{
+  abb_irb1200_ikfast_generated::ComputeFk(joints, translation, rotation);
+}
+
+} // namespace abb_irb1200_ikfast
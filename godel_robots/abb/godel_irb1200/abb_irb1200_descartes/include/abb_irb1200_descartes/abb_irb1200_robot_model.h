@@ -0,0 +1,62 @@
+/*
+  Copyright 2016, Southwest Research Institute
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+          http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef ABB_IRB1200_ROBOT_MODEL_H
+#define ABB_IRB1200_ROBOT_MODEL_H
+
+#include <descartes_moveit/moveit_state_adapter.h>
+
+namespace abb_irb1200_descartes
+{
+/**
+ * @brief Descartes robot model of the IRB1200 5/0.9 that calls its IKFast solver directly, like
+ * AbbIrb2400RobotModel does for the IRB2400, instead of going through the MoveIt kinematics
+ * plugin. Solutions are checked against the joint limits and with the adapter's one robot
+ * state for collisions.
+ */
+class AbbIrb1200RobotModel : public descartes_moveit::MoveitStateAdapter
+{
+public:
+  AbbIrb1200RobotModel();
+
+  virtual bool initialize(const std::string& robot_description, const std::string& group_name,
+                          const std::string& world_frame, const std::string& tcp_frame);
+
+  /**
+   * @brief All valid IKFast solutions, plus the ones that reach the same pose with joints turned
+   * a full revolution further, as far as their limits allow
+   */
+  virtual bool getAllIK(const Eigen::Affine3d& pose,
+                        std::vector<std::vector<double> >& joint_poses) const;
+
+  virtual descartes_core::RobotModelPtr clone() const
+  {
+    descartes_core::RobotModelPtr ptr(new AbbIrb1200RobotModel());
+    ptr->initialize(robot_description_, group_name_, world_frame_, tool_frame_);
+    return ptr;
+  }
+
+protected:
+  std::string robot_description_;
+  descartes_core::Frame world_to_base_; // world to arm base
+  descartes_core::Frame tool_to_tip_;   // from urdf tool to arm tool
+  std::vector<double> joint_min_;
+  std::vector<double> joint_max_;
+  mutable std::vector<double> solutions_; // IKFast output, kept to reuse its storage
+};
+}
+
+#endif // ABB_IRB1200_ROBOT_MODEL_H
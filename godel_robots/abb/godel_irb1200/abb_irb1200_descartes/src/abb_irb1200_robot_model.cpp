@@ -0,0 +1,144 @@
+/*
+  Copyright 2016, Southwest Research Institute
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+          http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <abb_irb1200_descartes/abb_irb1200_robot_model.h>
+#include <abb_irb1200_5_90_ikfast_manipulator_plugin/abb_irb1200_ikfast_solver.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <cmath>
+#include <limits>
+
+// The frames the IKFast solver was generated for
+static const std::string IRB1200_BASE_LINK = "base_link";
+static const std::string IRB1200_TOOL_LINK = "tool0";
+
+static const double REVOLUTION_OFFSETS[] = {0.0, 2 * M_PI, -2 * M_PI};
+
+using namespace descartes_moveit;
+
+namespace abb_irb1200_descartes
+{
+AbbIrb1200RobotModel::AbbIrb1200RobotModel()
+    : world_to_base_(Eigen::Affine3d::Identity()), tool_to_tip_(Eigen::Affine3d::Identity())
+{
+}
+
+bool AbbIrb1200RobotModel::initialize(const std::string& robot_description,
+                                      const std::string& group_name, const std::string& world_frame,
+                                      const std::string& tcp_frame)
+{
+  if (!MoveitStateAdapter::initialize(robot_description, group_name, world_frame, tcp_frame))
+    return false;
+  robot_description_ = robot_description;
+
+  if (getDOF() != abb_irb1200_ikfast::NUM_JOINTS)
+  {
+    ROS_ERROR_STREAM("Group '" << group_name << "' has " << getDOF() << " joints; the IRB1200 solver needs "
+                     << abb_irb1200_ikfast::NUM_JOINTS);
+    return false;
+  }
+
+  // initialize world transformations
+  if (tcp_frame != IRB1200_TOOL_LINK)
+  {
+    tool_to_tip_ = descartes_core::Frame(robot_state_->getFrameTransform(tcp_frame).inverse() *
+                                         robot_state_->getFrameTransform(IRB1200_TOOL_LINK));
+  }
+
+  if (world_frame != IRB1200_BASE_LINK)
+  {
+    world_to_base_ = descartes_core::Frame(world_to_root_.frame *
+                                           robot_state_->getFrameTransform(IRB1200_BASE_LINK));
+  }
+
+  joint_min_.clear();
+  joint_max_.clear();
+  for (const moveit::core::JointModel* joint : joint_group_->getActiveJointModels())
+  {
+    const moveit::core::VariableBounds& bounds = joint->getVariableBounds()[0];
+    joint_min_.push_back(bounds.position_bounded_ ? bounds.min_position_ : -std::numeric_limits<double>::max());
+    joint_max_.push_back(bounds.position_bounded_ ? bounds.max_position_ : std::numeric_limits<double>::max());
+  }
+
+  return true;
+}
+
+bool AbbIrb1200RobotModel::getAllIK(const Eigen::Affine3d& pose,
+                                    std::vector<std::vector<double> >& joint_poses) const
+{
+  const Eigen::Affine3d tool_pose = world_to_base_.frame_inv * pose * tool_to_tip_.frame;
+  double translation[3], rotation[9];
+  for (int i = 0; i < 3; ++i)
+  {
+    translation[i] = tool_pose.translation()(i);
+    for (int j = 0; j < 3; ++j)
+      rotation[3 * i + j] = tool_pose.linear()(i, j);
+  }
+
+  solutions_.clear();
+  const std::size_t count = abb_irb1200_ikfast::computeIk(translation, rotation, solutions_);
+
+  joint_poses.clear();
+  const int dof = abb_irb1200_ikfast::NUM_JOINTS;
+  std::vector<double> sol(dof);
+  for (std::size_t s = 0; s < count; ++s)
+  {
+    const double* solution = &solutions_[s * dof];
+
+    // IKFast returns the unique configurations of the robot (e.g. elbow up, wrist down) with
+    // joint values between -pi and +pi. Joints whose limits go beyond that (3, 4 and 6 on the
+    // IRB1200) also reach the same configuration a revolution further, so each joint gets every
+    // value within its limits, and each combination of them is checked for collisions.
+    double values[abb_irb1200_ikfast::NUM_JOINTS][3];
+    int counts[abb_irb1200_ikfast::NUM_JOINTS];
+    bool reachable = true;
+    for (int j = 0; j < dof; ++j)
+    {
+      counts[j] = 0;
+      for (double offset : REVOLUTION_OFFSETS)
+      {
+        const double value = solution[j] + offset;
+        if (value >= joint_min_[j] && value <= joint_max_[j])
+          values[j][counts[j]++] = value;
+      }
+      reachable = reachable && counts[j] > 0;
+    }
+    if (!reachable)
+      continue;
+
+    int index[abb_irb1200_ikfast::NUM_JOINTS] = {0};
+    while (true)
+    {
+      for (int j = 0; j < dof; ++j)
+        sol[j] = values[j][index[j]];
+      if (isValid(sol))
+        joint_poses.push_back(sol);
+
+      // Next combination, counting up from the last joint
+      int j = dof - 1;
+      while (j >= 0 && ++index[j] == counts[j])
+        index[j--] = 0;
+      if (j < 0)
+        break;
+    }
+  }
+
+  return !joint_poses.empty();
+}
+
+}
+
+PLUGINLIB_EXPORT_CLASS(abb_irb1200_descartes::AbbIrb1200RobotModel, descartes_core::RobotModel)
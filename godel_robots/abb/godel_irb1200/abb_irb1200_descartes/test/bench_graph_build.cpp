@@ -0,0 +1,121 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Descartes planning graph construction for an IRB1200 blending raster, with the robot model
+ * the launch files used to configure (descartes_moveit/IkFastMoveitStateAdapter, argument 0)
+ * and with AbbIrb1200RobotModel (argument 1). The raster has RASTER_LINES lines of
+ * RASTER_POINTS points around a reachable pose, each free to turn about the tool's z axis in 15
+ * degree steps like the blend planner's points. GetAllIK is one such orientation. Needs the
+ * IRB1200 description on the parameter server, see launch/bench_graph_build.launch.
+ */
+
+#include <abb_irb1200_descartes/abb_irb1200_robot_model.h>
+#include <benchmark/benchmark.h>
+#include <descartes_moveit/ikfast_moveit_state_adapter.h>
+#include <descartes_planner/planning_graph.h>
+#include <descartes_trajectory/axial_symmetric_pt.h>
+#include <ros/ros.h>
+
+#include <iostream>
+
+namespace
+{
+
+const static std::string ROBOT_DESCRIPTION = "robot_description";
+const static std::string GROUP = "manipulator_tcp";
+const static std::string WORLD_FRAME = "world_frame";
+const static std::string TCP_FRAME = "tcp_frame";
+
+const static int RASTER_LINES = 5;
+const static int RASTER_POINTS = 20;
+const static double RASTER_SPACING = 0.01; // m
+const static double ANGLE_DISCRETIZATION = M_PI / 12.0;
+const static std::vector<double> NOMINAL_JOINTS = {0.0, 0.3, 0.2, 0.0, 1.0, 0.0};
+
+descartes_core::RobotModelPtr models[2];
+Eigen::Affine3d nominal_pose;
+
+std::vector<descartes_core::TrajectoryPtPtr> raster()
+{
+  std::vector<descartes_core::TrajectoryPtPtr> points;
+  for (int line = 0; line < RASTER_LINES; ++line)
+  {
+    for (int i = 0; i < RASTER_POINTS; ++i)
+    {
+      const Eigen::Vector3d offset((i - RASTER_POINTS / 2) * RASTER_SPACING,
+                                   (line - RASTER_LINES / 2) * RASTER_SPACING, 0.0);
+      points.push_back(boost::make_shared<descartes_trajectory::AxialSymmetricPt>(
+          nominal_pose * Eigen::Translation3d(offset), ANGLE_DISCRETIZATION,
+          descartes_trajectory::AxialSymmetricPt::Z_AXIS));
+    }
+  }
+  return points;
+}
+
+void BM_GetAllIK(benchmark::State& state)
+{
+  const descartes_core::RobotModel& model = *models[state.range(0)];
+  std::vector<std::vector<double>> solutions;
+  for (auto _ : state)
+  {
+    if (!model.getAllIK(nominal_pose, solutions))
+      state.SkipWithError("The nominal pose has no solutions");
+    benchmark::DoNotOptimize(solutions.data());
+  }
+  state.counters["solutions"] = solutions.size();
+}
+
+void BM_BuildGraph(benchmark::State& state)
+{
+  const std::vector<descartes_core::TrajectoryPtPtr> points = raster();
+  for (auto _ : state)
+  {
+    descartes_planner::PlanningGraph graph(models[state.range(0)]);
+    if (!graph.insertGraph(points))
+      state.SkipWithError("Unable to build the graph");
+  }
+  state.counters["points"] = points.size();
+}
+
+} // end anon namespace
+
+BENCHMARK(BM_GetAllIK)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BuildGraph)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "bench_graph_build", ros::init_options::NoSigintHandler);
+  benchmark::Initialize(&argc, argv);
+
+  models[0].reset(new descartes_moveit::IkFastMoveitStateAdapter);
+  models[1].reset(new abb_irb1200_descartes::AbbIrb1200RobotModel);
+  for (const auto& model : models)
+  {
+    if (!model->initialize(ROBOT_DESCRIPTION, GROUP, WORLD_FRAME, TCP_FRAME))
+    {
+      std::cerr << "Unable to load the robot model from '" << ROBOT_DESCRIPTION << "'\n";
+      return 1;
+    }
+  }
+  if (!models[0]->getFK(NOMINAL_JOINTS, nominal_pose))
+    return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,172 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <abb_irb1200_descartes/abb_irb1200_robot_model.h>
+#include <descartes_moveit/ikfast_moveit_state_adapter.h>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+
+using abb_irb1200_descartes::AbbIrb1200RobotModel;
+typedef std::vector<std::vector<double>> Solutions;
+
+namespace
+{
+
+const static std::string ROBOT_DESCRIPTION = "robot_description";
+const static std::string GROUP = "manipulator_tcp";
+const static std::string WORLD_FRAME = "world_frame";
+const static std::string TCP_FRAME = "tcp_frame";
+const static int SAMPLES = 200;
+const static double TOLERANCE = 1e-5;
+
+bool contains(const Solutions& solutions, const std::vector<double>& joints)
+{
+  for (const auto& s : solutions)
+  {
+    double diff = 0.0;
+    for (std::size_t i = 0; i < s.size(); ++i)
+      diff = std::max(diff, std::abs(s[i] - joints[i]));
+    if (diff < TOLERANCE)
+      return true;
+  }
+  return false;
+}
+
+bool withinPi(const std::vector<double>& joints)
+{
+  for (double j : joints)
+  {
+    if (std::abs(j) > M_PI)
+      return false;
+  }
+  return true;
+}
+
+class AbbIrb1200RobotModelTest : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    model_.reset(new AbbIrb1200RobotModel);
+    ASSERT_TRUE(model_->initialize(ROBOT_DESCRIPTION, GROUP, WORLD_FRAME, TCP_FRAME));
+    adapter_.reset(new descartes_moveit::IkFastMoveitStateAdapter);
+    ASSERT_TRUE(adapter_->initialize(ROBOT_DESCRIPTION, GROUP, WORLD_FRAME, TCP_FRAME));
+  }
+
+  static void TearDownTestCase()
+  {
+    model_.reset();
+    adapter_.reset();
+  }
+
+  // Reachable, collision free poses with the configuration they were sampled at
+  static std::vector<std::pair<Eigen::Affine3d, std::vector<double>>> samplePoses()
+  {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const std::vector<double> lower = {-2.967, -1.745, -3.491, -4.712, -2.269, -6.283};
+    const std::vector<double> upper = {2.967, 2.269, 1.222, 4.712, 2.269, 6.283};
+
+    std::vector<std::pair<Eigen::Affine3d, std::vector<double>>> poses;
+    while (poses.size() < static_cast<std::size_t>(SAMPLES))
+    {
+      std::vector<double> joints(6);
+      for (std::size_t i = 0; i < joints.size(); ++i)
+        joints[i] = lower[i] + unit(rng) * (upper[i] - lower[i]);
+      Eigen::Affine3d pose;
+      if (adapter_->isValid(joints) && adapter_->getFK(joints, pose))
+        poses.push_back(std::make_pair(pose, joints));
+    }
+    return poses;
+  }
+
+  static std::unique_ptr<AbbIrb1200RobotModel> model_;
+  static std::unique_ptr<descartes_moveit::IkFastMoveitStateAdapter> adapter_;
+};
+
+std::unique_ptr<AbbIrb1200RobotModel> AbbIrb1200RobotModelTest::model_;
+std::unique_ptr<descartes_moveit::IkFastMoveitStateAdapter> AbbIrb1200RobotModelTest::adapter_;
+
+} // end anon namespace
+
+TEST_F(AbbIrb1200RobotModelTest, findsTheSolutionsOfTheMoveitAdapter)
+{
+  for (const auto& sample : samplePoses())
+  {
+    Solutions ours, theirs;
+    EXPECT_TRUE(model_->getAllIK(sample.first, ours));
+    adapter_->getAllIK(sample.first, theirs);
+
+    for (const auto& s : theirs)
+      EXPECT_TRUE(contains(ours, s));
+
+    // Apart from the extra revolutions, the solutions are the same
+    for (const auto& s : ours)
+    {
+      if (withinPi(s))
+        EXPECT_TRUE(contains(theirs, s));
+    }
+  }
+}
+
+TEST_F(AbbIrb1200RobotModelTest, solutionsReachThePose)
+{
+  for (const auto& sample : samplePoses())
+  {
+    Solutions ours;
+    ASSERT_TRUE(model_->getAllIK(sample.first, ours));
+    // The configuration the pose was sampled at is among them, even beyond +-pi
+    EXPECT_TRUE(contains(ours, sample.second));
+
+    for (const auto& s : ours)
+    {
+      Eigen::Affine3d pose;
+      ASSERT_TRUE(adapter_->getFK(s, pose));
+      EXPECT_TRUE(pose.isApprox(sample.first, 1e-6));
+      EXPECT_TRUE(model_->isValid(s));
+    }
+  }
+}
+
+TEST_F(AbbIrb1200RobotModelTest, clonesAreEquivalent)
+{
+  const descartes_core::RobotModelPtr clone = model_->clone();
+  for (const auto& sample : samplePoses())
+  {
+    Solutions ours, cloned;
+    model_->getAllIK(sample.first, ours);
+    clone->getAllIK(sample.first, cloned);
+    ASSERT_EQ(ours.size(), cloned.size());
+    for (const auto& s : cloned)
+      EXPECT_TRUE(contains(ours, s));
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_abb_irb1200_robot_model");
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+  return RUN_ALL_TESTS();
+}
@@ -37,8 +37,9 @@ public:
   virtual descartes_core::RobotModelPtr clone() const
   {
     descartes_core::RobotModelPtr ptr(new AbbIrb2400RobotModel());
-    ptr->initialize("robot_description", descartes_moveit::MoveitStateAdapter::group_name_,
-                    world_frame_, tool_frame_);
+    // The description this model was loaded from, e.g. the model cache's copy
+    ptr->initialize(kinematics::KinematicsBase::robot_description_,
+                    descartes_moveit::MoveitStateAdapter::group_name_, world_frame_, tool_frame_);
     return ptr;
   }
 
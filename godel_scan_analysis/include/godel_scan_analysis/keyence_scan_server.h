@@ -9,6 +9,8 @@
 
 #include <tf/transform_listener.h>
 
+#include <godel_utils/memory_accounting.h>
+
 #include "godel_scan_analysis/scan_roughness_scoring.h"
 
 namespace godel_scan_analysis
@@ -27,8 +29,11 @@ struct ScanServerConfig
 
 /**
  * Defines the ROS interface for a surface-quality-map
+ *
+ * The map only grows while scans arrive. When it is over its memory budget it is first compacted
+ * to one point per voxel (the resolution it is published at) and then its oldest points are dropped.
  */
-class ScanServer
+class ScanServer : public godel_utils::memory::AccountedStore
 {
 public:
   typedef pcl::PointCloud<pcl::PointXYZRGB> ColorCloud;
@@ -58,8 +63,15 @@ public:
    */
   void clear();
 
+  std::string storeName() const { return "scan_map"; }
+  std::size_t bytesUsed() const;
+
+protected:
+  void evict(std::size_t target_bytes);
+
 private:
   void transformScan(ColorCloud& cloud, const ros::Time& tm) const;
+  void compact(const ColorCloud::ConstPtr& in, ColorCloud& out) const;
   tf::StampedTransform findTransform(const ros::Time& tm) const;
 
   RoughnessScorer scorer_; /** Object that scores individual lines */
@@ -7,6 +7,7 @@ const static std::string DEFAULT_WORLD_FRAME = "world_frame";
 const static std::string DEFAULT_SCAN_FRAME = "keyence_sensor_optical_frame";
 const static double VOXEL_GRID_LEAF_SIZE = 0.005;    // 5 mm
 const static double VOXEL_GRID_PUBLISH_PERIOD = 2.0; // seconds
+const static double MEMORY_DIAGNOSTICS_PERIOD = 5.0; // seconds
 
 const static std::string DEFAULT_RESET_SERVICE = "reset_scan_server";
 
@@ -37,6 +38,12 @@ int main(int argc, char** argv)
                     VOXEL_GRID_PUBLISH_PERIOD);
 
   godel_scan_analysis::ScanServer server(config);
+  server.setBudget(godel_utils::memory::loadBudget(ros::NodeHandle("~/memory"), server.storeName()));
+
+  // Scans and the monitor's timer are both handled by the single spin thread
+  godel_utils::memory::MemoryMonitor memory_monitor(ros::this_node::getName());
+  memory_monitor.add(server);
+  memory_monitor.startPublishing(nh, MEMORY_DIAGNOSTICS_PERIOD, true);
 
   // Advertise a service that enables outside nodes to reset the accumulated cloud
   ros::ServiceServer reset_service =
@@ -37,6 +37,7 @@ void godel_scan_analysis::ScanServer::scanCallback(const Cloud& cloud)
     transformScan(*buffer_, stamp);
     // Insert into results cloud
     map_->insert(map_->end(), buffer_->begin(), buffer_->end());
+    enforceHardBudget();
   }
   catch (const tf::TransformException& ex)
   {
@@ -63,6 +64,49 @@ void godel_scan_analysis::ScanServer::publishCloud(const ros::TimerEvent&) const
 void godel_scan_analysis::ScanServer::clear()
 {
   map_->clear();
+  map_->points.shrink_to_fit();
+}
+
+std::size_t godel_scan_analysis::ScanServer::bytesUsed() const
+{
+  return godel_utils::memory::cloudBytes(*map_) + godel_utils::memory::cloudBytes(*buffer_);
+}
+
+void godel_scan_analysis::ScanServer::evict(std::size_t target_bytes)
+{
+  const std::size_t buffer_bytes = godel_utils::memory::cloudBytes(*buffer_);
+  const std::size_t max_points =
+      target_bytes > buffer_bytes ? (target_bytes - buffer_bytes) / sizeof(ColorCloud::PointType) : 0;
+
+  // Points closer together than the published resolution are merged first
+  ColorCloud::Ptr compacted(new ColorCloud);
+  compact(map_, *compacted);
+
+  // If that is not enough the oldest scans go. Compaction doesn't keep the order of the points,
+  // so they are dropped from the map as received and the rest is compacted again.
+  if (compacted->size() > max_points)
+  {
+    const std::size_t keep = map_->size() * max_points / compacted->size();
+    ROS_WARN_STREAM_THROTTLE(10.0, "Scan map over its memory budget, dropping the oldest "
+                                       << map_->size() - keep << " points");
+    map_->erase(map_->begin(), map_->begin() + (map_->size() - keep));
+    compact(map_, *compacted);
+    if (compacted->size() > max_points)
+      compacted->resize(max_points);
+  }
+
+  compacted->points.shrink_to_fit();
+  compacted->header = map_->header;
+  map_ = compacted;
+}
+
+void godel_scan_analysis::ScanServer::compact(const ColorCloud::ConstPtr& in, ColorCloud& out) const
+{
+  pcl::VoxelGrid<pcl::PointXYZRGB> vg;
+  vg.setInputCloud(in);
+  vg.setLeafSize(config_.voxel_grid_leaf_size, config_.voxel_grid_leaf_size,
+                 config_.voxel_grid_leaf_size);
+  vg.filter(out);
 }
 
 void godel_scan_analysis::ScanServer::transformScan(ColorCloud& cloud, const ros::Time& tm) const
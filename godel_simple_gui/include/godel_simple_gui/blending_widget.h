@@ -8,6 +8,9 @@
 #include "actionlib/client/simple_action_client.h"
 #include "godel_msgs/SelectMotionPlanAction.h"
 #include "godel_msgs/SelectMotionPlanActionGoal.h"
+#include "godel_msgs/ProcessPlanningAction.h"
+#include <atomic>
+#include <mutex>
 
 namespace Ui
 {
@@ -22,7 +25,7 @@ namespace godel_simple_gui
  * 2. Scanning State (Robot Scans)
  * 3. Surface Select State (User selects surfaces)
  * 4. Planning State (Godel path plans)
- * 5. Select Plans State (User selects plans)
+ * 5. Select Plans State (User selects plans; available as soon as the first surface is planned)
  * 6. Simulating State (Simulated robot executes motion)
  * 7. Waiting to Execute State (User selects next)
  * 8. Execute State (Simulated robot executes motion)
@@ -49,14 +52,32 @@ public:
   void sendGoal(const godel_msgs::SelectMotionPlanActionGoal& goal);
   void sendGoalAndWait(const godel_msgs::SelectMotionPlanActionGoal& goal);
   bool planSelectionEmpty();
+  void appendPlans(const std::vector<std::string>& plan_names);
+
+  // Process planning runs in the background, independent of the active state, so that plans
+  // can be simulated and executed while later surfaces are still being planned
+  void startPlanning(const godel_msgs::PathPlanningParameters& params);
+  void cancelPlanning();
+  bool planningActive() const { return planning_active_; }
+  std::vector<std::string> plannedPlans() const;
 
   ros::NodeHandle& nodeHandle() { return nh_; }
 
   OptionsSubmenu& options() { return *options_; }
 
+Q_SIGNALS:
+  // Emitted from the planning action callbacks
+  void planningFeedback(QString text);
+  void plansAvailable();
+  void planningFinished(bool succeeded);
+
 protected:
   void loadParameters();
 
+  void processPlanningDoneCallback(const actionlib::SimpleClientGoalState& state,
+                                   const godel_msgs::ProcessPlanningResultConstPtr& result);
+  void processPlanningFeedbackCallback(const godel_msgs::ProcessPlanningFeedbackConstPtr& feedback);
+
 protected Q_SLOTS:
   // Button Handlers
   void onNextButton();
@@ -81,6 +102,12 @@ protected:
   GuiState* active_state_;
   ros::ServiceClient surface_blending_parameters_client_;
   actionlib::SimpleActionClient<godel_msgs::SelectMotionPlanAction> select_motion_plan_action_client_;
+  actionlib::SimpleActionClient<godel_msgs::ProcessPlanningAction> process_planning_action_client_;
+
+  // Plans received from the active planning goal
+  std::atomic<bool> planning_active_;
+  mutable std::mutex planned_plans_mutex_;
+  std::vector<std::string> planned_plans_;
 
 };
 }
@@ -4,34 +4,25 @@
 #include "godel_simple_gui/gui_state.h"
 #include <ros/ros.h>
 
-#include <actionlib/client/simple_action_client.h>
-#include <godel_msgs/PathPlanningParameters.h>
-#include <godel_msgs/ProcessPlanningAction.h>
-
-const static std::string PROCESS_PLANNING_ACTION_SERVER_NAME = "process_planning_as";
-
 namespace godel_simple_gui
 {
 
+/**
+ * @brief Starts process planning and reports its progress. Planning itself is owned by the
+ * BlendingWidget, so once the first surface is planned the user may move on to simulate or
+ * execute its plans while the remaining surfaces are planned in the background.
+ */
 class PlanningState : public GuiState
 {
   Q_OBJECT
 private:
-  ros::NodeHandle nh_;
-  actionlib::SimpleActionClient<godel_msgs::ProcessPlanningAction> process_planning_action_client_;
   BlendingWidget* gui_ptr_;
-
-  void makeRequest(godel_msgs::PathPlanningParameters params);
-  void processPlanningDoneCallback(const actionlib::SimpleClientGoalState& state,
-              const godel_msgs::ProcessPlanningResultConstPtr& result);
-  void processPlanningActiveCallback();
-  void processPlanningFeedbackCallback(const godel_msgs::ProcessPlanningFeedbackConstPtr& feedback);
-
-Q_SIGNALS:
-  void feedbackReceived(QString feedback);
+  bool plans_ready_;
 
 protected Q_SLOTS:
   void setFeedbackText(QString feedback);
+  void onPlansAvailable();
+  void onPlanningFinished(bool succeeded);
 
 public:
   PlanningState();
@@ -20,7 +20,15 @@ public:
   virtual void onBack(BlendingWidget& gui);
   virtual void onReset(BlendingWidget& gui);
 
+protected Q_SLOTS:
+  // Picks up plans of surfaces that finished planning after this state was entered
+  void refreshPlans();
+
 private:
+  void fetchPlanNames(std::vector<std::string>& names);
+  void updateLabel();
+
+  BlendingWidget* gui_ptr_;
   std::vector<std::string> plan_names_;
 };
 }
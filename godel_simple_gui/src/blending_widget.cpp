@@ -6,11 +6,14 @@
 
 const std::string SURFACE_BLENDING_PARAMETERS_SERVICE = "surface_blending_parameters";
 const static std::string SELECT_MOTION_PLAN_ACTION_SERVER_NAME = "select_motion_plan_as";
+const static std::string PROCESS_PLANNING_ACTION_SERVER_NAME = "process_planning_as";
 
 godel_simple_gui::BlendingWidget::BlendingWidget(QWidget* parent)
     : QWidget(parent),
       active_state_(NULL),
-      select_motion_plan_action_client_(SELECT_MOTION_PLAN_ACTION_SERVER_NAME, true)
+      select_motion_plan_action_client_(SELECT_MOTION_PLAN_ACTION_SERVER_NAME, true),
+      process_planning_action_client_(PROCESS_PLANNING_ACTION_SERVER_NAME, true),
+      planning_active_(false)
 {
   // UI setup
   ui_ = new Ui::BlendingWidget;
@@ -178,3 +181,70 @@ bool godel_simple_gui::BlendingWidget::planSelectionEmpty()
 {
   return (ui_->plan_list_widget->currentItem() == NULL);
 }
+
+void godel_simple_gui::BlendingWidget::appendPlans(const std::vector<std::string>& plan_names)
+{
+  for(const auto& plan : plan_names)
+  {
+    QListWidgetItem* item = new QListWidgetItem();
+    item->setText(QString::fromStdString(plan));
+    ui_->plan_list_widget->addItem(item);
+  }
+}
+
+void godel_simple_gui::BlendingWidget::startPlanning(const godel_msgs::PathPlanningParameters& params)
+{
+  {
+    std::lock_guard<std::mutex> lock(planned_plans_mutex_);
+    planned_plans_.clear();
+  }
+  planning_active_ = true;
+
+  godel_msgs::ProcessPlanningGoal goal;
+  goal.action = godel_msgs::ProcessPlanningGoal::GENERATE_MOTION_PLAN_AND_PREVIEW;
+  goal.params = params;
+  process_planning_action_client_.sendGoal(
+        goal,
+        boost::bind(&godel_simple_gui::BlendingWidget::processPlanningDoneCallback, this, _1, _2),
+        actionlib::SimpleActionClient<godel_msgs::ProcessPlanningAction>::SimpleActiveCallback(),
+        boost::bind(&godel_simple_gui::BlendingWidget::processPlanningFeedbackCallback, this, _1));
+  ROS_INFO_STREAM("Process planning goal sent");
+}
+
+void godel_simple_gui::BlendingWidget::cancelPlanning()
+{
+  if (planning_active_)
+  {
+    ROS_INFO_STREAM("Cancelling process planning");
+    process_planning_action_client_.cancelGoal();
+  }
+}
+
+std::vector<std::string> godel_simple_gui::BlendingWidget::plannedPlans() const
+{
+  std::lock_guard<std::mutex> lock(planned_plans_mutex_);
+  return planned_plans_;
+}
+
+void godel_simple_gui::BlendingWidget::processPlanningDoneCallback(
+    const actionlib::SimpleClientGoalState& state,
+    const godel_msgs::ProcessPlanningResultConstPtr& result)
+{
+  planning_active_ = false;
+  Q_EMIT planningFinished(state == actionlib::SimpleClientGoalState::SUCCEEDED && result && result->succeeded);
+}
+
+void godel_simple_gui::BlendingWidget::processPlanningFeedbackCallback(
+    const godel_msgs::ProcessPlanningFeedbackConstPtr& feedback)
+{
+  Q_EMIT planningFeedback(QString::fromStdString(feedback->last_completed));
+
+  if (!feedback->plan_names.empty())
+  {
+    {
+      std::lock_guard<std::mutex> lock(planned_plans_mutex_);
+      planned_plans_.insert(planned_plans_.end(), feedback->plan_names.begin(), feedback->plan_names.end());
+    }
+    Q_EMIT plansAvailable();
+  }
+}
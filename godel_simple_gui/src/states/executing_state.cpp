@@ -6,6 +6,7 @@
 #include "godel_simple_gui/states/error_state.h"
 #include "godel_simple_gui/blending_widget.h"
 #include "godel_simple_gui/states/scan_teach_state.h"
+#include "godel_simple_gui/states/select_plans_state.h"
 
 const static std::string SELECT_MOTION_PLAN_SERVICE = "select_motion_plan";
 
@@ -47,7 +48,11 @@ void godel_simple_gui::ExecutingState::executeAll(BlendingWidget& gui)
       executeOne(plan_names_[i], gui);
     }
 
-    Q_EMIT newStateAvailable(new ScanTeachState());
+    // More plans may still arrive from surfaces that are being planned
+    if (gui.planningActive())
+      Q_EMIT newStateAvailable(new SelectPlansState());
+    else
+      Q_EMIT newStateAvailable(new ScanTeachState());
   }
   catch (const BadExecutionError& err)
   {
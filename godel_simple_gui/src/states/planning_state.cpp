@@ -1,72 +1,72 @@
 #include <ros/console.h>
-#include <QtConcurrent/QtConcurrentRun>
 #include "godel_simple_gui/blending_widget.h"
 #include "godel_simple_gui/states/planning_state.h"  // previous
 #include "godel_simple_gui/states/surface_select_state.h"  // next if fail
 #include "godel_simple_gui/states/select_plans_state.h" // next is success
 #include "godel_simple_gui/states/select_all_surface_state.h"
+#include "godel_simple_gui/states/scan_teach_state.h" // reset
 
-const static std::string PROCESS_PATH_SERVICE = "process_path";
+godel_simple_gui::PlanningState::PlanningState() : gui_ptr_(NULL), plans_ready_(false) {}
 
-godel_simple_gui::PlanningState::PlanningState()
-  : process_planning_action_client_(PROCESS_PLANNING_ACTION_SERVER_NAME, true) {}
 void godel_simple_gui::PlanningState::onStart(BlendingWidget& gui)
 {
   gui.setText("Planning...");
   gui.setButtonsEnabled(false);
   gui_ptr_ = &gui;
-  QObject::connect(this, SIGNAL(feedbackReceived(QString)), this, SLOT(setFeedbackText(QString)));
-  QtConcurrent::run(this, &PlanningState::makeRequest, gui.options().pathPlanningParams());
+  QObject::connect(&gui, SIGNAL(planningFeedback(QString)), this, SLOT(setFeedbackText(QString)));
+  QObject::connect(&gui, SIGNAL(plansAvailable()), this, SLOT(onPlansAvailable()));
+  QObject::connect(&gui, SIGNAL(planningFinished(bool)), this, SLOT(onPlanningFinished(bool)));
+  gui.startPlanning(gui.options().pathPlanningParams());
 }
 
-void godel_simple_gui::PlanningState::onExit(BlendingWidget& gui) { gui.setButtonsEnabled(true); }
+void godel_simple_gui::PlanningState::onExit(BlendingWidget& gui)
+{
+  QObject::disconnect(&gui, 0, this, 0);
+  gui.setButtonsEnabled(true);
+}
 
 
 // Handlers for the fixed buttons
-void godel_simple_gui::PlanningState::onNext(BlendingWidget& gui) {}
-void godel_simple_gui::PlanningState::onBack(BlendingWidget& gui) {}
-void godel_simple_gui::PlanningState::onReset(BlendingWidget& gui) {}
-
+void godel_simple_gui::PlanningState::onNext(BlendingWidget& gui)
+{
+  // Only enabled once plans are available; planning continues in the background
+  if (!gui.plannedPlans().empty())
+    Q_EMIT newStateAvailable(new SelectPlansState());
+}
 
-// State Specific Functions
-void godel_simple_gui::PlanningState::makeRequest(godel_msgs::PathPlanningParameters planning_params)
+void godel_simple_gui::PlanningState::onBack(BlendingWidget& gui)
 {
-  godel_msgs::ProcessPlanningGoal goal;
-  goal.action = godel_msgs::ProcessPlanningGoal::GENERATE_MOTION_PLAN_AND_PREVIEW;
-  goal.params = planning_params;
-  process_planning_action_client_.sendGoal(
-        goal,
-        boost::bind(&godel_simple_gui::PlanningState::processPlanningDoneCallback, this, _1, _2),
-        boost::bind(&godel_simple_gui::PlanningState::processPlanningActiveCallback, this),
-        boost::bind(&godel_simple_gui::PlanningState::processPlanningFeedbackCallback, this, _1));
-  ROS_INFO_STREAM("Goal sent from planning state");
+  gui.cancelPlanning();
+  Q_EMIT newStateAvailable(new SurfaceSelectState());
 }
 
-void godel_simple_gui::PlanningState::setFeedbackText(QString feedback)
+void godel_simple_gui::PlanningState::onReset(BlendingWidget& gui)
 {
-  gui_ptr_->appendText("\n" + feedback.toStdString());
+  gui.cancelPlanning();
+  Q_EMIT newStateAvailable(new ScanTeachState());
 }
 
 
-// Action Callbacks
-void godel_simple_gui::PlanningState::processPlanningDoneCallback(
-    const actionlib::SimpleClientGoalState& state,
-    const godel_msgs::ProcessPlanningResultConstPtr& result)
+// State Specific Functions
+void godel_simple_gui::PlanningState::setFeedbackText(QString feedback)
 {
-  if(result->succeeded)
-    Q_EMIT newStateAvailable(new SelectPlansState());
-  else
-    Q_EMIT newStateAvailable(new SelectAllSurfaceState());
+  gui_ptr_->appendText("\n" + feedback.toStdString());
 }
 
-void godel_simple_gui::PlanningState::processPlanningActiveCallback()
+void godel_simple_gui::PlanningState::onPlansAvailable()
 {
-  ROS_INFO_STREAM("Goal is active");
+  if (plans_ready_ || !gui_ptr_->planningActive())
+    return;
+
+  plans_ready_ = true;
+  gui_ptr_->appendText("\nPress Next to simulate or execute the plans that are ready while planning continues.");
+  gui_ptr_->setButtonsEnabled(true);
 }
 
-void godel_simple_gui::PlanningState::processPlanningFeedbackCallback(
-    const godel_msgs::ProcessPlanningFeedbackConstPtr& feedback)
+void godel_simple_gui::PlanningState::onPlanningFinished(bool succeeded)
 {
-  Q_EMIT feedbackReceived(QString::fromStdString((feedback->last_completed).c_str()));
+  if (succeeded)
+    Q_EMIT newStateAvailable(new SelectPlansState());
+  else
+    Q_EMIT newStateAvailable(new SelectAllSurfaceState());
 }
-
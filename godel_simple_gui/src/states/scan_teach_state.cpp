@@ -14,6 +14,8 @@ void godel_simple_gui::ScanTeachState::onExit(BlendingWidget& gui) {}
 
 void godel_simple_gui::ScanTeachState::onNext(BlendingWidget& gui)
 {
+  // A new scan invalidates plans that may still be generated for the previous one
+  gui.cancelPlanning();
   Q_EMIT newStateAvailable(new ScanningState());
 }
 
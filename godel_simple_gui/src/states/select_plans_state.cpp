@@ -1,4 +1,5 @@
 #include <ros/console.h>
+#include <algorithm>
 #include <QtConcurrent/QtConcurrentRun>
 #include "godel_simple_gui/states/select_plans_state.h"
 // previous state
@@ -17,34 +18,71 @@ const static std::string GET_AVAILABLE_MOTION_PLANS_SERVICE = "get_available_mot
 
 void godel_simple_gui::SelectPlansState::onStart(BlendingWidget& gui)
 {
-  ros::ServiceClient client = gui.nodeHandle().serviceClient<godel_msgs::GetAvailableMotionPlans>(
+  gui_ptr_ = &gui;
+  fetchPlanNames(plan_names_);
+
+  if (plan_names_.empty())
+  {
+    Q_EMIT newStateAvailable(new SelectAllSurfaceState());
+  }
+  else
+  {
+    gui.showPlanListWidget();
+    updateLabel();
+    gui.addPlans(plan_names_);
+
+    QObject::connect(&gui, SIGNAL(plansAvailable()), this, SLOT(refreshPlans()));
+    QObject::connect(&gui, SIGNAL(planningFinished(bool)), this, SLOT(refreshPlans()));
+  }
+
+}
+
+void godel_simple_gui::SelectPlansState::onExit(BlendingWidget& gui)
+{
+  QObject::disconnect(&gui, 0, this, 0);
+}
+
+void godel_simple_gui::SelectPlansState::fetchPlanNames(std::vector<std::string>& names)
+{
+  ros::ServiceClient client = gui_ptr_->nodeHandle().serviceClient<godel_msgs::GetAvailableMotionPlans>(
       GET_AVAILABLE_MOTION_PLANS_SERVICE);
 
   godel_msgs::GetAvailableMotionPlans srv;
   if (client.call(srv))
   {
-    this->plan_names_ = srv.response.names;
+    names = srv.response.names;
   }
   else
   {
     ROS_WARN_STREAM("Could not fetch plan names");
   }
+}
 
-  if (plan_names_.empty())
-  {
-    Q_EMIT newStateAvailable(new SelectAllSurfaceState());
-  }
+void godel_simple_gui::SelectPlansState::updateLabel()
+{
+  if (gui_ptr_->planningActive())
+    gui_ptr_->setLabelText("Select Plan (planning in progress):");
   else
+    gui_ptr_->setLabelText("Select Plan:");
+}
+
+void godel_simple_gui::SelectPlansState::refreshPlans()
+{
+  std::vector<std::string> names;
+  fetchPlanNames(names);
+
+  std::vector<std::string> new_names;
+  for (const auto& name : names)
   {
-    gui.showPlanListWidget();
-    gui.setLabelText("Select Plan:");
-    gui.addPlans(plan_names_);
+    if (std::find(plan_names_.begin(), plan_names_.end(), name) == plan_names_.end())
+      new_names.push_back(name);
   }
 
+  plan_names_.insert(plan_names_.end(), new_names.begin(), new_names.end());
+  gui_ptr_->appendPlans(new_names);
+  updateLabel();
 }
 
-void godel_simple_gui::SelectPlansState::onExit(BlendingWidget& gui) {}
-
 // Handlers for the fixed buttons
 void godel_simple_gui::SelectPlansState::onNext(BlendingWidget& gui)
 {
@@ -58,6 +96,7 @@ void godel_simple_gui::SelectPlansState::onNext(BlendingWidget& gui)
 
 void godel_simple_gui::SelectPlansState::onBack(BlendingWidget& gui)
 {
+  gui.cancelPlanning();
   gui.setLabelText("System Status:");
   gui.showStatusWindow();
   Q_EMIT newStateAvailable(new SurfaceSelectState());
@@ -65,6 +104,7 @@ void godel_simple_gui::SelectPlansState::onBack(BlendingWidget& gui)
 
 void godel_simple_gui::SelectPlansState::onReset(BlendingWidget& gui)
 {
+  gui.cancelPlanning();
   gui.setLabelText("System Status:");
   Q_EMIT newStateAvailable(new ScanTeachState());
 }
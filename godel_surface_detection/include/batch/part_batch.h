@@ -0,0 +1,123 @@
+#ifndef GODEL_PART_BATCH_H
+#define GODEL_PART_BATCH_H
+
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+#include <geometry_msgs/PoseArray.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+
+/*
+ * Batch processing of several parts on a shared fixture: the detected surfaces are grouped into
+ * parts, parts identical to one planned earlier reuse its tool paths through a rigid registration,
+ * and the parts are ordered to keep the traverse between them short.
+ */
+
+namespace godel_surface_detection
+{
+namespace batch
+{
+
+typedef pcl::PointCloud<pcl::PointXYZRGB> Cloud;
+
+struct BatchParameters
+{
+  BatchParameters()
+    : connect_distance(0.005), boundary_resolution(0.005), max_boundary_points(400), max_iterations(30),
+      max_rms(0.003), max_centroid_distance(0.01), size_tolerance(0.2)
+  {
+  }
+
+  double connect_distance; // (m) surfaces closer than this belong to the same part
+
+  // registration features: the outline of each surface on a grid of 'boundary_resolution' meters
+  // and the centroid of each surface. ICP fits at most 'max_boundary_points' points of the
+  // reference's outline to the other part's whole outline.
+  double boundary_resolution;
+  std::size_t max_boundary_points;
+
+  // two parts are identical if ICP of their features converges within 'max_iterations' to a
+  // boundary RMS error under 'max_rms' (m), and then every surface lands within
+  // 'max_centroid_distance' (m) of a surface whose point count differs by at most 'size_tolerance'
+  int max_iterations;
+  double max_rms;
+  double max_centroid_distance;
+  double size_tolerance;
+};
+
+/**
+ * @brief Groups surfaces into parts: surfaces with points closer than connect_distance, directly
+ * or through other surfaces, belong to the same part
+ * @return The surface indices of each part, ascending, with parts ordered by their first surface
+ */
+std::vector<std::vector<std::size_t>> clusterSurfaces(const std::vector<Cloud::ConstPtr>& surfaces,
+                                                      double connect_distance);
+
+/** @brief What a part is registered by */
+struct PartFeatures
+{
+  std::vector<Eigen::Vector3d> centroids; // of each surface, in the order given
+  std::vector<std::size_t> sizes;         // points of each surface
+  std::vector<Eigen::Vector3d> boundary;  // outline points of every surface
+};
+
+PartFeatures computeFeatures(const std::vector<Cloud::ConstPtr>& surfaces, const BatchParameters& params);
+
+struct Registration
+{
+  Registration() : matched(false), transform(Eigen::Affine3d::Identity()), rms(0.0) {}
+
+  bool matched;
+  Eigen::Affine3d transform;   // takes the reference part onto the other part
+  double rms;                  // (m) of the boundary after registration
+  std::vector<int> surface_map; // for each reference surface, the matching surface of the other part
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/**
+ * @brief Rigidly registers a reference part to another part with ICP on surface centroids and
+ * boundaries. ICP starts from the principal axes of both boundaries, turned about the third axis
+ * in steps of 30 degrees and flipped over, so that parts are found whatever their orientation.
+ */
+Registration registerParts(const PartFeatures& reference, const PartFeatures& part, const BatchParameters& params);
+
+/** @brief Moves tool paths planned on one part onto another: every pose is premultiplied */
+void transformPaths(const Eigen::Affine3d& transform, std::vector<geometry_msgs::PoseArray>& paths);
+
+/**
+ * @brief Order in which to visit parts, starting from 'start', that keeps the traverse between
+ * them short: nearest neighbour, improved by 2-opt
+ */
+std::vector<std::size_t> scheduleParts(const std::vector<Eigen::Vector3d>& positions, const Eigen::Vector3d& start);
+
+/** @brief Length of the traverse from 'start' through the positions in 'order' */
+double traverseLength(const std::vector<Eigen::Vector3d>& positions, const std::vector<std::size_t>& order,
+                      const Eigen::Vector3d& start);
+
+/**
+ * @brief How a set of surfaces is processed as a batch of parts
+ */
+struct PartBatch
+{
+  // surface indices of each part, in execution order
+  std::vector<std::vector<std::size_t>> parts;
+  // per part, the earlier part whose paths it reuses, or -1 if it is planned from scratch
+  std::vector<int> reference;
+  // per part, the registration from its reference; unmatched if it has none
+  std::vector<Registration, Eigen::aligned_allocator<Registration>> registrations;
+};
+
+/**
+ * @brief Clusters the surfaces into parts, orders the parts from 'start' and registers every part
+ * to the first earlier part it is identical to
+ */
+PartBatch planBatch(const std::vector<Cloud::ConstPtr>& surfaces, const BatchParameters& params,
+                    const Eigen::Vector3d& start);
+
+} // namespace batch
+} // namespace godel_surface_detection
+
+#endif // GODEL_PART_BATCH_H
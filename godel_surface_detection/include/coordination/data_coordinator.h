@@ -3,11 +3,17 @@
 
 #include <boost/filesystem.hpp>
 
+#include <atomic>
+#include <mutex>
+
 #include <pcl/PolygonMesh.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
 #include "geometry_msgs/PoseArray.h"
+#include <shape_msgs/Mesh.h>
+
+#include <godel_utils/memory_accounting.h>
 
 namespace godel_surface_detection
 {
@@ -34,11 +40,17 @@ namespace data
       int id_;
       std::string surface_name_;
       pcl::PointCloud<pcl::PointXYZRGB> input_cloud_;
-      pcl::PolygonMesh surface_mesh_;
+      // Held as a vertex and index buffer; planning only reads the vertex positions
+      shape_msgs::Mesh surface_mesh_;
+      pcl::PCLHeader surface_mesh_header_;
       pcl::PointCloud<pcl::PointXYZRGB> surface_cloud_;
       std::vector<std::pair<std::string, geometry_msgs::PoseArray>> edge_pairs_;
       std::vector<geometry_msgs::PoseArray> blend_poses_;
       std::vector<geometry_msgs::PoseArray> scan_poses_;
+
+      // Set while the cloud is spilled to this file to save memory; the member is empty then
+      std::string input_cloud_file_;
+      std::string surface_cloud_file_;
   };
 
   /**
@@ -55,22 +67,40 @@ namespace data
 
   /**
    * @brief Class to handle acquiring and diseminating data relevant to surface detection features
+   *
+   * Over its memory budget the coordinator writes the clouds of its oldest records to the spill
+   * directory. getCloud() reads them back, so callers don't see the difference.
+   *
+   * Planning reads the records while detection adds them and the memory monitor evicts them, so
+   * every access, eviction included, holds the coordinator's lock.
    */
-  class DataCoordinator
+  class DataCoordinator : public godel_utils::memory::AccountedStore
   {
   private:
     int id_counter_;
     std::vector<SurfaceDetectionRecord> records_;
     pcl::PointCloud<pcl::PointXYZRGB> process_cloud_;
+    std::string spill_directory_;
+    std::string spill_prefix_;
+    std::atomic<int> saves_in_progress_;
+    mutable std::recursive_mutex mutex_; // recursive: growing a record can evict
     int getNextID();
     std::string printIds();
     void saveRecord(boost::filesystem::path path);
+    bool spillCloud(pcl::PointCloud<pcl::PointXYZRGB>& cloud, const std::string& file);
+    void removeSpilledClouds();
+
+  protected:
+    void evict(std::size_t target_bytes);
 
 
   public:
     DataCoordinator();
+    ~DataCoordinator();
     bool init();
     int addRecord(pcl::PointCloud<pcl::PointXYZRGB> input_cloud, pcl::PointCloud<pcl::PointXYZRGB> surface_cloud);
+    bool removeRecord(int id);
+    std::vector<int> getRecordIds() const;
     void setProcessCloud(pcl::PointCloud<pcl::PointXYZRGB> incloud);
     bool getCloud(CloudTypes cloud_type, int id, pcl::PointCloud<pcl::PointXYZRGB>& cloud);
     bool setSurfaceName(int id, const std::string& name);
@@ -83,6 +113,10 @@ namespace data
     bool setPoses(PoseTypes pose_type, int id, const std::vector<geometry_msgs::PoseArray>& poses);
     bool getPoses(PoseTypes pose_type, int id, std::vector<geometry_msgs::PoseArray>& poses);
     void asyncSaveRecord(boost::filesystem::path path);
+
+    void setSpillDirectory(const std::string& directory) { spill_directory_ = directory; }
+    std::string storeName() const { return "data_coordinator"; }
+    std::size_t bytesUsed() const;
   };
 } /* end namespace data */
 } /* end namespace godel_surface_detection */
@@ -0,0 +1,68 @@
+#ifndef REGION_OF_INTEREST_H
+#define REGION_OF_INTEREST_H
+
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+#include <godel_msgs/RegionOfInterest.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+
+/*
+ * Regions of interest limit surface detection to part of the work cell, e.g. to the face of a
+ * part that was just scanned again. Detection crops the fused cloud to them before filtering it,
+ * and the surfaces found before outside them are kept.
+ */
+
+namespace godel_surface_detection
+{
+namespace data
+{
+class DataCoordinator;
+}
+
+namespace detection
+{
+
+/**
+ * @brief Tests points against a set of godel_msgs::RegionOfInterest. A point is in the set if
+ * it is in any of the regions; with no regions, every point is.
+ */
+class RegionOfInterestFilter
+{
+public:
+  explicit RegionOfInterestFilter(const std::vector<godel_msgs::RegionOfInterest>& regions);
+
+  bool empty() const { return regions_.empty(); }
+  bool contains(const Eigen::Vector3f& point) const;
+
+  /** @brief The points of 'cloud' in the regions, with its header and sensor pose */
+  void crop(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, pcl::PointCloud<pcl::PointXYZRGB>& cropped) const;
+
+  /** @brief Share of the points of 'cloud' in the regions, 0 for an empty cloud */
+  double share(const pcl::PointCloud<pcl::PointXYZRGB>& cloud) const;
+
+private:
+  struct Region
+  {
+    Eigen::Affine3f world_to_region;
+    Eigen::Vector3f min, max; // bounds in the region frame
+    std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f>> polygon; // prisms only
+  };
+
+  std::vector<Region, Eigen::aligned_allocator<Region>> regions_;
+};
+
+/**
+ * @brief Removes the records whose surfaces lie in the regions: at least 'min_share' of their
+ * points. Detection within the regions replaces them; all other records are left as they are.
+ * @return ids of the removed records
+ */
+std::vector<int> removeRecordsInRegions(data::DataCoordinator& coordinator, const RegionOfInterestFilter& regions,
+                                        double min_share = 0.5);
+
+} // namespace detection
+} // namespace godel_surface_detection
+
+#endif // REGION_OF_INTEREST_H
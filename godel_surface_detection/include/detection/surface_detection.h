@@ -23,8 +23,13 @@
 #include <pcl/point_types.h>
 #include <pcl/PolygonMesh.h>
 #include <visualization_msgs/MarkerArray.h>
+#include <godel_msgs/RegionOfInterest.h>
 #include <godel_msgs/SurfaceDetectionParameters.h>
+#include <godel_param_helpers/godel_param_helpers.h>
+#include <godel_utils/memory_accounting.h>
+#include <segmentation/surface_merging.h>
 
+#include <mutex>
 #include <random>
 
 namespace godel_surface_detection
@@ -35,7 +40,15 @@ namespace detection
 typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
 typedef pcl::PointCloud<pcl::Normal> Normals;
 
-class SurfaceDetection
+/**
+ * Over its memory budget, detection first drops the region colored cloud (only used for display)
+ * and then merges the points of the accumulated scans that fall in the same voxel of the grid the
+ * process cloud is filtered with.
+ *
+ * The memory monitor may evict from another callback thread than the one detecting, so the
+ * methods below and evict() hold the detector's lock. The parameters are not covered.
+ */
+class SurfaceDetection : public godel_utils::memory::AccountedStore
 {
 public:
   SurfaceDetection();
@@ -44,10 +57,17 @@ public:
   bool init();
 
   bool load_parameters(const std::string& filename);
-  void save_parameters(const std::string& filename);
+  std::future<bool> save_parameters(const std::string& filename, godel_param_helpers::MessageFileWriter& writer);
 
   bool find_surfaces();
 
+  /**
+   * @brief The filtering and segmentation half of find_surfaces(): fills the surface clouds but
+   * computes no meshes or markers, so no meshing plugin is needed
+   * @return false if no cloud was added
+   */
+  bool segment_surfaces();
+
   static void mesh_to_marker(const pcl::PolygonMesh& mesh, visualization_msgs::Marker& marker,
                              std::default_random_engine &random_engine);
 
@@ -68,13 +88,27 @@ public:
   void get_region_colored_cloud(CloudRGB& cloud);
   void get_region_colored_cloud(sensor_msgs::PointCloud2& cloud_msg);
 
+  // segments found by region growing and surfaces left after merging, of the last segmentation
+  const SurfaceMergeStats& get_merge_stats() const { return merge_stats_; }
+
   std::string getMeshingPluginName() const;
 
+  std::string storeName() const { return "surface_detection"; }
+  std::size_t bytesUsed() const;
+
+protected:
+  void evict(std::size_t target_bytes);
 
 public:
   // parameters
   godel_msgs::SurfaceDetectionParameters params_;
 
+  // threads used to estimate normals, 0 uses every core
+  int normal_estimation_threads_;
+
+  // if any, the full cloud is cropped to these before it is filtered
+  std::vector<godel_msgs::RegionOfInterest> regions_of_interest_;
+
 private:
   // roscpp members
   ros::Subscriber point_cloud_subs_;
@@ -88,13 +122,17 @@ private:
   std::vector<CloudRGB::Ptr> surface_clouds_;
   visualization_msgs::MarkerArray mesh_markers_;
   std::vector<pcl::PolygonMesh> meshes_;
+  SurfaceMergeStats merge_stats_;
 
   // counter
   int acquired_clouds_counter_;
+  std::size_t compacted_size_; // size of the full cloud after it was last compacted
+
+  mutable std::recursive_mutex mutex_; // recursive: adding a cloud can evict
 
   /**
-   * @brief filterFullCloud applies a passthrough and voxelgrid filter to the
-   * full cloud.  The result of these filters is the process cloud. The
+   * @brief filterFullCloud crops the full cloud to the regions of interest, if
+   * any, and applies a passthrough and voxelgrid filter to it.  The result of these filters is the process cloud. The
    * passthrough filter eliminates the table and the voxelgrid downsamples the
    * cloud.
    */
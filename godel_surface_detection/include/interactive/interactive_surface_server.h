@@ -22,7 +22,12 @@
 #include <interactive_markers/interactive_marker_server.h>
 #include <interactive_markers/menu_handler.h>
 #include <pcl/PolygonMesh.h>
+#include <shape_msgs/Mesh.h>
+#include <godel_utils/memory_accounting.h>
+#include <atomic>
 #include <functional>
+#include <mutex>
+#include <set>
 
 namespace interactive_markers
 {
@@ -37,6 +42,8 @@ namespace interactive
 namespace params
 {
 static const std::string PARAMETER_NS = "interactive_surface_server";
+static const std::string UPDATE_RATE = "update_rate";
+static const std::string DECIMATION_CELL_SIZE = "decimation_cell_size";
 }
 
 namespace defaults
@@ -52,6 +59,8 @@ static const double ARROW_HEAD_DIAMETER = 0.04f;
 static const double ARROW_HEAD_LENGTH = 0.02f;
 static const double ARROW_DISTANCE = 0.02f;
 static const double MARKER_ALPHA = 0.6f;
+static const double UPDATE_RATE = 30.0;          // max marker broadcasts per second [Hz]
+static const double DECIMATION_CELL_SIZE = 0.005; // vertex clustering cell for surface markers [m]
 }
 
 struct SurfaceSelectionMapEntry
@@ -60,7 +69,16 @@ struct SurfaceSelectionMapEntry
   bool selected;
 };
 
-class InteractiveSurfaceServer
+/**
+ * The full resolution meshes of the surfaces are held indexed, as triangles of their vertex
+ * positions. Over its memory budget the server writes the meshes of its oldest surfaces to the
+ * spill directory; get_selected_surfaces() reads them back unchanged. Only the meshes are spilled,
+ * the (decimated) markers stay on the marker server.
+ *
+ * Service callbacks, marker feedback, planning and the memory monitor use the server from
+ * different threads, so the public methods and evict() hold the server's lock.
+ */
+class InteractiveSurfaceServer : public godel_utils::memory::AccountedStore
 {
 
 public:
@@ -69,6 +87,8 @@ public:
 
 public:
   static void mesh_to_marker(const pcl::PolygonMesh& mesh, visualization_msgs::Marker& marker);
+  static void mesh_to_marker(const pcl::PolygonMesh& mesh, double decimation_cell_size,
+                             visualization_msgs::Marker& marker);
   static void marker_to_mesh(const visualization_msgs::Marker& marker, pcl::PolygonMesh& mesh);
 
 public:
@@ -85,7 +105,7 @@ public:
   std::string add_surface(const int id, const pcl::PolygonMesh& mesh, const geometry_msgs::Pose& pose);
   void add_random_surface_marker();
   void remove_all_surfaces();
-  int get_surface_count() { return surface_selection_map_.size(); }
+  int get_surface_count();
 
   void getSelectedIds(std::vector<int>& ids);
   void get_selected_list(std::vector<std::string>& list);
@@ -101,18 +121,50 @@ public:
   bool rename_surface(const int& id, const std::string& new_name);
   bool getIdFromName(const std::string& name, int& id);
 
+  /**
+   * @brief Marker changes are coalesced and broadcast at most 'update_rate' times per second.
+   * This sends anything pending right away.
+   */
+  void apply_pending_changes();
+
+  std::string storeName() const { return "interactive_surface_server"; }
+  std::size_t bytesUsed() const;
+
+  void setSpillDirectory(const std::string& directory) { spill_directory_ = directory; }
+
 protected:
+  void evict(std::size_t target_bytes);
+  bool has_mesh(int id) const;
+  bool get_mesh(int id, pcl::PolygonMesh& mesh) const;
+  std::string spill_file() const;
+  void remove_spill_file();
+
   interactive_markers::InteractiveMarkerServerPtr marker_server_ptr_;
   interactive_markers::MenuHandler menu_handler_;
   std::map<int, SurfaceSelectionMapEntry> surface_selection_map_;
-  std::map<int, pcl::PolygonMesh> meshes_map_;
+  std::map<int, shape_msgs::Mesh> meshes_map_;
+  std::map<int, pcl::PCLHeader> mesh_headers_;
+  std::set<int> spilled_meshes_;
+  std::string spill_directory_;
+  std::string spill_name_;
+  std::map<int, visualization_msgs::InteractiveMarker> hidden_markers_;
+  std::map<int, visualization_msgs::InteractiveMarker> arrow_markers_;
   std::vector<SelectionCallback> selection_callbacks_;
+  mutable std::recursive_mutex mutex_; // recursive: callbacks and evict() re-enter the server
+
+  // update batching
+  ros::Timer update_timer_;
+  std::atomic<bool> changes_pending_;
 
 protected:
   void
   button_marker_callback(const visualization_msgs::InteractiveMarkerFeedbackConstPtr& feedback);
   void menu_marker_callback(const visualization_msgs::InteractiveMarkerFeedbackConstPtr& feedback);
   void invoke_callbacks();
+  void request_update();
+  void update_timer_callback(const ros::TimerEvent&);
+  bool update_selection_flag(int id, bool selected);
+  void update_visibility(int id, bool show);
   void create_polygon_marker(visualization_msgs::Marker& marker, int triangles);
   void create_arrow_marker(const visualization_msgs::Marker& surface_marker,
                            visualization_msgs::Marker& arrow_marker);
@@ -127,6 +179,9 @@ public:
   double arrow_head_length_;
   double arrow_distance_;
 
+  double update_rate_;
+  double decimation_cell_size_;
+
 protected:
   // menu handling
   uint32_t select_entry_id_;
@@ -0,0 +1,77 @@
+#ifndef GODEL_CONTINUOUS_SCAN_H
+#define GODEL_CONTINUOUS_SCAN_H
+
+#include <sensor_msgs/JointState.h>
+#include <trajectory_msgs/JointTrajectory.h>
+
+#include <vector>
+
+/*
+ * Scan-while-moving capture: rather than stopping at every scan pose to capture, the robot runs
+ * the whole scan as one motion and frames are captured on the way. Each frame is transformed with
+ * the camera pose TF interpolates at the frame's own capture stamp, and frames captured while any
+ * joint moved too fast to give a sharp image are dropped.
+ */
+
+namespace godel_surface_detection
+{
+namespace scan
+{
+
+struct ContinuousScanParameters
+{
+  ContinuousScanParameters()
+    : frame_rate(5.0), hardware_trigger(false), velocity_scaling(0.25), max_joint_velocity(0.5),
+      transform_timeout(0.5), jump_threshold(2.0)
+  {
+  }
+
+  // frames are taken from the scan topic 'frame_rate' times a second; with 'hardware_trigger',
+  // every cloud the (externally triggered) sensor publishes during the motion is a frame
+  double frame_rate; // (Hz)
+  bool hardware_trigger;
+
+  // the scan motion runs at this share of the joint velocity and acceleration limits
+  double velocity_scaling;
+
+  // (rad/s) frames captured while any joint moved faster than this are rejected as blurred
+  double max_joint_velocity;
+
+  // (s) how long to wait for TF to reach a frame's capture stamp
+  double transform_timeout;
+
+  // the sweep ends before a step that moves the joints more than this many times the mean step
+  // of the sweep, such as an IK configuration flip
+  double jump_threshold;
+};
+
+/**
+ * @brief Capture times (s after the start of the motion) of a timer at 'frame_rate' running over
+ * a motion of 'duration' seconds: 0, 1 / frame_rate, ... up to and including 'duration'
+ */
+std::vector<double> captureTimes(double duration, double frame_rate);
+
+/**
+ * @brief Largest joint speed (rad/s) 't' seconds after the start of the trajectory, with the
+ * velocities interpolated linearly between its points; 0 before and after it
+ */
+double maxJointVelocity(const trajectory_msgs::JointTrajectory& trajectory, double t);
+
+/**
+ * @brief Time (s after the start of the trajectory) at which a joint has first moved 'tolerance'
+ * (rad) from its start, with the positions interpolated linearly between its points; the
+ * duration of the trajectory if no joint does
+ */
+double departureTime(const trajectory_msgs::JointTrajectory& trajectory, double tolerance);
+
+/**
+ * @brief True if a joint of the trajectory is further than 'tolerance' (rad) from its start in
+ * 'state'. Joints missing from 'state' are left out.
+ */
+bool hasDeparted(const trajectory_msgs::JointTrajectory& trajectory, const sensor_msgs::JointState& state,
+                 double tolerance);
+
+} // namespace scan
+} // namespace godel_surface_detection
+
+#endif // GODEL_CONTINUOUS_SCAN_H
@@ -0,0 +1,183 @@
+#ifndef GODEL_NEXT_BEST_VIEW_H
+#define GODEL_NEXT_BEST_VIEW_H
+
+#include <Eigen/Geometry>
+#include <boost/function.hpp>
+#include <godel_msgs/RobotScanParameters.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+
+/*
+ * Next-best-view scan planning: rather than a fixed circular sweep, each view is chosen from a set
+ * of candidate camera poses around the part as the one expected to observe the most new surface
+ * per second of robot motion, until the fused scans cover the part.
+ *
+ * Like RobotScan and the synthetic depth camera, a camera looks along the x axis of its frame.
+ */
+
+namespace godel_surface_detection
+{
+namespace scan
+{
+
+struct NextBestViewParameters
+{
+  NextBestViewParameters()
+    : resolution(0.01), map_min(-0.25, -0.25, 0.01), map_max(0.25, 0.25, 0.2), standoff(0.6),
+      azimuths(12), fov_horizontal(1.09), fov_vertical(0.86), min_range(0.3), max_range(3.0),
+      rays_horizontal(48), rays_vertical(36), linear_speed(0.25), angular_speed(0.75),
+      capture_time(1.5), coverage_target(0.97), max_views(20), min_gain(1e-4)
+  {
+    elevations.push_back(0.6);
+    elevations.push_back(1.0);
+    elevations.push_back(1.4);
+  }
+
+  // visibility map: a box in the object frame (world_to_obj_pose) that holds the part. Cut its
+  // floor above the table, as surface detection does, or the table is scanned too.
+  double resolution; // (m) cell size
+  Eigen::Vector3d map_min, map_max;
+
+  // candidate camera poses look at the center of the map from 'standoff' meters away, at
+  // 'azimuths' evenly spaced angles around the object z axis and each of the 'elevations' (rad)
+  double standoff;
+  int azimuths;
+  std::vector<double> elevations;
+
+  // sensor, sampled with a grid of rays to predict what a view will see
+  double fov_horizontal, fov_vertical; // (rad)
+  double min_range, max_range;         // (m)
+  int rays_horizontal, rays_vertical;
+
+  // motion time between views: the slower of translating the camera at 'linear_speed' (m/s) and
+  // rotating it at 'angular_speed' (rad/s), plus 'capture_time' (s) at every view
+  double linear_speed, angular_speed, capture_time;
+
+  // the scan stops at 'coverage_target' (see VisibilityMap::coverage(), which runs a few percent
+  // above the true coverage), after 'max_views' views, or when no view is expected to observe
+  // 'min_gain' (m^2) of new surface
+  double coverage_target;
+  int max_views;
+  double min_gain;
+};
+
+/**
+ * @brief Voxel map of what the fused scans have observed: every cell is unknown until a ray passes
+ * through it (free) or ends in it (occupied, i.e. observed surface). Occupied cells stay occupied.
+ */
+class VisibilityMap
+{
+public:
+  enum CellState
+  {
+    UNKNOWN = 0,
+    FREE = 1,
+    OCCUPIED = 2
+  };
+
+  /** @brief A map of the box [min, max] of the map frame, given in the world by world_to_map */
+  VisibilityMap(const Eigen::Affine3d& world_to_map, const Eigen::Vector3d& min, const Eigen::Vector3d& max,
+                double resolution);
+
+  /** @brief Adds a scan (world frame, NaNs allowed) taken from a camera at origin */
+  void integrate(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, const Eigen::Vector3d& origin);
+
+  /**
+   * @brief Walks a ray (world frame) between min_range and max_range to the first cell that isn't
+   * free; FREE if it leaves the map without meeting one
+   * @param range Distance along the ray to that cell
+   */
+  CellState castRay(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double min_range,
+                    double max_range, double& range) const;
+
+  /** @brief State of the cell holding a world point; FREE outside the map */
+  CellState at(const Eigen::Vector3d& point) const;
+
+  std::size_t occupiedCells() const { return occupied_; }
+
+  /** @brief Unknown cells next to free space: where unobserved surface may be */
+  std::size_t frontierCells() const;
+
+  /**
+   * @brief Estimated share of the part's surface observed so far: occupied cells over occupied
+   * and frontier cells; 0 before anything is observed
+   */
+  double coverage() const;
+
+  double resolution() const { return resolution_; }
+
+private:
+  bool index(const Eigen::Vector3d& map_point, std::size_t& i) const;
+  bool clip(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double& t0, double& t1) const;
+
+  Eigen::Affine3d map_to_world_;
+  Eigen::Vector3d min_;
+  double resolution_;
+  int nx_, ny_, nz_;
+  std::vector<unsigned char> cells_;
+  std::size_t occupied_;
+};
+
+/**
+ * @brief Picks scan views one at a time: the reachable, not yet visited candidate with the most
+ * expected newly observed surface per second of motion and capture
+ */
+class NextBestViewPlanner
+{
+public:
+  /** @brief True if the robot can place the camera at world_to_cam */
+  typedef boost::function<bool(const Eigen::Affine3d& world_to_cam)> ReachabilityCheck;
+
+  /**
+   * @param scan_params Only world_to_obj_pose is used: the pose of the map and of the candidates
+   * @param reachable Unreachable candidates are dropped up front; all are kept if empty
+   */
+  NextBestViewPlanner(const godel_msgs::RobotScanParameters& scan_params, const NextBestViewParameters& params,
+                      const ReachabilityCheck& reachable = ReachabilityCheck());
+
+  /** @brief Where the camera is before the first view; without it the first move is free */
+  void setCurrentPose(const Eigen::Affine3d& world_to_cam);
+
+  /** @brief Index of the next view in candidates(), or -1 once the scan is done */
+  int nextView() const;
+
+  /** @brief Records that the camera moved to a candidate and took a scan there */
+  void addView(std::size_t candidate, const pcl::PointCloud<pcl::PointXYZRGB>& cloud);
+
+  /** @brief Drops a candidate the robot failed to reach */
+  void rejectView(std::size_t candidate);
+
+  /** @brief Expected newly observed surface (m^2): unknown cells are assumed to be surface */
+  double expectedGain(const Eigen::Affine3d& world_to_cam) const;
+
+  /** @brief Estimated time (s) to move the camera between two poses, without capture */
+  double motionTime(const Eigen::Affine3d& from, const Eigen::Affine3d& to) const;
+
+  const std::vector<Eigen::Affine3d>& candidates() const { return candidates_; }
+  const VisibilityMap& map() const { return map_; }
+  std::size_t views() const { return views_; }
+
+  /** @brief Estimated motion and capture time (s) of the views so far */
+  double scanTime() const { return scan_time_; }
+
+  /** @brief Camera poses looking at the center of the map, before the reachability check */
+  static std::vector<Eigen::Affine3d> candidatePoses(const godel_msgs::RobotScanParameters& scan_params,
+                                                     const NextBestViewParameters& params);
+
+private:
+  NextBestViewParameters params_;
+  VisibilityMap map_;
+  std::vector<Eigen::Affine3d> candidates_;
+  std::vector<bool> available_;
+  bool has_pose_;
+  Eigen::Affine3d current_pose_;
+  std::size_t views_;
+  double scan_time_;
+};
+
+} // namespace scan
+} // namespace godel_surface_detection
+
+#endif // GODEL_NEXT_BEST_VIEW_H
@@ -26,6 +26,9 @@
 #include <sensor_msgs/PointCloud2.h>
 #include <geometry_msgs/PoseArray.h>
 #include <godel_msgs/RobotScanParameters.h>
+#include <godel_param_helpers/godel_param_helpers.h>
+#include <scan/continuous_scan.h>
+#include <scan/next_best_view.h>
 
 #ifndef ROBOT_SCAN_H_
 #define ROBOT_SCAN_H_
@@ -52,11 +55,12 @@ public:
 
 public:
   RobotScan();
+  virtual ~RobotScan() {}
 
   bool init();
 
   bool load_parameters(const std::string& filename);
-  void save_parameters(const std::string& filename);
+  std::future<bool> save_parameters(const std::string& filename, godel_param_helpers::MessageFileWriter& writer);
 
   void add_scan_callback(ScanCallback cb);
   bool generate_scan_display_trajectory(moveit_msgs::DisplayTrajectory& traj_data);
@@ -67,6 +71,13 @@ public:
   bool move_to_pose(geometry_msgs::Pose& target_pose);
   int scan(bool move_only = false);
 
+  /**
+   * @brief Camera poses (in the world frame) of the circular scan described by params, in scan
+   * order
+   */
+  static void compute_camera_poses(const godel_msgs::RobotScanParameters& params,
+                                   std::vector<tf::Transform>& world_to_cam);
+
   static void apply_trajectory_parabolic_time_parameterization(
       robot_trajectory::RobotTrajectory& rt, moveit_msgs::RobotTrajectory& traj,
       unsigned int max_iterations = 200, double max_time_change_per_it = .6);
@@ -76,6 +87,31 @@ protected:
   bool create_scan_trajectory(std::vector<geometry_msgs::Pose>& scan_poses,
                               moveit_msgs::RobotTrajectory& scan_traj);
 
+  // plans a move of the tcp to a scan pose from the current state
+  virtual bool plan_scan_move(const geometry_msgs::Pose& pose,
+                              moveit::planning_interface::MoveGroupInterface::Plan& plan);
+
+  // plans one motion of the tcp through 'poses' from the current state, timed for the continuous
+  // scan. The path is checked for collisions and joint jumps and ends before the first of either.
+  // Returns the fraction of the path it covers.
+  virtual double plan_sweep(const std::vector<geometry_msgs::Pose>& poses,
+                            moveit::planning_interface::MoveGroupInterface::Plan& plan);
+
+  // executes a plan and waits for it to finish; true if it ran to the end
+  virtual bool execute_plan(const moveit::planning_interface::MoveGroupInterface::Plan& plan);
+
+  // waits for a cloud on the scan topic and hands it, in the scan target frame, to the callbacks
+  bool acquire_scan(pcl::PointCloud<pcl::PointXYZRGB>& cloud);
+
+  // scans views picked by a NextBestViewPlanner until the part is covered
+  int scan_next_best_view();
+
+  // moves through the scan poses in one motion, capturing frames on the way
+  int scan_continuous();
+
+  // true if the robot model has an IK solution placing the camera at world_to_cam
+  bool is_camera_pose_reachable(const Eigen::Affine3d& world_to_cam);
+
 protected:
   // moveit
   MoveGroupPtr move_group_ptr_;
@@ -87,6 +123,16 @@ protected:
 
 public: // parameters
   godel_msgs::RobotScanParameters params_;
+
+  // read from 'next_best_view' next to the other parameters, and not saved with them; when
+  // enabled, scan() picks views with a NextBestViewPlanner instead of the circular sweep
+  bool use_next_best_view_;
+  NextBestViewParameters next_best_view_params_;
+
+  // read from 'continuous_scan' the same way; when enabled, scan() captures while moving
+  // through the circular sweep instead of stopping at every pose
+  bool use_continuous_scan_;
+  ContinuousScanParameters continuous_scan_params_;
 };
 
 } /* namespace detection */
@@ -0,0 +1,23 @@
+#ifndef EDGE_PATHS_H
+#define EDGE_PATHS_H
+
+#include <geometry_msgs/PoseArray.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace godel_surface_detection
+{
+
+/**
+ * @brief Traces the boundaries of a segmented surface and turns each one that is long enough into
+ * a path of poses along the edge, with the tool normal to the surface.
+ * @param surface Points of a single surface
+ * @param result One pose array per boundary is appended
+ * @return true if at least one edge path was generated
+ */
+bool generateEdgePaths(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& surface,
+                       std::vector<geometry_msgs::PoseArray>& result);
+
+} // namespace godel_surface_detection
+
+#endif // EDGE_PATHS_H
@@ -0,0 +1,48 @@
+#ifndef NORMAL_ESTIMATION_H
+#define NORMAL_ESTIMATION_H
+
+#include <Eigen/Core>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Normal estimation for the fixed radius neighbourhoods segmentation uses. Points are binned into
+ * a grid of cells a third of the radius wide. Each cell gathers the points of the surrounding
+ * cells once, into per thread arrays of x, y and z, and every point of the cell sums the moments
+ * of the candidates within the radius with vectorised Eigen array reductions. The 3x3 covariance
+ * is solved in closed form. There is no search tree, no neighbour index list per point and no
+ * iterative eigen solver.
+ */
+
+namespace godel_surface_detection
+{
+
+/**
+ * @brief Eigenvalues (ascending) and the eigenvector of the smallest eigenvalue of a symmetric
+ * 3x3 matrix, from the trigonometric solution of its characteristic cubic. Where the smallest
+ * eigenvalue is repeated, the vector is any unit vector orthogonal to the largest one's.
+ */
+void smallestEigenvector(const Eigen::Matrix3d& matrix, Eigen::Vector3d& eigenvalues, Eigen::Vector3d& eigenvector);
+
+/**
+ * @brief The same normals and curvatures as pcl::NormalEstimation with a radius search: the
+ * normals face the cloud's sensor origin, and points with fewer than three neighbours or without
+ * finite coordinates get NaNs.
+ * @param num_threads 0 uses every core
+ */
+void estimateNormals(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, double radius, int num_threads,
+                     pcl::PointCloud<pcl::Normal>& normals);
+
+/**
+ * @brief As above, for the points flagged in 'selected' only; all points are still neighbours.
+ * The normals of the other points are left as they are, so 'normals' must be as large as the cloud.
+ */
+void estimateNormals(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, const std::vector<uint8_t>& selected,
+                     double radius, int num_threads, pcl::PointCloud<pcl::Normal>& normals);
+
+} // namespace godel_surface_detection
+
+#endif // NORMAL_ESTIMATION_H
@@ -0,0 +1,65 @@
+#ifndef SURFACE_MERGING_H
+#define SURFACE_MERGING_H
+
+#include <Eigen/Core>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <utility>
+#include <vector>
+
+/*
+ * Region growing splits a single face into several segments wherever sensor noise or a crease
+ * bends the normals past its smoothness threshold. Every segment becomes a surface of its own,
+ * which is meshed, planned and approached separately. Merging joins adjacent segments whose
+ * fitted planes agree, one pair at a time starting with the best agreeing pair, and keeps a
+ * merge only if the joined points are still planar.
+ */
+
+namespace godel_surface_detection
+{
+
+struct SurfaceMergeParameters
+{
+  double max_angle = 0.05;           // (rad) between the normals of two planes
+  double max_offset = 0.002;         // (m) of either centroid from the other segment's plane
+  double max_rms = 0.0015;           // (m) RMS distance of the merged points from their plane
+  double adjacency_distance = 0.006; // (m) segments with points this close share a border
+  int min_border_points = 10;        // points on either side of a border
+};
+
+struct SurfaceMergeStats
+{
+  std::size_t segments = 0; // surfaces before merging
+  std::size_t surfaces = 0; // and after
+  std::size_t rejected = 0; // merges of agreeing planes undone because the result wasn't planar
+};
+
+struct PlaneFit
+{
+  Eigen::Vector3d centroid = Eigen::Vector3d::Zero();
+  Eigen::Vector3d normal = Eigen::Vector3d::UnitZ();
+  double rms = 0.0; // (m) of the points from the plane
+};
+
+/** @brief Least squares plane through the points */
+PlaneFit fitPlane(const pcl::PointCloud<pcl::PointXYZRGB>& cloud);
+
+/**
+ * @brief Pairs (i < j) of surfaces that have at least params.min_border_points points within about
+ * params.adjacency_distance of the other
+ */
+std::vector<std::pair<std::size_t, std::size_t>>
+surfaceAdjacency(const std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>& surfaces,
+                 const SurfaceMergeParameters& params);
+
+/**
+ * @brief Joins adjacent coplanar surfaces in place. A merged surface takes the place of its first
+ * segment; the order of the others is kept.
+ */
+SurfaceMergeStats mergeCoplanarSurfaces(std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>& surfaces,
+                                        const SurfaceMergeParameters& params = SurfaceMergeParameters());
+
+} // namespace godel_surface_detection
+
+#endif // SURFACE_MERGING_H
@@ -23,6 +23,23 @@ static const int MAX_CLUSTER_SIZE = 50000;
 static const int MIN_CLUSTER_SIZE = 2500;
 static const int NUM_NEIGHBORS = 30;
 
+/**
+ * @brief Normal estimation and region growing settings. The defaults are the values segmentation
+ * used before they could be configured.
+ */
+struct SegmentationParameters
+{
+  double normal_radius = 0.025;        // (m) neighbourhood of the normal estimation
+  double smoothness_threshold = 0.035; // (rad) max angle between normals within a region
+  double curvature_threshold = 1.0;
+  int min_cluster_size = MIN_CLUSTER_SIZE;
+  int max_cluster_size = MAX_CLUSTER_SIZE;
+  int num_neighbors = NUM_NEIGHBORS;
+  int num_threads = 0; // normal estimation threads, 0 uses every core
+  bool closed_form_normals = true; // godel_surface_detection::estimateNormals, else pcl::NormalEstimationOMP
+  double coarse_leaf = 0.0; // (m) if set, a voxel grid this coarse is segmented, and refined only near borders
+  int border_band = 2;      // coarse voxels either side of a border whose points are refined
+};
 
 template <bool IsManifoldT>
 struct MeshTraits
@@ -71,8 +88,10 @@ public:
   /**
    * @brief constructor that sets the background cloud, also initializes the KdTree for searching
    * @param bg_cloud the set of points defining the background
+   * @param params normal estimation and region growing settings
    */
-  SurfaceSegmentation(pcl::PointCloud<pcl::PointXYZRGB>::Ptr icloud);
+  SurfaceSegmentation(pcl::PointCloud<pcl::PointXYZRGB>::Ptr icloud,
+                      const SegmentationParameters& params = SegmentationParameters());
 
 
   //-------------------- Clouds --------------------//
@@ -152,15 +171,29 @@ public:
                              int sb,
                              std::vector<Eigen::Matrix4d, Eigen::aligned_allocator<Eigen::Matrix4d>> &poses);
 
+  /**
+   * @brief compute the normals and store in normals_, this is requried for both segmentation and meshing.
+   * Called by the cloud constructor, unless segmentation is coarse to fine; public so that it can be
+   * re-run and timed on its own.
+   */
+  void computeNormals();
+
 private:
+  /**
+   * @brief computeSegments() with params_.coarse_leaf set: region growing runs on a voxel grid of
+   * that size, whose labels are projected back onto the points. Only the points within
+   * params_.border_band voxels of a border between labels get normals of their own and are
+   * assigned again, by growing the labels of their neighbours into them; all other points take
+   * the normal and label of their voxel.
+   */
+  std::vector<pcl::PointIndices> computeCoarseToFineSegments(pcl::PointCloud<pcl::PointXYZRGB>::Ptr& colored_cloud);
+
   /** @brief remove any NAN points, otherwise many algorithms fail */
   void removeNans();
 
-  /** @brief compute the normals and store in normals_, this is requried for both segmentation and meshing*/
-  void computeNormals();
-
   pcl::PointCloud<pcl::Normal>::Ptr normals_;
   pcl::PointCloud<pcl::PointNormal>::Ptr cloud_with_normals_;
+  SegmentationParameters params_;
 
 };
 #endif
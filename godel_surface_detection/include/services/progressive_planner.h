@@ -0,0 +1,67 @@
+#ifndef PROGRESSIVE_PLANNER_H
+#define PROGRESSIVE_PLANNER_H
+
+#include <boost/function.hpp>
+#include <geometry_msgs/PoseArray.h>
+#include <godel_msgs/ProcessPlanningAction.h>
+#include <services/trajectory_library.h>
+
+namespace godel_surface_detection
+{
+
+/**
+ * @brief Everything produced by planning a single surface
+ */
+struct SurfacePlanningResult
+{
+  std::string surface_name;
+  TrajectoryLibrary::TrajectoryMap plans;
+  std::vector<geometry_msgs::PoseArray> paths; // tool paths of the plans, for preview
+};
+
+/**
+ * @brief Plans a list of surfaces one at a time and reports each surface as soon as it is done,
+ * so that its plans can be simulated or executed while the remaining surfaces are still being
+ * planned. Cancellation is checked between surfaces; a surface that is already being planned
+ * is allowed to finish.
+ */
+class ProgressivePlanner
+{
+public:
+  /** Plans one surface; returns false if nothing could be planned for it */
+  typedef boost::function<bool(SurfacePlanningResult&)> SurfaceJob;
+  /** Receives each finished surface along with the number of surfaces completed and in total */
+  typedef boost::function<void(const SurfacePlanningResult&, std::size_t, std::size_t)> SurfaceCallback;
+  typedef boost::function<bool()> StopCondition;
+
+  enum Outcome
+  {
+    COMPLETED,
+    PREEMPTED
+  };
+
+  void addSurface(const SurfaceJob& job) { jobs_.push_back(job); }
+
+  std::size_t size() const { return jobs_.size(); }
+
+  /**
+   * @brief Runs the queued jobs in order. Surfaces that fail to plan are skipped but still count
+   * as completed.
+   * @param on_surface Called after every surface that produced plans
+   * @param should_stop Polled before each surface; returning true abandons the pending surfaces
+   */
+  Outcome run(const SurfaceCallback& on_surface, const StopCondition& should_stop);
+
+private:
+  std::vector<SurfaceJob> jobs_;
+};
+
+/**
+ * @brief Fills the per-surface fields of the planning action feedback
+ */
+void toFeedback(const SurfacePlanningResult& result, std::size_t completed, std::size_t total,
+                godel_msgs::ProcessPlanningFeedback& feedback);
+
+} // namespace godel_surface_detection
+
+#endif // PROGRESSIVE_PLANNER_H
@@ -16,6 +16,7 @@
 #ifndef SURFACE_BLENDING_SERVICE_H
 #define SURFACE_BLENDING_SERVICE_H
 
+#include <batch/part_batch.h>
 #include <scan/robot_scan.h>
 #include <detection/surface_detection.h>
 #include <segmentation/surface_segmentation.h>
@@ -36,6 +37,7 @@
 #include <godel_msgs/KeyenceProcessPlanning.h>
 #include <godel_msgs/PathPlanning.h>
 #include <godel_msgs/PathPlanningParameters.h>
+#include <godel_param_helpers/godel_param_helpers.h>
 
 #include <godel_msgs/ProcessExecutionAction.h>
 #include <godel_msgs/ProcessPlanningAction.h>
@@ -47,11 +49,18 @@
 #include <godel_process_path_generation/utils.h>
 #include <godel_process_path_generation/polygon_utils.h>
 
+#include <services/progressive_planner.h>
 #include <services/trajectory_library.h>
 #include <coordination/data_coordinator.h>
+#include <utils/visualization_publisher.h>
+
+#include <godel_utils/intra_process.h>
+#include <godel_utils/memory_accounting.h>
 
 #include <pcl/console/parse.h>
 #include <rosbag/bag.h>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
 
 //  marker namespaces
 const static std::string BOUNDARY_NAMESPACE = "process_boundary";
@@ -86,18 +95,31 @@ struct ProcessPlanResult
 class SurfaceBlendingService
 {
 public:
-  SurfaceBlendingService();
+  /**
+   * @param nh Handle of the servers and clients; the nodelet passes its multi-threaded handle
+   */
+  explicit SurfaceBlendingService(const ros::NodeHandle& nh = ros::NodeHandle());
 
   bool init();
   void run();
 
+  // Connects the planning service clients and offers surface selection, the motion library listing
+  // and the process planning action. Called by init(); on its own it is enough to plan the
+  // surfaces added with addSurface().
+  void initPlanning();
+
+  // Records a detected surface and shows it on the surface server. Returns the surface's id.
+  int addSurface(const godel_surface_detection::detection::CloudRGB& input_cloud,
+                 const godel_surface_detection::detection::CloudRGB& surface_cloud,
+                 const pcl::PolygonMesh& mesh);
+
 private:
   bool load_blend_parameters(const std::string& filename);
-  void save_blend_parameters(const std::string& filename);
+  std::future<bool> save_blend_parameters(const std::string& filename);
   bool load_path_planning_parameters(const std::string& filename);
-  void save_path_planning_parameters(const std::string& filename);
+  std::future<bool> save_path_planning_parameters(const std::string& filename);
   bool load_scan_parameters(const std::string& filename);
-  void save_scan_parameters(const std::string& filename);
+  std::future<bool> save_scan_parameters(const std::string& filename);
 
   void publish_selected_surfaces_changed();
 
@@ -107,6 +129,12 @@ private:
 
   void clear_visualizations();
 
+  void publish_region_cloud();
+
+  // Brings the stores back within their soft memory budgets and refreshes the memory diagnostics.
+  // Called at the end of detection and planning, once those are done with the stores.
+  void update_memory_accounting();
+
   /**
    * The following path generation and planning methods are defined in
    * src/blending_service_path_generation.cpp
@@ -131,9 +159,33 @@ private:
   surface_blend_parameters_server_callback(godel_msgs::SurfaceBlendingParameters::Request& req,
                                            godel_msgs::SurfaceBlendingParameters::Response& res);
 
-  // Reads from the surface selection server and generates blend/scan paths for each
-  godel_surface_detection::TrajectoryLibrary
-  generateMotionLibrary(const godel_msgs::PathPlanningParameters& params);
+  // Reads from the surface selection server and plans the selected surfaces one after another.
+  // Each surface's plans are added to the motion library and reported as action feedback as soon
+  // as they are ready. Completes the active process planning goal.
+  void generateMotionLibrary(const godel_msgs::PathPlanningParameters& params);
+
+  // Generates the paths and process plans of a single surface
+  bool planSurface(const int id, const godel_msgs::PathPlanningParameters& params,
+                   godel_surface_detection::SurfacePlanningResult& result);
+
+  // Generates the process plans of a surface's paths
+  bool planProcessPaths(const ProcessPathResult& paths, const godel_msgs::PathPlanningParameters& params,
+                        godel_surface_detection::SurfacePlanningResult& result);
+
+  // Batch mode: groups the selected surfaces into parts and queues them part by part, in the
+  // order that keeps the traverse between parts short
+  void addBatchSurfaces(const std::vector<int>& ids, const godel_msgs::PathPlanningParameters& params,
+                        godel_surface_detection::ProgressivePlanner& planner);
+
+  // Batch mode: plans a surface of batch part 'part' with the paths of the matching surface of
+  // its reference part, moved onto it. Falls back to planSurface() if the moved paths can't be
+  // planned.
+  bool planTransferredSurface(const int id, const int reference_id, const std::size_t part,
+                              const godel_msgs::PathPlanningParameters& params,
+                              godel_surface_detection::SurfacePlanningResult& result);
+
+  // Publishes a status-only planning feedback message
+  void publishPlanningStatus(const std::string& status);
 
 
   bool generateProcessPath(const int& id, ProcessPathResult& result);
@@ -194,19 +246,18 @@ private:
   ros::ServiceServer load_save_motion_plan_server_;
   ros::ServiceServer rename_suface_server_;
 
-  // Services subscribed to by this class
-  ros::ServiceClient process_path_client_;
+  // Services subscribed to by this class; called directly when loaded into the same manager
+  godel_utils::intra_process::ServiceClient<godel_msgs::PathPlanning> process_path_client_;
   ros::ServiceClient trajectory_planner_client_;
 
-  ros::ServiceClient blend_planning_client_;
-  ros::ServiceClient keyence_planning_client_;
+  godel_utils::intra_process::ServiceClient<godel_msgs::BlendProcessPlanning> blend_planning_client_;
+  godel_utils::intra_process::ServiceClient<godel_msgs::KeyenceProcessPlanning> keyence_planning_client_;
 
   // Actions offered by this class
   ros::NodeHandle nh_;
   actionlib::SimpleActionServer<godel_msgs::ProcessPlanningAction> process_planning_server_;
   actionlib::SimpleActionServer<godel_msgs::SelectMotionPlanAction> select_motion_plan_server_;
   godel_msgs::ProcessPlanningFeedback process_planning_feedback_;
-  godel_msgs::ProcessPlanningResult process_planning_result_;
 
   // Actions subscribed to by this class
   actionlib::SimpleActionClient<godel_msgs::ProcessExecutionAction> blend_exe_client_;
@@ -214,11 +265,11 @@ private:
 
   // Current state publishers
   ros::Publisher selected_surf_changed_pub_;
-  ros::Publisher point_cloud_pub_;
-  ros::Publisher tool_path_markers_pub_;
-  ros::Publisher blend_visualization_pub_;
-  ros::Publisher edge_visualization_pub_;
-  ros::Publisher scan_visualization_pub_;
+  godel_surface_detection::visualization::CachedPublisher<sensor_msgs::PointCloud2> point_cloud_pub_;
+  godel_surface_detection::visualization::CachedPublisher<visualization_msgs::MarkerArray> tool_path_markers_pub_;
+  godel_surface_detection::visualization::CachedPublisher<geometry_msgs::PoseArray> blend_visualization_pub_;
+  godel_surface_detection::visualization::CachedPublisher<geometry_msgs::PoseArray> edge_visualization_pub_;
+  godel_surface_detection::visualization::CachedPublisher<geometry_msgs::PoseArray> scan_visualization_pub_;
 
   // Timers
   bool stop_tool_animation_;
@@ -241,6 +292,8 @@ private:
   godel_msgs::ScanPlanParameters scan_plan_params_;
   godel_msgs::BlendingPlanParameters blending_plan_params_;
   godel_msgs::PathPlanningParameters path_planning_params_;
+  // saves the parameters above in order, off the service threads
+  godel_param_helpers::MessageFileWriter param_writer_;
 
   // results
   godel_msgs::SurfaceDetection::Response latest_surface_detection_results_;
@@ -251,13 +304,22 @@ private:
 
   // parameters
   bool publish_region_point_cloud_;
+  int region_cloud_point_budget_;
+  double region_cloud_leaf_size_;
+  int max_visualized_poses_;
   bool save_data_;
   std::string save_location_;
 
-  // msgs
-  sensor_msgs::PointCloud2 region_cloud_msg_;
+  // batch processing of several parts on one fixture
+  bool batch_enabled_;
+  godel_surface_detection::batch::BatchParameters batch_params_;
+  godel_surface_detection::batch::PartBatch batch_;
+  std::map<int, ProcessPathResult> batch_paths_; // paths of the surfaces planned from scratch, by id
 
   godel_surface_detection::TrajectoryLibrary trajectory_library_;
+  boost::mutex trajectory_library_mutex_; // planning fills the library while plans are executed
+
+  godel_utils::memory::MemoryMonitor memory_monitor_;
   int marker_counter_;
 
   // Parameter loading and saving
@@ -2,26 +2,64 @@
 #define TRAJECTORY_LIBRARY_H
 
 #include <string>
+#include <list>
 #include <map>
+#include <set>
+#include <vector>
 
 #include <godel_msgs/ProcessPlan.h>
+#include <godel_utils/memory_accounting.h>
 
 namespace godel_surface_detection
 {
 
-class TrajectoryLibrary
+/**
+ * Named motion plans. Over its memory budget the library moves its oldest plans to a bag in the
+ * spill directory; they keep their names and are read back by fetch() and save().
+ */
+class TrajectoryLibrary : public godel_utils::memory::AccountedStore
 {
 public:
   typedef std::map<std::string, godel_msgs::ProcessPlan> TrajectoryMap;
 
+  TrajectoryLibrary();
+  ~TrajectoryLibrary();
+
   void load(const std::string& filename);
   void save(const std::string& filename);
 
-  TrajectoryMap& get() { return map_; }
+  /** @brief Adds plans, replacing plans of the same name */
+  void insert(const TrajectoryMap& plans);
+  void clear();
+
+  /** @brief Looks a plan up in memory, then among the spilled plans */
+  bool fetch(const std::string& name, godel_msgs::ProcessPlan& plan) const;
+
+  /** @brief Names of all plans, including spilled ones, in order */
+  std::vector<std::string> names() const;
+
+  /** @brief Plans held in memory */
   const TrajectoryMap& get() const { return map_; }
 
+  void setSpillDirectory(const std::string& directory) { spill_directory_ = directory; }
+
+  std::string storeName() const { return "trajectory_library"; }
+  std::size_t bytesUsed() const { return bytes_; }
+
+protected:
+  void evict(std::size_t target_bytes);
+
 private:
+  void add(const std::string& name, const godel_msgs::ProcessPlan& plan);
+  std::string spillFile() const;
+  void removeSpillFile();
+
   TrajectoryMap map_;
+  std::list<std::string> insertion_order_; // of the plans in map_, oldest first
+  std::set<std::string> spilled_;
+  std::size_t bytes_;
+  std::string spill_directory_;
+  std::string spill_name_;
 };
 }
 
@@ -0,0 +1,135 @@
+#ifndef GODEL_SYNTHETIC_WORKLOAD_H
+#define GODEL_SYNTHETIC_WORKLOAD_H
+
+#include <Eigen/Geometry>
+#include <godel_msgs/RobotScanParameters.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <ros/node_handle.h>
+#include <xmlrpcpp/XmlRpcValue.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Synthetic parts and scans with known geometry, for tests, benchmarks and running the pipeline
+ * without a robot or a sensor.
+ *
+ * A part is a union of primitives (boxes, cylinders and spheres) minus the primitives marked as
+ * cut-outs. Every face of every primitive is a ground truth surface with its own label; the walls
+ * of a cut-out are labelled as surfaces of the cut-out. Labels start at 1, NO_SURFACE marks pixels
+ * of simulated views that returned nothing.
+ *
+ * Everything is deterministic for a given seed, whatever the number of threads.
+ */
+
+namespace godel_surface_detection
+{
+namespace synthetic
+{
+
+typedef pcl::PointXYZRGBL LabelledPoint;
+typedef pcl::PointCloud<LabelledPoint> LabelledCloud;
+
+const static uint32_t NO_SURFACE = 0;
+
+enum PrimitiveType
+{
+  BOX,
+  CYLINDER,
+  SPHERE
+};
+
+struct Primitive
+{
+  Primitive() : type(BOX), pose(Eigen::Affine3d::Identity()), size(Eigen::Vector3d::Zero()), cut(false) {}
+
+  PrimitiveType type;
+  Eigen::Affine3d pose; // of the center; cylinders run along their z axis
+  Eigen::Vector3d size; // box: (l, w, h), cylinder: (radius, radius, h), sphere: (radius, radius, radius)
+  bool cut;             // removed from the part rather than added to it
+};
+
+struct PartDescription
+{
+  PartDescription() : target_points(100000), noise(0.0), seed(0) {}
+
+  std::vector<Primitive> primitives;
+  std::size_t target_points; // exact size of the generated cloud
+  double noise;              // (m) standard deviation of the Gaussian noise added to generated points
+  unsigned seed;
+};
+
+/** @brief A box of l x w x h centered on (x, y, z) */
+Primitive box(double x, double y, double z, double l, double w, double h);
+
+/** @brief A cylinder along z of the given radius and height h, centered on (x, y, z) */
+Primitive cylinder(double x, double y, double z, double radius, double h);
+
+/** @brief A sphere of the given radius centered on (x, y, z) */
+Primitive sphere(double x, double y, double z, double radius);
+
+/** @brief The primitive as a cut-out, e.g. cutOut(cylinder(x, y, 0.0, r, 1.0)) for a through hole */
+Primitive cutOut(Primitive primitive);
+
+/**
+ * @brief Pinhole depth camera. The camera looks along the x axis of its frame, the same camera
+ * frame RobotScan places around the part; image columns run along y and rows along z.
+ */
+struct CameraModel
+{
+  CameraModel()
+    : width(640), height(480), fx(525.0), fy(525.0), cx(319.5), cy(239.5), min_range(0.3),
+      max_range(3.0), depth_noise(0.0005), depth_noise_quadratic(0.0015), dropout_rate(0.01),
+      max_incidence_angle(1.3)
+  {
+  }
+
+  int width, height;
+  double fx, fy, cx, cy;        // intrinsics, in pixels
+  double min_range, max_range;  // (m) along the optical axis
+  double depth_noise;           // (m) standard deviation of the range noise at 0m ...
+  double depth_noise_quadratic; // ... growing by this much per squared meter
+  double dropout_rate;          // probability that a pixel returns nothing
+  double max_incidence_angle;   // (rad) surfaces seen at a grazing angle beyond this return nothing
+};
+
+/**
+ * @brief Reads a part description; see launch/synthetic_scan.launch for the format
+ * @return false (and logs why) if the description is malformed
+ */
+bool loadPart(XmlRpc::XmlRpcValue& description, PartDescription& part);
+
+/** @brief Reads a camera model from the parameters under nh, keeping defaults for missing ones */
+CameraModel loadCamera(const ros::NodeHandle& nh);
+
+/**
+ * @brief Name of every ground truth surface, e.g. "box_0/+z" or "cylinder_1/side"; the surface
+ * with label l is at index l - 1
+ */
+std::vector<std::string> surfaceNames(const PartDescription& part);
+
+/**
+ * @brief Samples the surface of the part uniformly, with part.target_points points labelled with
+ * the surface they belong to
+ * @return false if the part has no visible surface
+ */
+bool generatePart(const PartDescription& part, LabelledCloud& cloud);
+
+/**
+ * @brief Simulates one organized view of the part by ray casting from the camera
+ *
+ * The view is in the world frame, like the clouds RobotScan hands to its callbacks, and is
+ * width x height; pixels without a return are NaN with the NO_SURFACE label. Nearer surfaces
+ * occlude farther ones.
+ */
+void simulateView(const PartDescription& part, const CameraModel& camera,
+                  const Eigen::Affine3d& world_to_cam, unsigned seed, LabelledCloud& view);
+
+/** @brief Camera poses of the scan RobotScan would run with params */
+std::vector<Eigen::Affine3d> scanCameraPoses(const godel_msgs::RobotScanParameters& params);
+
+} // namespace synthetic
+} // namespace godel_surface_detection
+
+#endif // GODEL_SYNTHETIC_WORKLOAD_H
@@ -1,12 +1,50 @@
 #ifndef GODEL_MESH_CONVERSIONS_H
 #define GODEL_MESH_CONVERSIONS_H
 
+#include <cstring>
 #include <geometry_msgs/Point.h>
 #include <pcl_ros/point_cloud.h>
+#include <shape_msgs/Mesh.h>
 
 namespace godel_surface_detection
 {
 
+/**
+ * @brief Read-only access to the x, y and z fields of a pcl::PCLPointCloud2 without converting
+ * the whole blob with pcl::fromPCLPointCloud2. Only FLOAT32 coordinates are supported.
+ */
+class PointCloud2XYZView
+{
+public:
+  /**
+   * @throws std::invalid_argument if the cloud has no FLOAT32 x, y and z fields
+   */
+  explicit PointCloud2XYZView(const pcl::PCLPointCloud2& cloud);
+
+  std::size_t size() const { return size_; }
+
+  geometry_msgs::Point operator[](std::size_t i) const
+  {
+    const uint8_t* p = data_ + i * point_step_;
+    float v[3];
+    std::memcpy(&v[0], p + offsets_[0], sizeof(float));
+    std::memcpy(&v[1], p + offsets_[1], sizeof(float));
+    std::memcpy(&v[2], p + offsets_[2], sizeof(float));
+
+    geometry_msgs::Point pt;
+    pt.x = v[0];
+    pt.y = v[1];
+    pt.z = v[2];
+    return pt;
+  }
+
+private:
+  const uint8_t* data_;
+  std::size_t size_;
+  uint32_t point_step_;
+  uint32_t offsets_[3];
+};
+
 /**
  * @brief Flattens the list of vertices and polygon-indices found in the pcl::PolygonMesh data
  * structure into a simple list of 3d positions. Meant for serializing mesh data into a
@@ -17,14 +55,59 @@ namespace godel_surface_detection
 void meshToTrianglePoints(const pcl::PolygonMesh& mesh, std::vector<geometry_msgs::Point>& points);
 
 /**
- * @brief Converts a flattened triangle list into a pcl::PolygonMesh object. DOES NOT attempt
- * to reduce the vertex count.
+ * @brief Converts a flattened triangle list into a pcl::PolygonMesh object. Identical points
+ * are welded into a single shared vertex.
  * @param points A sequence of points where each sequential set of 3 points is a triangle.
- * @param mesh A polygon mesh of the triangles in \e points. If any triangles are connected,
- * this will produce duplicate points.
+ * @param mesh A polygon mesh of the triangles in \e points.
  */
 void trianglePointsToMesh(const std::vector<geometry_msgs::Point>& points, pcl::PolygonMesh& mesh);
 
+/**
+ * @brief Like meshToTrianglePoints(), but first decimates the mesh by vertex clustering: every
+ * vertex is snapped to the centroid of the vertices sharing its cubic cell, triangles that
+ * collapse are dropped and triangles that become identical are emitted once. Meant for
+ * visualization where sub-cell detail is not visible anyway.
+ * @param mesh Source mesh; 3 and 4 sided polygons are supported.
+ * @param cell_size Edge length of the clustering cells (m). Values <= 0 disable decimation.
+ * @param points Output parameter where each sequential tuple of 3 points is a triangle.
+ */
+void meshToDecimatedTrianglePoints(const pcl::PolygonMesh& mesh, double cell_size,
+                                   std::vector<geometry_msgs::Point>& points);
+
+//-------------------- Indexed (shared-vertex) meshes --------------------//
+
+/**
+ * @brief Converts a pcl::PolygonMesh into a vertex buffer plus triangle index buffer. Quads are
+ * split into two triangles. Vertices are read straight from the mesh cloud; only their positions
+ * are kept.
+ * @param weld_tolerance If positive, vertices closer than this are then merged with weldVertices()
+ */
+void meshToIndexedMesh(const pcl::PolygonMesh& mesh, shape_msgs::Mesh& indexed, double weld_tolerance = 0.0);
+
+/**
+ * @brief Converts an indexed mesh back into a pcl::PolygonMesh of triangles.
+ */
+void indexedMeshToMesh(const shape_msgs::Mesh& indexed, pcl::PolygonMesh& mesh);
+
+/**
+ * @brief Builds an indexed mesh from a flattened triangle list, welding points closer than
+ * \e tolerance into one vertex (identical points only, if tolerance is 0).
+ */
+void trianglePointsToIndexedMesh(const std::vector<geometry_msgs::Point>& points, double tolerance,
+                                 shape_msgs::Mesh& indexed);
+
+/**
+ * @brief Expands an indexed mesh into a flattened triangle list, e.g. for a TRIANGLE_LIST marker.
+ */
+void indexedMeshToTrianglePoints(const shape_msgs::Mesh& indexed, std::vector<geometry_msgs::Point>& points);
+
+/**
+ * @brief Merges vertices closer than \e tolerance using a spatial hash with cells of size
+ * \e tolerance, re-indexes the triangles and removes triangles that collapse.
+ * @return The number of vertices removed
+ */
+std::size_t weldVertices(shape_msgs::Mesh& indexed, double tolerance);
+
 }
 
 #endif // GODEL_MESH_CONVERSIONS_H
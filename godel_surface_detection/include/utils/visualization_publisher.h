@@ -0,0 +1,121 @@
+#ifndef GODEL_VISUALIZATION_PUBLISHER_H
+#define GODEL_VISUALIZATION_PUBLISHER_H
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <geometry_msgs/PoseArray.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <ros/ros.h>
+
+#include <mutex>
+
+namespace godel_surface_detection
+{
+namespace visualization
+{
+
+/**
+ * @brief A latched publisher for visualization data that only sends a message when its content
+ * changes. Messages are handed over as shared pointers to const, so a message that is published
+ * again is recognised by its address before anything is serialized; unchanged content costs a
+ * pointer compare. A new message is passed to roscpp as-is: it is serialized once for all remote
+ * subscribers and kept serialized as the latched copy for late RViz subscribers.
+ *
+ * The publisher can be used before advertise() is called (e.g. in benchmarks); in that case it
+ * tracks changes and byte counts but sends nothing.
+ *
+ * publish() may be called from several service threads at once; calls are serialized, as they
+ * share the last message.
+ */
+template <typename M> class CachedPublisher
+{
+public:
+  typedef boost::shared_ptr<const M> MessageConstPtr;
+
+  CachedPublisher() : bytes_published_(0), messages_published_(0) {}
+
+  void advertise(ros::NodeHandle& nh, const std::string& topic)
+  {
+    pub_ = nh.advertise<M>(topic, 1, true);
+  }
+
+  /**
+   * @brief Publishes 'msg' unless it is the last published message. The message must not be
+   * modified once published; publish a new one instead.
+   * @return true if the message was new and has been published
+   */
+  bool publish(const MessageConstPtr& msg)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (msg == last_)
+      return false;
+
+    last_ = msg;
+    if (pub_)
+      pub_.publish(msg);
+
+    bytes_published_ += ros::serialization::serializationLength(*msg);
+    messages_published_++;
+    return true;
+  }
+
+  /**
+   * @brief Publishes a copy of 'msg'. For small messages built on the spot; the content is taken
+   * to have changed.
+   */
+  bool publish(const M& msg)
+  {
+    return publish(boost::make_shared<const M>(msg));
+  }
+
+  /**
+   * @brief Forgets the last message so the next publish() is sent even if it is the same one
+   */
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_.reset();
+  }
+
+  uint64_t bytesPublished() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_published_;
+  }
+
+  uint64_t messagesPublished() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return messages_published_;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  ros::Publisher pub_;
+  MessageConstPtr last_; // kept alive so its address cannot be reused by a new message
+  uint64_t bytes_published_;
+  uint64_t messages_published_;
+};
+
+/**
+ * @brief Voxel-grid level of detail for display clouds. Points are binned into cubic voxels and
+ * each occupied voxel is replaced by the centroid of its points, keeping the colour of the first
+ * point (colours are region labels, so they are not averaged). The voxel size starts at
+ * \e min_leaf_size and grows until the result has at most \e point_budget points.
+ * @param point_budget Maximum output size; 0 disables the budget and uses \e min_leaf_size only
+ * @return The voxel size that was used (0 if the input was copied unchanged)
+ */
+double downsampleForDisplay(const pcl::PointCloud<pcl::PointXYZRGB>& input, std::size_t point_budget,
+                            double min_leaf_size, pcl::PointCloud<pcl::PointXYZRGB>& output);
+
+/**
+ * @brief Keeps every n-th pose, plus the last one, so that at most \e max_poses remain.
+ * A \e max_poses of 0 leaves the array untouched.
+ */
+void decimatePoses(geometry_msgs::PoseArray& poses, std::size_t max_poses);
+
+} // namespace visualization
+} // namespace godel_surface_detection
+
+#endif // GODEL_VISUALIZATION_PUBLISHER_H
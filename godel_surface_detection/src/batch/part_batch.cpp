@@ -0,0 +1,528 @@
+#include <batch/part_batch.h>
+
+#include <Eigen/Eigenvalues>
+#include <Eigen/SVD>
+#include <pcl/kdtree/kdtree_flann.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+// ICP initial hypotheses: turns about the third principal axis, each also flipped over
+const static int ICP_TURNS = 12;
+
+// Every hypothesis gets this many ICP iterations; only the best one is run to convergence
+const static int ICP_COARSE_ITERATIONS = 5;
+
+// ICP stops once an iteration moves the part less than this (m, rad)
+const static double ICP_CONVERGENCE = 1e-6;
+
+// The surface centroids weigh as much in ICP as this share of the boundary points
+const static double CENTROID_WEIGHT = 0.25;
+
+namespace godel_surface_detection
+{
+namespace batch
+{
+
+static bool isFinite(const pcl::PointXYZRGB& pt)
+{
+  return std::isfinite(pt.x) && std::isfinite(pt.y) && std::isfinite(pt.z);
+}
+
+// Voxels are keyed by 21 bits of each integer coordinate
+static long long voxelKey(int x, int y, int z)
+{
+  const long long mask = (1LL << 21) - 1;
+  return ((x & mask) << 42) | ((y & mask) << 21) | (z & mask);
+}
+
+static std::size_t findRoot(std::vector<std::size_t>& parent, std::size_t i)
+{
+  while (parent[i] != i)
+  {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+std::vector<std::vector<std::size_t>> clusterSurfaces(const std::vector<Cloud::ConstPtr>& surfaces,
+                                                      double connect_distance)
+{
+  struct Entry
+  {
+    std::size_t surface;
+    Eigen::Vector3f point;
+  };
+
+  // Points on a grid of connect_distance, so that any two points closer than that are in
+  // neighbouring cells
+  const double scale = 1.0 / connect_distance;
+  std::unordered_map<long long, std::vector<Entry>> grid;
+  for (std::size_t s = 0; s < surfaces.size(); ++s)
+  {
+    for (const auto& pt : surfaces[s]->points)
+    {
+      if (!isFinite(pt))
+        continue;
+      Entry e = {s, Eigen::Vector3f(pt.x, pt.y, pt.z)};
+      grid[voxelKey(std::floor(pt.x * scale), std::floor(pt.y * scale), std::floor(pt.z * scale))].push_back(e);
+    }
+  }
+
+  std::vector<std::size_t> parent(surfaces.size());
+  std::iota(parent.begin(), parent.end(), 0);
+
+  const float max_sq = static_cast<float>(connect_distance * connect_distance);
+  for (const auto& cell : grid)
+  {
+    for (const Entry& a : cell.second)
+    {
+      const int x = std::floor(a.point.x() * scale), y = std::floor(a.point.y() * scale),
+                z = std::floor(a.point.z() * scale);
+      for (int dx = -1; dx <= 1; ++dx)
+      {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+          for (int dz = -1; dz <= 1; ++dz)
+          {
+            const auto it = grid.find(voxelKey(x + dx, y + dy, z + dz));
+            if (it == grid.end())
+              continue;
+            for (const Entry& b : it->second)
+            {
+              // Only pairs that would join two parts need the distance test
+              if (findRoot(parent, a.surface) == findRoot(parent, b.surface))
+                continue;
+              if ((a.point - b.point).squaredNorm() <= max_sq)
+                parent[findRoot(parent, a.surface)] = findRoot(parent, b.surface);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<std::vector<std::size_t>> parts;
+  std::vector<int> part_of(surfaces.size(), -1);
+  for (std::size_t s = 0; s < surfaces.size(); ++s)
+  {
+    const std::size_t root = findRoot(parent, s);
+    if (part_of[root] < 0)
+    {
+      part_of[root] = static_cast<int>(parts.size());
+      parts.push_back(std::vector<std::size_t>());
+    }
+    parts[part_of[root]].push_back(s);
+  }
+  return parts;
+}
+
+// Mean and principal axes of a point set: the columns of 'axes' in order of decreasing spread,
+// forming a right handed frame
+static void principalAxes(const std::vector<Eigen::Vector3d>& points, Eigen::Vector3d& mean, Eigen::Matrix3d& axes)
+{
+  mean = Eigen::Vector3d::Zero();
+  for (const auto& p : points)
+    mean += p;
+  mean /= std::max<std::size_t>(points.size(), 1);
+
+  Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+  for (const auto& p : points)
+    covariance += (p - mean) * (p - mean).transpose();
+
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+  axes.col(0) = solver.eigenvectors().col(2);
+  axes.col(1) = solver.eigenvectors().col(1);
+  axes.col(2) = axes.col(0).cross(axes.col(1));
+}
+
+// Outline of a surface: it is projected onto its best fit plane and gridded, and each occupied
+// cell with an empty 4-neighbour contributes the mean of its points
+static void surfaceBoundary(const std::vector<Eigen::Vector3d>& points, double resolution,
+                            std::vector<Eigen::Vector3d>& boundary)
+{
+  if (points.empty())
+    return;
+
+  Eigen::Vector3d mean;
+  Eigen::Matrix3d axes;
+  principalAxes(points, mean, axes);
+
+  struct Cell
+  {
+    Eigen::Vector3d sum;
+    int count;
+  };
+  std::unordered_map<long long, Cell> cells;
+  for (const auto& p : points)
+  {
+    const Eigen::Vector3d local = axes.transpose() * (p - mean);
+    Cell& c = cells.emplace(voxelKey(std::floor(local.x() / resolution), std::floor(local.y() / resolution), 0),
+                            Cell{Eigen::Vector3d::Zero(), 0}).first->second;
+    c.sum += p;
+    ++c.count;
+  }
+
+  for (const auto& cell : cells)
+  {
+    const Eigen::Vector3d p = cell.second.sum / cell.second.count;
+    const Eigen::Vector3d local = axes.transpose() * (p - mean);
+    const int x = std::floor(local.x() / resolution), y = std::floor(local.y() / resolution);
+    if (!cells.count(voxelKey(x - 1, y, 0)) || !cells.count(voxelKey(x + 1, y, 0)) ||
+        !cells.count(voxelKey(x, y - 1, 0)) || !cells.count(voxelKey(x, y + 1, 0)))
+      boundary.push_back(p);
+  }
+}
+
+PartFeatures computeFeatures(const std::vector<Cloud::ConstPtr>& surfaces, const BatchParameters& params)
+{
+  PartFeatures features;
+  for (const auto& surface : surfaces)
+  {
+    std::vector<Eigen::Vector3d> points;
+    points.reserve(surface->size());
+    Eigen::Vector3d centroid = Eigen::Vector3d::Zero();
+    for (const auto& pt : surface->points)
+    {
+      if (!isFinite(pt))
+        continue;
+      points.push_back(Eigen::Vector3d(pt.x, pt.y, pt.z));
+      centroid += points.back();
+    }
+    features.centroids.push_back(centroid / std::max<std::size_t>(points.size(), 1));
+    features.sizes.push_back(points.size());
+
+    // Grid cells are sorted so that the thinning in registerParts() doesn't depend on hash order
+    std::vector<Eigen::Vector3d> outline;
+    surfaceBoundary(points, params.boundary_resolution, outline);
+    std::sort(outline.begin(), outline.end(), [](const Eigen::Vector3d& a, const Eigen::Vector3d& b) {
+      return std::lexicographical_compare(a.data(), a.data() + 3, b.data(), b.data() + 3);
+    });
+    features.boundary.insert(features.boundary.end(), outline.begin(), outline.end());
+  }
+  return features;
+}
+
+// Sorted point counts agree within the tolerance
+static bool sizesAgree(std::vector<std::size_t> a, std::vector<std::size_t> b, double tolerance)
+{
+  if (a.size() != b.size())
+    return false;
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  for (std::size_t i = 0; i < a.size(); ++i)
+  {
+    const double larger = std::max(a[i], b[i]);
+    if (std::abs(static_cast<double>(a[i]) - static_cast<double>(b[i])) > tolerance * larger)
+      return false;
+  }
+  return true;
+}
+
+static std::size_t nearestCentroid(const std::vector<Eigen::Vector3d>& centroids, const Eigen::Vector3d& p,
+                                   double& sq_distance)
+{
+  std::size_t best = 0;
+  sq_distance = std::numeric_limits<double>::max();
+  for (std::size_t i = 0; i < centroids.size(); ++i)
+  {
+    const double d = (centroids[i] - p).squaredNorm();
+    if (d < sq_distance)
+    {
+      sq_distance = d;
+      best = i;
+    }
+  }
+  return best;
+}
+
+// Weighted least squares rigid transform taking 'from' onto 'to' (Kabsch)
+static Eigen::Affine3d fitRigid(const std::vector<Eigen::Vector3d>& from, const std::vector<Eigen::Vector3d>& to,
+                                const std::vector<double>& weights)
+{
+  double total = 0.0;
+  Eigen::Vector3d mean_from = Eigen::Vector3d::Zero(), mean_to = Eigen::Vector3d::Zero();
+  for (std::size_t i = 0; i < from.size(); ++i)
+  {
+    total += weights[i];
+    mean_from += weights[i] * from[i];
+    mean_to += weights[i] * to[i];
+  }
+  mean_from /= total;
+  mean_to /= total;
+
+  Eigen::Matrix3d h = Eigen::Matrix3d::Zero();
+  for (std::size_t i = 0; i < from.size(); ++i)
+    h += weights[i] * (from[i] - mean_from) * (to[i] - mean_to).transpose();
+
+  Eigen::JacobiSVD<Eigen::Matrix3d> svd(h, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Eigen::Matrix3d d = Eigen::Matrix3d::Identity();
+  if ((svd.matrixV() * svd.matrixU().transpose()).determinant() < 0.0)
+    d(2, 2) = -1.0;
+
+  Eigen::Affine3d t = Eigen::Affine3d::Identity();
+  t.linear() = svd.matrixV() * d * svd.matrixU().transpose();
+  t.translation() = mean_to - t.linear() * mean_from;
+  return t;
+}
+
+// ICP of the reference's thinned boundary and centroids against the part's whole boundary (in
+// 'tree') and centroids, from an initial transform; returns the boundary RMS error
+static double icp(const std::vector<Eigen::Vector3d>& boundary, const PartFeatures& reference,
+                  const PartFeatures& part, const pcl::KdTreeFLANN<pcl::PointXYZ>& tree, int max_iterations,
+                  Eigen::Affine3d& transform)
+{
+  const std::size_t nb = boundary.size(), nc = reference.centroids.size();
+  const double centroid_weight = CENTROID_WEIGHT * nb / std::max<std::size_t>(nc, 1);
+
+  std::vector<Eigen::Vector3d> from(nb + nc), to(nb + nc);
+  std::vector<double> weights(nb + nc, 1.0);
+  std::fill(weights.begin() + nb, weights.end(), centroid_weight);
+
+  std::vector<int> index(1);
+  std::vector<float> sq_distance(1);
+  double rms = std::numeric_limits<double>::max();
+  for (int iteration = 0; iteration <= max_iterations; ++iteration)
+  {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < nb; ++i)
+    {
+      from[i] = transform * boundary[i];
+      tree.nearestKSearch(pcl::PointXYZ(from[i].x(), from[i].y(), from[i].z()), 1, index, sq_distance);
+      to[i] = part.boundary[index[0]];
+      sum += (to[i] - from[i]).squaredNorm();
+    }
+    rms = std::sqrt(sum / std::max<std::size_t>(nb, 1));
+    if (iteration == max_iterations)
+      break;
+
+    for (std::size_t i = 0; i < nc; ++i)
+    {
+      double d;
+      from[nb + i] = transform * reference.centroids[i];
+      to[nb + i] = part.centroids[nearestCentroid(part.centroids, from[nb + i], d)];
+    }
+
+    const Eigen::Affine3d step = fitRigid(from, to, weights);
+    transform = step * transform;
+    if (step.translation().norm() < ICP_CONVERGENCE && Eigen::AngleAxisd(step.linear()).angle() < ICP_CONVERGENCE)
+      max_iterations = iteration + 1; // one more pass for the final error
+  }
+  return rms;
+}
+
+Registration registerParts(const PartFeatures& reference, const PartFeatures& part, const BatchParameters& params)
+{
+  Registration result;
+  if (reference.boundary.empty() || part.boundary.empty() ||
+      !sizesAgree(reference.sizes, part.sizes, params.size_tolerance))
+    return result;
+
+  pcl::PointCloud<pcl::PointXYZ>::Ptr target(new pcl::PointCloud<pcl::PointXYZ>);
+  for (const auto& p : part.boundary)
+    target->push_back(pcl::PointXYZ(p.x(), p.y(), p.z()));
+  pcl::KdTreeFLANN<pcl::PointXYZ> tree;
+  tree.setInputCloud(target);
+
+  std::vector<Eigen::Vector3d> boundary;
+  const std::size_t stride = reference.boundary.size() / std::max<std::size_t>(params.max_boundary_points, 1) + 1;
+  for (std::size_t i = 0; i < reference.boundary.size(); i += stride)
+    boundary.push_back(reference.boundary[i]);
+
+  Eigen::Vector3d mean_ref, mean_part;
+  Eigen::Matrix3d axes_ref, axes_part;
+  principalAxes(reference.boundary, mean_ref, axes_ref);
+  principalAxes(part.boundary, mean_part, axes_part);
+
+  result.rms = std::numeric_limits<double>::max();
+  for (int flip = 0; flip < 2; ++flip)
+  {
+    const Eigen::Matrix3d d = Eigen::Vector3d(1.0, flip ? -1.0 : 1.0, flip ? -1.0 : 1.0).asDiagonal();
+    for (int turn = 0; turn < ICP_TURNS; ++turn)
+    {
+      Eigen::Affine3d t = Eigen::Affine3d::Identity();
+      t.linear() = axes_part * Eigen::AngleAxisd(2.0 * M_PI * turn / ICP_TURNS, Eigen::Vector3d::UnitZ()) * d *
+                   axes_ref.transpose();
+      t.translation() = mean_part - t.linear() * mean_ref;
+
+      const double rms = icp(boundary, reference, part, tree, ICP_COARSE_ITERATIONS, t);
+      if (rms < result.rms)
+      {
+        result.rms = rms;
+        result.transform = t;
+      }
+    }
+  }
+  result.rms = icp(boundary, reference, part, tree, params.max_iterations, result.transform);
+  if (result.rms > params.max_rms)
+    return result;
+
+  // Every reference surface must land on its own surface of the part
+  std::vector<bool> taken(part.centroids.size(), false);
+  result.surface_map.assign(reference.centroids.size(), -1);
+  for (std::size_t i = 0; i < reference.centroids.size(); ++i)
+  {
+    double sq_distance;
+    const std::size_t j = nearestCentroid(part.centroids, result.transform * reference.centroids[i], sq_distance);
+    const double larger = std::max(reference.sizes[i], part.sizes[j]);
+    if (taken[j] || std::sqrt(sq_distance) > params.max_centroid_distance ||
+        std::abs(static_cast<double>(reference.sizes[i]) - static_cast<double>(part.sizes[j])) >
+            params.size_tolerance * larger)
+      return result;
+    taken[j] = true;
+    result.surface_map[i] = static_cast<int>(j);
+  }
+  result.matched = true;
+  return result;
+}
+
+void transformPaths(const Eigen::Affine3d& transform, std::vector<geometry_msgs::PoseArray>& paths)
+{
+  const Eigen::Quaterniond rotation(transform.linear());
+  for (auto& path : paths)
+  {
+    for (auto& pose : path.poses)
+    {
+      const Eigen::Vector3d p = transform * Eigen::Vector3d(pose.position.x, pose.position.y, pose.position.z);
+      const Eigen::Quaterniond q = rotation * Eigen::Quaterniond(pose.orientation.w, pose.orientation.x,
+                                                                 pose.orientation.y, pose.orientation.z);
+      pose.position.x = p.x();
+      pose.position.y = p.y();
+      pose.position.z = p.z();
+      pose.orientation.w = q.w();
+      pose.orientation.x = q.x();
+      pose.orientation.y = q.y();
+      pose.orientation.z = q.z();
+    }
+  }
+}
+
+double traverseLength(const std::vector<Eigen::Vector3d>& positions, const std::vector<std::size_t>& order,
+                      const Eigen::Vector3d& start)
+{
+  double length = 0.0;
+  Eigen::Vector3d at = start;
+  for (std::size_t i : order)
+  {
+    length += (positions[i] - at).norm();
+    at = positions[i];
+  }
+  return length;
+}
+
+std::vector<std::size_t> scheduleParts(const std::vector<Eigen::Vector3d>& positions, const Eigen::Vector3d& start)
+{
+  const std::size_t n = positions.size();
+  std::vector<std::size_t> order;
+  std::vector<bool> visited(n, false);
+  Eigen::Vector3d at = start;
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    std::size_t best = 0;
+    double best_distance = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (!visited[i] && (positions[i] - at).norm() < best_distance)
+      {
+        best_distance = (positions[i] - at).norm();
+        best = i;
+      }
+    }
+    visited[best] = true;
+    order.push_back(best);
+    at = positions[best];
+  }
+
+  // 2-opt on an open path from a fixed start: reversing order[i..j] replaces the edges into i and
+  // out of j, the latter only if j isn't last
+  bool improved = true;
+  while (improved)
+  {
+    improved = false;
+    for (std::size_t i = 0; i + 1 < n; ++i)
+    {
+      const Eigen::Vector3d& before = i == 0 ? start : positions[order[i - 1]];
+      for (std::size_t j = i + 1; j < n; ++j)
+      {
+        const Eigen::Vector3d& first = positions[order[i]];
+        const Eigen::Vector3d& last = positions[order[j]];
+        double delta = (last - before).norm() - (first - before).norm();
+        if (j + 1 < n)
+        {
+          const Eigen::Vector3d& after = positions[order[j + 1]];
+          delta += (first - after).norm() - (last - after).norm();
+        }
+        if (delta < -1e-9)
+        {
+          std::reverse(order.begin() + i, order.begin() + j + 1);
+          improved = true;
+        }
+      }
+    }
+  }
+  return order;
+}
+
+PartBatch planBatch(const std::vector<Cloud::ConstPtr>& surfaces, const BatchParameters& params,
+                    const Eigen::Vector3d& start)
+{
+  const std::vector<std::vector<std::size_t>> clusters = clusterSurfaces(surfaces, params.connect_distance);
+
+  // Parts are visited by the centroid of their points
+  std::vector<Eigen::Vector3d> positions;
+  for (const auto& cluster : clusters)
+  {
+    Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+    std::size_t count = 0;
+    for (std::size_t s : cluster)
+    {
+      for (const auto& pt : surfaces[s]->points)
+      {
+        if (isFinite(pt))
+        {
+          sum += Eigen::Vector3d(pt.x, pt.y, pt.z);
+          ++count;
+        }
+      }
+    }
+    positions.push_back(sum / std::max<std::size_t>(count, 1));
+  }
+
+  PartBatch batch;
+  std::vector<PartFeatures> features;
+  for (std::size_t i : scheduleParts(positions, start))
+  {
+    batch.parts.push_back(clusters[i]);
+    std::vector<Cloud::ConstPtr> part_surfaces;
+    for (std::size_t s : clusters[i])
+      part_surfaces.push_back(surfaces[s]);
+    features.push_back(computeFeatures(part_surfaces, params));
+  }
+
+  // Only parts planned from scratch serve as references
+  batch.reference.assign(batch.parts.size(), -1);
+  batch.registrations.resize(batch.parts.size());
+  for (std::size_t k = 0; k < batch.parts.size(); ++k)
+  {
+    for (std::size_t m = 0; m < k; ++m)
+    {
+      if (batch.reference[m] >= 0)
+        continue;
+      const Registration r = registerParts(features[m], features[k], params);
+      if (r.matched)
+      {
+        batch.reference[k] = static_cast<int>(m);
+        batch.registrations[k] = r;
+        break;
+      }
+    }
+  }
+  return batch;
+}
+
+} // namespace batch
+} // namespace godel_surface_detection
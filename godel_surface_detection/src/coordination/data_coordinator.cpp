@@ -1,14 +1,45 @@
 #include <pcl/io/pcd_io.h>
 #include <ros/io.h>
 #include <ros/time.h>
+#include <mutex>
 #include <thread>
 
 #include "coordination/data_coordinator.h"
+#include "utils/mesh_conversions.h"
 
 namespace godel_surface_detection
 {
 namespace data
 {
+  namespace
+  {
+    std::atomic<unsigned> coordinator_count(0); // tells the spill files of several coordinators apart
+
+    std::size_t posesBytes(const std::vector<geometry_msgs::PoseArray>& arrays)
+    {
+      std::size_t bytes = arrays.capacity() * sizeof(geometry_msgs::PoseArray);
+      for (const auto& array : arrays)
+        bytes += array.poses.capacity() * sizeof(geometry_msgs::Pose);
+      return bytes;
+    }
+
+    std::size_t meshBytes(const shape_msgs::Mesh& mesh)
+    {
+      return mesh.vertices.capacity() * sizeof(geometry_msgs::Point) +
+             mesh.triangles.capacity() * sizeof(shape_msgs::MeshTriangle);
+    }
+
+    std::size_t recordBytes(const SurfaceDetectionRecord& rec)
+    {
+      std::size_t bytes = godel_utils::memory::cloudBytes(rec.input_cloud_) +
+                          godel_utils::memory::cloudBytes(rec.surface_cloud_) +
+                          meshBytes(rec.surface_mesh_) + posesBytes(rec.blend_poses_) +
+                          posesBytes(rec.scan_poses_);
+      for (const auto& edge : rec.edge_pairs_)
+        bytes += edge.second.poses.capacity() * sizeof(geometry_msgs::Pose);
+      return bytes;
+    }
+  } // end anon namespace
 
   /**
    * @brief getNextID return a unique ID
@@ -39,10 +70,21 @@ namespace data
 
   //! Default Constructor
   DataCoordinator::DataCoordinator()
+    : spill_directory_(godel_utils::memory::defaultSpillDirectory()), saves_in_progress_(0)
   {
     id_counter_ = 0;
     if(records_.size() > 0)
       records_.clear();
+
+    std::stringstream ss;
+    ss << "data_coordinator_" << coordinator_count++ << "_";
+    spill_prefix_ = ss.str();
+  }
+
+  DataCoordinator::~DataCoordinator()
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    removeSpilledClouds();
   }
 
   /**
@@ -51,7 +93,9 @@ namespace data
    */
   bool DataCoordinator::init()
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     id_counter_ = 0;
+    removeSpilledClouds();
     if(records_.size() > 0)
       records_.clear();
     return true;
@@ -68,17 +112,62 @@ namespace data
   int DataCoordinator::addRecord(pcl::PointCloud<pcl::PointXYZRGB> input_cloud,
                                  pcl::PointCloud<pcl::PointXYZRGB> surface_cloud)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     SurfaceDetectionRecord rec;
     rec.id_ = getNextID();
     rec.input_cloud_ = input_cloud;
     rec.surface_cloud_ = surface_cloud;
     records_.push_back(rec);
+    enforceHardBudget();
     return rec.id_;
   }
 
+  /**
+   * @brief removeRecord Deletes a record, and its clouds if they were spilled to disk
+   * @param id ID of the record
+   * @return true if the record was found, false otherwise
+   */
+  bool DataCoordinator::removeRecord(int id)
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    for(auto it = records_.begin(); it != records_.end(); ++it)
+    {
+      if(id == it->id_)
+      {
+        boost::system::error_code ec;
+        if(!it->input_cloud_file_.empty())
+          boost::filesystem::remove(it->input_cloud_file_, ec);
+        if(!it->surface_cloud_file_.empty())
+          boost::filesystem::remove(it->surface_cloud_file_, ec);
+        records_.erase(it);
+        return true;
+      }
+    }
+
+    ROS_ERROR_STREAM(UNABLE_TO_FIND_RECORD_ERROR << " " << id);
+    return false;
+  }
+
+
+  /**
+   * @brief getRecordIds
+   * @return the IDs of all current records, oldest first
+   */
+  std::vector<int> DataCoordinator::getRecordIds() const
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::vector<int> ids;
+    for(const auto& rec : records_)
+      ids.push_back(rec.id_);
+    return ids;
+  }
+
+
   void DataCoordinator::setProcessCloud(pcl::PointCloud<pcl::PointXYZRGB> incloud)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     process_cloud_ = incloud;
+    enforceHardBudget();
   }
 
 
@@ -92,6 +181,7 @@ namespace data
   bool DataCoordinator::getCloud(CloudTypes cloud_type, int id,
                                  pcl::PointCloud<pcl::PointXYZRGB>& cloud)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
@@ -100,13 +190,27 @@ namespace data
         {
           case input_cloud:
           {
-            cloud = rec.input_cloud_;
+            if (rec.input_cloud_file_.empty())
+            {
+              cloud = rec.input_cloud_;
+              return true;
+            }
+            if (pcl::io::loadPCDFile(rec.input_cloud_file_, cloud) != 0)
+              return false;
+            cloud.header = rec.input_cloud_.header; // PCD files don't keep the frame
             return true;
           }
 
           case surface_cloud:
           {
-            cloud = rec.surface_cloud_;
+            if (rec.surface_cloud_file_.empty())
+            {
+              cloud = rec.surface_cloud_;
+              return true;
+            }
+            if (pcl::io::loadPCDFile(rec.surface_cloud_file_, cloud) != 0)
+              return false;
+            cloud.header = rec.surface_cloud_.header;
             return true;
           }
 
@@ -132,6 +236,7 @@ namespace data
    */
   bool DataCoordinator::setSurfaceName(int id, const std::string& name)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
@@ -154,6 +259,7 @@ namespace data
    */
   bool DataCoordinator::getSurfaceName(int id, std::string& name)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
@@ -169,18 +275,30 @@ namespace data
 
 
   /**
-   * @brief Set the mesh of the specified record
+   * @brief Set the mesh of the specified record. It is stored indexed, as triangles of its vertex
+   * positions.
    * @param id ID of the desired record
-   * @param mesh PolygonMesh representing the surface of interest
-   * @return true if record is found, false otherwise
+   * @param mesh PolygonMesh representing the surface of interest, of triangles and quads
+   * @return true if record is found and the mesh could be stored, false otherwise
    */
   bool DataCoordinator::setSurfaceMesh(int id, pcl::PolygonMesh mesh)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
       {
-        rec.surface_mesh_ = mesh;
+        try
+        {
+          meshToIndexedMesh(mesh, rec.surface_mesh_);
+        }
+        catch (const std::invalid_argument& e)
+        {
+          ROS_ERROR_STREAM("Could not store the mesh of record " << id << ": " << e.what());
+          return false;
+        }
+        rec.surface_mesh_header_ = mesh.header;
+        enforceHardBudget();
         return true;
       }
     }
@@ -193,16 +311,18 @@ namespace data
   /**
    * @brief getSurfaceMesh
    * @param id ID of the desired record
-   * @param mesh Destination for the mesh
+   * @param mesh Destination for the mesh: triangles over a cloud of the vertex positions
    * @return true if record is found, false otherwise
    */
   bool DataCoordinator::getSurfaceMesh(int id, pcl::PolygonMesh& mesh)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
       {
-        mesh = rec.surface_mesh_;
+        indexedMeshToMesh(rec.surface_mesh_, mesh);
+        mesh.header = rec.surface_mesh_header_;
         return true;
       }
     }
@@ -222,6 +342,7 @@ namespace data
   bool DataCoordinator::addEdge(int id, std::string name,
                                 geometry_msgs::PoseArray edge_poses)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
@@ -249,6 +370,7 @@ namespace data
   bool DataCoordinator::renameEdge(int id, std::string old_name,
                                    std::string new_name)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
@@ -281,6 +403,7 @@ namespace data
   bool DataCoordinator::getEdgePosesByName(const std::string& edge_name,
                                            geometry_msgs::PoseArray& edge_poses)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       for (auto& edge_pair : rec.edge_pairs_)
@@ -309,6 +432,7 @@ namespace data
                                  int id,
                                  const std::vector<geometry_msgs::PoseArray>& poses)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
@@ -318,12 +442,14 @@ namespace data
           case blend_pose:
           {
             rec.blend_poses_ = poses;
+            enforceHardBudget();
             return true;
           }
 
           case scan_pose:
           {
             rec.scan_poses_ = poses;
+            enforceHardBudget();
             return true;
           }
 
@@ -350,6 +476,7 @@ namespace data
   bool DataCoordinator::getPoses(PoseTypes pose_type, int id,
                                  std::vector<geometry_msgs::PoseArray>& poses)
   {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     for(auto& rec : records_)
     {
       if(id == rec.id_)
@@ -388,6 +515,8 @@ namespace data
    */
   void DataCoordinator::asyncSaveRecord(boost::filesystem::path path)
   {
+    // Records are not spilled while they are being saved
+    ++saves_in_progress_;
     try
     {
       auto thd = std::thread(&DataCoordinator::saveRecord, this, path);
@@ -395,6 +524,7 @@ namespace data
     }
     catch (const std::exception& e)
     {
+      --saves_in_progress_;
       ROS_WARN_STREAM("Could not create save thread");
     }
   }
@@ -411,12 +541,15 @@ namespace data
     // TODO (austin.deric@gmail.com): Replace timestamp with session id.
     //                                Fix by Milestone 4.
 
+      // Held for the whole save, so the records can't be spilled or changed under it
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       std::stringstream session_id;
       session_id << ros::Time::now();
 
       if(!boost::filesystem::is_directory(path))
       {
         ROS_WARN_STREAM("Invalid Save Directory");
+        --saves_in_progress_;
         return;
       }
 
@@ -425,7 +558,17 @@ namespace data
         // write input_cloud_ to pcd files
         for(auto& rec : records_)
         {
-          if(!rec.input_cloud_.empty())
+          if(!rec.input_cloud_file_.empty())
+          {
+            std::stringstream save_loc;
+            save_loc << path.string() << session_id.str() << "_" << "input_cloud_"
+                     <<  rec.id_ << ".pcd";
+            boost::system::error_code ec;
+            boost::filesystem::copy_file(rec.input_cloud_file_, save_loc.str(), ec);
+            if(ec)
+              ROS_WARN_STREAM("input_cloud_ files not saved.");
+          }
+          else if(!rec.input_cloud_.empty())
           {
             std::stringstream save_loc;
             save_loc << path.string() << session_id.str() << "_" << "input_cloud_"
@@ -453,7 +596,85 @@ namespace data
       catch (const std::exception& e){
         ROS_WARN_STREAM("Data Save Error.");
       }
+    --saves_in_progress_;
     ROS_INFO_STREAM("Data Saved.");
   }
+
+  /**
+   * @brief bytesUsed Approximate memory held by the records and the process cloud
+   */
+  std::size_t DataCoordinator::bytesUsed() const
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::size_t bytes = godel_utils::memory::cloudBytes(process_cloud_);
+    for(const auto& rec : records_)
+      bytes += recordBytes(rec);
+    return bytes;
+  }
+
+  /**
+   * @brief evict Writes the clouds of the oldest records to the spill directory until the
+   * coordinator holds at most target_bytes. Meshes and poses stay in memory; planning reads them.
+   */
+  void DataCoordinator::evict(std::size_t target_bytes)
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if(saves_in_progress_ > 0)
+    {
+      ROS_DEBUG_STREAM("Records are being saved, not spilling them");
+      return;
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(spill_directory_, ec);
+    if(ec)
+    {
+      ROS_ERROR_STREAM("Could not create spill directory " << spill_directory_ << ": " << ec.message());
+      return;
+    }
+
+    std::size_t used = bytesUsed();
+    for(auto& rec : records_)
+    {
+      if(used <= target_bytes)
+        break;
+
+      const std::size_t before = recordBytes(rec);
+      const std::string base = (boost::filesystem::path(spill_directory_) /
+                                (spill_prefix_ + std::to_string(rec.id_))).string();
+      if(rec.input_cloud_file_.empty() && spillCloud(rec.input_cloud_, base + "_input.pcd"))
+        rec.input_cloud_file_ = base + "_input.pcd";
+      if(rec.surface_cloud_file_.empty() && spillCloud(rec.surface_cloud_, base + "_surface.pcd"))
+        rec.surface_cloud_file_ = base + "_surface.pcd";
+      used -= before - recordBytes(rec);
+    }
+  }
+
+  /**
+   * @brief spillCloud Writes a cloud to file and releases its memory
+   * @return true if the cloud is now held by the file
+   */
+  bool DataCoordinator::spillCloud(pcl::PointCloud<pcl::PointXYZRGB>& cloud, const std::string& file)
+  {
+    if(cloud.empty() || pcl::io::savePCDFileBinary(file, cloud) != 0)
+      return false;
+
+    cloud.points.clear();
+    cloud.points.shrink_to_fit();
+    cloud.width = cloud.height = 0;
+    return true;
+  }
+
+  void DataCoordinator::removeSpilledClouds()
+  {
+    boost::system::error_code ec;
+    for(const auto& rec : records_)
+    {
+      if(!rec.input_cloud_file_.empty())
+        boost::filesystem::remove(rec.input_cloud_file_, ec);
+      if(!rec.surface_cloud_file_.empty())
+        boost::filesystem::remove(rec.surface_cloud_file_, ec);
+    }
+  }
 } /* end namespace data */
 } /* end namespace godel_surface_detection */
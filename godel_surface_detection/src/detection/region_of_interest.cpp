@@ -0,0 +1,136 @@
+#include <detection/region_of_interest.h>
+#include <coordination/data_coordinator.h>
+#include <eigen_conversions/eigen_msg.h>
+#include <ros/console.h>
+
+#include <limits>
+
+namespace
+{
+
+// Even-odd rule: a ray along +x from the point crosses the edges of the polygon an odd number of
+// times if the point is inside
+template <typename Polygon>
+bool insidePolygon(const Polygon& polygon, const Eigen::Vector2f& p)
+{
+  bool inside = false;
+  for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+  {
+    const Eigen::Vector2f& a = polygon[i];
+    const Eigen::Vector2f& b = polygon[j];
+    if ((a.y() > p.y()) != (b.y() > p.y()) && p.x() < a.x() + (b.x() - a.x()) * (p.y() - a.y()) / (b.y() - a.y()))
+      inside = !inside;
+  }
+  return inside;
+}
+
+} // end anon namespace
+
+godel_surface_detection::detection::RegionOfInterestFilter::RegionOfInterestFilter(
+    const std::vector<godel_msgs::RegionOfInterest>& regions)
+{
+  for (const auto& roi : regions)
+  {
+    Eigen::Affine3d pose;
+    tf::poseMsgToEigen(roi.pose, pose);
+
+    Region region;
+    region.world_to_region = pose.inverse().cast<float>();
+    if (roi.type == godel_msgs::RegionOfInterest::BOX)
+    {
+      Eigen::Vector3d half;
+      tf::vectorMsgToEigen(roi.dimensions, half);
+      half *= 0.5;
+      region.min = -half.cast<float>();
+      region.max = half.cast<float>();
+    }
+    else if (roi.type == godel_msgs::RegionOfInterest::POLYGON_PRISM)
+    {
+      if (roi.polygon.size() < 3)
+      {
+        ROS_WARN_STREAM("Ignoring a region of interest whose polygon has " << roi.polygon.size() << " vertices");
+        continue;
+      }
+      const float inf = std::numeric_limits<float>::infinity();
+      region.min = Eigen::Vector3f(inf, inf, roi.min_height);
+      region.max = Eigen::Vector3f(-inf, -inf, roi.max_height);
+      for (const auto& vertex : roi.polygon)
+      {
+        const Eigen::Vector2f v(vertex.x, vertex.y);
+        region.polygon.push_back(v);
+        region.min.head<2>() = region.min.head<2>().cwiseMin(v);
+        region.max.head<2>() = region.max.head<2>().cwiseMax(v);
+      }
+    }
+    else
+    {
+      ROS_WARN_STREAM("Ignoring a region of interest of unknown type " << static_cast<int>(roi.type));
+      continue;
+    }
+    regions_.push_back(region);
+  }
+}
+
+bool godel_surface_detection::detection::RegionOfInterestFilter::contains(const Eigen::Vector3f& point) const
+{
+  if (regions_.empty())
+    return true;
+
+  for (const auto& region : regions_)
+  {
+    const Eigen::Vector3f p = region.world_to_region * point;
+    // The bounding box rules out most points before the polygon test
+    if ((p.array() < region.min.array()).any() || (p.array() > region.max.array()).any())
+      continue;
+    if (region.polygon.empty() || insidePolygon(region.polygon, p.head<2>()))
+      return true;
+  }
+  return false;
+}
+
+void godel_surface_detection::detection::RegionOfInterestFilter::crop(
+    const pcl::PointCloud<pcl::PointXYZRGB>& cloud, pcl::PointCloud<pcl::PointXYZRGB>& cropped) const
+{
+  cropped.clear();
+  cropped.header = cloud.header;
+  cropped.sensor_origin_ = cloud.sensor_origin_;
+  cropped.sensor_orientation_ = cloud.sensor_orientation_;
+  for (const auto& pt : cloud.points)
+  {
+    if (contains(pt.getVector3fMap()))
+      cropped.points.push_back(pt);
+  }
+  cropped.width = cropped.points.size();
+  cropped.height = 1;
+  cropped.is_dense = cloud.is_dense;
+}
+
+double godel_surface_detection::detection::RegionOfInterestFilter::share(
+    const pcl::PointCloud<pcl::PointXYZRGB>& cloud) const
+{
+  if (cloud.empty())
+    return 0.0;
+
+  std::size_t inside = 0;
+  for (const auto& pt : cloud.points)
+  {
+    if (contains(pt.getVector3fMap()))
+      ++inside;
+  }
+  return static_cast<double>(inside) / cloud.size();
+}
+
+std::vector<int> godel_surface_detection::detection::removeRecordsInRegions(
+    data::DataCoordinator& coordinator, const RegionOfInterestFilter& regions, double min_share)
+{
+  std::vector<int> removed;
+  for (int id : coordinator.getRecordIds())
+  {
+    pcl::PointCloud<pcl::PointXYZRGB> surface;
+    if (!coordinator.getCloud(data::surface_cloud, id, surface))
+      continue;
+    if (regions.share(surface) >= min_share && coordinator.removeRecord(id))
+      removed.push_back(id);
+  }
+  return removed;
+}
@@ -15,14 +15,17 @@
 */
 
 #include <detection/surface_detection.h>
+#include <detection/region_of_interest.h>
 #include <godel_param_helpers/godel_param_helpers.h>
 #include <meshing_plugins_base/meshing_base.h>
 #include <pcl_conversions/pcl_conversions.h>
 #include <pluginlib/class_loader.h>
+#include <segmentation/surface_merging.h>
 #include <segmentation/surface_segmentation.h>
 #include <sensor_msgs/point_cloud_conversion.h>
 #include <tf/transform_datatypes.h>
 #include <utils/mesh_conversions.h>
+#include <godel_utils/tracing.h>
 #include <swri_profiler/profiler.h>
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/pcl_base.h>
@@ -42,12 +45,19 @@ static std::string FRAME_ID = "world_frame";
 static const int STATISTICAL_OUTLIER_MEAN = 50;
 static const double STATISTICAL_OUTLIER_STDEV_THRESHOLD = 1;
 static const int K_SEARCH = 50;
+static const double NORMAL_RADIUS = 0.025f;
 
-static const int REGION_GROWING_MIN_CLUSTER_SIZE = 100;
-static const int REGION_GROWING_MAX_CLUSTER_SIZE = 100000;
-static const int REGION_GROWING_NEIGHBORS = 50;
-static const double REGION_GROWING_SMOOTHNESS_THRESHOLD = (M_PI / 180.0f) * 7.0f;
+static const int REGION_GROWING_MIN_CLUSTER_SIZE = 2500;
+static const int REGION_GROWING_MAX_CLUSTER_SIZE = 50000;
+static const int REGION_GROWING_NEIGHBORS = 30;
+static const double REGION_GROWING_SMOOTHNESS_THRESHOLD = 0.035f;
 static const double REGION_GROWING_CURVATURE_THRESHOLD = 1.0f;
+static const double REGION_GROWING_COARSE_LEAF = 0.0f;
+
+static const bool MERGE_ENABLED = true;
+static const double MERGE_MAX_ANGLE = 0.05f;
+static const double MERGE_MAX_OFFSET = 0.002f;
+static const double MERGE_MAX_RMS = 0.0015f;
 
 static const double TRIANGULATION_SEARCH_RADIUS = 0.01f;
 static const double TRIANGULATION_MU = 2.5f;
@@ -63,7 +73,7 @@ static const double PLANE_APROX_REFINEMENT_SEG_DIST_THRESHOLD = 0.01f;
 static const double PLANE_APROX_REFINEMENT_SAC_PLANE_DISTANCE = 0.01f;
 static const std::string PLANE_APROX_REFINEMENT_KDTREE_RADIUS = "pa_kdtree_radius";
 
-static const double VOXEL_LEAF_SIZE = 0.01f;
+static const double VOXEL_LEAF_SIZE = 0.0015f;
 
 static const double OCCUPANCY_THRESHOLD = 0.1f;
 
@@ -91,12 +101,19 @@ static const std::string USE_OCTOMAP = "use_octomap";
 static const std::string STOUTLIER_MEAN = "stout_mean";
 static const std::string STOUTLIER_STDEV_THRESHOLD = "stout_stdev_threshold";
 static const std::string K_SEARCH = "k_search";
+static const std::string NORMAL_RADIUS = "normal_radius";
 
 static const std::string REGION_GROWING_MIN_CLUSTER_SIZE = "rg_min_cluster_size";
 static const std::string REGION_GROWING_MAX_CLUSTER_SIZE = "rg_max_cluster_size";
 static const std::string REGION_GROWING_NEIGHBORS = "rg_neighbors";
 static const std::string REGION_GROWING_SMOOTHNESS_THRESHOLD = "rg_smoothness_threshold";
 static const std::string REGION_GROWING_CURVATURE_THRESHOLD = "rg_curvature_threshold";
+static const std::string REGION_GROWING_COARSE_LEAF = "rg_coarse_leaf";
+
+static const std::string MERGE_ENABLED = "merge_enabled";
+static const std::string MERGE_MAX_ANGLE = "merge_max_angle";
+static const std::string MERGE_MAX_OFFSET = "merge_max_offset";
+static const std::string MERGE_MAX_RMS = "merge_max_rms";
 
 static const std::string TRIANGULATION_SEARCH_RADIUS = "tr_search_radius";
 static const std::string TRIANGULATION_MU = "tr_mu";
@@ -128,7 +145,6 @@ static const std::string MARKER_ALPHA = "marker_alpha";
 }
 }
 
-static const float INPUT_CLOUD_VOXEL_FILTER_SIZE = 0.0015;
 const static int DOWNSAMPLE_NUMBER = 3;
 const static std::string MESHING_PLUGIN_PARAM = "meshing_plugin_name";
 
@@ -139,11 +155,15 @@ namespace godel_surface_detection
     SurfaceDetection::SurfaceDetection()
       : full_cloud_ptr_(new CloudRGB())
       , process_cloud_ptr_(new CloudRGB())
+      , region_colored_cloud_ptr_(new CloudRGB())
       , acquired_clouds_counter_(0)
+      , compacted_size_(0)
       , random_engine_(0) // This is using a fixed seed for down-sampling at the moment
+      , normal_estimation_threads_(0)
     {
       params_.frame_id = defaults::FRAME_ID;
       params_.k_search = defaults::K_SEARCH;
+      params_.normal_radius = defaults::NORMAL_RADIUS;
       params_.meanK = defaults::STATISTICAL_OUTLIER_MEAN;
       params_.stdv_threshold = defaults::STATISTICAL_OUTLIER_STDEV_THRESHOLD;
       params_.rg_min_cluster_size = defaults::REGION_GROWING_MIN_CLUSTER_SIZE;
@@ -151,6 +171,11 @@ namespace godel_surface_detection
       params_.rg_neightbors = defaults::REGION_GROWING_NEIGHBORS;
       params_.rg_smoothness_threshold = defaults::REGION_GROWING_SMOOTHNESS_THRESHOLD;
       params_.rg_curvature_threshold = defaults::REGION_GROWING_CURVATURE_THRESHOLD;
+      params_.rg_coarse_leaf = defaults::REGION_GROWING_COARSE_LEAF;
+      params_.merge_enabled = defaults::MERGE_ENABLED;
+      params_.merge_max_angle = defaults::MERGE_MAX_ANGLE;
+      params_.merge_max_offset = defaults::MERGE_MAX_OFFSET;
+      params_.merge_max_rms = defaults::MERGE_MAX_RMS;
       params_.tr_search_radius = defaults::TRIANGULATION_SEARCH_RADIUS;
       params_.tr_mu = defaults::TRIANGULATION_MU;
       params_.tr_max_nearest_neighbors = defaults::TRIANGULATION_MAX_NEAREST_NEIGHBORS;
@@ -170,6 +195,7 @@ namespace godel_surface_detection
 
     bool SurfaceDetection::init()
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       full_cloud_ptr_->header.frame_id = params_.frame_id;
       process_cloud_ptr_->header.frame_id = params_.frame_id;
       acquired_clouds_counter_ = 0;
@@ -178,8 +204,11 @@ namespace godel_surface_detection
 
     void SurfaceDetection::clear_results()
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       acquired_clouds_counter_ = 0;
+      compacted_size_ = 0;
       full_cloud_ptr_->clear();
+      full_cloud_ptr_->points.shrink_to_fit();
       process_cloud_ptr_->clear();
       surface_clouds_.clear();
       mesh_markers_.markers.clear();
@@ -196,6 +225,16 @@ namespace godel_surface_detection
         return true;
       }
       ros::NodeHandle nh("~/surface_detection");
+      // Optional, so that configurations written before it was added still load
+      nh.param(params::NORMAL_RADIUS, params_.normal_radius, defaults::NORMAL_RADIUS);
+      nh.param(params::REGION_GROWING_COARSE_LEAF, params_.rg_coarse_leaf, defaults::REGION_GROWING_COARSE_LEAF);
+      bool merge_enabled;
+      nh.param(params::MERGE_ENABLED, merge_enabled, defaults::MERGE_ENABLED);
+      params_.merge_enabled = merge_enabled;
+      nh.param(params::MERGE_MAX_ANGLE, params_.merge_max_angle, defaults::MERGE_MAX_ANGLE);
+      nh.param(params::MERGE_MAX_OFFSET, params_.merge_max_offset, defaults::MERGE_MAX_OFFSET);
+      nh.param(params::MERGE_MAX_RMS, params_.merge_max_rms, defaults::MERGE_MAX_RMS);
+
       return loadParam(nh, params::FRAME_ID, params_.frame_id) &&
              loadParam(nh, params::K_SEARCH, params_.k_search) &&
 
@@ -232,12 +271,10 @@ namespace godel_surface_detection
              loadParam(nh, params::MARKER_ALPHA, params_.marker_alpha);
     }
 
-    void SurfaceDetection::save_parameters(const std::string& filename)
+    std::future<bool> SurfaceDetection::save_parameters(const std::string& filename,
+                                                        godel_param_helpers::MessageFileWriter& writer)
     {
-      if (!godel_param_helpers::toFile(filename, params_))
-      {
-        ROS_WARN_STREAM("Unable to save surface-detection parameters to: " << filename);
-      }
+      return writer.save(filename, params_);
     }
 
     void SurfaceDetection::mesh_to_marker(const pcl::PolygonMesh& mesh,
@@ -268,52 +305,66 @@ namespace godel_surface_detection
 
     void SurfaceDetection::add_cloud(CloudRGB& cloud)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       (*full_cloud_ptr_) += cloud;
       acquired_clouds_counter_++;
+      enforceHardBudget();
     }
 
-    int SurfaceDetection::get_acquired_clouds_count() { return acquired_clouds_counter_; }
+    int SurfaceDetection::get_acquired_clouds_count()
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      return acquired_clouds_counter_;
+    }
 
 
     visualization_msgs::MarkerArray SurfaceDetection::get_surface_markers()
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       return visualization_msgs::MarkerArray(mesh_markers_);
     }
 
 
     void SurfaceDetection::get_meshes(std::vector<pcl::PolygonMesh>& meshes)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       meshes.insert(meshes.end(), meshes_.begin(), meshes_.end());
     }
 
 
     void SurfaceDetection::get_surface_clouds(std::vector<CloudRGB::Ptr>& surfaces)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       surfaces.insert(surfaces.end(), surface_clouds_.begin(), surface_clouds_.end());
     }
 
     void SurfaceDetection::get_full_cloud(CloudRGB& cloud)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       pcl::copyPointCloud(*full_cloud_ptr_, cloud);
     }
 
     void SurfaceDetection::get_full_cloud(sensor_msgs::PointCloud2 cloud_msg)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       pcl::toROSMsg(*full_cloud_ptr_, cloud_msg);
     }
 
     void SurfaceDetection::get_process_cloud(CloudRGB& cloud)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       pcl::copyPointCloud(*process_cloud_ptr_, cloud);
     }
 
     void SurfaceDetection::get_process_cloud(sensor_msgs::PointCloud2 &cloud_msg)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       pcl::toROSMsg(*process_cloud_ptr_, cloud_msg);
     }
 
     void SurfaceDetection::get_region_colored_cloud(CloudRGB& cloud)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       pcl::copyPointCloud(*region_colored_cloud_ptr_, cloud);
       cloud.header.frame_id = params_.frame_id;
     }
@@ -321,14 +372,14 @@ namespace godel_surface_detection
 
     void SurfaceDetection::get_region_colored_cloud(sensor_msgs::PointCloud2& cloud_msg)
     {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       pcl::toROSMsg(*region_colored_cloud_ptr_, cloud_msg);
       cloud_msg.header.frame_id = params_.frame_id;
     }
 
-    bool SurfaceDetection::find_surfaces()
+    bool SurfaceDetection::segment_surfaces()
     {
-      SWRI_PROFILE("find-surfaces");
-
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       // Reset members
       surface_clouds_.clear();
       mesh_markers_.markers.clear();
@@ -340,15 +391,63 @@ namespace godel_surface_detection
 
       filterFullCloud();
 
+      // e.g. regions of interest that hold none of the scanned points
+      if (process_cloud_ptr_->empty())
+      {
+        ROS_WARN_STREAM("No points are left to segment after filtering");
+        return false;
+      }
+
+      SegmentationParameters seg_params;
+      if (params_.normal_radius > 0.0)
+        seg_params.normal_radius = params_.normal_radius;
+      seg_params.smoothness_threshold = params_.rg_smoothness_threshold;
+      seg_params.curvature_threshold = params_.rg_curvature_threshold;
+      seg_params.min_cluster_size = params_.rg_min_cluster_size;
+      seg_params.max_cluster_size = params_.rg_max_cluster_size;
+      seg_params.num_neighbors = params_.rg_neightbors;
+      seg_params.coarse_leaf = params_.rg_coarse_leaf;
+      seg_params.num_threads = normal_estimation_threads_;
+
       // Segment the part into surface clusters using a "region growing" scheme
-      SurfaceSegmentation SS(process_cloud_ptr_);
+      SurfaceSegmentation SS(process_cloud_ptr_, seg_params);
       region_colored_cloud_ptr_ = CloudRGB::Ptr(new CloudRGB());
       {
         SWRI_PROFILE("segment-clouds");
+        GODEL_TRACE_SPAN("segment_clouds");
         SS.computeSegments(region_colored_cloud_ptr_);
       }
       SS.getSurfaceClouds(surface_clouds_);
 
+      merge_stats_ = SurfaceMergeStats();
+      merge_stats_.segments = merge_stats_.surfaces = surface_clouds_.size();
+      if (params_.merge_enabled)
+      {
+        SWRI_PROFILE("merge-surfaces");
+        GODEL_TRACE_SPAN("merge_surfaces");
+        SurfaceMergeParameters merge_params;
+        merge_params.max_angle = params_.merge_max_angle;
+        merge_params.max_offset = params_.merge_max_offset;
+        merge_params.max_rms = params_.merge_max_rms;
+        // Neighbouring segments are a few voxels apart after filtering
+        merge_params.adjacency_distance =
+            std::max(merge_params.adjacency_distance, 4.0 * params_.voxel_leafsize);
+        merge_stats_ = mergeCoplanarSurfaces(surface_clouds_, merge_params);
+        ROS_INFO_STREAM("Merged " << merge_stats_.segments << " segments into " << merge_stats_.surfaces
+                                  << " surfaces");
+      }
+      return true;
+    }
+
+    bool SurfaceDetection::find_surfaces()
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      SWRI_PROFILE("find-surfaces");
+      GODEL_TRACE_SPAN("find_surfaces");
+
+      if (!segment_surfaces())
+        return false;
+
       // Load the code to perform meshing dynamically
       pluginlib::ClassLoader<meshing_plugins_base::MeshingBase>
           poly_loader("meshing_plugins_base", "meshing_plugins_base::MeshingBase");
@@ -366,6 +465,7 @@ namespace godel_surface_detection
 
       // Compute mesh from point clouds
       SWRI_PROFILE("mesh-clouds");
+      GODEL_TRACE_SPAN("mesh_clouds");
       for (std::size_t i = 0; i < surface_clouds_.size(); i++)
       {
         pcl::PolygonMesh mesh;
@@ -398,6 +498,45 @@ namespace godel_surface_detection
       return true;
     }
 
+    std::size_t SurfaceDetection::bytesUsed() const
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      using godel_utils::memory::cloudBytes;
+      std::size_t bytes = cloudBytes(*full_cloud_ptr_) + cloudBytes(*process_cloud_ptr_) +
+                          cloudBytes(*region_colored_cloud_ptr_);
+      for (const auto& surface : surface_clouds_)
+        bytes += cloudBytes(*surface);
+      for (const auto& mesh : meshes_)
+        bytes += mesh.cloud.data.capacity() + mesh.polygons.size() * sizeof(pcl::Vertices);
+      for (const auto& marker : mesh_markers_.markers)
+        bytes += marker.points.capacity() * sizeof(geometry_msgs::Point);
+      return bytes;
+    }
+
+    void SurfaceDetection::evict(std::size_t target_bytes)
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      // The region colored cloud is only published for display after detection
+      if (!region_colored_cloud_ptr_->empty())
+        region_colored_cloud_ptr_.reset(new CloudRGB());
+      if (bytesUsed() <= target_bytes)
+        return;
+
+      // Detection filters the full cloud to this resolution anyway, so points that share a voxel
+      // are merged. Nothing is gained by compacting again until more scans arrive.
+      if (full_cloud_ptr_->size() == compacted_size_)
+        return;
+      CloudRGB::Ptr compacted(new CloudRGB());
+      pcl::VoxelGrid<pcl::PointXYZRGB> vox;
+      vox.setInputCloud(full_cloud_ptr_);
+      vox.setLeafSize(params_.voxel_leafsize, params_.voxel_leafsize, params_.voxel_leafsize);
+      vox.filter(*compacted);
+      compacted->points.shrink_to_fit();
+      compacted->header = full_cloud_ptr_->header;
+      full_cloud_ptr_ = compacted;
+      compacted_size_ = full_cloud_ptr_->size();
+    }
+
     std::string SurfaceDetection::getMeshingPluginName() const
     {
       ros::NodeHandle pnh ("~");
@@ -415,9 +554,20 @@ namespace godel_surface_detection
     {
       pcl::PointCloud<pcl::PointXYZRGB>::Ptr intermediate_cloud_ptr(new pcl::PointCloud<pcl::PointXYZRGB>);
 
+      //crop to the regions of interest first, so that the filters only see what is kept
+      CloudRGB::Ptr input_cloud_ptr = full_cloud_ptr_;
+      if (!regions_of_interest_.empty())
+      {
+        SWRI_PROFILE("crop-to-regions");
+        input_cloud_ptr.reset(new CloudRGB());
+        RegionOfInterestFilter(regions_of_interest_).crop(*full_cloud_ptr_, *input_cloud_ptr);
+        ROS_INFO_STREAM("Cropped " << full_cloud_ptr_->size() << " points to " << input_cloud_ptr->size()
+                                   << " in " << regions_of_interest_.size() << " regions of interest");
+      }
+
       //remove the table using the passthrough filter
       pcl::PassThrough<pcl::PointXYZRGB> pass;
-      pass.setInputCloud(full_cloud_ptr_);
+      pass.setInputCloud(input_cloud_ptr);
       const std::string FILTER_DIRECTION = "z";
       pass.setFilterFieldName (FILTER_DIRECTION);
       //keep poin clouds with these limits
@@ -429,9 +579,9 @@ namespace godel_surface_detection
       //downsample the full cloud using the voxelgrid filter method
       pcl::VoxelGrid<pcl::PointXYZRGB> vox;
       vox.setInputCloud (intermediate_cloud_ptr);
-      vox.setLeafSize (INPUT_CLOUD_VOXEL_FILTER_SIZE,
-                       INPUT_CLOUD_VOXEL_FILTER_SIZE,
-                       INPUT_CLOUD_VOXEL_FILTER_SIZE);
+      vox.setLeafSize (params_.voxel_leafsize,
+                       params_.voxel_leafsize,
+                       params_.voxel_leafsize);
       vox.filter(*process_cloud_ptr_);
     }
   } /* end namespace detection */
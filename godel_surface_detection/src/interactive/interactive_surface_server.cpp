@@ -24,11 +24,17 @@
 #include <pcl_ros/transforms.h>
 #include <pcl_ros/point_cloud.h>
 #include <pcl_conversions/pcl_conversions.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <boost/filesystem.hpp>
 
 #include "utils/mesh_conversions.h"
 
 const int RAND_MARKER_ID = -1;
 
+// tells the spill files of several servers apart
+static std::atomic<unsigned> server_count(0);
+
 namespace godel_surface_detection
 {
 namespace interactive
@@ -40,17 +46,24 @@ InteractiveSurfaceServer::InteractiveSurfaceServer()
       arrow_distance_(defaults::ARROW_DISTANCE),
       arrow_head_diameter_(defaults::ARROW_HEAD_DIAMETER),
       arrow_head_length_(defaults::ARROW_HEAD_LENGTH), arrow_length_(defaults::ARROW_LENGTH),
-      arrow_shaft_diameter_(defaults::ARROW_SHAFT_DIAMETER)
+      arrow_shaft_diameter_(defaults::ARROW_SHAFT_DIAMETER),
+      update_rate_(defaults::UPDATE_RATE), decimation_cell_size_(defaults::DECIMATION_CELL_SIZE),
+      changes_pending_(false), spill_directory_(godel_utils::memory::defaultSpillDirectory())
 {
-  // TODO Auto-generated constructor stub
+  std::stringstream ss;
+  ss << "interactive_surface_server_" << server_count++ << ".bag";
+  spill_name_ = ss.str();
 }
 
-InteractiveSurfaceServer::~InteractiveSurfaceServer()
+InteractiveSurfaceServer::~InteractiveSurfaceServer() { remove_spill_file(); }
+
+void InteractiveSurfaceServer::mesh_to_marker(const pcl::PolygonMesh& mesh,
+                                              visualization_msgs::Marker& marker)
 {
-  // TODO Auto-generated destructor stub
+  mesh_to_marker(mesh, 0.0, marker);
 }
 
-void InteractiveSurfaceServer::mesh_to_marker(const pcl::PolygonMesh& mesh,
+void InteractiveSurfaceServer::mesh_to_marker(const pcl::PolygonMesh& mesh, double decimation_cell_size,
                                               visualization_msgs::Marker& marker)
 {
   // color value ranges
@@ -80,7 +93,7 @@ void InteractiveSurfaceServer::mesh_to_marker(const pcl::PolygonMesh& mesh,
   marker.color = color;
 
   // filling points
-  meshToTrianglePoints(mesh, marker.points);
+  meshToDecimatedTrianglePoints(mesh, decimation_cell_size, marker.points);
 }
 
 void InteractiveSurfaceServer::marker_to_mesh(const visualization_msgs::Marker& marker,
@@ -92,6 +105,14 @@ void InteractiveSurfaceServer::marker_to_mesh(const visualization_msgs::Marker&
 
 bool InteractiveSurfaceServer::init()
 {
+  ros::NodeHandle ph("~/" + params::PARAMETER_NS);
+  ph.param(params::UPDATE_RATE, update_rate_, defaults::UPDATE_RATE);
+  ph.param(params::DECIMATION_CELL_SIZE, decimation_cell_size_, defaults::DECIMATION_CELL_SIZE);
+  if (update_rate_ <= 0.0)
+  {
+    ROS_WARN_STREAM("Invalid marker update rate " << update_rate_ << ", using " << defaults::UPDATE_RATE);
+    update_rate_ = defaults::UPDATE_RATE;
+  }
 
   srand(time(NULL));
   return true;
@@ -119,57 +140,138 @@ void InteractiveSurfaceServer::run()
   show_all_entry_id_ = menu_handler_.insert(submenu_handle, "Show All", menu_callback_);
 
   marker_server_ptr_->applyChanges();
+
+  ros::NodeHandle nh;
+  update_timer_ = nh.createTimer(ros::Duration(1.0 / update_rate_),
+                                 &InteractiveSurfaceServer::update_timer_callback, this);
 }
 
 void InteractiveSurfaceServer::stop()
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  update_timer_.stop();
   marker_server_ptr_.reset();
   surface_selection_map_.clear();
+  hidden_markers_.clear();
+  arrow_markers_.clear();
 }
 
-void InteractiveSurfaceServer::set_selection_flag(int id, bool selected)
+void InteractiveSurfaceServer::request_update()
 {
+  changes_pending_ = true;
+}
 
-  visualization_msgs::InteractiveMarker int_marker;
-  if (surface_selection_map_.count(id) > 0 && marker_server_ptr_->get(std::to_string(id), int_marker))
+void InteractiveSurfaceServer::update_timer_callback(const ros::TimerEvent&)
+{
+  if (changes_pending_.exchange(false))
   {
-    surface_selection_map_[id].selected = selected;
-    int_marker.controls[1].markers[0].type = selected ? visualization_msgs::Marker::ARROW : visualization_msgs::Marker::SPHERE;
-    int_marker.controls[1].markers[0].scale.x = selected ? arrow_shaft_diameter_ : 0.0001f;
-    int_marker.controls[1].markers[0].scale.y = selected ? arrow_head_diameter_ : 0.0001f;
-    int_marker.controls[1].markers[0].scale.z = selected ? arrow_head_length_ : 0.0001f;
+    marker_server_ptr_->applyChanges();
+  }
+}
+
+void InteractiveSurfaceServer::apply_pending_changes()
+{
+  changes_pending_ = false;
+  marker_server_ptr_->applyChanges();
+}
+
+/**
+ * Selection is shown by a separate, small arrow marker so that toggling it never re-sends the
+ * surface geometry. Returns false if there is no surface with the given id.
+ */
+bool InteractiveSurfaceServer::update_selection_flag(int id, bool selected)
+{
+  auto entry = surface_selection_map_.find(id);
+  auto arrow = arrow_markers_.find(id);
+  if (entry == surface_selection_map_.end() || arrow == arrow_markers_.end())
+  {
+    return false;
+  }
+
+  entry->second.selected = selected;
+  if (selected)
+  {
+    marker_server_ptr_->insert(arrow->second);
+  }
+  else
+  {
+    marker_server_ptr_->erase(arrow->second.name);
+  }
+  return true;
+}
 
-    marker_server_ptr_->insert(int_marker);
+/**
+ * Hidden surfaces are removed from the marker server and kept aside, so hiding only sends an
+ * erase and showing re-sends the geometry once.
+ */
+void InteractiveSurfaceServer::update_visibility(int id, bool show)
+{
+  const std::string name = std::to_string(id);
+  if (show)
+  {
+    auto hidden = hidden_markers_.find(id);
+    if (hidden != hidden_markers_.end())
+    {
+      marker_server_ptr_->insert(hidden->second, button_callback_);
+      menu_handler_.apply(*marker_server_ptr_, name);
+      hidden_markers_.erase(hidden);
+    }
+  }
+  else if (hidden_markers_.count(id) == 0)
+  {
+    visualization_msgs::InteractiveMarker int_marker;
+    if (marker_server_ptr_->get(name, int_marker))
+    {
+      hidden_markers_[id] = std::move(int_marker);
+      marker_server_ptr_->erase(name);
+    }
+  }
+}
+
+void InteractiveSurfaceServer::set_selection_flag(int id, bool selected)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (update_selection_flag(id, selected))
+  {
     invoke_callbacks();
-    marker_server_ptr_->applyChanges();
+    request_update();
   }
 }
 
 void InteractiveSurfaceServer::show(int id, bool show)
 {
-  visualization_msgs::InteractiveMarker int_marker;
-  if (surface_selection_map_.count(id) > 0 &&
-      marker_server_ptr_->get(std::to_string(id), int_marker))
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  auto entry = surface_selection_map_.find(id);
+  if (entry != surface_selection_map_.end())
   {
-
-    int_marker.controls[0].markers[0].scale.x = show ? 1 : 0.0001f;
-    int_marker.controls[0].markers[0].scale.y = show ? 1 : 0.0001f;
-    int_marker.controls[0].markers[0].scale.z = show ? 1 : 0.0001f;
-    marker_server_ptr_->insert(int_marker);
-    set_selection_flag(id, show && surface_selection_map_[id].selected);
+    update_visibility(id, show);
+    update_selection_flag(id, show && entry->second.selected);
+    invoke_callbacks();
+    request_update();
   }
 }
 
 void InteractiveSurfaceServer::select_all(bool select)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   for(auto& entry : surface_selection_map_)
-    set_selection_flag(entry.first, select);
+    update_selection_flag(entry.first, select);
+
+  invoke_callbacks();
+  request_update();
 }
 
 void InteractiveSurfaceServer::show_all(bool show_surf)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   for(auto& entry : surface_selection_map_)
-    show(entry.first, show_surf);
+  {
+    update_visibility(entry.first, show_surf);
+    update_selection_flag(entry.first, show_surf && entry.second.selected);
+  }
+
+  invoke_callbacks();
+  request_update();
 }
 
 void InteractiveSurfaceServer::invoke_callbacks()
@@ -183,6 +285,7 @@ void InteractiveSurfaceServer::invoke_callbacks()
 
 void InteractiveSurfaceServer::getSelectedIds(std::vector<int>& ids)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   for (const auto& entry : surface_selection_map_)
   {
     if(entry.second.selected)
@@ -193,6 +296,7 @@ void InteractiveSurfaceServer::getSelectedIds(std::vector<int>& ids)
 
 void InteractiveSurfaceServer::get_selected_list(std::vector<std::string>& list)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   for (const auto& entry : surface_selection_map_)
   {
     if(entry.second.selected)
@@ -208,8 +312,10 @@ void InteractiveSurfaceServer::get_selected_surfaces(visualization_msgs::MarkerA
     {
       visualization_msgs::InteractiveMarker int_marker;
       const std::string& id_string = std::to_string(entry.first);
-      marker_server_ptr_->get(id_string, int_marker);
-      surfaces.markers.push_back(int_marker.controls[0].markers[0]);
+      if (marker_server_ptr_->get(id_string, int_marker))
+        surfaces.markers.push_back(int_marker.controls[0].markers[0]);
+      else if (hidden_markers_.count(entry.first) > 0)
+        surfaces.markers.push_back(hidden_markers_[entry.first].controls[0].markers[0]);
     }
   }
 }
@@ -218,13 +324,23 @@ void InteractiveSurfaceServer::get_selected_surfaces(std::vector<pcl::PolygonMes
 {  
   for (const auto& entry : surface_selection_map_)
   {
-    if(entry.second.selected)
-      meshes.push_back(meshes_map_[entry.first]);
+    if(!entry.second.selected)
+      continue;
+
+    meshes.push_back(pcl::PolygonMesh());
+    if (!get_mesh(entry.first, meshes.back()))
+    {
+      ROS_ERROR_STREAM("Could not read the mesh of surface '" << entry.second.name << "'");
+      meshes.pop_back();
+    }
   }
 }
 
 void InteractiveSurfaceServer::toggle_selection_flag(int id)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   if (surface_selection_map_.count(id) > 0)
   {
     set_selection_flag(id, !surface_selection_map_[id].selected);
@@ -285,7 +401,6 @@ void InteractiveSurfaceServer::menu_marker_callback(
     else if (feedback->menu_entry_id == show_all_entry_id_)
     {
       show_all(true);
-      marker_server_ptr_->applyChanges();
       return;
     }
 
@@ -335,20 +450,27 @@ void InteractiveSurfaceServer::create_arrow_marker(const visualization_msgs::Mar
 
 void InteractiveSurfaceServer::remove_all_surfaces()
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   surface_selection_map_.clear();
   marker_server_ptr_->clear();
   meshes_map_.clear();
+  mesh_headers_.clear();
+  spilled_meshes_.clear();
+  remove_spill_file();
+  hidden_markers_.clear();
+  arrow_markers_.clear();
   invoke_callbacks();
-  marker_server_ptr_->applyChanges();
+  request_update();
 }
 
 
 std::string InteractiveSurfaceServer::add_surface(const int id, const pcl::PolygonMesh& mesh,
                                                   const geometry_msgs::Pose& pose)
 {
-  // convert polygon mesh to marker
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  // convert polygon mesh to a decimated marker
   visualization_msgs::Marker marker;
-  mesh_to_marker(mesh, marker);
+  mesh_to_marker(mesh, decimation_cell_size_, marker);
   marker.id = id;
   marker.color.a = defaults::MARKER_ALPHA;
 
@@ -368,7 +490,13 @@ std::string InteractiveSurfaceServer::add_surface(const int id, const pcl::Polyg
   button_control.name = "button_" + int_marker.name;
   button_control.always_visible = true;
 
-  // create seletected arrow marker
+  // fill interactive marker
+  int_marker.controls.push_back(button_control);
+  int_marker.scale = 1;
+  int_marker.header.frame_id = marker.header.frame_id;
+  int_marker.description = marker_description_;
+
+  // create selected arrow marker; it is only on the server while the surface is selected
   visualization_msgs::Marker arrow_marker;
   create_arrow_marker(marker, arrow_marker);
   visualization_msgs::InteractiveMarkerControl selected_arrow;
@@ -377,12 +505,12 @@ std::string InteractiveSurfaceServer::add_surface(const int id, const pcl::Polyg
   selected_arrow.name = "selected_" + int_marker.name;
   selected_arrow.always_visible = true;
 
-  // fill interactive marker
-  int_marker.controls.push_back(button_control);
-  int_marker.controls.push_back(selected_arrow);
-  int_marker.scale = 1;
-  int_marker.header.frame_id = marker.header.frame_id;
-  int_marker.description = marker_description_;
+  visualization_msgs::InteractiveMarker arrow_int_marker;
+  arrow_int_marker.name = selected_arrow.name;
+  arrow_int_marker.pose = pose;
+  arrow_int_marker.scale = 1;
+  arrow_int_marker.header.frame_id = marker.header.frame_id;
+  arrow_int_marker.controls.push_back(selected_arrow);
 
   // add marker to server
   marker_server_ptr_->insert(int_marker, button_callback_);
@@ -391,11 +519,15 @@ std::string InteractiveSurfaceServer::add_surface(const int id, const pcl::Polyg
   // save mesh
   SurfaceSelectionMapEntry entry {int_marker.name, false};
   surface_selection_map_.insert(std::pair<int, SurfaceSelectionMapEntry> (id, entry));
-  meshes_map_.insert(std::make_pair(id, mesh));
-  set_selection_flag(id, false);
-
-  // apply changes
-  marker_server_ptr_->applyChanges();
+  shape_msgs::Mesh indexed;
+  meshToIndexedMesh(mesh, indexed);
+  meshes_map_.insert(std::make_pair(id, indexed));
+  mesh_headers_.insert(std::make_pair(id, mesh.header));
+  arrow_markers_[id] = arrow_int_marker;
+  update_selection_flag(id, false);
+  enforceHardBudget();
+
+  request_update();
   return int_marker.name;
 }
 
@@ -430,10 +562,21 @@ std::string InteractiveSurfaceServer::add_surface(const int id, const visualizat
 
 void InteractiveSurfaceServer::add_selection_callback(SelectionCallback& f)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   selection_callbacks_.push_back(f);
 }
 
-void InteractiveSurfaceServer::clear_selection_callbacks() { selection_callbacks_.clear(); }
+void InteractiveSurfaceServer::clear_selection_callbacks()
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  selection_callbacks_.clear();
+}
+
+int InteractiveSurfaceServer::get_surface_count()
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return surface_selection_map_.size();
+}
 
 void InteractiveSurfaceServer::add_random_surface_marker()
 {
@@ -519,9 +662,9 @@ void InteractiveSurfaceServer::create_polygon_marker(visualization_msgs::Marker&
 
 bool InteractiveSurfaceServer::rename_surface(const int& id, const std::string& new_name)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   std::map<int, SurfaceSelectionMapEntry>::iterator select_iter = surface_selection_map_.find(id);
-  std::map<int, pcl::PolygonMesh>::iterator mesh_iter = meshes_map_.find(id);
-  if (select_iter != surface_selection_map_.end() && mesh_iter != meshes_map_.end())
+  if (select_iter != surface_selection_map_.end() && has_mesh(id))
   {
     select_iter->second.name = new_name;
     return true;
@@ -530,8 +673,116 @@ bool InteractiveSurfaceServer::rename_surface(const int& id, const std::string&
   return false;
 }
 
+static std::size_t meshBytes(const shape_msgs::Mesh& mesh)
+{
+  return mesh.vertices.capacity() * sizeof(geometry_msgs::Point) +
+         mesh.triangles.capacity() * sizeof(shape_msgs::MeshTriangle);
+}
+
+std::size_t InteractiveSurfaceServer::bytesUsed() const
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::size_t bytes = 0;
+  for (const auto& entry : meshes_map_)
+    bytes += meshBytes(entry.second);
+  return bytes;
+}
+
+static std::string spillTopic(int id) { return "surface_mesh_" + std::to_string(id); }
+
+void InteractiveSurfaceServer::evict(std::size_t target_bytes)
+{
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (meshes_map_.empty())
+    return;
+
+  // Surfaces are added in id order, so the lowest ids go first
+  try
+  {
+    boost::filesystem::create_directories(spill_directory_);
+    rosbag::Bag bag;
+    bag.open(spill_file(), boost::filesystem::exists(spill_file()) ? rosbag::bagmode::Append
+                                                                   : rosbag::bagmode::Write);
+    const ros::Time stamp(ros::WallTime::now().toSec());
+    std::size_t used = bytesUsed();
+    while (!meshes_map_.empty() && used > target_bytes)
+    {
+      std::map<int, shape_msgs::Mesh>::iterator it = meshes_map_.begin();
+      bag.write(spillTopic(it->first), stamp, it->second);
+
+      used -= meshBytes(it->second);
+      spilled_meshes_.insert(it->first);
+      meshes_map_.erase(it);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    ROS_ERROR_STREAM("Could not spill surface meshes to " << spill_file() << ": " << e.what());
+  }
+}
+
+bool InteractiveSurfaceServer::has_mesh(int id) const
+{
+  return meshes_map_.count(id) > 0 || spilled_meshes_.count(id) > 0;
+}
+
+bool InteractiveSurfaceServer::get_mesh(int id, pcl::PolygonMesh& mesh) const
+{
+  std::map<int, pcl::PCLHeader>::const_iterator header = mesh_headers_.find(id);
+  if (header == mesh_headers_.end())
+    return false;
+
+  std::map<int, shape_msgs::Mesh>::const_iterator it = meshes_map_.find(id);
+  if (it != meshes_map_.end())
+  {
+    indexedMeshToMesh(it->second, mesh);
+    mesh.header = header->second;
+    return true;
+  }
+  if (spilled_meshes_.count(id) == 0)
+    return false;
+
+  // A mesh may have been spilled more than once; the last copy is the current one
+  shape_msgs::MeshConstPtr spilled;
+  try
+  {
+    rosbag::Bag bag;
+    bag.open(spill_file(), rosbag::bagmode::Read);
+    rosbag::View view(bag, rosbag::TopicQuery(spillTopic(id)));
+    for (rosbag::View::iterator m = view.begin(); m != view.end(); ++m)
+    {
+      shape_msgs::MeshConstPtr ptr = m->instantiate<shape_msgs::Mesh>();
+      if (ptr)
+        spilled = ptr;
+    }
+  }
+  catch (const rosbag::BagException& e)
+  {
+    ROS_ERROR_STREAM("Could not read spilled mesh of surface " << id << ": " << e.what());
+    return false;
+  }
+  if (!spilled)
+    return false;
+
+  indexedMeshToMesh(*spilled, mesh);
+  mesh.header = header->second;
+  return true;
+}
+
+std::string InteractiveSurfaceServer::spill_file() const
+{
+  return (boost::filesystem::path(spill_directory_) / spill_name_).string();
+}
+
+void InteractiveSurfaceServer::remove_spill_file()
+{
+  boost::system::error_code ec;
+  boost::filesystem::remove(spill_file(), ec);
+}
+
 bool InteractiveSurfaceServer::getIdFromName(const std::string& name, int& id)
 {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   for(const auto& entry : surface_selection_map_)
   {
     if(name.compare(entry.second.name) == 0)
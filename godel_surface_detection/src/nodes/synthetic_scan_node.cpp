@@ -0,0 +1,101 @@
+/*
+ * Stands in for the sensor with a synthetic part: publishes the sampled part with its ground truth
+ * surface labels, and organized simulated views of it taken from the poses of the robot scan, one
+ * per period, on the scan topic. See launch/synthetic_scan.launch for the parameters.
+ */
+
+#include <ros/ros.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <scan/robot_scan.h>
+#include <synthetic/synthetic_workload.h>
+
+using namespace godel_surface_detection;
+
+const static std::string PART_PARAM = "part";
+const static std::string CAMERA_PARAM_NS = "camera";
+const static std::string FRAME_ID_PARAM = "frame_id";
+const static std::string PUBLISH_PERIOD_PARAM = "publish_period";
+const static std::string DEFAULT_FRAME_ID = "world_frame";
+const static double DEFAULT_PUBLISH_PERIOD = 1.0;
+
+// topics
+const static std::string PART_TOPIC = "synthetic_part";
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "synthetic_scan_node");
+  ros::NodeHandle nh;
+  ros::NodeHandle ph("~");
+
+  // part
+  XmlRpc::XmlRpcValue description;
+  synthetic::PartDescription part;
+  if (!ph.getParam(PART_PARAM, description) || !synthetic::loadPart(description, part))
+  {
+    ROS_ERROR_STREAM("Failed to load the synthetic part from '" << ph.resolveName(PART_PARAM) << "'");
+    return 1;
+  }
+
+  // scan
+  scan::RobotScan robot_scan;
+  if (!robot_scan.load_parameters(""))
+  {
+    ROS_ERROR_STREAM("Failed to load the robot scan parameters from '" << ph.resolveName("robot_scan") << "'");
+    return 1;
+  }
+  const synthetic::CameraModel camera = synthetic::loadCamera(ros::NodeHandle(ph, CAMERA_PARAM_NS));
+  const std::vector<Eigen::Affine3d> views = synthetic::scanCameraPoses(robot_scan.params_);
+  if (views.empty())
+  {
+    ROS_ERROR_STREAM("The robot scan has no scan points");
+    return 1;
+  }
+
+  std::string frame_id;
+  double publish_period;
+  ph.param(FRAME_ID_PARAM, frame_id, DEFAULT_FRAME_ID);
+  ph.param(PUBLISH_PERIOD_PARAM, publish_period, DEFAULT_PUBLISH_PERIOD);
+  if (publish_period <= 0.0)
+  {
+    ROS_WARN_STREAM("'" << PUBLISH_PERIOD_PARAM << "' must be positive, using " << DEFAULT_PUBLISH_PERIOD << "s");
+    publish_period = DEFAULT_PUBLISH_PERIOD;
+  }
+
+  synthetic::LabelledCloud cloud;
+  ros::WallTime start = ros::WallTime::now();
+  if (!synthetic::generatePart(part, cloud))
+    return 1;
+  ROS_INFO_STREAM("Generated a synthetic part of " << cloud.size() << " points with "
+                                                   << synthetic::surfaceNames(part).size() << " surfaces in "
+                                                   << (ros::WallTime::now() - start).toSec() << "s");
+
+  sensor_msgs::PointCloud2 part_msg;
+  pcl::toROSMsg(cloud, part_msg);
+  part_msg.header.frame_id = frame_id;
+  part_msg.header.stamp = ros::Time::now();
+  ros::Publisher part_pub = nh.advertise<sensor_msgs::PointCloud2>(PART_TOPIC, 1, true);
+  part_pub.publish(part_msg);
+
+  // Every view has its own seed, so a view looks the same every time around
+  std::vector<sensor_msgs::PointCloud2> view_msgs(views.size());
+  for (std::size_t i = 0; i < views.size(); ++i)
+  {
+    synthetic::simulateView(part, camera, views[i], part.seed + static_cast<unsigned>(i), cloud);
+    pcl::toROSMsg(cloud, view_msgs[i]);
+    view_msgs[i].header.frame_id = frame_id;
+  }
+
+  ros::Publisher scan_pub = nh.advertise<sensor_msgs::PointCloud2>(robot_scan.params_.scan_topic, 1);
+  ROS_INFO_STREAM("Publishing " << views.size() << " simulated views on '" << scan_pub.getTopic() << "'");
+
+  ros::Rate rate(1.0 / publish_period);
+  for (std::size_t i = 0; ros::ok(); i = (i + 1) % views.size())
+  {
+    view_msgs[i].header.stamp = ros::Time::now();
+    scan_pub.publish(view_msgs[i]);
+    ros::spinOnce();
+    rate.sleep();
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include <scan/continuous_scan.h>
+
+#include <algorithm>
+#include <cmath>
+
+std::vector<double> godel_surface_detection::scan::captureTimes(double duration, double frame_rate)
+{
+  std::vector<double> times;
+  if (duration < 0.0 || frame_rate <= 0.0)
+    return times;
+
+  // Counted rather than accumulated, so that the last frame isn't lost to rounding
+  const std::size_t frames = static_cast<std::size_t>(std::floor(duration * frame_rate + 1e-9)) + 1;
+  for (std::size_t i = 0; i < frames; ++i)
+    times.push_back(i / frame_rate);
+  return times;
+}
+
+double godel_surface_detection::scan::maxJointVelocity(const trajectory_msgs::JointTrajectory& trajectory, double t)
+{
+  const std::vector<trajectory_msgs::JointTrajectoryPoint>& points = trajectory.points;
+  if (points.empty() || t < points.front().time_from_start.toSec() || t > points.back().time_from_start.toSec())
+    return 0.0;
+
+  // The first point at or after t, and the one before it
+  auto after = std::lower_bound(points.begin(), points.end(), t,
+                                [](const trajectory_msgs::JointTrajectoryPoint& p, double time) {
+                                  return p.time_from_start.toSec() < time;
+                                });
+  auto before = after == points.begin() ? after : after - 1;
+  const double t0 = before->time_from_start.toSec();
+  const double t1 = after->time_from_start.toSec();
+  const double s = t1 > t0 ? (t - t0) / (t1 - t0) : 1.0;
+
+  double speed = 0.0;
+  const std::size_t joints = std::min(before->velocities.size(), after->velocities.size());
+  for (std::size_t j = 0; j < joints; ++j)
+    speed = std::max(speed, std::abs((1.0 - s) * before->velocities[j] + s * after->velocities[j]));
+  return speed;
+}
+
+double godel_surface_detection::scan::departureTime(const trajectory_msgs::JointTrajectory& trajectory,
+                                                     double tolerance)
+{
+  const std::vector<trajectory_msgs::JointTrajectoryPoint>& points = trajectory.points;
+  if (points.empty())
+    return 0.0;
+
+  const std::vector<double>& start = points.front().positions;
+  for (std::size_t i = 1; i < points.size(); ++i)
+  {
+    const trajectory_msgs::JointTrajectoryPoint& before = points[i - 1];
+    const trajectory_msgs::JointTrajectoryPoint& after = points[i];
+    const std::size_t joints = std::min(start.size(), std::min(before.positions.size(), after.positions.size()));
+
+    // The earliest time in this segment that a joint reaches 'tolerance' from its start
+    double s = 1.0;
+    bool departed = false;
+    for (std::size_t j = 0; j < joints; ++j)
+    {
+      const double d0 = before.positions[j] - start[j];
+      const double d1 = after.positions[j] - start[j];
+      if (std::abs(d1) < tolerance)
+        continue;
+      const double target = d1 > 0.0 ? tolerance : -tolerance;
+      s = std::min(s, std::abs(d1 - d0) > 0.0 ? std::max(0.0, (target - d0) / (d1 - d0)) : 0.0);
+      departed = true;
+    }
+    if (departed)
+    {
+      const double t0 = before.time_from_start.toSec();
+      return t0 + s * (after.time_from_start.toSec() - t0);
+    }
+  }
+  return points.back().time_from_start.toSec();
+}
+
+bool godel_surface_detection::scan::hasDeparted(const trajectory_msgs::JointTrajectory& trajectory,
+                                                const sensor_msgs::JointState& state, double tolerance)
+{
+  if (trajectory.points.empty())
+    return false;
+
+  const std::vector<double>& start = trajectory.points.front().positions;
+  for (std::size_t j = 0; j < std::min(start.size(), trajectory.joint_names.size()); ++j)
+  {
+    auto name = std::find(state.name.begin(), state.name.end(), trajectory.joint_names[j]);
+    const std::size_t k = name - state.name.begin();
+    if (name != state.name.end() && k < state.position.size() && std::abs(state.position[k] - start[j]) > tolerance)
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,278 @@
+#include <scan/next_best_view.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Rays are walked in steps of this fraction of a cell
+const static double RAY_STEP = 0.5;
+
+namespace godel_surface_detection
+{
+namespace scan
+{
+
+VisibilityMap::VisibilityMap(const Eigen::Affine3d& world_to_map, const Eigen::Vector3d& min,
+                             const Eigen::Vector3d& max, double resolution)
+  : map_to_world_(world_to_map.inverse()), min_(min), resolution_(resolution), occupied_(0)
+{
+  const Eigen::Vector3d cells = ((max - min) / resolution).array().ceil().max(1.0);
+  nx_ = static_cast<int>(cells.x());
+  ny_ = static_cast<int>(cells.y());
+  nz_ = static_cast<int>(cells.z());
+  cells_.assign(static_cast<std::size_t>(nx_) * ny_ * nz_, UNKNOWN);
+}
+
+bool VisibilityMap::index(const Eigen::Vector3d& map_point, std::size_t& i) const
+{
+  const Eigen::Vector3d c = (map_point - min_) / resolution_;
+  const int x = static_cast<int>(std::floor(c.x()));
+  const int y = static_cast<int>(std::floor(c.y()));
+  const int z = static_cast<int>(std::floor(c.z()));
+  if (x < 0 || y < 0 || z < 0 || x >= nx_ || y >= ny_ || z >= nz_)
+    return false;
+  i = (static_cast<std::size_t>(z) * ny_ + y) * nx_ + x;
+  return true;
+}
+
+// Slab test of a ray (map frame) against the map's box; [t0, t1] is the part of the ray inside
+bool VisibilityMap::clip(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double& t0,
+                         double& t1) const
+{
+  const Eigen::Vector3d max = min_ + resolution_ * Eigen::Vector3d(nx_, ny_, nz_);
+  for (int k = 0; k < 3; ++k)
+  {
+    if (std::abs(direction[k]) < 1e-12)
+    {
+      if (origin[k] < min_[k] || origin[k] > max[k])
+        return false;
+      continue;
+    }
+    double a = (min_[k] - origin[k]) / direction[k];
+    double b = (max[k] - origin[k]) / direction[k];
+    if (a > b)
+      std::swap(a, b);
+    t0 = std::max(t0, a);
+    t1 = std::min(t1, b);
+  }
+  return t0 <= t1;
+}
+
+void VisibilityMap::integrate(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, const Eigen::Vector3d& origin)
+{
+  const Eigen::Vector3d o = map_to_world_ * origin;
+  const double step = RAY_STEP * resolution_;
+
+  for (const auto& pt : cloud.points)
+  {
+    if (!std::isfinite(pt.x) || !std::isfinite(pt.y) || !std::isfinite(pt.z))
+      continue;
+    const Eigen::Vector3d p = map_to_world_ * Eigen::Vector3d(pt.x, pt.y, pt.z);
+    const double length = (p - o).norm();
+    if (length < 1e-9)
+      continue;
+    const Eigen::Vector3d d = (p - o) / length;
+
+    double t0 = 0.0, t1 = length;
+    std::size_t i;
+    if (clip(o, d, t0, t1))
+    {
+      for (double t = t0; t < t1; t += step)
+      {
+        if (index(o + t * d, i) && cells_[i] == UNKNOWN)
+          cells_[i] = FREE;
+      }
+    }
+    if (index(p, i) && cells_[i] != OCCUPIED)
+    {
+      cells_[i] = OCCUPIED;
+      ++occupied_;
+    }
+  }
+}
+
+VisibilityMap::CellState VisibilityMap::castRay(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction,
+                                                double min_range, double max_range, double& range) const
+{
+  const Eigen::Vector3d o = map_to_world_ * origin;
+  const Eigen::Vector3d d = (map_to_world_.linear() * direction).normalized();
+
+  double t0 = min_range, t1 = max_range;
+  if (!clip(o, d, t0, t1))
+    return FREE;
+
+  std::size_t i;
+  for (double t = t0; t <= t1; t += RAY_STEP * resolution_)
+  {
+    if (index(o + t * d, i) && cells_[i] != FREE)
+    {
+      range = t;
+      return static_cast<CellState>(cells_[i]);
+    }
+  }
+  return FREE;
+}
+
+VisibilityMap::CellState VisibilityMap::at(const Eigen::Vector3d& point) const
+{
+  std::size_t i;
+  return index(map_to_world_ * point, i) ? static_cast<CellState>(cells_[i]) : FREE;
+}
+
+std::size_t VisibilityMap::frontierCells() const
+{
+  const std::size_t sx = 1, sy = nx_, sz = static_cast<std::size_t>(nx_) * ny_;
+  std::size_t frontier = 0;
+  for (int z = 0; z < nz_; ++z)
+  {
+    for (int y = 0; y < ny_; ++y)
+    {
+      for (int x = 0; x < nx_; ++x)
+      {
+        const std::size_t i = z * sz + y * sy + x;
+        if (cells_[i] != UNKNOWN)
+          continue;
+        if ((x > 0 && cells_[i - sx] == FREE) || (x + 1 < nx_ && cells_[i + sx] == FREE) ||
+            (y > 0 && cells_[i - sy] == FREE) || (y + 1 < ny_ && cells_[i + sy] == FREE) ||
+            (z > 0 && cells_[i - sz] == FREE) || (z + 1 < nz_ && cells_[i + sz] == FREE))
+          ++frontier;
+      }
+    }
+  }
+  return frontier;
+}
+
+double VisibilityMap::coverage() const
+{
+  if (occupied_ == 0)
+    return 0.0;
+  return static_cast<double>(occupied_) / (occupied_ + frontierCells());
+}
+
+static Eigen::Affine3d objectPose(const godel_msgs::RobotScanParameters& scan_params)
+{
+  const geometry_msgs::Pose& p = scan_params.world_to_obj_pose;
+  return Eigen::Translation3d(p.position.x, p.position.y, p.position.z) *
+         Eigen::Quaterniond(p.orientation.w, p.orientation.x, p.orientation.y, p.orientation.z).normalized();
+}
+
+std::vector<Eigen::Affine3d> NextBestViewPlanner::candidatePoses(const godel_msgs::RobotScanParameters& scan_params,
+                                                                 const NextBestViewParameters& params)
+{
+  const Eigen::Affine3d world_to_obj = objectPose(scan_params);
+  const Eigen::Vector3d target = 0.5 * (params.map_min + params.map_max);
+
+  std::vector<Eigen::Affine3d> poses;
+  for (double elevation : params.elevations)
+  {
+    for (int a = 0; a < params.azimuths; ++a)
+    {
+      const double azimuth = 2.0 * M_PI * a / params.azimuths;
+      const Eigen::Vector3d out(std::cos(elevation) * std::cos(azimuth), std::cos(elevation) * std::sin(azimuth),
+                                std::sin(elevation));
+
+      // x looks at the target, y is horizontal so that images stay upright around the part
+      Eigen::Matrix3d r;
+      r.col(0) = -out;
+      r.col(1) = Eigen::Vector3d(-std::sin(azimuth), std::cos(azimuth), 0.0);
+      r.col(2) = r.col(0).cross(r.col(1));
+
+      Eigen::Affine3d obj_to_cam = Eigen::Affine3d::Identity();
+      obj_to_cam.linear() = r;
+      obj_to_cam.translation() = target + params.standoff * out;
+      poses.push_back(world_to_obj * obj_to_cam);
+    }
+  }
+  return poses;
+}
+
+NextBestViewPlanner::NextBestViewPlanner(const godel_msgs::RobotScanParameters& scan_params,
+                                         const NextBestViewParameters& params, const ReachabilityCheck& reachable)
+  : params_(params), map_(objectPose(scan_params), params.map_min, params.map_max, params.resolution),
+    has_pose_(false), current_pose_(Eigen::Affine3d::Identity()), views_(0), scan_time_(0.0)
+{
+  for (const Eigen::Affine3d& pose : candidatePoses(scan_params, params))
+  {
+    if (reachable.empty() || reachable(pose))
+      candidates_.push_back(pose);
+  }
+  available_.assign(candidates_.size(), true);
+}
+
+void NextBestViewPlanner::setCurrentPose(const Eigen::Affine3d& world_to_cam)
+{
+  current_pose_ = world_to_cam;
+  has_pose_ = true;
+}
+
+double NextBestViewPlanner::motionTime(const Eigen::Affine3d& from, const Eigen::Affine3d& to) const
+{
+  const double distance = (to.translation() - from.translation()).norm();
+  const double angle = Eigen::AngleAxisd(from.linear().transpose() * to.linear()).angle();
+  return std::max(distance / params_.linear_speed, angle / params_.angular_speed);
+}
+
+double NextBestViewPlanner::expectedGain(const Eigen::Affine3d& world_to_cam) const
+{
+  const double dh = params_.fov_horizontal / params_.rays_horizontal;
+  const double dv = params_.fov_vertical / params_.rays_vertical;
+  const Eigen::Vector3d origin = world_to_cam.translation();
+
+  double gain = 0.0;
+  for (int v = 0; v < params_.rays_vertical; ++v)
+  {
+    const double tan_v = std::tan(-0.5 * params_.fov_vertical + (v + 0.5) * dv);
+    for (int h = 0; h < params_.rays_horizontal; ++h)
+    {
+      const double tan_h = std::tan(-0.5 * params_.fov_horizontal + (h + 0.5) * dh);
+      const Eigen::Vector3d direction = world_to_cam.linear() * Eigen::Vector3d(1.0, tan_h, tan_v).normalized();
+
+      // Each ray stands for the patch of the image around it, whose area grows with range
+      double range;
+      if (map_.castRay(origin, direction, params_.min_range, params_.max_range, range) == VisibilityMap::UNKNOWN)
+        gain += range * range * dh * dv;
+    }
+  }
+  return gain;
+}
+
+int NextBestViewPlanner::nextView() const
+{
+  if (views_ >= static_cast<std::size_t>(params_.max_views) ||
+      (views_ > 0 && map_.coverage() >= params_.coverage_target))
+    return -1;
+
+  int best = -1;
+  double best_rate = 0.0;
+  for (std::size_t i = 0; i < candidates_.size(); ++i)
+  {
+    if (!available_[i])
+      continue;
+    const double gain = expectedGain(candidates_[i]);
+    if (gain < params_.min_gain)
+      continue;
+    const double time =
+        (has_pose_ ? motionTime(current_pose_, candidates_[i]) : 0.0) + params_.capture_time;
+    if (gain / time > best_rate)
+    {
+      best_rate = gain / time;
+      best = static_cast<int>(i);
+    }
+  }
+  return best;
+}
+
+void NextBestViewPlanner::addView(std::size_t candidate, const pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+{
+  const Eigen::Affine3d& pose = candidates_[candidate];
+  scan_time_ += (has_pose_ ? motionTime(current_pose_, pose) : 0.0) + params_.capture_time;
+  setCurrentPose(pose);
+  map_.integrate(cloud, pose.translation());
+  available_[candidate] = false;
+  ++views_;
+}
+
+void NextBestViewPlanner::rejectView(std::size_t candidate) { available_[candidate] = false; }
+
+} // namespace scan
+} // namespace godel_surface_detection
@@ -20,13 +20,24 @@
 #include <pcl/common/common.h>
 #include <pcl/filters/filter.h>
 #include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
 #include <boost/assert.hpp>
 #include <math.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
 #include <godel_param_helpers/godel_param_helpers.h>
+#include <godel_utils/model_cache.h>
+#include <ros/callback_queue.h>
+#include <tf_conversions/tf_eigen.h>
+
+#include <chrono>
+#include <future>
 
 static const std::string DEFAULT_MOVEIT_PLANNER = "RRTConnectkConfigDefault";
+static const unsigned int REACHABILITY_IK_ATTEMPTS = 3;
+static const double REACHABILITY_IK_TIMEOUT = 0.05; // seconds per attempt
+static const double SWEEP_DEPARTURE_TOLERANCE = 1e-3; // (rad) joint motion that shows the sweep has started
+static const std::string JOINT_STATES_TOPIC = "joint_states";
 
 static bool loadPoseParam(ros::NodeHandle& nh, const std::string& name, geometry_msgs::Pose& pose)
 {
@@ -40,6 +51,57 @@ static bool loadPoseParam(ros::NodeHandle& nh, const std::string& name, geometry
          loadParam(nh, name + "/quat/w", pose.orientation.w);
 }
 
+static bool loadVectorParam(ros::NodeHandle& nh, const std::string& name, Eigen::Vector3d& value)
+{
+  std::vector<double> v;
+  if (!nh.getParam(name, v))
+    return true;
+  if (v.size() != 3)
+  {
+    ROS_ERROR_STREAM("Parameter '" << nh.resolveName(name) << "' must be a list of 3 numbers");
+    return false;
+  }
+  value = Eigen::Vector3d(v[0], v[1], v[2]);
+  return true;
+}
+
+// Every next best view parameter is optional, so that configurations without them still load
+static bool loadNextBestViewParams(ros::NodeHandle& nh, bool& enabled,
+                                   godel_surface_detection::scan::NextBestViewParameters& params)
+{
+  nh.param("enabled", enabled, false);
+  nh.param("resolution", params.resolution, params.resolution);
+  nh.param("standoff", params.standoff, params.standoff);
+  nh.param("azimuths", params.azimuths, params.azimuths);
+  nh.param("elevations", params.elevations, params.elevations);
+  nh.param("fov_horizontal", params.fov_horizontal, params.fov_horizontal);
+  nh.param("fov_vertical", params.fov_vertical, params.fov_vertical);
+  nh.param("min_range", params.min_range, params.min_range);
+  nh.param("max_range", params.max_range, params.max_range);
+  nh.param("rays_horizontal", params.rays_horizontal, params.rays_horizontal);
+  nh.param("rays_vertical", params.rays_vertical, params.rays_vertical);
+  nh.param("linear_speed", params.linear_speed, params.linear_speed);
+  nh.param("angular_speed", params.angular_speed, params.angular_speed);
+  nh.param("capture_time", params.capture_time, params.capture_time);
+  nh.param("coverage_target", params.coverage_target, params.coverage_target);
+  nh.param("max_views", params.max_views, params.max_views);
+  nh.param("min_gain", params.min_gain, params.min_gain);
+  return loadVectorParam(nh, "map_min", params.map_min) && loadVectorParam(nh, "map_max", params.map_max);
+}
+
+// Optional as well
+static void loadContinuousScanParams(ros::NodeHandle& nh, bool& enabled,
+                                     godel_surface_detection::scan::ContinuousScanParameters& params)
+{
+  nh.param("enabled", enabled, false);
+  nh.param("frame_rate", params.frame_rate, params.frame_rate);
+  nh.param("hardware_trigger", params.hardware_trigger, params.hardware_trigger);
+  nh.param("velocity_scaling", params.velocity_scaling, params.velocity_scaling);
+  nh.param("max_joint_velocity", params.max_joint_velocity, params.max_joint_velocity);
+  nh.param("transform_timeout", params.transform_timeout, params.transform_timeout);
+  nh.param("jump_threshold", params.jump_threshold, params.jump_threshold);
+}
+
 namespace godel_surface_detection
 {
 namespace scan
@@ -51,7 +113,7 @@ const double RobotScan::MIN_TRAJECTORY_TIME_STEP = 0.8f; // seconds
 const double RobotScan::EEF_STEP = 0.05f;                // 5cm
 const double RobotScan::MIN_JOINT_VELOCITY = 0.01f;      // rad/sect
 
-RobotScan::RobotScan()
+RobotScan::RobotScan() : use_next_best_view_(false), use_continuous_scan_(false)
 {
 
   params_.group_name = "manipulator_asus";
@@ -74,7 +136,9 @@ RobotScan::RobotScan()
 
 bool RobotScan::init()
 {
-  move_group_ptr_ = MoveGroupPtr(new  moveit::planning_interface::MoveGroupInterface(params_.group_name));
+  moveit::planning_interface::MoveGroupInterface::Options options(
+      params_.group_name, godel_utils::model_cache::cachedRobotDescription());
+  move_group_ptr_ = MoveGroupPtr(new moveit::planning_interface::MoveGroupInterface(options));
   move_group_ptr_->setEndEffectorLink(params_.tcp_frame);
   move_group_ptr_->setPoseReferenceFrame(params_.world_frame);
   move_group_ptr_->setPlanningTime(PLANNING_TIME);
@@ -90,6 +154,14 @@ bool RobotScan::load_parameters(const std::string& filename)
   using godel_param_helpers::loadParam;
   using godel_param_helpers::loadBoolParam;
 
+  ros::NodeHandle nbv_nh("~/robot_scan/next_best_view");
+  if (!loadNextBestViewParams(nbv_nh, use_next_best_view_, next_best_view_params_))
+  {
+    return false;
+  }
+  ros::NodeHandle continuous_nh("~/robot_scan/continuous_scan");
+  loadContinuousScanParams(continuous_nh, use_continuous_scan_, continuous_scan_params_);
+
   if (godel_param_helpers::fromFile(filename, params_))
   {
     return true;
@@ -114,12 +186,10 @@ bool RobotScan::load_parameters(const std::string& filename)
          loadBoolParam(nh, "stop_on_planning_error", params_.stop_on_planning_error);
 }
 
-void RobotScan::save_parameters(const std::string& filename)
+std::future<bool> RobotScan::save_parameters(const std::string& filename,
+                                             godel_param_helpers::MessageFileWriter& writer)
 {
-  if (!godel_param_helpers::toFile(filename, params_))
-  {
-    ROS_WARN_STREAM("Unable to save macro scan-parameters to: " << filename);
-  }
+  return writer.save(filename, params_);
 }
 
 void RobotScan::add_scan_callback(ScanCallback cb) { callback_list_.push_back(cb); }
@@ -177,12 +247,27 @@ bool RobotScan::move_to_pose(geometry_msgs::Pose& target_pose)
 
 int RobotScan::scan(bool move_only)
 {
-  // cartesian path generation
-  double eef_step = EEF_STEP; // 1*alpha_incr*params_.cam_to_obj_xoffset;
-  double jump_threshold = 0.0;
-  moveit::planning_interface::MoveGroupInterface::Plan path_plan;
-  geometry_msgs::PoseArray cartesian_poses;
-  path_plan.planning_time_ = PLANNING_TIME;
+  if (use_next_best_view_)
+  {
+    if (move_only)
+    {
+      ROS_WARN_STREAM("Next best views are picked from the scans, moving through the circular sweep instead");
+    }
+    else if (params_.scan_target_frame != params_.world_frame)
+    {
+      ROS_WARN_STREAM("Next best view scanning needs the scans in '" << params_.world_frame
+                      << "', using the circular sweep instead");
+    }
+    else
+    {
+      return scan_next_best_view();
+    }
+  }
+
+  if (use_continuous_scan_ && !move_only)
+  {
+    return scan_continuous();
+  }
 
   // create trajectory
   scan_traj_poses_.clear();
@@ -190,40 +275,10 @@ int RobotScan::scan(bool move_only)
   moveit_msgs::RobotTrajectory robot_traj;
   if (create_scan_trajectory(scan_traj_poses_, robot_traj))
   {
-    std::vector<geometry_msgs::Pose> trajectory_poses;
-
-    // inserting all poses
-    trajectory_poses.push_back(move_group_ptr_->getCurrentPose(params_.tcp_frame).pose);
-    trajectory_poses.insert(trajectory_poses.begin() + 1, scan_traj_poses_.begin(),
-                            scan_traj_poses_.end());
-
-    for (size_t i = 1; i < trajectory_poses.size(); i++)
+    for (size_t i = 1; i <= scan_traj_poses_.size(); i++)
     {
-      // reset path plan structure
-      path_plan.start_state_ = moveit_msgs::RobotState();
-      path_plan.trajectory_ = moveit_msgs::RobotTrajectory();
-
-      // filling cartesian poses for next move
-      cartesian_poses.poses.clear();
-      cartesian_poses.poses.push_back(trajectory_poses[i]);
-
-      // creating path plan structure and execute
-      move_group_ptr_->setStartStateToCurrentState();
-
-      // Todo: What follows is a hack to get saner motions for the automate demonstration
-      // Can fail to plan because the solution is not checked for collisions/limits etc
-      // though in practice it works pretty well.
-      auto current_state = move_group_ptr_->getCurrentJointValues();
-      auto rob_model = move_group_ptr_->getRobotModel();
-      moveit::core::RobotState state (rob_model);
-      state.setVariablePositions(current_state);
-      state.setFromIK(rob_model->getJointModelGroup(params_.group_name), trajectory_poses[i], params_.tcp_frame);
-      std::vector<double> to_goto (state.getVariablePositions(), state.getVariablePositions() + current_state.size());
-      move_group_ptr_->setJointValueTarget(to_goto);
-//      move_group_ptr_->setPoseTarget(trajectory_poses[i], params_.tcp_frame);
-
       moveit::planning_interface::MoveGroupInterface::Plan my_plan;
-      bool success = static_cast<bool>(move_group_ptr_->plan(my_plan));
+      bool success = plan_scan_move(scan_traj_poses_[i - 1], my_plan);
 
       if (!success)
       {
@@ -239,7 +294,7 @@ int RobotScan::scan(bool move_only)
         }
       }
 
-      if (move_group_ptr_->execute(my_plan))
+      if (execute_plan(my_plan))
       {
         poses_reached++;
       }
@@ -259,55 +314,8 @@ int RobotScan::scan(bool move_only)
 
       if (!move_only)
       {
-        // get message
-        ros::Duration(1.0).sleep();
-        sensor_msgs::PointCloud2ConstPtr msg = ros::topic::waitForMessage<sensor_msgs::PointCloud2>(
-            params_.scan_topic, ros::Duration(WAIT_MSG_DURATION));
-        pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_ptr(new pcl::PointCloud<pcl::PointXYZRGB>());
-        tf::StampedTransform source_to_target_tf;
-        if (msg)
-        {
-          ROS_INFO_STREAM("Cloud message received, converting to target frame '"
-                          << params_.scan_target_frame << "'");
-
-          // convert to message to point cloud
-          pcl::fromROSMsg<pcl::PointXYZRGB>(*msg, *cloud_ptr);
-
-          // removed nans
-          std::vector<int> index;
-          pcl::removeNaNFromPointCloud(*cloud_ptr, *cloud_ptr, index);
-
-          // transforming
-          if (msg->header.frame_id.compare(params_.scan_target_frame) != 0)
-          {
-            try
-            {
-              tf_listener_ptr_->lookupTransform(params_.scan_target_frame, msg->header.frame_id,
-                                                ros::Time(0), source_to_target_tf);
-              pcl_ros::transformPointCloud(*cloud_ptr, *cloud_ptr, source_to_target_tf);
-            }
-            catch (tf::LookupException& e)
-            {
-              ROS_ERROR_STREAM("Transform lookup error, using source frame id '"
-                               << msg->header.frame_id << "'");
-            }
-            catch (tf::ExtrapolationException& e)
-            {
-              ROS_ERROR_STREAM("Transform lookup error, using source frame id '"
-                               << msg->header.frame_id << "'");
-            }
-          }
-
-          for (std::vector<ScanCallback>::iterator i = callback_list_.begin();
-               i != callback_list_.end(); i++)
-          {
-            (*i)(*cloud_ptr);
-          }
-        }
-        else
-        {
-          ROS_ERROR_STREAM("Cloud message not received");
-        }
+        pcl::PointCloud<pcl::PointXYZRGB> cloud;
+        acquire_scan(cloud);
       }
       else
       {
@@ -321,49 +329,372 @@ int RobotScan::scan(bool move_only)
   return poses_reached;
 }
 
+int RobotScan::scan_next_best_view()
+{
+  tf::Transform tcp_to_cam_tf;
+  tf::poseMsgToTF(params_.tcp_to_cam_pose, tcp_to_cam_tf);
+
+  NextBestViewPlanner planner(params_, next_best_view_params_,
+                              boost::bind(&RobotScan::is_camera_pose_reachable, this, _1));
+  ROS_INFO_STREAM(planner.candidates().size() << " next best view candidates are reachable");
+
+  tf::Transform world_to_tcp_tf;
+  tf::poseMsgToTF(move_group_ptr_->getCurrentPose(params_.tcp_frame).pose, world_to_tcp_tf);
+  Eigen::Affine3d world_to_cam;
+  tf::transformTFToEigen(world_to_tcp_tf * tcp_to_cam_tf, world_to_cam);
+  planner.setCurrentPose(world_to_cam);
+
+  scan_traj_poses_.clear();
+  int poses_reached = 0;
+  int next;
+  while ((next = planner.nextView()) >= 0)
+  {
+    tf::Transform world_to_cam_tf;
+    tf::transformEigenToTF(planner.candidates()[next], world_to_cam_tf);
+    geometry_msgs::Pose pose;
+    tf::poseTFToMsg(world_to_cam_tf * tcp_to_cam_tf.inverse(), pose);
+
+    moveit::planning_interface::MoveGroupInterface::Plan my_plan;
+    if (!plan_scan_move(pose, my_plan) || !execute_plan(my_plan))
+    {
+      if (params_.stop_on_planning_error)
+      {
+        ROS_ERROR_STREAM("Moving to next best view " << next << " failed, quitting scan");
+        break;
+      }
+      ROS_WARN_STREAM("Moving to next best view " << next << " failed, skipping it");
+      planner.rejectView(next);
+      continue;
+    }
+    scan_traj_poses_.push_back(pose);
+    poses_reached++;
+
+    // A view that returned nothing still counts as visited, so that it isn't picked again
+    pcl::PointCloud<pcl::PointXYZRGB> cloud;
+    acquire_scan(cloud);
+    planner.addView(next, cloud);
+
+    ros::Duration(0.5f).sleep();
+  }
+
+  ROS_INFO_STREAM("Next best view scan: " << planner.views() << " views, estimated coverage "
+                  << 100.0 * planner.map().coverage() << "%, estimated scan time " << planner.scanTime()
+                  << " s");
+  return poses_reached;
+}
+
+int RobotScan::scan_continuous()
+{
+  scan_traj_poses_.clear();
+  moveit_msgs::RobotTrajectory robot_traj;
+  if (!create_scan_trajectory(scan_traj_poses_, robot_traj) || scan_traj_poses_.empty())
+  {
+    return 0;
+  }
+
+  moveit::planning_interface::MoveGroupInterface::Plan approach;
+  if (!plan_scan_move(scan_traj_poses_.front(), approach) || !execute_plan(approach))
+  {
+    ROS_ERROR_STREAM("Moving to the first scan position failed, quitting scan");
+    return 0;
+  }
+
+  // The rest of the sweep as one motion; it can only end early, never skip a pose
+  moveit::planning_interface::MoveGroupInterface::Plan plan;
+  const double fraction = plan_sweep(scan_traj_poses_, plan);
+  const trajectory_msgs::JointTrajectory& joint_trajectory = plan.trajectory_.joint_trajectory;
+  if (fraction <= 0.0 || joint_trajectory.points.empty())
+  {
+    ROS_ERROR_STREAM("Planning the scan sweep failed, quitting scan");
+    return 0;
+  }
+  if (fraction < 1.0)
+  {
+    if (params_.stop_on_planning_error)
+    {
+      ROS_ERROR_STREAM("The scan sweep is blocked after " << 100.0 * fraction << "% of its path, quitting scan");
+      return 0;
+    }
+    ROS_WARN_STREAM("The scan sweep is blocked after " << 100.0 * fraction << "% of its path, ending it there");
+  }
+  const int poses_reached = 1 + static_cast<int>(std::floor(fraction * (scan_traj_poses_.size() - 1) + 1e-9));
+  const double duration = joint_trajectory.points.back().time_from_start.toSec();
+  const double departure = departureTime(joint_trajectory, SWEEP_DEPARTURE_TOLERANCE);
+
+  // Frames are only buffered during the motion: TF can only interpolate a frame's pose once it
+  // has robot states from after its capture. The sweep starts when the controller starts it,
+  // which is found from the first robot state that has left the start of the trajectory.
+  ros::NodeHandle nh;
+  ros::CallbackQueue queue;
+  nh.setCallbackQueue(&queue);
+  const bool triggered = continuous_scan_params_.hardware_trigger;
+  std::vector<sensor_msgs::PointCloud2ConstPtr> frames;
+  sensor_msgs::PointCloud2ConstPtr latest;
+  ros::Time start_time;
+  boost::function<void(const sensor_msgs::PointCloud2ConstPtr&)> on_cloud =
+      [&](const sensor_msgs::PointCloud2ConstPtr& msg) {
+        if (triggered)
+          frames.push_back(msg);
+        else
+          latest = msg;
+      };
+  boost::function<void(const sensor_msgs::JointStateConstPtr&)> on_joint_state =
+      [&](const sensor_msgs::JointStateConstPtr& msg) {
+        if (start_time.isZero() && hasDeparted(joint_trajectory, *msg, SWEEP_DEPARTURE_TOLERANCE))
+          start_time = msg->header.stamp - ros::Duration(departure);
+      };
+  ros::Subscriber scan_sub = nh.subscribe<sensor_msgs::PointCloud2>(params_.scan_topic, 10, on_cloud);
+  ros::Subscriber joint_state_sub = nh.subscribe<sensor_msgs::JointState>(JOINT_STATES_TOPIC, 100, on_joint_state);
+
+  std::future<bool> executed = std::async(std::launch::async, [this, &plan]() { return execute_plan(plan); });
+  const std::vector<double> capture_times = captureTimes(duration, continuous_scan_params_.frame_rate);
+  std::size_t next_capture = 0;
+  while (executed.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready)
+  {
+    queue.callAvailable(ros::WallDuration(0.01));
+    if (triggered || start_time.isZero())
+      continue;
+    const double t = (ros::Time::now() - start_time).toSec();
+    while (next_capture < capture_times.size() && t >= capture_times[next_capture])
+    {
+      if (latest && (frames.empty() || frames.back() != latest))
+        frames.push_back(latest);
+      next_capture++;
+    }
+  }
+  queue.callAvailable();
+  scan_sub.shutdown();
+  joint_state_sub.shutdown();
+
+  if (!executed.get())
+  {
+    ROS_ERROR_STREAM("Executing the scan sweep failed, dropping its " << frames.size() << " frames");
+    return 0;
+  }
+  if (start_time.isZero())
+  {
+    ROS_ERROR_STREAM("No robot state on '" << nh.resolveName(JOINT_STATES_TOPIC)
+                     << "' showed the scan sweep start, dropping its " << frames.size() << " frames");
+    return 0;
+  }
+
+  int rejected = 0, fused = 0;
+  for (const sensor_msgs::PointCloud2ConstPtr& msg : frames)
+  {
+    const ros::Time& stamp = msg->header.stamp;
+    if (maxJointVelocity(joint_trajectory, (stamp - start_time).toSec()) > continuous_scan_params_.max_joint_velocity)
+    {
+      rejected++;
+      continue;
+    }
+
+    pcl::PointCloud<pcl::PointXYZRGB> cloud;
+    pcl::fromROSMsg<pcl::PointXYZRGB>(*msg, cloud);
+    std::vector<int> index;
+    pcl::removeNaNFromPointCloud(cloud, cloud, index);
+
+    // Transformed with the camera pose at the capture stamp, which TF interpolates between the
+    // robot states around it; a frame without one is dropped rather than fused in the wrong place
+    if (msg->header.frame_id != params_.scan_target_frame)
+    {
+      tf::StampedTransform source_to_target_tf;
+      try
+      {
+        tf_listener_ptr_->waitForTransform(params_.scan_target_frame, msg->header.frame_id, stamp,
+                                           ros::Duration(continuous_scan_params_.transform_timeout));
+        tf_listener_ptr_->lookupTransform(params_.scan_target_frame, msg->header.frame_id, stamp,
+                                          source_to_target_tf);
+      }
+      catch (tf::TransformException& e)
+      {
+        ROS_WARN_STREAM("Dropping the frame captured at " << stamp << ": " << e.what());
+        continue;
+      }
+      pcl_ros::transformPointCloud(cloud, cloud, source_to_target_tf);
+    }
+
+    for (std::vector<ScanCallback>::iterator i = callback_list_.begin(); i != callback_list_.end(); i++)
+    {
+      (*i)(cloud);
+    }
+    fused++;
+  }
+
+  ROS_INFO_STREAM("Continuous scan: " << duration << " s sweep, " << frames.size() << " frames, " << rejected
+                  << " rejected as blurred, " << fused << " fused");
+  return fused > 0 ? poses_reached : 0;
+}
+
+double RobotScan::plan_sweep(const std::vector<geometry_msgs::Pose>& poses,
+                             moveit::planning_interface::MoveGroupInterface::Plan& plan)
+{
+  move_group_ptr_->setEndEffectorLink(params_.tcp_frame);
+  move_group_ptr_->setStartStateToCurrentState();
+
+  // Interpolated in Cartesian space, so the tcp stays on the sweep between the poses; move_group
+  // checks every state against the planning scene
+  moveit_msgs::RobotTrajectory path;
+  const double fraction = move_group_ptr_->computeCartesianPath(
+      poses, EEF_STEP, continuous_scan_params_.jump_threshold, path, true);
+  if (fraction <= 0.0)
+  {
+    return fraction;
+  }
+
+  // Retimed at the scan's share of the joint limits
+  moveit::core::RobotStatePtr start = move_group_ptr_->getCurrentState();
+  robot_trajectory::RobotTrajectory sweep(move_group_ptr_->getRobotModel(), params_.group_name);
+  sweep.setRobotTrajectoryMsg(*start, path);
+  trajectory_processing::IterativeParabolicTimeParameterization time_parameterization;
+  if (!time_parameterization.computeTimeStamps(sweep, continuous_scan_params_.velocity_scaling,
+                                               continuous_scan_params_.velocity_scaling))
+  {
+    return 0.0;
+  }
+  sweep.getRobotTrajectoryMsg(plan.trajectory_);
+  moveit::core::robotStateToRobotStateMsg(*start, plan.start_state_);
+  return fraction;
+}
+
+bool RobotScan::execute_plan(const moveit::planning_interface::MoveGroupInterface::Plan& plan)
+{
+  return static_cast<bool>(move_group_ptr_->execute(plan));
+}
+
+bool RobotScan::plan_scan_move(const geometry_msgs::Pose& pose,
+                               moveit::planning_interface::MoveGroupInterface::Plan& plan)
+{
+  move_group_ptr_->setEndEffectorLink(params_.tcp_frame);
+  move_group_ptr_->setStartStateToCurrentState();
+
+  // Todo: What follows is a hack to get saner motions for the automate demonstration
+  // Can fail to plan because the solution is not checked for collisions/limits etc
+  // though in practice it works pretty well.
+  auto current_state = move_group_ptr_->getCurrentJointValues();
+  auto rob_model = move_group_ptr_->getRobotModel();
+  moveit::core::RobotState state (rob_model);
+  state.setVariablePositions(current_state);
+  state.setFromIK(rob_model->getJointModelGroup(params_.group_name), pose, params_.tcp_frame);
+  std::vector<double> to_goto (state.getVariablePositions(), state.getVariablePositions() + current_state.size());
+  move_group_ptr_->setJointValueTarget(to_goto);
+//      move_group_ptr_->setPoseTarget(pose, params_.tcp_frame);
+
+  return static_cast<bool>(move_group_ptr_->plan(plan));
+}
+
+bool RobotScan::acquire_scan(pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+{
+  // get message
+  ros::Duration(1.0).sleep();
+  sensor_msgs::PointCloud2ConstPtr msg = ros::topic::waitForMessage<sensor_msgs::PointCloud2>(
+      params_.scan_topic, ros::Duration(WAIT_MSG_DURATION));
+  tf::StampedTransform source_to_target_tf;
+  if (!msg)
+  {
+    ROS_ERROR_STREAM("Cloud message not received");
+    return false;
+  }
+
+  ROS_INFO_STREAM("Cloud message received, converting to target frame '"
+                  << params_.scan_target_frame << "'");
+
+  // convert to message to point cloud
+  pcl::fromROSMsg<pcl::PointXYZRGB>(*msg, cloud);
+
+  // removed nans
+  std::vector<int> index;
+  pcl::removeNaNFromPointCloud(cloud, cloud, index);
+
+  // transforming
+  if (msg->header.frame_id.compare(params_.scan_target_frame) != 0)
+  {
+    try
+    {
+      tf_listener_ptr_->lookupTransform(params_.scan_target_frame, msg->header.frame_id,
+                                        ros::Time(0), source_to_target_tf);
+      pcl_ros::transformPointCloud(cloud, cloud, source_to_target_tf);
+    }
+    catch (tf::LookupException& e)
+    {
+      ROS_ERROR_STREAM("Transform lookup error, using source frame id '"
+                       << msg->header.frame_id << "'");
+    }
+    catch (tf::ExtrapolationException& e)
+    {
+      ROS_ERROR_STREAM("Transform lookup error, using source frame id '"
+                       << msg->header.frame_id << "'");
+    }
+  }
+
+  for (std::vector<ScanCallback>::iterator i = callback_list_.begin();
+       i != callback_list_.end(); i++)
+  {
+    (*i)(cloud);
+  }
+  return true;
+}
+
+bool RobotScan::is_camera_pose_reachable(const Eigen::Affine3d& world_to_cam)
+{
+  tf::Transform world_to_cam_tf, tcp_to_cam_tf;
+  tf::transformEigenToTF(world_to_cam, world_to_cam_tf);
+  tf::poseMsgToTF(params_.tcp_to_cam_pose, tcp_to_cam_tf);
+  geometry_msgs::Pose pose;
+  tf::poseTFToMsg(world_to_cam_tf * tcp_to_cam_tf.inverse(), pose);
+
+  moveit::core::RobotState state(move_group_ptr_->getRobotModel());
+  state.setToDefaultValues();
+  return state.setFromIK(state.getJointModelGroup(params_.group_name), pose, params_.tcp_frame,
+                         REACHABILITY_IK_ATTEMPTS, REACHABILITY_IK_TIMEOUT);
+}
+
 MoveGroupPtr RobotScan::get_move_group() { return move_group_ptr_; }
 
 bool RobotScan::create_scan_trajectory(std::vector<geometry_msgs::Pose>& scan_poses,
                                        moveit_msgs::RobotTrajectory& scan_traj)
 {
   // creating poses
-  tf::Transform world_to_tcp = tf::Transform::getIdentity();
-  tf::Transform world_to_cam = tf::Transform::getIdentity();
-  tf::Transform obj_to_cam_pose = tf::Transform::getIdentity();
-  tf::Transform tcp_to_cam_tf, world_to_obj_tf;
-
-  // converting pose msg to tf
-  tf::poseMsgToTF(params_.world_to_obj_pose, world_to_obj_tf);
+  tf::Transform tcp_to_cam_tf;
   tf::poseMsgToTF(params_.tcp_to_cam_pose, tcp_to_cam_tf);
 
+  std::vector<tf::Transform> world_to_cam;
+  compute_camera_poses(params_, world_to_cam);
+
   geometry_msgs::Pose pose;
+  for (const tf::Transform& cam : world_to_cam)
+  {
+    tf::poseTFToMsg(cam * tcp_to_cam_tf.inverse(), pose);
+    scan_poses.push_back(pose);
+  }
+
+  return true;
+}
+
+void RobotScan::compute_camera_poses(const godel_msgs::RobotScanParameters& params,
+                                     std::vector<tf::Transform>& world_to_cam)
+{
+  tf::Transform world_to_obj_tf;
+  tf::poseMsgToTF(params.world_to_obj_pose, world_to_obj_tf);
+
   double alpha;
-  double alpha_incr = params_.num_scan_points == 1 ? 0.0 :
-      (params_.sweep_angle_end - params_.sweep_angle_start) / (params_.num_scan_points - 1);
-  double eef_step = 4 * alpha_incr * params_.cam_to_obj_xoffset;
-  double jump_threshold = 0.0f;
+  double alpha_incr = params.num_scan_points == 1 ? 0.0 :
+      (params.sweep_angle_end - params.sweep_angle_start) / (params.num_scan_points - 1);
 
   // relative transforms
   tf::Transform xoffset_disp =
-      tf::Transform(tf::Quaternion::getIdentity(), tf::Vector3(params_.cam_to_obj_xoffset, 0, 0));
+      tf::Transform(tf::Quaternion::getIdentity(), tf::Vector3(params.cam_to_obj_xoffset, 0, 0));
   tf::Transform zoffset_disp =
-      tf::Transform(tf::Quaternion::getIdentity(), tf::Vector3(0, 0, params_.cam_to_obj_zoffset));
+      tf::Transform(tf::Quaternion::getIdentity(), tf::Vector3(0, 0, params.cam_to_obj_zoffset));
   tf::Transform rot_alpha_about_z = tf::Transform::getIdentity();
   tf::Transform rot_tilt_about_y =
-      tf::Transform(tf::Quaternion(tf::Vector3(0, 1, 0), params_.cam_tilt_angle));
-  for (int i = 0; i < params_.num_scan_points; i++)
+      tf::Transform(tf::Quaternion(tf::Vector3(0, 1, 0), params.cam_tilt_angle));
+  for (int i = 0; i < params.num_scan_points; i++)
   {
-    alpha = params_.sweep_angle_start + alpha_incr * i;
+    alpha = params.sweep_angle_start + alpha_incr * i;
     rot_alpha_about_z = tf::Transform(tf::Quaternion(tf::Vector3(0, 0, 1), alpha));
-    obj_to_cam_pose = zoffset_disp * rot_alpha_about_z * xoffset_disp * rot_tilt_about_y;
-    world_to_tcp = world_to_obj_tf * obj_to_cam_pose * tcp_to_cam_tf.inverse();
-    tf::poseTFToMsg(world_to_tcp, pose);
-    scan_poses.push_back(pose);
+    world_to_cam.push_back(world_to_obj_tf * zoffset_disp * rot_alpha_about_z * xoffset_disp *
+                           rot_tilt_about_y);
   }
-
-  move_group_ptr_->setEndEffectorLink(params_.tcp_frame);
-
-  return true;
 }
 
 void RobotScan::apply_trajectory_parabolic_time_parameterization(
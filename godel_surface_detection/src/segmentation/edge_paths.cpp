@@ -0,0 +1,69 @@
+#include <segmentation/edge_paths.h>
+#include <segmentation/surface_segmentation.h>
+#include <eigen_conversions/eigen_msg.h>
+#include <ros/console.h>
+
+// Edge Processing constants
+const static double SEGMENTATION_SEARCH_RADIUS = 0.03; // 3cm
+const static int BOUNDARY_THRESHOLD = 10;
+
+static void computeBoundaries(SurfaceSegmentation& SS, std::vector<pcl::IndicesPtr>& sorted_boundaries)
+{
+  pcl::PointCloud<pcl::Boundary>::Ptr boundary_ptr (new pcl::PointCloud<pcl::Boundary>());
+  SS.getBoundaryCloud(boundary_ptr);
+  int k=0;
+
+  pcl::IndicesPtr boundary_idx(new std::vector<int>());
+  for(const auto& pt : boundary_ptr->points)
+  {
+    if(pt.boundary_point)
+      boundary_idx->push_back(k);
+    k++;
+  }
+
+  // sort the boundaries
+  SS.sortBoundary(boundary_idx, sorted_boundaries);
+}
+
+bool godel_surface_detection::generateEdgePaths(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& surface,
+                                                std::vector<geometry_msgs::PoseArray>& result)
+{
+  std::vector<pcl::IndicesPtr> sorted_boundaries;
+
+  // Compute the boundary
+  SurfaceSegmentation SS(surface);
+
+  SS.setSearchRadius(SEGMENTATION_SEARCH_RADIUS);
+  computeBoundaries(SS, sorted_boundaries);
+
+  ROS_INFO_STREAM("Boundaries Computed = "<<sorted_boundaries.size());
+
+  std::size_t generated = 0;
+  for(int i = 0; i < sorted_boundaries.size(); i++)
+  {
+    if(sorted_boundaries.at(i)->size() < BOUNDARY_THRESHOLD)
+      continue;
+
+    geometry_msgs::PoseArray edge_poses;
+    geometry_msgs::Pose geo_pose;
+    std::vector<Eigen::Matrix4d, Eigen::aligned_allocator<Eigen::Matrix4d>> poses;
+
+    // Get boundary trajectory and trim last two poses (last poses are susceptible to large velocity changes)
+    SS.getBoundaryTrajectory(sorted_boundaries, i, poses);
+    poses.resize(poses.size() - 2);
+
+    // Convert eigen poses to geometry poses for messaging and visualization
+    for(const auto& p : poses)
+    {
+      Eigen::Affine3d pose(p.matrix());
+      tf::poseEigenToMsg(pose, geo_pose);
+      edge_poses.poses.push_back(geo_pose);
+    }
+
+    result.push_back(edge_poses);
+    generated++;
+  }
+
+  ROS_INFO_COND((generated > 0),"Finished generating edge paths for %i boundaries",int(generated));
+  return generated > 0;
+}
@@ -0,0 +1,300 @@
+#include <segmentation/normal_estimation.h>
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+// Cells are radius / CELLS_PER_RADIUS wide, so the neighbourhood of a cell is CELLS_PER_RADIUS
+// cells in every direction
+const static int CELLS_PER_RADIUS = 3;
+// Below this, relative to the largest squared cross product of unit rows, the rows of
+// (matrix - eigenvalue * I) span less than a plane
+const static double DEGENERATE_CROSS = 1e-12;
+
+typedef Eigen::Map<Eigen::ArrayXf> ArrayMap;
+
+/**
+ * @brief Coordinates of the candidate neighbours of one cell, and their offsets from the point
+ * being estimated, kept as separate arrays so that every reduction runs over contiguous floats
+ */
+struct NeighbourScratch
+{
+  std::vector<float> x, y, z;
+  std::vector<float> dx, dy, dz, w;
+
+  void clear()
+  {
+    x.clear();
+    y.clear();
+    z.clear();
+  }
+
+  void append(const std::vector<float>& xs, const std::vector<float>& ys, const std::vector<float>& zs,
+              std::size_t begin, std::size_t end)
+  {
+    x.insert(x.end(), xs.begin() + begin, xs.begin() + end);
+    y.insert(y.end(), ys.begin() + begin, ys.begin() + end);
+    z.insert(z.end(), zs.begin() + begin, zs.begin() + end);
+  }
+
+  void resizeOffsets()
+  {
+    dx.resize(x.size());
+    dy.resize(x.size());
+    dz.resize(x.size());
+    w.resize(x.size());
+  }
+};
+
+uint64_t cellKey(int64_t x, int64_t y, int64_t z)
+{
+  return (static_cast<uint64_t>(x & 0x1FFFFF) << 42) | (static_cast<uint64_t>(y & 0x1FFFFF) << 21) |
+         static_cast<uint64_t>(z & 0x1FFFFF);
+}
+
+// The largest of the cross products of pairs of rows, which is orthogonal to all three rows
+bool crossOfRows(const Eigen::Matrix3d& m, Eigen::Vector3d& result)
+{
+  const Eigen::Vector3d c01 = m.row(0).cross(m.row(1));
+  const Eigen::Vector3d c02 = m.row(0).cross(m.row(2));
+  const Eigen::Vector3d c12 = m.row(1).cross(m.row(2));
+  const double n01 = c01.squaredNorm(), n02 = c02.squaredNorm(), n12 = c12.squaredNorm();
+  if (n01 >= n02 && n01 >= n12)
+    result = c01;
+  else if (n02 >= n12)
+    result = c02;
+  else
+    result = c12;
+  const double n = std::max(n01, std::max(n02, n12));
+  if (n <= DEGENERATE_CROSS)
+    return false;
+  result /= std::sqrt(n);
+  return true;
+}
+
+} // end anon namespace
+
+void godel_surface_detection::smallestEigenvector(const Eigen::Matrix3d& matrix, Eigen::Vector3d& eigenvalues,
+                                                  Eigen::Vector3d& eigenvector)
+{
+  // Scaled to a largest coefficient of 1, so that neither the cubic nor the thresholds depend on
+  // the units
+  const double scale = matrix.cwiseAbs().maxCoeff();
+  if (!(scale > 0.0) || !std::isfinite(scale))
+  {
+    eigenvalues.setConstant(scale > 0.0 ? scale : 0.0);
+    eigenvector = Eigen::Vector3d::UnitZ();
+    return;
+  }
+  const Eigen::Matrix3d a = matrix / scale;
+
+  const double off = a(0, 1) * a(0, 1) + a(0, 2) * a(0, 2) + a(1, 2) * a(1, 2);
+  const double q = a.trace() / 3.0;
+  const double p2 = (a(0, 0) - q) * (a(0, 0) - q) + (a(1, 1) - q) * (a(1, 1) - q) + (a(2, 2) - q) * (a(2, 2) - q) +
+                    2.0 * off;
+  Eigen::Vector3d values;
+  if (p2 <= std::numeric_limits<double>::epsilon())
+  {
+    // A multiple of the identity: every direction is an eigenvector
+    values.setConstant(q);
+  }
+  else
+  {
+    // a = q I + p b, where the eigenvalues of b are 2 cos(phi + 2 k pi / 3)
+    const double p = std::sqrt(p2 / 6.0);
+    const Eigen::Matrix3d b = (a - q * Eigen::Matrix3d::Identity()) / p;
+    const double r = std::min(1.0, std::max(-1.0, b.determinant() / 2.0));
+    const double phi = std::acos(r) / 3.0;
+    values(2) = q + 2.0 * p * std::cos(phi);
+    values(0) = q + 2.0 * p * std::cos(phi + 2.0 * M_PI / 3.0);
+    values(1) = 3.0 * q - values(0) - values(2);
+  }
+  eigenvalues = values * scale;
+
+  if (crossOfRows(a - values(0) * Eigen::Matrix3d::Identity(), eigenvector))
+    return;
+
+  // The smallest eigenvalue is repeated, so the remaining rows are all along the largest
+  // eigenvector; any direction orthogonal to it will do
+  const Eigen::Matrix3d m = a - values(0) * Eigen::Matrix3d::Identity();
+  int row;
+  m.rowwise().squaredNorm().maxCoeff(&row);
+  if (m.row(row).squaredNorm() <= DEGENERATE_CROSS)
+    eigenvector = Eigen::Vector3d::UnitZ();
+  else
+    eigenvector = m.row(row).transpose().normalized().unitOrthogonal();
+}
+
+namespace
+{
+
+// Normals of the selected points (all if 'selected' is null), which are NaN on entry
+void estimateSelected(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, const std::vector<uint8_t>* selected,
+                      double radius, int num_threads, pcl::PointCloud<pcl::Normal>& normals)
+{
+  if (cloud.empty() || !(radius > 0.0))
+    return;
+
+  // Bin the finite points, in cell order so that the points of a cell are contiguous
+  const double cell = radius / CELLS_PER_RADIUS;
+  std::unordered_map<uint64_t, int> cell_ids;
+  std::vector<Eigen::Vector3i> cell_coords;
+  std::vector<int> point_cells(cloud.size(), -1);
+  for (std::size_t i = 0; i < cloud.size(); ++i)
+  {
+    const pcl::PointXYZRGB& p = cloud.points[i];
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+      continue;
+    const Eigen::Vector3i c(static_cast<int>(std::floor(p.x / cell)), static_cast<int>(std::floor(p.y / cell)),
+                            static_cast<int>(std::floor(p.z / cell)));
+    const auto inserted = cell_ids.insert(std::make_pair(cellKey(c.x(), c.y(), c.z()), cell_coords.size()));
+    if (inserted.second)
+      cell_coords.push_back(c);
+    point_cells[i] = inserted.first->second;
+  }
+
+  std::vector<std::size_t> cell_starts(cell_coords.size() + 1, 0);
+  for (int c : point_cells)
+    if (c >= 0)
+      cell_starts[c + 1]++;
+  for (std::size_t c = 0; c < cell_coords.size(); ++c)
+    cell_starts[c + 1] += cell_starts[c];
+
+  std::vector<std::size_t> fill(cell_starts.begin(), cell_starts.end() - 1);
+  std::vector<int> order(cell_starts.back());
+  std::vector<uint8_t> wanted(cell_coords.size(), selected ? 0 : 1);
+  std::vector<float> xs(order.size()), ys(order.size()), zs(order.size());
+  for (std::size_t i = 0; i < cloud.size(); ++i)
+  {
+    if (point_cells[i] < 0)
+      continue;
+    const std::size_t slot = fill[point_cells[i]]++;
+    if (selected && (*selected)[i])
+      wanted[point_cells[i]] = 1;
+    order[slot] = i;
+    xs[slot] = cloud.points[i].x;
+    ys[slot] = cloud.points[i].y;
+    zs[slot] = cloud.points[i].z;
+  }
+
+  const float radius_sq = static_cast<float>(radius * radius);
+  const Eigen::Vector3f viewpoint = cloud.sensor_origin_.head<3>();
+  const int threads = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+  const int num_cells = static_cast<int>(cell_coords.size());
+
+#pragma omp parallel num_threads(threads)
+  {
+    NeighbourScratch scratch;
+
+#pragma omp for schedule(dynamic, 8)
+    for (int c = 0; c < num_cells; ++c)
+    {
+      if (!wanted[c])
+        continue;
+      scratch.clear();
+      const Eigen::Vector3i& coords = cell_coords[c];
+      for (int dx = -CELLS_PER_RADIUS; dx <= CELLS_PER_RADIUS; ++dx)
+        for (int dy = -CELLS_PER_RADIUS; dy <= CELLS_PER_RADIUS; ++dy)
+          for (int dz = -CELLS_PER_RADIUS; dz <= CELLS_PER_RADIUS; ++dz)
+          {
+            const auto it = cell_ids.find(cellKey(coords.x() + dx, coords.y() + dy, coords.z() + dz));
+            if (it != cell_ids.end())
+              scratch.append(xs, ys, zs, cell_starts[it->second], cell_starts[it->second + 1]);
+          }
+      scratch.resizeOffsets();
+
+      const int m = static_cast<int>(scratch.x.size());
+      const ArrayMap x(scratch.x.data(), m), y(scratch.y.data(), m), z(scratch.z.data(), m);
+      ArrayMap ox(scratch.dx.data(), m), oy(scratch.dy.data(), m), oz(scratch.dz.data(), m), w(scratch.w.data(), m);
+
+      for (std::size_t slot = cell_starts[c]; slot < cell_starts[c + 1]; ++slot)
+      {
+        if (selected && !(*selected)[order[slot]])
+          continue;
+
+        // Moments of the neighbours about the point itself, which keeps them small enough for floats
+        ox = x - xs[slot];
+        oy = y - ys[slot];
+        oz = z - zs[slot];
+        w = ((ox.square() + oy.square() + oz.square()) <= radius_sq).cast<float>();
+        const double n = w.sum();
+        if (n < 3.0)
+          continue;
+
+        const Eigen::Vector3d mean = Eigen::Vector3d((w * ox).sum(), (w * oy).sum(), (w * oz).sum()) / n;
+        Eigen::Matrix3d covariance;
+        covariance(0, 0) = (w * ox.square()).sum();
+        covariance(1, 1) = (w * oy.square()).sum();
+        covariance(2, 2) = (w * oz.square()).sum();
+        covariance(0, 1) = covariance(1, 0) = (w * ox * oy).sum();
+        covariance(0, 2) = covariance(2, 0) = (w * ox * oz).sum();
+        covariance(1, 2) = covariance(2, 1) = (w * oy * oz).sum();
+        covariance = covariance / n - mean * mean.transpose();
+
+        Eigen::Vector3d values, normal;
+        godel_surface_detection::smallestEigenvector(covariance, values, normal);
+
+        const int index = order[slot];
+        const Eigen::Vector3f point(xs[slot], ys[slot], zs[slot]);
+        if ((viewpoint - point).cast<double>().dot(normal) < 0.0)
+          normal = -normal;
+
+        pcl::Normal& result = normals.points[index];
+        result.normal_x = normal.x();
+        result.normal_y = normal.y();
+        result.normal_z = normal.z();
+        const double trace = covariance.trace();
+        result.curvature = trace != 0.0 ? std::abs(values(0) / trace) : 0.0;
+      }
+    }
+  }
+}
+
+pcl::Normal invalidNormal()
+{
+  pcl::Normal invalid;
+  invalid.normal_x = invalid.normal_y = invalid.normal_z = invalid.curvature =
+      std::numeric_limits<float>::quiet_NaN();
+  return invalid;
+}
+
+bool allFinite(const pcl::PointCloud<pcl::Normal>& normals)
+{
+  return std::all_of(normals.points.begin(), normals.points.end(),
+                     [](const pcl::Normal& n) { return std::isfinite(n.curvature); });
+}
+
+} // end anon namespace
+
+void godel_surface_detection::estimateNormals(const pcl::PointCloud<pcl::PointXYZRGB>& cloud, double radius,
+                                              int num_threads, pcl::PointCloud<pcl::Normal>& normals)
+{
+  normals.header = cloud.header;
+  normals.points.assign(cloud.size(), invalidNormal());
+  normals.width = cloud.width;
+  normals.height = cloud.height;
+  estimateSelected(cloud, NULL, radius, num_threads, normals);
+  normals.is_dense = allFinite(normals);
+}
+
+void godel_surface_detection::estimateNormals(const pcl::PointCloud<pcl::PointXYZRGB>& cloud,
+                                              const std::vector<uint8_t>& selected, double radius, int num_threads,
+                                              pcl::PointCloud<pcl::Normal>& normals)
+{
+  for (std::size_t i = 0; i < cloud.size(); ++i)
+  {
+    if (selected[i])
+      normals.points[i] = invalidNormal();
+  }
+  estimateSelected(cloud, &selected, radius, num_threads, normals);
+  normals.is_dense = allFinite(normals);
+}
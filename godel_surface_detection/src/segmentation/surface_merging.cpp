@@ -0,0 +1,252 @@
+#include <segmentation/surface_merging.h>
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace
+{
+
+typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+
+/**
+ * @brief Sums over the points of a surface, from which the plane of any union of surfaces follows
+ * without revisiting their points
+ */
+struct Moments
+{
+  Moments() : n(0.0), sum(Eigen::Vector3d::Zero()), sum_sq(Eigen::Matrix3d::Zero()) {}
+
+  explicit Moments(const CloudRGB& cloud) : Moments()
+  {
+    for (const auto& p : cloud.points)
+    {
+      const Eigen::Vector3d v(p.x, p.y, p.z);
+      n += 1.0;
+      sum += v;
+      sum_sq += v * v.transpose();
+    }
+  }
+
+  Moments operator+(const Moments& other) const
+  {
+    Moments m;
+    m.n = n + other.n;
+    m.sum = sum + other.sum;
+    m.sum_sq = sum_sq + other.sum_sq;
+    return m;
+  }
+
+  godel_surface_detection::PlaneFit plane() const
+  {
+    godel_surface_detection::PlaneFit fit;
+    if (n <= 0.0)
+      return fit;
+    fit.centroid = sum / n;
+    const Eigen::Matrix3d covariance = sum_sq / n - fit.centroid * fit.centroid.transpose();
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+    fit.normal = solver.eigenvectors().col(0);
+    fit.rms = std::sqrt(std::max(0.0, solver.eigenvalues()(0)));
+    return fit;
+  }
+
+  double n;
+  Eigen::Vector3d sum;
+  Eigen::Matrix3d sum_sq;
+};
+
+typedef std::pair<std::size_t, std::size_t> SurfacePair;
+
+SurfacePair ordered(std::size_t a, std::size_t b) { return a < b ? SurfacePair(a, b) : SurfacePair(b, a); }
+
+// Whether two planes are the same plane, and how far their normals are apart
+bool planesAgree(const godel_surface_detection::PlaneFit& a, const godel_surface_detection::PlaneFit& b,
+                 const godel_surface_detection::SurfaceMergeParameters& params, double& angle)
+{
+  // Fitted normals have no consistent sign
+  angle = std::acos(std::min(1.0, std::abs(a.normal.dot(b.normal))));
+  const double offset = std::max(std::abs(a.normal.dot(b.centroid - a.centroid)),
+                                 std::abs(b.normal.dot(a.centroid - b.centroid)));
+  return angle <= params.max_angle && offset <= params.max_offset;
+}
+
+} // end anon namespace
+
+godel_surface_detection::PlaneFit godel_surface_detection::fitPlane(const pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+{
+  return Moments(cloud).plane();
+}
+
+std::vector<std::pair<std::size_t, std::size_t>>
+godel_surface_detection::surfaceAdjacency(const std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>& surfaces,
+                                          const SurfaceMergeParameters& params)
+{
+  // Points are binned into cubes as large as the adjacency distance; a point borders the surfaces
+  // that have points in its own or one of the 26 surrounding cubes
+  const double cell = params.adjacency_distance;
+  auto cellOf = [cell](const pcl::PointXYZRGB& p) {
+    return Eigen::Vector3i(static_cast<int>(std::floor(p.x / cell)), static_cast<int>(std::floor(p.y / cell)),
+                           static_cast<int>(std::floor(p.z / cell)));
+  };
+  auto key = [](const Eigen::Vector3i& c) {
+    return (static_cast<uint64_t>(c.x() & 0x1FFFFF) << 42) | (static_cast<uint64_t>(c.y() & 0x1FFFFF) << 21) |
+           static_cast<uint64_t>(c.z() & 0x1FFFFF);
+  };
+
+  std::unordered_map<uint64_t, std::vector<std::size_t>> grid;
+  for (std::size_t s = 0; s < surfaces.size(); ++s)
+  {
+    for (const auto& p : surfaces[s]->points)
+    {
+      std::vector<std::size_t>& labels = grid[key(cellOf(p))];
+      if (labels.empty() || labels.back() != s)
+        labels.push_back(s);
+    }
+  }
+
+  // Border points of surface s next to surface t, counted from both sides
+  std::map<std::pair<std::size_t, std::size_t>, int> border;
+  std::vector<std::size_t> near;
+  for (std::size_t s = 0; s < surfaces.size(); ++s)
+  {
+    for (const auto& p : surfaces[s]->points)
+    {
+      const Eigen::Vector3i c = cellOf(p);
+      near.clear();
+      for (int dx = -1; dx <= 1; ++dx)
+        for (int dy = -1; dy <= 1; ++dy)
+          for (int dz = -1; dz <= 1; ++dz)
+          {
+            const auto it = grid.find(key(c + Eigen::Vector3i(dx, dy, dz)));
+            if (it == grid.end())
+              continue;
+            for (std::size_t t : it->second)
+              if (t != s)
+                near.push_back(t);
+          }
+      std::sort(near.begin(), near.end());
+      near.erase(std::unique(near.begin(), near.end()), near.end());
+      for (std::size_t t : near)
+        border[std::make_pair(s, t)]++;
+    }
+  }
+
+  std::vector<SurfacePair> pairs;
+  for (const auto& b : border)
+  {
+    const std::size_t s = b.first.first, t = b.first.second;
+    if (s >= t)
+      continue;
+    const auto other_side = border.find(std::make_pair(t, s));
+    if (b.second >= params.min_border_points && other_side != border.end() &&
+        other_side->second >= params.min_border_points)
+      pairs.push_back(b.first);
+  }
+  return pairs;
+}
+
+godel_surface_detection::SurfaceMergeStats
+godel_surface_detection::mergeCoplanarSurfaces(std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>& surfaces,
+                                               const SurfaceMergeParameters& params)
+{
+  SurfaceMergeStats stats;
+  stats.segments = surfaces.size();
+
+  // Every group of merged segments is named by its first segment
+  std::vector<Moments> moments;
+  std::vector<PlaneFit> planes;
+  std::vector<std::vector<std::size_t>> members(surfaces.size());
+  for (std::size_t i = 0; i < surfaces.size(); ++i)
+  {
+    moments.push_back(Moments(*surfaces[i]));
+    planes.push_back(moments.back().plane());
+    members[i].push_back(i);
+  }
+
+  std::set<SurfacePair> adjacent;
+  for (const auto& pair : surfaceAdjacency(surfaces, params))
+    adjacent.insert(pair);
+
+  std::set<SurfacePair> rejected;
+  while (true)
+  {
+    // The adjacent pair with the closest planes that hasn't been tried yet
+    SurfacePair best;
+    double best_angle = std::numeric_limits<double>::infinity();
+    for (const auto& pair : adjacent)
+    {
+      double angle;
+      if (!rejected.count(pair) && planesAgree(planes[pair.first], planes[pair.second], params, angle) &&
+          angle < best_angle)
+      {
+        best = pair;
+        best_angle = angle;
+      }
+    }
+    if (std::isinf(best_angle))
+      break;
+
+    // Agreeing planes can still make a curved surface, so the union must fit a plane too
+    const std::size_t a = best.first, b = best.second;
+    const Moments merged = moments[a] + moments[b];
+    const PlaneFit plane = merged.plane();
+    if (plane.rms > params.max_rms)
+    {
+      rejected.insert(best);
+      stats.rejected++;
+      continue;
+    }
+
+    moments[a] = merged;
+    planes[a] = plane;
+    members[a].insert(members[a].end(), members[b].begin(), members[b].end());
+    members[b].clear();
+
+    // b's borders become a's; a's own pairs are tried again with its new plane
+    std::set<SurfacePair> updated;
+    for (const auto& pair : adjacent)
+    {
+      const std::size_t first = pair.first == b ? a : pair.first;
+      const std::size_t second = pair.second == b ? a : pair.second;
+      if (first != second)
+        updated.insert(ordered(first, second));
+    }
+    adjacent.swap(updated);
+    for (auto it = rejected.begin(); it != rejected.end();)
+      it = it->first == a || it->second == a || it->first == b || it->second == b ? rejected.erase(it) : ++it;
+  }
+
+  std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> result;
+  for (std::size_t i = 0; i < surfaces.size(); ++i)
+  {
+    if (members[i].empty())
+      continue;
+    if (members[i].size() == 1)
+    {
+      result.push_back(surfaces[i]);
+      continue;
+    }
+
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr joined(new pcl::PointCloud<pcl::PointXYZRGB>());
+    joined->header = surfaces[i]->header;
+    joined->is_dense = true;
+    for (std::size_t m : members[i])
+    {
+      joined->points.insert(joined->points.end(), surfaces[m]->points.begin(), surfaces[m]->points.end());
+      joined->is_dense = joined->is_dense && surfaces[m]->is_dense;
+    }
+    joined->width = joined->points.size();
+    joined->height = 1;
+    result.push_back(joined);
+  }
+
+  surfaces.swap(result);
+  stats.surfaces = surfaces.size();
+  return stats;
+}
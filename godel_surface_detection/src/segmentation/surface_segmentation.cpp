@@ -1,4 +1,6 @@
 #include <segmentation/surface_segmentation.h>
+#include <segmentation/normal_estimation.h>
+#include <boost/make_shared.hpp>
 #include <pcl/common/distances.h>
 #include <pcl/features/normal_3d_omp.h>
 #include <pcl/kdtree/kdtree_flann.h>
@@ -9,12 +11,18 @@
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/filters/project_inliers.h>
 #include <ros/io.h>
+#include <cmath>
+#include <queue>
+#include <random>
 #include <thread>
 
 static const double DOWNSAMPLING_LEAF = 0.005f;
 static const double EDGE_SEARCH_RADIUS = 0.01;
 static const double PLANE_INLIER_DISTANCE = 0.005;
 static const double PLANE_INLIER_THRESHOLD = 0.8;
+// Coarse to fine segmentation
+static const double COARSE_CLUSTER_SLACK = 0.5; // share of the cluster size limits region growing uses on the grid
+static const double COARSE_SEED_DISTANCE = 1.5; // (voxels) of the seeds from the refined voxels
 
 
 // Custom boundary estimation
@@ -35,13 +43,17 @@ SurfaceSegmentation::~SurfaceSegmentation()
 }
 
 
-SurfaceSegmentation::SurfaceSegmentation(pcl::PointCloud<pcl::PointXYZRGB>::Ptr icloud)
+SurfaceSegmentation::SurfaceSegmentation(pcl::PointCloud<pcl::PointXYZRGB>::Ptr icloud,
+                                         const SegmentationParameters& params)
+  : params_(params)
 {
   input_cloud_ =  pcl::PointCloud<pcl::PointXYZRGB>::Ptr(new pcl::PointCloud<pcl::PointXYZRGB>);
   normals_ =  pcl::PointCloud<pcl::Normal>::Ptr(new pcl::PointCloud<pcl::Normal>);
   setInputCloud(icloud);
   removeNans();
-  computeNormals();
+  // Coarse to fine segmentation computes the normals it needs itself
+  if (params_.coarse_leaf <= 0.0)
+    computeNormals();
 
 }
 
@@ -95,27 +107,37 @@ void SurfaceSegmentation::getBoundaryCloud(pcl::PointCloud<pcl::Boundary>::Ptr &
 }
 
 
-std::vector <pcl::PointIndices> SurfaceSegmentation::computeSegments(pcl::PointCloud<pcl::PointXYZRGB>::Ptr
-                                                                     &colored_cloud)
+// Region growing as segmentation uses it, except for its input and cluster sizes
+static void configureRegionGrowing(pcl::RegionGrowing<pcl::PointXYZRGB, pcl::Normal>& rg,
+                                   const SegmentationParameters& params)
 {
-  // Region growing
   pcl::search::Search<pcl::PointXYZRGB>::Ptr tree =
       boost::shared_ptr<pcl::search::Search<pcl::PointXYZRGB>> (new pcl::search::KdTree<pcl::PointXYZRGB>);
-  pcl::RegionGrowing<pcl::PointXYZRGB, pcl::Normal> rg;
 
   rg.setSmoothModeFlag (true); // Depends on the cloud being processed
-  rg.setSmoothnessThreshold (0.035);
-  rg.setCurvatureThreshold(1.0);
-
-  rg.setMaxClusterSize(MAX_CLUSTER_SIZE);
+  rg.setSmoothnessThreshold (params.smoothness_threshold);
+  rg.setCurvatureThreshold(params.curvature_threshold);
   rg.setSearchMethod (tree);
-  rg.setMinClusterSize(MIN_CLUSTER_SIZE);
-  rg.setNumberOfNeighbours (NUM_NEIGHBORS);
+  rg.setNumberOfNeighbours (params.num_neighbors);
 
   float resid_thresh = rg.getResidualThreshold();
 
   rg.setResidualTestFlag(true);
   rg.setResidualThreshold(resid_thresh);
+}
+
+
+std::vector <pcl::PointIndices> SurfaceSegmentation::computeSegments(pcl::PointCloud<pcl::PointXYZRGB>::Ptr
+                                                                     &colored_cloud)
+{
+  if (params_.coarse_leaf > 0.0)
+    return computeCoarseToFineSegments(colored_cloud);
+
+  // Region growing
+  pcl::RegionGrowing<pcl::PointXYZRGB, pcl::Normal> rg;
+  configureRegionGrowing(rg, params_);
+  rg.setMaxClusterSize(params_.max_cluster_size);
+  rg.setMinClusterSize(params_.min_cluster_size);
   rg.setInputCloud (input_cloud_);
   rg.setInputNormals (normals_);
 
@@ -128,6 +150,189 @@ std::vector <pcl::PointIndices> SurfaceSegmentation::computeSegments(pcl::PointC
 }
 
 
+std::vector<pcl::PointIndices>
+SurfaceSegmentation::computeCoarseToFineSegments(pcl::PointCloud<pcl::PointXYZRGB>::Ptr& colored_cloud)
+{
+  typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+  const double leaf = params_.coarse_leaf;
+  const std::size_t n = input_cloud_->size();
+  clusters_.clear();
+  if (n == 0)
+    return clusters_;
+
+  // Segment the coarse grid; the leaf layout maps every point to its voxel
+  CloudRGB::Ptr coarse(new CloudRGB());
+  pcl::VoxelGrid<pcl::PointXYZRGB> vg;
+  vg.setInputCloud(input_cloud_);
+  vg.setLeafSize(leaf, leaf, leaf);
+  vg.setSaveLeafLayout(true);
+  vg.filter(*coarse);
+  coarse->sensor_origin_ = input_cloud_->sensor_origin_;
+
+  pcl::PointCloud<pcl::Normal>::Ptr coarse_normals(new pcl::PointCloud<pcl::Normal>());
+  godel_surface_detection::estimateNormals(*coarse, params_.normal_radius, params_.num_threads, *coarse_normals);
+
+  // Cluster sizes count points, which the grid thins out; the limits are loosened here and applied
+  // to the refined clusters
+  const double ratio = static_cast<double>(coarse->size()) / n;
+  pcl::RegionGrowing<pcl::PointXYZRGB, pcl::Normal> rg;
+  configureRegionGrowing(rg, params_);
+  rg.setMinClusterSize(std::max(1, static_cast<int>(COARSE_CLUSTER_SLACK * params_.min_cluster_size * ratio)));
+  rg.setMaxClusterSize(static_cast<int>(std::ceil(params_.max_cluster_size * ratio / COARSE_CLUSTER_SLACK)));
+  rg.setInputCloud(coarse);
+  rg.setInputNormals(coarse_normals);
+  std::vector<pcl::PointIndices> coarse_clusters;
+  rg.extract(coarse_clusters);
+
+  std::vector<int> coarse_labels(coarse->size(), -1);
+  for (std::size_t k = 0; k < coarse_clusters.size(); ++k)
+    for (int idx : coarse_clusters[k].indices)
+      coarse_labels[idx] = k;
+
+  // Voxels near a differently labelled one are refined; the voxels next to those seed the labels
+  enum { COARSE = 0, REFINED, SEED };
+  std::vector<uint8_t> voxel_state(coarse->size(), COARSE);
+  pcl::search::KdTree<pcl::PointXYZRGB> coarse_tree;
+  coarse_tree.setInputCloud(coarse);
+  std::vector<int> nn_indices;
+  std::vector<float> nn_dists;
+  const double band = (params_.border_band + 0.5) * leaf;
+  for (std::size_t i = 0; i < coarse->size(); ++i)
+  {
+    coarse_tree.radiusSearch(coarse->points[i], band, nn_indices, nn_dists);
+    for (int j : nn_indices)
+    {
+      if (coarse_labels[j] != coarse_labels[i])
+      {
+        voxel_state[i] = REFINED;
+        break;
+      }
+    }
+  }
+  for (std::size_t i = 0; i < coarse->size(); ++i)
+  {
+    if (voxel_state[i] != REFINED)
+      continue;
+    coarse_tree.radiusSearch(coarse->points[i], COARSE_SEED_DISTANCE * leaf, nn_indices, nn_dists);
+    for (int j : nn_indices)
+      if (voxel_state[j] == COARSE)
+        voxel_state[j] = SEED;
+  }
+
+  // Points take the label and normal of their voxel, except that the refined ones are unlabelled
+  // and, like the seeds, get normals of their own
+  std::vector<int> labels(n, -1), voxels(n);
+  std::vector<uint8_t> fine(n, 0);
+  normals_->header = input_cloud_->header;
+  normals_->points.resize(n);
+  normals_->width = input_cloud_->width;
+  normals_->height = input_cloud_->height;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const int v = vg.getCentroidIndex(input_cloud_->points[i]);
+    voxels[i] = v;
+    normals_->points[i] = coarse_normals->points[v];
+    fine[i] = voxel_state[v] != COARSE;
+    if (voxel_state[v] != REFINED)
+      labels[i] = coarse_labels[v];
+  }
+  godel_surface_detection::estimateNormals(*input_cloud_, fine, params_.normal_radius, params_.num_threads,
+                                           *normals_);
+
+  // Grow the seeds' labels into the refined points with the tests of region growing: a neighbour
+  // joins if its normal is close to the point's, and grows the region further if it is flat and
+  // close to the point's plane
+  std::vector<int> band_indices;
+  for (std::size_t i = 0; i < n; ++i)
+    if (fine[i])
+      band_indices.push_back(i);
+  if (!band_indices.empty())
+  {
+    pcl::search::KdTree<pcl::PointXYZRGB> tree;
+    tree.setInputCloud(input_cloud_, boost::make_shared<std::vector<int>>(band_indices));
+    const float cos_smoothness = std::cos(params_.smoothness_threshold);
+    const float residual_threshold = rg.getResidualThreshold();
+
+    auto grow = [&](std::queue<int>& front) {
+      while (!front.empty())
+      {
+        const int p = front.front();
+        front.pop();
+        const Eigen::Vector3f normal = normals_->points[p].getNormalVector3fMap();
+        const Eigen::Vector3f point = input_cloud_->points[p].getVector3fMap();
+        tree.nearestKSearch(input_cloud_->points[p], params_.num_neighbors, nn_indices, nn_dists);
+        for (int q : nn_indices)
+        {
+          if (labels[q] >= 0 || voxel_state[voxels[q]] != REFINED)
+            continue;
+          const Eigen::Vector3f other = normals_->points[q].getNormalVector3fMap();
+          if (!(std::abs(normal.dot(other)) >= cos_smoothness))
+            continue;
+          labels[q] = labels[p];
+          const float residual = std::abs(normal.dot(point - input_cloud_->points[q].getVector3fMap()));
+          if (normals_->points[q].curvature < params_.curvature_threshold && residual <= residual_threshold)
+            front.push(q);
+        }
+      }
+    };
+
+    std::queue<int> front;
+    for (int i : band_indices)
+      if (labels[i] >= 0 && std::isfinite(normals_->points[i].curvature))
+        front.push(i);
+    grow(front);
+
+    // Surfaces narrower than the band have no seeds; they keep their coarse labels
+    for (int i : band_indices)
+    {
+      const int coarse_label = coarse_labels[voxels[i]];
+      if (labels[i] >= 0 || coarse_label < 0 || !std::isfinite(normals_->points[i].curvature))
+        continue;
+      labels[i] = coarse_label;
+      front.push(i);
+      grow(front);
+    }
+  }
+
+  std::vector<pcl::PointIndices> clusters(coarse_clusters.size());
+  for (std::size_t i = 0; i < n; ++i)
+    if (labels[i] >= 0)
+      clusters[labels[i]].indices.push_back(i);
+  for (auto& cluster : clusters)
+  {
+    const int size = cluster.indices.size();
+    if (size >= params_.min_cluster_size && size <= params_.max_cluster_size)
+      clusters_.push_back(cluster);
+  }
+
+  // Colored as pcl::RegionGrowing::getColoredCloud() does: unsegmented points are red
+  if (!clusters_.empty())
+  {
+    colored_cloud.reset(new CloudRGB());
+    pcl::copyPointCloud(*input_cloud_, *colored_cloud);
+    for (auto& p : colored_cloud->points)
+    {
+      p.r = 255;
+      p.g = p.b = 0;
+    }
+    std::default_random_engine random_engine(0);
+    std::uniform_int_distribution<int> channel(0, 255);
+    for (const auto& cluster : clusters_)
+    {
+      const uint8_t r = channel(random_engine), g = channel(random_engine), b = channel(random_engine);
+      for (int idx : cluster.indices)
+      {
+        colored_cloud->points[idx].r = r;
+        colored_cloud->points[idx].g = g;
+        colored_cloud->points[idx].b = b;
+      }
+    }
+  }
+
+  return clusters_;
+}
+
+
 std::pair<int, int> SurfaceSegmentation::getNextUnused(std::vector< std::pair<int,int> > used)
 {
   std::pair<int,int> rtn;
@@ -631,16 +836,22 @@ void SurfaceSegmentation::removeNans()
 
 void SurfaceSegmentation::computeNormals()
 {
+  if (params_.closed_form_normals)
+  {
+    godel_surface_detection::estimateNormals(*input_cloud_, params_.normal_radius, params_.num_threads, *normals_);
+    return;
+  }
+
   // Determine the number of available cores
   pcl::NormalEstimationOMP<pcl::PointXYZRGB, pcl::Normal> ne;
-  int nr_cores = std::thread::hardware_concurrency();
+  int nr_cores = params_.num_threads > 0 ? params_.num_threads : std::thread::hardware_concurrency();
   ne.setNumberOfThreads(nr_cores);
 
   // Configure parameters
   ne.setInputCloud (input_cloud_);
   pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree (new pcl::search::KdTree<pcl::PointXYZRGB> ());
   ne.setSearchMethod (tree);
-  ne.setRadiusSearch(0.025);
+  ne.setRadiusSearch(params_.normal_radius);
 //  ne.setKSearch (100);
 
   // Estimate the normals
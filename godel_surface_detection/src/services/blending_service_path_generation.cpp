@@ -6,10 +6,11 @@
 #include <pluginlib/class_loader.h>
 #include <ros/node_handle.h>
 #include <services/surface_blending_service.h>
-#include <segmentation/surface_segmentation.h>
+#include <segmentation/edge_paths.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <path_planning_plugins_base/path_planning_base.h>
 
+#include <godel_utils/tracing.h>
 #include <swri_profiler/profiler.h>
 
 // Temporary constants for storing blending path `planning parameters
@@ -32,10 +33,6 @@ const static std::string BLEND_TYPE = "blend";
 const static std::string EDGE_TYPE = "edge";
 const static std::string SCAN_TYPE = "scan";
 
-// Edge Processing constants
-const static double SEGMENTATION_SEARCH_RADIUS = 0.03; // 3cm
-const static int BOUNDARY_THRESHOLD = 10;
-
 // Variables to select path type
 const static int PATH_TYPE_BLENDING = 0;
 const static int PATH_TYPE_SCAN = 1;
@@ -60,46 +57,6 @@ const static std::string MIN_QA_VALUE_PARAM = PARAM_BASE + SCAN_PARAM_BASE + "mi
 const static std::string MAX_QA_VALUE_PARAM = PARAM_BASE + SCAN_PARAM_BASE + "max_qa_value";
 
 
-void computeBoundaries(const godel_surface_detection::detection::CloudRGB::Ptr surface_cloud,
-                       SurfaceSegmentation& SS,
-                       std::vector< pcl::IndicesPtr>& sorted_boundaries)
-{
-  pcl::PointCloud<pcl::Boundary>::Ptr boundary_ptr (new pcl::PointCloud<pcl::Boundary>());
-  pcl::PointCloud<pcl::PointXYZRGB>::Ptr boundary_cloud_ptr(new pcl::PointCloud<pcl::PointXYZRGB>());
-  SS.getBoundaryCloud(boundary_ptr);
-  int k=0;
-
-  pcl::IndicesPtr boundary_idx(new std::vector<int>());
-  for(const auto& pt : boundary_ptr->points)
-  {
-    if(pt.boundary_point)
-    {
-      boundary_cloud_ptr->points.push_back(surface_cloud->points[k]);
-      boundary_idx->push_back(k);
-    }
-    k++;
-  }
-
-  boundary_cloud_ptr->width = 1;
-  boundary_cloud_ptr->height = boundary_cloud_ptr->points.size();
-
-
-  // sort the boundaries
-  SS.sortBoundary(boundary_idx, sorted_boundaries);
-
-  int max=0;
-  int max_idx=0;
-
-  for(int i=0;i<sorted_boundaries.size();i++)
-  {
-    if(sorted_boundaries[i]->size() > max)
-    {
-      max = sorted_boundaries[i]->size();
-      max_idx = i;
-    }
-  }
-}
-
 inline static bool isBlendingPath(const std::string& name)
 {
   const static std::string suffix("_blend");
@@ -130,44 +87,8 @@ bool SurfaceBlendingService::generateEdgePath(godel_surface_detection::detection
                                               std::vector<geometry_msgs::PoseArray>& result)
 {
   SWRI_PROFILE("gen-edge-path");
-  // Send request to edge path generation service
-  std::vector<pcl::IndicesPtr> sorted_boundaries;
-
-  // Compute the boundary
-  SurfaceSegmentation SS(surface);
-
-  SS.setSearchRadius(SEGMENTATION_SEARCH_RADIUS);
-  computeBoundaries(surface, SS, sorted_boundaries);
-
-  ROS_INFO_STREAM("Boundaries Computed = "<<sorted_boundaries.size());
-
-  for(int i = 0; i < sorted_boundaries.size(); i++)
-  {
-    if(sorted_boundaries.at(i)->size() < BOUNDARY_THRESHOLD)
-      continue;
-
-    geometry_msgs::PoseArray edge_poses;
-    geometry_msgs::Pose geo_pose;
-    std::vector<Eigen::Matrix4d, Eigen::aligned_allocator<Eigen::Matrix4d>> poses;
-
-    // Get boundary trajectory and trim last two poses (last poses are susceptible to large velocity changes)
-    SS.getBoundaryTrajectory(sorted_boundaries, i, poses);
-    poses.resize(poses.size() - 2);
-
-    // Convert eigen poses to geometry poses for messaging and visualization
-    for(const auto& p : poses)
-    {
-      Eigen::Affine3d pose(p.matrix());
-      tf::poseEigenToMsg(pose, geo_pose);
-      edge_poses.poses.push_back(geo_pose);
-    }
-
-    result.push_back(edge_poses);
-  }
-
-  ROS_INFO_COND((result.size() > 0),"Finished generating edge paths for %i boundaries",int(result.size()));
-  return result.size() > 0;
-
+  GODEL_TRACE_SPAN("gen_edge_path");
+  return godel_surface_detection::generateEdgePaths(surface, result);
 }
 
 
@@ -203,6 +124,7 @@ bool SurfaceBlendingService::generateBlendPath(const godel_msgs::PathPlanningPar
                                                const pcl::PolygonMesh &mesh, std::vector<geometry_msgs::PoseArray> &result)
 {
   SWRI_PROFILE("gen-blend-path");
+  GODEL_TRACE_SPAN("gen_blend_path");
   try
   {
     if (!generateToolPaths(params, mesh, getBlendToolPlanningPluginName(), result))
@@ -223,6 +145,7 @@ bool SurfaceBlendingService::generateScanPath(const godel_msgs::PathPlanningPara
                                               std::vector<geometry_msgs::PoseArray> &result)
 {
   SWRI_PROFILE("gen-scan-path");
+  GODEL_TRACE_SPAN("gen_scan_path");
   try
   {
     if (!generateToolPaths(params, mesh, getScanToolPlanningPluginName(), result))
@@ -247,19 +170,18 @@ SurfaceBlendingService::generateProcessPath(const int& id,
                                             ProcessPathResult& result)
 {
   SWRI_PROFILE("tool-planning");
+  GODEL_TRACE_SPAN("tool_planning");
   std::vector<geometry_msgs::PoseArray> blend_result, edge_result, scan_result;
 
   // Step 1: Generate Blending Paths
   godel_msgs::PathPlanningParameters params;
   if (!generateBlendPath(params, mesh, blend_result))
   {
-    process_planning_feedback_.last_completed = "Failed to generate blend path for surface " + name;
-    process_planning_server_.publishFeedback(process_planning_feedback_);
+    publishPlanningStatus("Failed to generate blend path for surface " + name);
   }
   else
   {
-    process_planning_feedback_.last_completed = "Generated blend path for surface " + name;
-    process_planning_server_.publishFeedback(process_planning_feedback_);
+    publishPlanningStatus("Generated blend path for surface " + name);
 
     // Add the successful blend path to the output
     ProcessPathResult::value_type vt;
@@ -272,13 +194,11 @@ SurfaceBlendingService::generateProcessPath(const int& id,
   // Step 2: Generate Laser Scan Paths
   if (!generateScanPath(params, mesh, scan_result))
   {
-    process_planning_feedback_.last_completed = "Failed to generate scan path for surface " + name;
-    process_planning_server_.publishFeedback(process_planning_feedback_);
+    publishPlanningStatus("Failed to generate scan path for surface " + name);
   }
   else
   {
-    process_planning_feedback_.last_completed = "Generated scan path for surface " + name;
-    process_planning_server_.publishFeedback(process_planning_feedback_);
+    publishPlanningStatus("Generated scan path for surface " + name);
 
     // Add the successful scan path to the output
     ProcessPathResult::value_type vt;
@@ -291,13 +211,11 @@ SurfaceBlendingService::generateProcessPath(const int& id,
   // Step 3: Generate Edge Paths for the given surface
   if (!generateEdgePath(surface, edge_result))
   {
-    process_planning_feedback_.last_completed = "Failed to generate generate edge path(s) for surface " + name;
-    process_planning_server_.publishFeedback(process_planning_feedback_);
+    publishPlanningStatus("Failed to generate generate edge path(s) for surface " + name);
   }
   else
   {
-    process_planning_feedback_.last_completed = "Generated edge path(s) for surface " + name;
-    process_planning_server_.publishFeedback(process_planning_feedback_);
+    publishPlanningStatus("Generated edge path(s) for surface " + name);
 
     // Add the edge paths to the results
     ProcessPathResult::value_type vt;
@@ -316,90 +234,196 @@ SurfaceBlendingService::generateProcessPath(const int& id,
   return result.paths.size() > 0;
 }
 
-godel_surface_detection::TrajectoryLibrary SurfaceBlendingService::generateMotionLibrary(
-    const godel_msgs::PathPlanningParameters& params)
+static void loadProcessParameters(const godel_msgs::PathPlanningParameters& params,
+                                  godel_msgs::BlendingPlanParameters& blend_params,
+                                  godel_msgs::ScanPlanParameters& scan_params)
+{
+  ros::NodeHandle nh;
+
+  blend_params.margin = params.margin;
+  blend_params.overlap = params.overlap;
+  blend_params.tool_radius = params.tool_radius;
+  blend_params.discretization = params.discretization;
+  blend_params.safe_traverse_height = params.traverse_height;
+  nh.getParam(SPINDLE_SPEED_PARAM, blend_params.spindle_speed);
+  nh.getParam(APPROACH_SPD_PARAM, blend_params.approach_spd);
+  nh.getParam(BLENDING_SPD_PARAM, blend_params.blending_spd);
+  nh.getParam(RETRACT_SPD_PARAM, blend_params.retract_spd);
+  nh.getParam(TRAVERSE_SPD_PARAM, blend_params.traverse_spd);
+  nh.getParam(Z_ADJUST_PARAM, blend_params.z_adjust);
+
+  scan_params.scan_width = params.scan_width;
+  scan_params.margin = params.margin;
+  scan_params.overlap = params.overlap;
+  scan_params.scan_width = params.scan_width;
+  nh.getParam(APPROACH_DISTANCE_PARAM, scan_params.approach_distance);
+  nh.getParam(TRAVERSE_SPD_PARAM, scan_params.traverse_spd);
+  nh.getParam(QUALITY_METRIC_PARAM, scan_params.quality_metric);
+  nh.getParam(WINDOW_WIDTH_PARAM, scan_params.window_width);
+  nh.getParam(MIN_QA_VALUE_PARAM, scan_params.min_qa_value);
+  nh.getParam(MAX_QA_VALUE_PARAM, scan_params.min_qa_value);
+//  nh.getParam(Z_ADJUST_PARAM, scan_params.z_adjust);
+  scan_params.z_adjust = 0.0; // Until we fix these parameters and do not share them among the
+                              // different processes, I'm only applying this to blend paths.
+}
+
+bool SurfaceBlendingService::planSurface(const int id, const godel_msgs::PathPlanningParameters& params,
+                                         godel_surface_detection::SurfacePlanningResult& result)
 {
-  SWRI_PROFILE("generate-motion-library");
-  std::vector<int> selected_ids;
-  surface_server_.getSelectedIds(selected_ids);
+  SWRI_PROFILE("plan-surface");
+  GODEL_TRACE_SPAN("plan_surface");
+  data_coordinator_.getSurfaceName(id, result.surface_name);
 
-  godel_surface_detection::TrajectoryLibrary lib;
-  // Clear previous results
-  process_path_results_.blend_poses_.clear();
-  process_path_results_.edge_poses_.clear();
-  process_path_results_.scan_poses_.clear();
+  // Generate motion plan
+  ProcessPathResult paths;
+  generateProcessPath(id, paths);
 
-  for (const auto& id : selected_ids)
+  // If planning failed entirely, skip to next
+  if(paths.paths.size() == 0)
+    return false;
+
+  // Identical parts later in the batch reuse these paths
+  if (batch_enabled_)
+    batch_paths_[id] = paths;
+
+  return planProcessPaths(paths, params, result);
+}
+
+bool SurfaceBlendingService::planProcessPaths(const ProcessPathResult& paths,
+                                              const godel_msgs::PathPlanningParameters& params,
+                                              godel_surface_detection::SurfacePlanningResult& result)
+{
+  // Add new path to result
+  for(const auto& vt: paths.paths)
   {
-    // Generate motion plan
-    ProcessPathResult paths;
-    generateProcessPath(id, paths);
+    if(isBlendingPath(vt.first))
+      process_path_results_.blend_poses_.push_back(vt.second);
 
-    // If planning failed entirely, skip to next
-    if(paths.paths.size() == 0)
-      continue;
+    else if(isEdgePath(vt.first))
+      process_path_results_.edge_poses_.push_back(vt.second.front());
+
+    else if(isScanPath(vt.first))
+      process_path_results_.scan_poses_.push_back(vt.second);
+
+    else
+      ROS_ERROR_STREAM("Tried to process an unrecognized path type: " << vt.first);
+  }
+
+  godel_msgs::BlendingPlanParameters blend_params;
+  godel_msgs::ScanPlanParameters scan_params;
+  loadProcessParameters(params, blend_params, scan_params);
 
-    // Add new path to result
-    for(const auto& vt: paths.paths)
+  // Generate trajectory plans from motion plan
+  {
+    SWRI_PROFILE("motion-planning");
+    GODEL_TRACE_SPAN("motion_planning");
+    for (std::size_t j = 0; j < paths.paths.size(); ++j)
     {
-      if(isBlendingPath(vt.first))
-        process_path_results_.blend_poses_.push_back(vt.second);
+      ProcessPlanResult plan = generateProcessPlan(paths.paths[j].first, paths.paths[j].second, blend_params,
+                                                   scan_params);
+
+      for (std::size_t k = 0; k < plan.plans.size(); ++k)
+        result.plans[plan.plans[k].first] = plan.plans[k].second;
+
+      if (!plan.plans.empty())
+        result.paths.insert(result.paths.end(), paths.paths[j].second.begin(), paths.paths[j].second.end());
+    }
+  }
+
+  return !result.plans.empty();
+}
 
-      else if(isEdgePath(vt.first))
-        process_path_results_.edge_poses_.push_back(vt.second.front());
+void SurfaceBlendingService::addBatchSurfaces(const std::vector<int>& ids,
+                                              const godel_msgs::PathPlanningParameters& params,
+                                              godel_surface_detection::ProgressivePlanner& planner)
+{
+  using namespace godel_surface_detection;
+  SWRI_PROFILE("plan-batch");
+  GODEL_TRACE_SPAN("plan_batch");
 
-      else if(isScanPath(vt.first))
-        process_path_results_.scan_poses_.push_back(vt.second);
+  std::vector<batch::Cloud::ConstPtr> surfaces;
+  for (const auto& id : ids)
+  {
+    batch::Cloud::Ptr surface(new batch::Cloud);
+    data_coordinator_.getCloud(data::CloudTypes::surface_cloud, id, *surface);
+    surfaces.push_back(surface);
+  }
 
-      else
-        ROS_ERROR_STREAM("Tried to process an unrecognized path type: " << vt.first);
+  // The robot starts from and returns to the world origin between jobs
+  batch_ = batch::planBatch(surfaces, batch_params_, Eigen::Vector3d::Zero());
+  batch_paths_.clear();
+
+  std::size_t reused = 0;
+  for (std::size_t k = 0; k < batch_.parts.size(); ++k)
+  {
+    const std::vector<std::size_t>& part = batch_.parts[k];
+    if (batch_.reference[k] < 0)
+    {
+      for (std::size_t s : part)
+        planner.addSurface(boost::bind(&SurfaceBlendingService::planSurface, this, ids[s], params, _1));
+      continue;
     }
 
-    ros::NodeHandle nh;
-
-    godel_msgs::BlendingPlanParameters blend_params;
-    blend_params.margin = params.margin;
-    blend_params.overlap = params.overlap;
-    blend_params.tool_radius = params.tool_radius;
-    blend_params.discretization = params.discretization;
-    blend_params.safe_traverse_height = params.traverse_height;
-    nh.getParam(SPINDLE_SPEED_PARAM, blend_params.spindle_speed);
-    nh.getParam(APPROACH_SPD_PARAM, blend_params.approach_spd);
-    nh.getParam(BLENDING_SPD_PARAM, blend_params.blending_spd);
-    nh.getParam(RETRACT_SPD_PARAM, blend_params.retract_spd);
-    nh.getParam(TRAVERSE_SPD_PARAM, blend_params.traverse_spd);
-    nh.getParam(Z_ADJUST_PARAM, blend_params.z_adjust);
-
-    godel_msgs::ScanPlanParameters scan_params;
-    scan_params.scan_width = params.scan_width;
-    scan_params.margin = params.margin;
-    scan_params.overlap = params.overlap;
-    scan_params.scan_width = params.scan_width;
-    nh.getParam(APPROACH_DISTANCE_PARAM, scan_params.approach_distance);
-    nh.getParam(TRAVERSE_SPD_PARAM, scan_params.traverse_spd);
-    nh.getParam(QUALITY_METRIC_PARAM, scan_params.quality_metric);
-    nh.getParam(WINDOW_WIDTH_PARAM, scan_params.window_width);
-    nh.getParam(MIN_QA_VALUE_PARAM, scan_params.min_qa_value);
-    nh.getParam(MAX_QA_VALUE_PARAM, scan_params.min_qa_value);
-//    nh.getParam(Z_ADJUST_PARAM, scan_params.z_adjust);
-    scan_params.z_adjust = 0.0; // Until we fix these parameters and do not share them among the
-                                // different processes, I'm only applying this to blend paths.
-
-    // Generate trajectory plans from motion plan
+    // Surface i of the reference part lands on surface surface_map[i] of this one
+    const std::vector<std::size_t>& reference = batch_.parts[batch_.reference[k]];
+    const std::vector<int>& surface_map = batch_.registrations[k].surface_map;
+    for (std::size_t i = 0; i < reference.size(); ++i)
     {
-      SWRI_PROFILE("motion-planning");
-      for (std::size_t j = 0; j < paths.paths.size(); ++j)
-      {
-        ProcessPlanResult plan = generateProcessPlan(paths.paths[j].first, paths.paths[j].second, blend_params,
-                                                     scan_params);
-
-        for (std::size_t k = 0; k < plan.plans.size(); ++k)
-          lib.get()[plan.plans[k].first] = plan.plans[k].second;
-      }
+      planner.addSurface(boost::bind(&SurfaceBlendingService::planTransferredSurface, this,
+                                     ids[part[surface_map[i]]], ids[reference[i]], k, params, _1));
     }
+    ++reused;
+  }
+
+  ROS_INFO_STREAM("Batch of " << batch_.parts.size() << " parts; " << reused
+                  << " of them reuse the paths of an identical part");
+  publishPlanningStatus("Planning " + std::to_string(batch_.parts.size()) + " parts, " +
+                        std::to_string(reused) + " from the paths of an identical part");
+}
+
+bool SurfaceBlendingService::planTransferredSurface(const int id, const int reference_id, const std::size_t part,
+                                                    const godel_msgs::PathPlanningParameters& params,
+                                                    godel_surface_detection::SurfacePlanningResult& result)
+{
+  using namespace godel_surface_detection;
+  SWRI_PROFILE("plan-transferred-surface");
+  GODEL_TRACE_SPAN("plan_transferred_surface");
+
+  // The reference surface may have failed to plan
+  const auto reference_paths = batch_paths_.find(reference_id);
+  if (reference_paths == batch_paths_.end())
+    return planSurface(id, params, result);
+
+  std::string name, reference_name;
+  data_coordinator_.getSurfaceName(id, name);
+  data_coordinator_.getSurfaceName(reference_id, reference_name);
+  result.surface_name = name;
+
+  // Paths keep their type suffix ("_blend", "_edge_0", ...) under the surface's own name
+  ProcessPathResult paths;
+  for (const auto& vt : reference_paths->second.paths)
+  {
+    ProcessPathResult::value_type moved(name + vt.first.substr(reference_name.size()), vt.second);
+    batch::transformPaths(batch_.registrations[part].transform, moved.second);
+
+    if (isBlendingPath(moved.first))
+      data_coordinator_.setPoses(data::PoseTypes::blend_pose, id, moved.second);
+    else if (isEdgePath(moved.first))
+      data_coordinator_.addEdge(id, moved.first, moved.second.front());
+    else if (isScanPath(moved.first))
+      data_coordinator_.setPoses(data::PoseTypes::scan_pose, id, moved.second);
+    paths.paths.push_back(moved);
   }
+  publishPlanningStatus("Moved the paths of surface " + reference_name + " onto surface " + name);
+
+  // The process planners check that the moved paths are still reachable and collision free
+  if (planProcessPaths(paths, params, result))
+    return true;
 
-  return lib;
+  ROS_WARN_STREAM("The paths of surface " << reference_name << " could not be planned on surface " << name
+                  << "; planning it from scratch");
+  result = SurfacePlanningResult();
+  return planSurface(id, params, result);
 }
 
 
@@ -420,6 +444,7 @@ SurfaceBlendingService::generateProcessPlan(const std::string& name,
     godel_msgs::BlendProcessPlanning srv;
     srv.request.path.segments = poses;
     srv.request.params = params;
+    srv.request.trace = godel_utils::tracing::inject();
 
     success = blend_planning_client_.call(srv);
     process_plan = srv.response.plan;
@@ -429,6 +454,7 @@ SurfaceBlendingService::generateProcessPlan(const std::string& name,
     godel_msgs::BlendProcessPlanning srv;
     srv.request.path.segments = poses;
     srv.request.params = params;
+    srv.request.trace = godel_utils::tracing::inject();
 
     success = blend_planning_client_.call(srv);
     process_plan = srv.response.plan;
@@ -438,6 +464,7 @@ SurfaceBlendingService::generateProcessPlan(const std::string& name,
     godel_msgs::KeyenceProcessPlanning srv;
     srv.request.path.segments = poses;
     srv.request.params = scan_params;
+    srv.request.trace = godel_utils::tracing::inject();
 
     success = keyence_planning_client_.call(srv);
     process_plan = srv.response.plan;
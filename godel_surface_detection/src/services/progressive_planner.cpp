@@ -0,0 +1,42 @@
+#include "services/progressive_planner.h"
+
+#include <ros/console.h>
+
+godel_surface_detection::ProgressivePlanner::Outcome
+godel_surface_detection::ProgressivePlanner::run(const SurfaceCallback& on_surface, const StopCondition& should_stop)
+{
+  const std::size_t total = jobs_.size();
+  for (std::size_t i = 0; i < total; ++i)
+  {
+    if (should_stop && should_stop())
+    {
+      ROS_INFO_STREAM("Planning stopped with " << (total - i) << " of " << total << " surfaces pending");
+      return PREEMPTED;
+    }
+
+    SurfacePlanningResult result;
+    if (!jobs_[i](result))
+    {
+      ROS_WARN_STREAM("Planning failed for surface '" << result.surface_name << "'");
+      continue;
+    }
+
+    if (on_surface)
+      on_surface(result, i + 1, total);
+  }
+  return COMPLETED;
+}
+
+void godel_surface_detection::toFeedback(const SurfacePlanningResult& result, std::size_t completed,
+                                         std::size_t total, godel_msgs::ProcessPlanningFeedback& feedback)
+{
+  feedback.last_completed = "Finished planning surface " + result.surface_name + " (" +
+                            std::to_string(completed) + "/" + std::to_string(total) + ")";
+  feedback.surface_name = result.surface_name;
+  feedback.plan_names.clear();
+  for (const auto& plan : result.plans)
+    feedback.plan_names.push_back(plan.first);
+  feedback.paths = result.paths;
+  feedback.surfaces_completed = completed;
+  feedback.surfaces_total = total;
+}
@@ -0,0 +1,54 @@
+/*
+ * surface_blending_service as a nodelet. Its parameters are read from the private namespace,
+ * which is the manager's inside a nodelet, so it is loaded into a manager that is itself named
+ * surface_blending_service (see launch/godel_core.launch with nodelets:=true). Path generation and
+ * process planning loaded into the same manager are then called without serializing the poses,
+ * boundaries and trajectories of each surface.
+ */
+
+#include <services/surface_blending_service.h>
+#include <godel_utils/tracing.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <memory>
+#include <thread>
+
+namespace godel_surface_detection
+{
+
+class SurfaceBlendingNodelet : public nodelet::Nodelet
+{
+public:
+  ~SurfaceBlendingNodelet()
+  {
+    if (init_thread_.joinable())
+      init_thread_.join();
+  }
+
+private:
+  virtual void onInit()
+  {
+    if (!godel_utils::tracing::enabled())
+      godel_utils::tracing::initialize(ros::this_node::getName());
+
+    // Callbacks run on the manager's worker threads, like the node's spinner threads
+    service_.reset(new SurfaceBlendingService(getMTNodeHandle()));
+
+    // init() waits for move_group and the other servers; onInit must not block the manager
+    init_thread_ = std::thread([this]() {
+      if (service_->init())
+      {
+        NODELET_INFO("Godel Surface Blending Service successfully initialized and now running");
+        service_->run();
+      }
+    });
+  }
+
+  std::unique_ptr<SurfaceBlendingService> service_;
+  std::thread init_thread_;
+};
+
+} // namespace godel_surface_detection
+
+PLUGINLIB_EXPORT_CLASS(godel_surface_detection::SurfaceBlendingNodelet, nodelet::Nodelet)
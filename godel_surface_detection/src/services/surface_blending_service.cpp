@@ -1,6 +1,7 @@
 #include <services/surface_blending_service.h>
 #include <segmentation/surface_segmentation.h>
 #include <detection/surface_detection.h>
+#include <detection/region_of_interest.h>
 #include <godel_msgs/TrajectoryExecution.h>
 
 // Process Planning
@@ -10,6 +11,12 @@
 
 #include <godel_param_helpers/godel_param_helpers.h>
 #include <godel_utils/ensenso_guard.h>
+#include <godel_utils/tracing.h>
+#include <swri_profiler/profiler.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <future>
+#include <set>
 
 // topics and services
 const static std::string SAVE_DATA_BOOL_PARAM = "save_data";
@@ -40,6 +47,15 @@ const static std::string SELECTED_SURFACES_CHANGED_TOPIC = "selected_surfaces_ch
 const static std::string ROBOT_SCAN_PATH_PREVIEW_TOPIC = "robot_scan_path_preview";
 const static std::string PUBLISH_REGION_POINT_CLOUD = "publish_region_point_cloud";
 const static std::string REGION_POINT_CLOUD_TOPIC = "region_colored_cloud";
+const static std::string REGION_CLOUD_POINT_BUDGET_PARAM = "visualization/region_cloud_point_budget";
+const static std::string REGION_CLOUD_LEAF_SIZE_PARAM = "visualization/region_cloud_leaf_size";
+const static std::string MAX_VISUALIZED_POSES_PARAM = "visualization/max_visualized_poses";
+const static int DEFAULT_REGION_CLOUD_POINT_BUDGET = 250000;
+const static double DEFAULT_REGION_CLOUD_LEAF_SIZE = 0.002; // m
+const static int DEFAULT_MAX_VISUALIZED_POSES = 5000; // per pose array
+const static std::string MEMORY_PARAM_NS = "memory";
+const static std::string BATCH_PARAM_NS = "batch/";
+const static double MEMORY_DIAGNOSTICS_PERIOD = 5.0; // s
 
 const static std::string EDGE_IDENTIFIER = "_edge_";
 
@@ -68,13 +84,18 @@ const static std::string PROCESS_PLANNING_ACTION_SERVER_NAME = "process_planning
 const static std::string SELECT_MOTION_PLAN_ACTION_SERVER_NAME = "select_motion_plan_as";
 const static int PROCESS_EXE_BUFFER = 5;  // Additional time [s] buffer between when blending should end and timeout
 
-SurfaceBlendingService::SurfaceBlendingService() : publish_region_point_cloud_(false), save_data_(false),
+SurfaceBlendingService::SurfaceBlendingService(const ros::NodeHandle& nh) : publish_region_point_cloud_(false),
+  region_cloud_point_budget_(DEFAULT_REGION_CLOUD_POINT_BUDGET),
+  region_cloud_leaf_size_(DEFAULT_REGION_CLOUD_LEAF_SIZE),
+  max_visualized_poses_(DEFAULT_MAX_VISUALIZED_POSES), save_data_(false), batch_enabled_(false),
   blend_exe_client_(BLEND_EXE_ACTION_SERVER_NAME, true),
   scan_exe_client_(SCAN_EXE_ACTION_SERVER_NAME, true),
+  nh_(nh),
   process_planning_server_(nh_, PROCESS_PLANNING_ACTION_SERVER_NAME,
                            boost::bind(&SurfaceBlendingService::processPlanningActionCallback, this, _1), false),
   select_motion_plan_server_(nh_, SELECT_MOTION_PLAN_ACTION_SERVER_NAME,
-                             boost::bind(&SurfaceBlendingService::selectMotionPlansActionCallback, this, _1), false)
+                             boost::bind(&SurfaceBlendingService::selectMotionPlansActionCallback, this, _1), false),
+  memory_monitor_(ros::this_node::getName())
 {}
 
 bool SurfaceBlendingService::init()
@@ -85,12 +106,30 @@ bool SurfaceBlendingService::init()
 
   // loading parameters
   ph.getParam(PUBLISH_REGION_POINT_CLOUD, publish_region_point_cloud_);
+  ph.getParam(REGION_CLOUD_POINT_BUDGET_PARAM, region_cloud_point_budget_);
+  ph.getParam(REGION_CLOUD_LEAF_SIZE_PARAM, region_cloud_leaf_size_);
+  ph.getParam(MAX_VISUALIZED_POSES_PARAM, max_visualized_poses_);
   ph.getParam(SAVE_DATA_BOOL_PARAM, save_data_);
   ph.getParam(SAVE_LOCATION_PARAM, save_location_);
 
   // Load the 'prefix' that will be combined with parameters msg base names to save to disk
   ph.param<std::string>("param_cache_prefix", param_cache_prefix_, "");
 
+  // batch processing of several parts on one fixture; off by default
+  {
+    batch::BatchParameters& b = batch_params_;
+    int max_boundary_points = b.max_boundary_points;
+    ph.getParam(BATCH_PARAM_NS + "enabled", batch_enabled_);
+    ph.getParam(BATCH_PARAM_NS + "connect_distance", b.connect_distance);
+    ph.getParam(BATCH_PARAM_NS + "boundary_resolution", b.boundary_resolution);
+    ph.getParam(BATCH_PARAM_NS + "max_boundary_points", max_boundary_points);
+    ph.getParam(BATCH_PARAM_NS + "max_iterations", b.max_iterations);
+    ph.getParam(BATCH_PARAM_NS + "max_rms", b.max_rms);
+    ph.getParam(BATCH_PARAM_NS + "max_centroid_distance", b.max_centroid_distance);
+    ph.getParam(BATCH_PARAM_NS + "size_tolerance", b.size_tolerance);
+    b.max_boundary_points = std::max(max_boundary_points, 1);
+  }
+
   if (!this->load_path_planning_parameters(param_cache_prefix_ + PATH_PLANNING_PARAMS_FILE))
     ROS_WARN("Unable to load blending process parameters.");
 
@@ -134,8 +173,13 @@ bool SurfaceBlendingService::init()
   default_blending_plan_params_ = blending_plan_params_;
   default_scan_params_ = scan_plan_params_;
 
-  if (surface_detection_.init() && robot_scan_.init() &&
-      surface_server_.init() && data_coordinator_.init())
+  // Connecting to move_group and loading the robot model take longest, so they run alongside
+  // the rest of the initialization
+  std::future<bool> robot_scan_ready =
+      std::async(std::launch::async, [this]() { return robot_scan_.init(); });
+  const bool initialized =
+      surface_detection_.init() && surface_server_.init() && data_coordinator_.init();
+  if (robot_scan_ready.get() && initialized)
   {
     // adding callbacks
     scan::RobotScan::ScanCallback cb =
@@ -148,17 +192,31 @@ bool SurfaceBlendingService::init()
     ROS_ERROR_STREAM("Surface detection service had an initialization error");
   }
 
+  // memory budgets of the stores that grow with every scan and plan
+  {
+    using namespace godel_utils::memory;
+    ros::NodeHandle mh("~/" + MEMORY_PARAM_NS);
+    const std::string spill_directory = loadSpillDirectory(mh);
+    data_coordinator_.setSpillDirectory(spill_directory);
+    trajectory_library_.setSpillDirectory(spill_directory);
+    surface_server_.setSpillDirectory(spill_directory);
+
+    AccountedStore* stores[] = {&surface_detection_, &surface_server_, &data_coordinator_,
+                                &trajectory_library_};
+    for (AccountedStore* store : stores)
+    {
+      store->setBudget(loadBudget(mh, store->storeName()));
+      memory_monitor_.add(*store);
+    }
+    memory_monitor_.startPublishing(nh_, MEMORY_DIAGNOSTICS_PERIOD, false);
+  }
+
   // start server
   interactive::InteractiveSurfaceServer::SelectionCallback f =
       boost::bind(&SurfaceBlendingService::publish_selected_surfaces_changed, this);
   surface_server_.add_selection_callback(f);
 
-  // service clients
-  process_path_client_ = nh_.serviceClient<godel_msgs::PathPlanning>(PATH_GENERATION_SERVICE);
-
-  // Process Execution Parameters
-  blend_planning_client_ = nh_.serviceClient<godel_msgs::BlendProcessPlanning>(BLEND_PROCESS_PLANNING_SERVICE);
-  keyence_planning_client_ = nh_.serviceClient<godel_msgs::KeyenceProcessPlanning>(SCAN_PROCESS_PLANNING_SERVICE);
+  initPlanning();
 
   // service servers
   surf_blend_parameters_server_ =
@@ -168,12 +226,6 @@ bool SurfaceBlendingService::init()
   surface_detect_server_ = nh_.advertiseService(
       SURFACE_DETECTION_SERVICE, &SurfaceBlendingService::surface_detection_server_callback, this);
 
-  select_surface_server_ = nh_.advertiseService(
-      SELECT_SURFACE_SERVICE, &SurfaceBlendingService::select_surface_server_callback, this);
-
-  get_motion_plans_server_ = nh_.advertiseService(
-      GET_MOTION_PLANS_SERVICE, &SurfaceBlendingService::getMotionPlansCallback, this);
-
   load_save_motion_plan_server_ = nh_.advertiseService(
       LOAD_SAVE_MOTION_PLAN_SERVICE, &SurfaceBlendingService::loadSaveMotionPlanCallback, this);
 
@@ -182,33 +234,43 @@ bool SurfaceBlendingService::init()
 
   // publishers
   selected_surf_changed_pub_ = nh_.advertise<godel_msgs::SelectedSurfacesChanged>(SELECTED_SURFACES_CHANGED_TOPIC, 1);
-  point_cloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(REGION_POINT_CLOUD_TOPIC, 1);
-  tool_path_markers_pub_ = nh_.advertise<visualization_msgs::MarkerArray>(TOOL_PATH_PREVIEW_TOPIC, 1, true);
-  blend_visualization_pub_ = nh_.advertise<geometry_msgs::PoseArray>(BLEND_VISUALIZATION_TOPIC, 1, true);
-  edge_visualization_pub_ = nh_.advertise<geometry_msgs::PoseArray>(EDGE_VISUALIZATION_TOPIC, 1, true);
-  scan_visualization_pub_ = nh_.advertise<geometry_msgs::PoseArray>(SCAN_VISUALIZATION_TOPIC, 1, true);
+  // visualization publishers are latched and only send when their content changes
+  point_cloud_pub_.advertise(nh_, REGION_POINT_CLOUD_TOPIC);
+  tool_path_markers_pub_.advertise(nh_, TOOL_PATH_PREVIEW_TOPIC);
+  blend_visualization_pub_.advertise(nh_, BLEND_VISUALIZATION_TOPIC);
+  edge_visualization_pub_.advertise(nh_, EDGE_VISUALIZATION_TOPIC);
+  scan_visualization_pub_.advertise(nh_, SCAN_VISUALIZATION_TOPIC);
 
   // action servers
-  process_planning_server_.start();
   select_motion_plan_server_.start();
 
   return true;
 }
 
-void SurfaceBlendingService::run()
+void SurfaceBlendingService::initPlanning()
 {
-  surface_server_.run();
+  // service clients
+  process_path_client_ =
+      godel_utils::intra_process::ServiceClient<godel_msgs::PathPlanning>(nh_, PATH_GENERATION_SERVICE);
 
-  ros::Duration loop_duration(1.0f);
-  while (ros::ok())
-  {
-    if (publish_region_point_cloud_ && !region_cloud_msg_.data.empty())
-    {
-      point_cloud_pub_.publish(region_cloud_msg_);
-    }
+  // Process Execution Parameters
+  blend_planning_client_ = godel_utils::intra_process::ServiceClient<godel_msgs::BlendProcessPlanning>(
+      nh_, BLEND_PROCESS_PLANNING_SERVICE);
+  keyence_planning_client_ = godel_utils::intra_process::ServiceClient<godel_msgs::KeyenceProcessPlanning>(
+      nh_, SCAN_PROCESS_PLANNING_SERVICE);
 
-    loop_duration.sleep();
-  }
+  select_surface_server_ = nh_.advertiseService(
+      SELECT_SURFACE_SERVICE, &SurfaceBlendingService::select_surface_server_callback, this);
+
+  get_motion_plans_server_ = nh_.advertiseService(
+      GET_MOTION_PLANS_SERVICE, &SurfaceBlendingService::getMotionPlansCallback, this);
+
+  process_planning_server_.start();
+}
+
+void SurfaceBlendingService::run()
+{
+  surface_server_.run();
 }
 
 // Blending Parameters
@@ -236,12 +298,9 @@ bool SurfaceBlendingService::load_blend_parameters(const std::string& filename)
 }
 
 
-void SurfaceBlendingService::save_blend_parameters(const std::string& filename)
+std::future<bool> SurfaceBlendingService::save_blend_parameters(const std::string& filename)
 {
-  if (!godel_param_helpers::toFile(filename, blending_plan_params_))
-  {
-    ROS_WARN_STREAM("Unable to save blending-plan parameters to: " << filename);
-  }
+  return param_writer_.save(filename, blending_plan_params_);
 }
 
 
@@ -255,12 +314,9 @@ bool SurfaceBlendingService::load_path_planning_parameters(const std::string & f
 }
 
 
-void SurfaceBlendingService::save_path_planning_parameters(const std::string & filename)
+std::future<bool> SurfaceBlendingService::save_path_planning_parameters(const std::string & filename)
 {
-  if(!godel_param_helpers::toFile(filename, path_planning_params_))
-  {
-    ROS_WARN_STREAM("Unable to save path-planning parameters to: " << filename);
-  }
+  return param_writer_.save(filename, path_planning_params_);
 }
 
 
@@ -287,12 +343,9 @@ bool SurfaceBlendingService::load_scan_parameters(const std::string& filename)
          loadParam(nh, "window_width", scan_plan_params_.window_width);
 }
 
-void SurfaceBlendingService::save_scan_parameters(const std::string& filename)
+std::future<bool> SurfaceBlendingService::save_scan_parameters(const std::string& filename)
 {
-  if (!godel_param_helpers::toFile(filename, scan_plan_params_))
-  {
-    ROS_WARN_STREAM("Unable to save scan-plan parameters to: " << filename);
-  }
+  return param_writer_.save(filename, scan_plan_params_);
 }
 
 void SurfaceBlendingService::publish_selected_surfaces_changed()
@@ -314,7 +367,11 @@ bool SurfaceBlendingService::run_robot_scan(visualization_msgs::MarkerArray& sur
   surface_detection_.clear_results();
 
   // saving parameters used
-  int scans_completed = robot_scan_.scan(false);
+  int scans_completed;
+  {
+    GODEL_TRACE_SPAN("robot_scan");
+    scans_completed = robot_scan_.scan(false);
+  }
   if (scans_completed > 0)
   {
     ensenso::EnsensoGuard guard;
@@ -333,8 +390,30 @@ bool SurfaceBlendingService::find_surfaces(visualization_msgs::MarkerArray& surf
   bool succeeded = true;
   if (surface_detection_.find_surfaces())
   {
+    // Detection within regions of interest replaces the surfaces found in them before; the
+    // records outside them are kept and their surfaces shown again
+    if (!surface_detection_.regions_of_interest_.empty())
+    {
+      const std::vector<int> removed = godel_surface_detection::detection::removeRecordsInRegions(
+          data_coordinator_,
+          godel_surface_detection::detection::RegionOfInterestFilter(surface_detection_.regions_of_interest_));
+      ROS_INFO_STREAM("Replacing " << removed.size() << " surfaces in the regions of interest");
+    }
+
     // clear current surfaces
     surface_server_.remove_all_surfaces();
+    std::set<std::string> kept_names;
+    for (int id : data_coordinator_.getRecordIds())
+    {
+      pcl::PolygonMesh surface_mesh;
+      std::string name;
+      if (data_coordinator_.getSurfaceMesh(id, surface_mesh) && data_coordinator_.getSurfaceName(id, name))
+      {
+        surface_server_.add_surface(id, surface_mesh);
+        surface_server_.rename_surface(id, name);
+        kept_names.insert(name);
+      }
+    }
 
     // adding meshes to server
     std::vector<pcl::PolygonMesh> meshes;
@@ -352,12 +431,15 @@ bool SurfaceBlendingService::find_surfaces(visualization_msgs::MarkerArray& surf
     ROS_ASSERT(meshes.size() == surface_clouds.size());
     for (std::size_t i = 0; i < meshes.size(); i++)
     {
-      pcl::PolygonMesh surface_mesh = meshes[i];
-      int id = data_coordinator_.addRecord(input_cloud, *(surface_clouds[i]));
-      ROS_INFO_STREAM("Created record with id: " << id);
-      std::string name = surface_server_.add_surface(id, surface_mesh);
-      data_coordinator_.setSurfaceMesh(id, surface_mesh);
-      data_coordinator_.setSurfaceName(id, name);
+      const int id = addSurface(input_cloud, *(surface_clouds[i]), meshes[i]);
+      std::string name;
+      data_coordinator_.getSurfaceName(id, name);
+      if (kept_names.count(name))
+      {
+        name += "_" + std::to_string(id);
+        surface_server_.rename_surface(id, name);
+        data_coordinator_.setSurfaceName(id, name);
+      }
     }
 
     // Save the Data Coordinator's Records
@@ -374,26 +456,59 @@ bool SurfaceBlendingService::find_surfaces(visualization_msgs::MarkerArray& surf
     latest_surface_detection_results_.surfaces = surfaces;
     robot_scan_.get_latest_scan_poses(latest_surface_detection_results_.robot_scan_poses);
 
-    // saving region colored point cloud
-    region_cloud_msg_ = sensor_msgs::PointCloud2();
-    surface_detection_.get_region_colored_cloud(region_cloud_msg_);
+    // publishing a reduced region colored point cloud for display
+    if (publish_region_point_cloud_)
+      publish_region_cloud();
   }
   else
   {
     succeeded = false;
-    region_cloud_msg_ = sensor_msgs::PointCloud2();
   }
 
   return succeeded;
 }
 
+int SurfaceBlendingService::addSurface(const godel_surface_detection::detection::CloudRGB& input_cloud,
+                                       const godel_surface_detection::detection::CloudRGB& surface_cloud,
+                                       const pcl::PolygonMesh& mesh)
+{
+  const int id = data_coordinator_.addRecord(input_cloud, surface_cloud);
+  ROS_INFO_STREAM("Created record with id: " << id);
+  const std::string name = surface_server_.add_surface(id, mesh);
+  data_coordinator_.setSurfaceMesh(id, mesh);
+  data_coordinator_.setSurfaceName(id, name);
+  return id;
+}
+
+void SurfaceBlendingService::publish_region_cloud()
+{
+  godel_surface_detection::detection::CloudRGB region_cloud, display_cloud;
+  surface_detection_.get_region_colored_cloud(region_cloud);
+
+  const double leaf = godel_surface_detection::visualization::downsampleForDisplay(
+      region_cloud, region_cloud_point_budget_, region_cloud_leaf_size_, display_cloud);
+  ROS_DEBUG_STREAM("Region cloud reduced from " << region_cloud.size() << " to " << display_cloud.size()
+                   << " points (voxel size " << leaf << ")");
+
+  sensor_msgs::PointCloud2Ptr msg(new sensor_msgs::PointCloud2);
+  pcl::toROSMsg(display_cloud, *msg);
+  msg->header.frame_id = region_cloud.header.frame_id;
+  point_cloud_pub_.publish(msg);
+}
+
+void SurfaceBlendingService::update_memory_accounting()
+{
+  // The other stores lock themselves; the trajectory library is guarded by the service
+  boost::lock_guard<boost::mutex> lock(trajectory_library_mutex_);
+  memory_monitor_.update();
+}
+
 void SurfaceBlendingService::clear_visualizations()
 {
   // Remove line-strips
   visualization_msgs::Marker marker;
   visualization_msgs::MarkerArray marker_array;
   marker.header.frame_id = "world_frame";
-  marker.header.stamp = ros::Time::now();
   marker.action = marker.DELETEALL;
   marker_array.markers.push_back(marker);
   tool_path_markers_pub_.publish(marker_array);
@@ -401,7 +516,6 @@ void SurfaceBlendingService::clear_visualizations()
   // Remove poses
   geometry_msgs::PoseArray empty_poses;
   empty_poses.header.frame_id = "world_frame";
-  empty_poses.header.stamp = ros::Time::now();
   edge_visualization_pub_.publish(empty_poses);
   blend_visualization_pub_.publish(empty_poses);
   scan_visualization_pub_.publish(empty_poses);
@@ -416,6 +530,7 @@ static bool isBlendPath(const std::string& s)
 bool SurfaceBlendingService::surface_detection_server_callback(
     godel_msgs::SurfaceDetection::Request& req, godel_msgs::SurfaceDetection::Response& res)
 {
+  GODEL_TRACE_SPAN("surface_detection");
   switch (req.action)
   {
     case godel_msgs::SurfaceDetection::Request::INITIALIZE_SPACE:
@@ -447,7 +562,9 @@ bool SurfaceBlendingService::surface_detection_server_callback(
       res.surfaces_found = false;
       res.surfaces = visualization_msgs::MarkerArray();
       SurfaceBlendingService::clear_visualizations();
-      data_coordinator_.init();
+      surface_detection_.regions_of_interest_ = req.regions_of_interest;
+      if (req.regions_of_interest.empty())
+        data_coordinator_.init();
 
       if (req.use_default_parameters)
       {
@@ -470,7 +587,9 @@ bool SurfaceBlendingService::surface_detection_server_callback(
       res.surfaces_found = false;
       res.surfaces = visualization_msgs::MarkerArray();
       SurfaceBlendingService::clear_visualizations();
-      data_coordinator_.init();
+      surface_detection_.regions_of_interest_ = req.regions_of_interest;
+      if (req.regions_of_interest.empty())
+        data_coordinator_.init();
 
       if (req.use_default_parameters)
       {
@@ -492,7 +611,9 @@ bool SurfaceBlendingService::surface_detection_server_callback(
       res.surfaces_found = false;
       res.surfaces = visualization_msgs::MarkerArray();
       SurfaceBlendingService::clear_visualizations();
-      data_coordinator_.init();
+      surface_detection_.regions_of_interest_ = req.regions_of_interest;
+      if (req.regions_of_interest.empty())
+        data_coordinator_.init();
 
       if (req.use_default_parameters)
       {
@@ -513,7 +634,9 @@ bool SurfaceBlendingService::surface_detection_server_callback(
       res.surfaces_found = false;
       res.surfaces = visualization_msgs::MarkerArray();
       SurfaceBlendingService::clear_visualizations();
-      data_coordinator_.init();
+      surface_detection_.regions_of_interest_ = req.regions_of_interest;
+      if (req.regions_of_interest.empty())
+        data_coordinator_.init();
 
       if (req.use_default_parameters)
       {
@@ -552,30 +675,92 @@ bool SurfaceBlendingService::surface_detection_server_callback(
       ROS_ERROR_STREAM("Unrecognized surface detection request");
   }
 
+  update_memory_accounting();
   return true;
 }
 
+void SurfaceBlendingService::publishPlanningStatus(const std::string& status)
+{
+  process_planning_feedback_ = godel_msgs::ProcessPlanningFeedback();
+  process_planning_feedback_.last_completed = status;
+  process_planning_server_.publishFeedback(process_planning_feedback_);
+}
+
+void SurfaceBlendingService::generateMotionLibrary(const godel_msgs::PathPlanningParameters& params)
+{
+  SWRI_PROFILE("generate-motion-library");
+  GODEL_TRACE_SPAN("generate_motion_library");
+  std::vector<int> selected_ids;
+  surface_server_.getSelectedIds(selected_ids);
+
+  // Clear previous results; plans are added back surface by surface as they finish
+  {
+    boost::lock_guard<boost::mutex> lock(trajectory_library_mutex_);
+    trajectory_library_.clear();
+  }
+  process_path_results_ = ProcessPathDetails();
+
+  godel_surface_detection::ProgressivePlanner planner;
+  if (batch_enabled_)
+  {
+    addBatchSurfaces(selected_ids, params, planner);
+  }
+  else
+  {
+    for (const auto& id : selected_ids)
+      planner.addSurface(boost::bind(&SurfaceBlendingService::planSurface, this, id, params, _1));
+  }
+
+  godel_msgs::ProcessPlanningResult result;
+  auto on_surface = [this, &result](const godel_surface_detection::SurfacePlanningResult& surface,
+                                    std::size_t completed, std::size_t total) {
+    {
+      boost::lock_guard<boost::mutex> lock(trajectory_library_mutex_);
+      trajectory_library_.insert(surface.plans);
+    }
+    for (const auto& plan : surface.plans)
+      result.plan_names.push_back(plan.first);
+
+    visualizePaths();
+    godel_surface_detection::toFeedback(surface, completed, total, process_planning_feedback_);
+    process_planning_server_.publishFeedback(process_planning_feedback_);
+  };
+
+  const auto outcome = planner.run(on_surface, [this]() {
+    return process_planning_server_.isPreemptRequested() || !ros::ok();
+  });
+
+  batch_paths_.clear();
+
+  result.succeeded = !result.plan_names.empty();
+  if (outcome == godel_surface_detection::ProgressivePlanner::PREEMPTED)
+  {
+    process_planning_server_.setPreempted(result, "Planning cancelled; pending surfaces were skipped");
+  }
+  else
+  {
+    publishPlanningStatus("Finished planning.");
+    process_planning_server_.setSucceeded(result);
+  }
+
+  update_memory_accounting();
+}
+
 void SurfaceBlendingService::processPlanningActionCallback(const godel_msgs::ProcessPlanningGoalConstPtr &goal_in)
 {
+  godel_utils::tracing::Span span("process_planning", goal_in->trace);
   switch (goal_in->action)
   {
     case godel_msgs::ProcessPlanningGoal::GENERATE_MOTION_PLAN_AND_PREVIEW:
     {
       ensenso::EnsensoGuard guard; // turns off ensenso for planning and turns it on when this goes out of scope
-      process_planning_feedback_.last_completed = "Recieved request to generate motion plan";
-      process_planning_server_.publishFeedback(process_planning_feedback_);
-      trajectory_library_ = generateMotionLibrary(goal_in->params);
-      process_planning_feedback_.last_completed = "Finished planning. Visualizing...";
-      process_planning_server_.publishFeedback(process_planning_feedback_);
-      visualizePaths();
-      process_planning_result_.succeeded = true;
-      process_planning_server_.setSucceeded(process_planning_result_);
+      publishPlanningStatus("Recieved request to generate motion plan");
+      generateMotionLibrary(goal_in->params);
       break;
     }
     case godel_msgs::ProcessPlanningGoal::PREVIEW_TOOL_PATH:
     {
-      process_planning_feedback_.last_completed = "Recieved request to preview tool path";
-      process_planning_server_.publishFeedback(process_planning_feedback_);
+      publishPlanningStatus("Recieved request to preview tool path");
       break;
     }
 
@@ -585,9 +770,6 @@ void SurfaceBlendingService::processPlanningActionCallback(const godel_msgs::Pro
       break;
     }
   }
-
-  process_planning_result_.succeeded = false;
-
 }
 
 
@@ -640,6 +822,7 @@ bool SurfaceBlendingService::surface_blend_parameters_server_callback(
     godel_msgs::SurfaceBlendingParameters::Request& req,
     godel_msgs::SurfaceBlendingParameters::Response& res)
 {
+  res.succeeded = true;
   switch (req.action)
   {
   case godel_msgs::SurfaceBlendingParameters::Request::GET_CURRENT_PARAMETERS:
@@ -671,11 +854,19 @@ bool SurfaceBlendingService::surface_blend_parameters_server_callback(
 
     if (req.action == godel_msgs::SurfaceBlendingParameters::Request::SAVE_PARAMETERS)
     {
-      this->save_blend_parameters(param_cache_prefix_ + BLEND_PARAMS_FILE);
-      this->save_scan_parameters(param_cache_prefix_ + SCAN_PARAMS_FILE);
-      this->save_path_planning_parameters(param_cache_prefix_ + PATH_PLANNING_PARAMS_FILE);
-      robot_scan_.save_parameters(param_cache_prefix_ + ROBOT_SCAN_PARAMS_FILE);
-      surface_detection_.save_parameters(param_cache_prefix_ + SURFACE_DETECTION_PARAMS_FILE);
+      // The files are written by the parameter writer, in the order the requests came in; the
+      // reply waits for them so that a save that failed is reported
+      std::vector<std::future<bool> > saves;
+      saves.push_back(this->save_blend_parameters(param_cache_prefix_ + BLEND_PARAMS_FILE));
+      saves.push_back(this->save_scan_parameters(param_cache_prefix_ + SCAN_PARAMS_FILE));
+      saves.push_back(this->save_path_planning_parameters(param_cache_prefix_ + PATH_PLANNING_PARAMS_FILE));
+      saves.push_back(robot_scan_.save_parameters(param_cache_prefix_ + ROBOT_SCAN_PARAMS_FILE, param_writer_));
+      saves.push_back(
+          surface_detection_.save_parameters(param_cache_prefix_ + SURFACE_DETECTION_PARAMS_FILE, param_writer_));
+      for (std::future<bool>& saved : saves)
+      {
+        res.succeeded = saved.get() && res.succeeded;
+      }
     }
     break;
   }
@@ -686,26 +877,33 @@ bool SurfaceBlendingService::surface_blend_parameters_server_callback(
 
 void SurfaceBlendingService::selectMotionPlansActionCallback(const godel_msgs::SelectMotionPlanGoalConstPtr& goal_in)
 {
+  GODEL_TRACE_SPAN("select_motion_plan");
   godel_msgs::SelectMotionPlanResult res;
 
-  // If plan does not exist, abort and return
-  if (trajectory_library_.get().find(goal_in->name) == trajectory_library_.get().end())
+  // Plans may be added by a planning goal that is still running, so take a copy
+  godel_msgs::ProcessPlan plan;
   {
-    ROS_WARN_STREAM("Motion plan " << goal_in->name << " does not exist. Cannot execute.");
-    res.code = godel_msgs::SelectMotionPlanResponse::NO_SUCH_NAME;
-    select_motion_plan_server_.setAborted(res);
-    return;
+    boost::lock_guard<boost::mutex> lock(trajectory_library_mutex_);
+    // If plan does not exist, abort and return
+    if (!trajectory_library_.fetch(goal_in->name, plan))
+    {
+      ROS_WARN_STREAM("Motion plan " << goal_in->name << " does not exist. Cannot execute.");
+      res.code = godel_msgs::SelectMotionPlanResponse::NO_SUCH_NAME;
+      select_motion_plan_server_.setAborted(res);
+      return;
+    }
   }
 
-  bool is_blend = trajectory_library_.get()[goal_in->name].type == godel_msgs::ProcessPlan::BLEND_TYPE;
+  bool is_blend = plan.type == godel_msgs::ProcessPlan::BLEND_TYPE;
 
   // Send command to execution server
   godel_msgs::ProcessExecutionActionGoal goal;
-  goal.goal.trajectory_approach = trajectory_library_.get()[goal_in->name].trajectory_approach;
-  goal.goal.trajectory_depart = trajectory_library_.get()[goal_in->name].trajectory_depart;
-  goal.goal.trajectory_process = trajectory_library_.get()[goal_in->name].trajectory_process;
+  goal.goal.trajectory_approach = plan.trajectory_approach;
+  goal.goal.trajectory_depart = plan.trajectory_depart;
+  goal.goal.trajectory_process = plan.trajectory_process;
   goal.goal.wait_for_execution = goal_in->wait_for_execution;
   goal.goal.simulate = goal_in->simulate;
+  goal.goal.trace = godel_utils::tracing::inject();
 
   actionlib::SimpleActionClient<godel_msgs::ProcessExecutionAction> *exe_client =
       (is_blend ? &blend_exe_client_ : &scan_exe_client_);
@@ -730,11 +928,8 @@ bool SurfaceBlendingService::getMotionPlansCallback(
     godel_msgs::GetAvailableMotionPlans::Request&,
     godel_msgs::GetAvailableMotionPlans::Response& res)
 {
-  typedef godel_surface_detection::TrajectoryLibrary::TrajectoryMap::const_iterator MapIter;
-  for (MapIter it = trajectory_library_.get().begin(); it != trajectory_library_.get().end(); ++it)
-  {
-    res.names.push_back(it->first);
-  }
+  boost::lock_guard<boost::mutex> lock(trajectory_library_mutex_);
+  res.names = trajectory_library_.names();
   return true;
 }
 
@@ -742,6 +937,7 @@ bool SurfaceBlendingService::getMotionPlansCallback(
 bool SurfaceBlendingService::loadSaveMotionPlanCallback(
     godel_msgs::LoadSaveMotionPlan::Request& req, godel_msgs::LoadSaveMotionPlan::Response& res)
 {
+  boost::lock_guard<boost::mutex> lock(trajectory_library_mutex_);
   switch (req.mode)
   {
   case godel_msgs::LoadSaveMotionPlan::Request::MODE_LOAD:
@@ -784,8 +980,8 @@ void SurfaceBlendingService::visualizePathPoses()
 {
   // Publish poses
   geometry_msgs::PoseArray blend_poses, edge_poses, scan_poses;
+  // Stamps are left at zero (latest transform); the publishers skip arrays whose content is unchanged
   blend_poses.header.frame_id = edge_poses.header.frame_id = scan_poses.header.frame_id = "world_frame";
-  blend_poses.header.stamp = edge_poses.header.stamp = scan_poses.header.stamp = ros::Time::now();
 
   for (const auto& path : process_path_results_.blend_poses_)
   {
@@ -806,6 +1002,11 @@ void SurfaceBlendingService::visualizePathPoses()
     }
   }
 
+  using godel_surface_detection::visualization::decimatePoses;
+  decimatePoses(blend_poses, max_visualized_poses_);
+  decimatePoses(edge_poses, max_visualized_poses_);
+  decimatePoses(scan_poses, max_visualized_poses_);
+
   blend_visualization_pub_.publish(blend_poses);
   edge_visualization_pub_.publish(edge_poses);
   scan_visualization_pub_.publish(scan_poses);
@@ -816,7 +1017,6 @@ static visualization_msgs::Marker makeLineStripMarker(const std::string& ns, con
 {
   visualization_msgs::Marker marker;
   marker.header.frame_id = "world_frame";
-  marker.header.stamp = ros::Time::now();
   marker.id = id;
   marker.ns = ns;
   marker.pose.orientation.w = 1;
@@ -834,7 +1034,7 @@ static visualization_msgs::Marker makeLineStripMarker(const std::string& ns, con
 
 void SurfaceBlendingService::visualizePathStrips()
 {
-  visualization_msgs::MarkerArray path_visualization;
+  visualization_msgs::MarkerArrayPtr path_visualization(new visualization_msgs::MarkerArray);
 
   // Visualize Blending Paths
   std_msgs::ColorRGBA blend_color;
@@ -851,7 +1051,7 @@ void SurfaceBlendingService::visualizePathStrips()
   {
     for (const auto& segment : path) // for a given path segment on the surface
     {
-      path_visualization.markers.push_back(makeLineStripMarker(blend_ns, blend_path_id++, blend_color, segment));
+      path_visualization->markers.push_back(makeLineStripMarker(blend_ns, blend_path_id++, blend_color, segment));
     }
   }
 
@@ -870,7 +1070,7 @@ void SurfaceBlendingService::visualizePathStrips()
   {
     for (const auto& segment : path) // for a given path segment on the surface
     {
-      path_visualization.markers.push_back(makeLineStripMarker(scan_ns, scan_path_id++, scan_color, segment));
+      path_visualization->markers.push_back(makeLineStripMarker(scan_ns, scan_path_id++, scan_color, segment));
     }
   }
 
@@ -902,19 +1102,3 @@ std::string SurfaceBlendingService::getScanToolPlanningPluginName() const
 
   return name;
 }
-
-int main(int argc, char** argv)
-{
-  ros::init(argc, argv, "surface_blending_service");
-  ros::AsyncSpinner spinner(4);
-  spinner.start();
-  SurfaceBlendingService service;
-
-  if (service.init())
-  {
-    ROS_INFO("Godel Surface Blending Service successfully initialized and now running");
-    service.run();
-  }
-
-  ros::waitForShutdown();
-}
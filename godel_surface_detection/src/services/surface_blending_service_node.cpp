@@ -0,0 +1,19 @@
+#include <services/surface_blending_service.h>
+#include <godel_utils/tracing.h>
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "surface_blending_service");
+  godel_utils::tracing::initialize(ros::this_node::getName());
+  ros::AsyncSpinner spinner(4);
+  spinner.start();
+  SurfaceBlendingService service;
+
+  if (service.init())
+  {
+    ROS_INFO("Godel Surface Blending Service successfully initialized and now running");
+    service.run();
+  }
+
+  ros::waitForShutdown();
+}
@@ -1,7 +1,26 @@
 #include "services/trajectory_library.h"
 
+#include <atomic>
+#include <boost/filesystem.hpp>
 #include <rosbag/bag.h>
 #include <rosbag/view.h>
+#include <ros/serialization.h>
+#include <sstream>
+
+namespace
+{
+std::atomic<unsigned> library_count(0); // tells the spill files of several libraries apart
+}
+
+godel_surface_detection::TrajectoryLibrary::TrajectoryLibrary()
+    : bytes_(0), spill_directory_(godel_utils::memory::defaultSpillDirectory())
+{
+  std::ostringstream ss;
+  ss << "trajectory_library_" << library_count++ << ".bag";
+  spill_name_ = ss.str();
+}
+
+godel_surface_detection::TrajectoryLibrary::~TrajectoryLibrary() { removeSpillFile(); }
 
 void godel_surface_detection::TrajectoryLibrary::save(const std::string& filename)
 {
@@ -9,9 +28,11 @@ void godel_surface_detection::TrajectoryLibrary::save(const std::string& filenam
   bag.open(filename, rosbag::bagmode::Write);
   ros::Time now = ros::Time::now();
 
-  for (TrajectoryMap::const_iterator it = map_.begin(); it != map_.end(); ++it)
+  for (const std::string& name : names())
   {
-    bag.write(it->first, now, it->second);
+    godel_msgs::ProcessPlan plan;
+    if (fetch(name, plan))
+      bag.write(name, now, plan);
   }
 }
 
@@ -32,11 +53,129 @@ void godel_surface_detection::TrajectoryLibrary::load(const std::string& filenam
 
     // Check to see if key is already in data structure
     std::string const& key = it->getTopic();
-    if (map_.find(key) != map_.end())
+    if (map_.find(key) != map_.end() || spilled_.count(key) > 0)
     {
       throw std::runtime_error("Bagfile had name matching key already in data structure");
     }
 
-    map_[key] = *ptr;
+    add(key, *ptr);
+  }
+  enforceHardBudget();
+}
+
+void godel_surface_detection::TrajectoryLibrary::insert(const TrajectoryMap& plans)
+{
+  for (const auto& plan : plans)
+    add(plan.first, plan.second);
+  enforceHardBudget();
+}
+
+void godel_surface_detection::TrajectoryLibrary::clear()
+{
+  map_.clear();
+  insertion_order_.clear();
+  spilled_.clear();
+  bytes_ = 0;
+  removeSpillFile();
+}
+
+bool godel_surface_detection::TrajectoryLibrary::fetch(const std::string& name,
+                                                       godel_msgs::ProcessPlan& plan) const
+{
+  TrajectoryMap::const_iterator it = map_.find(name);
+  if (it != map_.end())
+  {
+    plan = it->second;
+    return true;
+  }
+  if (spilled_.count(name) == 0)
+    return false;
+
+  // A plan may have been spilled more than once; the last copy is the current one
+  bool found = false;
+  try
+  {
+    rosbag::Bag bag;
+    bag.open(spillFile(), rosbag::bagmode::Read);
+    rosbag::View view(bag, rosbag::TopicQuery(name));
+    for (rosbag::View::iterator m = view.begin(); m != view.end(); ++m)
+    {
+      godel_msgs::ProcessPlanPtr ptr = m->instantiate<godel_msgs::ProcessPlan>();
+      if (ptr)
+      {
+        plan = *ptr;
+        found = true;
+      }
+    }
+  }
+  catch (const rosbag::BagException& e)
+  {
+    ROS_ERROR_STREAM("Could not read spilled motion plan '" << name << "': " << e.what());
+    return false;
+  }
+  return found;
+}
+
+std::vector<std::string> godel_surface_detection::TrajectoryLibrary::names() const
+{
+  std::set<std::string> all(spilled_);
+  for (const auto& entry : map_)
+    all.insert(entry.first);
+  return std::vector<std::string>(all.begin(), all.end());
+}
+
+void godel_surface_detection::TrajectoryLibrary::evict(std::size_t target_bytes)
+{
+  if (insertion_order_.empty())
+    return;
+
+  try
+  {
+    boost::filesystem::create_directories(spill_directory_);
+    rosbag::Bag bag;
+    bag.open(spillFile(), boost::filesystem::exists(spillFile()) ? rosbag::bagmode::Append
+                                                                 : rosbag::bagmode::Write);
+    const ros::Time stamp(ros::WallTime::now().toSec());
+    while (bytes_ > target_bytes && !insertion_order_.empty())
+    {
+      const std::string name = insertion_order_.front();
+      TrajectoryMap::iterator it = map_.find(name);
+      bag.write(name, stamp, it->second);
+
+      bytes_ -= ros::serialization::serializationLength(it->second);
+      map_.erase(it);
+      insertion_order_.pop_front();
+      spilled_.insert(name);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    ROS_ERROR_STREAM("Could not spill motion plans to " << spillFile() << ": " << e.what());
+  }
+}
+
+void godel_surface_detection::TrajectoryLibrary::add(const std::string& name,
+                                                     const godel_msgs::ProcessPlan& plan)
+{
+  TrajectoryMap::iterator it = map_.find(name);
+  if (it != map_.end())
+  {
+    bytes_ -= ros::serialization::serializationLength(it->second);
+    insertion_order_.remove(name);
   }
+  map_[name] = plan;
+  insertion_order_.push_back(name);
+  spilled_.erase(name);
+  bytes_ += ros::serialization::serializationLength(plan);
+}
+
+std::string godel_surface_detection::TrajectoryLibrary::spillFile() const
+{
+  return (boost::filesystem::path(spill_directory_) / spill_name_).string();
+}
+
+void godel_surface_detection::TrajectoryLibrary::removeSpillFile()
+{
+  boost::system::error_code ec;
+  boost::filesystem::remove(spillFile(), ec);
 }
@@ -0,0 +1,693 @@
+#include <synthetic/synthetic_workload.h>
+
+#include <scan/robot_scan.h>
+#include <ros/console.h>
+#include <tf_conversions/tf_eigen.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+
+const static double SURFACE_TOLERANCE = 1e-6; // (m) points closer than this to a boundary are on it
+const static long CHUNK_POINTS = 1 << 16;      // generated with one random sequence
+const static int MAX_REJECTIONS = 10000;       // in a row before a part is deemed to have no surface
+
+namespace
+{
+using namespace godel_surface_detection::synthetic;
+
+enum FaceKind
+{
+  RECTANGLE,     // normal to 'axis' at 'offset', half sizes 'half_u' and 'half_v' along the next axes
+  DISK,          // normal to z at 'offset', of 'radius'
+  CYLINDER_SIDE, // of 'radius' and 'half_height'
+  SPHERE_SURFACE // of 'radius'
+};
+
+struct Face
+{
+  std::size_t primitive;
+  FaceKind kind;
+  int axis;
+  double offset;
+  double half_u, half_v;
+  double radius, half_height;
+  double area;
+  uint32_t label;
+};
+
+/**
+ * A primitive with the inverse of its pose; boundary() is negative inside, zero on the surface and
+ * positive outside. It is not a true distance off the faces, only its sign and zero set matter.
+ */
+struct Solid
+{
+  explicit Solid(const Primitive& p) : primitive(p), inverse(p.pose.inverse()) {}
+
+  double boundary(const Eigen::Vector3d& world, Eigen::Vector3d& normal) const
+  {
+    const Eigen::Vector3d q = inverse * world;
+    const Eigen::Vector3d& size = primitive.size;
+    Eigen::Vector3d n;
+    double s;
+
+    switch (primitive.type)
+    {
+    case BOX:
+    {
+      const Eigen::Vector3d d = q.cwiseAbs() - 0.5 * size;
+      int axis;
+      s = d.maxCoeff(&axis);
+      n = Eigen::Vector3d::Zero();
+      n[axis] = q[axis] < 0.0 ? -1.0 : 1.0;
+      break;
+    }
+    case CYLINDER:
+    {
+      const double r = std::hypot(q.x(), q.y());
+      const double radial = r - size.x();
+      const double axial = std::abs(q.z()) - 0.5 * size.z();
+      if (radial > axial)
+      {
+        s = radial;
+        n = r > 0.0 ? Eigen::Vector3d(q.x() / r, q.y() / r, 0.0) : Eigen::Vector3d::UnitX();
+      }
+      else
+      {
+        s = axial;
+        n = Eigen::Vector3d(0.0, 0.0, q.z() < 0.0 ? -1.0 : 1.0);
+      }
+      break;
+    }
+    default:
+    {
+      const double r = q.norm();
+      s = r - size.x();
+      n = r > 0.0 ? Eigen::Vector3d(q / r) : Eigen::Vector3d::UnitZ();
+      break;
+    }
+    }
+
+    normal = primitive.pose.linear() * n;
+    return s;
+  }
+
+  Primitive primitive;
+  Eigen::Affine3d inverse;
+};
+
+std::string typeName(PrimitiveType type)
+{
+  switch (type)
+  {
+  case BOX:
+    return "box";
+  case CYLINDER:
+    return "cylinder";
+  default:
+    return "sphere";
+  }
+}
+
+void buildFaces(const PartDescription& part, std::vector<Face>& faces, std::vector<std::string>& names)
+{
+  for (std::size_t i = 0; i < part.primitives.size(); ++i)
+  {
+    const Primitive& p = part.primitives[i];
+    const std::string prefix = typeName(p.type) + "_" + std::to_string(i) + "/";
+    Face f = Face();
+    f.primitive = i;
+
+    if (p.type == BOX)
+    {
+      f.kind = RECTANGLE;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        f.axis = axis;
+        f.half_u = 0.5 * p.size[(axis + 1) % 3];
+        f.half_v = 0.5 * p.size[(axis + 2) % 3];
+        f.area = 4.0 * f.half_u * f.half_v;
+        for (int sign = 1; sign >= -1; sign -= 2)
+        {
+          f.offset = 0.5 * sign * p.size[axis];
+          faces.push_back(f);
+          names.push_back(prefix + (sign > 0 ? "+" : "-") + "xyz"[axis]);
+        }
+      }
+    }
+    else if (p.type == CYLINDER)
+    {
+      f.radius = p.size.x();
+      f.half_height = 0.5 * p.size.z();
+      f.kind = CYLINDER_SIDE;
+      f.area = 2.0 * M_PI * f.radius * p.size.z();
+      faces.push_back(f);
+      names.push_back(prefix + "side");
+
+      f.kind = DISK;
+      f.axis = 2;
+      f.area = M_PI * f.radius * f.radius;
+      for (int sign = 1; sign >= -1; sign -= 2)
+      {
+        f.offset = sign * f.half_height;
+        faces.push_back(f);
+        names.push_back(prefix + (sign > 0 ? "+z" : "-z"));
+      }
+    }
+    else
+    {
+      f.kind = SPHERE_SURFACE;
+      f.radius = p.size.x();
+      f.area = 4.0 * M_PI * f.radius * f.radius;
+      faces.push_back(f);
+      names.push_back(prefix + "surface");
+    }
+  }
+
+  for (std::size_t i = 0; i < faces.size(); ++i)
+    faces[i].label = static_cast<uint32_t>(i + 1);
+}
+
+std::vector<Solid> buildSolids(const PartDescription& part)
+{
+  std::vector<Solid> solids;
+  for (const Primitive& p : part.primitives)
+    solids.push_back(Solid(p));
+  return solids;
+}
+
+/**
+ * @brief Whether a point on the surface of solid 'self', with outward normal n, is on the surface
+ * of the part. Faces hidden inside the material or between two touching primitives are not; of two
+ * flush faces only the first primitive's one is. Walls of cut-outs are only where there is
+ * material around them.
+ */
+bool visible(const std::vector<Solid>& solids, std::size_t self, const Eigen::Vector3d& p,
+             const Eigen::Vector3d& n)
+{
+  const bool self_cut = solids[self].primitive.cut;
+  bool in_material = !self_cut;
+  Eigen::Vector3d other_n;
+
+  for (std::size_t j = 0; j < solids.size(); ++j)
+  {
+    if (j == self)
+      continue;
+
+    const double s = solids[j].boundary(p, other_n);
+    if (solids[j].primitive.cut)
+    {
+      if (s < SURFACE_TOLERANCE)
+        return false;
+    }
+    else if (self_cut)
+    {
+      if (s < -SURFACE_TOLERANCE)
+        in_material = true;
+    }
+    else if (s < -SURFACE_TOLERANCE)
+    {
+      return false;
+    }
+    else if (s < SURFACE_TOLERANCE && (other_n.dot(n) < 0.5 || j < self))
+    {
+      return false;
+    }
+  }
+  return in_material;
+}
+
+/** @brief A uniformly distributed point of a face and its outward normal, in the world frame */
+void sampleFace(const Face& f, const Primitive& primitive, std::mt19937& rng, Eigen::Vector3d& p,
+                Eigen::Vector3d& n)
+{
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  Eigen::Vector3d q, m;
+
+  switch (f.kind)
+  {
+  case RECTANGLE:
+    q[f.axis] = f.offset;
+    q[(f.axis + 1) % 3] = f.half_u * (2.0 * unit(rng) - 1.0);
+    q[(f.axis + 2) % 3] = f.half_v * (2.0 * unit(rng) - 1.0);
+    m = Eigen::Vector3d::Zero();
+    m[f.axis] = f.offset < 0.0 ? -1.0 : 1.0;
+    break;
+  case DISK:
+  {
+    const double r = f.radius * std::sqrt(unit(rng));
+    const double theta = 2.0 * M_PI * unit(rng);
+    q = Eigen::Vector3d(r * std::cos(theta), r * std::sin(theta), f.offset);
+    m = Eigen::Vector3d(0.0, 0.0, f.offset < 0.0 ? -1.0 : 1.0);
+    break;
+  }
+  case CYLINDER_SIDE:
+  {
+    const double theta = 2.0 * M_PI * unit(rng);
+    m = Eigen::Vector3d(std::cos(theta), std::sin(theta), 0.0);
+    q = f.radius * m;
+    q.z() = f.half_height * (2.0 * unit(rng) - 1.0);
+    break;
+  }
+  default:
+  {
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    do
+    {
+      m = Eigen::Vector3d(gauss(rng), gauss(rng), gauss(rng));
+    } while (m.squaredNorm() < 1e-12);
+    m.normalize();
+    q = f.radius * m;
+    break;
+  }
+  }
+
+  p = primitive.pose * q;
+  n = primitive.pose.linear() * m;
+}
+
+/**
+ * @brief Ray parameters (up to two) at which a ray, in the frame of the face's primitive, crosses
+ * the face
+ */
+int intersectFace(const Face& f, const Eigen::Vector3d& o, const Eigen::Vector3d& d, double t[2])
+{
+  switch (f.kind)
+  {
+  case RECTANGLE:
+  case DISK:
+  {
+    if (std::abs(d[f.axis]) < 1e-12)
+      return 0;
+    t[0] = (f.offset - o[f.axis]) / d[f.axis];
+    const Eigen::Vector3d q = o + t[0] * d;
+    if (f.kind == RECTANGLE)
+      return std::abs(q[(f.axis + 1) % 3]) <= f.half_u && std::abs(q[(f.axis + 2) % 3]) <= f.half_v;
+    return q.x() * q.x() + q.y() * q.y() <= f.radius * f.radius;
+  }
+  case CYLINDER_SIDE:
+  {
+    const double a = d.x() * d.x() + d.y() * d.y();
+    const double b = 2.0 * (o.x() * d.x() + o.y() * d.y());
+    const double c = o.x() * o.x() + o.y() * o.y() - f.radius * f.radius;
+    const double disc = b * b - 4.0 * a * c;
+    if (a < 1e-12 || disc < 0.0)
+      return 0;
+    int count = 0;
+    for (double root : {(-b - std::sqrt(disc)) / (2.0 * a), (-b + std::sqrt(disc)) / (2.0 * a)})
+      if (std::abs(o.z() + root * d.z()) <= f.half_height)
+        t[count++] = root;
+    return count;
+  }
+  default:
+  {
+    const double b = 2.0 * o.dot(d);
+    const double c = o.squaredNorm() - f.radius * f.radius;
+    const double disc = b * b - 4.0 * d.squaredNorm() * c;
+    if (disc < 0.0)
+      return 0;
+    t[0] = (-b - std::sqrt(disc)) / (2.0 * d.squaredNorm());
+    t[1] = (-b + std::sqrt(disc)) / (2.0 * d.squaredNorm());
+    return 2;
+  }
+  }
+}
+
+void setColor(uint32_t label, LabelledPoint& p)
+{
+  // Well spread, stable colors so that surfaces tell apart in rviz
+  const uint32_t hash = label * 2654435761u;
+  p.r = 64 + (hash >> 8) % 192;
+  p.g = 64 + (hash >> 16) % 192;
+  p.b = 64 + (hash >> 24) % 192;
+}
+
+double toDouble(XmlRpc::XmlRpcValue& value)
+{
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+    return static_cast<int>(value);
+  return static_cast<double>(value);
+}
+
+bool isNumber(XmlRpc::XmlRpcValue& value)
+{
+  return value.getType() == XmlRpc::XmlRpcValue::TypeInt || value.getType() == XmlRpc::XmlRpcValue::TypeDouble;
+}
+
+/** @brief Reads an optional number; false if the field is there but is not a number */
+bool readNumber(XmlRpc::XmlRpcValue& entry, const std::string& field, double& value)
+{
+  if (!entry.hasMember(field))
+    return true;
+  if (!isNumber(entry[field]))
+  {
+    ROS_ERROR_STREAM("Synthetic part field '" << field << "' must be a number");
+    return false;
+  }
+  value = toDouble(entry[field]);
+  return true;
+}
+
+bool loadPrimitive(XmlRpc::XmlRpcValue& entry, int index, Primitive& primitive)
+{
+  if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    ROS_ERROR_STREAM("Synthetic part primitive " << index << " must be a struct");
+    return false;
+  }
+
+  std::string type = "box";
+  if (entry.hasMember("type"))
+    type = static_cast<std::string>(entry["type"]);
+  if (entry.hasMember("cut"))
+    primitive.cut = static_cast<bool>(entry["cut"]);
+
+  double x = 0, y = 0, z = 0, rx = 0, ry = 0, rz = 0, l = 0, w = 0, h = 0, radius = 0;
+  if (!readNumber(entry, "x", x) || !readNumber(entry, "y", y) || !readNumber(entry, "z", z) ||
+      !readNumber(entry, "rx", rx) || !readNumber(entry, "ry", ry) || !readNumber(entry, "rz", rz) ||
+      !readNumber(entry, "l", l) || !readNumber(entry, "w", w) || !readNumber(entry, "h", h) ||
+      !readNumber(entry, "radius", radius))
+    return false;
+
+  primitive.pose = Eigen::Translation3d(x, y, z) * Eigen::AngleAxisd(rz, Eigen::Vector3d::UnitZ()) *
+                   Eigen::AngleAxisd(ry, Eigen::Vector3d::UnitY()) *
+                   Eigen::AngleAxisd(rx, Eigen::Vector3d::UnitX());
+
+  if (type == "box")
+  {
+    primitive.type = BOX;
+    primitive.size = Eigen::Vector3d(l, w, h);
+  }
+  else if (type == "cylinder")
+  {
+    primitive.type = CYLINDER;
+    primitive.size = Eigen::Vector3d(radius, radius, h);
+  }
+  else if (type == "sphere")
+  {
+    primitive.type = SPHERE;
+    primitive.size = Eigen::Vector3d(radius, radius, radius);
+  }
+  else
+  {
+    ROS_ERROR_STREAM("Synthetic part primitive " << index << " has unknown type '" << type
+                                                 << "', expected box, cylinder or sphere");
+    return false;
+  }
+
+  if (primitive.size.minCoeff() <= 0.0)
+  {
+    ROS_ERROR_STREAM("Synthetic part primitive " << index << " (" << type << ") needs "
+                                                 << (type == "box" ? "positive l, w and h" :
+                                                     type == "cylinder" ? "a positive radius and h" :
+                                                                          "a positive radius"));
+    return false;
+  }
+  return true;
+}
+
+} // end anon namespace
+
+namespace godel_surface_detection
+{
+namespace synthetic
+{
+
+Primitive box(double x, double y, double z, double l, double w, double h)
+{
+  Primitive primitive;
+  primitive.type = BOX;
+  primitive.pose = Eigen::Translation3d(x, y, z);
+  primitive.size = Eigen::Vector3d(l, w, h);
+  return primitive;
+}
+
+Primitive cylinder(double x, double y, double z, double radius, double h)
+{
+  Primitive primitive;
+  primitive.type = CYLINDER;
+  primitive.pose = Eigen::Translation3d(x, y, z);
+  primitive.size = Eigen::Vector3d(radius, radius, h);
+  return primitive;
+}
+
+Primitive sphere(double x, double y, double z, double radius)
+{
+  Primitive primitive;
+  primitive.type = SPHERE;
+  primitive.pose = Eigen::Translation3d(x, y, z);
+  primitive.size = Eigen::Vector3d(radius, radius, radius);
+  return primitive;
+}
+
+Primitive cutOut(Primitive primitive)
+{
+  primitive.cut = true;
+  return primitive;
+}
+
+bool loadPart(XmlRpc::XmlRpcValue& description, PartDescription& part)
+{
+  if (description.getType() != XmlRpc::XmlRpcValue::TypeStruct || !description.hasMember("primitives") ||
+      description["primitives"].getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    ROS_ERROR("A synthetic part needs a list of 'primitives'");
+    return false;
+  }
+
+  double target_points = part.target_points, noise = part.noise, seed = part.seed;
+  if (!readNumber(description, "target_points", target_points) ||
+      !readNumber(description, "noise", noise) || !readNumber(description, "seed", seed))
+    return false;
+  if (target_points < 1 || noise < 0.0 || seed < 0)
+  {
+    ROS_ERROR("Synthetic part 'target_points' must be positive, 'noise' and 'seed' not negative");
+    return false;
+  }
+  part.target_points = static_cast<std::size_t>(target_points);
+  part.noise = noise;
+  part.seed = static_cast<unsigned>(seed);
+
+  XmlRpc::XmlRpcValue& primitives = description["primitives"];
+  part.primitives.clear();
+  for (int i = 0; i < primitives.size(); ++i)
+  {
+    Primitive primitive;
+    if (!loadPrimitive(primitives[i], i, primitive))
+      return false;
+    part.primitives.push_back(primitive);
+  }
+  return true;
+}
+
+CameraModel loadCamera(const ros::NodeHandle& nh)
+{
+  CameraModel camera;
+  nh.param("width", camera.width, camera.width);
+  nh.param("height", camera.height, camera.height);
+  nh.param("fx", camera.fx, camera.fx);
+  nh.param("fy", camera.fy, camera.fy);
+  nh.param("cx", camera.cx, (camera.width - 1) / 2.0);
+  nh.param("cy", camera.cy, (camera.height - 1) / 2.0);
+  nh.param("min_range", camera.min_range, camera.min_range);
+  nh.param("max_range", camera.max_range, camera.max_range);
+  nh.param("depth_noise", camera.depth_noise, camera.depth_noise);
+  nh.param("depth_noise_quadratic", camera.depth_noise_quadratic, camera.depth_noise_quadratic);
+  nh.param("dropout_rate", camera.dropout_rate, camera.dropout_rate);
+  nh.param("max_incidence_angle", camera.max_incidence_angle, camera.max_incidence_angle);
+  return camera;
+}
+
+std::vector<std::string> surfaceNames(const PartDescription& part)
+{
+  std::vector<Face> faces;
+  std::vector<std::string> names;
+  buildFaces(part, faces, names);
+  return names;
+}
+
+bool generatePart(const PartDescription& part, LabelledCloud& cloud)
+{
+  std::vector<Face> faces;
+  std::vector<std::string> names;
+  buildFaces(part, faces, names);
+  const std::vector<Solid> solids = buildSolids(part);
+
+  cloud.clear();
+  if (faces.empty() || part.target_points == 0)
+  {
+    ROS_ERROR("Cannot generate a synthetic part without primitives or points");
+    return false;
+  }
+
+  std::vector<double> cumulative_area(faces.size());
+  double area = 0.0;
+  for (std::size_t i = 0; i < faces.size(); ++i)
+    cumulative_area[i] = area += faces[i].area;
+
+  // Every chunk of points has its own random sequence, so the cloud does not depend on how the
+  // chunks are spread over threads
+  cloud.points.resize(part.target_points);
+  const long size = static_cast<long>(part.target_points);
+  const long chunks = (size + CHUNK_POINTS - 1) / CHUNK_POINTS;
+  std::atomic<bool> failed(false);
+
+#pragma omp parallel for schedule(dynamic)
+  for (long c = 0; c < chunks; ++c)
+  {
+    std::seed_seq seed{part.seed, static_cast<unsigned>(c)};
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> pick(0.0, area);
+    std::normal_distribution<double> noise(0.0, part.noise > 0.0 ? part.noise : 1.0);
+
+    for (long i = c * CHUNK_POINTS; i < std::min(size, (c + 1) * CHUNK_POINTS) && !failed; ++i)
+    {
+      Eigen::Vector3d p, n;
+      std::size_t face;
+      int rejections = 0;
+      do
+      {
+        face = std::lower_bound(cumulative_area.begin(), cumulative_area.end(), pick(rng)) -
+               cumulative_area.begin();
+        face = std::min(face, faces.size() - 1);
+        sampleFace(faces[face], solids[faces[face].primitive].primitive, rng, p, n);
+      } while (!visible(solids, faces[face].primitive, p, n) && ++rejections < MAX_REJECTIONS);
+
+      if (rejections == MAX_REJECTIONS)
+      {
+        failed = true;
+        break;
+      }
+
+      if (part.noise > 0.0)
+        p += Eigen::Vector3d(noise(rng), noise(rng), noise(rng));
+
+      LabelledPoint& point = cloud.points[i];
+      point.x = p.x();
+      point.y = p.y();
+      point.z = p.z();
+      point.label = faces[face].label;
+      setColor(point.label, point);
+    }
+  }
+
+  if (failed)
+  {
+    ROS_ERROR("The synthetic part has no visible surface: its cut-outs remove all of it");
+    cloud.clear();
+    return false;
+  }
+
+  cloud.width = cloud.points.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
+  return true;
+}
+
+void simulateView(const PartDescription& part, const CameraModel& camera,
+                  const Eigen::Affine3d& world_to_cam, unsigned seed, LabelledCloud& view)
+{
+  std::vector<Face> faces;
+  std::vector<std::string> names;
+  buildFaces(part, faces, names);
+  const std::vector<Solid> solids = buildSolids(part);
+
+  LabelledPoint nothing;
+  nothing.x = nothing.y = nothing.z = std::numeric_limits<float>::quiet_NaN();
+  nothing.r = nothing.g = nothing.b = 0;
+  nothing.label = NO_SURFACE;
+
+  view.points.assign(static_cast<std::size_t>(camera.width) * camera.height, nothing);
+  view.width = camera.width;
+  view.height = camera.height;
+  view.is_dense = false;
+  view.sensor_origin_ = Eigen::Vector4f(world_to_cam.translation().x(), world_to_cam.translation().y(),
+                                        world_to_cam.translation().z(), 0.0f);
+  view.sensor_orientation_ = Eigen::Quaternionf(Eigen::Quaterniond(world_to_cam.linear()).cast<float>());
+
+  const Eigen::Vector3d origin = world_to_cam.translation();
+  const double min_cos_incidence = std::cos(camera.max_incidence_angle);
+
+  // Rows have their own random sequence, for the same reason as generatePart()'s chunks
+#pragma omp parallel for schedule(dynamic)
+  for (int v = 0; v < camera.height; ++v)
+  {
+    std::seed_seq row_seed{seed, static_cast<unsigned>(v)};
+    std::mt19937 rng(row_seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    std::vector<Eigen::Vector3d> local_origin(solids.size()), local_direction(solids.size());
+
+    for (int u = 0; u < camera.width; ++u)
+    {
+      const Eigen::Vector3d ray_cam =
+          Eigen::Vector3d(1.0, (u - camera.cx) / camera.fx, (v - camera.cy) / camera.fy).normalized();
+      const Eigen::Vector3d ray = world_to_cam.linear() * ray_cam;
+      for (std::size_t s = 0; s < solids.size(); ++s)
+      {
+        local_origin[s] = solids[s].inverse * origin;
+        local_direction[s] = solids[s].inverse.linear() * ray;
+      }
+
+      // Nearest crossing of the ray with the part's surface
+      double nearest = std::numeric_limits<double>::infinity();
+      const Face* hit = NULL;
+      Eigen::Vector3d hit_normal;
+      for (const Face& f : faces)
+      {
+        double t[2];
+        const int count = intersectFace(f, local_origin[f.primitive], local_direction[f.primitive], t);
+        for (int k = 0; k < count; ++k)
+        {
+          if (t[k] <= 0.0 || t[k] >= nearest)
+            continue;
+          const Eigen::Vector3d p = origin + t[k] * ray;
+          Eigen::Vector3d n;
+          solids[f.primitive].boundary(p, n);
+          if (!visible(solids, f.primitive, p, n))
+            continue;
+          nearest = t[k];
+          hit = &f;
+          hit_normal = solids[f.primitive].primitive.cut ? Eigen::Vector3d(-n) : n;
+        }
+      }
+
+      // Every pixel draws the same random numbers, hit or not, so that changing one surface does
+      // not reshuffle the noise of the others
+      const double dropout = unit(rng);
+      const double range_noise = gauss(rng);
+      if (!hit)
+        continue;
+
+      const double depth = nearest * ray_cam.x();
+      if (depth < camera.min_range || depth > camera.max_range || -ray.dot(hit_normal) < min_cos_incidence ||
+          dropout < camera.dropout_rate)
+        continue;
+
+      const double sigma = camera.depth_noise + camera.depth_noise_quadratic * depth * depth;
+      const Eigen::Vector3d p = origin + (nearest + sigma * range_noise) * ray;
+      LabelledPoint& point = view.points[static_cast<std::size_t>(v) * camera.width + u];
+      point.x = p.x();
+      point.y = p.y();
+      point.z = p.z();
+      point.label = hit->label;
+      setColor(point.label, point);
+    }
+  }
+}
+
+std::vector<Eigen::Affine3d> scanCameraPoses(const godel_msgs::RobotScanParameters& params)
+{
+  std::vector<tf::Transform> world_to_cam;
+  scan::RobotScan::compute_camera_poses(params, world_to_cam);
+
+  std::vector<Eigen::Affine3d> poses(world_to_cam.size());
+  for (std::size_t i = 0; i < world_to_cam.size(); ++i)
+    tf::transformTFToEigen(world_to_cam[i], poses[i]);
+  return poses;
+}
+
+} // namespace synthetic
+} // namespace godel_surface_detection
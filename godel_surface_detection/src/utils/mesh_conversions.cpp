@@ -1,74 +1,337 @@
 #include "utils/mesh_conversions.h"
 
-void godel_surface_detection::meshToTrianglePoints(const pcl::PolygonMesh &mesh, std::vector<geometry_msgs::Point> &points)
+#include <Eigen/Core>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
 {
-  pcl::PointCloud<pcl::PointXYZ> mesh_points;
-  pcl::fromPCLPointCloud2(mesh.cloud, mesh_points);
+struct CellKey
+{
+  int64_t x, y, z;
+  bool operator==(const CellKey& other) const { return x == other.x && y == other.y && z == other.z; }
+};
 
-  auto add_point = [&mesh_points](uint32_t idx)
+struct CellKeyHash
+{
+  std::size_t operator()(const CellKey& k) const
   {
-    geometry_msgs::Point p;
-    p.x = mesh_points.points[idx].x;
-    p.y = mesh_points.points[idx].y;
-    p.z = mesh_points.points[idx].z;
-    return p;
-  };
+    // Large primes from "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+    return static_cast<std::size_t>(k.x * 73856093) ^ static_cast<std::size_t>(k.y * 19349663) ^
+           static_cast<std::size_t>(k.z * 83492791);
+  }
+};
 
-  for (std::size_t i = 0; i < mesh.polygons.size(); ++i)
+struct TriangleKeyHash
+{
+  std::size_t operator()(const std::array<uint32_t, 3>& t) const
   {
-    const pcl::Vertices& v = mesh.polygons[i];
+    return (static_cast<std::size_t>(t[0]) * 73856093) ^ (static_cast<std::size_t>(t[1]) * 19349663) ^
+           (static_cast<std::size_t>(t[2]) * 83492791);
+  }
+};
+
+CellKey cellOf(const geometry_msgs::Point& p, double cell_size)
+{
+  return CellKey{static_cast<int64_t>(std::floor(p.x / cell_size)),
+                 static_cast<int64_t>(std::floor(p.y / cell_size)),
+                 static_cast<int64_t>(std::floor(p.z / cell_size))};
+}
+
+double squaredDistance(const geometry_msgs::Point& a, const geometry_msgs::Point& b)
+{
+  const double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+  return dx * dx + dy * dy + dz * dz;
+}
 
+/**
+ * Calls f(a, b, c) for every triangle of the mesh, splitting quads in two.
+ */
+template <typename Func> void forEachTriangle(const pcl::PolygonMesh& mesh, const std::string& caller, Func f)
+{
+  for (const pcl::Vertices& v : mesh.polygons)
+  {
     // We currently support 3 and 4-gon meshes
     if (v.vertices.size() == 3)
     {
-      points.push_back(add_point(v.vertices[0]));
-      points.push_back(add_point(v.vertices[1]));
-      points.push_back(add_point(v.vertices[2]));
+      f(v.vertices[0], v.vertices[1], v.vertices[2]);
     }
     else if (v.vertices.size() == 4)
     {
-      auto v1 = v.vertices[0];
-      auto v2 = v.vertices[1];
-      auto v3 = v.vertices[2];
-      auto v4 = v.vertices[3];
-
-      // Add triangle 1
-      points.push_back(add_point(v1));
-      points.push_back(add_point(v2));
-      points.push_back(add_point(v3));
-
-      // triangle 2
-      points.push_back(add_point(v3));
-      points.push_back(add_point(v4));
-      points.push_back(add_point(v1));
+      f(v.vertices[0], v.vertices[1], v.vertices[2]);
+      f(v.vertices[2], v.vertices[3], v.vertices[0]);
     }
     else
     {
       const auto sz = std::to_string(v.vertices.size());
-      throw std::invalid_argument("meshToTrianglePoints(): passed polygon w/ " + sz + " vertices. Only supports 3 and 4.");
+      throw std::invalid_argument(caller + "(): passed polygon w/ " + sz + " vertices. Only supports 3 and 4.");
     }
-  } // end of vertex loop
+  }
 }
 
-void godel_surface_detection::trianglePointsToMesh(const std::vector<geometry_msgs::Point> &points, pcl::PolygonMesh &mesh)
+/**
+ * Maps points to vertex indices, merging points within 'tolerance' of an existing vertex.
+ */
+class VertexWelder
 {
-  pcl::PointCloud<pcl::PointXYZ> mesh_points;
+public:
+  VertexWelder(double tolerance, std::vector<geometry_msgs::Point>& vertices)
+    : tolerance_(tolerance), vertices_(vertices)
+  {
+  }
 
-  for (std::size_t i = 0; i < points.size(); i += 3)
+  uint32_t add(const geometry_msgs::Point& p)
   {
-    pcl::Vertices v;
-    for (int j = 0; j < 3; j++)
+    if (tolerance_ <= 0.0)
     {
-      v.vertices.push_back(i + j);
+      const std::array<double, 3> key = {{p.x, p.y, p.z}};
+      auto it = exact_.find(key);
+      if (it != exact_.end())
+        return it->second;
+      const uint32_t idx = push(p);
+      exact_[key] = idx;
+      return idx;
+    }
+
+    const CellKey c = cellOf(p, tolerance_);
+    const double tol2 = tolerance_ * tolerance_;
+    for (int64_t dx = -1; dx <= 1; ++dx)
+      for (int64_t dy = -1; dy <= 1; ++dy)
+        for (int64_t dz = -1; dz <= 1; ++dz)
+        {
+          auto it = cells_.find(CellKey{c.x + dx, c.y + dy, c.z + dz});
+          if (it == cells_.end())
+            continue;
+          for (uint32_t idx : it->second)
+            if (squaredDistance(vertices_[idx], p) <= tol2)
+              return idx;
+        }
+
+    const uint32_t idx = push(p);
+    cells_[c].push_back(idx);
+    return idx;
+  }
 
-      pcl::PointXYZ p;
-      p.x = points[i + j].x;
-      p.y = points[i + j].y;
-      p.z = points[i + j].z;
-      mesh_points.points.push_back(p);
+private:
+  uint32_t push(const geometry_msgs::Point& p)
+  {
+    vertices_.push_back(p);
+    return static_cast<uint32_t>(vertices_.size() - 1);
+  }
+
+  double tolerance_;
+  std::vector<geometry_msgs::Point>& vertices_;
+  std::unordered_map<CellKey, std::vector<uint32_t>, CellKeyHash> cells_;
+  std::map<std::array<double, 3>, uint32_t> exact_;
+};
+
+shape_msgs::MeshTriangle makeTriangle(uint32_t a, uint32_t b, uint32_t c)
+{
+  shape_msgs::MeshTriangle t;
+  t.vertex_indices[0] = a;
+  t.vertex_indices[1] = b;
+  t.vertex_indices[2] = c;
+  return t;
+}
+}
+
+godel_surface_detection::PointCloud2XYZView::PointCloud2XYZView(const pcl::PCLPointCloud2& cloud)
+  : data_(cloud.data.data()), size_(cloud.width * cloud.height), point_step_(cloud.point_step)
+{
+  static const char* names[3] = {"x", "y", "z"};
+  for (int i = 0; i < 3; ++i)
+  {
+    auto field = std::find_if(cloud.fields.begin(), cloud.fields.end(),
+                              [i](const pcl::PCLPointField& f) { return f.name == names[i]; });
+    if (field == cloud.fields.end() || field->datatype != pcl::PCLPointField::FLOAT32)
+    {
+      throw std::invalid_argument(std::string("PointCloud2XYZView(): cloud has no FLOAT32 field '") + names[i] + "'");
     }
+    offsets_[i] = field->offset;
+  }
+
+  if (cloud.data.size() < size_ * point_step_)
+  {
+    throw std::invalid_argument("PointCloud2XYZView(): cloud data is smaller than width * height * point_step");
+  }
+}
+
+void godel_surface_detection::meshToTrianglePoints(const pcl::PolygonMesh &mesh, std::vector<geometry_msgs::Point> &points)
+{
+  const PointCloud2XYZView mesh_points(mesh.cloud);
+
+  points.reserve(points.size() + 3 * mesh.polygons.size());
+  forEachTriangle(mesh, "meshToTrianglePoints", [&](uint32_t a, uint32_t b, uint32_t c) {
+    points.push_back(mesh_points[a]);
+    points.push_back(mesh_points[b]);
+    points.push_back(mesh_points[c]);
+  });
+}
+
+void godel_surface_detection::trianglePointsToMesh(const std::vector<geometry_msgs::Point> &points, pcl::PolygonMesh &mesh)
+{
+  shape_msgs::Mesh indexed;
+  trianglePointsToIndexedMesh(points, 0.0, indexed);
+  indexedMeshToMesh(indexed, mesh);
+}
+
+void godel_surface_detection::meshToDecimatedTrianglePoints(const pcl::PolygonMesh& mesh, double cell_size,
+                                                            std::vector<geometry_msgs::Point>& points)
+{
+  if (cell_size <= 0.0)
+  {
+    meshToTrianglePoints(mesh, points);
+    return;
+  }
+
+  const PointCloud2XYZView mesh_points(mesh.cloud);
+
+  // Cluster vertices by cell; cluster_of maps a mesh vertex to its cluster index
+  std::unordered_map<CellKey, uint32_t, CellKeyHash> cells;
+  std::vector<uint32_t> cluster_of(mesh_points.size());
+  std::vector<Eigen::Vector3d> sums;
+  std::vector<int> counts;
+
+  for (std::size_t i = 0; i < mesh_points.size(); ++i)
+  {
+    const geometry_msgs::Point p = mesh_points[i];
+    auto it = cells.find(cellOf(p, cell_size));
+    if (it == cells.end())
+    {
+      it = cells.insert(std::make_pair(cellOf(p, cell_size), static_cast<uint32_t>(sums.size()))).first;
+      sums.push_back(Eigen::Vector3d::Zero());
+      counts.push_back(0);
+    }
+    cluster_of[i] = it->second;
+    sums[it->second] += Eigen::Vector3d(p.x, p.y, p.z);
+    counts[it->second]++;
+  }
+
+  std::vector<geometry_msgs::Point> centroids(sums.size());
+  for (std::size_t i = 0; i < sums.size(); ++i)
+  {
+    const Eigen::Vector3d c = sums[i] / counts[i];
+    centroids[i].x = c.x();
+    centroids[i].y = c.y();
+    centroids[i].z = c.z();
+  }
+
+  std::unordered_set<std::array<uint32_t, 3>, TriangleKeyHash> emitted;
+  forEachTriangle(mesh, "meshToDecimatedTrianglePoints", [&](uint32_t a, uint32_t b, uint32_t c) {
+    a = cluster_of[a];
+    b = cluster_of[b];
+    c = cluster_of[c];
+    if (a == b || b == c || a == c)
+      return; // collapsed
+
+    // Rotate so the smallest index is first; this keeps winding while identifying duplicates
+    std::array<uint32_t, 3> key = {{a, b, c}};
+    std::rotate(key.begin(), std::min_element(key.begin(), key.end()), key.end());
+    if (!emitted.insert(key).second)
+      return;
+
+    points.push_back(centroids[a]);
+    points.push_back(centroids[b]);
+    points.push_back(centroids[c]);
+  });
+}
+
+void godel_surface_detection::meshToIndexedMesh(const pcl::PolygonMesh& mesh, shape_msgs::Mesh& indexed,
+                                                double weld_tolerance)
+{
+  const PointCloud2XYZView mesh_points(mesh.cloud);
+
+  indexed.vertices.resize(mesh_points.size());
+  for (std::size_t i = 0; i < mesh_points.size(); ++i)
+    indexed.vertices[i] = mesh_points[i];
+
+  indexed.triangles.clear();
+  indexed.triangles.reserve(mesh.polygons.size());
+  forEachTriangle(mesh, "meshToIndexedMesh", [&](uint32_t a, uint32_t b, uint32_t c) {
+    indexed.triangles.push_back(makeTriangle(a, b, c));
+  });
+
+  if (weld_tolerance > 0.0)
+    weldVertices(indexed, weld_tolerance);
+}
+
+void godel_surface_detection::indexedMeshToMesh(const shape_msgs::Mesh& indexed, pcl::PolygonMesh& mesh)
+{
+  pcl::PointCloud<pcl::PointXYZ> mesh_points;
+  mesh_points.reserve(indexed.vertices.size());
+  for (const auto& v : indexed.vertices)
+    mesh_points.push_back(pcl::PointXYZ(v.x, v.y, v.z));
+
+  mesh.polygons.clear();
+  mesh.polygons.reserve(indexed.triangles.size());
+  for (const auto& t : indexed.triangles)
+  {
+    pcl::Vertices v;
+    v.vertices.assign(t.vertex_indices.begin(), t.vertex_indices.end());
     mesh.polygons.push_back(v);
   }
 
   pcl::toPCLPointCloud2(mesh_points, mesh.cloud);
 }
+
+void godel_surface_detection::trianglePointsToIndexedMesh(const std::vector<geometry_msgs::Point>& points,
+                                                          double tolerance, shape_msgs::Mesh& indexed)
+{
+  indexed.vertices.clear();
+  indexed.triangles.clear();
+  indexed.triangles.reserve(points.size() / 3);
+
+  VertexWelder welder(tolerance, indexed.vertices);
+  for (std::size_t i = 0; i + 2 < points.size(); i += 3)
+  {
+    const uint32_t a = welder.add(points[i]);
+    const uint32_t b = welder.add(points[i + 1]);
+    const uint32_t c = welder.add(points[i + 2]);
+    if (tolerance > 0.0 && (a == b || b == c || a == c))
+      continue; // collapsed by welding
+    indexed.triangles.push_back(makeTriangle(a, b, c));
+  }
+}
+
+void godel_surface_detection::indexedMeshToTrianglePoints(const shape_msgs::Mesh& indexed,
+                                                          std::vector<geometry_msgs::Point>& points)
+{
+  points.reserve(points.size() + 3 * indexed.triangles.size());
+  for (const auto& t : indexed.triangles)
+  {
+    points.push_back(indexed.vertices[t.vertex_indices[0]]);
+    points.push_back(indexed.vertices[t.vertex_indices[1]]);
+    points.push_back(indexed.vertices[t.vertex_indices[2]]);
+  }
+}
+
+std::size_t godel_surface_detection::weldVertices(shape_msgs::Mesh& indexed, double tolerance)
+{
+  std::vector<geometry_msgs::Point> welded;
+  std::vector<uint32_t> remap(indexed.vertices.size());
+  {
+    VertexWelder welder(tolerance, welded);
+    for (std::size_t i = 0; i < indexed.vertices.size(); ++i)
+      remap[i] = welder.add(indexed.vertices[i]);
+  }
+
+  std::vector<shape_msgs::MeshTriangle> triangles;
+  triangles.reserve(indexed.triangles.size());
+  for (const auto& t : indexed.triangles)
+  {
+    const uint32_t a = remap[t.vertex_indices[0]];
+    const uint32_t b = remap[t.vertex_indices[1]];
+    const uint32_t c = remap[t.vertex_indices[2]];
+    if (a != b && b != c && a != c)
+      triangles.push_back(makeTriangle(a, b, c));
+  }
+
+  const std::size_t removed = indexed.vertices.size() - welded.size();
+  indexed.vertices.swap(welded);
+  indexed.triangles.swap(triangles);
+  return removed;
+}
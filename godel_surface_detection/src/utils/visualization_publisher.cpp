@@ -0,0 +1,130 @@
+#include "utils/visualization_publisher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+struct VoxelKey
+{
+  int64_t x, y, z;
+  bool operator==(const VoxelKey& other) const { return x == other.x && y == other.y && z == other.z; }
+};
+
+struct VoxelKeyHash
+{
+  std::size_t operator()(const VoxelKey& k) const
+  {
+    return static_cast<std::size_t>(k.x * 73856093) ^ static_cast<std::size_t>(k.y * 19349663) ^
+           static_cast<std::size_t>(k.z * 83492791);
+  }
+};
+
+struct Voxel
+{
+  double x, y, z;
+  std::size_t count;
+  uint32_t rgb;
+};
+
+// Smallest factor the voxel size grows by while the result is over budget
+const static double MIN_LEAF_GROWTH = 1.05;
+const static int MAX_LOD_ITERATIONS = 32;
+
+void voxelize(const pcl::PointCloud<pcl::PointXYZRGB>& input, double leaf,
+              pcl::PointCloud<pcl::PointXYZRGB>& output)
+{
+  std::unordered_map<VoxelKey, std::size_t, VoxelKeyHash> index;
+  std::vector<Voxel> voxels;
+  index.reserve(input.size() / 4);
+
+  const double inv_leaf = 1.0 / leaf;
+  for (const auto& pt : input)
+  {
+    if (!pcl::isFinite(pt))
+      continue;
+
+    const VoxelKey key{static_cast<int64_t>(std::floor(pt.x * inv_leaf)),
+                       static_cast<int64_t>(std::floor(pt.y * inv_leaf)),
+                       static_cast<int64_t>(std::floor(pt.z * inv_leaf))};
+    auto it = index.find(key);
+    if (it == index.end())
+    {
+      index.emplace(key, voxels.size());
+      voxels.push_back(Voxel{pt.x, pt.y, pt.z, 1, pt.rgba});
+    }
+    else
+    {
+      Voxel& v = voxels[it->second];
+      v.x += pt.x;
+      v.y += pt.y;
+      v.z += pt.z;
+      v.count++;
+    }
+  }
+
+  output.clear();
+  output.reserve(voxels.size());
+  for (const auto& v : voxels)
+  {
+    pcl::PointXYZRGB pt;
+    pt.x = v.x / v.count;
+    pt.y = v.y / v.count;
+    pt.z = v.z / v.count;
+    pt.rgba = v.rgb;
+    output.push_back(pt);
+  }
+}
+}
+
+double godel_surface_detection::visualization::downsampleForDisplay(const pcl::PointCloud<pcl::PointXYZRGB>& input,
+                                                                  std::size_t point_budget, double min_leaf_size,
+                                                                  pcl::PointCloud<pcl::PointXYZRGB>& output)
+{
+  const pcl::PCLHeader header = input.header;
+
+  if (min_leaf_size <= 0.0 && (point_budget == 0 || input.size() <= point_budget))
+  {
+    output = input;
+    return 0.0;
+  }
+
+  // Without a minimum voxel size, start from 1mm and let the budget loop grow it
+  double leaf = min_leaf_size > 0.0 ? min_leaf_size : 0.001;
+  voxelize(input, leaf, output);
+
+  // Scanned parts are surfaces, so the point count falls roughly with the square of the voxel
+  // size; jump straight to the estimate and only creep up from there.
+  for (int i = 0; point_budget > 0 && output.size() > point_budget && i < MAX_LOD_ITERATIONS; ++i)
+  {
+    leaf *= std::max(MIN_LEAF_GROWTH, std::sqrt(static_cast<double>(output.size()) / point_budget));
+    voxelize(input, leaf, output);
+  }
+
+  output.header = header;
+  output.width = output.size();
+  output.height = 1;
+  output.is_dense = true;
+  return leaf;
+}
+
+void godel_surface_detection::visualization::decimatePoses(geometry_msgs::PoseArray& poses, std::size_t max_poses)
+{
+  if (max_poses == 0 || poses.poses.size() <= max_poses)
+    return;
+
+  if (max_poses == 1)
+  {
+    poses.poses.erase(poses.poses.begin(), poses.poses.end() - 1);
+    return;
+  }
+
+  const std::size_t stride = (poses.poses.size() + max_poses - 2) / (max_poses - 1);
+  std::vector<geometry_msgs::Pose> kept;
+  kept.reserve(max_poses);
+  for (std::size_t i = 0; i < poses.poses.size() - 1; i += stride)
+    kept.push_back(poses.poses[i]);
+  kept.push_back(poses.poses.back());
+  poses.poses.swap(kept);
+}
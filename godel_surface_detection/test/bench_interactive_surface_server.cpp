@@ -0,0 +1,128 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Measures the marker traffic and server-side latency of "Select All" on 50 dense surfaces.
+ * Requires a running roscore:
+ *   rosrun godel_surface_detection bench_interactive_surface_server
+ */
+
+#include <benchmark/benchmark.h>
+#include <interactive/interactive_surface_server.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <visualization_msgs/InteractiveMarkerUpdate.h>
+
+namespace
+{
+
+const static int NUM_SURFACES = 50;
+const static int GRID_SIZE = 150; // vertices per side, 1mm apart
+
+std::atomic<uint64_t> update_bytes(0);
+
+void updateCallback(const visualization_msgs::InteractiveMarkerUpdateConstPtr& msg)
+{
+  update_bytes += ros::serialization::serializationLength(*msg);
+}
+
+pcl::PolygonMesh makeGridMesh(int n, double spacing, double x0)
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      cloud.push_back(pcl::PointXYZ(x0 + i * spacing, j * spacing, 0.0));
+
+  pcl::PolygonMesh mesh;
+  pcl::toPCLPointCloud2(cloud, mesh.cloud);
+  mesh.header.frame_id = "world_frame";
+  for (int i = 0; i + 1 < n; ++i)
+  {
+    for (int j = 0; j + 1 < n; ++j)
+    {
+      pcl::Vertices quad;
+      quad.vertices = {static_cast<uint32_t>(i * n + j), static_cast<uint32_t>((i + 1) * n + j),
+                       static_cast<uint32_t>((i + 1) * n + j + 1), static_cast<uint32_t>(i * n + j + 1)};
+      mesh.polygons.push_back(quad);
+    }
+  }
+  return mesh;
+}
+
+// Waits until the update stream has been quiet for a moment
+void drainUpdates()
+{
+  uint64_t last = update_bytes;
+  do
+  {
+    last = update_bytes;
+    ros::Duration(0.2).sleep();
+  } while (last != update_bytes);
+}
+
+} // end anon namespace
+
+// range(0): decimation cell size in micrometres, 0 disables decimation
+static void BM_SelectAll(benchmark::State& state)
+{
+  using godel_surface_detection::interactive::InteractiveSurfaceServer;
+  namespace params = godel_surface_detection::interactive::params;
+  namespace defaults = godel_surface_detection::interactive::defaults;
+
+  ros::NodeHandle ph("~/" + params::PARAMETER_NS);
+  ph.setParam(params::DECIMATION_CELL_SIZE, state.range(0) * 1e-6);
+
+  InteractiveSurfaceServer server;
+  server.init();
+  server.run();
+
+  ros::NodeHandle nh;
+  ros::Subscriber sub = nh.subscribe(defaults::MARKER_SERVER_NAME + "/update", 1000, updateCallback);
+  ros::Duration(1.0).sleep(); // let the subscription connect
+
+  update_bytes = 0;
+  for (int i = 0; i < NUM_SURFACES; ++i)
+    server.add_surface(i, makeGridMesh(GRID_SIZE, 0.001, 0.2 * i));
+  server.apply_pending_changes();
+  drainUpdates();
+  state.counters["add_bytes"] = update_bytes;
+
+  update_bytes = 0;
+  bool select = true;
+  for (auto _ : state)
+  {
+    server.select_all(select);
+    server.apply_pending_changes();
+    select = !select;
+  }
+  drainUpdates();
+  state.counters["select_all_bytes"] = static_cast<double>(update_bytes) / state.iterations();
+
+  server.stop();
+}
+BENCHMARK(BM_SelectAll)->Arg(0)->Arg(5000)->Iterations(20)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "bench_interactive_surface_server");
+  ros::AsyncSpinner spinner(2);
+  spinner.start();
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
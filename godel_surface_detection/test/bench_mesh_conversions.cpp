@@ -0,0 +1,156 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Conversion time and serialized message size of flattened triangle lists versus indexed
+ * (shared-vertex) meshes. The "bytes" counter is the ROS serialization length of the result.
+ */
+
+#include <benchmark/benchmark.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <utils/mesh_conversions.h>
+#include <visualization_msgs/Marker.h>
+
+namespace
+{
+
+pcl::PolygonMesh makeGridMesh(int n, double spacing)
+{
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+    {
+      pcl::PointXYZRGB p;
+      p.x = i * spacing;
+      p.y = j * spacing;
+      p.z = 0.0f;
+      cloud.push_back(p);
+    }
+
+  pcl::PolygonMesh mesh;
+  pcl::toPCLPointCloud2(cloud, mesh.cloud);
+  for (int i = 0; i + 1 < n; ++i)
+  {
+    for (int j = 0; j + 1 < n; ++j)
+    {
+      pcl::Vertices quad;
+      quad.vertices = {static_cast<uint32_t>(i * n + j), static_cast<uint32_t>((i + 1) * n + j),
+                       static_cast<uint32_t>((i + 1) * n + j + 1), static_cast<uint32_t>(i * n + j + 1)};
+      mesh.polygons.push_back(quad);
+    }
+  }
+  return mesh;
+}
+
+// Reference implementation: the full blob conversion used before PointCloud2XYZView
+void meshToTrianglePointsPcl(const pcl::PolygonMesh& mesh, std::vector<geometry_msgs::Point>& points)
+{
+  pcl::PointCloud<pcl::PointXYZ> mesh_points;
+  pcl::fromPCLPointCloud2(mesh.cloud, mesh_points);
+  for (const pcl::Vertices& v : mesh.polygons)
+  {
+    const std::size_t n = v.vertices.size();
+    const uint32_t idx[6] = {v.vertices[0], v.vertices[1], v.vertices[2],
+                             v.vertices[2], v.vertices[n == 4 ? 3 : 0], v.vertices[0]};
+    for (std::size_t k = 0; k < (n == 4 ? 6u : 3u); ++k)
+    {
+      geometry_msgs::Point p;
+      p.x = mesh_points[idx[k]].x;
+      p.y = mesh_points[idx[k]].y;
+      p.z = mesh_points[idx[k]].z;
+      points.push_back(p);
+    }
+  }
+}
+
+void BM_TriangleListPcl(benchmark::State& state)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(state.range(0), 0.001);
+  visualization_msgs::Marker marker;
+  for (auto _ : state)
+  {
+    marker.points.clear();
+    meshToTrianglePointsPcl(mesh, marker.points);
+    benchmark::DoNotOptimize(marker.points.data());
+  }
+  state.counters["bytes"] = ros::serialization::serializationLength(marker);
+}
+
+void BM_TriangleListView(benchmark::State& state)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(state.range(0), 0.001);
+  visualization_msgs::Marker marker;
+  for (auto _ : state)
+  {
+    marker.points.clear();
+    godel_surface_detection::meshToTrianglePoints(mesh, marker.points);
+    benchmark::DoNotOptimize(marker.points.data());
+  }
+  state.counters["bytes"] = ros::serialization::serializationLength(marker);
+}
+
+void BM_IndexedMesh(benchmark::State& state)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(state.range(0), 0.001);
+  shape_msgs::Mesh indexed;
+  for (auto _ : state)
+  {
+    godel_surface_detection::meshToIndexedMesh(mesh, indexed);
+    benchmark::DoNotOptimize(indexed.vertices.data());
+  }
+  state.counters["bytes"] = ros::serialization::serializationLength(indexed);
+}
+
+void BM_TrianglePointsToMesh(benchmark::State& state)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(state.range(0), 0.001);
+  std::vector<geometry_msgs::Point> points;
+  godel_surface_detection::meshToTrianglePoints(mesh, points);
+
+  for (auto _ : state)
+  {
+    pcl::PolygonMesh restored;
+    godel_surface_detection::trianglePointsToMesh(points, restored);
+    benchmark::DoNotOptimize(restored.polygons.data());
+  }
+}
+
+void BM_WeldTrianglePoints(benchmark::State& state)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(state.range(0), 0.001);
+  std::vector<geometry_msgs::Point> points;
+  godel_surface_detection::meshToTrianglePoints(mesh, points);
+
+  shape_msgs::Mesh indexed;
+  for (auto _ : state)
+  {
+    godel_surface_detection::trianglePointsToIndexedMesh(points, 1e-5, indexed);
+    benchmark::DoNotOptimize(indexed.vertices.data());
+  }
+  state.counters["bytes"] = ros::serialization::serializationLength(indexed);
+}
+
+} // end anon namespace
+
+BENCHMARK(BM_TriangleListPcl)->Arg(50)->Arg(150)->Arg(500)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TriangleListView)->Arg(50)->Arg(150)->Arg(500)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IndexedMesh)->Arg(50)->Arg(150)->Arg(500)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TrianglePointsToMesh)->Arg(50)->Arg(150)->Arg(500)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_WeldTrianglePoints)->Arg(50)->Arg(150)->Arg(500)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,135 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * pcl::NormalEstimationOMP, as segmentation used it, against the closed form kernel, both on
+ * every core. The argument is the number of points. The parts grow with it, so that the points
+ * stay as far apart as after the detection's voxel filter and every point has as many neighbours
+ * within the radius as in a real scan.
+ */
+
+#include <benchmark/benchmark.h>
+#include <segmentation/normal_estimation.h>
+#include <synthetic/synthetic_workload.h>
+
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/search/kdtree.h>
+
+#include <cmath>
+#include <map>
+#include <thread>
+
+using namespace godel_surface_detection;
+
+namespace
+{
+
+typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+
+// The defaults of detection
+const static double NORMAL_RADIUS = 0.025;
+const static double VOXEL_LEAF_SIZE = 0.0015;
+
+/**
+ * @brief A box with a cylinder and a ball on top, scaled to hold 'points' points one voxel apart
+ */
+CloudRGB::Ptr makeCloud(int points)
+{
+  static std::map<int, CloudRGB::Ptr> clouds;
+  CloudRGB::Ptr& cloud = clouds[points];
+  if (cloud)
+    return cloud;
+
+  // The surface of the part at a scale of 1, without the faces that touch
+  const double unit_area = 2.3;
+  const double scale = std::sqrt(points * VOXEL_LEAF_SIZE * VOXEL_LEAF_SIZE / unit_area);
+
+  synthetic::Primitive box, cylinder, ball;
+  box.type = synthetic::BOX;
+  box.pose = Eigen::Translation3d(0.0, 0.0, 0.1 * scale);
+  box.size = Eigen::Vector3d(1.0, 0.6, 0.2) * scale;
+  box.cut = false;
+  cylinder.type = synthetic::CYLINDER;
+  cylinder.pose = Eigen::Translation3d(-0.2 * scale, 0.0, 0.3 * scale);
+  cylinder.size = Eigen::Vector3d(0.15, 0.15, 0.2) * scale;
+  cylinder.cut = false;
+  ball.type = synthetic::SPHERE;
+  ball.pose = Eigen::Translation3d(0.3 * scale, 0.0, 0.3 * scale);
+  ball.size = Eigen::Vector3d::Constant(0.1 * scale);
+  ball.cut = false;
+
+  synthetic::PartDescription part;
+  part.primitives = {box, cylinder, ball};
+  part.target_points = points;
+  part.noise = 0.0005;
+  part.seed = 0;
+
+  synthetic::LabelledCloud labelled;
+  synthetic::generatePart(part, labelled);
+  cloud.reset(new CloudRGB());
+  for (const auto& pt : labelled.points)
+  {
+    pcl::PointXYZRGB p;
+    p.x = pt.x;
+    p.y = pt.y;
+    p.z = pt.z;
+    cloud->push_back(p);
+  }
+  // A scanner above the part
+  cloud->sensor_origin_ = Eigen::Vector4f(0.0f, 0.0f, 2.0f * scale, 0.0f);
+  return cloud;
+}
+
+void BM_PclNormals(benchmark::State& state)
+{
+  const CloudRGB::Ptr cloud = makeCloud(state.range(0));
+  pcl::NormalEstimationOMP<pcl::PointXYZRGB, pcl::Normal> ne;
+  ne.setNumberOfThreads(std::thread::hardware_concurrency());
+  ne.setInputCloud(cloud);
+  ne.setSearchMethod(pcl::search::KdTree<pcl::PointXYZRGB>::Ptr(new pcl::search::KdTree<pcl::PointXYZRGB>()));
+  ne.setRadiusSearch(NORMAL_RADIUS);
+
+  pcl::PointCloud<pcl::Normal> normals;
+  for (auto _ : state)
+  {
+    ne.compute(normals);
+    benchmark::DoNotOptimize(normals.points.data());
+  }
+  state.counters["points"] = cloud->size();
+}
+
+void BM_ClosedFormNormals(benchmark::State& state)
+{
+  const CloudRGB::Ptr cloud = makeCloud(state.range(0));
+  pcl::PointCloud<pcl::Normal> normals;
+  for (auto _ : state)
+  {
+    estimateNormals(*cloud, NORMAL_RADIUS, 0, normals);
+    benchmark::DoNotOptimize(normals.points.data());
+  }
+  state.counters["points"] = cloud->size();
+}
+
+} // end anon namespace
+
+BENCHMARK(BM_PclNormals)->Arg(100000)->Arg(500000)->Arg(1000000)->Arg(5000000)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ClosedFormNormals)->Arg(100000)->Arg(500000)->Arg(1000000)->Arg(5000000)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,129 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Batch planning of identical parts on one fixture against planning every part on its own. Both
+ * generate the edge paths of every surface; the batch clusters the scene into parts, registers
+ * them to the first one and moves its paths onto the others instead of generating theirs. The
+ * argument is the number of parts.
+ */
+
+#include <batch/part_batch.h>
+#include <benchmark/benchmark.h>
+#include <segmentation/edge_paths.h>
+#include <synthetic/synthetic_workload.h>
+
+using namespace godel_surface_detection;
+using namespace godel_surface_detection::batch;
+
+namespace
+{
+
+// A plate with an off-center block, laid out on a grid of 30cm with a different turn each
+std::vector<Cloud::Ptr> makeScene(int parts)
+{
+  std::vector<Cloud::Ptr> scene;
+  for (int k = 0; k < parts; ++k)
+  {
+    const Eigen::Affine3d pose = Eigen::Translation3d(0.3 * (k % 4), 0.3 * (k / 4), 0.0) *
+                                 Eigen::AngleAxisd(0.7 * k, Eigen::Vector3d::UnitZ());
+
+    synthetic::Primitive plate, block;
+    plate.pose = pose * Eigen::Translation3d(0.0, 0.0, 0.01);
+    plate.size = Eigen::Vector3d(0.2, 0.12, 0.02);
+    block.pose = pose * Eigen::Translation3d(0.05, 0.02, 0.04);
+    block.size = Eigen::Vector3d(0.06, 0.05, 0.04);
+
+    synthetic::PartDescription part;
+    part.primitives.push_back(plate);
+    part.primitives.push_back(block);
+    part.target_points = 40000;
+    part.seed = k;
+
+    synthetic::LabelledCloud cloud;
+    synthetic::generatePart(part, cloud);
+    const std::vector<std::string> names = synthetic::surfaceNames(part);
+
+    // Bottom faces lie on the fixture and aren't scanned
+    std::vector<Cloud::Ptr> surfaces(names.size());
+    for (auto& s : surfaces)
+      s.reset(new Cloud);
+    for (const auto& pt : cloud.points)
+    {
+      pcl::PointXYZRGB p;
+      p.x = pt.x;
+      p.y = pt.y;
+      p.z = pt.z;
+      surfaces[pt.label - 1]->push_back(p);
+    }
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+      if (surfaces[i]->size() >= 100 && names[i].find("/-z") == std::string::npos)
+        scene.push_back(surfaces[i]);
+    }
+  }
+  return scene;
+}
+
+void BM_PlanEachPart(benchmark::State& state)
+{
+  const std::vector<Cloud::Ptr> scene = makeScene(state.range(0));
+  for (auto _ : state)
+  {
+    std::vector<geometry_msgs::PoseArray> paths;
+    for (const auto& surface : scene)
+      generateEdgePaths(surface, paths);
+    benchmark::DoNotOptimize(paths.data());
+  }
+}
+
+void BM_PlanBatch(benchmark::State& state)
+{
+  const std::vector<Cloud::Ptr> scene = makeScene(state.range(0));
+  const std::vector<Cloud::ConstPtr> surfaces(scene.begin(), scene.end());
+  std::size_t reused = 0;
+  for (auto _ : state)
+  {
+    const PartBatch batch = planBatch(surfaces, BatchParameters(), Eigen::Vector3d::Zero());
+
+    std::vector<std::vector<geometry_msgs::PoseArray>> part_paths(batch.parts.size());
+    for (std::size_t k = 0; k < batch.parts.size(); ++k)
+    {
+      if (batch.reference[k] < 0)
+      {
+        for (std::size_t s : batch.parts[k])
+          generateEdgePaths(scene[s], part_paths[k]);
+      }
+      else
+      {
+        part_paths[k] = part_paths[batch.reference[k]];
+        transformPaths(batch.registrations[k].transform, part_paths[k]);
+        ++reused;
+      }
+    }
+    benchmark::DoNotOptimize(part_paths.data());
+  }
+  state.counters["reused_parts"] = benchmark::Counter(reused, benchmark::Counter::kAvgIterations);
+}
+
+} // end anon namespace
+
+BENCHMARK(BM_PlanEachPart)->Arg(1)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PlanBatch)->Arg(1)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
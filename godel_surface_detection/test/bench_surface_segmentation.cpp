@@ -0,0 +1,463 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Stage-by-stage timings of surface segmentation and boundary extraction, plus the complete
+ * SurfaceDetection::find_surfaces().
+ *
+ * Every stage runs against synthetic clouds of increasing density and against any recorded
+ * clouds given on the command line:
+ *
+ *   bench_surface_segmentation [benchmark flags] [cloud.pcd ...]
+ *
+ * The process_cloud.pcd files written by the blending service when 'save_data' is enabled are
+ * suitable inputs. Use --benchmark_out=<file> --benchmark_out_format=json to keep results for
+ * comparison between runs (e.g. with google-benchmark's tools/compare.py).
+ *
+ * BM_FindSurfacesInRegion limits find_surfaces() to a region of interest around half of the
+ * cloud, as after re-scanning one side of a part.
+ *
+ * find_surfaces() loads the meshing plugin through pluginlib and its name from the parameter
+ * server, so it is only benchmarked when a ROS master is running; launch/bench_surface_segmentation.launch
+ * starts one and sets the parameter. All other stages run without ROS.
+ */
+
+#include <benchmark/benchmark.h>
+#include <detection/surface_detection.h>
+#include <segmentation/surface_segmentation.h>
+
+#include <pcl/common/common.h>
+#include <pcl/io/pcd_io.h>
+#include <ros/ros.h>
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+namespace
+{
+typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+
+// Same as the blending service's boundary search radius
+const static double SEGMENTATION_SEARCH_RADIUS = 0.03;
+// Smoother lengths used by getBoundaryTrajectory()
+const static int POSITION_SMOOTHER_LENGTH = 13;
+const static int ORIENTATION_SMOOTHER_LENGTH = 31;
+const static double SENSOR_NOISE = 0.0005;
+// Voxel size of coarse to fine segmentation
+const static double COARSE_LEAF = 0.005;
+const static std::string MESHING_PLUGIN_PARAM = "meshing_plugin_name";
+const static std::string DEFAULT_MESHING_PLUGIN = "concave_hull_mesher::ConcaveHullMesher";
+
+// Synthetic cloud densities, in micrometers between samples
+const static int SYNTHETIC_SPACINGS[] = {3000, 2000, 1500};
+
+/**
+ * @brief A cloud that every stage is run against. 'part' is what the scanner sees and is
+ * segmented; 'surface' is a single segmented surface, the input of the boundary stages.
+ */
+struct BenchmarkSource
+{
+  std::string name;
+  CloudRGB::Ptr part;
+  CloudRGB::Ptr surface;
+};
+
+void addPoint(CloudRGB& cloud, double x, double y, double z, std::mt19937& rng)
+{
+  std::normal_distribution<double> noise(0.0, SENSOR_NOISE);
+  pcl::PointXYZRGB p;
+  p.x = x + noise(rng);
+  p.y = y + noise(rng);
+  p.z = z + noise(rng);
+  p.r = p.g = p.b = 255;
+  cloud.push_back(p);
+}
+
+void finishCloud(CloudRGB& cloud)
+{
+  cloud.width = cloud.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
+}
+
+/**
+ * @brief A 0.4 x 0.3 x 0.1 m block resting 2cm above the table: the top and the four sides are
+ * sampled, as a scan from above would see them.
+ */
+CloudRGB::Ptr makeBlockCloud(double spacing, unsigned seed)
+{
+  const double sx = 0.4, sy = 0.3, sz = 0.1, base = 0.02;
+  std::mt19937 rng(seed);
+  CloudRGB::Ptr cloud(new CloudRGB());
+
+  for (double x = 0.0; x <= sx; x += spacing)
+    for (double y = 0.0; y <= sy; y += spacing)
+      addPoint(*cloud, x, y, base + sz, rng);
+
+  for (double z = base; z < base + sz; z += spacing)
+  {
+    for (double x = 0.0; x <= sx; x += spacing)
+    {
+      addPoint(*cloud, x, 0.0, z, rng);
+      addPoint(*cloud, x, sy, z, rng);
+    }
+    for (double y = spacing; y < sy; y += spacing)
+    {
+      addPoint(*cloud, 0.0, y, z, rng);
+      addPoint(*cloud, sx, y, z, rng);
+    }
+  }
+
+  finishCloud(*cloud);
+  return cloud;
+}
+
+/**
+ * @brief A 0.3 x 0.2 m plate with a 0.08 x 0.06 m pocket through its middle, so the boundary
+ * stages see an outer and an inner contour.
+ */
+CloudRGB::Ptr makePlateCloud(double spacing, unsigned seed)
+{
+  const double sx = 0.3, sy = 0.2, hx = 0.04, hy = 0.03;
+  std::mt19937 rng(seed);
+  CloudRGB::Ptr cloud(new CloudRGB());
+
+  for (double x = 0.0; x <= sx; x += spacing)
+  {
+    for (double y = 0.0; y <= sy; y += spacing)
+    {
+      if (std::abs(x - sx / 2) < hx && std::abs(y - sy / 2) < hy)
+        continue;
+      addPoint(*cloud, x, y, 0.1, rng);
+    }
+  }
+
+  finishCloud(*cloud);
+  return cloud;
+}
+
+/**
+ * @brief Loads a recorded cloud and picks its largest segmented surface for the boundary stages.
+ * @return false if the file can't be read
+ */
+bool loadRecordedSource(const std::string& filename, BenchmarkSource& source)
+{
+  source.part.reset(new CloudRGB());
+  if (pcl::io::loadPCDFile(filename, *source.part) < 0 || source.part->empty())
+  {
+    std::cerr << "Could not load a point cloud from '" << filename << "'\n";
+    return false;
+  }
+  source.name = filename.substr(filename.find_last_of('/') + 1);
+
+  SurfaceSegmentation SS(source.part);
+  CloudRGB::Ptr colored(new CloudRGB());
+  SS.computeSegments(colored);
+  std::vector<CloudRGB::Ptr> surfaces;
+  SS.getSurfaceClouds(surfaces);
+
+  for (const auto& surface : surfaces)
+  {
+    if (!source.surface || surface->size() > source.surface->size())
+      source.surface = surface;
+  }
+  if (!source.surface)
+    std::cerr << "No surfaces were segmented in '" << filename << "'; skipping its boundary benchmarks\n";
+  return true;
+}
+
+/**
+ * @brief The state the boundary stages start from: a segmentation of one surface with its
+ * boundary points found and sorted into contours.
+ */
+struct BoundaryFixture
+{
+  std::unique_ptr<SurfaceSegmentation> SS;
+  pcl::IndicesPtr boundary_indices;
+  std::vector<pcl::IndicesPtr> sorted_boundaries;
+  int longest;
+
+  explicit BoundaryFixture(const CloudRGB::Ptr& surface)
+    : SS(new SurfaceSegmentation(surface)), boundary_indices(new std::vector<int>()), longest(0)
+  {
+    SS->setSearchRadius(SEGMENTATION_SEARCH_RADIUS);
+
+    pcl::PointCloud<pcl::Boundary>::Ptr boundary(new pcl::PointCloud<pcl::Boundary>());
+    SS->getBoundaryCloud(boundary);
+    for (std::size_t i = 0; i < boundary->size(); ++i)
+    {
+      if (boundary->points[i].boundary_point)
+        boundary_indices->push_back(i);
+    }
+
+    SS->sortBoundary(boundary_indices, sorted_boundaries);
+    for (std::size_t i = 0; i < sorted_boundaries.size(); ++i)
+    {
+      if (sorted_boundaries[i]->size() > sorted_boundaries[longest]->size())
+        longest = i;
+    }
+  }
+};
+
+void BM_Downsample(benchmark::State& state, CloudRGB::Ptr cloud)
+{
+  SurfaceSegmentation SS;
+  for (auto _ : state)
+  {
+    SS.setInputCloud(cloud);
+    benchmark::DoNotOptimize(SS.kd_tree_.get());
+  }
+  state.counters["points"] = cloud->size();
+  state.counters["downsampled"] = SS.input_cloud_downsampled_->size();
+}
+
+void BM_ComputeNormals(benchmark::State& state, CloudRGB::Ptr cloud)
+{
+  SurfaceSegmentation SS(cloud);
+  for (auto _ : state)
+    SS.computeNormals();
+  state.counters["points"] = SS.input_cloud_->size();
+}
+
+void BM_ComputeSegments(benchmark::State& state, CloudRGB::Ptr cloud)
+{
+  SurfaceSegmentation SS(cloud);
+  std::size_t segments = 0;
+  for (auto _ : state)
+  {
+    CloudRGB::Ptr colored(new CloudRGB());
+    segments = SS.computeSegments(colored).size();
+  }
+  state.counters["points"] = SS.input_cloud_->size();
+  state.counters["segments"] = segments;
+}
+
+// Normals and region growing together, at full resolution or coarse to fine
+void BM_Segment(benchmark::State& state, CloudRGB::Ptr cloud, double coarse_leaf)
+{
+  SegmentationParameters params;
+  params.coarse_leaf = coarse_leaf;
+  std::size_t segments = 0;
+  for (auto _ : state)
+  {
+    SurfaceSegmentation SS(cloud, params);
+    CloudRGB::Ptr colored(new CloudRGB());
+    segments = SS.computeSegments(colored).size();
+  }
+  state.counters["points"] = cloud->size();
+  state.counters["segments"] = segments;
+}
+
+void BM_GetBoundaryCloud(benchmark::State& state, CloudRGB::Ptr surface)
+{
+  SurfaceSegmentation SS(surface);
+  SS.setSearchRadius(SEGMENTATION_SEARCH_RADIUS);
+  for (auto _ : state)
+  {
+    pcl::PointCloud<pcl::Boundary>::Ptr boundary(new pcl::PointCloud<pcl::Boundary>());
+    SS.getBoundaryCloud(boundary);
+    benchmark::DoNotOptimize(boundary->points.data());
+  }
+  state.counters["points"] = SS.input_cloud_->size();
+}
+
+void BM_SortBoundary(benchmark::State& state, CloudRGB::Ptr surface)
+{
+  BoundaryFixture fixture(surface);
+  std::vector<pcl::IndicesPtr> sorted;
+  for (auto _ : state)
+    fixture.SS->sortBoundary(fixture.boundary_indices, sorted);
+  state.counters["boundary_points"] = fixture.boundary_indices->size();
+  state.counters["contours"] = sorted.size();
+}
+
+void BM_SmoothPointNormal(benchmark::State& state, CloudRGB::Ptr surface)
+{
+  BoundaryFixture fixture(surface);
+  if (fixture.sorted_boundaries.empty())
+  {
+    state.SkipWithError("no boundary was found");
+    return;
+  }
+
+  // The smoother's cost doesn't depend on the normals, so the surface normal is used throughout
+  std::vector<pcl::PointNormal> pts;
+  for (int idx : *fixture.sorted_boundaries[fixture.longest])
+  {
+    pcl::PointNormal pt;
+    pt.x = fixture.SS->input_cloud_->points[idx].x;
+    pt.y = fixture.SS->input_cloud_->points[idx].y;
+    pt.z = fixture.SS->input_cloud_->points[idx].z;
+    pt.normal_x = 0.0f;
+    pt.normal_y = 0.0f;
+    pt.normal_z = 1.0f;
+    pts.push_back(pt);
+  }
+
+  std::vector<pcl::PointNormal> smoothed;
+  for (auto _ : state)
+  {
+    smoothed.clear();
+    fixture.SS->smoothPointNormal(pts, smoothed, POSITION_SMOOTHER_LENGTH, ORIENTATION_SMOOTHER_LENGTH);
+    benchmark::DoNotOptimize(smoothed.data());
+  }
+  state.counters["boundary_points"] = pts.size();
+}
+
+void BM_GetBoundaryTrajectory(benchmark::State& state, CloudRGB::Ptr surface)
+{
+  BoundaryFixture fixture(surface);
+  if (fixture.sorted_boundaries.empty())
+  {
+    state.SkipWithError("no boundary was found");
+    return;
+  }
+
+  std::vector<Eigen::Matrix4d, Eigen::aligned_allocator<Eigen::Matrix4d>> poses;
+  for (auto _ : state)
+  {
+    fixture.SS->getBoundaryTrajectory(fixture.sorted_boundaries, fixture.longest, poses);
+    benchmark::DoNotOptimize(poses.data());
+  }
+  state.counters["poses"] = poses.size();
+}
+
+/**
+ * @brief A box around the half of the cloud's bounding box with the smallest x
+ */
+godel_msgs::RegionOfInterest makeHalfRegion(const CloudRGB& cloud)
+{
+  pcl::PointXYZRGB min, max;
+  pcl::getMinMax3D(cloud, min, max);
+  godel_msgs::RegionOfInterest roi;
+  roi.type = godel_msgs::RegionOfInterest::BOX;
+  roi.pose.position.x = 0.75 * min.x + 0.25 * max.x;
+  roi.pose.position.y = 0.5 * (min.y + max.y);
+  roi.pose.position.z = 0.5 * (min.z + max.z);
+  roi.pose.orientation.w = 1.0;
+  // a little larger, so the points on its faces are kept
+  roi.dimensions.x = 0.5 * (max.x - min.x) + 0.01;
+  roi.dimensions.y = max.y - min.y + 0.01;
+  roi.dimensions.z = max.z - min.z + 0.01;
+  return roi;
+}
+
+void BM_FindSurfaces(benchmark::State& state, CloudRGB::Ptr cloud, bool in_region)
+{
+  std::size_t surfaces = 0;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    godel_surface_detection::detection::SurfaceDetection detection;
+    detection.init();
+    detection.add_cloud(*cloud);
+    if (in_region)
+      detection.regions_of_interest_.push_back(makeHalfRegion(*cloud));
+    state.ResumeTiming();
+
+    if (!detection.find_surfaces())
+    {
+      state.SkipWithError("find_surfaces() failed");
+      break;
+    }
+
+    state.PauseTiming();
+    std::vector<pcl::PolygonMesh> meshes;
+    detection.get_meshes(meshes);
+    surfaces = meshes.size();
+    state.ResumeTiming();
+  }
+  state.counters["points"] = cloud->size();
+  state.counters["surfaces"] = surfaces;
+}
+
+template <typename Fn, typename... Args>
+void registerStage(const std::string& stage, const std::string& source, Fn&& fn, Args&&... args)
+{
+  benchmark::RegisterBenchmark((stage + "/" + source).c_str(), std::forward<Fn>(fn), std::forward<Args>(args)...)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime(); // normal estimation and boundary estimation are multi-threaded
+}
+
+void registerSource(const BenchmarkSource& source, bool with_find_surfaces)
+{
+  registerStage("BM_Downsample", source.name, BM_Downsample, source.part);
+  registerStage("BM_ComputeNormals", source.name, BM_ComputeNormals, source.part);
+  registerStage("BM_ComputeSegments", source.name, BM_ComputeSegments, source.part);
+  registerStage("BM_SegmentFull", source.name, BM_Segment, source.part, 0.0);
+  registerStage("BM_SegmentCoarseToFine", source.name, BM_Segment, source.part, COARSE_LEAF);
+  if (with_find_surfaces)
+  {
+    registerStage("BM_FindSurfaces", source.name, BM_FindSurfaces, source.part, false);
+    registerStage("BM_FindSurfacesInRegion", source.name, BM_FindSurfaces, source.part, true);
+  }
+
+  if (!source.surface)
+    return;
+  registerStage("BM_GetBoundaryCloud", source.name, BM_GetBoundaryCloud, source.surface);
+  registerStage("BM_SortBoundary", source.name, BM_SortBoundary, source.surface);
+  registerStage("BM_SmoothPointNormal", source.name, BM_SmoothPointNormal, source.surface);
+  registerStage("BM_GetBoundaryTrajectory", source.name, BM_GetBoundaryTrajectory, source.surface);
+}
+
+} // end anon namespace
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "bench_surface_segmentation",
+            ros::init_options::NoSigintHandler);
+  benchmark::Initialize(&argc, argv);
+
+  const bool with_find_surfaces = ros::master::check();
+  if (with_find_surfaces)
+  {
+    if (!ros::param::has("~" + MESHING_PLUGIN_PARAM))
+      ros::param::set("~" + MESHING_PLUGIN_PARAM, DEFAULT_MESHING_PLUGIN);
+  }
+  else
+  {
+    std::cerr << "No ROS master is running; BM_FindSurfaces is skipped\n";
+  }
+
+  std::vector<BenchmarkSource> sources;
+  for (int spacing_um : SYNTHETIC_SPACINGS)
+  {
+    const double spacing = spacing_um * 1e-6;
+    BenchmarkSource source;
+    source.name = "synthetic_" + std::to_string(spacing_um) + "um";
+    source.part = makeBlockCloud(spacing, spacing_um);
+    source.surface = makePlateCloud(spacing, spacing_um);
+    sources.push_back(source);
+  }
+
+  // Whatever google-benchmark didn't consume is a recorded cloud
+  for (int i = 1; i < argc; ++i)
+  {
+    BenchmarkSource source;
+    if (!loadRecordedSource(argv[i], source))
+      return 1;
+    sources.push_back(source);
+  }
+
+  for (const auto& source : sources)
+    registerSource(source, with_find_surfaces);
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
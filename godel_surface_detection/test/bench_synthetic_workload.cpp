@@ -0,0 +1,105 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Throughput of the synthetic workload generator: points per second of part generation, from a
+ * hundred thousand to tens of millions of points, and pixels per second of simulated views at
+ * common depth camera resolutions. Thread count follows OMP_NUM_THREADS.
+ */
+
+#include <benchmark/benchmark.h>
+#include <synthetic/synthetic_workload.h>
+
+using namespace godel_surface_detection::synthetic;
+
+namespace
+{
+
+// A plate with two holes, a boss and a dome: every primitive type and both boolean operations
+PartDescription makePart(std::size_t points)
+{
+  PartDescription part;
+  Primitive plate;
+  plate.pose = Eigen::Translation3d(0.0, 0.0, 0.025);
+  plate.size = Eigen::Vector3d(0.4, 0.3, 0.05);
+  part.primitives.push_back(plate);
+
+  for (double x : {-0.12, 0.12})
+  {
+    Primitive hole;
+    hole.type = CYLINDER;
+    hole.pose = Eigen::Translation3d(x, 0.0, 0.025);
+    hole.size = Eigen::Vector3d(0.03, 0.03, 0.1);
+    hole.cut = true;
+    part.primitives.push_back(hole);
+  }
+
+  Primitive boss;
+  boss.pose = Eigen::Translation3d(0.0, 0.08, 0.075);
+  boss.size = Eigen::Vector3d(0.1, 0.08, 0.05);
+  part.primitives.push_back(boss);
+
+  Primitive dome;
+  dome.type = SPHERE;
+  dome.pose = Eigen::Translation3d(0.0, -0.07, 0.05);
+  dome.size = Eigen::Vector3d(0.05, 0.05, 0.05);
+  part.primitives.push_back(dome);
+
+  part.target_points = points;
+  part.noise = 0.0003;
+  return part;
+}
+
+void BM_GeneratePart(benchmark::State& state)
+{
+  const PartDescription part = makePart(state.range(0));
+  LabelledCloud cloud;
+  for (auto _ : state)
+  {
+    generatePart(part, cloud);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SimulateView(benchmark::State& state)
+{
+  const PartDescription part = makePart(0);
+  CameraModel camera;
+  camera.width = state.range(0);
+  camera.height = state.range(1);
+  camera.fx = camera.fy = 0.8 * camera.width;
+  camera.cx = (camera.width - 1) / 2.0;
+  camera.cy = (camera.height - 1) / 2.0;
+  const Eigen::Affine3d above =
+      Eigen::Translation3d(0.0, 0.0, 0.6) * Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitY());
+
+  LabelledCloud view;
+  unsigned seed = 0;
+  for (auto _ : state)
+  {
+    simulateView(part, camera, above, seed++, view);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+} // end anon namespace
+
+BENCHMARK(BM_GeneratePart)->Arg(100000)->Arg(1000000)->Arg(10000000)->Arg(30000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SimulateView)->Args({640, 480})->Args({1280, 960})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
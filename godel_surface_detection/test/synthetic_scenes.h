@@ -0,0 +1,88 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * The scan scene the scan planning tests share: a plate with a boss on a table, seen by the
+ * synthetic camera from the circular sweep RobotScan runs.
+ */
+
+#ifndef GODEL_TEST_SYNTHETIC_SCENES_H
+#define GODEL_TEST_SYNTHETIC_SCENES_H
+
+#include <synthetic/synthetic_workload.h>
+
+#include <cmath>
+
+namespace godel_surface_detection
+{
+namespace synthetic
+{
+namespace test
+{
+
+// 20cm x 20cm x 5cm plate on the z = 0 plane with a 6cm x 6cm boss
+inline PartDescription plateWithBoss(std::size_t points)
+{
+  PartDescription part;
+  part.primitives.push_back(box(0.0, 0.0, 0.025, 0.2, 0.2, 0.05));
+  part.primitives.push_back(box(0.04, 0.04, 0.07, 0.06, 0.06, 0.04));
+  part.target_points = points;
+  part.seed = 1;
+  return part;
+}
+
+// The part on a table, so that views see the table around it as a real camera would; the table's
+// labels come after the part's
+inline PartDescription onTable(PartDescription part)
+{
+  part.primitives.push_back(box(0.0, 0.0, -0.01, 1.0, 1.0, 0.02));
+  return part;
+}
+
+// The default 640 x 480 camera with its resolution scaled down by 'factor', same field of view
+inline CameraModel scaledCamera(int factor)
+{
+  CameraModel camera;
+  camera.width /= factor;
+  camera.height /= factor;
+  camera.fx /= factor;
+  camera.fy /= factor;
+  camera.cx = (camera.width - 1) / 2.0;
+  camera.cy = (camera.height - 1) / 2.0;
+  return camera;
+}
+
+// A circular sweep of 12 views 40cm out and 40cm up, looking down at the part at 45 degrees
+inline godel_msgs::RobotScanParameters circularSweep()
+{
+  godel_msgs::RobotScanParameters params;
+  params.world_to_obj_pose.orientation.w = 1.0;
+  params.cam_to_obj_xoffset = 0.4;
+  params.cam_to_obj_zoffset = 0.4;
+  params.cam_tilt_angle = 0.75 * M_PI;
+  params.num_scan_points = 12;
+  params.sweep_angle_start = 0.0;
+  params.sweep_angle_end = 2.0 * M_PI * 11.0 / 12.0;
+  return params;
+}
+
+} // namespace test
+} // namespace synthetic
+} // namespace godel_surface_detection
+
+#endif // GODEL_TEST_SYNTHETIC_SCENES_H
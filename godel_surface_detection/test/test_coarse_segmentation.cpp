@@ -0,0 +1,160 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <segmentation/surface_segmentation.h>
+
+#include <random>
+
+namespace
+{
+
+typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+
+const static double SPACING = 0.002;
+const static double SENSOR_NOISE = 0.0005;
+const static double COARSE_LEAF = 0.005;
+
+void addPoint(CloudRGB& cloud, double x, double y, double z, std::mt19937& rng)
+{
+  std::normal_distribution<double> noise(0.0, SENSOR_NOISE);
+  pcl::PointXYZRGB p;
+  p.x = x + noise(rng);
+  p.y = y + noise(rng);
+  p.z = z + noise(rng);
+  cloud.push_back(p);
+}
+
+/**
+ * @brief The top and sides of a 0.2 x 0.15 x 0.05 m block, as a scan from above sees them: five
+ * faces meeting at creases
+ */
+CloudRGB::Ptr makeBlockCloud()
+{
+  const double sx = 0.2, sy = 0.15, sz = 0.05;
+  std::mt19937 rng(7);
+  CloudRGB::Ptr cloud(new CloudRGB());
+  for (double x = 0.0; x <= sx; x += SPACING)
+    for (double y = 0.0; y <= sy; y += SPACING)
+      addPoint(*cloud, x, y, sz, rng);
+  for (double z = 0.0; z < sz; z += SPACING)
+  {
+    for (double x = 0.0; x <= sx; x += SPACING)
+    {
+      addPoint(*cloud, x, 0.0, z, rng);
+      addPoint(*cloud, x, sy, z, rng);
+    }
+    for (double y = SPACING; y < sy; y += SPACING)
+    {
+      addPoint(*cloud, 0.0, y, z, rng);
+      addPoint(*cloud, sx, y, z, rng);
+    }
+  }
+  cloud->width = cloud->size();
+  cloud->height = 1;
+  cloud->is_dense = true;
+  cloud->sensor_origin_ = Eigen::Vector4f(0.1f, 0.075f, 1.0f, 0.0f);
+  return cloud;
+}
+
+SegmentationParameters makeParameters(double coarse_leaf)
+{
+  // The sides hold fewer points than detection's minimum
+  SegmentationParameters params;
+  params.min_cluster_size = 500;
+  params.coarse_leaf = coarse_leaf;
+  return params;
+}
+
+std::vector<int> labelPoints(const std::vector<pcl::PointIndices>& clusters, std::size_t points)
+{
+  std::vector<int> labels(points, -1);
+  for (std::size_t k = 0; k < clusters.size(); ++k)
+    for (int idx : clusters[k].indices)
+      labels[idx] = k;
+  return labels;
+}
+
+/**
+ * @brief Share of the points segmented at full resolution that the other segmentation puts in
+ * the cluster matching theirs, clusters being matched one to one by their largest overlap
+ */
+double labelAgreement(const std::vector<pcl::PointIndices>& expected, const std::vector<pcl::PointIndices>& actual,
+                      std::size_t points)
+{
+  const std::vector<int> labels = labelPoints(actual, points);
+  std::vector<bool> matched(actual.size(), false);
+  std::size_t agreed = 0, total = 0;
+  for (const auto& cluster : expected)
+  {
+    std::vector<std::size_t> overlap(actual.size(), 0);
+    for (int idx : cluster.indices)
+      if (labels[idx] >= 0)
+        ++overlap[labels[idx]];
+    int best = -1;
+    for (std::size_t k = 0; k < actual.size(); ++k)
+      if (!matched[k] && (best < 0 || overlap[k] > overlap[best]))
+        best = k;
+    if (best >= 0)
+    {
+      matched[best] = true;
+      agreed += overlap[best];
+    }
+    total += cluster.indices.size();
+  }
+  return total == 0 ? 0.0 : static_cast<double>(agreed) / total;
+}
+
+} // end anon namespace
+
+TEST(CoarseSegmentation, agreesWithFullResolution)
+{
+  const CloudRGB::Ptr cloud = makeBlockCloud();
+
+  SurfaceSegmentation full(cloud, makeParameters(0.0));
+  CloudRGB::Ptr full_colored(new CloudRGB());
+  const std::vector<pcl::PointIndices> expected = full.computeSegments(full_colored);
+
+  SurfaceSegmentation coarse(cloud, makeParameters(COARSE_LEAF));
+  CloudRGB::Ptr coarse_colored(new CloudRGB());
+  const std::vector<pcl::PointIndices> actual = coarse.computeSegments(coarse_colored);
+
+  ASSERT_EQ(5u, expected.size());
+  EXPECT_EQ(expected.size(), actual.size());
+  EXPECT_GE(labelAgreement(expected, actual, cloud->size()), 0.95);
+  ASSERT_TRUE(coarse_colored != nullptr);
+  EXPECT_EQ(cloud->size(), coarse_colored->size());
+}
+
+TEST(CoarseSegmentation, segmentsWhenEveryPointIsRefined)
+{
+  // A band wider than the part leaves no seeds between the borders; the faces keep their coarse
+  // labels instead of being lost
+  const CloudRGB::Ptr cloud = makeBlockCloud();
+  SegmentationParameters params = makeParameters(COARSE_LEAF);
+  params.border_band = 100;
+  SurfaceSegmentation SS(cloud, params);
+  CloudRGB::Ptr colored(new CloudRGB());
+  EXPECT_EQ(5u, SS.computeSegments(colored).size());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,408 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Offline comparison of scan-while-moving capture with stop-and-go scanning. The synthetic depth
+ * camera runs the circular sweep RobotScan would, either stopping at every pose or capturing
+ * frames on a timer while moving. A moving frame's pixels are drawn from several instants across
+ * its exposure, and the frame is placed in the world with the camera pose that a TF buffer fed by
+ * robot states at TF_RATE gives for its capture stamp.
+ */
+
+#include <gtest/gtest.h>
+#include <scan/continuous_scan.h>
+#include <scan/next_best_view.h>
+#include <synthetic/synthetic_workload.h>
+#include "synthetic_scenes.h"
+
+#include <pcl/kdtree/kdtree_flann.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+using namespace godel_surface_detection;
+using namespace godel_surface_detection::synthetic;
+using godel_surface_detection::scan::ContinuousScanParameters;
+
+namespace
+{
+
+const double SHORT_EXPOSURE = 0.005;   // (s) of a sensor suited to capture while moving
+const int EXPOSURE_STEPS = 3;          // instants across the exposure that a frame's pixels are drawn from
+const double TF_RATE = 20.0;           // (Hz) of the robot states the TF buffer holds
+const double TF_PHASE = 0.02;          // (s) the robot states are not published in step with the frames
+const double SWEEP_VELOCITY = 0.4;     // (rad/s) of the sweep angle
+const double SWEEP_ACCELERATION = 0.8; // (rad/s^2)
+const double STOP_AND_GO_SETTLE = 1.5; // (s) RobotScan waits 1 s before and 0.5 s after every capture
+const double COVERED_DISTANCE = 0.003; // (m) a ground truth point this close to a scanned one was seen
+const int PART_POINTS = 200000;        // ground truth points of the part
+
+// The camera pose of the sweep at sweep angle 'alpha'
+Eigen::Affine3d cameraAt(double alpha)
+{
+  godel_msgs::RobotScanParameters params = test::circularSweep();
+  params.num_scan_points = 1;
+  params.sweep_angle_start = alpha;
+  return scanCameraPoses(params).front();
+}
+
+/**
+ * @brief The sweep angle over a continuous sweep: accelerating to SWEEP_VELOCITY, cruising and
+ * stopping at the end of the sweep, like a time parameterized trajectory through the stops
+ */
+struct SweepProfile
+{
+  SweepProfile()
+  {
+    const godel_msgs::RobotScanParameters params = test::circularSweep();
+    start = params.sweep_angle_start;
+    distance = params.sweep_angle_end - params.sweep_angle_start;
+    ramp = SWEEP_VELOCITY / SWEEP_ACCELERATION;
+    duration = 2.0 * ramp + (distance - SWEEP_VELOCITY * ramp) / SWEEP_VELOCITY;
+  }
+
+  double velocity(double t) const
+  {
+    t = std::min(std::max(t, 0.0), duration);
+    return SWEEP_ACCELERATION * std::min(std::min(t, duration - t), ramp);
+  }
+
+  double angle(double t) const
+  {
+    t = std::min(std::max(t, 0.0), duration);
+    if (t < ramp)
+      return start + 0.5 * SWEEP_ACCELERATION * t * t;
+    if (t > duration - ramp)
+      return start + distance - 0.5 * SWEEP_ACCELERATION * (duration - t) * (duration - t);
+    return start + 0.5 * SWEEP_VELOCITY * ramp + SWEEP_VELOCITY * (t - ramp);
+  }
+
+  /** @brief The sweep angle as the one joint of a trajectory sampled every 'dt' seconds */
+  trajectory_msgs::JointTrajectory trajectory(double dt) const
+  {
+    trajectory_msgs::JointTrajectory trajectory;
+    trajectory.joint_names.push_back("sweep");
+    const int steps = static_cast<int>(std::ceil(duration / dt));
+    for (int i = 0; i <= steps; ++i)
+    {
+      const double t = std::min(i * dt, duration);
+      trajectory_msgs::JointTrajectoryPoint point;
+      point.positions.push_back(angle(t));
+      point.velocities.push_back(velocity(t));
+      point.time_from_start = ros::Duration(t);
+      trajectory.points.push_back(point);
+    }
+    return trajectory;
+  }
+
+  double start, distance, ramp, duration;
+};
+
+/**
+ * @brief The camera pose TF gives for time t from the robot states published at TF_RATE:
+ * interpolated between the two around t, or else the latest one before it
+ */
+Eigen::Affine3d cameraFromTf(const SweepProfile& sweep, double t, bool interpolate)
+{
+  const double t0 = TF_PHASE + std::floor((t - TF_PHASE) * TF_RATE) / TF_RATE;
+  const Eigen::Affine3d before = cameraAt(sweep.angle(t0));
+  if (!interpolate)
+    return before;
+
+  const Eigen::Affine3d after = cameraAt(sweep.angle(t0 + 1.0 / TF_RATE));
+  const double s = (t - t0) * TF_RATE;
+  const Eigen::Quaterniond rotation =
+      Eigen::Quaterniond(before.linear()).slerp(s, Eigen::Quaterniond(after.linear()));
+  return Eigen::Translation3d((1.0 - s) * before.translation() + s * after.translation()) * rotation;
+}
+
+/**
+ * @brief A frame captured at time t, in the camera frame: every pixel comes from one of
+ * EXPOSURE_STEPS instants across the exposure, with the camera wherever it was then
+ */
+LabelledCloud captureFrame(const PartDescription& scene, const SweepProfile& sweep, double t, double exposure,
+                           unsigned seed)
+{
+  std::vector<LabelledCloud> instants(EXPOSURE_STEPS);
+  std::vector<Eigen::Affine3d> to_camera(EXPOSURE_STEPS);
+  for (int k = 0; k < EXPOSURE_STEPS; ++k)
+  {
+    const double tk = t + exposure * ((k + 0.5) / EXPOSURE_STEPS - 0.5);
+    const Eigen::Affine3d world_to_cam = cameraAt(sweep.angle(tk));
+    simulateView(scene, test::scaledCamera(4), world_to_cam, seed * EXPOSURE_STEPS + k, instants[k]);
+    to_camera[k] = world_to_cam.inverse();
+  }
+
+  LabelledCloud frame = instants[0];
+  for (std::size_t i = 0; i < frame.size(); ++i)
+  {
+    const int k = i % EXPOSURE_STEPS;
+    const LabelledPoint& p = instants[k].points[i];
+    frame.points[i] = p;
+    if (p.label == NO_SURFACE)
+      continue;
+    frame.points[i].getVector3fMap() = (to_camera[k] * p.getVector3fMap().cast<double>()).cast<float>();
+  }
+  return frame;
+}
+
+struct ScanResult
+{
+  std::size_t frames;
+  std::size_t rejected;
+  double time;     // (s)
+  double coverage; // share of the part's visible surface
+  double error;    // (m) mean distance of the scanned part points from the part
+};
+
+/**
+ * @brief Accumulates the scanned points of the part, and measures them against its ground truth
+ */
+class FusedScan
+{
+public:
+  FusedScan()
+    : part_(test::plateWithBoss(PART_POINTS)), part_labels_(surfaceNames(part_).size()),
+      fused_(new pcl::PointCloud<pcl::PointXYZ>())
+  {
+    generatePart(part_, truth_);
+  }
+
+  /** @brief Adds a frame given in the camera frame, placed in the world with world_to_cam */
+  void add(const LabelledCloud& frame, const Eigen::Affine3d& world_to_cam)
+  {
+    for (const auto& p : frame.points)
+    {
+      if (p.label == NO_SURFACE || p.label > part_labels_)
+        continue;
+      pcl::PointXYZ q;
+      q.getVector3fMap() = (world_to_cam * p.getVector3fMap().cast<double>()).cast<float>();
+      fused_->push_back(q);
+    }
+  }
+
+  void measure(ScanResult& result) const
+  {
+    pcl::PointCloud<pcl::PointXYZ>::Ptr truth(new pcl::PointCloud<pcl::PointXYZ>());
+    pcl::PointCloud<pcl::PointXYZ>::Ptr visible(new pcl::PointCloud<pcl::PointXYZ>());
+    const std::vector<std::string> names = surfaceNames(part_);
+    for (const auto& p : truth_.points)
+    {
+      pcl::PointXYZ q(p.x, p.y, p.z);
+      truth->push_back(q);
+      const std::string& name = names[p.label - 1];
+      if (name.compare(name.size() - 3, 3, "/-z") != 0)
+        visible->push_back(q);
+    }
+
+    std::vector<int> index(1);
+    std::vector<float> sqr_distance(1);
+    pcl::KdTreeFLANN<pcl::PointXYZ> fused_tree;
+    fused_tree.setInputCloud(fused_);
+    std::size_t covered = 0;
+    for (const auto& p : visible->points)
+    {
+      if (fused_tree.nearestKSearch(p, 1, index, sqr_distance) > 0 &&
+          sqr_distance[0] < COVERED_DISTANCE * COVERED_DISTANCE)
+        ++covered;
+    }
+    result.coverage = static_cast<double>(covered) / visible->size();
+
+    pcl::KdTreeFLANN<pcl::PointXYZ> truth_tree;
+    truth_tree.setInputCloud(truth);
+    double error = 0.0;
+    for (const auto& p : fused_->points)
+    {
+      truth_tree.nearestKSearch(p, 1, index, sqr_distance);
+      error += std::sqrt(sqr_distance[0]);
+    }
+    result.error = error / fused_->size();
+  }
+
+private:
+  PartDescription part_;
+  uint32_t part_labels_;
+  LabelledCloud truth_;
+  pcl::PointCloud<pcl::PointXYZ>::Ptr fused_;
+};
+
+ScanResult runStopAndGo()
+{
+  const PartDescription scene = test::onTable(test::plateWithBoss(PART_POINTS));
+  const std::vector<Eigen::Affine3d> stops = scanCameraPoses(test::circularSweep());
+  const scan::NextBestViewPlanner timing(test::circularSweep(), scan::NextBestViewParameters());
+  FusedScan fused;
+  ScanResult result = ScanResult();
+  for (std::size_t i = 0; i < stops.size(); ++i)
+  {
+    LabelledCloud view;
+    simulateView(scene, test::scaledCamera(4), stops[i], i, view);
+    // Back to the camera frame, and placed with the pose the robot stopped at
+    for (auto& p : view.points)
+    {
+      if (p.label != NO_SURFACE)
+        p.getVector3fMap() = (stops[i].inverse() * p.getVector3fMap().cast<double>()).cast<float>();
+    }
+    fused.add(view, stops[i]);
+    result.time += (i > 0 ? timing.motionTime(stops[i - 1], stops[i]) : 0.0) + STOP_AND_GO_SETTLE;
+  }
+  result.frames = stops.size();
+  fused.measure(result);
+  return result;
+}
+
+ScanResult runContinuous(const ContinuousScanParameters& params, double exposure, bool interpolate)
+{
+  const PartDescription scene = test::onTable(test::plateWithBoss(PART_POINTS));
+  const SweepProfile sweep;
+  const trajectory_msgs::JointTrajectory trajectory = sweep.trajectory(0.01);
+  FusedScan fused;
+  ScanResult result = ScanResult();
+  const std::vector<double> times = scan::captureTimes(sweep.duration, params.frame_rate);
+  for (std::size_t i = 0; i < times.size(); ++i)
+  {
+    if (scan::maxJointVelocity(trajectory, times[i]) > params.max_joint_velocity)
+    {
+      ++result.rejected;
+      continue;
+    }
+    fused.add(captureFrame(scene, sweep, times[i], exposure, i), cameraFromTf(sweep, times[i], interpolate));
+    ++result.frames;
+  }
+  result.time = sweep.duration;
+  fused.measure(result);
+  return result;
+}
+
+void report(const std::string& name, const ScanResult& result)
+{
+  std::cout << name << ": " << result.frames << " frames (" << result.rejected << " rejected), " << result.time
+            << " s, " << 100.0 * result.coverage << "% of the surface, " << 1000.0 * result.error
+            << " mm mean error\n";
+}
+
+} // end anon namespace
+
+TEST(ContinuousScan, captureTimesCoverTheMotion)
+{
+  const std::vector<double> times = scan::captureTimes(2.0, 5.0);
+  ASSERT_EQ(11u, times.size());
+  EXPECT_DOUBLE_EQ(0.0, times.front());
+  EXPECT_DOUBLE_EQ(2.0, times.back());
+  EXPECT_DOUBLE_EQ(0.2, times[1] - times[0]);
+  EXPECT_TRUE(scan::captureTimes(2.0, 0.0).empty());
+}
+
+TEST(ContinuousScan, interpolatesJointVelocities)
+{
+  const SweepProfile sweep;
+  const trajectory_msgs::JointTrajectory trajectory = sweep.trajectory(0.1);
+  EXPECT_NEAR(0.5 * SWEEP_VELOCITY, scan::maxJointVelocity(trajectory, 0.5 * sweep.ramp), 1e-9);
+  EXPECT_NEAR(SWEEP_VELOCITY, scan::maxJointVelocity(trajectory, 0.5 * sweep.duration), 1e-9);
+  EXPECT_NEAR(0.0, scan::maxJointVelocity(trajectory, sweep.duration), 1e-9);
+  EXPECT_EQ(0.0, scan::maxJointVelocity(trajectory, -0.1));
+  EXPECT_EQ(0.0, scan::maxJointVelocity(trajectory, sweep.duration + 0.1));
+
+  // Joints moving in either direction
+  trajectory_msgs::JointTrajectory two_joints;
+  two_joints.points.resize(2);
+  two_joints.points[0].velocities = {0.1, -0.4};
+  two_joints.points[1].velocities = {0.3, 0.0};
+  two_joints.points[1].time_from_start = ros::Duration(1.0);
+  EXPECT_NEAR(0.2, scan::maxJointVelocity(two_joints, 0.5), 1e-9);
+  EXPECT_NEAR(0.3, scan::maxJointVelocity(two_joints, 0.25), 1e-9);
+}
+
+TEST(ContinuousScan, findsTheDepartureFromTheStart)
+{
+  trajectory_msgs::JointTrajectory trajectory;
+  trajectory.joint_names = {"a", "b"};
+  trajectory.points.resize(3);
+  trajectory.points[0].positions = {0.0, 1.0};
+  trajectory.points[1].positions = {0.0005, 0.99};
+  trajectory.points[1].time_from_start = ros::Duration(1.0);
+  trajectory.points[2].positions = {0.1, 0.99};
+  trajectory.points[2].time_from_start = ros::Duration(2.0);
+
+  // Joint b moves 0.001 a tenth of the way into the first segment
+  EXPECT_NEAR(0.1, scan::departureTime(trajectory, 0.001), 1e-9);
+  // Only joint a moves 0.05, about halfway into the second segment
+  EXPECT_NEAR(1.0 + 0.0495 / 0.0995, scan::departureTime(trajectory, 0.05), 1e-9);
+  EXPECT_NEAR(2.0, scan::departureTime(trajectory, 1.0), 1e-9);
+
+  sensor_msgs::JointState state;
+  state.name = {"b", "other", "a"};
+  state.position = {1.0, 5.0, 0.0005};
+  EXPECT_FALSE(scan::hasDeparted(trajectory, state, 0.001));
+  state.position[0] = 0.998;
+  EXPECT_TRUE(scan::hasDeparted(trajectory, state, 0.001));
+
+  // Joints the state doesn't have don't count
+  state.name = {"c"};
+  state.position = {3.0};
+  EXPECT_FALSE(scan::hasDeparted(trajectory, state, 0.001));
+}
+
+TEST(ContinuousScan, sweepCoversThePartFasterThanStopAndGo)
+{
+  const ScanResult stop_and_go = runStopAndGo();
+  const ScanResult continuous = runContinuous(ContinuousScanParameters(), SHORT_EXPOSURE, true);
+  report("stop and go", stop_and_go);
+  report("continuous", continuous);
+  RecordProperty("stop_and_go_time_ms", static_cast<int>(1000.0 * stop_and_go.time));
+  RecordProperty("continuous_time_ms", static_cast<int>(1000.0 * continuous.time));
+
+  EXPECT_EQ(0u, continuous.rejected);
+  EXPECT_GT(continuous.coverage, stop_and_go.coverage - 0.01);
+  EXPECT_LT(continuous.error, stop_and_go.error + 0.0005);
+  EXPECT_LT(continuous.time, 0.75 * stop_and_go.time);
+}
+
+TEST(ContinuousScan, framesArePlacedAtTheirCaptureTime)
+{
+  // The latest robot state before a frame is up to 1 / TF_RATE old, and the camera has moved on
+  const ScanResult interpolated = runContinuous(ContinuousScanParameters(), SHORT_EXPOSURE, true);
+  const ScanResult latest = runContinuous(ContinuousScanParameters(), SHORT_EXPOSURE, false);
+  report("latest robot state", latest);
+  EXPECT_LT(2.0 * interpolated.error, latest.error);
+}
+
+TEST(ContinuousScan, rejectsBlurredFrames)
+{
+  // With a long exposure, only the frames captured while the sweep is slow are sharp
+  const double long_exposure = 0.05;
+  ContinuousScanParameters all, slow;
+  all.max_joint_velocity = std::numeric_limits<double>::infinity();
+  slow.max_joint_velocity = 0.25 * SWEEP_VELOCITY;
+  const ScanResult blurred = runContinuous(all, long_exposure, true);
+  const ScanResult sharp = runContinuous(slow, long_exposure, true);
+  report("long exposure", blurred);
+  report("long exposure, blurred frames rejected", sharp);
+
+  EXPECT_GT(sharp.rejected, 0u);
+  EXPECT_GT(sharp.frames, 0u);
+  EXPECT_LT(sharp.error, blurred.error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,122 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <interactive/interactive_surface_server.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <utils/mesh_conversions.h>
+
+#include <boost/filesystem.hpp>
+
+using namespace godel_surface_detection;
+using namespace godel_surface_detection::interactive;
+using godel_utils::memory::MemoryBudget;
+
+namespace
+{
+
+// Grid of n x n vertices 'spacing' apart, finer than the markers' decimation cell
+pcl::PolygonMesh makeGridMesh(int n, double spacing, double x0)
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      cloud.push_back(pcl::PointXYZ(x0 + i * spacing, j * spacing, 0.0));
+
+  pcl::PolygonMesh mesh;
+  pcl::toPCLPointCloud2(cloud, mesh.cloud);
+  mesh.header.frame_id = "world_frame";
+  for (int i = 0; i + 1 < n; ++i)
+  {
+    for (int j = 0; j + 1 < n; ++j)
+    {
+      pcl::Vertices quad;
+      quad.vertices = {static_cast<uint32_t>(i * n + j), static_cast<uint32_t>((i + 1) * n + j),
+                       static_cast<uint32_t>((i + 1) * n + j + 1), static_cast<uint32_t>(i * n + j + 1)};
+      mesh.polygons.push_back(quad);
+    }
+  }
+  return mesh;
+}
+
+// Same frame and the same triangles of the same vertex positions
+void expectSameMesh(const pcl::PolygonMesh& expected, const pcl::PolygonMesh& actual)
+{
+  EXPECT_EQ(expected.header.frame_id, actual.header.frame_id);
+  EXPECT_EQ(expected.cloud.width * expected.cloud.height, actual.cloud.width * actual.cloud.height);
+
+  std::vector<geometry_msgs::Point> expected_points, actual_points;
+  meshToTrianglePoints(expected, expected_points);
+  meshToTrianglePoints(actual, actual_points);
+  EXPECT_EQ(expected_points, actual_points);
+}
+
+std::string makeSpillDirectory()
+{
+  char directory[] = "/tmp/test_interactive_surface_server_XXXXXX";
+  return mkdtemp(directory) ? directory : "";
+}
+
+} // end anon namespace
+
+TEST(InteractiveSurfaceServer, spilledMeshesAreReadBackUnchanged)
+{
+  const std::string spill = makeSpillDirectory();
+  ASSERT_FALSE(spill.empty());
+
+  InteractiveSurfaceServer server;
+  server.setSpillDirectory(spill);
+  server.init();
+  server.run();
+
+  const pcl::PolygonMesh first = makeGridMesh(60, 0.001, 0.0);
+  const pcl::PolygonMesh second = makeGridMesh(60, 0.001, 0.2);
+  server.add_surface(0, first);
+  const std::size_t one = server.bytesUsed();
+
+  // A hard budget of one mesh sends the first one to disk when the second is added
+  server.setBudget(MemoryBudget(one, one + one / 2));
+  server.add_surface(1, second);
+  EXPECT_LE(server.bytesUsed(), one + one / 2);
+  EXPECT_FALSE(boost::filesystem::is_empty(spill));
+
+  // Spilled surfaces can still be renamed, surfaces that don't exist can't
+  EXPECT_TRUE(server.rename_surface(0, "spilled"));
+  EXPECT_FALSE(server.rename_surface(2, "missing"));
+
+  server.select_all(true);
+  std::vector<pcl::PolygonMesh> meshes;
+  server.get_selected_surfaces(meshes);
+  ASSERT_EQ(2u, meshes.size());
+  expectSameMesh(first, meshes[0]);
+  expectSameMesh(second, meshes[1]);
+
+  // Starting over removes the spilled meshes
+  server.remove_all_surfaces();
+  EXPECT_TRUE(boost::filesystem::is_empty(spill));
+  server.stop();
+  boost::filesystem::remove_all(spill);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_interactive_surface_server");
+  ros::NodeHandle nh;
+  return RUN_ALL_TESTS();
+}
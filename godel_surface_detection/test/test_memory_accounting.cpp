@@ -0,0 +1,299 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <coordination/data_coordinator.h>
+#include <detection/surface_detection.h>
+#include <services/trajectory_library.h>
+
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <random>
+#include <thread>
+
+using namespace godel_surface_detection;
+using godel_utils::memory::MemoryBudget;
+
+namespace
+{
+
+const std::size_t MB = 1024 * 1024;
+
+// One scan of a 20cm x 20cm plate: about 'n' points with some sensor noise
+detection::CloudRGB makeScan(std::size_t n, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> along(0.0f, 0.2f);
+  std::normal_distribution<float> noise(0.0f, 0.0002f);
+
+  detection::CloudRGB cloud;
+  cloud.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    pcl::PointXYZRGB p;
+    p.x = along(rng);
+    p.y = along(rng);
+    p.z = 0.05f + noise(rng);
+    p.r = p.g = p.b = 128;
+    cloud.push_back(p);
+  }
+  cloud.header.frame_id = "world_frame";
+  return cloud;
+}
+
+godel_msgs::ProcessPlan makePlan(std::size_t points)
+{
+  godel_msgs::ProcessPlan plan;
+  plan.type = godel_msgs::ProcessPlan::BLEND_TYPE;
+  plan.trajectory_process.joint_names.resize(6, "joint");
+  plan.trajectory_process.points.resize(points);
+  for (std::size_t i = 0; i < points; ++i)
+  {
+    plan.trajectory_process.points[i].positions.assign(6, 0.001 * i);
+    plan.trajectory_process.points[i].time_from_start = ros::Duration(0.01 * i);
+  }
+  return plan;
+}
+
+std::vector<geometry_msgs::PoseArray> makePoses(std::size_t n)
+{
+  std::vector<geometry_msgs::PoseArray> poses(1);
+  poses[0].poses.resize(n);
+  return poses;
+}
+
+std::string makeSpillDirectory()
+{
+  char directory[] = "/tmp/test_memory_accounting_XXXXXX";
+  return mkdtemp(directory) ? directory : "";
+}
+
+} // end anon namespace
+
+TEST(MemoryAccounting, spilledRecordsAreReadBack)
+{
+  const std::string spill = makeSpillDirectory();
+  ASSERT_FALSE(spill.empty());
+
+  data::DataCoordinator coordinator;
+  coordinator.setSpillDirectory(spill);
+  const detection::CloudRGB input = makeScan(50000, 1);
+  const detection::CloudRGB surface = makeScan(10000, 2);
+  const int first = coordinator.addRecord(input, surface);
+  const int second = coordinator.addRecord(input, surface);
+  const std::size_t full = coordinator.bytesUsed();
+
+  // Half the budget leaves room for one record: the oldest one goes to disk
+  coordinator.setBudget(MemoryBudget(full / 2 + MB / 10, full));
+  EXPECT_GT(coordinator.enforceSoftBudget(), 0u);
+  EXPECT_LE(coordinator.bytesUsed(), coordinator.budget().soft_bytes);
+
+  detection::CloudRGB read;
+  ASSERT_TRUE(coordinator.getCloud(data::input_cloud, first, read));
+  ASSERT_EQ(input.size(), read.size());
+  EXPECT_EQ(input[123].x, read[123].x);
+  ASSERT_TRUE(coordinator.getCloud(data::surface_cloud, second, read));
+  EXPECT_EQ(surface.size(), read.size());
+
+  // Starting over removes the spilled files
+  coordinator.init();
+  EXPECT_TRUE(boost::filesystem::is_empty(spill));
+  boost::filesystem::remove_all(spill);
+}
+
+TEST(MemoryAccounting, recordsAreReadWhileTheyAreEvicted)
+{
+  const std::string spill = makeSpillDirectory();
+  ASSERT_FALSE(spill.empty());
+
+  data::DataCoordinator coordinator;
+  coordinator.setSpillDirectory(spill);
+  const detection::CloudRGB input = makeScan(20000, 1);
+  const detection::CloudRGB surface = makeScan(5000, 2);
+  std::vector<int> ids;
+  for (int i = 0; i < 4; ++i)
+    ids.push_back(coordinator.addRecord(input, surface));
+
+  // Room for about one record, so every record detection adds spills the others
+  const std::size_t one = coordinator.bytesUsed() / ids.size();
+  coordinator.setBudget(MemoryBudget(one, 2 * one));
+  godel_utils::memory::MemoryMonitor monitor("test_memory_accounting");
+  monitor.add(coordinator);
+
+  // Planning reads the surfaces' clouds and stores their paths, as the service's planning thread
+  std::atomic<bool> done(false);
+  std::atomic<int> passes(0), bad_reads(0);
+  std::thread planning([&]() {
+    while (!done)
+    {
+      for (int id : ids)
+      {
+        detection::CloudRGB read;
+        if (!coordinator.getCloud(data::input_cloud, id, read) || read.size() != input.size())
+          ++bad_reads;
+        if (!coordinator.getCloud(data::surface_cloud, id, read) || read.size() != surface.size())
+          ++bad_reads;
+        coordinator.setPoses(data::blend_pose, id, makePoses(100));
+      }
+      ++passes;
+    }
+  });
+
+  while (passes == 0)
+    std::this_thread::yield();
+  for (int i = 0; i < 20; ++i)
+  {
+    coordinator.addRecord(input, surface);
+    monitor.update();
+  }
+  const int seen = passes;
+  while (passes < seen + 2)
+    std::this_thread::yield();
+  done = true;
+  planning.join();
+
+  EXPECT_EQ(0, bad_reads.load());
+  EXPECT_GT(coordinator.evictions(), 0u);
+  coordinator.init();
+  boost::filesystem::remove_all(spill);
+}
+
+TEST(MemoryAccounting, spilledPlansKeepTheirNames)
+{
+  const std::string spill = makeSpillDirectory();
+  ASSERT_FALSE(spill.empty());
+
+  TrajectoryLibrary library;
+  library.setSpillDirectory(spill);
+  TrajectoryLibrary::TrajectoryMap plans;
+  for (int i = 0; i < 10; ++i)
+    plans["surface_" + std::to_string(i) + "_blend"] = makePlan(1000 + i);
+  library.insert(plans);
+  const std::size_t full = library.bytesUsed();
+
+  library.setBudget(MemoryBudget(full / 3, full / 2));
+  library.insert({{"surface_10_blend", makePlan(1000)}}); // over the hard budget
+  EXPECT_LE(library.bytesUsed(), full / 3);
+  EXPECT_EQ(1u, library.evictions());
+  EXPECT_EQ(1u, library.get().count("surface_10_blend")); // the newest plans stay in memory
+  EXPECT_EQ(0u, library.get().count("surface_0_blend"));
+
+  EXPECT_EQ(11u, library.names().size());
+  godel_msgs::ProcessPlan plan;
+  ASSERT_TRUE(library.fetch("surface_3_blend", plan));
+  EXPECT_EQ(1003u, plan.trajectory_process.points.size());
+  EXPECT_FALSE(library.fetch("surface_11_blend", plan));
+
+  library.clear();
+  EXPECT_TRUE(library.names().empty());
+  boost::filesystem::remove_all(spill);
+}
+
+TEST(MemoryAccounting, repeatedScansAreCompacted)
+{
+  detection::SurfaceDetection detection;
+  detection.setBudget(MemoryBudget(4 * MB, 8 * MB));
+
+  // Every scan covers the same plate, so the merged cloud stops growing
+  for (unsigned i = 0; i < 20; ++i)
+  {
+    detection::CloudRGB scan = makeScan(100000, i);
+    detection.add_cloud(scan);
+    EXPECT_LE(detection.bytesUsed(), 8 * MB) << "scan " << i;
+  }
+  EXPECT_GT(detection.evictions(), 0u);
+
+  detection::CloudRGB full;
+  detection.get_full_cloud(full);
+  EXPECT_GT(full.size(), 10000u); // the plate is still covered at the processing resolution
+}
+
+TEST(MemoryAccounting, repeatedScanPlanCyclesStayBounded)
+{
+  const std::string spill = makeSpillDirectory();
+  ASSERT_FALSE(spill.empty());
+
+  detection::SurfaceDetection detection;
+  data::DataCoordinator coordinator;
+  TrajectoryLibrary library;
+  coordinator.setSpillDirectory(spill);
+  library.setSpillDirectory(spill);
+  detection.setBudget(MemoryBudget(2 * MB, 4 * MB));
+  coordinator.setBudget(MemoryBudget(8 * MB, 16 * MB));
+  library.setBudget(MemoryBudget(2 * MB, 4 * MB));
+
+  godel_utils::memory::MemoryMonitor monitor("test_memory_accounting");
+  monitor.add(detection);
+  monitor.add(coordinator);
+  monitor.add(library);
+
+  // Without budgets the stores would hold about 1GB by the end
+  const int cycles = 25;
+  const int warm_up = 5;
+  std::size_t resident_after_warm_up = 0;
+  for (int cycle = 0; cycle < cycles; ++cycle)
+  {
+    // scan: the part is scanned again and surfaces are recorded from the accumulated cloud
+    detection::CloudRGB scan = makeScan(50000, cycle);
+    detection.add_cloud(scan);
+    detection::CloudRGB full;
+    detection.get_full_cloud(full);
+    for (int s = 0; s < 2; ++s)
+    {
+      const int id = coordinator.addRecord(full, makeScan(10000, 100 * cycle + s));
+      coordinator.setPoses(data::blend_pose, id, makePoses(1000));
+    }
+    monitor.update();
+
+    // plan
+    TrajectoryLibrary::TrajectoryMap plans;
+    for (int s = 0; s < 2; ++s)
+      plans["cycle_" + std::to_string(cycle) + "_surface_" + std::to_string(s)] = makePlan(2000);
+    library.insert(plans);
+    monitor.update();
+
+    EXPECT_LE(detection.bytesUsed(), 4 * MB) << "cycle " << cycle;
+    EXPECT_LE(coordinator.bytesUsed(), 16 * MB) << "cycle " << cycle;
+    EXPECT_LE(library.bytesUsed(), 4 * MB) << "cycle " << cycle;
+
+    if (cycle == warm_up)
+      resident_after_warm_up = godel_utils::memory::residentBytes();
+  }
+
+  // Every store reports, and the process report comes last
+  const diagnostic_msgs::DiagnosticArray report = monitor.report();
+  ASSERT_EQ(4u, report.status.size());
+  for (const auto& status : report.status)
+    EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::OK, status.level) << status.name;
+  EXPECT_EQ("test_memory_accounting: memory", report.status.back().name);
+
+  // After the warm up the stores are at their budgets, so resident memory should stop growing
+  const std::size_t resident = godel_utils::memory::residentBytes();
+  ASSERT_GT(resident_after_warm_up, 0u);
+  EXPECT_LT(resident, resident_after_warm_up + 64 * MB);
+
+  EXPECT_EQ(2u * cycles, library.names().size());
+  boost::filesystem::remove_all(spill);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::Time::init();
+  return RUN_ALL_TESTS();
+}
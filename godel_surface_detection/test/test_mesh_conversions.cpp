@@ -0,0 +1,235 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include "utils/mesh_conversions.h"
+
+namespace
+{
+
+// A flat n x n vertex grid in the z = 0 plane with two triangles per cell
+pcl::PolygonMesh makeGridMesh(int n, double spacing)
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      cloud.push_back(pcl::PointXYZ(i * spacing, j * spacing, 0.0));
+
+  pcl::PolygonMesh mesh;
+  pcl::toPCLPointCloud2(cloud, mesh.cloud);
+  for (int i = 0; i + 1 < n; ++i)
+  {
+    for (int j = 0; j + 1 < n; ++j)
+    {
+      const uint32_t a = i * n + j, b = (i + 1) * n + j, c = (i + 1) * n + j + 1, d = i * n + j + 1;
+      pcl::Vertices t1, t2;
+      t1.vertices = {a, b, c};
+      t2.vertices = {c, d, a};
+      mesh.polygons.push_back(t1);
+      mesh.polygons.push_back(t2);
+    }
+  }
+  return mesh;
+}
+
+} // end anon namespace
+
+TEST(MeshConversions, decimationDisabledMatchesFullConversion)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(10, 0.001);
+  std::vector<geometry_msgs::Point> full, decimated;
+  godel_surface_detection::meshToTrianglePoints(mesh, full);
+  godel_surface_detection::meshToDecimatedTrianglePoints(mesh, 0.0, decimated);
+  EXPECT_EQ(full, decimated);
+}
+
+TEST(MeshConversions, decimationReducesTriangles)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(101, 0.001); // 10cm square, 1mm spacing
+  std::vector<geometry_msgs::Point> full, decimated;
+  godel_surface_detection::meshToTrianglePoints(mesh, full);
+  godel_surface_detection::meshToDecimatedTrianglePoints(mesh, 0.005, decimated);
+
+  ASSERT_EQ(0u, decimated.size() % 3);
+  EXPECT_GT(decimated.size(), 0u);
+  EXPECT_LT(decimated.size() * 10, full.size());
+
+  // Decimation must stay inside the original extents and in the original plane
+  for (const auto& p : decimated)
+  {
+    EXPECT_GE(p.x, 0.0);
+    EXPECT_LE(p.x, 0.1 + 1e-9);
+    EXPECT_GE(p.y, 0.0);
+    EXPECT_LE(p.y, 0.1 + 1e-9);
+    EXPECT_NEAR(0.0, p.z, 1e-9);
+  }
+
+  // No collapsed triangles
+  for (std::size_t i = 0; i < decimated.size(); i += 3)
+  {
+    EXPECT_FALSE(decimated[i] == decimated[i + 1]);
+    EXPECT_FALSE(decimated[i + 1] == decimated[i + 2]);
+    EXPECT_FALSE(decimated[i] == decimated[i + 2]);
+  }
+}
+
+TEST(MeshConversions, decimationRejectsLargePolygons)
+{
+  pcl::PolygonMesh mesh = makeGridMesh(3, 0.01);
+  pcl::Vertices pentagon;
+  pentagon.vertices = {0, 1, 2, 3, 4};
+  mesh.polygons.push_back(pentagon);
+
+  std::vector<geometry_msgs::Point> points;
+  EXPECT_THROW(godel_surface_detection::meshToDecimatedTrianglePoints(mesh, 0.005, points), std::invalid_argument);
+}
+
+TEST(MeshConversions, fieldViewReadsColoredClouds)
+{
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  pcl::PointXYZRGB p;
+  p.x = 1.0f;
+  p.y = 2.0f;
+  p.z = 3.0f;
+  p.r = 255;
+  cloud.push_back(p);
+
+  pcl::PCLPointCloud2 blob;
+  pcl::toPCLPointCloud2(cloud, blob);
+  godel_surface_detection::PointCloud2XYZView view(blob);
+  ASSERT_EQ(1u, view.size());
+  EXPECT_DOUBLE_EQ(1.0, view[0].x);
+  EXPECT_DOUBLE_EQ(2.0, view[0].y);
+  EXPECT_DOUBLE_EQ(3.0, view[0].z);
+
+  pcl::PCLPointCloud2 no_xyz;
+  EXPECT_THROW(godel_surface_detection::PointCloud2XYZView view2(no_xyz), std::invalid_argument);
+}
+
+TEST(MeshConversions, indexedRoundTrip)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(20, 0.01);
+  shape_msgs::Mesh indexed;
+  godel_surface_detection::meshToIndexedMesh(mesh, indexed);
+  EXPECT_EQ(400u, indexed.vertices.size());
+  EXPECT_EQ(mesh.polygons.size(), indexed.triangles.size());
+
+  pcl::PolygonMesh restored;
+  godel_surface_detection::indexedMeshToMesh(indexed, restored);
+
+  std::vector<geometry_msgs::Point> expected, actual;
+  godel_surface_detection::meshToTrianglePoints(mesh, expected);
+  godel_surface_detection::meshToTrianglePoints(restored, actual);
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(MeshConversions, trianglePointsRoundTripSharesVertices)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(20, 0.01);
+  std::vector<geometry_msgs::Point> points;
+  godel_surface_detection::meshToTrianglePoints(mesh, points);
+
+  // The triangle list repeats every interior vertex; converting back must weld them
+  pcl::PolygonMesh restored;
+  godel_surface_detection::trianglePointsToMesh(points, restored);
+  EXPECT_EQ(400u, restored.cloud.width * restored.cloud.height);
+  EXPECT_EQ(mesh.polygons.size(), restored.polygons.size());
+
+  std::vector<geometry_msgs::Point> round_trip;
+  godel_surface_detection::meshToTrianglePoints(restored, round_trip);
+  EXPECT_EQ(points, round_trip);
+}
+
+TEST(MeshConversions, weldMergesNearbyVertices)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(10, 0.01);
+  std::vector<geometry_msgs::Point> points;
+  godel_surface_detection::meshToTrianglePoints(mesh, points);
+
+  // Jitter each copy of a vertex by much less than the weld tolerance
+  for (std::size_t i = 0; i < points.size(); ++i)
+    points[i].x += (i % 7) * 1e-6;
+
+  shape_msgs::Mesh exact, welded;
+  godel_surface_detection::trianglePointsToIndexedMesh(points, 0.0, exact);
+  godel_surface_detection::trianglePointsToIndexedMesh(points, 1e-4, welded);
+  EXPECT_GT(exact.vertices.size(), 100u);
+  EXPECT_EQ(100u, welded.vertices.size());
+  EXPECT_EQ(mesh.polygons.size(), welded.triangles.size());
+
+  // Welding an already indexed mesh in place gives the same vertex count
+  const std::size_t removed = godel_surface_detection::weldVertices(exact, 1e-4);
+  EXPECT_EQ(100u, exact.vertices.size());
+  EXPECT_GT(removed, 0u);
+}
+
+TEST(MeshConversions, indexedConversionWeldsTriangleSoup)
+{
+  const pcl::PolygonMesh grid = makeGridMesh(10, 0.01);
+  std::vector<geometry_msgs::Point> points;
+  godel_surface_detection::meshToTrianglePoints(grid, points);
+
+  // Give every triangle its own jittered copy of its corners, as a mesher emitting a soup would
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  pcl::PolygonMesh soup;
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    cloud.push_back(pcl::PointXYZ(points[i].x + (i % 5) * 1e-6, points[i].y, points[i].z));
+    if (i % 3 == 2)
+    {
+      pcl::Vertices t;
+      t.vertices = {static_cast<uint32_t>(i - 2), static_cast<uint32_t>(i - 1), static_cast<uint32_t>(i)};
+      soup.polygons.push_back(t);
+    }
+  }
+  pcl::toPCLPointCloud2(cloud, soup.cloud);
+
+  shape_msgs::Mesh exact, welded;
+  godel_surface_detection::meshToIndexedMesh(soup, exact);
+  godel_surface_detection::meshToIndexedMesh(soup, welded, 1e-4);
+  EXPECT_EQ(points.size(), exact.vertices.size());
+  EXPECT_EQ(100u, welded.vertices.size());
+  EXPECT_EQ(grid.polygons.size(), welded.triangles.size());
+}
+
+TEST(MeshConversions, weldDropsCollapsedTriangles)
+{
+  const pcl::PolygonMesh mesh = makeGridMesh(10, 0.001);
+  shape_msgs::Mesh indexed;
+  godel_surface_detection::meshToIndexedMesh(mesh, indexed);
+
+  // A tolerance larger than the grid spacing collapses neighbouring vertices
+  godel_surface_detection::weldVertices(indexed, 0.0015);
+  EXPECT_LT(indexed.vertices.size(), 100u);
+  for (const auto& t : indexed.triangles)
+  {
+    EXPECT_NE(t.vertex_indices[0], t.vertex_indices[1]);
+    EXPECT_NE(t.vertex_indices[1], t.vertex_indices[2]);
+    EXPECT_NE(t.vertex_indices[0], t.vertex_indices[2]);
+    EXPECT_LT(t.vertex_indices[0], indexed.vertices.size());
+    EXPECT_LT(t.vertex_indices[1], indexed.vertices.size());
+    EXPECT_LT(t.vertex_indices[2], indexed.vertices.size());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,273 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <scan/next_best_view.h>
+#include <synthetic/synthetic_workload.h>
+#include "synthetic_scenes.h"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <unordered_set>
+
+using namespace godel_surface_detection;
+using namespace godel_surface_detection::synthetic;
+using godel_surface_detection::scan::NextBestViewParameters;
+using godel_surface_detection::scan::NextBestViewPlanner;
+using godel_surface_detection::scan::VisibilityMap;
+
+namespace
+{
+
+const double COVERED_DISTANCE = 0.003; // (m) a ground truth point this close to a scanned one was seen
+
+// The plate with a boss and a 3cm through hole
+PartDescription makePart()
+{
+  PartDescription part = test::plateWithBoss(50000);
+  part.primitives.push_back(cutOut(cylinder(-0.05, -0.03, 0.0, 0.015, 1.0)));
+  return part;
+}
+
+NextBestViewParameters makeParameters()
+{
+  NextBestViewParameters params;
+  params.map_min = Eigen::Vector3d(-0.15, -0.15, 0.01);
+  params.map_max = Eigen::Vector3d(0.15, 0.15, 0.12);
+  params.standoff = 0.4 * std::sqrt(2.0);
+  params.fov_horizontal = 2.0 * std::atan(160.0 / 262.5);
+  params.fov_vertical = 2.0 * std::atan(120.0 / 262.5);
+  return params;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB> toRGB(const LabelledCloud& view)
+{
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  for (const auto& p : view.points)
+  {
+    pcl::PointXYZRGB q;
+    q.x = p.x;
+    q.y = p.y;
+    q.z = p.z;
+    cloud.points.push_back(q);
+  }
+  return cloud;
+}
+
+struct CellHash
+{
+  std::size_t operator()(const Eigen::Vector3i& c) const
+  {
+    return (static_cast<std::size_t>(c.x()) * 73856093u) ^ (static_cast<std::size_t>(c.y()) * 19349663u) ^
+           (static_cast<std::size_t>(c.z()) * 83492791u);
+  }
+};
+
+// Share of the visible surface of a part (every face but the bottoms on the table) that the
+// views observed
+class TrueCoverage
+{
+public:
+  explicit TrueCoverage(const PartDescription& part)
+  {
+    generatePart(part, truth_);
+    names_ = surfaceNames(part);
+  }
+
+  void add(const LabelledCloud& view)
+  {
+    for (const auto& p : view.points)
+    {
+      if (p.label != NO_SURFACE)
+        seen_.insert(cell(p));
+    }
+  }
+
+  double value() const
+  {
+    std::size_t visible = 0, covered = 0;
+    for (const auto& p : truth_.points)
+    {
+      const std::string& name = names_[p.label - 1];
+      if (name.size() > 3 && name.compare(name.size() - 3, 3, "/-z") == 0)
+        continue;
+      ++visible;
+      const Eigen::Vector3i c = cell(p);
+      bool found = false;
+      for (int dx = -1; dx <= 1 && !found; ++dx)
+        for (int dy = -1; dy <= 1 && !found; ++dy)
+          for (int dz = -1; dz <= 1 && !found; ++dz)
+            found = seen_.count(c + Eigen::Vector3i(dx, dy, dz)) > 0;
+      covered += found;
+    }
+    return static_cast<double>(covered) / visible;
+  }
+
+private:
+  static Eigen::Vector3i cell(const LabelledPoint& p)
+  {
+    return Eigen::Vector3i(static_cast<int>(std::floor(p.x / COVERED_DISTANCE)),
+                           static_cast<int>(std::floor(p.y / COVERED_DISTANCE)),
+                           static_cast<int>(std::floor(p.z / COVERED_DISTANCE)));
+  }
+
+  LabelledCloud truth_;
+  std::vector<std::string> names_;
+  std::unordered_set<Eigen::Vector3i, CellHash> seen_;
+};
+
+struct ScanResult
+{
+  std::size_t views;
+  double time;
+  double coverage;
+};
+
+ScanResult runNextBestView(const NextBestViewPlanner::ReachabilityCheck& reachable, std::vector<Eigen::Affine3d>& poses)
+{
+  const PartDescription part = makePart();
+  const PartDescription scene = test::onTable(part);
+  NextBestViewPlanner planner(test::circularSweep(), makeParameters(), reachable);
+  TrueCoverage coverage(part);
+
+  int next;
+  while ((next = planner.nextView()) >= 0)
+  {
+    LabelledCloud view;
+    simulateView(scene, test::scaledCamera(2), planner.candidates()[next], planner.views(), view);
+    coverage.add(view);
+    planner.addView(next, toRGB(view));
+    poses.push_back(planner.candidates()[next]);
+  }
+  return {planner.views(), planner.scanTime(), coverage.value()};
+}
+
+} // end anon namespace
+
+TEST(NextBestView, mapRecordsObservedSurfaceAndFreeSpace)
+{
+  // A 10cm square patch 5cm above the map floor, seen from 50cm straight above
+  VisibilityMap map(Eigen::Affine3d::Identity(), Eigen::Vector3d(-0.1, -0.1, 0.0), Eigen::Vector3d(0.1, 0.1, 0.2),
+                    0.01);
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  for (double x = -0.0495; x < 0.05; x += 0.002)
+  {
+    for (double y = -0.0495; y < 0.05; y += 0.002)
+    {
+      pcl::PointXYZRGB p;
+      p.x = x;
+      p.y = y;
+      p.z = 0.055;
+      cloud.points.push_back(p);
+    }
+  }
+  pcl::PointXYZRGB nan;
+  nan.x = nan.y = nan.z = std::numeric_limits<float>::quiet_NaN();
+  cloud.points.push_back(nan);
+
+  const Eigen::Vector3d camera(0.0, 0.0, 0.555);
+  map.integrate(cloud, camera);
+
+  EXPECT_EQ(100u, map.occupiedCells());
+  EXPECT_EQ(VisibilityMap::OCCUPIED, map.at(Eigen::Vector3d(0.0, 0.0, 0.055)));
+  EXPECT_EQ(VisibilityMap::FREE, map.at(Eigen::Vector3d(0.0, 0.0, 0.15)));
+  EXPECT_EQ(VisibilityMap::UNKNOWN, map.at(Eigen::Vector3d(0.0, 0.0, 0.03)));
+  EXPECT_EQ(VisibilityMap::UNKNOWN, map.at(Eigen::Vector3d(0.08, 0.08, 0.15)));
+
+  double range = 0.0;
+  EXPECT_EQ(VisibilityMap::OCCUPIED, map.castRay(camera, -Eigen::Vector3d::UnitZ(), 0.3, 3.0, range));
+  EXPECT_NEAR(0.5, range, 0.01);
+  EXPECT_EQ(VisibilityMap::UNKNOWN,
+            map.castRay(Eigen::Vector3d(0.08, 0.08, 0.555), -Eigen::Vector3d::UnitZ(), 0.3, 3.0, range));
+  EXPECT_EQ(VisibilityMap::FREE, map.castRay(camera, Eigen::Vector3d::UnitZ(), 0.3, 3.0, range));
+
+  // Only the patch was seen, surrounded by unknown space
+  EXPECT_GT(map.frontierCells(), 0u);
+  EXPECT_GT(map.coverage(), 0.0);
+  EXPECT_LT(map.coverage(), 0.5);
+}
+
+TEST(NextBestView, candidatesLookAtTheMapCenter)
+{
+  const NextBestViewParameters params = makeParameters();
+  const std::vector<Eigen::Affine3d> poses = NextBestViewPlanner::candidatePoses(test::circularSweep(), params);
+  ASSERT_EQ(params.elevations.size() * params.azimuths, poses.size());
+
+  const Eigen::Vector3d center = 0.5 * (params.map_min + params.map_max);
+  for (const auto& pose : poses)
+  {
+    const Eigen::Vector3d to_center = center - pose.translation();
+    EXPECT_NEAR(params.standoff, to_center.norm(), 1e-9);
+    EXPECT_NEAR(1.0, pose.linear().col(0).dot(to_center.normalized()), 1e-9);
+    EXPECT_NEAR(0.0, pose.linear().col(1).z(), 1e-9);
+    EXPECT_NEAR(1.0, pose.linear().determinant(), 1e-9);
+  }
+}
+
+TEST(NextBestView, coversThePartFasterThanTheCircularSweep)
+{
+  // Circular sweep
+  const PartDescription part = makePart();
+  const PartDescription scene = test::onTable(part);
+  const std::vector<Eigen::Affine3d> sweep = scanCameraPoses(test::circularSweep());
+  NextBestViewPlanner timing(test::circularSweep(), makeParameters());
+  TrueCoverage sweep_coverage(part);
+  double sweep_time = 0.0;
+  for (std::size_t i = 0; i < sweep.size(); ++i)
+  {
+    LabelledCloud view;
+    simulateView(scene, test::scaledCamera(2), sweep[i], i, view);
+    sweep_coverage.add(view);
+    sweep_time += (i > 0 ? timing.motionTime(sweep[i - 1], sweep[i]) : 0.0) + makeParameters().capture_time;
+  }
+
+  std::vector<Eigen::Affine3d> poses;
+  const ScanResult nbv = runNextBestView(NextBestViewPlanner::ReachabilityCheck(), poses);
+
+  std::cout << "circular sweep: " << sweep.size() << " views, " << sweep_time << " s, "
+            << 100.0 * sweep_coverage.value() << "% of the surface\n"
+            << "next best view: " << nbv.views << " views, " << nbv.time << " s, " << 100.0 * nbv.coverage
+            << "% of the surface\n";
+  RecordProperty("sweep_views", sweep.size());
+  RecordProperty("next_best_view_views", nbv.views);
+
+  EXPECT_GT(nbv.coverage, 0.9);
+  EXPECT_GT(nbv.coverage, sweep_coverage.value() - 0.02);
+  EXPECT_LT(nbv.views, sweep.size());
+  EXPECT_LT(nbv.time, sweep_time);
+}
+
+TEST(NextBestView, onlyReachableViewsAreTaken)
+{
+  // The robot can only reach the +y half of the part
+  auto reachable = [](const Eigen::Affine3d& world_to_cam) { return world_to_cam.translation().y() > 0.0; };
+  std::vector<Eigen::Affine3d> poses;
+  const ScanResult nbv = runNextBestView(reachable, poses);
+
+  ASSERT_FALSE(poses.empty());
+  for (const auto& pose : poses)
+    EXPECT_TRUE(reachable(pose));
+  EXPECT_LE(nbv.views, static_cast<std::size_t>(makeParameters().max_views));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,244 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <segmentation/normal_estimation.h>
+
+#include <Eigen/Eigenvalues>
+#include <pcl/features/normal_3d.h>
+#include <pcl/search/kdtree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace godel_surface_detection;
+
+namespace
+{
+
+typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+
+// As segmentation uses them
+const static double NORMAL_RADIUS = 0.025;
+const static double SPACING = 0.003;
+const static double SENSOR_NOISE = 0.0005;
+
+void addPoint(CloudRGB& cloud, double x, double y, double z, std::mt19937& rng)
+{
+  std::normal_distribution<double> noise(0.0, SENSOR_NOISE);
+  pcl::PointXYZRGB p;
+  p.x = x + noise(rng);
+  p.y = y + noise(rng);
+  p.z = z + noise(rng);
+  cloud.push_back(p);
+}
+
+/**
+ * @brief The top and sides of a 0.2 x 0.15 x 0.05 m block, with a scanner above it, so that the
+ * normals meet at creases and the ones of the sides face outwards
+ */
+CloudRGB::Ptr makeBlockCloud()
+{
+  const double sx = 0.2, sy = 0.15, sz = 0.05;
+  std::mt19937 rng(42);
+  CloudRGB::Ptr cloud(new CloudRGB());
+  for (double x = 0.0; x <= sx; x += SPACING)
+    for (double y = 0.0; y <= sy; y += SPACING)
+      addPoint(*cloud, x, y, sz, rng);
+  for (double z = 0.0; z < sz; z += SPACING)
+  {
+    for (double x = 0.0; x <= sx; x += SPACING)
+    {
+      addPoint(*cloud, x, 0.0, z, rng);
+      addPoint(*cloud, x, sy, z, rng);
+    }
+    for (double y = SPACING; y < sy; y += SPACING)
+    {
+      addPoint(*cloud, 0.0, y, z, rng);
+      addPoint(*cloud, sx, y, z, rng);
+    }
+  }
+  cloud->width = cloud->size();
+  cloud->height = 1;
+  cloud->is_dense = true;
+  cloud->sensor_origin_ = Eigen::Vector4f(0.1f, 0.075f, 1.0f, 0.0f);
+  return cloud;
+}
+
+// The value below which the given share of the values lie
+double percentile(std::vector<double> values, double share)
+{
+  const std::size_t n = std::min(values.size() - 1, static_cast<std::size_t>(share * values.size()));
+  std::nth_element(values.begin(), values.begin() + n, values.end());
+  return values[n];
+}
+
+} // end anon namespace
+
+TEST(NormalEstimation, solvesSymmetricMatrices)
+{
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> coeff(-1.0, 1.0);
+  for (int i = 0; i < 1000; ++i)
+  {
+    // Covariances of neighbourhoods from flat to round, at the scale of sensor data
+    const Eigen::Vector3d spread(1e-4, 1e-4 * std::abs(coeff(rng)),
+                                 1e-4 * std::pow(10.0, -6.0 * std::abs(coeff(rng))));
+    const Eigen::Matrix3d rotation =
+        Eigen::Quaterniond(coeff(rng), coeff(rng), coeff(rng), coeff(rng)).normalized().toRotationMatrix();
+    const Eigen::Matrix3d m = rotation * spread.asDiagonal() * rotation.transpose();
+
+    Eigen::Vector3d values, vector;
+    smallestEigenvector(m, values, vector);
+    const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> reference(m);
+    EXPECT_NEAR(reference.eigenvalues()(0), values(0), 1e-10);
+    EXPECT_NEAR(reference.eigenvalues()(2), values(2), 1e-10);
+    EXPECT_NEAR(1.0, vector.norm(), 1e-9);
+    // The eigenvector is only defined when the smallest eigenvalue is well separated
+    if (reference.eigenvalues()(1) - reference.eigenvalues()(0) > 1e-8)
+    {
+      EXPECT_NEAR(1.0, std::abs(vector.dot(reference.eigenvectors().col(0))), 1e-6);
+    }
+  }
+}
+
+TEST(NormalEstimation, handlesDegenerateMatrices)
+{
+  Eigen::Vector3d values, vector;
+
+  // Points on a line: any normal orthogonal to it
+  const Eigen::Vector3d line = Eigen::Vector3d(1.0, 2.0, 3.0).normalized();
+  smallestEigenvector(line * line.transpose(), values, vector);
+  EXPECT_NEAR(0.0, values(0), 1e-12);
+  EXPECT_NEAR(1.0, vector.norm(), 1e-9);
+  EXPECT_NEAR(0.0, vector.dot(line), 1e-9);
+
+  // Already diagonal
+  smallestEigenvector(Eigen::Vector3d(3.0, 1.0, 2.0).asDiagonal(), values, vector);
+  EXPECT_NEAR(1.0, values(0), 1e-12);
+  EXPECT_NEAR(1.0, std::abs(vector.y()), 1e-9);
+
+  // All directions alike, and no spread at all
+  smallestEigenvector(Eigen::Matrix3d::Identity(), values, vector);
+  EXPECT_NEAR(1.0, vector.norm(), 1e-9);
+  smallestEigenvector(Eigen::Matrix3d::Zero(), values, vector);
+  EXPECT_NEAR(1.0, vector.norm(), 1e-9);
+  EXPECT_EQ(0.0, values(0));
+}
+
+TEST(NormalEstimation, matchesPclNormals)
+{
+  const CloudRGB::Ptr cloud = makeBlockCloud();
+
+  pcl::PointCloud<pcl::Normal> expected;
+  pcl::NormalEstimation<pcl::PointXYZRGB, pcl::Normal> ne;
+  ne.setInputCloud(cloud);
+  ne.setSearchMethod(pcl::search::KdTree<pcl::PointXYZRGB>::Ptr(new pcl::search::KdTree<pcl::PointXYZRGB>()));
+  ne.setRadiusSearch(NORMAL_RADIUS);
+  ne.compute(expected);
+
+  pcl::PointCloud<pcl::Normal> normals;
+  estimateNormals(*cloud, NORMAL_RADIUS, 2, normals);
+  ASSERT_EQ(expected.size(), normals.size());
+  EXPECT_TRUE(normals.is_dense);
+
+  std::vector<double> angles, curvatures;
+  for (std::size_t i = 0; i < normals.size(); ++i)
+  {
+    const Eigen::Vector3d a(expected[i].normal_x, expected[i].normal_y, expected[i].normal_z);
+    const Eigen::Vector3d b(normals[i].normal_x, normals[i].normal_y, normals[i].normal_z);
+    ASSERT_TRUE(std::isfinite(b.norm())) << "at point " << i;
+    // Same orientation, so no absolute value
+    angles.push_back(std::acos(std::min(1.0, a.dot(b) / (a.norm() * b.norm()))));
+    curvatures.push_back(std::abs(expected[i].curvature - normals[i].curvature));
+  }
+
+  // PCL sums the moments of the absolute coordinates in floats, which costs it more precision than
+  // the closed form solution does; neighbours right at the radius can also fall either side of it
+  EXPECT_LT(percentile(angles, 0.5), 1e-4);
+  EXPECT_LT(percentile(angles, 0.99), 1e-3);
+  EXPECT_LT(percentile(curvatures, 0.99), 5e-4);
+}
+
+TEST(NormalEstimation, estimatesSelectedPoints)
+{
+  const CloudRGB::Ptr cloud = makeBlockCloud();
+  pcl::PointCloud<pcl::Normal> all;
+  estimateNormals(*cloud, NORMAL_RADIUS, 0, all);
+
+  // Every third point; the others keep what they had
+  std::vector<uint8_t> selected(cloud->size(), 0);
+  pcl::PointCloud<pcl::Normal> some;
+  some.points.resize(cloud->size());
+  for (std::size_t i = 0; i < cloud->size(); i += 3)
+    selected[i] = 1;
+  estimateNormals(*cloud, selected, NORMAL_RADIUS, 0, some);
+
+  for (std::size_t i = 0; i < cloud->size(); ++i)
+  {
+    if (selected[i])
+    {
+      EXPECT_EQ(all[i].normal_x, some[i].normal_x);
+      EXPECT_EQ(all[i].curvature, some[i].curvature);
+    }
+    else
+    {
+      EXPECT_EQ(0.0f, some[i].normal_x);
+    }
+  }
+}
+
+TEST(NormalEstimation, marksPointsWithoutNormals)
+{
+  CloudRGB cloud;
+  for (int i = 0; i < 10; ++i)
+  {
+    pcl::PointXYZRGB p;
+    p.x = 0.001f * i;
+    p.y = 0.001f * (i % 3);
+    p.z = 0.0f;
+    cloud.push_back(p);
+  }
+  pcl::PointXYZRGB alone;
+  alone.x = alone.y = alone.z = 1.0f;
+  cloud.push_back(alone);
+  pcl::PointXYZRGB invalid;
+  invalid.x = invalid.y = invalid.z = std::numeric_limits<float>::quiet_NaN();
+  cloud.push_back(invalid);
+  cloud.sensor_origin_ = Eigen::Vector4f(0.0f, 0.0f, -1.0f, 0.0f);
+
+  pcl::PointCloud<pcl::Normal> normals;
+  estimateNormals(cloud, NORMAL_RADIUS, 0, normals);
+  ASSERT_EQ(cloud.size(), normals.size());
+  EXPECT_FALSE(normals.is_dense);
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    EXPECT_NEAR(-1.0, normals[i].normal_z, 1e-6) << "at point " << i;
+    EXPECT_NEAR(0.0, normals[i].curvature, 1e-6) << "at point " << i;
+  }
+  EXPECT_TRUE(std::isnan(normals[10].normal_x));
+  EXPECT_TRUE(std::isnan(normals[11].normal_x));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,267 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <batch/part_batch.h>
+#include <gtest/gtest.h>
+#include <synthetic/synthetic_workload.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace godel_surface_detection;
+using namespace godel_surface_detection::batch;
+
+namespace
+{
+
+// 20cm x 12cm plate with a block off its center and a through hole: no rotation maps it onto itself
+synthetic::PartDescription makeBracket()
+{
+  synthetic::PartDescription part;
+  part.primitives.push_back(synthetic::box(0.0, 0.0, 0.01, 0.2, 0.12, 0.02));
+  part.primitives.push_back(synthetic::box(0.05, 0.02, 0.04, 0.06, 0.05, 0.04));
+  part.primitives.push_back(synthetic::cutOut(synthetic::cylinder(-0.05, 0.0, 0.0, 0.02, 1.0)));
+  part.target_points = 40000;
+  return part;
+}
+
+// A plain 15cm x 15cm plate
+synthetic::PartDescription makePlate()
+{
+  synthetic::PartDescription part;
+  part.primitives.push_back(synthetic::box(0.0, 0.0, 0.01, 0.15, 0.15, 0.02));
+  part.target_points = 30000;
+  return part;
+}
+
+struct Surface
+{
+  std::string name;
+  std::size_t part;
+  Cloud::ConstPtr cloud;
+};
+
+// Adds a part lying on the table at 'pose' to the scene, one cloud per surface. Bottom faces sit
+// on the table and are left out, as are surfaces hidden by the rest of the part.
+void addPart(synthetic::PartDescription part, const Eigen::Affine3d& pose, unsigned seed, std::vector<Surface>& scene)
+{
+  for (auto& primitive : part.primitives)
+    primitive.pose = pose * primitive.pose;
+  part.seed = seed;
+
+  synthetic::LabelledCloud cloud;
+  ASSERT_TRUE(synthetic::generatePart(part, cloud));
+  const std::vector<std::string> names = synthetic::surfaceNames(part);
+
+  std::vector<Cloud::Ptr> surfaces(names.size());
+  for (auto& s : surfaces)
+    s.reset(new Cloud);
+  for (const auto& pt : cloud.points)
+  {
+    pcl::PointXYZRGB p;
+    p.x = pt.x;
+    p.y = pt.y;
+    p.z = pt.z;
+    surfaces[pt.label - 1]->push_back(p);
+  }
+
+  const std::size_t part_index = scene.empty() ? 0 : scene.back().part + 1;
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    if (surfaces[i]->size() < 100 || names[i].find("/-z") != std::string::npos)
+      continue;
+    scene.push_back(Surface{names[i], part_index, surfaces[i]});
+  }
+}
+
+std::vector<Cloud::ConstPtr> clouds(const std::vector<Surface>& scene)
+{
+  std::vector<Cloud::ConstPtr> result;
+  for (const auto& s : scene)
+    result.push_back(s.cloud);
+  return result;
+}
+
+PartFeatures features(const std::vector<Surface>& scene, std::size_t part, std::vector<std::string>& names)
+{
+  std::vector<Cloud::ConstPtr> surfaces;
+  names.clear();
+  for (const auto& s : scene)
+  {
+    if (s.part == part)
+    {
+      surfaces.push_back(s.cloud);
+      names.push_back(s.name);
+    }
+  }
+  return computeFeatures(surfaces, BatchParameters());
+}
+
+Eigen::Affine3d placement(double x, double y, double yaw)
+{
+  return Eigen::Translation3d(x, y, 0.0) * Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ());
+}
+
+} // end anon namespace
+
+TEST(PartBatch, surfacesAreClusteredByPart)
+{
+  std::vector<Surface> scene;
+  addPart(makeBracket(), placement(0.0, 0.0, 0.0), 1, scene);
+  addPart(makeBracket(), placement(0.3, 0.05, 1.0), 2, scene);
+  addPart(makePlate(), placement(0.0, 0.3, 0.3), 3, scene);
+
+  const std::vector<std::vector<std::size_t>> parts = clusterSurfaces(clouds(scene), 0.005);
+  ASSERT_EQ(3u, parts.size());
+  for (std::size_t p = 0; p < parts.size(); ++p)
+  {
+    std::size_t expected = 0;
+    for (const auto& s : scene)
+      expected += s.part == p;
+    ASSERT_EQ(expected, parts[p].size());
+    for (std::size_t s : parts[p])
+      EXPECT_EQ(p, scene[s].part);
+  }
+}
+
+TEST(PartBatch, identicalPartIsRegistered)
+{
+  const Eigen::Affine3d truth = placement(0.35, -0.1, 2.2);
+  std::vector<Surface> scene;
+  addPart(makeBracket(), Eigen::Affine3d::Identity(), 1, scene);
+  addPart(makeBracket(), truth, 2, scene);
+
+  std::vector<std::string> ref_names, part_names;
+  const PartFeatures reference = features(scene, 0, ref_names);
+  const PartFeatures part = features(scene, 1, part_names);
+
+  const Registration r = registerParts(reference, part, BatchParameters());
+  ASSERT_TRUE(r.matched);
+  EXPECT_LT(r.rms, 0.003);
+  EXPECT_LT((r.transform.translation() - truth.translation()).norm(), 0.002);
+  EXPECT_LT(Eigen::AngleAxisd(r.transform.linear().transpose() * truth.linear()).angle(), 0.01);
+
+  ASSERT_EQ(ref_names.size(), r.surface_map.size());
+  for (std::size_t i = 0; i < ref_names.size(); ++i)
+  {
+    ASSERT_GE(r.surface_map[i], 0);
+    EXPECT_EQ(ref_names[i], part_names[r.surface_map[i]]);
+  }
+}
+
+TEST(PartBatch, differentPartIsNotRegistered)
+{
+  std::vector<Surface> scene;
+  addPart(makeBracket(), Eigen::Affine3d::Identity(), 1, scene);
+  addPart(makePlate(), placement(0.3, 0.0, 0.5), 2, scene);
+
+  std::vector<std::string> names;
+  EXPECT_FALSE(registerParts(features(scene, 0, names), features(scene, 1, names), BatchParameters()).matched);
+
+  // A bracket with its block moved has the same surfaces, but not the same shape
+  synthetic::PartDescription moved = makeBracket();
+  moved.primitives[1].pose = Eigen::Translation3d(-0.05, -0.02, 0.04);
+  moved.primitives[2].pose = Eigen::Translation3d(0.05, 0.0, 0.0);
+  moved.primitives[2].size *= 0.5;
+  scene.clear();
+  addPart(makeBracket(), Eigen::Affine3d::Identity(), 1, scene);
+  addPart(moved, placement(0.3, 0.0, 0.5), 2, scene);
+  EXPECT_FALSE(registerParts(features(scene, 0, names), features(scene, 1, names), BatchParameters()).matched);
+}
+
+TEST(PartBatch, batchReusesIdenticalParts)
+{
+  std::vector<Surface> scene;
+  addPart(makeBracket(), placement(0.0, 0.0, 0.0), 1, scene);
+  addPart(makePlate(), placement(0.4, 0.0, 0.0), 2, scene);
+  addPart(makeBracket(), placement(0.3, 0.3, 3.0), 3, scene);
+  addPart(makeBracket(), placement(0.0, 0.3, -1.2), 4, scene);
+
+  const PartBatch batch = planBatch(clouds(scene), BatchParameters(), Eigen::Vector3d(-0.5, 0.0, 0.0));
+  ASSERT_EQ(4u, batch.parts.size());
+
+  // From the start, the nearest part is the first bracket; the others are visited around the square
+  std::vector<std::size_t> order;
+  for (const auto& part : batch.parts)
+    order.push_back(scene[part.front()].part);
+  const std::vector<std::size_t> expected = {0, 3, 2, 1};
+  EXPECT_EQ(expected, order);
+
+  const std::vector<int> reference = {-1, 0, 0, -1};
+  EXPECT_EQ(reference, batch.reference);
+  for (std::size_t k = 0; k < batch.parts.size(); ++k)
+    EXPECT_EQ(reference[k] >= 0, batch.registrations[k].matched);
+}
+
+TEST(PartBatch, scheduleIsShort)
+{
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> position(-0.5, 0.5);
+  const Eigen::Vector3d start(-1.0, 0.0, 0.0);
+
+  for (int trial = 0; trial < 10; ++trial)
+  {
+    std::vector<Eigen::Vector3d> positions;
+    for (int i = 0; i < 7; ++i)
+      positions.push_back(Eigen::Vector3d(position(rng), position(rng), 0.0));
+
+    std::vector<std::size_t> order = scheduleParts(positions, start);
+    ASSERT_EQ(positions.size(), order.size());
+    const double scheduled = traverseLength(positions, order, start);
+
+    std::sort(order.begin(), order.end());
+    double best = std::numeric_limits<double>::max();
+    do
+      best = std::min(best, traverseLength(positions, order, start));
+    while (std::next_permutation(order.begin(), order.end()));
+    EXPECT_LE(scheduled, 1.05 * best);
+  }
+}
+
+TEST(PartBatch, pathsAreTransformed)
+{
+  const Eigen::Affine3d t = placement(0.2, -0.1, 0.7);
+  const Eigen::Affine3d pose = Eigen::Translation3d(0.1, 0.02, 0.03) * Eigen::AngleAxisd(0.4, Eigen::Vector3d::UnitX());
+
+  std::vector<geometry_msgs::PoseArray> paths(1);
+  paths[0].poses.resize(1);
+  geometry_msgs::Pose& p = paths[0].poses[0];
+  const Eigen::Quaterniond q(pose.linear());
+  p.position.x = pose.translation().x();
+  p.position.y = pose.translation().y();
+  p.position.z = pose.translation().z();
+  p.orientation.w = q.w();
+  p.orientation.x = q.x();
+  p.orientation.y = q.y();
+  p.orientation.z = q.z();
+
+  transformPaths(t, paths);
+
+  const Eigen::Affine3d expected = t * pose;
+  const Eigen::Quaterniond result(p.orientation.w, p.orientation.x, p.orientation.y, p.orientation.z);
+  EXPECT_LT((Eigen::Vector3d(p.position.x, p.position.y, p.position.z) - expected.translation()).norm(), 1e-9);
+  EXPECT_LT(result.angularDistance(Eigen::Quaterniond(expected.linear())), 1e-9);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
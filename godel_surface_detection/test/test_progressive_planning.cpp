@@ -0,0 +1,369 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Drives SurfaceBlendingService's process planning action end to end. The service plans its
+ * surfaces with the tool planning plugins named in progressive_planning.test; the path generation
+ * and process planning services it calls are stubbed here and take staggered amounts of time.
+ */
+
+#include <gtest/gtest.h>
+#include <actionlib/client/simple_action_client.h>
+#include <godel_msgs/GetAvailableMotionPlans.h>
+#include <godel_msgs/SelectSurface.h>
+#include <pcl/common/io.h>
+#include <pcl/conversions.h>
+#include <services/surface_blending_service.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+
+namespace
+{
+
+const static std::string ACTION_NAME = "process_planning_as";
+const static int NUM_SURFACES = 4;
+const static int FAILING_SURFACE = 2;
+const static double SURFACE_SPACING = 1.0; // (m) along x; surface i starts at x = i
+const static double SURFACE_SIZE = 0.2;    // (m) side of each square surface
+const static int SURFACE_CELLS = 20;       // grid cells along each side of a surface
+const static ros::WallDuration HOLD_TIMEOUT(10.0);
+
+typedef actionlib::SimpleActionClient<godel_msgs::ProcessPlanningAction> PlanningClient;
+
+/**
+ * The path generation and process planning services the blending service calls. Planning
+ * surface i takes (i + 1) * 150ms and one surface fails to plan. A surface can be held: its
+ * planning then waits until release() is called.
+ */
+class PlanningServiceStubs
+{
+public:
+  PlanningServiceStubs() : held_(-1), released_(false), hold_timed_out_(false)
+  {
+    path_server_ = nh_.advertiseService("process_path_generator", &PlanningServiceStubs::generatePath, this);
+    blend_server_ = nh_.advertiseService("blend_process_planning", &PlanningServiceStubs::planBlend, this);
+    keyence_server_ = nh_.advertiseService("keyence_process_planning", &PlanningServiceStubs::planScan, this);
+  }
+
+  void reset(int held)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    started_.clear();
+    held_ = held;
+    released_ = false;
+    hold_timed_out_ = false;
+  }
+
+  void release()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      released_ = true;
+    }
+    release_.notify_all();
+  }
+
+  std::size_t surfacesStarted()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return started_.size();
+  }
+
+  bool holdTimedOut()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hold_timed_out_;
+  }
+
+private:
+  // A raster across the middle of the surface, in the frame of its boundary
+  bool generatePath(godel_msgs::PathPlanning::Request&, godel_msgs::PathPlanning::Response& res)
+  {
+    for (int i = 0; i < 5; ++i)
+    {
+      geometry_msgs::Pose pose;
+      pose.position.x = 0.02 * (i - 2);
+      pose.orientation.w = 1.0;
+      res.poses.poses.push_back(pose);
+    }
+    return true;
+  }
+
+  bool planBlend(godel_msgs::BlendProcessPlanning::Request& req, godel_msgs::BlendProcessPlanning::Response&)
+  {
+    return plan(req.path.segments);
+  }
+
+  bool planScan(godel_msgs::KeyenceProcessPlanning::Request& req, godel_msgs::KeyenceProcessPlanning::Response&)
+  {
+    return plan(req.path.segments);
+  }
+
+  bool plan(const std::vector<geometry_msgs::PoseArray>& segments)
+  {
+    const int surface = surfaceOf(segments);
+    if (surface < 0)
+      return false;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      started_.insert(surface);
+      if (surface == held_ && !released_)
+      {
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(static_cast<int>(HOLD_TIMEOUT.toSec() * 1000));
+        hold_timed_out_ = !release_.wait_until(lock, deadline, [this]() { return released_; });
+      }
+    }
+
+    ros::WallDuration(0.15 * (surface + 1)).sleep();
+    return surface != FAILING_SURFACE;
+  }
+
+  // Which surface a path lies on, from the position of its first pose
+  static int surfaceOf(const std::vector<geometry_msgs::PoseArray>& segments)
+  {
+    for (const auto& segment : segments)
+    {
+      if (!segment.poses.empty())
+        return static_cast<int>(std::round(segment.poses.front().position.x / SURFACE_SPACING));
+    }
+    return -1;
+  }
+
+  ros::NodeHandle nh_;
+  ros::ServiceServer path_server_;
+  ros::ServiceServer blend_server_;
+  ros::ServiceServer keyence_server_;
+
+  std::mutex mutex_;
+  std::condition_variable release_;
+  std::set<int> started_;
+  int held_;
+  bool released_;
+  bool hold_timed_out_;
+};
+
+// A flat square grid of points starting at x = x0, as detection would find it
+void makeSurface(double x0, godel_surface_detection::detection::CloudRGB& cloud, pcl::PolygonMesh& mesh)
+{
+  const int n = SURFACE_CELLS + 1;
+  for (int j = 0; j < n; ++j)
+  {
+    for (int i = 0; i < n; ++i)
+    {
+      pcl::PointXYZRGB p;
+      p.x = x0 + SURFACE_SIZE * i / SURFACE_CELLS;
+      p.y = SURFACE_SIZE * j / SURFACE_CELLS;
+      p.z = 0.0;
+      cloud.push_back(p);
+    }
+  }
+
+  pcl::PointCloud<pcl::PointXYZ> points;
+  pcl::copyPointCloud(cloud, points);
+  pcl::toPCLPointCloud2(points, mesh.cloud);
+  mesh.header.frame_id = "world_frame";
+  for (int j = 0; j < SURFACE_CELLS; ++j)
+  {
+    for (int i = 0; i < SURFACE_CELLS; ++i)
+    {
+      const uint32_t a = j * n + i, b = a + 1, c = a + n, d = c + 1;
+      pcl::Vertices lower, upper;
+      lower.vertices = {a, b, d};
+      upper.vertices = {a, d, c};
+      mesh.polygons.push_back(lower);
+      mesh.polygons.push_back(upper);
+    }
+  }
+}
+
+PlanningServiceStubs* stubs_ptr = nullptr;
+
+class ProgressivePlanningTest : public ::testing::Test
+{
+protected:
+  ProgressivePlanningTest() : client_(ACTION_NAME, true), release_on_feedback_(false) {}
+
+  void SetUp() override { ASSERT_TRUE(client_.waitForServer(ros::Duration(5.0))); }
+
+  void onFeedback(const godel_msgs::ProcessPlanningFeedbackConstPtr& feedback)
+  {
+    // Status-only feedback (e.g. "Generated blend path") doesn't report a finished surface
+    if (feedback->surfaces_total == 0)
+      return;
+
+    // Plans announced in feedback are already in the motion library (e.g. for simulation)
+    godel_msgs::GetAvailableMotionPlans srv;
+    const bool listed = ros::service::call("get_available_motion_plans", srv);
+    bool available = listed && !feedback->plan_names.empty();
+    for (const auto& name : feedback->plan_names)
+      available = available && std::count(srv.response.names.begin(), srv.response.names.end(), name) > 0;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      feedback_.push_back(*feedback);
+      goal_active_at_feedback_.push_back(client_.getState() == actionlib::SimpleClientGoalState::ACTIVE);
+      plan_available_at_feedback_.push_back(available);
+    }
+
+    if (release_on_feedback_)
+      stubs_ptr->release();
+  }
+
+  void sendGoal()
+  {
+    godel_msgs::ProcessPlanningGoal goal;
+    goal.action = godel_msgs::ProcessPlanningGoal::GENERATE_MOTION_PLAN_AND_PREVIEW;
+    client_.sendGoal(goal, PlanningClient::SimpleDoneCallback(), PlanningClient::SimpleActiveCallback(),
+                     boost::bind(&ProgressivePlanningTest::onFeedback, this, _1));
+  }
+
+  std::size_t feedbackCount()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return feedback_.size();
+  }
+
+  bool waitForFeedback()
+  {
+    const ros::WallTime deadline = ros::WallTime::now() + HOLD_TIMEOUT;
+    while (feedbackCount() == 0 && ros::WallTime::now() < deadline)
+      ros::WallDuration(0.01).sleep();
+    return feedbackCount() > 0;
+  }
+
+  static bool hasPlan(const godel_msgs::ProcessPlanningFeedback& feedback, const std::string& suffix)
+  {
+    return std::count(feedback.plan_names.begin(), feedback.plan_names.end(), feedback.surface_name + suffix) > 0;
+  }
+
+  PlanningClient client_;
+  bool release_on_feedback_;
+  std::mutex mutex_;
+  std::vector<godel_msgs::ProcessPlanningFeedback> feedback_;
+  std::vector<bool> goal_active_at_feedback_;
+  std::vector<bool> plan_available_at_feedback_;
+};
+
+} // end anon namespace
+
+TEST_F(ProgressivePlanningTest, streamsSurfacesAsTheyFinish)
+{
+  // The last surface can't finish planning until the first one has been reported, so the goal
+  // only completes if surfaces are streamed while it is still running
+  stubs_ptr->reset(NUM_SURFACES - 1);
+  release_on_feedback_ = true;
+  sendGoal();
+
+  ASSERT_TRUE(client_.waitForResult(ros::Duration(30.0)));
+  EXPECT_EQ(actionlib::SimpleClientGoalState::SUCCEEDED, client_.getState().state_);
+  EXPECT_FALSE(stubs_ptr->holdTimedOut());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT_EQ(static_cast<std::size_t>(NUM_SURFACES - 1), feedback_.size()); // the failing surface is skipped
+  int previous = 0;
+  std::set<std::string> names;
+  std::size_t plans = 0;
+  for (std::size_t i = 0; i < feedback_.size(); ++i)
+  {
+    const auto& fb = feedback_[i];
+    EXPECT_EQ(NUM_SURFACES, fb.surfaces_total);
+    EXPECT_GT(fb.surfaces_completed, previous);
+    previous = fb.surfaces_completed;
+    EXPECT_TRUE(hasPlan(fb, "_blend"));
+    EXPECT_TRUE(hasPlan(fb, "_scan"));
+    EXPECT_FALSE(fb.paths.empty());
+    EXPECT_TRUE(goal_active_at_feedback_[i]);
+    EXPECT_TRUE(plan_available_at_feedback_[i]);
+    names.insert(fb.surface_name);
+    plans += fb.plan_names.size();
+  }
+  EXPECT_EQ(feedback_.size(), names.size());
+
+  const auto result = client_.getResult();
+  EXPECT_TRUE(result->succeeded);
+  EXPECT_EQ(plans, result->plan_names.size());
+}
+
+TEST_F(ProgressivePlanningTest, preemptionSkipsPendingSurfaces)
+{
+  // The second surface is held until the goal has been cancelled
+  stubs_ptr->reset(1);
+  sendGoal();
+  ASSERT_TRUE(waitForFeedback());
+
+  client_.cancelGoal();
+  stubs_ptr->release();
+  ASSERT_TRUE(client_.waitForResult(ros::Duration(30.0)));
+  EXPECT_EQ(actionlib::SimpleClientGoalState::PREEMPTED, client_.getState().state_);
+
+  // The surface being planned when the cancel arrived finishes; everything after it is skipped
+  EXPECT_EQ(2u, stubs_ptr->surfacesStarted());
+
+  const auto result = client_.getResult();
+  ASSERT_TRUE(static_cast<bool>(result));
+  std::size_t plans = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& fb : feedback_)
+      plans += fb.plan_names.size();
+  }
+  EXPECT_EQ(plans, result->plan_names.size());
+
+  godel_msgs::GetAvailableMotionPlans srv;
+  ASSERT_TRUE(ros::service::call("get_available_motion_plans", srv));
+  for (const auto& name : result->plan_names)
+    EXPECT_EQ(1, std::count(srv.response.names.begin(), srv.response.names.end(), name));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_progressive_planning");
+  ros::AsyncSpinner spinner(4);
+  spinner.start();
+
+  PlanningServiceStubs stubs;
+  stubs_ptr = &stubs;
+
+  SurfaceBlendingService service;
+  service.run();
+  service.initPlanning();
+  for (int i = 0; i < NUM_SURFACES; ++i)
+  {
+    godel_surface_detection::detection::CloudRGB cloud;
+    pcl::PolygonMesh mesh;
+    makeSurface(i * SURFACE_SPACING, cloud, mesh);
+    service.addSurface(cloud, cloud, mesh);
+  }
+
+  godel_msgs::SelectSurface select;
+  select.request.action = godel_msgs::SelectSurface::Request::SELECT_ALL;
+  if (!ros::service::call("select_surface", select))
+  {
+    ROS_ERROR("Could not select the test surfaces");
+    return 1;
+  }
+  return RUN_ALL_TESTS();
+}
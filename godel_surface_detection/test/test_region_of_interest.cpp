@@ -0,0 +1,174 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <coordination/data_coordinator.h>
+#include <detection/region_of_interest.h>
+
+#include <eigen_conversions/eigen_msg.h>
+
+#include <cmath>
+
+using namespace godel_surface_detection;
+using detection::RegionOfInterestFilter;
+
+namespace
+{
+
+typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+
+godel_msgs::RegionOfInterest makeBox(const Eigen::Affine3d& pose, double x, double y, double z)
+{
+  godel_msgs::RegionOfInterest roi;
+  roi.type = godel_msgs::RegionOfInterest::BOX;
+  tf::poseEigenToMsg(pose, roi.pose);
+  roi.dimensions.x = x;
+  roi.dimensions.y = y;
+  roi.dimensions.z = z;
+  return roi;
+}
+
+// An L: the 0.2 x 0.2 m square at the origin without its 0.1 x 0.1 m top right quarter
+godel_msgs::RegionOfInterest makeLPrism(double min_height, double max_height)
+{
+  godel_msgs::RegionOfInterest roi;
+  roi.type = godel_msgs::RegionOfInterest::POLYGON_PRISM;
+  tf::poseEigenToMsg(Eigen::Affine3d::Identity(), roi.pose);
+  const double xy[][2] = {{0.0, 0.0}, {0.2, 0.0}, {0.2, 0.1}, {0.1, 0.1}, {0.1, 0.2}, {0.0, 0.2}};
+  for (const auto& v : xy)
+  {
+    geometry_msgs::Point p;
+    p.x = v[0];
+    p.y = v[1];
+    roi.polygon.push_back(p);
+  }
+  roi.min_height = min_height;
+  roi.max_height = max_height;
+  return roi;
+}
+
+// A 0.1 x 0.1 m patch of a face of a part, 5mm between points, at height z
+CloudRGB makePatch(double x, double y, double z)
+{
+  CloudRGB cloud;
+  for (int i = 0; i < 20; ++i)
+  {
+    for (int j = 0; j < 20; ++j)
+    {
+      pcl::PointXYZRGB p;
+      p.x = x + 0.005 * i;
+      p.y = y + 0.005 * j;
+      p.z = z;
+      cloud.push_back(p);
+    }
+  }
+  cloud.header.frame_id = "world_frame";
+  return cloud;
+}
+
+} // end anon namespace
+
+TEST(RegionOfInterest, containsPointsInRotatedBoxes)
+{
+  // 0.4 m long along the diagonal of the xy plane, 0.1 m wide and high
+  const Eigen::Affine3d pose =
+      Eigen::Translation3d(0.5, 0.5, 0.1) * Eigen::AngleAxisd(M_PI / 4, Eigen::Vector3d::UnitZ());
+  const RegionOfInterestFilter filter({makeBox(pose, 0.4, 0.1, 0.1)});
+
+  EXPECT_TRUE(filter.contains(Eigen::Vector3f(0.5f, 0.5f, 0.1f)));
+  EXPECT_TRUE(filter.contains(Eigen::Vector3f(0.6f, 0.6f, 0.14f)));
+  EXPECT_FALSE(filter.contains(Eigen::Vector3f(0.6f, 0.6f, 0.16f)));
+  // Within the unrotated box, but not the rotated one
+  EXPECT_FALSE(filter.contains(Eigen::Vector3f(0.68f, 0.5f, 0.1f)));
+}
+
+TEST(RegionOfInterest, containsPointsInConcavePrisms)
+{
+  const RegionOfInterestFilter filter({makeLPrism(0.0, 0.05)});
+
+  EXPECT_TRUE(filter.contains(Eigen::Vector3f(0.05f, 0.05f, 0.02f)));
+  EXPECT_TRUE(filter.contains(Eigen::Vector3f(0.15f, 0.05f, 0.02f)));
+  EXPECT_TRUE(filter.contains(Eigen::Vector3f(0.05f, 0.15f, 0.02f)));
+  // The missing quarter, and above the prism
+  EXPECT_FALSE(filter.contains(Eigen::Vector3f(0.15f, 0.15f, 0.02f)));
+  EXPECT_FALSE(filter.contains(Eigen::Vector3f(0.05f, 0.05f, 0.06f)));
+}
+
+TEST(RegionOfInterest, cropsToAnyOfTheRegions)
+{
+  CloudRGB cloud = makePatch(0.0, 0.0, 0.02);
+  cloud += makePatch(0.5, 0.5, 0.1);
+  cloud += makePatch(1.0, 1.0, 0.1);
+
+  const Eigen::Affine3d pose(Eigen::Translation3d(0.55, 0.55, 0.1));
+  const RegionOfInterestFilter filter({makeLPrism(0.0, 0.05), makeBox(pose, 0.2, 0.2, 0.02)});
+  CloudRGB cropped;
+  filter.crop(cloud, cropped);
+  EXPECT_EQ(cloud.header.frame_id, cropped.header.frame_id);
+  // The whole first and second patches, and none of the third
+  EXPECT_EQ(800u, cropped.size());
+  EXPECT_NEAR(2.0 / 3.0, filter.share(cloud), 1e-9);
+
+  // No regions: everything
+  const RegionOfInterestFilter everything({});
+  everything.crop(cloud, cropped);
+  EXPECT_EQ(cloud.size(), cropped.size());
+}
+
+TEST(RegionOfInterest, keepsRecordsOutsideTheRegions)
+{
+  data::DataCoordinator coordinator;
+  const CloudRGB input = makePatch(0.0, 0.0, 0.0);
+  std::vector<int> ids;
+  for (int i = 0; i < 4; ++i)
+  {
+    const int id = coordinator.addRecord(input, makePatch(0.2 * i, 0.0, 0.05));
+    coordinator.setSurfaceName(id, "part_" + std::to_string(i + 1));
+    ids.push_back(id);
+  }
+
+  // Around the second surface, and a strip of the third
+  const Eigen::Affine3d pose(Eigen::Translation3d(0.305, 0.05, 0.05));
+  const RegionOfInterestFilter filter({makeBox(pose, 0.23, 0.2, 0.05)});
+  const std::vector<int> removed = detection::removeRecordsInRegions(coordinator, filter);
+  ASSERT_EQ(1u, removed.size());
+  EXPECT_EQ(ids[1], removed[0]);
+
+  // New detections get new ids; the other records are as they were
+  const int added = coordinator.addRecord(input, makePatch(0.2, 0.0, 0.05));
+  EXPECT_EQ(ids.back() + 1, added);
+  const std::vector<int> expected = {ids[0], ids[2], ids[3], added};
+  EXPECT_EQ(expected, coordinator.getRecordIds());
+  for (int i : {0, 2, 3})
+  {
+    std::string name;
+    CloudRGB surface;
+    ASSERT_TRUE(coordinator.getSurfaceName(ids[i], name));
+    EXPECT_EQ("part_" + std::to_string(i + 1), name);
+    ASSERT_TRUE(coordinator.getCloud(data::surface_cloud, ids[i], surface));
+    ASSERT_EQ(400u, surface.size());
+    EXPECT_FLOAT_EQ(0.2f * i, surface[0].x);
+  }
+  EXPECT_FALSE(coordinator.removeRecord(ids[1]));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,250 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Runs RobotScan's continuous scan against a simulated robot and sensor. The robot starts the
+ * sweep some time after it is sent, as a controller does, and publishes its joint states while
+ * it moves; the sensor publishes a frame every FRAME_PERIOD whose one point holds the time into
+ * the sweep it was captured at.
+ */
+
+#include <gtest/gtest.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <scan/robot_scan.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace godel_surface_detection;
+
+namespace
+{
+
+const static std::string JOINT = "joint_1";
+const static double SLOW = 0.2;               // (rad/s) the sweep's speed at its ends
+const static double FAST = 1.0;               // (rad/s) its speed between FAST_START and FAST_END
+const static double FAST_START = 1.0;         // (s)
+const static double FAST_END = 2.0;           // (s)
+const static double SWEEP_DURATION = 3.0;     // (s)
+const static double MAX_JOINT_VELOCITY = 0.5; // (rad/s)
+const static double START_DELAY = 0.5;        // (s) from sending the sweep until the robot moves
+const static double STATE_PERIOD = 0.02;      // (s)
+const static double FRAME_PERIOD = 0.1;       // (s)
+const static int SCAN_POINTS = 5;
+
+double speed(double t) { return t >= FAST_START && t <= FAST_END ? FAST : SLOW; }
+
+trajectory_msgs::JointTrajectory makeSweep()
+{
+  trajectory_msgs::JointTrajectory trajectory;
+  trajectory.joint_names.push_back(JOINT);
+  double position = 0.0;
+  for (int i = 0; i <= static_cast<int>(std::round(SWEEP_DURATION / FRAME_PERIOD)); ++i)
+  {
+    const double t = i * FRAME_PERIOD;
+    if (i > 0)
+      position += speed(t - 0.5 * FRAME_PERIOD) * FRAME_PERIOD;
+    trajectory_msgs::JointTrajectoryPoint point;
+    point.positions.push_back(position);
+    point.velocities.push_back(speed(t));
+    point.time_from_start = ros::Duration(t);
+    trajectory.points.push_back(point);
+  }
+  return trajectory;
+}
+
+class SimulatedRobotScan : public scan::RobotScan
+{
+public:
+  SimulatedRobotScan() : fraction(1.0), execution_fails(false), sweeps_executed(0)
+  {
+    params_.num_scan_points = SCAN_POINTS;
+    params_.scan_topic = "simulated_scan";
+    params_.stop_on_planning_error = true;
+    use_continuous_scan_ = true;
+    continuous_scan_params_.hardware_trigger = true;
+    continuous_scan_params_.max_joint_velocity = MAX_JOINT_VELOCITY;
+    add_scan_callback(boost::bind(&SimulatedRobotScan::onCloud, this, _1));
+
+    ros::NodeHandle nh;
+    joint_state_pub_ = nh.advertise<sensor_msgs::JointState>("joint_states", 100);
+    scan_pub_ = nh.advertise<sensor_msgs::PointCloud2>(params_.scan_topic, 100);
+  }
+
+  // Times into the sweep of the frames handed to the scan callbacks
+  std::vector<double> fused;
+
+  // Times into the sweep of the frames the sensor published
+  std::vector<double> published;
+
+  double fraction;
+  bool execution_fails;
+  int sweeps_executed;
+
+protected:
+  bool plan_scan_move(const geometry_msgs::Pose&, moveit::planning_interface::MoveGroupInterface::Plan&) override
+  {
+    return true;
+  }
+
+  double plan_sweep(const std::vector<geometry_msgs::Pose>& poses,
+                    moveit::planning_interface::MoveGroupInterface::Plan& plan) override
+  {
+    EXPECT_EQ(static_cast<std::size_t>(SCAN_POINTS), poses.size());
+    plan.trajectory_.joint_trajectory = makeSweep();
+    return fraction;
+  }
+
+  bool execute_plan(const moveit::planning_interface::MoveGroupInterface::Plan& plan) override
+  {
+    const trajectory_msgs::JointTrajectory& trajectory = plan.trajectory_.joint_trajectory;
+    if (trajectory.points.empty())
+      return true; // the approach
+
+    sweeps_executed++;
+    const ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(5.0);
+    while ((joint_state_pub_.getNumSubscribers() == 0 || scan_pub_.getNumSubscribers() == 0) &&
+           ros::WallTime::now() < deadline)
+      ros::WallDuration(0.01).sleep();
+
+    publishState(0.0, trajectory);
+    ros::Duration(START_DELAY).sleep();
+
+    const ros::Time start = ros::Time::now();
+    const double end = execution_fails ? 0.5 * SWEEP_DURATION : SWEEP_DURATION;
+    double next_frame = 0.0;
+    for (double t = 0.0; t <= end; t = (ros::Time::now() - start).toSec())
+    {
+      publishState(t, trajectory);
+      if (t >= next_frame)
+      {
+        publishFrame(t);
+        next_frame += FRAME_PERIOD;
+      }
+      ros::Duration(STATE_PERIOD).sleep();
+    }
+    return !execution_fails;
+  }
+
+private:
+  void publishState(double t, const trajectory_msgs::JointTrajectory& trajectory)
+  {
+    // Linear between the points, which is close enough for speeds held over each of them
+    const auto& points = trajectory.points;
+    std::size_t i = 1;
+    while (i + 1 < points.size() && points[i].time_from_start.toSec() < t)
+      ++i;
+    const double t0 = points[i - 1].time_from_start.toSec(), t1 = points[i].time_from_start.toSec();
+    const double s = std::min(1.0, std::max(0.0, (t - t0) / (t1 - t0)));
+
+    sensor_msgs::JointState state;
+    state.header.stamp = ros::Time::now();
+    state.name.push_back(JOINT);
+    state.position.push_back((1.0 - s) * points[i - 1].positions[0] + s * points[i].positions[0]);
+    joint_state_pub_.publish(state);
+  }
+
+  void publishFrame(double t)
+  {
+    pcl::PointCloud<pcl::PointXYZRGB> cloud;
+    pcl::PointXYZRGB p;
+    p.x = t;
+    p.y = p.z = 0.0;
+    cloud.push_back(p);
+
+    sensor_msgs::PointCloud2 msg;
+    pcl::toROSMsg(cloud, msg);
+    msg.header.frame_id = params_.scan_target_frame;
+    msg.header.stamp = ros::Time::now();
+    scan_pub_.publish(msg);
+    published.push_back(t);
+  }
+
+  void onCloud(pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+  {
+    ASSERT_EQ(1u, cloud.size());
+    fused.push_back(cloud.points[0].x);
+  }
+
+  ros::Publisher joint_state_pub_;
+  ros::Publisher scan_pub_;
+};
+
+} // end anon namespace
+
+TEST(RobotScan, continuousScanTimesFramesFromTheSweepStart)
+{
+  SimulatedRobotScan robot_scan;
+  EXPECT_EQ(SCAN_POINTS, robot_scan.scan());
+  EXPECT_EQ(1, robot_scan.sweeps_executed);
+  ASSERT_FALSE(robot_scan.published.empty());
+
+  // Frames well inside the slow and the fast parts of the sweep are told apart; timing them from
+  // when the sweep was sent rather than when it started would misplace them by START_DELAY
+  const double margin = 2.0 * FRAME_PERIOD;
+  for (double t : robot_scan.published)
+  {
+    const bool was_fused =
+        std::count_if(robot_scan.fused.begin(), robot_scan.fused.end(),
+                      [t](double f) { return std::abs(f - t) < 1e-4; }) > 0;
+    if (t < FAST_START - margin || t > FAST_END + margin)
+      EXPECT_TRUE(was_fused) << "slow frame at " << t << " s was dropped";
+    else if (t > FAST_START + margin && t < FAST_END - margin)
+      EXPECT_FALSE(was_fused) << "blurred frame at " << t << " s was fused";
+  }
+}
+
+TEST(RobotScan, continuousScanDropsTheFramesOfAFailedSweep)
+{
+  SimulatedRobotScan robot_scan;
+  robot_scan.execution_fails = true;
+  EXPECT_EQ(0, robot_scan.scan());
+  EXPECT_FALSE(robot_scan.published.empty());
+  EXPECT_TRUE(robot_scan.fused.empty());
+}
+
+TEST(RobotScan, continuousScanEndsABlockedSweep)
+{
+  // A sweep blocked by a collision or a joint jump isn't run at all when planning errors stop the
+  // scan
+  SimulatedRobotScan stopped;
+  stopped.fraction = 0.5;
+  EXPECT_EQ(0, stopped.scan());
+  EXPECT_EQ(0, stopped.sweeps_executed);
+
+  // Otherwise the part of it before the block is
+  SimulatedRobotScan partial;
+  partial.fraction = 0.5;
+  partial.params_.stop_on_planning_error = false;
+  EXPECT_EQ(1 + (SCAN_POINTS - 1) / 2, partial.scan());
+  EXPECT_EQ(1, partial.sweeps_executed);
+
+  SimulatedRobotScan unplanned;
+  unplanned.fraction = 0.0;
+  unplanned.params_.stop_on_planning_error = false;
+  EXPECT_EQ(0, unplanned.scan());
+  EXPECT_EQ(0, unplanned.sweeps_executed);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_robot_scan");
+  ros::NodeHandle nh;
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,153 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <segmentation/surface_merging.h>
+
+#include <cmath>
+#include <random>
+
+using namespace godel_surface_detection;
+
+namespace
+{
+
+typedef pcl::PointCloud<pcl::PointXYZRGB> CloudRGB;
+
+const static double SPACING = 0.002;
+const static double NOISE = 0.0003;
+
+/**
+ * @brief Samples origin + s * u + t * v over [0, length) x [0, width) with sensor noise, as
+ * region growing would have segmented it
+ */
+CloudRGB::Ptr makePatch(const Eigen::Vector3d& origin, const Eigen::Vector3d& u, const Eigen::Vector3d& v,
+                        double length, double width, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0.0, NOISE);
+  CloudRGB::Ptr cloud(new CloudRGB());
+  for (double s = 0.0; s < length - 1e-9; s += SPACING)
+  {
+    for (double t = 0.0; t < width - 1e-9; t += SPACING)
+    {
+      const Eigen::Vector3d p = origin + s * u + t * v;
+      pcl::PointXYZRGB point;
+      point.x = p.x() + noise(rng);
+      point.y = p.y() + noise(rng);
+      point.z = p.z() + noise(rng);
+      cloud->points.push_back(point);
+    }
+  }
+  cloud->width = cloud->points.size();
+  cloud->height = 1;
+  return cloud;
+}
+
+// Total number of points, which merging must keep
+std::size_t countPoints(const std::vector<CloudRGB::Ptr>& surfaces)
+{
+  std::size_t n = 0;
+  for (const auto& s : surfaces)
+    n += s->size();
+  return n;
+}
+
+} // end anon namespace
+
+TEST(SurfaceMerging, fitsPlanes)
+{
+  const CloudRGB::Ptr patch =
+      makePatch(Eigen::Vector3d(0, 0, 0.05), Eigen::Vector3d::UnitX(), Eigen::Vector3d::UnitY(), 0.1, 0.1, 1);
+  const PlaneFit plane = fitPlane(*patch);
+  EXPECT_NEAR(1.0, std::abs(plane.normal.z()), 1e-3);
+  EXPECT_NEAR(0.05, plane.centroid.z(), 1e-4);
+  EXPECT_NEAR(NOISE, plane.rms, 1e-4);
+}
+
+TEST(SurfaceMerging, joinsAnOverSegmentedFace)
+{
+  // The top of a block, split into quadrants, and one of its sides
+  std::vector<CloudRGB::Ptr> surfaces;
+  for (int q = 0; q < 4; ++q)
+  {
+    const Eigen::Vector3d origin(0.1 * (q % 2), 0.1 * (q / 2), 0.05);
+    surfaces.push_back(makePatch(origin, Eigen::Vector3d::UnitX(), Eigen::Vector3d::UnitY(), 0.1, 0.1, q));
+  }
+  surfaces.push_back(
+      makePatch(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d::UnitX(), Eigen::Vector3d::UnitZ(), 0.2, 0.048, 9));
+  const std::size_t points = countPoints(surfaces);
+
+  EXPECT_EQ(8u, surfaceAdjacency(surfaces, SurfaceMergeParameters()).size());
+
+  const SurfaceMergeStats stats = mergeCoplanarSurfaces(surfaces);
+  EXPECT_EQ(5u, stats.segments);
+  EXPECT_EQ(2u, stats.surfaces);
+  ASSERT_EQ(2u, surfaces.size());
+  EXPECT_EQ(points, countPoints(surfaces));
+  EXPECT_NEAR(1.0, std::abs(fitPlane(*surfaces[0]).normal.z()), 1e-3);
+  EXPECT_NEAR(1.0, std::abs(fitPlane(*surfaces[1]).normal.y()), 1e-3);
+}
+
+TEST(SurfaceMerging, keepsStepsAndSeparateFaces)
+{
+  std::vector<CloudRGB::Ptr> surfaces;
+  // A 5mm step between two touching parallel faces
+  surfaces.push_back(
+      makePatch(Eigen::Vector3d(0, 0, 0.05), Eigen::Vector3d::UnitX(), Eigen::Vector3d::UnitY(), 0.1, 0.1, 1));
+  surfaces.push_back(
+      makePatch(Eigen::Vector3d(0.1, 0, 0.055), Eigen::Vector3d::UnitX(), Eigen::Vector3d::UnitY(), 0.1, 0.1, 2));
+  // Coplanar with the first, but not touching it
+  surfaces.push_back(
+      makePatch(Eigen::Vector3d(0, 0.2, 0.05), Eigen::Vector3d::UnitX(), Eigen::Vector3d::UnitY(), 0.1, 0.1, 3));
+
+  const SurfaceMergeStats stats = mergeCoplanarSurfaces(surfaces);
+  EXPECT_EQ(3u, stats.surfaces);
+  EXPECT_EQ(3u, surfaces.size());
+}
+
+TEST(SurfaceMerging, stopsWhereCurvedFacesStopBeingPlanar)
+{
+  // A cylinder of 1m radius, segmented into 1cm strips whose normals are 0.01 rad apart. With
+  // tolerances this loose, the planarity check alone decides where merging stops.
+  const double radius = 1.0, strip = 0.01;
+  std::vector<CloudRGB::Ptr> surfaces;
+  for (int i = 0; i < 40; ++i)
+  {
+    const double angle = i * strip / radius;
+    const Eigen::Vector3d origin(radius * std::sin(angle), 0.0, radius * (std::cos(angle) - 1.0));
+    const Eigen::Vector3d u(std::cos(angle), 0.0, -std::sin(angle));
+    surfaces.push_back(makePatch(origin, u, Eigen::Vector3d::UnitY(), strip, 0.1, i));
+  }
+
+  SurfaceMergeParameters params;
+  params.max_angle = 0.2;
+  params.max_offset = 0.02;
+  const SurfaceMergeStats stats = mergeCoplanarSurfaces(surfaces, params);
+  EXPECT_GT(stats.rejected, 0u);
+  EXPECT_GT(stats.surfaces, 1u);
+  EXPECT_LT(stats.surfaces, stats.segments / 4);
+  for (const auto& surface : surfaces)
+    EXPECT_LE(fitPlane(*surface).rms, params.max_rms);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
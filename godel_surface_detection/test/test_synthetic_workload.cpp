@@ -0,0 +1,265 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <synthetic/synthetic_workload.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace godel_surface_detection::synthetic;
+
+namespace
+{
+
+// 20cm x 20cm x 5cm plate on the z = 0 plane with a 3cm through hole
+PartDescription makePlateWithHole(std::size_t points, unsigned seed)
+{
+  PartDescription part;
+  part.primitives.push_back(box(0.0, 0.0, 0.025, 0.2, 0.2, 0.05));
+  part.primitives.push_back(cutOut(cylinder(0.06, 0.0, 0.0, 0.03, 1.0)));
+  part.target_points = points;
+  part.noise = 0.0002;
+  part.seed = seed;
+  return part;
+}
+
+// A 10cm block standing on the middle of the plate
+PartDescription makeStackedBoxes(std::size_t points)
+{
+  PartDescription part;
+  part.primitives.push_back(box(0.0, 0.0, 0.025, 0.2, 0.2, 0.05));
+  part.primitives.push_back(box(0.0, 0.0, 0.1, 0.1, 0.1, 0.1));
+  part.target_points = points;
+  return part;
+}
+
+uint32_t labelOf(const PartDescription& part, const std::string& name)
+{
+  const std::vector<std::string> names = surfaceNames(part);
+  return std::find(names.begin(), names.end(), name) - names.begin() + 1;
+}
+
+// Looking straight down at the origin from 'height'; image rows run along x, columns along y
+Eigen::Affine3d cameraAbove(double height)
+{
+  return Eigen::Translation3d(0.0, 0.0, height) * Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitY());
+}
+
+CameraModel makeCamera()
+{
+  CameraModel camera;
+  camera.width = 320;
+  camera.height = 240;
+  camera.fx = camera.fy = 300.0;
+  camera.cx = 159.5;
+  camera.cy = 119.5;
+  camera.dropout_rate = 0.0;
+  return camera;
+}
+
+bool samePoints(const LabelledCloud& a, const LabelledCloud& b)
+{
+  if (a.size() != b.size() || a.width != b.width)
+    return false;
+  for (std::size_t i = 0; i < a.size(); ++i)
+  {
+    if (a[i].label != b[i].label)
+      return false;
+    if (std::isnan(a[i].x) != std::isnan(b[i].x))
+      return false;
+    if (!std::isnan(a[i].x) && (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z))
+      return false;
+  }
+  return true;
+}
+
+std::size_t countLabel(const LabelledCloud& cloud, uint32_t label)
+{
+  return std::count_if(cloud.points.begin(), cloud.points.end(),
+                       [label](const LabelledPoint& p) { return p.label == label; });
+}
+
+} // end anon namespace
+
+TEST(SyntheticWorkload, sameSeedGivesTheSameCloud)
+{
+  LabelledCloud first, second, other;
+  ASSERT_TRUE(generatePart(makePlateWithHole(200000, 7), first));
+  ASSERT_TRUE(generatePart(makePlateWithHole(200000, 7), second));
+  ASSERT_TRUE(generatePart(makePlateWithHole(200000, 8), other));
+
+  EXPECT_TRUE(samePoints(first, second));
+  EXPECT_FALSE(samePoints(first, other));
+}
+
+TEST(SyntheticWorkload, generatesTheTargetCountOnLabelledSurfaces)
+{
+  PartDescription part = makePlateWithHole(100003, 1);
+  part.noise = 0.0;
+  LabelledCloud cloud;
+  ASSERT_TRUE(generatePart(part, cloud));
+  ASSERT_EQ(100003u, cloud.size());
+  EXPECT_TRUE(cloud.is_dense);
+
+  const uint32_t top = labelOf(part, "box_0/+z");
+  const uint32_t wall = labelOf(part, "cylinder_1/side");
+  const std::size_t surfaces = surfaceNames(part).size();
+  for (const LabelledPoint& p : cloud.points)
+  {
+    ASSERT_GE(p.label, 1u);
+    ASSERT_LE(p.label, surfaces);
+    const double radius = std::hypot(p.x - 0.06, p.y);
+    if (p.label == top)
+    {
+      EXPECT_NEAR(0.05, p.z, 1e-6);
+      EXPECT_GE(radius, 0.03 - 1e-6); // nothing over the hole
+    }
+    else if (p.label == wall)
+    {
+      EXPECT_NEAR(0.03, radius, 1e-6);
+      EXPECT_GE(p.z, -1e-6); // only where the plate is
+      EXPECT_LE(p.z, 0.05 + 1e-6);
+    }
+  }
+  EXPECT_GT(countLabel(cloud, wall), 0u);
+  EXPECT_EQ(0u, countLabel(cloud, labelOf(part, "cylinder_1/+z")));
+}
+
+TEST(SyntheticWorkload, touchingPrimitivesHideTheirContactFaces)
+{
+  const PartDescription part = makeStackedBoxes(100000);
+  LabelledCloud cloud;
+  ASSERT_TRUE(generatePart(part, cloud));
+
+  EXPECT_EQ(0u, countLabel(cloud, labelOf(part, "box_1/-z")));
+  const uint32_t plate_top = labelOf(part, "box_0/+z");
+  for (const LabelledPoint& p : cloud.points)
+    if (p.label == plate_top)
+      ASSERT_FALSE(std::abs(p.x) < 0.0499 && std::abs(p.y) < 0.0499) << "under the block";
+}
+
+TEST(SyntheticWorkload, viewsAreOrganizedAndDeterministic)
+{
+  const PartDescription part = makePlateWithHole(1000, 0);
+  CameraModel camera = makeCamera();
+  camera.dropout_rate = 0.1;
+
+  LabelledCloud first, second, other;
+  simulateView(part, camera, cameraAbove(0.6), 3, first);
+  simulateView(part, camera, cameraAbove(0.6), 3, second);
+  simulateView(part, camera, cameraAbove(0.6), 4, other);
+
+  ASSERT_EQ(320u, first.width);
+  ASSERT_EQ(240u, first.height);
+  EXPECT_FALSE(first.is_dense);
+  EXPECT_TRUE(samePoints(first, second));
+  EXPECT_FALSE(samePoints(first, other));
+}
+
+TEST(SyntheticWorkload, nearerSurfacesOccludeFartherOnes)
+{
+  const PartDescription part = makeStackedBoxes(1000);
+  CameraModel camera = makeCamera();
+  camera.depth_noise = camera.depth_noise_quadratic = 0.0;
+  LabelledCloud view;
+  simulateView(part, camera, cameraAbove(0.6), 0, view);
+
+  const uint32_t block_top = labelOf(part, "box_1/+z");
+  const uint32_t plate_top = labelOf(part, "box_0/+z");
+  EXPECT_GT(countLabel(view, block_top), 0u);
+  EXPECT_GT(countLabel(view, plate_top), 0u);
+  EXPECT_EQ(0u, countLabel(view, labelOf(part, "box_0/-z")));
+  EXPECT_EQ(0u, countLabel(view, labelOf(part, "box_1/-z")));
+
+  for (const LabelledPoint& p : view.points)
+  {
+    if (p.label == block_top)
+      EXPECT_NEAR(0.15, p.z, 1e-6);
+    else if (p.label == plate_top)
+      ASSERT_FALSE(std::abs(p.x) < 0.0499 && std::abs(p.y) < 0.0499) << "seen through the block";
+  }
+}
+
+TEST(SyntheticWorkload, viewsSeeIntoCutOuts)
+{
+  const PartDescription part = makePlateWithHole(1000, 0);
+  CameraModel camera = makeCamera();
+  camera.max_incidence_angle = M_PI / 2;
+  LabelledCloud view;
+  simulateView(part, camera, cameraAbove(0.6), 0, view);
+
+  // The far wall of the hole is in sight, and the ground under the plate is not modelled
+  EXPECT_GT(countLabel(view, labelOf(part, "cylinder_1/side")), 0u);
+  EXPECT_EQ(0u, countLabel(view, labelOf(part, "box_0/-z")));
+
+  // Walls seen almost edge on are lost at the default incidence limit
+  camera.max_incidence_angle = CameraModel().max_incidence_angle;
+  simulateView(part, camera, cameraAbove(0.6), 0, view);
+  EXPECT_EQ(0u, countLabel(view, labelOf(part, "cylinder_1/side")));
+}
+
+TEST(SyntheticWorkload, dropoutsRemoveReturns)
+{
+  PartDescription part;
+  part.primitives.push_back(box(0.0, 0.0, 0.0, 2.0, 2.0, 0.01)); // fills the view
+  CameraModel camera = makeCamera();
+  LabelledCloud view;
+
+  simulateView(part, camera, cameraAbove(0.6), 0, view);
+  EXPECT_EQ(view.size(), countLabel(view, labelOf(part, "box_0/+z")));
+
+  camera.dropout_rate = 0.5;
+  simulateView(part, camera, cameraAbove(0.6), 0, view);
+  const double returns = static_cast<double>(view.size() - countLabel(view, NO_SURFACE)) / view.size();
+  EXPECT_NEAR(0.5, returns, 0.02);
+}
+
+TEST(SyntheticWorkload, partsWithoutSurfaceAreRejected)
+{
+  PartDescription part;
+  part.primitives.push_back(box(0.0, 0.0, 0.0, 0.1, 0.1, 0.1));
+  part.primitives.push_back(cutOut(box(0.0, 0.0, 0.0, 0.2, 0.2, 0.2)));
+
+  LabelledCloud cloud;
+  EXPECT_FALSE(generatePart(part, cloud));
+  EXPECT_TRUE(cloud.points.empty());
+}
+
+TEST(SyntheticWorkload, primitiveFactoriesBuildLabelledParts)
+{
+  PartDescription part;
+  part.primitives.push_back(box(0.0, 0.0, 0.0, 0.2, 0.1, 0.05));
+  part.primitives.push_back(cylinder(0.3, 0.0, 0.0, 0.05, 0.1));
+  part.primitives.push_back(sphere(0.6, 0.0, 0.0, 0.05));
+  EXPECT_EQ(Eigen::Vector3d(0.05, 0.05, 0.1), part.primitives[1].size);
+  EXPECT_TRUE(part.primitives[2].pose.translation().isApprox(Eigen::Vector3d(0.6, 0.0, 0.0)));
+  EXPECT_FALSE(part.primitives[2].cut);
+  EXPECT_TRUE(cutOut(part.primitives[2]).cut);
+
+  const std::vector<std::string> names = surfaceNames(part);
+  EXPECT_NE(names.end(), std::find(names.begin(), names.end(), "box_0/+z"));
+  EXPECT_NE(names.end(), std::find(names.begin(), names.end(), "cylinder_1/side"));
+  EXPECT_NE(names.end(), std::find(names.begin(), names.end(), "sphere_2/surface"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,179 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include "utils/visualization_publisher.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace godel_surface_detection::visualization;
+
+namespace
+{
+
+// A dense 1mm grid on a w x w metre plane
+pcl::PointCloud<pcl::PointXYZRGB> makePlane(double w, double spacing)
+{
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  const int n = static_cast<int>(w / spacing);
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+    {
+      pcl::PointXYZRGB p;
+      p.x = i * spacing;
+      p.y = j * spacing;
+      p.z = 0.0f;
+      p.r = i < n / 2 ? 255 : 0;
+      p.g = 0;
+      p.b = i < n / 2 ? 0 : 255;
+      cloud.push_back(p);
+    }
+  cloud.header.frame_id = "world_frame";
+  return cloud;
+}
+
+} // end anon namespace
+
+TEST(VisualizationPublisher, downsampleRespectsPointBudget)
+{
+  const auto cloud = makePlane(0.5, 0.001); // 250k points
+  pcl::PointCloud<pcl::PointXYZRGB> out;
+  const double leaf = downsampleForDisplay(cloud, 10000, 0.002, out);
+
+  EXPECT_LE(out.size(), 10000u);
+  EXPECT_GT(out.size(), 2000u); // should not overshoot the voxel size by much
+  EXPECT_GE(leaf, 0.002);
+  EXPECT_EQ("world_frame", out.header.frame_id);
+  EXPECT_EQ(out.size(), out.width);
+
+  // Colours are kept, never blended
+  for (const auto& p : out)
+  {
+    EXPECT_TRUE((p.r == 255 && p.b == 0) || (p.r == 0 && p.b == 255));
+  }
+}
+
+TEST(VisualizationPublisher, downsampleUsesMinimumLeaf)
+{
+  const auto cloud = makePlane(0.1, 0.001); // 10k points
+  pcl::PointCloud<pcl::PointXYZRGB> out;
+  const double leaf = downsampleForDisplay(cloud, 1000000, 0.002, out);
+  EXPECT_DOUBLE_EQ(0.002, leaf);
+  EXPECT_NEAR(2500.0, out.size(), 200.0);
+
+  // No leaf and no budget: unchanged copy
+  EXPECT_DOUBLE_EQ(0.0, downsampleForDisplay(cloud, 0, 0.0, out));
+  EXPECT_EQ(cloud.size(), out.size());
+}
+
+TEST(VisualizationPublisher, decimatePosesKeepsEnds)
+{
+  geometry_msgs::PoseArray poses;
+  for (int i = 0; i < 1001; ++i)
+  {
+    geometry_msgs::Pose p;
+    p.position.x = i;
+    poses.poses.push_back(p);
+  }
+
+  geometry_msgs::PoseArray copy = poses;
+  decimatePoses(copy, 0);
+  EXPECT_EQ(poses.poses.size(), copy.poses.size());
+
+  for (std::size_t max : {1u, 2u, 3u, 100u, 1000u})
+  {
+    copy = poses;
+    decimatePoses(copy, max);
+    EXPECT_LE(copy.poses.size(), max);
+    EXPECT_DOUBLE_EQ(1000.0, copy.poses.back().position.x);
+    if (max > 1)
+      EXPECT_DOUBLE_EQ(0.0, copy.poses.front().position.x);
+  }
+}
+
+TEST(VisualizationPublisher, publishesOnlyOnChange)
+{
+  CachedPublisher<geometry_msgs::PoseArray> pub; // not advertised: counts only
+
+  geometry_msgs::PoseArrayPtr poses(new geometry_msgs::PoseArray);
+  poses->header.frame_id = "world_frame";
+  poses->poses.resize(10);
+
+  EXPECT_TRUE(pub.publish(poses));
+  EXPECT_FALSE(pub.publish(poses));
+  EXPECT_EQ(1u, pub.messagesPublished());
+  EXPECT_EQ(ros::serialization::serializationLength(*poses), pub.bytesPublished());
+
+  geometry_msgs::PoseArrayPtr changed(new geometry_msgs::PoseArray(*poses));
+  changed->poses[3].position.z = 1.0;
+  EXPECT_TRUE(pub.publish(changed));
+  EXPECT_EQ(2u, pub.messagesPublished());
+
+  pub.reset();
+  EXPECT_TRUE(pub.publish(changed));
+
+  // Messages passed by value are always new
+  EXPECT_TRUE(pub.publish(*changed));
+  EXPECT_EQ(4u, pub.messagesPublished());
+}
+
+// Service threads publish to the same publisher; each message they report as sent is counted
+// exactly once, with the bytes of its own content
+TEST(VisualizationPublisher, concurrentPublishes)
+{
+  CachedPublisher<geometry_msgs::PoseArray> pub;
+
+  std::atomic<uint64_t> sent(0), sent_bytes(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.push_back(std::thread([&pub, &sent, &sent_bytes, t]() {
+      // Each thread re-offers a few messages of its own length
+      std::vector<geometry_msgs::PoseArrayConstPtr> messages;
+      for (int k = 0; k < 7; ++k)
+      {
+        geometry_msgs::PoseArrayPtr poses(new geometry_msgs::PoseArray);
+        poses->header.frame_id = "world_frame";
+        poses->poses.resize(10 + t);
+        poses->poses[0].position.x = k;
+        messages.push_back(poses);
+      }
+      for (int i = 0; i < 500; ++i)
+      {
+        const geometry_msgs::PoseArrayConstPtr& poses = messages[(i / 3) % messages.size()];
+        if (pub.publish(poses))
+        {
+          sent++;
+          sent_bytes += ros::serialization::serializationLength(*poses);
+        }
+      }
+    }));
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  EXPECT_EQ(sent.load(), pub.messagesPublished());
+  EXPECT_EQ(sent_bytes.load(), pub.bytesPublished());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
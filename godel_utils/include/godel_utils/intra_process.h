@@ -0,0 +1,255 @@
+#ifndef GODEL_UTILS_INTRA_PROCESS_H
+#define GODEL_UTILS_INTRA_PROCESS_H
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <ros/node_handle.h>
+#include <ros/service_client.h>
+#include <ros/service_server.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+
+/*
+ * Services that skip serialization when client and server share a process.
+ *
+ * roscpp serializes every service call, even between nodelets loaded into the same manager. A
+ * ServiceServer advertises its service over ROS as usual and also registers it in a process-wide
+ * registry; a ServiceClient looks the service up there first. If it is found, the client puts
+ * a shared pointer to the call, which refers to the caller's own request and response, on the
+ * server's request queue and waits for it: nothing is copied or serialized. Otherwise the call
+ * goes over ROS. One thread per server works through its queue, so the handler sees one request
+ * at a time, whether it came over ROS or from within the process.
+ */
+
+namespace godel_utils
+{
+namespace intra_process
+{
+
+namespace detail
+{
+
+class ServiceQueueBase
+{
+public:
+  virtual ~ServiceQueueBase() {}
+};
+
+/** @brief Makes 'queue' the in-process server of 'name'; services are told apart by C++ type */
+void registerService(const std::string& name, const std::type_info& type,
+                     const boost::shared_ptr<ServiceQueueBase>& queue);
+
+/** @brief Removes 'queue' from the registry if it still serves 'name' */
+void unregisterService(const std::string& name, const ServiceQueueBase* queue);
+
+/** @brief The in-process server of 'name', if there is one for this service type */
+boost::shared_ptr<ServiceQueueBase> findService(const std::string& name, const std::type_info& type);
+
+} // namespace detail
+
+/**
+ * @brief Calls of one service, handled in order on a thread of their own
+ */
+template <typename Service>
+class ServiceQueue : public detail::ServiceQueueBase
+{
+public:
+  typedef typename Service::Request Request;
+  typedef typename Service::Response Response;
+  typedef boost::function<bool(Request&, Response&)> Callback;
+
+  explicit ServiceQueue(const Callback& callback)
+    : callback_(callback), stopped_(false), worker_(&ServiceQueue::work, this)
+  {
+  }
+
+  ~ServiceQueue() { stop(); }
+
+  /**
+   * @brief Queues a call and waits for the handler's result. Rethrows what the handler throws.
+   * Returns false once the queue is stopped.
+   */
+  bool call(Request& req, Response& res)
+  {
+    boost::shared_ptr<Call> c = boost::make_shared<Call>(req, res);
+    std::future<bool> result = c->done.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_)
+        return false;
+      calls_.push_back(c);
+    }
+    wakeup_.notify_one();
+    return result.get();
+  }
+
+  /** @brief Fails the queued calls and joins the worker */
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    wakeup_.notify_one();
+    if (worker_.joinable())
+      worker_.join();
+  }
+
+private:
+  struct Call
+  {
+    Call(Request& req, Response& res) : req(req), res(res) {}
+
+    Request& req;
+    Response& res;
+    std::promise<bool> done;
+  };
+
+  void work()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+      wakeup_.wait(lock, [this]() { return stopped_ || !calls_.empty(); });
+      if (calls_.empty())
+        return;
+      boost::shared_ptr<Call> c = calls_.front();
+      calls_.pop_front();
+
+      if (stopped_)
+      {
+        c->done.set_value(false);
+        continue;
+      }
+
+      lock.unlock();
+      try
+      {
+        c->done.set_value(callback_(c->req, c->res));
+      }
+      catch (...)
+      {
+        c->done.set_exception(std::current_exception());
+      }
+      lock.lock();
+    }
+  }
+
+  Callback callback_;
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::deque<boost::shared_ptr<Call>> calls_;
+  bool stopped_;
+  std::thread worker_;
+};
+
+/**
+ * @brief Calls the in-process server of 'name' (a resolved service name) if there is one
+ * @param result The server's result, if it was called
+ * @return false if there is no such server in this process
+ */
+template <typename Service>
+bool callInProcess(const std::string& name, typename Service::Request& req, typename Service::Response& res,
+                   bool& result)
+{
+  const boost::shared_ptr<detail::ServiceQueueBase> queue = detail::findService(name, typeid(Service));
+  if (!queue)
+    return false;
+  result = static_cast<ServiceQueue<Service>&>(*queue).call(req, res);
+  return true;
+}
+
+/**
+ * @brief Drop-in for ros::ServiceServer that also serves callers in the same process. Like a
+ * ros::ServiceServer, the service is shut down when the last copy of the handle goes away.
+ */
+template <typename Service>
+class ServiceServer
+{
+public:
+  typedef typename ServiceQueue<Service>::Callback Callback;
+
+  ServiceServer() {}
+
+  ServiceServer(ros::NodeHandle& nh, const std::string& service, const Callback& callback)
+    : impl_(boost::make_shared<Impl>(nh.resolveName(service), callback))
+  {
+    impl_->server = nh.advertiseService<typename Service::Request, typename Service::Response>(
+        service, boost::bind(&ServiceQueue<Service>::call, impl_->queue, _1, _2));
+    detail::registerService(impl_->name, typeid(Service), impl_->queue);
+  }
+
+  void shutdown() { impl_.reset(); }
+
+  std::string getService() const { return impl_ ? impl_->name : std::string(); }
+
+private:
+  struct Impl
+  {
+    Impl(const std::string& name, const Callback& callback)
+      : name(name), queue(boost::make_shared<ServiceQueue<Service>>(callback))
+    {
+    }
+
+    ~Impl()
+    {
+      detail::unregisterService(name, queue.get());
+      server.shutdown();
+      queue->stop();
+    }
+
+    std::string name;
+    boost::shared_ptr<ServiceQueue<Service>> queue;
+    ros::ServiceServer server;
+  };
+
+  boost::shared_ptr<Impl> impl_;
+};
+
+/**
+ * @brief Drop-in for ros::ServiceClient that calls servers in the same process directly
+ */
+template <typename Service>
+class ServiceClient
+{
+public:
+  ServiceClient() {}
+
+  ServiceClient(ros::NodeHandle& nh, const std::string& service)
+    : name_(nh.resolveName(service)), client_(nh.serviceClient<Service>(service))
+  {
+  }
+
+  bool call(typename Service::Request& req, typename Service::Response& res)
+  {
+    bool result;
+    if (callInProcess<Service>(name_, req, res, result))
+      return result;
+    return client_.call(req, res);
+  }
+
+  bool call(Service& srv) { return call(srv.request, srv.response); }
+
+  /** @brief True if the service is served by this process or over ROS */
+  bool exists() { return detail::findService(name_, typeid(Service)) || client_.exists(); }
+
+  std::string getService() const { return name_; }
+
+private:
+  std::string name_;
+  ros::ServiceClient client_;
+};
+
+} // namespace intra_process
+} // namespace godel_utils
+
+#endif // GODEL_UTILS_INTRA_PROCESS_H
@@ -0,0 +1,158 @@
+#ifndef GODEL_UTILS_MEMORY_ACCOUNTING_H
+#define GODEL_UTILS_MEMORY_ACCOUNTING_H
+
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <ros/node_handle.h>
+#include <ros/publisher.h>
+#include <ros/timer.h>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Keeps the data stores of long running nodes (surface records, motion plans, accumulated
+ * clouds) within a memory budget.
+ *
+ * Each store reports the bytes it holds and knows how to give some of them back, e.g. by spilling
+ * old records to disk or dropping data it can regenerate. A store has two budgets:
+ *  - above the soft budget, the node's MemoryMonitor evicts down to the soft budget the next time
+ *    it runs (the node calls it after operations that grow its stores);
+ *  - above the hard budget, the store evicts down to the soft budget as soon as it grows.
+ * A budget of 0 means unlimited. The monitor publishes what every store holds on /diagnostics.
+ */
+
+namespace godel_utils
+{
+namespace memory
+{
+
+struct MemoryBudget
+{
+  MemoryBudget() : soft_bytes(0), hard_bytes(0) {}
+  MemoryBudget(std::size_t soft, std::size_t hard) : soft_bytes(soft), hard_bytes(hard) {}
+
+  std::size_t soft_bytes;
+  std::size_t hard_bytes;
+};
+
+/**
+ * @brief Common interface of the stores whose memory is accounted for
+ *
+ * A store used from several threads locks its data in bytesUsed() and evict() as well as in its
+ * accessors; the monitor evicts from whichever thread calls update().
+ */
+class AccountedStore
+{
+public:
+  AccountedStore() : evictions_(0), bytes_evicted_(0) {}
+  virtual ~AccountedStore() {}
+
+  /** @brief Name used in diagnostics */
+  virtual std::string storeName() const = 0;
+
+  /** @brief Approximate heap memory held by the store */
+  virtual std::size_t bytesUsed() const = 0;
+
+  void setBudget(const MemoryBudget& budget) { budget_ = budget; }
+  const MemoryBudget& budget() const { return budget_; }
+
+  /**
+   * @brief Evicts down to the soft budget if the store is over it
+   * @return Bytes freed
+   */
+  std::size_t enforceSoftBudget();
+
+  /** @brief Number of times the store has evicted data, and the bytes freed doing so */
+  std::size_t evictions() const { return evictions_; }
+  std::size_t bytesEvicted() const { return bytes_evicted_; }
+
+protected:
+  /**
+   * @brief Frees memory, oldest or cheapest to rebuild first, until the store holds at most
+   * target_bytes or has nothing left it is allowed to give up
+   */
+  virtual void evict(std::size_t target_bytes) = 0;
+
+  /**
+   * @brief Stores call this after growing; evicts down to the soft budget if the hard one is
+   * exceeded
+   */
+  void enforceHardBudget();
+
+private:
+  std::size_t shrinkTo(std::size_t target_bytes);
+
+  MemoryBudget budget_;
+  std::atomic<std::size_t> evictions_;
+  std::atomic<std::size_t> bytes_evicted_;
+};
+
+/**
+ * @brief Reads a store's budget from '<ns>/<store>/soft_budget_mb' and 'hard_budget_mb'
+ */
+MemoryBudget loadBudget(const ros::NodeHandle& nh, const std::string& store);
+
+/** @brief Where stores spill to unless configured otherwise: $TMPDIR/godel_spill_<pid> */
+std::string defaultSpillDirectory();
+
+/**
+ * @brief Reads the directory stores spill records to from '<ns>/spill_directory'
+ */
+std::string loadSpillDirectory(const ros::NodeHandle& nh);
+
+/** @brief Resident set size of this process in bytes, 0 if unknown */
+std::size_t residentBytes();
+
+/** @brief Heap memory of a point cloud (or any container of 'points') */
+template <typename CloudT>
+std::size_t cloudBytes(const CloudT& cloud)
+{
+  return cloud.points.capacity() * sizeof(typename CloudT::PointType);
+}
+
+/**
+ * @brief Enforces the soft budgets of a node's stores and publishes their size as diagnostics
+ *
+ * The stores are only touched by update(), which nodes call after the operations that grow them.
+ * Stores shared between threads guard themselves (see AccountedStore); the publishing timer only
+ * sends the figures of the last update unless asked to update itself.
+ */
+class MemoryMonitor
+{
+public:
+  explicit MemoryMonitor(const std::string& node_name);
+
+  /** @brief The store must outlive the monitor */
+  void add(AccountedStore& store);
+
+  /**
+   * @brief Publishes the last report on /diagnostics every 'period' seconds
+   * @param update_on_timer Also calls update() from the timer, for single threaded nodes
+   */
+  void startPublishing(ros::NodeHandle& nh, double period, bool update_on_timer);
+
+  /** @brief Enforces every store's soft budget and refreshes the report */
+  void update();
+
+  /** @brief One status per store and one for the whole process, as of the last update() */
+  diagnostic_msgs::DiagnosticArray report() const;
+
+private:
+  void timerCallback(const ros::TimerEvent&);
+
+  std::string node_name_;
+  std::vector<AccountedStore*> stores_;
+  diagnostic_msgs::DiagnosticArray report_;
+  mutable std::mutex report_mutex_;
+  ros::Publisher publisher_;
+  ros::Timer timer_;
+  bool update_on_timer_;
+};
+
+} // namespace memory
+} // namespace godel_utils
+
+#endif // GODEL_UTILS_MEMORY_ACCOUNTING_H
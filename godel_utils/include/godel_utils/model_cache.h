@@ -0,0 +1,124 @@
+#ifndef GODEL_UTILS_MODEL_CACHE_H
+#define GODEL_UTILS_MODEL_CACHE_H
+
+#include <boost/function.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Startup cache of the collision geometry of a robot description.
+ *
+ * Every node that loads the robot model reads and decodes each collision mesh of the URDF (and
+ * resolves its package:// path) before MoveIt builds its collision models. The cache keeps a
+ * preprocessed copy of those meshes, binary STL files that load without any format conversion,
+ * optionally reduced to their convex hulls, and a copy of the URDF that points at them. Entries
+ * are keyed by a hash of the URDF, the SRDF and the cache options, and remember the size and
+ * modification time of every source mesh, so editing the description or a mesh invalidates them.
+ *
+ * Nodes call cachedRobotDescription() and load their robot models from the parameter it returns.
+ */
+
+namespace godel_utils
+{
+namespace model_cache
+{
+
+/** @brief Triangle mesh: x, y, z of each vertex, and three vertex indices per triangle */
+struct MeshData
+{
+  std::vector<float> vertices;
+  std::vector<uint32_t> triangles;
+};
+
+struct CacheOptions
+{
+  CacheOptions() : convex_hulls(false), keep_entries(4) {}
+
+  // Replace every collision mesh by its convex hull. Collision checks get much cheaper, but are
+  // conservative: concave parts of links collide with what sits in their hollows.
+  bool convex_hulls;
+  // Least recently used entries beyond this many are deleted
+  std::size_t keep_entries;
+};
+
+/** @brief Cache key of a robot description: a hash of the URDF, the SRDF and the options */
+std::string descriptionHash(const std::string& urdf, const std::string& srdf, const CacheOptions& options);
+
+/** @brief URIs of the collision meshes of a URDF, in order of appearance, without repeats */
+std::vector<std::string> collisionMeshes(const std::string& urdf);
+
+bool writeBinaryStl(const std::string& path, const MeshData& mesh);
+bool readBinaryStl(const std::string& path, MeshData& mesh);
+
+/** @brief Reads a mesh resource (package://, file://) the way MoveIt does, with geometric_shapes */
+bool loadMesh(const std::string& uri, MeshData& mesh);
+
+/** @brief Replaces a mesh by its convex hull */
+bool convexHull(MeshData& mesh);
+
+class ModelCache
+{
+public:
+  /** @brief Reads the mesh at a URI (package://, file://) */
+  typedef boost::function<bool(const std::string& uri, MeshData& mesh)> MeshLoader;
+  /** @brief Replaces a mesh by its convex hull */
+  typedef boost::function<bool(MeshData& mesh)> HullBuilder;
+  /**
+   * @brief Identifies the current version of a mesh source, e.g. its size and modification time;
+   * empty if it can't be determined, in which case the mesh is assumed unchanged
+   */
+  typedef boost::function<std::string(const std::string& uri)> SourceStamp;
+
+  /**
+   * @brief A cache in 'directory'. Empty functions stand for the defaults: loadMesh(),
+   * convexHull(), and the size and modification time of the mesh file.
+   */
+  explicit ModelCache(const std::string& directory, const MeshLoader& loader = MeshLoader(),
+                      const HullBuilder& hull = HullBuilder(), const SourceStamp& stamp = SourceStamp());
+
+  /**
+   * @brief The URDF to load robot models from: the original with every collision mesh read from
+   * the cache. Builds the cache entry if it is missing or stale.
+   * @param hit Set to true if a valid entry was found
+   * @return false if the entry couldn't be built; use the original URDF then
+   */
+  bool prepare(const std::string& urdf, const std::string& srdf, const CacheOptions& options,
+               std::string& cached_urdf, bool& hit);
+
+  /** @brief Deletes all but the 'keep' most recently used entries */
+  void prune(std::size_t keep) const;
+
+  /** @brief Directory of the entry of a description hash */
+  std::string entryDirectory(const std::string& hash) const;
+
+private:
+  bool loadEntry(const std::string& hash, const std::vector<std::string>& sources, std::string& cached_urdf) const;
+  bool buildEntry(const std::string& hash, const std::string& urdf, const std::vector<std::string>& sources,
+                  const CacheOptions& options, std::string& cached_urdf) const;
+
+  std::string directory_;
+  MeshLoader loader_;
+  HullBuilder hull_;
+  SourceStamp stamp_;
+};
+
+/**
+ * @brief Prepares the cached copy of a robot description and puts it on the parameter server
+ * next to the original, as '<robot_description>_cached' (and '<robot_description>_cached_semantic'
+ * for the SRDF), so that RobotModelLoader and MoveGroupInterface can load it by name. The
+ * kinematics and joint limit parameters of the original are copied along.
+ *
+ * Reads 'model_cache/enabled' (default true), 'model_cache/directory' (default
+ * $ROS_HOME/godel_model_cache), 'model_cache/convex_hulls' and 'model_cache/keep_entries'.
+ *
+ * @return The parameter to load robot models from: the cached description, or the original one
+ * if caching is disabled or fails
+ */
+std::string cachedRobotDescription(const std::string& robot_description = "robot_description");
+
+} // namespace model_cache
+} // namespace godel_utils
+
+#endif // GODEL_UTILS_MODEL_CACHE_H
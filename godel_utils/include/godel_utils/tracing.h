@@ -0,0 +1,136 @@
+#ifndef GODEL_UTILS_TRACING_H
+#define GODEL_UTILS_TRACING_H
+
+#include <godel_msgs/TraceContext.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/*
+ * Lightweight tracing of requests as they move through the godel nodes.
+ *
+ * A trace is a tree of timed spans that all share one trace id. Spans are scoped objects; a span
+ * created while another is open on the same thread becomes its child. To continue a trace in
+ * another node, the caller puts tracing::inject() into the request's or goal's 'trace' field and
+ * the server opens its outermost span with that context:
+ *
+ *   // caller                                   // server callback
+ *   req.trace = tracing::inject();              tracing::Span span("offset_polygon", req.trace);
+ *   client.call(req, res);
+ *
+ * Ids are always propagated, but spans are only recorded when the GODEL_TRACE_DIR environment
+ * variable names a directory. Each node then writes <dir>/<node>_<pid>.trace.json in the Chrome
+ * trace-event format (chrome://tracing, https://ui.perfetto.dev) and 'rosrun godel_utils
+ * trace_merge' combines the files of several nodes into one timeline, optionally keeping a single
+ * trace. Recording is lock-free: every thread appends to its own fixed-size ring, and spans that
+ * don't fit before the rings are next drained are dropped and counted.
+ */
+
+namespace godel_utils
+{
+namespace tracing
+{
+
+/**
+ * @brief Enables recording if GODEL_TRACE_DIR is set. Spans are written to disk when the rings
+ * fill up and when the process exits. Call once, after ros::init().
+ * @param process_name Names the process in the timeline and its trace file, e.g. the node name
+ * @return true if recording was enabled
+ */
+bool initialize(const std::string& process_name);
+
+/**
+ * @brief Enables recording to an explicit directory (an empty directory disables it again)
+ */
+bool initialize(const std::string& process_name, const std::string& directory);
+
+/** @brief Whether spans are being recorded */
+bool enabled();
+
+/**
+ * @brief Appends the spans recorded so far to this process's trace file
+ * @return false if the file couldn't be written
+ */
+bool flush();
+
+/** @brief Path of this process's trace file, empty if recording is disabled */
+std::string traceFile();
+
+/** @brief Spans dropped because a thread's ring was full */
+std::uint64_t droppedSpans();
+
+/**
+ * @brief Context of the span open on this thread, empty if there is none
+ */
+godel_msgs::TraceContext current();
+
+/**
+ * @brief Context to send with an outgoing request or goal. Records the start of the arrow
+ * drawn from the current span to the span the receiver opens with it.
+ */
+godel_msgs::TraceContext inject();
+
+/**
+ * @brief Records a named, timed region of work. Must be destroyed on the thread that created it.
+ */
+class Span
+{
+public:
+  /**
+   * @brief Opens a child of the span open on this thread, or starts a new trace if there is none
+   * @param name Must outlive the span; string literals are expected
+   */
+  explicit Span(const char* name);
+
+  /**
+   * @brief Opens a span that continues the trace of a received request or goal. Starts a new
+   * trace if the context is empty (the caller doesn't trace).
+   */
+  Span(const char* name, const godel_msgs::TraceContext& parent);
+
+  ~Span();
+
+  const std::string& traceId() const { return trace_id_; }
+  std::uint64_t spanId() const { return span_id_; }
+  std::uint64_t parentId() const { return parent_id_; }
+
+private:
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  void open(const char* name, const std::string& trace_id, std::uint64_t parent_id);
+
+  const char* name_;
+  std::string trace_id_;
+  std::uint64_t span_id_;
+  std::uint64_t parent_id_;
+  std::int64_t start_us_;
+
+  // Restored when this span closes
+  std::string previous_trace_id_;
+  std::uint64_t previous_span_id_;
+};
+
+/**
+ * @brief Combines per-node trace files into one Chrome trace
+ * @param files Trace files written by flush()
+ * @param trace_id If not empty, only events of this trace (and the process names) are kept
+ * @param out Receives a JSON object with a 'traceEvents' array
+ * @return Number of events written, not counting process names
+ */
+std::size_t mergeTraceFiles(const std::vector<std::string>& files, const std::string& trace_id,
+                            std::ostream& out);
+
+} // namespace tracing
+} // namespace godel_utils
+
+#define GODEL_TRACE_CONCAT_(a, b) a##b
+#define GODEL_TRACE_CONCAT(a, b) GODEL_TRACE_CONCAT_(a, b)
+
+/** @brief Traces the rest of the enclosing scope as a child of the current span */
+#define GODEL_TRACE_SPAN(name) \
+  ::godel_utils::tracing::Span GODEL_TRACE_CONCAT(godel_trace_span_, __LINE__)(name)
+
+#endif // GODEL_UTILS_TRACING_H
@@ -0,0 +1,61 @@
+#include <godel_utils/intra_process.h>
+
+#include <boost/weak_ptr.hpp>
+#include <ros/console.h>
+
+#include <map>
+
+namespace godel_utils
+{
+namespace intra_process
+{
+namespace detail
+{
+
+namespace
+{
+
+struct Entry
+{
+  std::string type;
+  boost::weak_ptr<ServiceQueueBase> queue;
+};
+
+// Shared by every nodelet of a manager
+std::mutex registry_mutex;
+std::map<std::string, Entry> registry;
+
+} // namespace
+
+void registerService(const std::string& name, const std::type_info& type,
+                     const boost::shared_ptr<ServiceQueueBase>& queue)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  Entry& entry = registry[name];
+  if (!entry.queue.expired())
+    ROS_WARN_STREAM("Service '" << name << "' is served twice in this process; in-process calls go to the last");
+  // Type names rather than type_info objects are compared, as nodelets live in different libraries
+  entry.type = type.name();
+  entry.queue = queue;
+}
+
+void unregisterService(const std::string& name, const ServiceQueueBase* queue)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  const auto it = registry.find(name);
+  if (it != registry.end() && (it->second.queue.expired() || it->second.queue.lock().get() == queue))
+    registry.erase(it);
+}
+
+boost::shared_ptr<ServiceQueueBase> findService(const std::string& name, const std::type_info& type)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  const auto it = registry.find(name);
+  if (it == registry.end() || it->second.type != type.name())
+    return boost::shared_ptr<ServiceQueueBase>();
+  return it->second.queue.lock();
+}
+
+} // namespace detail
+} // namespace intra_process
+} // namespace godel_utils
@@ -0,0 +1,209 @@
+#include <godel_utils/memory_accounting.h>
+
+#include <ros/console.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace godel_utils
+{
+namespace memory
+{
+
+const static std::string SOFT_BUDGET_PARAM = "soft_budget_mb";
+const static std::string HARD_BUDGET_PARAM = "hard_budget_mb";
+const static std::string SPILL_DIRECTORY_PARAM = "spill_directory";
+const static std::string DIAGNOSTICS_TOPIC = "/diagnostics";
+const static double BYTES_PER_MB = 1024.0 * 1024.0;
+
+namespace
+{
+
+std::string toMb(std::size_t bytes)
+{
+  std::ostringstream ss;
+  ss.precision(1);
+  ss << std::fixed << bytes / BYTES_PER_MB;
+  return ss.str();
+}
+
+diagnostic_msgs::KeyValue keyValue(const std::string& key, const std::string& value)
+{
+  diagnostic_msgs::KeyValue kv;
+  kv.key = key;
+  kv.value = value;
+  return kv;
+}
+
+} // end anon namespace
+
+std::size_t AccountedStore::enforceSoftBudget()
+{
+  if (budget_.soft_bytes == 0 || bytesUsed() <= budget_.soft_bytes)
+    return 0;
+  return shrinkTo(budget_.soft_bytes);
+}
+
+void AccountedStore::enforceHardBudget()
+{
+  if (budget_.hard_bytes == 0 || bytesUsed() <= budget_.hard_bytes)
+    return;
+  // Going back to the soft budget rather than just under the hard one leaves room to grow
+  // before the next eviction
+  const std::size_t target = budget_.soft_bytes != 0 ? budget_.soft_bytes : budget_.hard_bytes;
+  shrinkTo(target);
+}
+
+std::size_t AccountedStore::shrinkTo(std::size_t target_bytes)
+{
+  const std::size_t before = bytesUsed();
+  evict(target_bytes);
+  const std::size_t after = bytesUsed();
+  const std::size_t freed = before > after ? before - after : 0;
+
+  ++evictions_;
+  bytes_evicted_ += freed;
+  ROS_DEBUG_STREAM("Store '" << storeName() << "' evicted " << toMb(freed) << "MB, now holds "
+                             << toMb(after) << "MB");
+  if (after > target_bytes)
+    ROS_WARN_STREAM_THROTTLE(10.0, "Store '" << storeName() << "' holds " << toMb(after)
+                                             << "MB, over its " << toMb(target_bytes)
+                                             << "MB budget, and has nothing left to evict");
+  return freed;
+}
+
+MemoryBudget loadBudget(const ros::NodeHandle& nh, const std::string& store)
+{
+  double soft_mb = 0.0, hard_mb = 0.0;
+  nh.param(store + "/" + SOFT_BUDGET_PARAM, soft_mb, 0.0);
+  nh.param(store + "/" + HARD_BUDGET_PARAM, hard_mb, 0.0);
+
+  if (soft_mb < 0.0 || hard_mb < 0.0)
+  {
+    ROS_WARN_STREAM("Negative memory budget for store '" << store << "', using no budget");
+    return MemoryBudget();
+  }
+  if (soft_mb > 0.0 && hard_mb > 0.0 && soft_mb > hard_mb)
+  {
+    ROS_WARN_STREAM("Soft memory budget of store '" << store << "' is above its hard budget, "
+                                                   << "using the hard budget for both");
+    soft_mb = hard_mb;
+  }
+  return MemoryBudget(static_cast<std::size_t>(soft_mb * BYTES_PER_MB),
+                      static_cast<std::size_t>(hard_mb * BYTES_PER_MB));
+}
+
+std::string defaultSpillDirectory()
+{
+  const char* tmp = std::getenv("TMPDIR");
+  std::ostringstream ss;
+  ss << (tmp && *tmp ? tmp : "/tmp") << "/godel_spill_" << getpid();
+  return ss.str();
+}
+
+std::string loadSpillDirectory(const ros::NodeHandle& nh)
+{
+  std::string directory;
+  nh.param(SPILL_DIRECTORY_PARAM, directory, defaultSpillDirectory());
+  return directory;
+}
+
+std::size_t residentBytes()
+{
+  // Second field of statm is the resident set size, in pages
+  std::ifstream statm("/proc/self/statm");
+  std::size_t size = 0, resident = 0;
+  if (!(statm >> size >> resident))
+    return 0;
+  return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+MemoryMonitor::MemoryMonitor(const std::string& node_name)
+    : node_name_(node_name), update_on_timer_(false)
+{
+}
+
+void MemoryMonitor::add(AccountedStore& store) { stores_.push_back(&store); }
+
+void MemoryMonitor::startPublishing(ros::NodeHandle& nh, double period, bool update_on_timer)
+{
+  update_on_timer_ = update_on_timer;
+  publisher_ = nh.advertise<diagnostic_msgs::DiagnosticArray>(DIAGNOSTICS_TOPIC, 1);
+  timer_ = nh.createTimer(ros::Duration(period), &MemoryMonitor::timerCallback, this);
+}
+
+void MemoryMonitor::update()
+{
+  diagnostic_msgs::DiagnosticArray report;
+  report.header.stamp = ros::Time::now();
+
+  std::size_t total = 0;
+  unsigned char worst = diagnostic_msgs::DiagnosticStatus::OK;
+  for (AccountedStore* store : stores_)
+  {
+    const std::size_t freed = store->enforceSoftBudget();
+    const std::size_t used = store->bytesUsed();
+    const MemoryBudget& budget = store->budget();
+    total += used;
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = node_name_ + ": memory/" + store->storeName();
+    status.hardware_id = node_name_;
+    if (budget.hard_bytes != 0 && used > budget.hard_bytes)
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::ERROR;
+      status.message = "Over hard budget";
+    }
+    else if (budget.soft_bytes != 0 && used > budget.soft_bytes)
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+      status.message = "Over soft budget";
+    }
+    else
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::OK;
+      status.message = freed != 0 ? "Evicted to soft budget" : "Within budget";
+    }
+    worst = std::max(worst, status.level);
+
+    status.values.push_back(keyValue("used_mb", toMb(used)));
+    status.values.push_back(keyValue("soft_budget_mb", toMb(budget.soft_bytes)));
+    status.values.push_back(keyValue("hard_budget_mb", toMb(budget.hard_bytes)));
+    status.values.push_back(keyValue("evictions", std::to_string(store->evictions())));
+    status.values.push_back(keyValue("evicted_mb", toMb(store->bytesEvicted())));
+    report.status.push_back(status);
+  }
+
+  diagnostic_msgs::DiagnosticStatus process;
+  process.name = node_name_ + ": memory";
+  process.hardware_id = node_name_;
+  process.level = worst;
+  process.message = worst == diagnostic_msgs::DiagnosticStatus::OK ? "OK" : "Stores over budget";
+  process.values.push_back(keyValue("resident_mb", toMb(residentBytes())));
+  process.values.push_back(keyValue("accounted_mb", toMb(total)));
+  report.status.push_back(process);
+
+  std::lock_guard<std::mutex> lock(report_mutex_);
+  report_ = report;
+}
+
+diagnostic_msgs::DiagnosticArray MemoryMonitor::report() const
+{
+  std::lock_guard<std::mutex> lock(report_mutex_);
+  return report_;
+}
+
+void MemoryMonitor::timerCallback(const ros::TimerEvent&)
+{
+  if (update_on_timer_)
+    update();
+  const diagnostic_msgs::DiagnosticArray last = report();
+  if (!last.status.empty())
+    publisher_.publish(last);
+}
+
+} // namespace memory
+} // namespace godel_utils
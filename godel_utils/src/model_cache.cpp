@@ -0,0 +1,499 @@
+#include <godel_utils/model_cache.h>
+
+#include <boost/filesystem.hpp>
+#include <geometric_shapes/bodies.h>
+#include <geometric_shapes/mesh_operations.h>
+#include <ros/console.h>
+#include <ros/node_handle.h>
+#include <ros/package.h>
+#include <ros/time.h>
+#include <xmlrpcpp/XmlRpcValue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <unistd.h>
+
+namespace godel_utils
+{
+namespace model_cache
+{
+
+namespace fs = boost::filesystem;
+
+// Bump whenever the layout of an entry changes; older entries then miss
+const static std::string CACHE_FORMAT = "godel_model_cache 1";
+const static std::string MANIFEST_FILE = "manifest";
+const static std::string URDF_FILE = "robot_description.urdf";
+const static std::string CACHED_SUFFIX = "_cached";
+const static std::string SEMANTIC_SUFFIX = "_semantic";
+// Parameters MoveIt reads next to a description: kinematics solvers and joint limits
+const static char* const MIRRORED_SUFFIXES[] = {"_kinematics", "_planning"};
+const static std::size_t STL_HEADER_SIZE = 80;
+const static std::size_t STL_TRIANGLE_SIZE = 50; // normal, three vertices, attribute count
+
+namespace
+{
+
+void fnv1a(uint64_t& hash, const std::string& data)
+{
+  for (unsigned char c : data)
+  {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  // Separator, so that ("ab", "c") and ("a", "bc") differ
+  hash ^= 0xff;
+  hash *= 1099511628211ULL;
+}
+
+// Calls f(value_begin, value_end) for every filename attribute of every <collision> element
+template <typename F>
+void forEachCollisionMesh(const std::string& urdf, F f)
+{
+  std::size_t pos = 0;
+  while ((pos = urdf.find("<collision", pos)) != std::string::npos)
+  {
+    const std::size_t tag_end = urdf.find('>', pos);
+    if (tag_end == std::string::npos)
+      return;
+    const char next = urdf[pos + std::strlen("<collision")];
+    if ((next != '>' && !std::isspace(static_cast<unsigned char>(next))) || urdf[tag_end - 1] == '/')
+    {
+      pos = tag_end;
+      continue;
+    }
+    const std::size_t end = urdf.find("</collision>", tag_end);
+    if (end == std::string::npos)
+      return;
+
+    std::size_t attr = tag_end;
+    while ((attr = urdf.find("filename", attr)) != std::string::npos && attr < end)
+    {
+      std::size_t quote = urdf.find_first_not_of(" \t\r\n=", attr + std::strlen("filename"));
+      if (quote >= end || (urdf[quote] != '"' && urdf[quote] != '\''))
+        break;
+      const std::size_t value_end = urdf.find(urdf[quote], quote + 1);
+      if (value_end == std::string::npos || value_end > end)
+        break;
+      f(quote + 1, value_end);
+      attr = value_end;
+    }
+    pos = end;
+  }
+}
+
+// Written next to the target and renamed over it, so that other nodes never read part of a file
+bool writeAtomically(const std::string& path, const std::string& data)
+{
+  static std::atomic<unsigned> counter(0);
+  const std::string tmp_path = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+  {
+    std::ofstream out(tmp_path.c_str(), std::ios::binary);
+    if (!out.write(data.data(), data.size()))
+    {
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+  {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool readFile(const std::string& path, std::string& data)
+{
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in)
+    return false;
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  data = ss.str();
+  return true;
+}
+
+std::string resolvePath(const std::string& uri)
+{
+  const std::string package_prefix = "package://", file_prefix = "file://";
+  if (uri.compare(0, file_prefix.size(), file_prefix) == 0)
+    return uri.substr(file_prefix.size());
+  if (uri.compare(0, package_prefix.size(), package_prefix) == 0)
+  {
+    const std::size_t slash = uri.find('/', package_prefix.size());
+    if (slash == std::string::npos)
+      return "";
+    const std::string package = ros::package::getPath(uri.substr(package_prefix.size(), slash - package_prefix.size()));
+    return package.empty() ? "" : package + uri.substr(slash);
+  }
+  return "";
+}
+
+std::string fileStamp(const std::string& uri)
+{
+  boost::system::error_code ec;
+  const fs::path path(resolvePath(uri));
+  if (path.empty())
+    return "";
+  const uintmax_t size = fs::file_size(path, ec);
+  if (ec)
+    return "";
+  const std::time_t time = fs::last_write_time(path, ec);
+  if (ec)
+    return "";
+  return std::to_string(size) + ":" + std::to_string(time);
+}
+
+template <typename T>
+void append(std::string& out, T value)
+{
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+std::string descriptionHash(const std::string& urdf, const std::string& srdf, const CacheOptions& options)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  fnv1a(hash, CACHE_FORMAT);
+  fnv1a(hash, urdf);
+  fnv1a(hash, srdf);
+  fnv1a(hash, options.convex_hulls ? "convex_hulls" : "meshes");
+
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+  return buffer;
+}
+
+std::vector<std::string> collisionMeshes(const std::string& urdf)
+{
+  std::vector<std::string> uris;
+  forEachCollisionMesh(urdf, [&](std::size_t begin, std::size_t end) {
+    const std::string uri = urdf.substr(begin, end - begin);
+    if (std::find(uris.begin(), uris.end(), uri) == uris.end())
+      uris.push_back(uri);
+  });
+  return uris;
+}
+
+bool writeBinaryStl(const std::string& path, const MeshData& mesh)
+{
+  const std::size_t triangles = mesh.triangles.size() / 3;
+  std::string data(STL_HEADER_SIZE, '\0');
+  std::strncpy(&data[0], CACHE_FORMAT.c_str(), STL_HEADER_SIZE);
+  data.reserve(STL_HEADER_SIZE + 4 + triangles * STL_TRIANGLE_SIZE);
+  append(data, static_cast<uint32_t>(triangles));
+
+  for (std::size_t t = 0; t < triangles; ++t)
+  {
+    const float* v[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      const uint32_t index = mesh.triangles[3 * t + k];
+      if (3 * index + 2 >= mesh.vertices.size())
+        return false;
+      v[k] = &mesh.vertices[3 * index];
+    }
+
+    float a[3], b[3], n[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      a[k] = v[1][k] - v[0][k];
+      b[k] = v[2][k] - v[0][k];
+    }
+    n[0] = a[1] * b[2] - a[2] * b[1];
+    n[1] = a[2] * b[0] - a[0] * b[2];
+    n[2] = a[0] * b[1] - a[1] * b[0];
+    const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    for (int k = 0; k < 3; ++k)
+      append(data, length > 0.0f ? n[k] / length : 0.0f);
+
+    for (int k = 0; k < 3; ++k)
+      for (int c = 0; c < 3; ++c)
+        append(data, v[k][c]);
+    append(data, static_cast<uint16_t>(0));
+  }
+  return writeAtomically(path, data);
+}
+
+bool readBinaryStl(const std::string& path, MeshData& mesh)
+{
+  std::string data;
+  if (!readFile(path, data) || data.size() < STL_HEADER_SIZE + 4)
+    return false;
+
+  uint32_t triangles;
+  std::memcpy(&triangles, &data[STL_HEADER_SIZE], sizeof(triangles));
+  if (data.size() != STL_HEADER_SIZE + 4 + static_cast<std::size_t>(triangles) * STL_TRIANGLE_SIZE)
+    return false;
+
+  // Vertices are stored per triangle
+  mesh.vertices.resize(9 * static_cast<std::size_t>(triangles));
+  mesh.triangles.resize(3 * static_cast<std::size_t>(triangles));
+  for (std::size_t t = 0; t < triangles; ++t)
+  {
+    const char* record = &data[STL_HEADER_SIZE + 4 + t * STL_TRIANGLE_SIZE];
+    std::memcpy(&mesh.vertices[9 * t], record + 3 * sizeof(float), 9 * sizeof(float));
+    for (int k = 0; k < 3; ++k)
+      mesh.triangles[3 * t + k] = static_cast<uint32_t>(3 * t + k);
+  }
+  return true;
+}
+
+bool loadMesh(const std::string& uri, MeshData& mesh)
+{
+  std::unique_ptr<shapes::Mesh> m(shapes::createMeshFromResource(uri));
+  if (!m || m->triangle_count == 0)
+    return false;
+  mesh.vertices.assign(m->vertices, m->vertices + 3 * m->vertex_count);
+  mesh.triangles.assign(m->triangles, m->triangles + 3 * m->triangle_count);
+  return true;
+}
+
+bool convexHull(MeshData& mesh)
+{
+  shapes::Mesh m(mesh.vertices.size() / 3, mesh.triangles.size() / 3);
+  std::copy(mesh.vertices.begin(), mesh.vertices.end(), m.vertices);
+  std::copy(mesh.triangles.begin(), mesh.triangles.end(), m.triangles);
+
+  const bodies::ConvexMesh hull(&m);
+  const EigenSTL::vector_Vector3d& vertices = hull.getVertices();
+  const std::vector<unsigned int>& triangles = hull.getTriangles();
+  if (triangles.empty())
+    return false;
+
+  mesh.vertices.clear();
+  for (const auto& v : vertices)
+  {
+    mesh.vertices.push_back(v.x());
+    mesh.vertices.push_back(v.y());
+    mesh.vertices.push_back(v.z());
+  }
+  mesh.triangles.assign(triangles.begin(), triangles.end());
+  return true;
+}
+
+ModelCache::ModelCache(const std::string& directory, const MeshLoader& loader, const HullBuilder& hull,
+                       const SourceStamp& stamp)
+  : directory_(directory), loader_(loader.empty() ? MeshLoader(&loadMesh) : loader),
+    hull_(hull.empty() ? HullBuilder(&convexHull) : hull), stamp_(stamp.empty() ? SourceStamp(&fileStamp) : stamp)
+{
+}
+
+std::string ModelCache::entryDirectory(const std::string& hash) const
+{
+  return (fs::path(directory_) / hash).string();
+}
+
+/*
+ * An entry is a directory named after the description hash, holding one STL file per collision
+ * mesh, the rewritten URDF, and a manifest that is written last:
+ *
+ *   godel_model_cache <format>
+ *   source <tab> <uri> <tab> <stamp>     one per collision mesh, in order
+ *   file <tab> <name> <tab> <bytes>      the STL files and the URDF
+ */
+bool ModelCache::loadEntry(const std::string& hash, const std::vector<std::string>& sources,
+                           std::string& cached_urdf) const
+{
+  const fs::path entry(entryDirectory(hash));
+  std::ifstream manifest((entry / MANIFEST_FILE).string().c_str());
+  std::string line;
+  if (!std::getline(manifest, line) || line != CACHE_FORMAT)
+    return false;
+
+  std::size_t source = 0;
+  boost::system::error_code ec;
+  while (std::getline(manifest, line))
+  {
+    std::istringstream fields(line);
+    std::string kind, name, value;
+    if (!std::getline(fields, kind, '\t') || !std::getline(fields, name, '\t'))
+      return false;
+    std::getline(fields, value, '\t');
+
+    if (kind == "source")
+    {
+      // A mesh whose current version can't be told is assumed unchanged
+      if (source >= sources.size() || name != sources[source])
+        return false;
+      const std::string stamp = stamp_(name);
+      if (!stamp.empty() && stamp != value)
+        return false;
+      ++source;
+    }
+    else if (kind == "file")
+    {
+      if (fs::file_size(entry / name, ec) != std::strtoull(value.c_str(), NULL, 10) || ec)
+        return false;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  if (source != sources.size() || !readFile((entry / URDF_FILE).string(), cached_urdf))
+    return false;
+
+  // The modification time of the manifest orders entries for pruning
+  fs::last_write_time(entry / MANIFEST_FILE, std::time(NULL), ec);
+  return true;
+}
+
+bool ModelCache::buildEntry(const std::string& hash, const std::string& urdf, const std::vector<std::string>& sources,
+                            const CacheOptions& options, std::string& cached_urdf) const
+{
+  const fs::path entry(entryDirectory(hash));
+  boost::system::error_code ec;
+  fs::create_directories(entry, ec);
+  if (ec)
+  {
+    ROS_WARN_STREAM("Unable to create the model cache directory " << entry.string() << ": " << ec.message());
+    return false;
+  }
+
+  std::ostringstream manifest;
+  manifest << CACHE_FORMAT << "\n";
+
+  std::map<std::string, std::string> cached_paths;
+  for (std::size_t i = 0; i < sources.size(); ++i)
+  {
+    MeshData mesh;
+    if (!loader_(sources[i], mesh))
+    {
+      ROS_WARN_STREAM("Unable to read collision mesh " << sources[i] << " into the model cache");
+      return false;
+    }
+    if (options.convex_hulls && !hull_(mesh))
+    {
+      ROS_WARN_STREAM("Unable to compute the convex hull of collision mesh " << sources[i]);
+      return false;
+    }
+
+    const std::string name = "mesh_" + std::to_string(i) + ".stl";
+    if (!writeBinaryStl((entry / name).string(), mesh))
+    {
+      ROS_WARN_STREAM("Unable to write " << (entry / name).string());
+      return false;
+    }
+    cached_paths[sources[i]] = fs::absolute(entry / name).string();
+    manifest << "source\t" << sources[i] << "\t" << stamp_(sources[i]) << "\n";
+    manifest << "file\t" << name << "\t" << fs::file_size(entry / name, ec) << "\n";
+  }
+
+  // The URDF with its collision meshes pointing into the entry; everything else is untouched
+  cached_urdf.clear();
+  std::size_t copied = 0;
+  forEachCollisionMesh(urdf, [&](std::size_t begin, std::size_t end) {
+    cached_urdf.append(urdf, copied, begin - copied);
+    cached_urdf += "file://" + cached_paths[urdf.substr(begin, end - begin)];
+    copied = end;
+  });
+  cached_urdf.append(urdf, copied, std::string::npos);
+
+  if (!writeAtomically((entry / URDF_FILE).string(), cached_urdf))
+    return false;
+  manifest << "file\t" << URDF_FILE << "\t" << cached_urdf.size() << "\n";
+  return writeAtomically((entry / MANIFEST_FILE).string(), manifest.str());
+}
+
+bool ModelCache::prepare(const std::string& urdf, const std::string& srdf, const CacheOptions& options,
+                         std::string& cached_urdf, bool& hit)
+{
+  const std::string hash = descriptionHash(urdf, srdf, options);
+  const std::vector<std::string> sources = collisionMeshes(urdf);
+
+  hit = loadEntry(hash, sources, cached_urdf);
+  return hit || buildEntry(hash, urdf, sources, options, cached_urdf);
+}
+
+void ModelCache::prune(std::size_t keep) const
+{
+  boost::system::error_code ec;
+  std::vector<std::pair<std::time_t, fs::path>> entries;
+  for (fs::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec))
+  {
+    const fs::path manifest = it->path() / MANIFEST_FILE;
+    const std::time_t used = fs::exists(manifest, ec) ? fs::last_write_time(manifest, ec) : 0;
+    if (fs::is_directory(it->path(), ec))
+      entries.push_back(std::make_pair(used, it->path()));
+  }
+
+  std::sort(entries.begin(), entries.end(), [](const std::pair<std::time_t, fs::path>& a,
+                                               const std::pair<std::time_t, fs::path>& b) {
+    return a.first > b.first;
+  });
+  for (std::size_t i = keep; i < entries.size(); ++i)
+    fs::remove_all(entries[i].second, ec);
+}
+
+std::string cachedRobotDescription(const std::string& robot_description)
+{
+  ros::NodeHandle nh;
+
+  bool enabled;
+  nh.param("model_cache/enabled", enabled, true);
+  if (!enabled)
+    return robot_description;
+
+  std::string urdf, srdf;
+  if (!nh.getParam(robot_description, urdf))
+  {
+    ROS_WARN_STREAM("No robot description in '" << robot_description << "' to cache");
+    return robot_description;
+  }
+  nh.getParam(robot_description + SEMANTIC_SUFFIX, srdf);
+
+  const char* ros_home = std::getenv("ROS_HOME");
+  const char* home = std::getenv("HOME");
+  const std::string default_directory =
+      ros_home ? std::string(ros_home) + "/godel_model_cache"
+               : std::string(home ? home : ".") + "/.ros/godel_model_cache";
+
+  CacheOptions options;
+  std::string directory;
+  int keep_entries;
+  nh.param<std::string>("model_cache/directory", directory, default_directory);
+  nh.param("model_cache/convex_hulls", options.convex_hulls, options.convex_hulls);
+  nh.param("model_cache/keep_entries", keep_entries, static_cast<int>(options.keep_entries));
+  options.keep_entries = std::max(keep_entries, 1);
+
+  const ros::WallTime start = ros::WallTime::now();
+  ModelCache cache(directory);
+  std::string cached_urdf;
+  bool hit;
+  if (!cache.prepare(urdf, srdf, options, cached_urdf, hit))
+  {
+    ROS_WARN_STREAM("Unable to cache the robot description in " << directory << "; loading it uncached");
+    return robot_description;
+  }
+  cache.prune(options.keep_entries);
+
+  const std::string cached = robot_description + CACHED_SUFFIX;
+  nh.setParam(cached, cached_urdf);
+  nh.setParam(cached + SEMANTIC_SUFFIX, srdf);
+  for (const char* suffix : MIRRORED_SUFFIXES)
+  {
+    XmlRpc::XmlRpcValue value;
+    if (nh.getParam(robot_description + suffix, value))
+      nh.setParam(cached + suffix, value);
+  }
+  ROS_INFO_STREAM((hit ? "Loaded" : "Built") << " the cached robot description "
+                  << descriptionHash(urdf, srdf, options) << " in " << (ros::WallTime::now() - start).toSec()
+                  << " s");
+  return cached;
+}
+
+} // namespace model_cache
+} // namespace godel_utils
@@ -0,0 +1,56 @@
+/*
+ * Combines the trace files written by several nodes into one Chrome trace:
+ *
+ *   rosrun godel_utils trace_merge [--trace <trace_id>] -o merged.json $GODEL_TRACE_DIR/*.trace.json
+ *
+ * Open the result in chrome://tracing or https://ui.perfetto.dev. Calls between nodes are drawn
+ * as arrows from the caller's span to the receiver's.
+ */
+
+#include <godel_utils/tracing.h>
+
+#include <fstream>
+#include <iostream>
+
+static int usage(const char* program)
+{
+  std::cerr << "Usage: " << program << " [--trace <trace_id>] [-o <output.json>] <trace files...>\n";
+  return 1;
+}
+
+int main(int argc, char** argv)
+{
+  std::string trace_id, output;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if ((arg == "--trace" || arg == "-o") && i + 1 < argc)
+      (arg == "-o" ? output : trace_id) = argv[++i];
+    else if (arg.empty() || arg[0] == '-')
+      return usage(argv[0]);
+    else
+      files.push_back(arg);
+  }
+  if (files.empty())
+    return usage(argv[0]);
+
+  std::size_t events;
+  if (output.empty())
+  {
+    events = godel_utils::tracing::mergeTraceFiles(files, trace_id, std::cout);
+  }
+  else
+  {
+    std::ofstream out(output.c_str());
+    if (!out)
+    {
+      std::cerr << "Unable to write " << output << "\n";
+      return 1;
+    }
+    events = godel_utils::tracing::mergeTraceFiles(files, trace_id, out);
+  }
+
+  std::cerr << "Merged " << events << " events from " << files.size() << " files\n";
+  return events > 0 ? 0 : 1;
+}
@@ -0,0 +1,454 @@
+#include <godel_utils/tracing.h>
+#include <ros/console.h>
+
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace godel_utils
+{
+namespace tracing
+{
+
+const static std::string TRACE_DIRECTORY_VARIABLE = "GODEL_TRACE_DIR";
+const static std::string TRACE_FILE_SUFFIX = ".trace.json";
+const static char* const CALL_EVENT_NAME = "call";
+
+const static std::size_t RING_SIZE = 2048;           // events per thread
+const static std::size_t RING_DRAIN_LEVEL = 1536;    // a thread tries to drain the rings from here on
+const static std::size_t MAX_TRACE_ID_LENGTH = 32;
+
+namespace
+{
+
+// Recorded by the thread that owns the ring; trace ids are copied so the ring has no pointers
+// into thread or message state (names are string literals)
+struct Event
+{
+  const char* name;
+  char trace_id[MAX_TRACE_ID_LENGTH + 1];
+  std::uint64_t span_id;   // the flow id for flow events
+  std::uint64_t parent_id;
+  std::int64_t ts_us;
+  std::int64_t dur_us;
+  char phase;              // 'X' span, 's'/'f' start/end of a call between spans
+};
+
+// Single producer (the owning thread), single consumer (whoever holds the recorder mutex)
+struct ThreadBuffer
+{
+  explicit ThreadBuffer(std::uint32_t id) : tid(id), head(0), tail(0) {}
+
+  const std::uint32_t tid;
+  std::array<Event, RING_SIZE> ring;
+  std::atomic<std::uint64_t> head;
+  std::atomic<std::uint64_t> tail;
+};
+
+struct Recorder
+{
+  Recorder() : enabled(false), dropped(0), pid(::getpid()), next_tid(1), header_written(false) {}
+
+  std::atomic<bool> enabled;
+  std::atomic<std::uint64_t> dropped;
+  const int pid;
+
+  // Guards everything below, and draining the rings
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::uint32_t next_tid;
+  std::string process_name;
+  std::string file;
+  bool header_written;
+};
+
+// Never destroyed, so spans closing during static destruction are safe
+Recorder& recorder()
+{
+  static Recorder* instance = new Recorder();
+  return *instance;
+}
+
+struct ThreadContext
+{
+  ThreadContext() : span_id(0) {}
+
+  std::string trace_id;
+  std::uint64_t span_id;
+};
+
+thread_local ThreadContext t_context;
+thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+
+std::int64_t nowMicroseconds()
+{
+  // Wall clock time so that the files of different nodes line up
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::uint64_t newId()
+{
+  thread_local std::mt19937_64 rng(std::random_device{}() ^
+                                   std::hash<std::thread::id>()(std::this_thread::get_id()));
+  std::uint64_t id;
+  do
+  {
+    id = rng();
+  } while (id == 0);
+  return id;
+}
+
+std::string newTraceId()
+{
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016" PRIx64, newId());
+  return buffer;
+}
+
+// Trace ids arrive in messages and end up in JSON, so only a safe subset is kept
+std::string sanitizeTraceId(const std::string& id)
+{
+  std::string result;
+  for (const char c : id)
+  {
+    if (result.size() == MAX_TRACE_ID_LENGTH)
+      break;
+    if (std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_')
+      result += c;
+  }
+  return result;
+}
+
+std::string escapeJson(const std::string& s)
+{
+  std::string result;
+  for (const char c : s)
+  {
+    if (c == '"' || c == '\\')
+      result += '\\';
+    if (static_cast<unsigned char>(c) >= 0x20)
+      result += c;
+  }
+  return result;
+}
+
+std::string fileStem(const std::string& process_name)
+{
+  std::string stem;
+  for (const char c : process_name)
+    stem += std::isalnum(static_cast<unsigned char>(c)) || c == '-' ? c : '_';
+  const std::size_t first = stem.find_first_not_of('_');
+  return first == std::string::npos ? "process" : stem.substr(first);
+}
+
+void writeEvent(std::ostream& out, const Event& e, int pid, std::uint32_t tid)
+{
+  char line[512];
+  if (e.phase == 'X')
+  {
+    std::snprintf(line, sizeof(line),
+                  "{\"name\":\"%s\",\"cat\":\"godel\",\"ph\":\"X\",\"ts\":%" PRId64 ",\"dur\":%" PRId64
+                  ",\"pid\":%d,\"tid\":%u,\"args\":{\"trace_id\":\"%s\",\"span_id\":\"%016" PRIx64
+                  "\",\"parent_id\":\"%016" PRIx64 "\"}},\n",
+                  e.name, e.ts_us, e.dur_us, pid, tid, e.trace_id, e.span_id, e.parent_id);
+  }
+  else
+  {
+    // Calls end on the span that encloses the flow's end ("bp":"e"), i.e. the receiver's span
+    std::snprintf(line, sizeof(line),
+                  "{\"name\":\"%s\",\"cat\":\"godel\",\"ph\":\"%c\",%s\"id\":\"0x%016" PRIx64 "\",\"ts\":%" PRId64
+                  ",\"pid\":%d,\"tid\":%u,\"args\":{\"trace_id\":\"%s\"}},\n",
+                  e.name, e.phase, e.phase == 'f' ? "\"bp\":\"e\"," : "", e.span_id, e.ts_us, pid, tid,
+                  e.trace_id);
+  }
+  out << line;
+}
+
+// Requires the recorder mutex
+bool flushLocked(Recorder& r)
+{
+  if (r.file.empty())
+    return false;
+
+  // The JSON array format may end without ']', so the file can simply be appended to
+  std::ofstream out(r.file.c_str(), r.header_written ? std::ios::app : std::ios::trunc);
+  if (!out)
+  {
+    ROS_ERROR_STREAM("Unable to write trace file " << r.file);
+    return false;
+  }
+  if (!r.header_written)
+  {
+    out << "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << r.pid << ",\"args\":{\"name\":\""
+        << escapeJson(r.process_name) << "\"}},\n";
+    r.header_written = true;
+  }
+
+  for (auto it = r.buffers.begin(); it != r.buffers.end();)
+  {
+    ThreadBuffer& buffer = **it;
+    const std::uint64_t head = buffer.head.load(std::memory_order_acquire);
+    std::uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail)
+      writeEvent(out, buffer.ring[tail % RING_SIZE], r.pid, buffer.tid);
+    buffer.tail.store(tail, std::memory_order_release);
+
+    // Rings of threads that have exited are dropped once they are empty
+    if (it->use_count() == 1)
+      it = r.buffers.erase(it);
+    else
+      ++it;
+  }
+  out.flush();
+  return static_cast<bool>(out);
+}
+
+void flushAtExit()
+{
+  flush();
+  const std::uint64_t dropped = droppedSpans();
+  if (dropped > 0)
+    ROS_WARN_STREAM(dropped << " trace events were dropped because a thread recorded them faster than they were written");
+}
+
+ThreadBuffer& threadBuffer()
+{
+  if (!t_buffer)
+  {
+    Recorder& r = recorder();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    t_buffer = std::make_shared<ThreadBuffer>(r.next_tid++);
+    r.buffers.push_back(t_buffer);
+  }
+  return *t_buffer;
+}
+
+void record(const Event& event)
+{
+  ThreadBuffer& buffer = threadBuffer();
+  Recorder& r = recorder();
+
+  const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  const std::uint64_t used = head - buffer.tail.load(std::memory_order_acquire);
+  if (used >= RING_SIZE)
+  {
+    r.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer.ring[head % RING_SIZE] = event;
+  buffer.head.store(head + 1, std::memory_order_release);
+
+  // Drain when the ring is getting full, unless another thread is already writing
+  if (used + 1 >= RING_DRAIN_LEVEL)
+  {
+    std::unique_lock<std::mutex> lock(r.mutex, std::try_to_lock);
+    if (lock.owns_lock())
+      flushLocked(r);
+  }
+}
+
+Event makeEvent(char phase, const char* name, const std::string& trace_id, std::uint64_t span_id)
+{
+  Event e;
+  e.phase = phase;
+  e.name = name;
+  std::strncpy(e.trace_id, trace_id.c_str(), MAX_TRACE_ID_LENGTH);
+  e.trace_id[MAX_TRACE_ID_LENGTH] = '\0';
+  e.span_id = span_id;
+  e.parent_id = 0;
+  e.ts_us = nowMicroseconds();
+  e.dur_us = 0;
+  return e;
+}
+
+} // end anon namespace
+
+bool initialize(const std::string& process_name)
+{
+  const char* directory = std::getenv(TRACE_DIRECTORY_VARIABLE.c_str());
+  return initialize(process_name, directory ? directory : "");
+}
+
+bool initialize(const std::string& process_name, const std::string& directory)
+{
+  Recorder& r = recorder();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  if (r.header_written)
+    flushLocked(r);
+
+  r.process_name = process_name;
+  r.header_written = false;
+  if (directory.empty())
+  {
+    r.file.clear();
+    r.enabled = false;
+    return false;
+  }
+
+  r.file = directory + "/" + fileStem(process_name) + "_" + std::to_string(r.pid) + TRACE_FILE_SUFFIX;
+  r.enabled = true;
+
+  static bool exit_handler_registered = false;
+  if (!exit_handler_registered)
+    exit_handler_registered = std::atexit(flushAtExit) == 0;
+
+  ROS_INFO_STREAM("Recording traces to " << r.file);
+  return true;
+}
+
+bool enabled()
+{
+  return recorder().enabled.load(std::memory_order_relaxed);
+}
+
+bool flush()
+{
+  Recorder& r = recorder();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return flushLocked(r);
+}
+
+std::string traceFile()
+{
+  Recorder& r = recorder();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return r.file;
+}
+
+std::uint64_t droppedSpans()
+{
+  return recorder().dropped.load(std::memory_order_relaxed);
+}
+
+godel_msgs::TraceContext current()
+{
+  godel_msgs::TraceContext context;
+  context.trace_id = t_context.trace_id;
+  context.span_id = t_context.span_id;
+  return context;
+}
+
+godel_msgs::TraceContext inject()
+{
+  godel_msgs::TraceContext context;
+  context.span_id = newId();
+  if (t_context.trace_id.empty())
+  {
+    // Nothing to draw the call from, but the receiver's spans are still one trace
+    context.trace_id = newTraceId();
+    return context;
+  }
+
+  context.trace_id = t_context.trace_id;
+  if (enabled())
+    record(makeEvent('s', CALL_EVENT_NAME, context.trace_id, context.span_id));
+  return context;
+}
+
+Span::Span(const char* name)
+{
+  if (t_context.trace_id.empty())
+    open(name, newTraceId(), 0);
+  else
+    open(name, t_context.trace_id, t_context.span_id);
+}
+
+Span::Span(const char* name, const godel_msgs::TraceContext& parent)
+{
+  const std::string trace_id = sanitizeTraceId(parent.trace_id);
+  if (trace_id.empty())
+  {
+    open(name, newTraceId(), 0);
+    return;
+  }
+
+  open(name, trace_id, parent.span_id);
+  if (start_us_ != 0 && parent.span_id != 0)
+    record(makeEvent('f', CALL_EVENT_NAME, trace_id_, parent.span_id));
+}
+
+void Span::open(const char* name, const std::string& trace_id, std::uint64_t parent_id)
+{
+  name_ = name;
+  trace_id_ = trace_id;
+  span_id_ = newId();
+  parent_id_ = parent_id;
+  start_us_ = enabled() ? nowMicroseconds() : 0;
+
+  previous_trace_id_.swap(t_context.trace_id);
+  previous_span_id_ = t_context.span_id;
+  t_context.trace_id = trace_id_;
+  t_context.span_id = span_id_;
+}
+
+Span::~Span()
+{
+  t_context.trace_id.swap(previous_trace_id_);
+  t_context.span_id = previous_span_id_;
+
+  // Spans opened before recording was enabled aren't recorded
+  if (start_us_ == 0)
+    return;
+  Event e = makeEvent('X', name_, trace_id_, span_id_);
+  e.parent_id = parent_id_;
+  e.dur_us = e.ts_us - start_us_;
+  e.ts_us = start_us_;
+  record(e);
+}
+
+std::size_t mergeTraceFiles(const std::vector<std::string>& files, const std::string& trace_id,
+                            std::ostream& out)
+{
+  const std::string metadata = "\"ph\":\"M\"";
+  const std::string wanted = "\"trace_id\":\"" + trace_id + "\"";
+
+  std::size_t events = 0;
+  bool first = true;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (const auto& file : files)
+  {
+    std::ifstream in(file.c_str());
+    if (!in)
+    {
+      ROS_WARN_STREAM("Unable to read trace file " << file);
+      continue;
+    }
+
+    // flush() writes one event per line
+    std::string line;
+    while (std::getline(in, line))
+    {
+      if (line.empty() || line[0] != '{')
+        continue;
+      while (!line.empty() && (line.back() == ',' || std::isspace(static_cast<unsigned char>(line.back()))))
+        line.pop_back();
+
+      const bool is_metadata = line.find(metadata) != std::string::npos;
+      if (!is_metadata && !trace_id.empty() && line.find(wanted) == std::string::npos)
+        continue;
+
+      out << (first ? "\n" : ",\n") << line;
+      first = false;
+      if (!is_metadata)
+        ++events;
+    }
+  }
+  out << "\n]}\n";
+  return events;
+}
+
+} // namespace tracing
+} // namespace godel_utils
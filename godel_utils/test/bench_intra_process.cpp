@@ -0,0 +1,112 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Cost of one offset_polygon call, the hop between process_path_generator and polygon_offset,
+ * without the work of the handler. Serialized is what every roscpp service call does on top of
+ * the socket round trip: serialize the request, deserialize it on the server, and the same for
+ * the response. InProcess hands the caller's request and response to the server's queue. The
+ * argument is the number of boundary points; the response carries five offsets of them.
+ */
+
+#include <godel_utils/intra_process.h>
+#include <benchmark/benchmark.h>
+#include <godel_msgs/OffsetBoundary.h>
+#include <ros/serialization.h>
+
+#include <cmath>
+
+using namespace godel_utils::intra_process;
+namespace ser = ros::serialization;
+
+namespace
+{
+
+const static int OFFSETS = 5;
+
+godel_msgs::OffsetBoundaryRequest makeRequest(int points)
+{
+  godel_msgs::OffsetBoundaryRequest req;
+  req.polygons.resize(1);
+  for (int i = 0; i < points; ++i)
+  {
+    geometry_msgs::Point32 p;
+    p.x = std::cos(2.0 * M_PI * i / points);
+    p.y = std::sin(2.0 * M_PI * i / points);
+    req.polygons[0].points.push_back(p);
+  }
+  req.offset_distance = 0.01;
+  return req;
+}
+
+// Replies with copies of the boundary, as many as the polygon offsetter typically produces
+bool handler(godel_msgs::OffsetBoundaryRequest& req, godel_msgs::OffsetBoundaryResponse& res)
+{
+  res.offset_polygons.assign(OFFSETS, req.polygons[0]);
+  res.offsets.assign(OFFSETS, req.offset_distance);
+  return true;
+}
+
+template <typename M>
+M roundTrip(const M& message)
+{
+  std::vector<uint8_t> buffer(ser::serializationLength(message));
+  ser::OStream out(buffer.data(), buffer.size());
+  ser::serialize(out, message);
+
+  M copy;
+  ser::IStream in(buffer.data(), buffer.size());
+  ser::deserialize(in, copy);
+  return copy;
+}
+
+void BM_Serialized(benchmark::State& state)
+{
+  const godel_msgs::OffsetBoundaryRequest req = makeRequest(state.range(0));
+  for (auto _ : state)
+  {
+    godel_msgs::OffsetBoundaryRequest server_req = roundTrip(req);
+    godel_msgs::OffsetBoundaryResponse server_res;
+    handler(server_req, server_res);
+    godel_msgs::OffsetBoundaryResponse res = roundTrip(server_res);
+    benchmark::DoNotOptimize(res.offset_polygons.data());
+  }
+}
+
+void BM_InProcess(benchmark::State& state)
+{
+  auto queue = boost::make_shared<ServiceQueue<godel_msgs::OffsetBoundary>>(&handler);
+  detail::registerService("/offset_polygon", typeid(godel_msgs::OffsetBoundary), queue);
+
+  godel_msgs::OffsetBoundaryRequest req = makeRequest(state.range(0));
+  for (auto _ : state)
+  {
+    godel_msgs::OffsetBoundaryResponse res;
+    bool result;
+    callInProcess<godel_msgs::OffsetBoundary>("/offset_polygon", req, res, result);
+    benchmark::DoNotOptimize(res.offset_polygons.data());
+  }
+  detail::unregisterService("/offset_polygon", queue.get());
+}
+
+} // end anon namespace
+
+BENCHMARK(BM_Serialized)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_InProcess)->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
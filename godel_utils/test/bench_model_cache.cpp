@@ -0,0 +1,173 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Startup cost of the collision meshes of a robot description, with and without the model cache.
+ * The robot is a chain of seven links whose collision meshes are ASCII STL spheres of about 20k
+ * triangles, like exported CAD models. LoadOriginalMeshes reads them the way MoveIt does at every
+ * start; PrepareCold builds the cache entry (the first start after a change), PrepareWarm validates
+ * an existing one and LoadCachedMeshes reads the cached meshes (every later start). The argument
+ * of the cached benchmarks selects convex hulls.
+ */
+
+#include <godel_utils/model_cache.h>
+#include <benchmark/benchmark.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+#include <fstream>
+
+using namespace godel_utils::model_cache;
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+const static int LINKS = 7;
+const static int RINGS = 100;
+const static int SEGMENTS = 100;
+
+void writeAsciiSphere(const std::string& path, double radius)
+{
+  std::ofstream out(path.c_str());
+  out << "solid link\n";
+  auto point = [&](int ring, int segment) {
+    const double theta = M_PI * ring / RINGS, phi = 2.0 * M_PI * segment / SEGMENTS;
+    return std::vector<double>{radius * std::sin(theta) * std::cos(phi), radius * std::sin(theta) * std::sin(phi),
+                               radius * std::cos(theta)};
+  };
+  for (int r = 0; r < RINGS; ++r)
+  {
+    for (int s = 0; s < SEGMENTS; ++s)
+    {
+      const std::vector<double> quad[4] = {point(r, s), point(r + 1, s), point(r + 1, s + 1), point(r, s + 1)};
+      for (int t = 0; t < 2; ++t)
+      {
+        out << "facet normal 0 0 0\n outer loop\n";
+        for (int k : {0, t + 1, t + 2})
+          out << "  vertex " << quad[k][0] << " " << quad[k][1] << " " << quad[k][2] << "\n";
+        out << " endloop\nendfacet\n";
+      }
+    }
+  }
+  out << "endsolid link\n";
+}
+
+struct Robot
+{
+  Robot() : directory(fs::temp_directory_path() / fs::unique_path("godel_bench_model_cache_%%%%-%%%%"))
+  {
+    fs::create_directories(directory / "meshes");
+    urdf = "<robot name=\"chain\">\n";
+    for (int i = 0; i < LINKS; ++i)
+    {
+      const fs::path mesh = directory / "meshes" / ("link_" + std::to_string(i) + ".stl");
+      writeAsciiSphere(mesh.string(), 0.1 + 0.01 * i);
+      urdf += "  <link name=\"link_" + std::to_string(i) + "\"><collision><geometry><mesh filename=\"file://" +
+              mesh.string() + "\"/></geometry></collision></link>\n";
+    }
+    urdf += "</robot>\n";
+    srdf = "<robot name=\"chain\"/>";
+  }
+
+  ~Robot() { fs::remove_all(directory); }
+
+  std::string cacheDirectory() const { return (directory / "cache").string(); }
+
+  fs::path directory;
+  std::string urdf;
+  std::string srdf;
+};
+
+CacheOptions options(const benchmark::State& state)
+{
+  CacheOptions options;
+  options.convex_hulls = state.range(0) != 0;
+  return options;
+}
+
+void loadAll(benchmark::State& state, const std::string& urdf)
+{
+  for (auto _ : state)
+  {
+    for (const auto& uri : collisionMeshes(urdf))
+    {
+      MeshData mesh;
+      if (!loadMesh(uri, mesh))
+        state.SkipWithError("Unable to load a mesh");
+      benchmark::DoNotOptimize(mesh.vertices.data());
+    }
+  }
+}
+
+void BM_LoadOriginalMeshes(benchmark::State& state)
+{
+  const Robot robot;
+  loadAll(state, robot.urdf);
+}
+
+void BM_PrepareCold(benchmark::State& state)
+{
+  const Robot robot;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    fs::remove_all(robot.cacheDirectory());
+    state.ResumeTiming();
+
+    ModelCache cache(robot.cacheDirectory());
+    std::string cached_urdf;
+    bool hit;
+    if (!cache.prepare(robot.urdf, robot.srdf, options(state), cached_urdf, hit))
+      state.SkipWithError("Unable to build the cache entry");
+  }
+}
+
+void BM_PrepareWarm(benchmark::State& state)
+{
+  const Robot robot;
+  ModelCache cache(robot.cacheDirectory());
+  std::string cached_urdf;
+  bool hit;
+  cache.prepare(robot.urdf, robot.srdf, options(state), cached_urdf, hit);
+  for (auto _ : state)
+  {
+    if (!cache.prepare(robot.urdf, robot.srdf, options(state), cached_urdf, hit) || !hit)
+      state.SkipWithError("The cache entry was rebuilt");
+  }
+}
+
+void BM_LoadCachedMeshes(benchmark::State& state)
+{
+  const Robot robot;
+  ModelCache cache(robot.cacheDirectory());
+  std::string cached_urdf;
+  bool hit;
+  cache.prepare(robot.urdf, robot.srdf, options(state), cached_urdf, hit);
+  loadAll(state, cached_urdf);
+}
+
+} // end anon namespace
+
+BENCHMARK(BM_LoadOriginalMeshes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PrepareCold)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PrepareWarm)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadCachedMeshes)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
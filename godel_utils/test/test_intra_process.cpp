@@ -0,0 +1,167 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <godel_utils/intra_process.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace godel_utils::intra_process;
+
+namespace
+{
+
+struct Polygons
+{
+  std::vector<double> points;
+};
+
+struct Offsets
+{
+  const Polygons* seen;
+  std::vector<double> offsets;
+};
+
+// Stands in for a generated service type
+struct OffsetService
+{
+  typedef Polygons Request;
+  typedef Offsets Response;
+};
+
+struct OtherService
+{
+  typedef Polygons Request;
+  typedef Offsets Response;
+};
+
+bool offset(Polygons& req, Offsets& res)
+{
+  res.seen = &req;
+  for (double p : req.points)
+    res.offsets.push_back(p + 1.0);
+  return !req.points.empty();
+}
+
+boost::shared_ptr<ServiceQueue<OffsetService>> serve(const std::string& name,
+                                                     const ServiceQueue<OffsetService>::Callback& callback)
+{
+  auto queue = boost::make_shared<ServiceQueue<OffsetService>>(callback);
+  detail::registerService(name, typeid(OffsetService), queue);
+  return queue;
+}
+
+} // end anon namespace
+
+TEST(IntraProcess, callsReachServerWithoutCopies)
+{
+  auto queue = serve("/offset", &offset);
+
+  Polygons req;
+  req.points = {1.0, 2.0};
+  Offsets res;
+  bool result = false;
+  ASSERT_TRUE(callInProcess<OffsetService>("/offset", req, res, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(&req, res.seen);
+  EXPECT_EQ(std::vector<double>({2.0, 3.0}), res.offsets);
+
+  // The handler's result is passed on
+  Polygons empty;
+  ASSERT_TRUE(callInProcess<OffsetService>("/offset", empty, res, result));
+  EXPECT_FALSE(result);
+
+  detail::unregisterService("/offset", queue.get());
+}
+
+TEST(IntraProcess, otherServicesAreNotServed)
+{
+  auto queue = serve("/offset", &offset);
+
+  Polygons req;
+  Offsets res;
+  bool result;
+  EXPECT_FALSE(callInProcess<OffsetService>("/other", req, res, result));
+  EXPECT_FALSE(callInProcess<OtherService>("/offset", req, res, result));
+
+  // Once the server is gone, calls go over ROS again
+  detail::unregisterService("/offset", queue.get());
+  EXPECT_FALSE(callInProcess<OffsetService>("/offset", req, res, result));
+
+  queue = serve("/offset", &offset);
+  queue.reset();
+  EXPECT_FALSE(callInProcess<OffsetService>("/offset", req, res, result));
+}
+
+TEST(IntraProcess, callsAreHandledOneAtATime)
+{
+  std::atomic<int> active(0), overlaps(0), handled(0);
+  auto queue = serve("/offset", [&](Polygons& req, Offsets& res) {
+    if (++active > 1)
+      ++overlaps;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    --active;
+    ++handled;
+    return offset(req, res);
+  });
+
+  std::vector<std::thread> callers;
+  for (int t = 0; t < 8; ++t)
+  {
+    callers.emplace_back([t]() {
+      for (int i = 0; i < 20; ++i)
+      {
+        Polygons req;
+        req.points = {double(t)};
+        Offsets res;
+        bool result;
+        ASSERT_TRUE(callInProcess<OffsetService>("/offset", req, res, result));
+        ASSERT_EQ(std::vector<double>({t + 1.0}), res.offsets);
+      }
+    });
+  }
+  for (auto& c : callers)
+    c.join();
+
+  EXPECT_EQ(160, handled);
+  EXPECT_EQ(0, overlaps);
+  detail::unregisterService("/offset", queue.get());
+}
+
+TEST(IntraProcess, handlerExceptionsReachCaller)
+{
+  auto queue = serve("/offset", [](Polygons&, Offsets&) -> bool { throw std::runtime_error("bad polygon"); });
+
+  Polygons req;
+  Offsets res;
+  bool result;
+  EXPECT_THROW(callInProcess<OffsetService>("/offset", req, res, result), std::runtime_error);
+
+  // A stopped server turns calls down
+  queue->stop();
+  EXPECT_FALSE(queue->call(req, res));
+  detail::unregisterService("/offset", queue.get());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
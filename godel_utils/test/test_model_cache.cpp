@@ -0,0 +1,278 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <godel_utils/model_cache.h>
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <map>
+
+using namespace godel_utils::model_cache;
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+const std::string URDF = "<robot name=\"r\">\n"
+                         "  <link name=\"base\">\n"
+                         "    <visual><geometry><mesh filename=\"package://r/visual/base.dae\"/></geometry></visual>\n"
+                         "    <collision><geometry><mesh filename=\"package://r/collision/base.stl\"/></geometry>"
+                         "</collision>\n"
+                         "  </link>\n"
+                         "  <link name=\"arm\">\n"
+                         "    <collision name='c'><geometry><mesh filename='package://r/collision/arm.stl' "
+                         "scale=\"0.001 0.001 0.001\"/></geometry></collision>\n"
+                         "    <collision><geometry><box size=\"1 1 1\"/></geometry></collision>\n"
+                         "  </link>\n"
+                         "  <link name=\"tool\">\n"
+                         "    <collision><geometry><mesh filename=\"package://r/collision/base.stl\"/></geometry>"
+                         "</collision>\n"
+                         "  </link>\n"
+                         "</robot>\n";
+const std::string SRDF = "<robot name=\"r\"><disable_collisions link1=\"base\" link2=\"arm\"/></robot>";
+
+// A single tetrahedron, displaced per URI so meshes can be told apart
+MeshData tetrahedron(float offset)
+{
+  MeshData mesh;
+  mesh.vertices = {offset, 0, 0, offset + 1, 0, 0, offset, 1, 0, offset, 0, 1};
+  mesh.triangles = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3};
+  return mesh;
+}
+
+// Stands in for the mesh files of a robot package
+struct FakeSources
+{
+  FakeSources() : loads(0), fail(false) {}
+
+  bool load(const std::string& uri, MeshData& mesh)
+  {
+    ++loads;
+    if (fail)
+      return false;
+    mesh = tetrahedron(uri.find("arm") != std::string::npos ? 2.0f : 0.0f);
+    return true;
+  }
+
+  std::string stamp(const std::string& uri) { return stamps[uri]; }
+
+  int loads;
+  bool fail;
+  std::map<std::string, std::string> stamps;
+};
+
+class ModelCacheTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    directory_ = fs::temp_directory_path() / fs::unique_path("godel_model_cache_%%%%-%%%%");
+    sources_.stamps["package://r/collision/base.stl"] = "100:1";
+    sources_.stamps["package://r/collision/arm.stl"] = "200:1";
+  }
+
+  void TearDown() override { fs::remove_all(directory_); }
+
+  ModelCache cache()
+  {
+    return ModelCache(directory_.string(),
+                      [this](const std::string& uri, MeshData& mesh) { return sources_.load(uri, mesh); },
+                      ModelCache::HullBuilder(),
+                      [this](const std::string& uri) { return sources_.stamp(uri); });
+  }
+
+  bool prepare(const std::string& urdf, std::string& cached_urdf, bool& hit)
+  {
+    return cache().prepare(urdf, SRDF, CacheOptions(), cached_urdf, hit);
+  }
+
+  fs::path directory_;
+  FakeSources sources_;
+};
+
+} // end anon namespace
+
+TEST(ModelCache, hashCoversDescriptionAndOptions)
+{
+  const CacheOptions options;
+  CacheOptions hulls;
+  hulls.convex_hulls = true;
+
+  const std::string hash = descriptionHash(URDF, SRDF, options);
+  EXPECT_EQ(hash, descriptionHash(URDF, SRDF, options));
+  EXPECT_NE(hash, descriptionHash(URDF + " ", SRDF, options));
+  EXPECT_NE(hash, descriptionHash(URDF, SRDF + " ", options));
+  EXPECT_NE(hash, descriptionHash(URDF, SRDF, hulls));
+  // Moving text between the URDF and the SRDF changes the key
+  EXPECT_NE(descriptionHash("ab", "c", options), descriptionHash("a", "bc", options));
+}
+
+TEST(ModelCache, collisionMeshesAreFound)
+{
+  const std::vector<std::string> expected = {"package://r/collision/base.stl", "package://r/collision/arm.stl"};
+  EXPECT_EQ(expected, collisionMeshes(URDF));
+  EXPECT_TRUE(collisionMeshes("<robot><collision/><link/></robot>").empty());
+}
+
+TEST(ModelCache, stlRoundTrips)
+{
+  const fs::path path = fs::temp_directory_path() / fs::unique_path("godel_mesh_%%%%-%%%%.stl");
+  const MeshData mesh = tetrahedron(0.5f);
+  ASSERT_TRUE(writeBinaryStl(path.string(), mesh));
+  EXPECT_EQ(84u + 4u * 50u, fs::file_size(path));
+
+  MeshData read;
+  ASSERT_TRUE(readBinaryStl(path.string(), read));
+  ASSERT_EQ(mesh.triangles.size(), read.triangles.size());
+  for (std::size_t i = 0; i < mesh.triangles.size(); ++i)
+    for (int c = 0; c < 3; ++c)
+      EXPECT_EQ(mesh.vertices[3 * mesh.triangles[i] + c], read.vertices[3 * read.triangles[i] + c]);
+
+  fs::resize_file(path, fs::file_size(path) - 1);
+  EXPECT_FALSE(readBinaryStl(path.string(), read));
+  fs::remove(path);
+}
+
+TEST_F(ModelCacheTest, secondStartIsServedFromCache)
+{
+  std::string first, second;
+  bool hit;
+  ASSERT_TRUE(prepare(URDF, first, hit));
+  EXPECT_FALSE(hit);
+  EXPECT_EQ(2, sources_.loads);
+
+  ASSERT_TRUE(prepare(URDF, second, hit));
+  EXPECT_TRUE(hit);
+  EXPECT_EQ(2, sources_.loads);
+  EXPECT_EQ(first, second);
+
+  // Collision meshes point into the entry, visual meshes and attributes are kept
+  const std::string entry = cache().entryDirectory(descriptionHash(URDF, SRDF, CacheOptions()));
+  EXPECT_EQ(std::string::npos, second.find("package://r/collision"));
+  EXPECT_NE(std::string::npos, second.find("package://r/visual/base.dae"));
+  EXPECT_NE(std::string::npos, second.find("scale=\"0.001 0.001 0.001\""));
+  EXPECT_EQ(collisionMeshes(URDF).size(), collisionMeshes(second).size());
+  for (const auto& uri : collisionMeshes(second))
+  {
+    ASSERT_EQ(0u, uri.find("file://" + fs::absolute(entry).string()));
+    MeshData mesh;
+    EXPECT_TRUE(readBinaryStl(uri.substr(std::string("file://").size()), mesh));
+  }
+}
+
+TEST_F(ModelCacheTest, changedDescriptionMisses)
+{
+  std::string cached;
+  bool hit;
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+
+  std::string changed = URDF;
+  changed.replace(changed.find("name=\"tool\""), 11, "name=\"tcp\"");
+  ASSERT_TRUE(prepare(changed, cached, hit));
+  EXPECT_FALSE(hit);
+  EXPECT_NE(std::string::npos, cached.find("name=\"tcp\""));
+
+  ASSERT_TRUE(cache().prepare(URDF, SRDF + " ", CacheOptions(), cached, hit));
+  EXPECT_FALSE(hit);
+}
+
+TEST_F(ModelCacheTest, changedMeshMisses)
+{
+  std::string cached;
+  bool hit;
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+
+  sources_.stamps["package://r/collision/arm.stl"] = "200:2";
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  EXPECT_FALSE(hit);
+  EXPECT_EQ(4, sources_.loads);
+
+  // The rebuilt entry is valid for the new mesh
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  EXPECT_TRUE(hit);
+
+  // A mesh whose stamp can't be read is assumed unchanged
+  sources_.stamps["package://r/collision/arm.stl"] = "";
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  EXPECT_TRUE(hit);
+}
+
+TEST_F(ModelCacheTest, damagedEntryIsRebuilt)
+{
+  std::string cached;
+  bool hit;
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  const fs::path entry = cache().entryDirectory(descriptionHash(URDF, SRDF, CacheOptions()));
+
+  fs::resize_file(entry / "mesh_1.stl", 84);
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  EXPECT_FALSE(hit);
+
+  fs::remove(entry / "mesh_0.stl");
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  EXPECT_FALSE(hit);
+
+  std::ofstream((entry / "manifest").string().c_str()) << "godel_model_cache 0\n";
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  EXPECT_FALSE(hit);
+
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  EXPECT_TRUE(hit);
+}
+
+TEST_F(ModelCacheTest, failedBuildFallsBack)
+{
+  sources_.fail = true;
+  std::string cached;
+  bool hit;
+  EXPECT_FALSE(prepare(URDF, cached, hit));
+  EXPECT_FALSE(hit);
+
+  // Nothing usable was left behind
+  sources_.fail = false;
+  ASSERT_TRUE(prepare(URDF, cached, hit));
+  EXPECT_FALSE(hit);
+}
+
+TEST_F(ModelCacheTest, pruneKeepsRecentEntries)
+{
+  std::vector<std::string> urdfs;
+  for (int i = 0; i < 4; ++i)
+  {
+    urdfs.push_back(URDF + "<!-- " + std::to_string(i) + " -->");
+    std::string cached;
+    bool hit;
+    ASSERT_TRUE(prepare(urdfs.back(), cached, hit));
+    // Entries are ordered by the modification time of their manifest
+    fs::last_write_time(fs::path(cache().entryDirectory(descriptionHash(urdfs.back(), SRDF, CacheOptions()))) /
+                            "manifest",
+                        1000 + i);
+  }
+
+  cache().prune(2);
+  for (int i = 0; i < 4; ++i)
+    EXPECT_EQ(i >= 2, fs::exists(cache().entryDirectory(descriptionHash(urdfs[i], SRDF, CacheOptions()))));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,233 @@
+/*
+* Software License Agreement (Apache License)
+*
+* Copyright (c) 2016, Southwest Research Institute
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Follows a trace through a chain of two services, the same way process_path_generator calls
+ * offset_polygon on behalf of the path planning plugins, and checks the exported timeline.
+ */
+
+#include <godel_utils/tracing.h>
+#include <godel_msgs/OffsetBoundary.h>
+#include <godel_msgs/PathPlanning.h>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace tracing = godel_utils::tracing;
+
+namespace
+{
+
+const static std::string OUTER_SERVICE = "test_tracing_path_planning";
+const static std::string INNER_SERVICE = "test_tracing_offset";
+
+struct Observed
+{
+  godel_msgs::TraceContext context; // the server span's own context
+  std::uint64_t parent_id;
+};
+
+std::mutex observed_mutex;
+Observed outer_observed, inner_observed;
+std::string trace_directory;
+
+bool innerCallback(godel_msgs::OffsetBoundary::Request& req, godel_msgs::OffsetBoundary::Response&)
+{
+  tracing::Span span("inner", req.trace);
+  std::lock_guard<std::mutex> lock(observed_mutex);
+  inner_observed.context = tracing::current();
+  inner_observed.parent_id = span.parentId();
+  return true;
+}
+
+bool outerCallback(godel_msgs::PathPlanning::Request& req, godel_msgs::PathPlanning::Response&)
+{
+  tracing::Span span("outer", req.trace);
+  {
+    std::lock_guard<std::mutex> lock(observed_mutex);
+    outer_observed.context = tracing::current();
+    outer_observed.parent_id = span.parentId();
+  }
+
+  godel_msgs::OffsetBoundary srv;
+  {
+    GODEL_TRACE_SPAN("offset");
+    srv.request.trace = tracing::inject();
+    if (!ros::service::call(INNER_SERVICE, srv))
+      return false;
+  }
+  return true;
+}
+
+std::string readFile(const std::string& path)
+{
+  std::ifstream in(path.c_str());
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+std::size_t count(const std::string& haystack, const std::string& needle)
+{
+  std::size_t n = 0;
+  for (std::size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1))
+    ++n;
+  return n;
+}
+
+std::string merged(const std::string& trace_id)
+{
+  tracing::flush();
+  std::ostringstream out;
+  tracing::mergeTraceFiles({tracing::traceFile()}, trace_id, out);
+  return out.str();
+}
+
+} // end anon namespace
+
+TEST(Tracing, nestedSpansShareTheTrace)
+{
+  EXPECT_TRUE(tracing::current().trace_id.empty());
+
+  tracing::Span root("root");
+  EXPECT_EQ(0u, root.parentId());
+  EXPECT_EQ(root.traceId(), tracing::current().trace_id);
+  {
+    tracing::Span child("child");
+    EXPECT_EQ(root.traceId(), child.traceId());
+    EXPECT_EQ(root.spanId(), child.parentId());
+    EXPECT_EQ(child.spanId(), tracing::current().span_id);
+  }
+  EXPECT_EQ(root.spanId(), tracing::current().span_id);
+
+  // Requests from callers that don't trace start a new trace
+  tracing::Span unrelated("unrelated", godel_msgs::TraceContext());
+  EXPECT_NE(root.traceId(), unrelated.traceId());
+  EXPECT_EQ(0u, unrelated.parentId());
+}
+
+TEST(Tracing, receivedIdsAreSanitized)
+{
+  godel_msgs::TraceContext context;
+  context.trace_id = "abc\",\"x\":\"1" + std::string(64, 'f');
+  context.span_id = 42;
+
+  tracing::Span span("received", context);
+  EXPECT_EQ(std::string::npos, span.traceId().find('"'));
+  EXPECT_EQ(32u, span.traceId().size());
+  EXPECT_EQ(42u, span.parentId());
+}
+
+TEST(Tracing, propagatesIdsThroughAServiceChain)
+{
+  godel_msgs::PathPlanning srv;
+  std::string trace_id;
+  std::uint64_t client_span;
+  {
+    tracing::Span client("client");
+    trace_id = client.traceId();
+    client_span = client.spanId();
+    srv.request.trace = tracing::inject();
+    ASSERT_TRUE(ros::service::call(OUTER_SERVICE, srv));
+  }
+
+  std::lock_guard<std::mutex> lock(observed_mutex);
+  EXPECT_EQ(trace_id, srv.request.trace.trace_id);
+  EXPECT_EQ(trace_id, outer_observed.context.trace_id);
+  EXPECT_EQ(trace_id, inner_observed.context.trace_id);
+
+  // Each server's span hangs off the call that reached it, not the caller's span
+  EXPECT_EQ(srv.request.trace.span_id, outer_observed.parent_id);
+  EXPECT_NE(client_span, outer_observed.parent_id);
+  EXPECT_NE(0u, inner_observed.parent_id);
+  EXPECT_NE(outer_observed.parent_id, inner_observed.parent_id);
+  EXPECT_NE(outer_observed.context.span_id, inner_observed.context.span_id);
+
+  // All four spans and both calls are on the merged timeline
+  const std::string json = merged(trace_id);
+  for (const std::string name : {"client", "outer", "offset", "inner"})
+    EXPECT_EQ(1u, count(json, "{\"name\":\"" + name + "\"")) << name;
+  EXPECT_EQ(2u, count(json, "\"ph\":\"s\""));
+  EXPECT_EQ(2u, count(json, "\"ph\":\"f\",\"bp\":\"e\""));
+  EXPECT_EQ(1u, count(json, "\"ph\":\"M\""));
+  std::ostringstream call;
+  call << std::hex << "\"id\":\"0x" << std::setw(16) << std::setfill('0') << srv.request.trace.span_id << "\"";
+  EXPECT_EQ(2u, count(json, call.str())); // start and end of the client's call
+}
+
+TEST(Tracing, mergeKeepsOnlyTheRequestedTrace)
+{
+  std::string first, second;
+  {
+    tracing::Span a("first_trace");
+    first = a.traceId();
+  }
+  {
+    tracing::Span b("second_trace");
+    second = b.traceId();
+  }
+
+  const std::string json = merged(first);
+  EXPECT_EQ(1u, count(json, "first_trace"));
+  EXPECT_EQ(0u, count(json, "second_trace"));
+  EXPECT_EQ(0u, count(json, second));
+
+  // Without a filter every trace is kept
+  EXPECT_EQ(1u, count(merged(""), "second_trace"));
+}
+
+TEST(Tracing, longBurstsAreWrittenWithoutDrops)
+{
+  const int spans = 5000; // more than one thread's ring holds
+  {
+    tracing::Span root("burst_root");
+    for (int i = 0; i < spans; ++i)
+    {
+      GODEL_TRACE_SPAN("burst");
+    }
+  }
+  ASSERT_TRUE(tracing::flush());
+  EXPECT_EQ(0u, tracing::droppedSpans());
+  EXPECT_EQ(static_cast<std::size_t>(spans), count(readFile(tracing::traceFile()), "{\"name\":\"burst\""));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_tracing");
+  ros::NodeHandle nh;
+
+  char directory[] = "/tmp/test_tracing_XXXXXX";
+  if (!mkdtemp(directory))
+    return 1;
+  trace_directory = directory;
+  tracing::initialize("test_tracing", trace_directory);
+
+  // The outer service calls the inner one from its callback, so two threads are needed
+  ros::AsyncSpinner spinner(2);
+  spinner.start();
+  ros::ServiceServer inner = nh.advertiseService(INNER_SERVICE, innerCallback);
+  ros::ServiceServer outer = nh.advertiseService(OUTER_SERVICE, outerCallback);
+
+  return RUN_ALL_TESTS();
+}
@@ -3,6 +3,8 @@
 #include <geometry_msgs/Pose.h>
 #include <geometry_msgs/PoseArray.h>
 #include <godel_msgs/PathPlanning.h>
+#include <godel_utils/intra_process.h>
+#include <godel_utils/tracing.h>
 #include <mesh_importer/mesh_importer.h>
 #include <path_planning_plugins/openveronoi_plugins.h>
 #include <pluginlib/class_list_macros.h>
@@ -27,10 +29,12 @@ bool openveronoi::BlendPlanner::generatePath(std::vector<geometry_msgs::PoseArra
   using godel_process_path::PolygonBoundary;
 
   path.clear();
+  GODEL_TRACE_SPAN("blend_tool_path");
 
   std::unique_ptr<mesh_importer::MeshImporter> mesh_importer_ptr(new mesh_importer::MeshImporter(false));
   ros::NodeHandle nh;
-  ros::ServiceClient process_path_client = nh.serviceClient<godel_msgs::PathPlanning>(PATH_GENERATION_SERVICE);
+  // Called directly when the path generator is loaded into the same nodelet manager
+  godel_utils::intra_process::ServiceClient<godel_msgs::PathPlanning> process_path_client(nh, PATH_GENERATION_SERVICE);
   godel_msgs::PathPlanningParameters params;
   try
   {
@@ -49,7 +53,12 @@ bool openveronoi::BlendPlanner::generatePath(std::vector<geometry_msgs::PoseArra
 
 
   // Calculate boundaries for a surface
-  if (mesh_importer_ptr->calculateSimpleBoundary(mesh_))
+  bool boundary_found;
+  {
+    GODEL_TRACE_SPAN("calculate_boundary");
+    boundary_found = mesh_importer_ptr->calculateSimpleBoundary(mesh_);
+  }
+  if (boundary_found)
   {
     // Read & filter boundaries that are ill-formed or too small
     PolygonBoundaryCollection filtered_boundaries = filterPolygonBoundaries(mesh_importer_ptr->getBoundaries());
@@ -63,6 +72,7 @@ bool openveronoi::BlendPlanner::generatePath(std::vector<geometry_msgs::PoseArra
     srv.request.params = params;
     godel_process_path::utils::translations::godelToGeometryMsgs(srv.request.surface.boundaries, filtered_boundaries);
     tf::poseTFToMsg(tf::Transform::getIdentity(), srv.request.surface.pose);
+    srv.request.trace = godel_utils::tracing::inject();
 
     if (!process_path_client.call(srv))
     {